@@ -31,6 +31,7 @@
 #include "Eigen\blas\level3_impl.h"
 
 #include "Accelerate\Accelerate.h"
+#include "blasParallelGemm.h"
 
 
 #ifdef __cplusplus
@@ -199,8 +200,11 @@ void __zhpr2__(char* Uplo, const int* N, const void* alpha, const void* X, const
 
 void __zgemm__(char* TransA, char* TransB, const int* M, const int* N, const int* K, const void* alpha, const void* A, const int* lda,
                const void* B, const int* ldb, const void* beta, void* C, const int* ldc) {
-    EigenFunc_zgemm(TransA, TransB, INTCAST(M), INTCAST(N), INTCAST(K), VDOUBLECAST(alpha), VDOUBLECAST(A), INTCAST(lda), VDOUBLECAST(B),
-                    INTCAST(ldb), VDOUBLECAST(beta), RDOUBLECAST(C), INTCAST(ldc));
+    if (!_blasParallelGemm(TransA, TransB, *M, *N, *K, *static_cast<const Scalar*>(alpha), static_cast<const Scalar*>(A), *lda,
+                           static_cast<const Scalar*>(B), *ldb, *static_cast<const Scalar*>(beta), static_cast<Scalar*>(C), *ldc)) {
+        EigenFunc_zgemm(TransA, TransB, INTCAST(M), INTCAST(N), INTCAST(K), VDOUBLECAST(alpha), VDOUBLECAST(A), INTCAST(lda), VDOUBLECAST(B),
+                        INTCAST(ldb), VDOUBLECAST(beta), RDOUBLECAST(C), INTCAST(ldc));
+    }
 }
 
 
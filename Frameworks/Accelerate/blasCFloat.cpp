@@ -31,6 +31,7 @@
 #include "Eigen\blas\level3_impl.h"
 
 #include "Accelerate\Accelerate.h"
+#include "blasParallelGemm.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -198,8 +199,11 @@ void __chpr2__(char* Uplo, const int* N, const void* alpha, const void* X, const
 
 void __cgemm__(char* TransA, char* TransB, const int* M, const int* N, const int* K, const void* alpha, const void* A, const int* lda,
                  const void* B, const int* ldb, const void* beta, void* C, const int* ldc) {
-    EigenFunc_cgemm(TransA, TransB, INTCAST(M), INTCAST(N), INTCAST(K), VFLOATCAST(alpha), VFLOATCAST(A), INTCAST(lda), VFLOATCAST(B),
-                 INTCAST(ldb), VFLOATCAST(beta), RFLOATCAST(C), INTCAST(ldc));
+    if (!_blasParallelGemm(TransA, TransB, *M, *N, *K, *static_cast<const Scalar*>(alpha), static_cast<const Scalar*>(A), *lda,
+                           static_cast<const Scalar*>(B), *ldb, *static_cast<const Scalar*>(beta), static_cast<Scalar*>(C), *ldc)) {
+        EigenFunc_cgemm(TransA, TransB, INTCAST(M), INTCAST(N), INTCAST(K), VFLOATCAST(alpha), VFLOATCAST(A), INTCAST(lda), VFLOATCAST(B),
+                     INTCAST(ldb), VFLOATCAST(beta), RFLOATCAST(C), INTCAST(ldc));
+    }
 }
 
 
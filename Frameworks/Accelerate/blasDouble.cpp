@@ -30,6 +30,7 @@
 #include "Eigen\blas\level2_real_impl.h"
 
 #include "Accelerate\Accelerate.h"
+#include "blasParallelGemm.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -174,8 +175,10 @@ void __dspr2__(char* Uplo, const int* N, const double* alpha, const double* X, c
 
 void __dgemm__(char* TransA, char* TransB, const int* M, const int* N, const int* K, const double* alpha, const double* A, 
                const int* lda, const double* B, const int* ldb, const double* beta, double* C, const int* ldc) {
-    EigenFunc_dgemm(TransA, TransB, INTCAST(M), INTCAST(N), INTCAST(K), DOUBLECAST(alpha), DOUBLECAST(A), 
-                    INTCAST(lda), DOUBLECAST(B), INTCAST(ldb), DOUBLECAST(beta), DOUBLECAST(C), INTCAST(ldc));
+    if (!_blasParallelGemm(TransA, TransB, *M, *N, *K, *alpha, A, *lda, B, *ldb, *beta, C, *ldc)) {
+        EigenFunc_dgemm(TransA, TransB, INTCAST(M), INTCAST(N), INTCAST(K), DOUBLECAST(alpha), DOUBLECAST(A), 
+                        INTCAST(lda), DOUBLECAST(B), INTCAST(ldb), DOUBLECAST(beta), DOUBLECAST(C), INTCAST(ldc));
+    }
 }
 
 
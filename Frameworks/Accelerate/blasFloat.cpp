@@ -30,6 +30,7 @@
 #include "Eigen\blas\level2_real_impl.h"
 
 #include "Accelerate\Accelerate.h"
+#include "blasParallelGemm.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -174,8 +175,10 @@ void __sspr2__(char* Uplo, const int* N, const float* alpha, const float* X, con
 
 void __sgemm__(char* TransA, char* TransB, const int* M, const int* N, const int* K, const float* alpha, const float* A, const int* lda,
                const float* B, const int* ldb, const float* beta, float* C, const int* ldc) {
-    EigenFunc_sgemm(TransA, TransB, INTCAST(M), INTCAST(N), INTCAST(K), FLOATCAST(alpha), FLOATCAST(A), INTCAST(lda), FLOATCAST(B),
-                    INTCAST(ldb), FLOATCAST(beta), FLOATCAST(C), INTCAST(ldc));
+    if (!_blasParallelGemm(TransA, TransB, *M, *N, *K, *alpha, A, *lda, B, *ldb, *beta, C, *ldc)) {
+        EigenFunc_sgemm(TransA, TransB, INTCAST(M), INTCAST(N), INTCAST(K), FLOATCAST(alpha), FLOATCAST(A), INTCAST(lda), FLOATCAST(B),
+                        INTCAST(ldb), FLOATCAST(beta), FLOATCAST(C), INTCAST(ldc));
+    }
 }
 
 
@@ -0,0 +1,179 @@
+//******************************************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+//
+// This code is licensed under the MIT License (MIT).
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+//******************************************************************************
+
+// Multi-threaded GEMM for the Eigen-BLAS translation units. Include after the Eigen blas headers, which define Scalar and
+// the OP() helpers for the precision being compiled.
+
+#pragma once
+
+#include "blasThreading.h"
+
+#include <algorithm>
+
+// Products with fewer multiply-adds than this stay on Eigen's single-threaded path, where packing and dispatch dominate
+static const double c_blasParallelGemmMinOperations = 128.0 * 128.0 * 128.0;
+
+// Tiles narrower than this waste most of Eigen's register blocking
+static const DenseIndex c_blasParallelGemmMinTile = 32;
+
+typedef void (*_blasGemmKernel)(DenseIndex,
+                                DenseIndex,
+                                DenseIndex,
+                                const Scalar*,
+                                DenseIndex,
+                                const Scalar*,
+                                DenseIndex,
+                                Scalar*,
+                                DenseIndex,
+                                Scalar,
+                                internal::level3_blocking<Scalar, Scalar>&,
+                                internal::GemmParallelInfo<DenseIndex>*);
+
+// Indexed by OP(opa) | (OP(opb) << 2), as in Eigen's gemm
+static const _blasGemmKernel c_blasGemmKernels[12] = {
+    internal::general_matrix_matrix_product<DenseIndex, Scalar, ColMajor, false, Scalar, ColMajor, false, ColMajor>::run,
+    internal::general_matrix_matrix_product<DenseIndex, Scalar, RowMajor, false, Scalar, ColMajor, false, ColMajor>::run,
+    internal::general_matrix_matrix_product<DenseIndex, Scalar, RowMajor, Conj, Scalar, ColMajor, false, ColMajor>::run,
+    nullptr,
+    internal::general_matrix_matrix_product<DenseIndex, Scalar, ColMajor, false, Scalar, RowMajor, false, ColMajor>::run,
+    internal::general_matrix_matrix_product<DenseIndex, Scalar, RowMajor, false, Scalar, RowMajor, false, ColMajor>::run,
+    internal::general_matrix_matrix_product<DenseIndex, Scalar, RowMajor, Conj, Scalar, RowMajor, false, ColMajor>::run,
+    nullptr,
+    internal::general_matrix_matrix_product<DenseIndex, Scalar, ColMajor, false, Scalar, RowMajor, Conj, ColMajor>::run,
+    internal::general_matrix_matrix_product<DenseIndex, Scalar, RowMajor, false, Scalar, RowMajor, Conj, ColMajor>::run,
+    internal::general_matrix_matrix_product<DenseIndex, Scalar, RowMajor, Conj, Scalar, RowMajor, Conj, ColMajor>::run,
+    nullptr,
+};
+
+struct _blasGemmJob {
+    _blasGemmKernel kernel;
+    bool transposeA;
+    bool transposeB;
+    DenseIndex m;
+    DenseIndex n;
+    DenseIndex k;
+    Scalar alpha;
+    Scalar beta;
+    const Scalar* a;
+    DenseIndex lda;
+    const Scalar* b;
+    DenseIndex ldb;
+    Scalar* c;
+    DenseIndex ldc;
+    DenseIndex tileRows;
+    DenseIndex tileCols;
+    DenseIndex rowTiles;
+};
+
+// Computes one tile of C. Each tile packs its own panels of A and B with blocking sized to the tile, so the caches each
+// thread sees hold only its share of the operands.
+static void _blasGemmTile(void* context, size_t index) {
+    const _blasGemmJob& job = *static_cast<const _blasGemmJob*>(context);
+    const DenseIndex firstRow = (index % job.rowTiles) * job.tileRows;
+    const DenseIndex firstCol = (index / job.rowTiles) * job.tileCols;
+    const DenseIndex rows = std::min(job.tileRows, job.m - firstRow);
+    const DenseIndex cols = std::min(job.tileCols, job.n - firstCol);
+
+    Scalar* c = job.c + firstRow + firstCol * job.ldc;
+    if (job.beta != Scalar(1)) {
+        if (job.beta == Scalar(0)) {
+            matrix(c, rows, cols, job.ldc).setZero();
+        } else {
+            matrix(c, rows, cols, job.ldc) *= job.beta;
+        }
+    }
+
+    const Scalar* a = job.transposeA ? job.a + firstRow * job.lda : job.a + firstRow;
+    const Scalar* b = job.transposeB ? job.b + firstCol : job.b + firstCol * job.ldb;
+
+    internal::gemm_blocking_space<ColMajor, Scalar, Scalar, Dynamic, Dynamic, Dynamic> blocking(rows, cols, job.k);
+    job.kernel(rows, cols, job.k, a, job.lda, b, job.ldb, c, job.ldc, job.alpha, blocking, 0);
+}
+
+// Runs GEMM across the BLAS worker pool, splitting C into one tile per thread. Returns false, without touching C, when the
+// call should take Eigen's single-threaded path instead: small products, a single thread, or arguments Eigen must report.
+static bool _blasParallelGemm(char* opa,
+                              char* opb,
+                              int m,
+                              int n,
+                              int k,
+                              Scalar alpha,
+                              const Scalar* a,
+                              int lda,
+                              const Scalar* b,
+                              int ldb,
+                              Scalar beta,
+                              Scalar* c,
+                              int ldc) {
+    if ((OP(*opa) == INVALID) || (OP(*opb) == INVALID) || (m <= 0) || (n <= 0) || (k <= 0) ||
+        (lda < std::max(1, (OP(*opa) == NOTR) ? m : k)) || (ldb < std::max(1, (OP(*opb) == NOTR) ? k : n)) || (ldc < std::max(1, m))) {
+        return false;
+    }
+
+    const size_t threadCount = _blasThreadCount();
+    if ((threadCount <= 1) || (static_cast<double>(m) * n * k < c_blasParallelGemmMinOperations)) {
+        return false;
+    }
+
+    //  Pick the grid that packs the least: each tile column repacks its rows of A, each tile row its columns of B. Grids never
+    //  have more tiles than threads, since a thread left with a second tile would double the time of the whole call.
+    DenseIndex rowTiles = 1;
+    DenseIndex colTiles = static_cast<DenseIndex>(threadCount);
+    double bestCost = -1.0;
+    for (DenseIndex candidateRows = 1; candidateRows <= static_cast<DenseIndex>(threadCount); ++candidateRows) {
+        const DenseIndex candidateCols = static_cast<DenseIndex>(threadCount) / candidateRows;
+        if ((m / candidateRows < c_blasParallelGemmMinTile && candidateRows > 1) ||
+            (n / candidateCols < c_blasParallelGemmMinTile && candidateCols > 1)) {
+            continue;
+        }
+
+        const double cost = static_cast<double>(candidateCols) * m + static_cast<double>(candidateRows) * n;
+        if ((bestCost < 0.0) || (cost < bestCost)) {
+            bestCost = cost;
+            rowTiles = candidateRows;
+            colTiles = candidateCols;
+        }
+    }
+
+    if (bestCost < 0.0) {
+        return false;
+    }
+
+    _blasGemmJob job;
+    job.kernel = c_blasGemmKernels[OP(*opa) | (OP(*opb) << 2)];
+    job.transposeA = OP(*opa) != NOTR;
+    job.transposeB = OP(*opb) != NOTR;
+    job.m = m;
+    job.n = n;
+    job.k = k;
+    job.alpha = alpha;
+    job.beta = beta;
+    job.a = a;
+    job.lda = lda;
+    job.b = b;
+    job.ldb = ldb;
+    job.c = c;
+    job.ldc = ldc;
+
+    //  Keep tile edges on multiples of the register block so only the last tile in each direction is ragged
+    job.tileRows = std::min<DenseIndex>(m, ((m + rowTiles - 1) / rowTiles + 7) & ~DenseIndex(7));
+    job.tileCols = std::min<DenseIndex>(n, ((n + colTiles - 1) / colTiles + 3) & ~DenseIndex(3));
+    job.rowTiles = (m + job.tileRows - 1) / job.tileRows;
+    const DenseIndex tileCount = job.rowTiles * ((n + job.tileCols - 1) / job.tileCols);
+
+    _blasParallelFor(tileCount, _blasGemmTile, &job);
+    return true;
+}
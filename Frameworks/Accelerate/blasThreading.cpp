@@ -0,0 +1,197 @@
+//******************************************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+//
+// This code is licensed under the MIT License (MIT).
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+//******************************************************************************
+
+#include "Accelerate\Accelerate.h"
+#include "blasThreading.h"
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <system_error>
+#include <thread>
+
+namespace {
+
+std::atomic<int> s_blasThreading(BLAS_THREADING_MULTI_THREADED);
+
+// 0 selects the hardware concurrency
+std::atomic<int> s_blasThreadCount(0);
+
+// Worker threads shared by every level 3 call. Workers are created on demand and live for the rest of the process; they are
+// detached rather than joined because joining threads while the DLL unloads deadlocks on the loader lock.
+class BlasWorkerPool {
+public:
+    void run(size_t taskCount, size_t threadCount, _blasParallelTask task, void* context) {
+        //  One call owns the pool at a time. Concurrent callers, and tasks that themselves call into BLAS, run on their own thread.
+        if (_busy.exchange(true)) {
+            for (size_t i = 0; i < taskCount; ++i) {
+                task(context, i);
+            }
+
+            return;
+        }
+
+        _ensureWorkers(threadCount - 1);
+
+        {
+            std::unique_lock<std::mutex> lock(_lock);
+
+            //  Stragglers from the previous call may still be reading the old task
+            _idle.wait(lock, [this]() { return _activeWorkers == 0; });
+
+            _task = task;
+            _context = context;
+            _taskCount = taskCount;
+            _nextTask = 0;
+            _participants = std::min(threadCount - 1, _workerCount);
+            ++_generation;
+        }
+
+        _wake.notify_all();
+        _drain();
+
+        {
+            std::unique_lock<std::mutex> lock(_lock);
+            _idle.wait(lock, [this]() { return _activeWorkers == 0; });
+        }
+
+        _busy = false;
+    }
+
+private:
+    void _ensureWorkers(size_t count) {
+        std::lock_guard<std::mutex> lock(_lock);
+        while (_workerCount < count) {
+            try {
+                std::thread(&BlasWorkerPool::_workerMain, this, _workerCount).detach();
+            } catch (const std::system_error&) {
+                //  Run with the workers we have
+                break;
+            }
+
+            ++_workerCount;
+        }
+    }
+
+    void _workerMain(size_t index) {
+        uint64_t seenGeneration = 0;
+        std::unique_lock<std::mutex> lock(_lock);
+
+        for (;;) {
+            _wake.wait(lock, [this, seenGeneration]() { return _generation != seenGeneration; });
+            seenGeneration = _generation;
+            if (index >= _participants) {
+                continue;
+            }
+
+            ++_activeWorkers;
+            lock.unlock();
+            _drain();
+            lock.lock();
+
+            if (--_activeWorkers == 0) {
+                _idle.notify_all();
+            }
+        }
+    }
+
+    void _drain() {
+        for (size_t i = _nextTask++; i < _taskCount; i = _nextTask++) {
+            _task(_context, i);
+        }
+    }
+
+    std::atomic<bool> _busy{ false };
+    std::mutex _lock;
+    std::condition_variable _wake;
+    std::condition_variable _idle;
+
+    size_t _workerCount = 0;
+    size_t _participants = 0;
+    size_t _activeWorkers = 0;
+    uint64_t _generation = 0;
+
+    _blasParallelTask _task = nullptr;
+    void* _context = nullptr;
+    size_t _taskCount = 0;
+    std::atomic<size_t> _nextTask{ 0 };
+};
+
+BlasWorkerPool& _blasWorkerPool() {
+    static BlasWorkerPool* pool = new BlasWorkerPool();
+    return *pool;
+}
+
+} // namespace
+
+size_t _blasThreadCount() {
+    if (s_blasThreading.load() == BLAS_THREADING_SINGLE_THREADED) {
+        return 1;
+    }
+
+    //  More threads than cores would only time-slice the tiles, so requests beyond the hardware are clamped to it
+    const size_t hardwareThreads = std::max(1u, std::thread::hardware_concurrency());
+    const int count = s_blasThreadCount.load();
+    if (count > 0) {
+        return std::min(static_cast<size_t>(count), hardwareThreads);
+    }
+
+    return hardwareThreads;
+}
+
+void _blasParallelFor(size_t taskCount, _blasParallelTask task, void* context) {
+    const size_t threadCount = std::min(_blasThreadCount(), taskCount);
+    if (threadCount <= 1) {
+        for (size_t i = 0; i < taskCount; ++i) {
+            task(context, i);
+        }
+
+        return;
+    }
+
+    _blasWorkerPool().run(taskCount, threadCount, task, context);
+}
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+int BLASSetThreading(BLAS_THREADING threading) {
+    if (threading != BLAS_THREADING_MULTI_THREADED && threading != BLAS_THREADING_SINGLE_THREADED) {
+        return -1;
+    }
+
+    s_blasThreading = threading;
+    return 0;
+}
+
+BLAS_THREADING BLASGetThreading(void) {
+    return static_cast<BLAS_THREADING>(s_blasThreading.load());
+}
+
+void BLASSetThreadCount(int count) {
+    s_blasThreadCount = std::max(0, count);
+}
+
+int BLASGetThreadCount(void) {
+    return static_cast<int>(_blasThreadCount());
+}
+
+#ifdef __cplusplus
+}
+#endif
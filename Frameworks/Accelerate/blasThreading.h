@@ -0,0 +1,28 @@
+//******************************************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+//
+// This code is licensed under the MIT License (MIT).
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+//******************************************************************************
+
+#pragma once
+
+#include <stddef.h>
+
+typedef void (*_blasParallelTask)(void* context, size_t index);
+
+// Number of threads the level 3 routines may use; 1 when BLAS threading is disabled
+size_t _blasThreadCount();
+
+// Runs task(context, i) for every i in [0, taskCount) on the shared BLAS worker pool and the calling thread, returning once all
+// tasks have completed. Tasks run serially on the calling thread when the pool is already running another call.
+void _blasParallelFor(size_t taskCount, _blasParallelTask task, void* context);
@@ -19,20 +19,709 @@
 #define _USE_MATH_DEFINES // for C++
 #include <cmath>
 #include <algorithm>
+#include <memory>
+#include <mutex>
+#include <new>
 #include "Accelerate\vDSP.h"
 
+#if defined(_M_IX86) || defined(_M_X64) || defined(__SSE2__)
+#define VDSP_SSE 1
+#include <emmintrin.h>
+#else
+#define VDSP_SSE 0
+#endif
+
+// AVX2 kernels are selected at runtime; GCC and clang only build them when the whole file targets AVX2
+#if (VDSP_SSE == 1) && ((defined(_MSC_VER) && !defined(__clang__)) || defined(__AVX2__))
+#define VDSP_AVX 1
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+#else
+#define VDSP_AVX 0
+#endif
+
+#if defined(_M_ARM) || defined(__ARM_NEON)
+#define VDSP_NEON 1
+#include <arm_neon.h>
+#else
+#define VDSP_NEON 0
+#endif
+
+// Element-wise kernels.
+//
+// Each kernel is written once against the small operation sets below (ScalarOps, SseFloatOps, ...), and the
+// vectorMap helpers run it with the widest operation set available when every stride is 1, finishing the tail
+// and any other stride with ScalarOps. The operation sets keep the comparison semantics of the scalar code,
+// including which operand wins when one of them is NaN.
+namespace {
 
-void vDSP_vabs(const float* A, vDSP_Stride IA, float* C, vDSP_Stride IC, vDSP_Length N) {
-    for (vDSP_Length i = 0; i < N; ++i) {
-        C[i*IC] = abs(A[i*IA]);
+template <typename T>
+struct ScalarOps {
+    typedef T Type;
+    static const vDSP_Length width = 1;
+
+    static T load(const T* p) {
+        return *p;
+    }
+    static void store(T* p, T v) {
+        *p = v;
+    }
+    static T set(T v) {
+        return v;
+    }
+    static T add(T a, T b) {
+        return a + b;
+    }
+    static T sub(T a, T b) {
+        return a - b;
+    }
+    static T mul(T a, T b) {
+        return a * b;
+    }
+    // a > b ? a : b
+    static T max(T a, T b) {
+        return (a > b) ? a : b;
+    }
+    // a < b ? a : b
+    static T min(T a, T b) {
+        return (a < b) ? a : b;
+    }
+    static T abs(T a) {
+        return std::abs(a);
+    }
+    static T neg(T a) {
+        return -a;
+    }
+    // a >= b ? x : y
+    static T selectGreaterEqual(T a, T b, T x, T y) {
+        return (a >= b) ? x : y;
+    }
+};
+
+#if (VDSP_SSE == 1)
+struct SseFloatOps {
+    typedef __m128 Type;
+    static const vDSP_Length width = 4;
+
+    static __m128 load(const float* p) {
+        return _mm_loadu_ps(p);
+    }
+    static void store(float* p, __m128 v) {
+        _mm_storeu_ps(p, v);
+    }
+    static __m128 set(float v) {
+        return _mm_set1_ps(v);
+    }
+    static __m128 add(__m128 a, __m128 b) {
+        return _mm_add_ps(a, b);
+    }
+    static __m128 sub(__m128 a, __m128 b) {
+        return _mm_sub_ps(a, b);
+    }
+    static __m128 mul(__m128 a, __m128 b) {
+        return _mm_mul_ps(a, b);
+    }
+    static __m128 max(__m128 a, __m128 b) {
+        return _mm_max_ps(a, b);
+    }
+    static __m128 min(__m128 a, __m128 b) {
+        return _mm_min_ps(a, b);
+    }
+    static __m128 abs(__m128 a) {
+        return _mm_andnot_ps(_mm_set1_ps(-0.0f), a);
+    }
+    static __m128 neg(__m128 a) {
+        return _mm_xor_ps(_mm_set1_ps(-0.0f), a);
+    }
+    static __m128 selectGreaterEqual(__m128 a, __m128 b, __m128 x, __m128 y) {
+        const __m128 mask = _mm_cmpge_ps(a, b);
+        return _mm_or_ps(_mm_and_ps(mask, x), _mm_andnot_ps(mask, y));
+    }
+};
+
+struct SseDoubleOps {
+    typedef __m128d Type;
+    static const vDSP_Length width = 2;
+
+    static __m128d load(const double* p) {
+        return _mm_loadu_pd(p);
+    }
+    static void store(double* p, __m128d v) {
+        _mm_storeu_pd(p, v);
+    }
+    static __m128d set(double v) {
+        return _mm_set1_pd(v);
+    }
+    static __m128d add(__m128d a, __m128d b) {
+        return _mm_add_pd(a, b);
+    }
+    static __m128d sub(__m128d a, __m128d b) {
+        return _mm_sub_pd(a, b);
+    }
+    static __m128d mul(__m128d a, __m128d b) {
+        return _mm_mul_pd(a, b);
+    }
+    static __m128d max(__m128d a, __m128d b) {
+        return _mm_max_pd(a, b);
+    }
+    static __m128d min(__m128d a, __m128d b) {
+        return _mm_min_pd(a, b);
+    }
+    static __m128d abs(__m128d a) {
+        return _mm_andnot_pd(_mm_set1_pd(-0.0), a);
+    }
+    static __m128d neg(__m128d a) {
+        return _mm_xor_pd(_mm_set1_pd(-0.0), a);
+    }
+    static __m128d selectGreaterEqual(__m128d a, __m128d b, __m128d x, __m128d y) {
+        const __m128d mask = _mm_cmpge_pd(a, b);
+        return _mm_or_pd(_mm_and_pd(mask, x), _mm_andnot_pd(mask, y));
+    }
+};
+#endif
+
+#if (VDSP_AVX == 1)
+struct AvxFloatOps {
+    typedef __m256 Type;
+    static const vDSP_Length width = 8;
+
+    static __m256 load(const float* p) {
+        return _mm256_loadu_ps(p);
+    }
+    static void store(float* p, __m256 v) {
+        _mm256_storeu_ps(p, v);
+    }
+    static __m256 set(float v) {
+        return _mm256_set1_ps(v);
+    }
+    static __m256 add(__m256 a, __m256 b) {
+        return _mm256_add_ps(a, b);
+    }
+    static __m256 sub(__m256 a, __m256 b) {
+        return _mm256_sub_ps(a, b);
+    }
+    static __m256 mul(__m256 a, __m256 b) {
+        return _mm256_mul_ps(a, b);
+    }
+    static __m256 max(__m256 a, __m256 b) {
+        return _mm256_max_ps(a, b);
+    }
+    static __m256 min(__m256 a, __m256 b) {
+        return _mm256_min_ps(a, b);
+    }
+    static __m256 abs(__m256 a) {
+        return _mm256_andnot_ps(_mm256_set1_ps(-0.0f), a);
+    }
+    static __m256 neg(__m256 a) {
+        return _mm256_xor_ps(_mm256_set1_ps(-0.0f), a);
+    }
+    static __m256 selectGreaterEqual(__m256 a, __m256 b, __m256 x, __m256 y) {
+        return _mm256_blendv_ps(y, x, _mm256_cmp_ps(a, b, _CMP_GE_OQ));
+    }
+};
+
+struct AvxDoubleOps {
+    typedef __m256d Type;
+    static const vDSP_Length width = 4;
+
+    static __m256d load(const double* p) {
+        return _mm256_loadu_pd(p);
+    }
+    static void store(double* p, __m256d v) {
+        _mm256_storeu_pd(p, v);
+    }
+    static __m256d set(double v) {
+        return _mm256_set1_pd(v);
+    }
+    static __m256d add(__m256d a, __m256d b) {
+        return _mm256_add_pd(a, b);
+    }
+    static __m256d sub(__m256d a, __m256d b) {
+        return _mm256_sub_pd(a, b);
+    }
+    static __m256d mul(__m256d a, __m256d b) {
+        return _mm256_mul_pd(a, b);
+    }
+    static __m256d max(__m256d a, __m256d b) {
+        return _mm256_max_pd(a, b);
+    }
+    static __m256d min(__m256d a, __m256d b) {
+        return _mm256_min_pd(a, b);
+    }
+    static __m256d abs(__m256d a) {
+        return _mm256_andnot_pd(_mm256_set1_pd(-0.0), a);
+    }
+    static __m256d neg(__m256d a) {
+        return _mm256_xor_pd(_mm256_set1_pd(-0.0), a);
+    }
+    static __m256d selectGreaterEqual(__m256d a, __m256d b, __m256d x, __m256d y) {
+        return _mm256_blendv_pd(y, x, _mm256_cmp_pd(a, b, _CMP_GE_OQ));
+    }
+};
+
+bool detectAvx2() {
+#if defined(_MSC_VER)
+    int info[4];
+    __cpuid(info, 0);
+    if (info[0] < 7) {
+        return false;
+    }
+
+    //AVX2 needs the CPU feature bits and the OS saving the YMM state
+    __cpuid(info, 1);
+    const bool osxsave = (info[2] & (1 << 27)) != 0;
+    const bool avx = (info[2] & (1 << 28)) != 0;
+    if (!osxsave || !avx || (_xgetbv(0) & 0x6) != 0x6) {
+        return false;
     }
+
+    __cpuidex(info, 7, 0);
+    return (info[1] & (1 << 5)) != 0;
+#else
+    return __builtin_cpu_supports("avx2") != 0;
+#endif
 }
 
+const bool c_vDSPUseAvx2 = detectAvx2();
+#endif
 
-void vDSP_vabsD(const double* A, vDSP_Stride IA, double* C, vDSP_Stride IC, vDSP_Length N) {
-    for (vDSP_Length i = 0; i < N; ++i) {
-        C[i*IC] = abs(A[i*IA]);
+#if (VDSP_NEON == 1)
+struct NeonFloatOps {
+    typedef float32x4_t Type;
+    static const vDSP_Length width = 4;
+
+    static float32x4_t load(const float* p) {
+        return vld1q_f32(p);
+    }
+    static void store(float* p, float32x4_t v) {
+        vst1q_f32(p, v);
+    }
+    static float32x4_t set(float v) {
+        return vdupq_n_f32(v);
+    }
+    static float32x4_t add(float32x4_t a, float32x4_t b) {
+        return vaddq_f32(a, b);
+    }
+    static float32x4_t sub(float32x4_t a, float32x4_t b) {
+        return vsubq_f32(a, b);
+    }
+    static float32x4_t mul(float32x4_t a, float32x4_t b) {
+        return vmulq_f32(a, b);
+    }
+    static float32x4_t max(float32x4_t a, float32x4_t b) {
+        return vbslq_f32(vcgtq_f32(a, b), a, b);
+    }
+    static float32x4_t min(float32x4_t a, float32x4_t b) {
+        return vbslq_f32(vcltq_f32(a, b), a, b);
+    }
+    static float32x4_t abs(float32x4_t a) {
+        return vabsq_f32(a);
+    }
+    static float32x4_t neg(float32x4_t a) {
+        return vnegq_f32(a);
+    }
+    static float32x4_t selectGreaterEqual(float32x4_t a, float32x4_t b, float32x4_t x, float32x4_t y) {
+        return vbslq_f32(vcgeq_f32(a, b), x, y);
+    }
+};
+#endif
+
+//Widest operation set available without runtime checks
+template <typename T>
+struct VectorOps {
+    typedef ScalarOps<T> Type;
+};
+
+#if (VDSP_SSE == 1)
+template <>
+struct VectorOps<float> {
+    typedef SseFloatOps Type;
+};
+
+template <>
+struct VectorOps<double> {
+    typedef SseDoubleOps Type;
+};
+#elif (VDSP_NEON == 1)
+template <>
+struct VectorOps<float> {
+    typedef NeonFloatOps Type;
+};
+#endif
+
+#if (VDSP_AVX == 1)
+template <typename T>
+struct WideVectorOps;
+
+template <>
+struct WideVectorOps<float> {
+    typedef AvxFloatOps Type;
+};
+
+template <>
+struct WideVectorOps<double> {
+    typedef AvxDoubleOps Type;
+};
+#endif
+
+template <typename V, typename Kernel, typename T, typename... Inputs>
+vDSP_Length mapLoop(const Kernel& kernel, T* C, vDSP_Length N, const Inputs*... inputs) {
+    vDSP_Length i = 0;
+    for (; i + V::width <= N; i += V::width) {
+        V::store(C + i, kernel.template apply<V>(V::load(inputs + i)...));
+    }
+
+    return i;
+}
+
+//Runs the vector part of a unit-stride map and returns the number of elements processed
+template <typename Kernel, typename T, typename... Inputs>
+vDSP_Length unitStrideMap(const Kernel& kernel, T* C, vDSP_Length N, const Inputs*... inputs) {
+#if (VDSP_AVX == 1)
+    if (c_vDSPUseAvx2) {
+        const vDSP_Length i = mapLoop<typename WideVectorOps<T>::Type>(kernel, C, N, inputs...);
+        _mm256_zeroupper();
+        return i;
+    }
+#endif
+    return mapLoop<typename VectorOps<T>::Type>(kernel, C, N, inputs...);
+}
+
+template <typename Kernel, typename T>
+void vectorMap(const Kernel& kernel, T* C, vDSP_Stride IC, vDSP_Length N) {
+    vDSP_Length i = (IC == 1) ? unitStrideMap(kernel, C, N) : 0;
+    for (; i < N; ++i) {
+        C[i * IC] = kernel.template apply<ScalarOps<T>>();
+    }
+}
+
+template <typename Kernel, typename T>
+void vectorMap(const Kernel& kernel, T* C, vDSP_Stride IC, vDSP_Length N, const T* A, vDSP_Stride IA) {
+    vDSP_Length i = (IC == 1 && IA == 1) ? unitStrideMap(kernel, C, N, A) : 0;
+    for (; i < N; ++i) {
+        C[i * IC] = kernel.template apply<ScalarOps<T>>(A[i * IA]);
+    }
+}
+
+template <typename Kernel, typename T>
+void vectorMap(const Kernel& kernel, T* C, vDSP_Stride IC, vDSP_Length N, const T* A, vDSP_Stride IA, const T* B, vDSP_Stride IB) {
+    vDSP_Length i = (IC == 1 && IA == 1 && IB == 1) ? unitStrideMap(kernel, C, N, A, B) : 0;
+    for (; i < N; ++i) {
+        C[i * IC] = kernel.template apply<ScalarOps<T>>(A[i * IA], B[i * IB]);
+    }
+}
+
+template <typename Kernel, typename T>
+void vectorMap(const Kernel& kernel,
+               T* D,
+               vDSP_Stride ID,
+               vDSP_Length N,
+               const T* A,
+               vDSP_Stride IA,
+               const T* B,
+               vDSP_Stride IB,
+               const T* C,
+               vDSP_Stride IC) {
+    vDSP_Length i = (ID == 1 && IA == 1 && IB == 1 && IC == 1) ? unitStrideMap(kernel, D, N, A, B, C) : 0;
+    for (; i < N; ++i) {
+        D[i * ID] = kernel.template apply<ScalarOps<T>>(A[i * IA], B[i * IB], C[i * IC]);
+    }
+}
+
+//Vector part of a maximum reduction that starts from c
+template <typename V, typename T>
+vDSP_Length maxLoop(const T* A, vDSP_Length N, T& c) {
+    if (N < V::width) {
+        return 0;
+    }
+
+    typename V::Type vMax = V::set(c);
+    vDSP_Length i = 0;
+    for (; i + V::width <= N; i += V::width) {
+        vMax = V::max(V::load(A + i), vMax);
+    }
+
+    T lanes[V::width];
+    V::store(lanes, vMax);
+    for (vDSP_Length j = 0; j < V::width; ++j) {
+        if (c < lanes[j]) {
+            c = lanes[j];
+        }
+    }
+
+    return i;
+}
+
+//Vector part of a maximum magnitude reduction that starts from c
+template <typename V, typename T>
+vDSP_Length maxMagnitudeLoop(const T* A, vDSP_Length N, T& c) {
+    if (N < V::width) {
+        return 0;
+    }
+
+    typename V::Type vMax = V::set(c);
+    vDSP_Length i = 0;
+    for (; i + V::width <= N; i += V::width) {
+        vMax = V::max(V::abs(V::load(A + i)), vMax);
+    }
+
+    T lanes[V::width];
+    V::store(lanes, vMax);
+    for (vDSP_Length j = 0; j < V::width; ++j) {
+        if (c < lanes[j]) {
+            c = lanes[j];
+        }
+    }
+
+    return i;
+}
+
+//Vector part of a sum of squares of A * scale
+template <typename V, typename T>
+vDSP_Length scaledSumOfSquaresLoop(const T* A, vDSP_Length N, T scale, T& c) {
+    if (N < V::width) {
+        return 0;
+    }
+
+    const typename V::Type vScale = V::set(scale);
+    typename V::Type vSum = V::set(0);
+    vDSP_Length i = 0;
+    for (; i + V::width <= N; i += V::width) {
+        const typename V::Type t = V::mul(V::load(A + i), vScale);
+        vSum = V::add(vSum, V::mul(t, t));
+    }
+
+    T lanes[V::width];
+    V::store(lanes, vSum);
+    for (vDSP_Length j = 0; j < V::width; ++j) {
+        c += lanes[j];
+    }
+
+    return i;
+}
+
+template <typename T>
+vDSP_Length unitStrideMax(const T* A, vDSP_Length N, T& c) {
+#if (VDSP_AVX == 1)
+    if (c_vDSPUseAvx2) {
+        const vDSP_Length i = maxLoop<typename WideVectorOps<T>::Type>(A, N, c);
+        _mm256_zeroupper();
+        return i;
+    }
+#endif
+    return maxLoop<typename VectorOps<T>::Type>(A, N, c);
+}
+
+template <typename T>
+vDSP_Length unitStrideMaxMagnitude(const T* A, vDSP_Length N, T& c) {
+#if (VDSP_AVX == 1)
+    if (c_vDSPUseAvx2) {
+        const vDSP_Length i = maxMagnitudeLoop<typename WideVectorOps<T>::Type>(A, N, c);
+        _mm256_zeroupper();
+        return i;
+    }
+#endif
+    return maxMagnitudeLoop<typename VectorOps<T>::Type>(A, N, c);
+}
+
+template <typename T>
+vDSP_Length unitStrideScaledSumOfSquares(const T* A, vDSP_Length N, T scale, T& c) {
+#if (VDSP_AVX == 1)
+    if (c_vDSPUseAvx2) {
+        const vDSP_Length i = scaledSumOfSquaresLoop<typename WideVectorOps<T>::Type>(A, N, scale, c);
+        _mm256_zeroupper();
+        return i;
+    }
+#endif
+    return scaledSumOfSquaresLoop<typename VectorOps<T>::Type>(A, N, scale, c);
+}
+
+struct AbsKernel {
+    template <typename V>
+    typename V::Type apply(typename V::Type a) const {
+        return V::abs(a);
+    }
+};
+
+struct NegativeAbsKernel {
+    template <typename V>
+    typename V::Type apply(typename V::Type a) const {
+        return V::neg(V::abs(a));
+    }
+};
+
+struct NegateKernel {
+    template <typename V>
+    typename V::Type apply(typename V::Type a) const {
+        return V::neg(a);
+    }
+};
+
+struct CopyKernel {
+    template <typename V>
+    typename V::Type apply(typename V::Type a) const {
+        return a;
+    }
+};
+
+template <typename T>
+struct FillKernel {
+    T a;
+    template <typename V>
+    typename V::Type apply() const {
+        return V::set(a);
+    }
+};
+
+struct SquareKernel {
+    template <typename V>
+    typename V::Type apply(typename V::Type a) const {
+        return V::mul(a, a);
+    }
+};
+
+struct SignedSquareKernel {
+    template <typename V>
+    typename V::Type apply(typename V::Type a) const {
+        return V::mul(a, V::abs(a));
+    }
+};
+
+//Squared magnitude of the complex value (a, b)
+struct MagnitudeSquaredKernel {
+    template <typename V>
+    typename V::Type apply(typename V::Type a, typename V::Type b) const {
+        return V::add(V::mul(a, a), V::mul(b, b));
+    }
+};
+
+struct MagnitudeSquaredAddKernel {
+    template <typename V>
+    typename V::Type apply(typename V::Type a, typename V::Type b, typename V::Type c) const {
+        return V::add(V::add(V::mul(a, a), V::mul(b, b)), c);
+    }
+};
+
+template <typename T>
+struct ClipKernel {
+    T low;
+    T high;
+    template <typename V>
+    typename V::Type apply(typename V::Type a) const {
+        //Operand order keeps a NaN input in the output, as the scalar comparisons do
+        return V::min(V::set(high), V::max(V::set(low), a));
+    }
+};
+
+template <typename T>
+struct ThresholdKernel {
+    T b;
+    template <typename V>
+    typename V::Type apply(typename V::Type a) const {
+        return V::selectGreaterEqual(a, V::set(b), a, V::set(b));
+    }
+};
+
+template <typename T>
+struct ThresholdZeroKernel {
+    T b;
+    template <typename V>
+    typename V::Type apply(typename V::Type a) const {
+        return V::selectGreaterEqual(a, V::set(b), a, V::set(0));
+    }
+};
+
+template <typename T>
+struct ThresholdSignedConstantKernel {
+    T b;
+    T c;
+    template <typename V>
+    typename V::Type apply(typename V::Type a) const {
+        return V::selectGreaterEqual(a, V::set(b), V::set(c), V::set(-c));
+    }
+};
+
+template <typename T>
+struct ScalarAddKernel {
+    T b;
+    template <typename V>
+    typename V::Type apply(typename V::Type a) const {
+        return V::add(a, V::set(b));
+    }
+};
+
+template <typename T>
+struct ScalarMultiplyKernel {
+    T b;
+    template <typename V>
+    typename V::Type apply(typename V::Type a) const {
+        return V::mul(a, V::set(b));
+    }
+};
+
+struct AddKernel {
+    template <typename V>
+    typename V::Type apply(typename V::Type a, typename V::Type b) const {
+        return V::add(a, b);
     }
+};
+
+struct MultiplyKernel {
+    template <typename V>
+    typename V::Type apply(typename V::Type a, typename V::Type b) const {
+        return V::mul(a, b);
+    }
+};
+
+template <typename T>
+struct AddScalarMultiplyKernel {
+    T c;
+    template <typename V>
+    typename V::Type apply(typename V::Type a, typename V::Type b) const {
+        return V::mul(V::add(a, b), V::set(c));
+    }
+};
+
+//Multiplies the split complex vector a by the complex scalar (realB, imagB); c may alias a
+template <typename V, typename T>
+vDSP_Length complexScalarMultiplyLoop(const T* ar, const T* ai, T realB, T imagB, T* cr, T* ci, vDSP_Length N) {
+    const typename V::Type vRealB = V::set(realB);
+    const typename V::Type vImagB = V::set(imagB);
+    vDSP_Length i = 0;
+    for (; i + V::width <= N; i += V::width) {
+        const typename V::Type vAr = V::load(ar + i);
+        const typename V::Type vAi = V::load(ai + i);
+        V::store(cr + i, V::sub(V::mul(vAr, vRealB), V::mul(vAi, vImagB)));
+        V::store(ci + i, V::add(V::mul(vAr, vImagB), V::mul(vAi, vRealB)));
+    }
+
+    return i;
+}
+
+template <typename T>
+vDSP_Length unitStrideComplexScalarMultiply(const T* ar, const T* ai, T realB, T imagB, T* cr, T* ci, vDSP_Length N) {
+#if (VDSP_AVX == 1)
+    if (c_vDSPUseAvx2) {
+        const vDSP_Length i = complexScalarMultiplyLoop<typename WideVectorOps<T>::Type>(ar, ai, realB, imagB, cr, ci, N);
+        _mm256_zeroupper();
+        return i;
+    }
+#endif
+    return complexScalarMultiplyLoop<typename VectorOps<T>::Type>(ar, ai, realB, imagB, cr, ci, N);
+}
+
+} // namespace
+
+
+void vDSP_vabs(const float* A, vDSP_Stride IA, float* C, vDSP_Stride IC, vDSP_Length N) {
+    vectorMap(AbsKernel(), C, IC, N, A, IA);
+}
+
+
+void vDSP_vabsD(const double* A, vDSP_Stride IA, double* C, vDSP_Stride IC, vDSP_Length N) {
+    vectorMap(AbsKernel(), C, IC, N, A, IA);
 }
 
 
@@ -58,62 +747,46 @@ void vDSP_zvabsD(const DSPDoubleSplitComplex* A, vDSP_Stride IA, double* C, vDSP
 
 
 void vDSP_vnabs(const float* A, vDSP_Stride IA, float* C, vDSP_Stride IC, vDSP_Length N) {
-    for (vDSP_Length i = 0; i < N; ++i) {
-        C[i*IC] = -abs(A[i*IA]);
-    }
+    vectorMap(NegativeAbsKernel(), C, IC, N, A, IA);
 }
 
 
 void vDSP_vnabsD(const double* A, vDSP_Stride IA, double* C, vDSP_Stride IC, vDSP_Length N) {
-    for (vDSP_Length i = 0; i < N; ++i) {
-        C[i*IC] = -abs(A[i*IA]);
-    }
+    vectorMap(NegativeAbsKernel(), C, IC, N, A, IA);
 }
 
 
 void vDSP_vneg(const float* A, vDSP_Stride IA, float* C, vDSP_Stride IC, vDSP_Length N) {
-    for (vDSP_Length i = 0; i < N; ++i) {
-        C[i*IC] = -A[i*IA];
-    }
+    vectorMap(NegateKernel(), C, IC, N, A, IA);
 }
 
 
 void vDSP_vnegD(const double* A, vDSP_Stride IA, double* C, vDSP_Stride IC, vDSP_Length N) {
-    for (vDSP_Length i = 0; i < N; ++i) {
-        C[i*IC] = -A[i*IA];
-    }
+    vectorMap(NegateKernel(), C, IC, N, A, IA);
 }
 
 
 void vDSP_zvneg(const DSPSplitComplex* A, vDSP_Stride IA, const DSPSplitComplex* C, vDSP_Stride IC, vDSP_Length N) {
-    for (vDSP_Length i = 0; i < N; ++i) {
-        C->realp[i*IC] = -A->realp[i*IA];
-        C->imagp[i*IC] = -A->imagp[i*IA];
-    }
+    vectorMap(NegateKernel(), C->realp, IC, N, A->realp, IA);
+    vectorMap(NegateKernel(), C->imagp, IC, N, A->imagp, IA);
 }
 
 
 void vDSP_zvnegD(const DSPDoubleSplitComplex* A, vDSP_Stride IA, const DSPDoubleSplitComplex* C, vDSP_Stride IC, vDSP_Length N) {
-    for (vDSP_Length i = 0; i < N; ++i) {
-        C->realp[i*IC] = -A->realp[i*IA];
-        C->imagp[i*IC] = -A->imagp[i*IA];
-    }
+    vectorMap(NegateKernel(), C->realp, IC, N, A->realp, IA);
+    vectorMap(NegateKernel(), C->imagp, IC, N, A->imagp, IA);
 }
 
 
 void vDSP_vfill(const float* A, float* C, vDSP_Stride IC, vDSP_Length N) {
-    float a = *A;
-    for (vDSP_Length i = 0; i < N; ++i) {
-        C[i*IC] = a;
-    }
+    const FillKernel<float> kernel = { *A };
+    vectorMap(kernel, C, IC, N);
 }
 
 
 void vDSP_vfillD(const double* A, double* C, vDSP_Stride IC, vDSP_Length N) {
-    double a = *A;
-    for (vDSP_Length i = 0; i < N; ++i) {
-        C[i*IC] = a;
-    }
+    const FillKernel<double> kernel = { *A };
+    vectorMap(kernel, C, IC, N);
 }
 
 
@@ -126,36 +799,30 @@ void vDSP_vfilli(const int* A, int* C, vDSP_Stride IC, vDSP_Length N) {
 
 
 void vDSP_zvfill(const DSPSplitComplex* A, const DSPSplitComplex* C, vDSP_Stride IC, vDSP_Length N) {
-    float real = *(A->realp);
-    float imag = *(A->imagp);
-    for (vDSP_Length i = 0; i < N; ++i) {
-        C->realp[i*IC] = real;
-        C->imagp[i*IC] = imag;
-    }
+    const FillKernel<float> realKernel = { *A->realp };
+    const FillKernel<float> imagKernel = { *A->imagp };
+    vectorMap(realKernel, C->realp, IC, N);
+    vectorMap(imagKernel, C->imagp, IC, N);
 }
 
 
 void vDSP_zvfillD(const DSPDoubleSplitComplex* A, const DSPDoubleSplitComplex* C, vDSP_Stride IC, vDSP_Length N) {
-    double real = *(A->realp);
-    double imag = *(A->imagp);
-    for (vDSP_Length i = 0; i < N; ++i) {
-        C->realp[i*IC] = real;
-        C->imagp[i*IC] = imag;
-    }
+    const FillKernel<double> realKernel = { *A->realp };
+    const FillKernel<double> imagKernel = { *A->imagp };
+    vectorMap(realKernel, C->realp, IC, N);
+    vectorMap(imagKernel, C->imagp, IC, N);
 }
 
 
 void vDSP_vclr(float* C, vDSP_Stride IC, vDSP_Length N) {
-    for (vDSP_Length i = 0; i < N; ++i) {
-        C[i*IC] = 0.0;
-    }
+    const FillKernel<float> kernel = { 0 };
+    vectorMap(kernel, C, IC, N);
 }
 
 
 void vDSP_vclrD(double* C, vDSP_Stride IC, vDSP_Length N) {
-    for (vDSP_Length i = 0; i < N; ++i) {
-        C[i*IC] = 0.0;
-    }
+    const FillKernel<double> kernel = { 0 };
+    vectorMap(kernel, C, IC, N);
 }
 
 
@@ -278,59 +945,43 @@ void vDSP_vgenD(const double* A, const double* B, double* C, vDSP_Stride IC, vDS
 
 
 void vDSP_vsq(const float* A, vDSP_Stride IA, float* C, vDSP_Stride IC, vDSP_Length N) {
-    for (vDSP_Length i = 0; i < N; ++i) {
-        C[i*IC] = A[i*IA] * A[i*IA];
-    }
+    vectorMap(SquareKernel(), C, IC, N, A, IA);
 }
 
 
 void vDSP_vsqD(const double* A, vDSP_Stride IA, double* C, vDSP_Stride IC, vDSP_Length N) {
-    for (vDSP_Length i = 0; i < N; ++i) {
-        C[i*IC] = A[i*IA] * A[i*IA];
-    }
+    vectorMap(SquareKernel(), C, IC, N, A, IA);
 }
 
 
 void vDSP_vssq(const float* A, vDSP_Stride IA, float* C, vDSP_Stride IC, vDSP_Length N) {
-    for (vDSP_Length i = 0; i < N; ++i) {
-        C[i*IC] = A[i*IA] * abs(A[i*IA]);
-    }
+    vectorMap(SignedSquareKernel(), C, IC, N, A, IA);
 }
 
 
 void vDSP_vssqD(const double* A, vDSP_Stride IA, double* C, vDSP_Stride IC, vDSP_Length N) {
-    for (vDSP_Length i = 0; i < N; ++i) {
-        C[i*IC] = A[i*IA] * abs(A[i*IA]);
-    }
+    vectorMap(SignedSquareKernel(), C, IC, N, A, IA);
 }
 
 
 void vDSP_zvmags(const DSPSplitComplex* A, vDSP_Stride IA, float* C, vDSP_Stride IC, vDSP_Length N) {
-    for (vDSP_Length i = 0; i < N; ++i) {
-        C[i*IC] = A->realp[i*IA] * A->realp[i*IA] + A->imagp[i*IA] * A->imagp[i*IA];
-    }
+    vectorMap(MagnitudeSquaredKernel(), C, IC, N, A->realp, IA, A->imagp, IA);
 }
 
 
 void vDSP_zvmagsD(const DSPDoubleSplitComplex* A, vDSP_Stride IA, double* C, vDSP_Stride IC, vDSP_Length N) {
-    for (vDSP_Length i = 0; i < N; ++i) {
-        C[i*IC] = A->realp[i*IA] * A->realp[i*IA] + A->imagp[i*IA] * A->imagp[i*IA];
-    }
+    vectorMap(MagnitudeSquaredKernel(), C, IC, N, A->realp, IA, A->imagp, IA);
 }
 
 
 void vDSP_zvmgsa(const DSPSplitComplex* A, vDSP_Stride IA, const float* B, vDSP_Stride IB, float* C, vDSP_Stride IC, vDSP_Length N) {
-    for (vDSP_Length i = 0; i < N; ++i) {
-        C[i*IC] = A->realp[i*IA] * A->realp[i*IA] + A->imagp[i*IA] * A->imagp[i*IA] + B[i*IB];
-    }
+    vectorMap(MagnitudeSquaredAddKernel(), C, IC, N, A->realp, IA, A->imagp, IA, B, IB);
 }
 
 
 void vDSP_zvmgsaD(const DSPDoubleSplitComplex* A, vDSP_Stride IA, const double* B, vDSP_Stride IB, double* C, vDSP_Stride IC, 
                   vDSP_Length N) {
-    for (vDSP_Length i = 0; i < N; ++i) {
-        C[i*IC] = A->realp[i*IA] * A->realp[i*IA] + A->imagp[i*IA] * A->imagp[i*IA] + B[i*IB];
-    }
+    vectorMap(MagnitudeSquaredAddKernel(), C, IC, N, A->realp, IA, A->imagp, IA, B, IB);
 }
 
 
@@ -349,20 +1000,14 @@ void vDSP_vfracD(const double* A, vDSP_Stride IA, double* C, vDSP_Stride IC, vDS
 
 
 void vDSP_vclip(const float* A, vDSP_Stride IA, const float* B, const float* C, float* D, vDSP_Stride ID, vDSP_Length N) {
-    float b = *B;
-    float c = *C;
-    for (vDSP_Length i = 0; i < N; ++i) {
-        D[i*ID] = (A[i*IA] < b) ? b : ((A[i*IA] > c) ? c : A[i*IA]);
-    }
+    const ClipKernel<float> kernel = { *B, *C };
+    vectorMap(kernel, D, ID, N, A, IA);
 }
 
 
 void vDSP_vclipD(const double* A, vDSP_Stride IA, const double* B, const double* C, double* D, vDSP_Stride ID, vDSP_Length N) {
-    double b = *B;
-    double c = *C;
-    for (vDSP_Length i = 0; i < N; ++i) {
-        D[i*ID] = (A[i*IA] < b) ? b : ((A[i*IA] > c) ? c : A[i*IA]);
-    }
+    const ClipKernel<double> kernel = { *B, *C };
+    vectorMap(kernel, D, ID, N, A, IA);
 }
 
 
@@ -413,70 +1058,50 @@ void vDSP_viclipD(const double* A, vDSP_Stride IA, const double* B, const double
 
 
 void vDSP_vlim(const float* A, vDSP_Stride IA, const float* B, const float* C, float* D, vDSP_Stride ID, vDSP_Length N) {
-    float b = *B;
-    float c = *C;
-    for (vDSP_Length i = 0; i < N; ++i) {
-        D[i*ID] = (A[i*IA] >=  b) ? c : -c;
-    }
+    const ThresholdSignedConstantKernel<float> kernel = { *B, *C };
+    vectorMap(kernel, D, ID, N, A, IA);
 }
 
 
 void vDSP_vlimD(const double* A, vDSP_Stride IA, const double* B, const double* C, double* D, vDSP_Stride ID, vDSP_Length N) {
-    double b = *B;
-    double c = *C;
-    for (vDSP_Length i = 0; i < N; ++i) {
-        D[i*ID] = (A[i*IA] >=  b) ? c : -c;
-    }
+    const ThresholdSignedConstantKernel<double> kernel = { *B, *C };
+    vectorMap(kernel, D, ID, N, A, IA);
 }
 
 
 void vDSP_vthr(const float* A, vDSP_Stride IA, const float* B, float* C, vDSP_Stride IC, vDSP_Length N) {
-    float  b = *B;
-    for (vDSP_Length i = 0; i < N; ++i) {
-        C[i*IC] = (A[i*IA] >=  b) ? A[i*IA] : b;
-    }
+    const ThresholdKernel<float> kernel = { *B };
+    vectorMap(kernel, C, IC, N, A, IA);
 }
 
 
 void vDSP_vthrD(const double* A, vDSP_Stride IA, const double* B, double* C, vDSP_Stride IC, vDSP_Length N) {
-    double  b = *B;
-    for (vDSP_Length i = 0; i < N; ++i) {
-        C[i*IC] = (A[i*IA] >=  b) ? A[i*IA] : b;
-    }
+    const ThresholdKernel<double> kernel = { *B };
+    vectorMap(kernel, C, IC, N, A, IA);
 }
 
 
 void vDSP_vthres(const float* A, vDSP_Stride IA, const float* B, float* C, vDSP_Stride IC, vDSP_Length N) {
-    float  b = *B;
-    for (vDSP_Length i = 0; i < N; ++i) {
-        C[i*IC] = (A[i*IA] >=  b) ? A[i*IA] : 0;
-    }
+    const ThresholdZeroKernel<float> kernel = { *B };
+    vectorMap(kernel, C, IC, N, A, IA);
 }
 
 
 void vDSP_vthresD(const double* A, vDSP_Stride IA, const double* B, double* C, vDSP_Stride IC, vDSP_Length N) {
-    double  b = *B;
-    for (vDSP_Length i = 0; i < N; ++i) {
-        C[i*IC] = (A[i*IA] >=  b) ? A[i*IA] : 0;
-    }
+    const ThresholdZeroKernel<double> kernel = { *B };
+    vectorMap(kernel, C, IC, N, A, IA);
 }
 
 
 void vDSP_vthrsc(const float* A, vDSP_Stride IA, const float* B, const float* C, float* D, vDSP_Stride ID, vDSP_Length N) {
-    float b = *B;
-    float c = *C;
-    for (vDSP_Length i = 0; i < N; ++i) {
-        D[i*ID] = (A[i*IA] >=  b) ? c : -c;
-    }
+    const ThresholdSignedConstantKernel<float> kernel = { *B, *C };
+    vectorMap(kernel, D, ID, N, A, IA);
 }
 
 
 void vDSP_vthrscD(const double* A, vDSP_Stride IA, const double* B, const double* C, double* D, vDSP_Stride ID, vDSP_Length N) {
-    double b = *B;
-    double c = *C;
-    for (vDSP_Length i = 0; i < N; ++i) {
-        D[i*ID] = (A[i*IA] >=  b) ? c : -c;
-    }
+    const ThresholdSignedConstantKernel<double> kernel = { *B, *C };
+    vectorMap(kernel, D, ID, N, A, IA);
 }
 
 
@@ -552,18 +1177,14 @@ void vDSP_vrvrsD(double* C, vDSP_Stride IC, vDSP_Length N) {
 
 
 void vDSP_zvmov(const DSPSplitComplex* A, vDSP_Stride IA, const DSPSplitComplex* C, vDSP_Stride IC, vDSP_Length N) {
-    for (vDSP_Length i = 0; i < N; ++i) {
-        C->realp[i*IC] = A->realp[i*IA];
-        C->imagp[i*IC] = A->imagp[i*IA];
-    }
+    vectorMap(CopyKernel(), C->realp, IC, N, A->realp, IA);
+    vectorMap(CopyKernel(), C->imagp, IC, N, A->imagp, IA);
 }
 
 
 void vDSP_zvmovD(const DSPDoubleSplitComplex* A, vDSP_Stride IA, const DSPDoubleSplitComplex* C, vDSP_Stride IC, vDSP_Length N) {
-    for (vDSP_Length i = 0; i < N; ++i) {
-        C->realp[i*IC] = A->realp[i*IA];
-        C->imagp[i*IC] = A->imagp[i*IA];
-    }
+    vectorMap(CopyKernel(), C->realp, IC, N, A->realp, IA);
+    vectorMap(CopyKernel(), C->imagp, IC, N, A->imagp, IA);
 }
 
 
@@ -669,20 +1290,16 @@ void vDSP_vdbconD(const double *A, vDSP_Stride IA, const double *B, double *C, v
     }
 }
 
-
-void vDSP_vsadd(const float *A, vDSP_Stride IA, const float *B, float *C, vDSP_Stride IC, vDSP_Length N) {
-    float b = *B;
-    for (vDSP_Length i = 0; i < N; ++i) {
-        C[i*IC] = A[i*IA] + b;
-    }
+
+void vDSP_vsadd(const float *A, vDSP_Stride IA, const float *B, float *C, vDSP_Stride IC, vDSP_Length N) {
+    const ScalarAddKernel<float> kernel = { *B };
+    vectorMap(kernel, C, IC, N, A, IA);
 }
 
 
 void vDSP_vsaddD(const double *A, vDSP_Stride IA, const double *B, double *C, vDSP_Stride IC, vDSP_Length N) {
-    double b = *B;
-    for (vDSP_Length i = 0; i < N; ++i) {
-        C[i*IC] = A[i*IA] + b;
-    }
+    const ScalarAddKernel<double> kernel = { *B };
+    vectorMap(kernel, C, IC, N, A, IA);
 }
 
 
@@ -695,18 +1312,14 @@ void vDSP_vsaddi(const int *A, vDSP_Stride IA, const int *B, int *C, vDSP_Stride
 
 
 void vDSP_vsmul(const float *A, vDSP_Stride IA, const float *B, float *C, vDSP_Stride IC, vDSP_Length N) {
-    float b = *B;
-    for (vDSP_Length i = 0; i < N; ++i) {
-        C[i*IC] = A[i*IA] * b;
-    }
+    const ScalarMultiplyKernel<float> kernel = { *B };
+    vectorMap(kernel, C, IC, N, A, IA);
 }
 
 
 void vDSP_vsmulD(const double *A, vDSP_Stride IA, const double *B, double *C, vDSP_Stride IC, vDSP_Length N) {
-    double b = *B;
-    for (vDSP_Length i = 0; i < N; ++i) {
-        C[i*IC] = A[i*IA] * b;
-    }
+    const ScalarMultiplyKernel<double> kernel = { *B };
+    vectorMap(kernel, C, IC, N, A, IA);
 }
 
 
@@ -714,9 +1327,12 @@ void vDSP_zvzsml(const DSPSplitComplex *A, vDSP_Stride IA, const DSPSplitComplex
                  vDSP_Stride IC, vDSP_Length N) {
     float realB = *(B->realp);
     float imagB = *(B->imagp);
-    for (vDSP_Length i = 0; i < N; ++i) {
-        C->realp[i*IC] = A->realp[i*IA] * realB - A->imagp[i*IA] * imagB;
-        C->imagp[i*IC] = A->realp[i*IA] * imagB + A->imagp[i*IA] * realB;
+    vDSP_Length i = (IA == 1 && IC == 1) ? unitStrideComplexScalarMultiply(A->realp, A->imagp, realB, imagB, C->realp, C->imagp, N) : 0;
+    for (; i < N; ++i) {
+        float realA = A->realp[i*IA];
+        float imagA = A->imagp[i*IA];
+        C->realp[i*IC] = realA * realB - imagA * imagB;
+        C->imagp[i*IC] = realA * imagB + imagA * realB;
     }
 }
 
@@ -725,61 +1341,53 @@ void vDSP_zvzsmlD(const DSPDoubleSplitComplex *A, vDSP_Stride IA, const DSPDoubl
                   vDSP_Stride IC, vDSP_Length N) {
     double realB = *(B->realp);
     double imagB = *(B->imagp);
-    for (vDSP_Length i = 0; i < N; ++i) {
-        C->realp[i*IC] = A->realp[i*IA] * realB - A->imagp[i*IA] * imagB;
-        C->imagp[i*IC] = A->realp[i*IA] * imagB + A->imagp[i*IA] * realB;
+    vDSP_Length i = (IA == 1 && IC == 1) ? unitStrideComplexScalarMultiply(A->realp, A->imagp, realB, imagB, C->realp, C->imagp, N) : 0;
+    for (; i < N; ++i) {
+        double realA = A->realp[i*IA];
+        double imagA = A->imagp[i*IA];
+        C->realp[i*IC] = realA * realB - imagA * imagB;
+        C->imagp[i*IC] = realA * imagB + imagA * realB;
     }
 }
 
 
 void vDSP_vadd(const float *A, vDSP_Stride IA, const float *B, vDSP_Stride IB, float *C, vDSP_Stride IC, vDSP_Length N) {
-    for (vDSP_Length i = 0; i < N; ++i) {
-        C[i*IC] = A[i*IA] + B[i*IB];
-    }
+    vectorMap(AddKernel(), C, IC, N, A, IA, B, IB);
 }
 
 
 void vDSP_vaddD(const double *A, vDSP_Stride IA, const double *B, vDSP_Stride IB, double *C, vDSP_Stride IC, vDSP_Length N) {
-    for (vDSP_Length i = 0; i < N; ++i) {
-        C[i*IC] = A[i*IA] + B[i*IB];
-    }
+    vectorMap(AddKernel(), C, IC, N, A, IA, B, IB);
 }
 
 
 void vDSP_vasm(const float *A, vDSP_Stride IA, const float *B, vDSP_Stride IB, const float *C, float *D, vDSP_Stride ID, vDSP_Length N) {
-    float c = *C;
-    for (vDSP_Length i = 0; i < N; ++i) {
-        D[i*ID] = (A[i*IA] + B[i*IB]) * c;
-    }
+    const AddScalarMultiplyKernel<float> kernel = { *C };
+    vectorMap(kernel, D, ID, N, A, IA, B, IB);
 }
 
 
 void vDSP_vasmD(const double *A, vDSP_Stride IA, const double *B, vDSP_Stride IB, const double *C, double *D, vDSP_Stride ID, 
                 vDSP_Length N) {
-    double c = *C;
-    for (vDSP_Length i = 0; i < N; ++i) {
-        D[i*ID] = (A[i*IA] + B[i*IB]) * c;
-    }
+    const AddScalarMultiplyKernel<double> kernel = { *C };
+    vectorMap(kernel, D, ID, N, A, IA, B, IB);
 }
 
 
 void vDSP_vmul(const float *A, vDSP_Stride IA, const float *B, vDSP_Stride IB, float *C, vDSP_Stride IC, vDSP_Length N) {
-    for (vDSP_Length i = 0; i < N; ++i) {
-        C[i*IC] = A[i*IA] * B[i*IB];
-    }
+    vectorMap(MultiplyKernel(), C, IC, N, A, IA, B, IB);
 }
 
 
 void vDSP_vmulD(const double *A, vDSP_Stride IA, const double *B, vDSP_Stride IB, double *C, vDSP_Stride IC, vDSP_Length N) {
-    for (vDSP_Length i = 0; i < N; ++i) {
-        C[i*IC] = A[i*IA] * B[i*IB];
-    }
+    vectorMap(MultiplyKernel(), C, IC, N, A, IA, B, IB);
 }
 
 
 void vDSP_maxv(const float *A, vDSP_Stride IA, float *C, vDSP_Length N) {
     float c = FLT_MIN;
-    for (vDSP_Length i = 0; i < N; ++i) {
+    vDSP_Length i = (IA == 1) ? unitStrideMax(A, N, c) : 0;
+    for (; i < N; ++i) {
         if (c < A[i*IA]) {
             c = A[i*IA];
         }
@@ -790,7 +1398,8 @@ void vDSP_maxv(const float *A, vDSP_Stride IA, float *C, vDSP_Length N) {
 
 void vDSP_maxvD(const double *A, vDSP_Stride IA, double *C, vDSP_Length N) {
     double c = DBL_MIN;
-    for (vDSP_Length i = 0; i < N; ++i) {
+    vDSP_Length i = (IA == 1) ? unitStrideMax(A, N, c) : 0;
+    for (; i < N; ++i) {
         if (c < A[i*IA]) {
             c = A[i*IA];
         }
@@ -804,7 +1413,8 @@ void vDSP_measqv(const float *A, vDSP_Stride IA, float *C, vDSP_Length N) {
     float t;
     if (N > 0) {
         float scale = 1.0f / sqrtf(static_cast<float>(N));
-        for (vDSP_Length i = 0; i < N; ++i) {
+        vDSP_Length i = (IA == 1) ? unitStrideScaledSumOfSquares(A, N, scale, c) : 0;
+        for (; i < N; ++i) {
             t = A[i*IA] * scale;
             c += t*t;
         }
@@ -821,7 +1431,8 @@ void vDSP_measqvD(const double *A, vDSP_Stride IA, double *C, vDSP_Length N) {
     double t;
     if (N > 0) {
         double scale = 1.0 / sqrt(N);
-        for (vDSP_Length i = 0; i < N; ++i) {
+        vDSP_Length i = (IA == 1) ? unitStrideScaledSumOfSquares(A, N, scale, c) : 0;
+        for (; i < N; ++i) {
             t = A[i*IA] * scale;
             c += t*t;
         }
@@ -838,7 +1449,7 @@ void vDSP_rmsqv(const float *A, vDSP_Stride IA, float *C, vDSP_Length N) {
     float t;
     if (N > 0) {
         float max = FP_ZERO;
-        for (vDSP_Length i = 0; i < N; ++i) {
+        for (vDSP_Length i = (IA == 1) ? unitStrideMaxMagnitude(A, N, max) : 0; i < N; ++i) {
             float val = fabs(A[i*IA]);
             if (val > max) {
                 max = val;
@@ -846,7 +1457,8 @@ void vDSP_rmsqv(const float *A, vDSP_Stride IA, float *C, vDSP_Length N) {
         }
         if (max > 0) {
             float scale = 1.0f / (max * sqrtf(static_cast<float>(N)));
-            for (vDSP_Length i = 0; i < N; ++i) {
+            vDSP_Length i = (IA == 1) ? unitStrideScaledSumOfSquares(A, N, scale, c) : 0;
+            for (; i < N; ++i) {
                 t = A[i*IA] * scale;
                 c += t*t;
             }
@@ -865,7 +1477,7 @@ void vDSP_rmsqvD(const double *A, vDSP_Stride IA, double *C, vDSP_Length N) {
     double t;
     if (N > 0) {
         double max = FP_ZERO;
-        for (vDSP_Length i = 0; i < N; ++i) {
+        for (vDSP_Length i = (IA == 1) ? unitStrideMaxMagnitude(A, N, max) : 0; i < N; ++i) {
             double val = fabs(A[i*IA]);
             if (val > max) {
                 max = val;
@@ -873,7 +1485,8 @@ void vDSP_rmsqvD(const double *A, vDSP_Stride IA, double *C, vDSP_Length N) {
         }
         if (max > 0) {
             double scale = 1.0 / (max * sqrt(N));
-            for (vDSP_Length i = 0; i < N; ++i) {
+            vDSP_Length i = (IA == 1) ? unitStrideScaledSumOfSquares(A, N, scale, c) : 0;
+            for (; i < N; ++i) {
                 t = A[i*IA] * scale;
                 c += t*t;
             }
@@ -919,6 +1532,488 @@ void vDSP_blkman_windowD(double *C, vDSP_Length N, int Flag) {
 }
 
 
+// FFT engine shared by the vDSP_fft_* and vDSP_DFT_* families.
+//
+// Power-of-two transforms run as an in-place radix-2 decimation-in-time FFT. The twiddle factors of the
+// stage that merges transforms of length h are stored contiguously at offset h - 1 of a stage table, so a
+// single table built for 2^log2n serves every smaller length and the butterflies read it with unit stride.
+// DFT lengths of 3, 5 or 15 times a power of two add one mixed-radix pass on top of the power-of-two FFTs.
+// Inverse transforms swap the real and imaginary arrays, which conjugates both the input and the output.
+namespace {
+
+template <typename T>
+struct FFTStageTwiddles {
+    vDSP_Length log2n;
+    std::unique_ptr<T[]> real;
+    std::unique_ptr<T[]> imag;
+};
+
+template <typename T>
+std::shared_ptr<const FFTStageTwiddles<T>> createStageTwiddles(vDSP_Length log2n) {
+    const vDSP_Length length = static_cast<vDSP_Length>(1) << log2n;
+    std::shared_ptr<FFTStageTwiddles<T>> twiddles(new (std::nothrow) FFTStageTwiddles<T>());
+    if (!twiddles) {
+        return nullptr;
+    }
+
+    twiddles->log2n = log2n;
+    twiddles->real.reset(new (std::nothrow) T[length]);
+    twiddles->imag.reset(new (std::nothrow) T[length]);
+    if (!twiddles->real || !twiddles->imag) {
+        return nullptr;
+    }
+
+    //Stage with half-length h holds exp(-i * pi * j / h) for j < h
+    for (vDSP_Length half = 1; half < length; half <<= 1) {
+        for (vDSP_Length j = 0; j < half; ++j) {
+            const double angle = -M_PI * j / half;
+            twiddles->real[half - 1 + j] = static_cast<T>(cos(angle));
+            twiddles->imag[half - 1 + j] = static_cast<T>(sin(angle));
+        }
+    }
+
+    return twiddles;
+}
+
+//Returns the stage table for transforms of up to 2^log2n elements; tables are shared by all live setups of the same size
+template <typename T>
+std::shared_ptr<const FFTStageTwiddles<T>> getStageTwiddles(vDSP_Length log2n) {
+    static std::mutex cacheLock;
+    static std::weak_ptr<const FFTStageTwiddles<T>> cache[sizeof(vDSP_Length) * 8];
+
+    if (log2n >= sizeof(vDSP_Length) * 8 - 1) {
+        return nullptr;
+    }
+
+    std::lock_guard<std::mutex> lock(cacheLock);
+    std::shared_ptr<const FFTStageTwiddles<T>> twiddles = cache[log2n].lock();
+    if (!twiddles) {
+        twiddles = createStageTwiddles<T>(log2n);
+        cache[log2n] = twiddles;
+    }
+
+    return twiddles;
+}
+
+template <typename V>
+inline void butterfly(typename V::Type& ar,
+                      typename V::Type& ai,
+                      typename V::Type& br,
+                      typename V::Type& bi,
+                      typename V::Type wr,
+                      typename V::Type wi) {
+    const typename V::Type tr = V::sub(V::mul(br, wr), V::mul(bi, wi));
+    const typename V::Type ti = V::add(V::mul(br, wi), V::mul(bi, wr));
+    br = V::sub(ar, tr);
+    bi = V::sub(ai, ti);
+    ar = V::add(ar, tr);
+    ai = V::add(ai, ti);
+}
+
+//Radix-2 stage of half-length h on one block of 2h elements
+template <typename V, typename T>
+inline vDSP_Length radix2Butterflies(T* real, T* imag, vDSP_Length h, const T* wr, const T* wi, vDSP_Length j) {
+    for (; j + V::width <= h; j += V::width) {
+        typename V::Type r0 = V::load(real + j);
+        typename V::Type i0 = V::load(imag + j);
+        typename V::Type r1 = V::load(real + j + h);
+        typename V::Type i1 = V::load(imag + j + h);
+        butterfly<V>(r0, i0, r1, i1, V::load(wr + j), V::load(wi + j));
+        V::store(real + j, r0);
+        V::store(imag + j, i0);
+        V::store(real + j + h, r1);
+        V::store(imag + j + h, i1);
+    }
+
+    return j;
+}
+
+//Two consecutive radix-2 stages of half-lengths h and 2h on one block of 4h elements, done in registers to halve the memory traffic
+template <typename V, typename T>
+inline vDSP_Length radix4Butterflies(
+    T* real, T* imag, vDSP_Length h, const T* w1r, const T* w1i, const T* w2r, const T* w2i, vDSP_Length j) {
+    for (; j + V::width <= h; j += V::width) {
+        typename V::Type r0 = V::load(real + j);
+        typename V::Type i0 = V::load(imag + j);
+        typename V::Type r1 = V::load(real + j + h);
+        typename V::Type i1 = V::load(imag + j + h);
+        typename V::Type r2 = V::load(real + j + 2 * h);
+        typename V::Type i2 = V::load(imag + j + 2 * h);
+        typename V::Type r3 = V::load(real + j + 3 * h);
+        typename V::Type i3 = V::load(imag + j + 3 * h);
+        const typename V::Type vW1r = V::load(w1r + j);
+        const typename V::Type vW1i = V::load(w1i + j);
+        butterfly<V>(r0, i0, r1, i1, vW1r, vW1i);
+        butterfly<V>(r2, i2, r3, i3, vW1r, vW1i);
+        butterfly<V>(r0, i0, r2, i2, V::load(w2r + j), V::load(w2i + j));
+        butterfly<V>(r1, i1, r3, i3, V::load(w2r + j + h), V::load(w2i + j + h));
+        V::store(real + j, r0);
+        V::store(imag + j, i0);
+        V::store(real + j + h, r1);
+        V::store(imag + j + h, i1);
+        V::store(real + j + 2 * h, r2);
+        V::store(imag + j + 2 * h, i2);
+        V::store(real + j + 3 * h, r3);
+        V::store(imag + j + 3 * h, i3);
+    }
+
+    return j;
+}
+
+template <typename T>
+void bitReversePermute(T* real, T* imag, vDSP_Length length) {
+    for (vDSP_Length i = 0, j = 0; i < length; ++i) {
+        if (i < j) {
+            std::swap(real[i], real[j]);
+            std::swap(imag[i], imag[j]);
+        }
+
+        vDSP_Length bit = length >> 1;
+        while (j & bit) {
+            j ^= bit;
+            bit >>= 1;
+        }
+
+        j |= bit;
+    }
+}
+
+//In-place forward FFT of 2^log2n contiguous elements; log2n must not exceed twiddles.log2n
+template <typename T>
+void fftPowerOfTwo(const FFTStageTwiddles<T>& twiddles, T* real, T* imag, vDSP_Length log2n) {
+    typedef typename VectorOps<T>::Type V;
+
+    const vDSP_Length length = static_cast<vDSP_Length>(1) << log2n;
+    bitReversePermute(real, imag, length);
+
+    vDSP_Length half = 1;
+    for (; half * 4 <= length; half *= 4) {
+        const T* w1r = twiddles.real.get() + half - 1;
+        const T* w1i = twiddles.imag.get() + half - 1;
+        const T* w2r = twiddles.real.get() + 2 * half - 1;
+        const T* w2i = twiddles.imag.get() + 2 * half - 1;
+        for (vDSP_Length base = 0; base < length; base += 4 * half) {
+            const vDSP_Length j = radix4Butterflies<V>(real + base, imag + base, half, w1r, w1i, w2r, w2i, 0);
+            radix4Butterflies<ScalarOps<T>>(real + base, imag + base, half, w1r, w1i, w2r, w2i, j);
+        }
+    }
+
+    if (half < length) {
+        const T* wr = twiddles.real.get() + half - 1;
+        const T* wi = twiddles.imag.get() + half - 1;
+        const vDSP_Length j = radix2Butterflies<V>(real, imag, half, wr, wi, 0);
+        radix2Butterflies<ScalarOps<T>>(real, imag, half, wr, wi, j);
+    }
+}
+
+template <typename T>
+void fftPowerOfTwo(const FFTStageTwiddles<T>& twiddles, T* real, T* imag, vDSP_Length log2n, int direction) {
+    if (direction == kFFTDirection_Inverse) {
+        fftPowerOfTwo(twiddles, imag, real, log2n);
+    } else {
+        fftPowerOfTwo(twiddles, real, imag, log2n);
+    }
+}
+
+//Turns the half-length complex FFT of real data packed as even/odd pairs into the vDSP packed real spectrum:
+//DC in real[0], Nyquist in imag[0] and the remaining bins in place, all scaled by 2. w holds exp(-2 * pi * i * k / (2 * half)).
+template <typename T>
+void realForwardPostprocess(T* real, T* imag, vDSP_Length half, const T* wr, const T* wi) {
+    const T z0r = real[0];
+    const T z0i = imag[0];
+    real[0] = 2 * (z0r + z0i);
+    imag[0] = 2 * (z0r - z0i);
+
+    for (vDSP_Length k = 1, m = half - 1; k <= m; ++k, --m) {
+        const T ar = real[k] + real[m];
+        const T ai = imag[k] - imag[m];
+        const T br = real[k] - real[m];
+        const T bi = imag[k] + imag[m];
+        const T cr = br * wr[k] - bi * wi[k];
+        const T ci = br * wi[k] + bi * wr[k];
+        real[k] = ar + ci;
+        imag[k] = ai - cr;
+        if (k != m) {
+            real[m] = ar - ci;
+            imag[m] = -ai - cr;
+        }
+    }
+}
+
+//Inverse of realForwardPostprocess, up to the scale: leaves the spectrum whose half-length inverse FFT yields the even/odd pairs
+template <typename T>
+void realInversePreprocess(T* real, T* imag, vDSP_Length half, const T* wr, const T* wi) {
+    const T dc = real[0];
+    const T nyquist = imag[0];
+    real[0] = dc + nyquist;
+    imag[0] = dc - nyquist;
+
+    for (vDSP_Length k = 1, m = half - 1; k <= m; ++k, --m) {
+        const T ar = real[k] + real[m];
+        const T ai = imag[k] - imag[m];
+        const T br = real[k] - real[m];
+        const T bi = imag[k] + imag[m];
+        const T cr = br * wr[k] + bi * wi[k];
+        const T ci = bi * wr[k] - br * wi[k];
+        real[k] = ar - ci;
+        imag[k] = ai + cr;
+        if (k != m) {
+            real[m] = ar + ci;
+            imag[m] = cr - ai;
+        }
+    }
+}
+
+//Runs a power-of-two FFT on split complex vectors with arbitrary strides. A and C may be the same vector.
+template <typename T, typename SplitComplex>
+void fftStrided(const FFTStageTwiddles<T>& twiddles,
+                const SplitComplex* A,
+                vDSP_Stride IA,
+                const SplitComplex* C,
+                vDSP_Stride IC,
+                vDSP_Length count,
+                void (*transform)(const FFTStageTwiddles<T>&, T*, T*, vDSP_Length, int),
+                vDSP_Length log2n,
+                int direction) {
+    T* real = C->realp;
+    T* imag = C->imagp;
+    std::unique_ptr<T[]> packed;
+    if (IC != 1) {
+        packed.reset(new (std::nothrow) T[2 * count]);
+        if (!packed) {
+            return;
+        }
+
+        real = packed.get();
+        imag = packed.get() + count;
+    }
+
+    if (real != A->realp || imag != A->imagp || IA != 1) {
+        for (vDSP_Length i = 0; i < count; ++i) {
+            real[i] = A->realp[i * IA];
+            imag[i] = A->imagp[i * IA];
+        }
+    }
+
+    transform(twiddles, real, imag, log2n, direction);
+
+    if (IC != 1) {
+        for (vDSP_Length i = 0; i < count; ++i) {
+            C->realp[i * IC] = real[i];
+            C->imagp[i * IC] = imag[i];
+        }
+    }
+}
+
+template <typename T>
+void fftComplexTransform(const FFTStageTwiddles<T>& twiddles, T* real, T* imag, vDSP_Length log2n, int direction) {
+    fftPowerOfTwo(twiddles, real, imag, log2n, direction);
+}
+
+//Real transforms of 2^log2n elements work on 2^(log2n - 1) even/odd pairs
+template <typename T>
+void fftRealTransform(const FFTStageTwiddles<T>& twiddles, T* real, T* imag, vDSP_Length log2n, int direction) {
+    const vDSP_Length half = static_cast<vDSP_Length>(1) << (log2n - 1);
+    const T* wr = twiddles.real.get() + half - 1;
+    const T* wi = twiddles.imag.get() + half - 1;
+    if (direction == kFFTDirection_Inverse) {
+        realInversePreprocess(real, imag, half, wr, wi);
+        fftPowerOfTwo(twiddles, real, imag, log2n - 1, direction);
+    } else {
+        fftPowerOfTwo(twiddles, real, imag, log2n - 1, direction);
+        realForwardPostprocess(real, imag, half, wr, wi);
+    }
+}
+
+template <typename T>
+struct DFTTwiddles {
+    typedef T ValueType;
+
+    vDSP_Length length;
+    vDSP_Length factor;
+    vDSP_Length log2PowerOfTwo;
+    std::shared_ptr<const FFTStageTwiddles<T>> stages;
+
+    //exp(-2 * pi * i * j / length) for j < length
+    std::unique_ptr<T[]> real;
+    std::unique_ptr<T[]> imag;
+};
+
+//Forward complex DFT of count elements, where count divides twiddles.length and is twiddles.factor times a power of two.
+//Input and output may alias. Scratch must hold 2 * count elements when twiddles.factor > 1.
+template <typename T>
+void dftComplex(const DFTTwiddles<T>& twiddles, const T* ir, const T* ii, T* outR, T* outI, vDSP_Length count, T* scratch) {
+    const vDSP_Length factor = twiddles.factor;
+    const vDSP_Length subLength = count / factor;
+    vDSP_Length log2SubLength = 0;
+    while ((static_cast<vDSP_Length>(1) << log2SubLength) < subLength) {
+        ++log2SubLength;
+    }
+
+    if (factor == 1) {
+        if (outR != ir || outI != ii) {
+            std::copy(ir, ir + count, outR);
+            std::copy(ii, ii + count, outI);
+        }
+
+        fftPowerOfTwo(*twiddles.stages, outR, outI, log2SubLength);
+        return;
+    }
+
+    //Decimate the input into factor interleaved power-of-two subsequences and transform each of them
+    T* subR = scratch;
+    T* subI = scratch + count;
+    for (vDSP_Length r = 0; r < factor; ++r) {
+        for (vDSP_Length n = 0; n < subLength; ++n) {
+            subR[r * subLength + n] = ir[n * factor + r];
+            subI[r * subLength + n] = ii[n * factor + r];
+        }
+
+        fftPowerOfTwo(*twiddles.stages, subR + r * subLength, subI + r * subLength, log2SubLength);
+    }
+
+    //Combine the subsequence spectra with one twiddled DFT of size factor per output column
+    const vDSP_Length stride = twiddles.length / count;
+    const T* wr = twiddles.real.get();
+    const T* wi = twiddles.imag.get();
+    T tr[15];
+    T ti[15];
+    for (vDSP_Length k = 0; k < subLength; ++k) {
+        for (vDSP_Length r = 0; r < factor; ++r) {
+            const vDSP_Length w = r * k * stride;
+            const T xr = subR[r * subLength + k];
+            const T xi = subI[r * subLength + k];
+            tr[r] = xr * wr[w] - xi * wi[w];
+            ti[r] = xr * wi[w] + xi * wr[w];
+        }
+
+        for (vDSP_Length q = 0; q < factor; ++q) {
+            T sumR = 0;
+            T sumI = 0;
+            for (vDSP_Length r = 0; r < factor; ++r) {
+                const vDSP_Length w = ((r * q) % factor) * subLength * stride;
+                sumR += tr[r] * wr[w] - ti[r] * wi[w];
+                sumI += tr[r] * wi[w] + ti[r] * wr[w];
+            }
+
+            outR[k + q * subLength] = sumR;
+            outI[k + q * subLength] = sumI;
+        }
+    }
+}
+
+template <typename TwiddleStruct>
+bool updateDFTTwiddles(TwiddleStruct*& twiddles, vDSP_Length length) {
+    typedef typename TwiddleStruct::ValueType T;
+
+    if (twiddles && twiddles->length == length) {
+        return true;
+    }
+
+    delete twiddles;
+    twiddles = nullptr;
+
+    std::unique_ptr<TwiddleStruct> created(new (std::nothrow) TwiddleStruct());
+    if (!created) {
+        return false;
+    }
+
+    created->length = length;
+    created->factor = length;
+    created->log2PowerOfTwo = 0;
+    while ((created->factor & 1) == 0) {
+        created->factor >>= 1;
+        ++created->log2PowerOfTwo;
+    }
+
+    created->stages = getStageTwiddles<T>(created->log2PowerOfTwo);
+    created->real.reset(new (std::nothrow) T[length]);
+    created->imag.reset(new (std::nothrow) T[length]);
+    if (!created->stages || !created->real || !created->imag) {
+        return false;
+    }
+
+    for (vDSP_Length j = 0; j < length; ++j) {
+        const double angle = -2 * M_PI * j / length;
+        created->real[j] = static_cast<T>(cos(angle));
+        created->imag[j] = static_cast<T>(sin(angle));
+    }
+
+    twiddles = created.release();
+    return true;
+}
+
+template <typename T>
+void dftExecute(const DFTTwiddles<T>& twiddles,
+                vDSP_DFT_TransformType type,
+                vDSP_DFT_Direction direction,
+                const T* ir,
+                const T* ii,
+                T* outR,
+                T* outI) {
+    const vDSP_Length length = twiddles.length;
+    const vDSP_Length half = length / 2;
+
+    if (type == ZOP) {
+        std::unique_ptr<T[]> scratch;
+        if (twiddles.factor > 1) {
+            scratch.reset(new (std::nothrow) T[2 * length]);
+            if (!scratch) {
+                return;
+            }
+        }
+
+        if (direction == vDSP_DFT_FORWARD) {
+            dftComplex(twiddles, ir, ii, outR, outI, length, scratch.get());
+        } else {
+            dftComplex(twiddles, ii, ir, outI, outR, length, scratch.get());
+        }
+    } else if (type == ZROP && half > 0) {
+        if (direction == vDSP_DFT_FORWARD) {
+            std::unique_ptr<T[]> scratch;
+            if (twiddles.factor > 1) {
+                scratch.reset(new (std::nothrow) T[length]);
+                if (!scratch) {
+                    return;
+                }
+            }
+
+            dftComplex(twiddles, ir, ii, outR, outI, half, scratch.get());
+            realForwardPostprocess(outR, outI, half, twiddles.real.get(), twiddles.imag.get());
+        } else {
+            //Real part of the full-length inverse transform, with the Nyquist adjustment that matches iOS behavior
+            std::unique_ptr<T[]> scratch(new (std::nothrow) T[4 * length]);
+            if (!scratch) {
+                return;
+            }
+
+            T* realOutput = scratch.get();
+            T* imagOutput = scratch.get() + length;
+            const T nyquist = ir[half];
+            dftComplex(twiddles, ii, ir, imagOutput, realOutput, length, scratch.get() + 2 * length);
+
+            for (vDSP_Length i = 0; i < half; i++) {
+                outR[i] = realOutput[2 * i + 0] - nyquist;
+                outI[i] = realOutput[2 * i + 1] + nyquist;
+            }
+        }
+    }
+}
+
+} // namespace
+
+struct vDSP_DFT_TwiddleStruct : DFTTwiddles<float> {};
+struct vDSP_DFT_TwiddleStructD : DFTTwiddles<double> {};
+
+struct OpaqueFFTSetup {
+    std::shared_ptr<const FFTStageTwiddles<float>> twiddles;
+};
+
+struct OpaqueFFTSetupD {
+    std::shared_ptr<const FFTStageTwiddles<double>> twiddles;
+};
+
+
 static inline int isPowerOfTwo(vDSP_Length length) {
     return !(length & (length - 1));
 }
@@ -936,7 +2031,7 @@ static inline int isValidDFTLength(vDSP_Length length, unsigned int minLength) {
 vDSP_DFT_Setup vDSP_DFT_zop_CreateSetup(vDSP_DFT_Setup __Previous, vDSP_Length __Length, vDSP_DFT_Direction __Direction) {
     vDSP_DFT_Setup DFTObject;
     if (!__Previous) {
-        DFTObject = new vDSP_DFT_SetupStruct;
+        DFTObject = new vDSP_DFT_SetupStruct();
     } else {
         DFTObject = __Previous;
     }
@@ -950,6 +2045,10 @@ vDSP_DFT_Setup vDSP_DFT_zop_CreateSetup(vDSP_DFT_Setup __Previous, vDSP_Length _
         return nullptr;
     }
 
+    if (!updateDFTTwiddles(DFTObject->twiddles, __Length)) {
+        return nullptr;
+    }
+
     DFTObject->transformLength = __Length;
     DFTObject->transformDirection = __Direction;
     DFTObject->transformType = ZOP;
@@ -961,7 +2060,7 @@ vDSP_DFT_Setup vDSP_DFT_zop_CreateSetup(vDSP_DFT_Setup __Previous, vDSP_Length _
 vDSP_DFT_SetupD vDSP_DFT_zop_CreateSetupD(vDSP_DFT_SetupD __Previous, vDSP_Length __Length, vDSP_DFT_Direction __Direction) {
     vDSP_DFT_SetupD DFTDObject;
     if (!__Previous) {
-        DFTDObject = new vDSP_DFT_SetupStructD;
+        DFTDObject = new vDSP_DFT_SetupStructD();
     } else {
         DFTDObject = __Previous;
     }
@@ -975,6 +2074,10 @@ vDSP_DFT_SetupD vDSP_DFT_zop_CreateSetupD(vDSP_DFT_SetupD __Previous, vDSP_Lengt
         return nullptr;
     }
 
+    if (!updateDFTTwiddles(DFTDObject->twiddles, __Length)) {
+        return nullptr;
+    }
+
     DFTDObject->transformLength = __Length;
     DFTDObject->transformDirection = __Direction;
     DFTDObject->transformType = ZOP;
@@ -986,7 +2089,7 @@ vDSP_DFT_SetupD vDSP_DFT_zop_CreateSetupD(vDSP_DFT_SetupD __Previous, vDSP_Lengt
 vDSP_DFT_Setup vDSP_DFT_zrop_CreateSetup(vDSP_DFT_Setup __Previous, vDSP_Length __Length, vDSP_DFT_Direction __Direction) {
     vDSP_DFT_Setup DFTObject;
     if (!__Previous) {
-        DFTObject = new vDSP_DFT_SetupStruct;
+        DFTObject = new vDSP_DFT_SetupStruct();
     } else {
         DFTObject = __Previous;
     }
@@ -1000,6 +2103,10 @@ vDSP_DFT_Setup vDSP_DFT_zrop_CreateSetup(vDSP_DFT_Setup __Previous, vDSP_Length
         return nullptr;
     }
 
+    if (!updateDFTTwiddles(DFTObject->twiddles, __Length)) {
+        return nullptr;
+    }
+
     DFTObject->transformLength = __Length;
     DFTObject->transformDirection = __Direction;
     DFTObject->transformType = ZROP;
@@ -1011,7 +2118,7 @@ vDSP_DFT_Setup vDSP_DFT_zrop_CreateSetup(vDSP_DFT_Setup __Previous, vDSP_Length
 vDSP_DFT_SetupD vDSP_DFT_zrop_CreateSetupD(vDSP_DFT_SetupD __Previous, vDSP_Length __Length, vDSP_DFT_Direction __Direction) {
     vDSP_DFT_SetupD DFTDObject;
     if (!__Previous) {
-        DFTDObject = new vDSP_DFT_SetupStructD;
+        DFTDObject = new vDSP_DFT_SetupStructD();
     } else {
         DFTDObject = __Previous;
     }
@@ -1025,6 +2132,10 @@ vDSP_DFT_SetupD vDSP_DFT_zrop_CreateSetupD(vDSP_DFT_SetupD __Previous, vDSP_Leng
         return nullptr;
     }
 
+    if (!updateDFTTwiddles(DFTDObject->twiddles, __Length)) {
+        return nullptr;
+    }
+
     DFTDObject->transformLength = __Length;
     DFTDObject->transformDirection = __Direction;
     DFTDObject->transformType = ZROP;
@@ -1034,187 +2145,199 @@ vDSP_DFT_SetupD vDSP_DFT_zrop_CreateSetupD(vDSP_DFT_SetupD __Previous, vDSP_Leng
 
 //Computes the single-precision DFT for a vector
 void vDSP_DFT_Execute(const struct vDSP_DFT_SetupStruct *__Setup, const float *__Ir, const float *__Ii, float *__Or, float *__Oi) {
-    if (!__Setup) {
+    if (!__Setup || !__Setup->twiddles) {
         return;
     }
 
-    int length = __Setup->transformLength;
-    int direction = __Setup->transformDirection;
-    float scale;
-    float kscale;
-    float real;
-    float imaginary;
-
-    if (__Setup->transformType == ZOP) {
-        scale = 2 * static_cast<float>(M_PI) * direction / length;
-        for (int k = 0; k < length; k++) {
-            real = 0;
-            imaginary = 0;
-            kscale = k * scale;
-            for (int n = 0; n < length; n++) {
-                real += (__Ir[n] * cos(n * kscale)) + (__Ii[n] * sin(n * kscale));
-                imaginary += (__Ii[n] * cos(n * kscale)) - (__Ir[n] * sin(n * kscale));
-            }
+    dftExecute<float>(*__Setup->twiddles, __Setup->transformType, __Setup->transformDirection, __Ir, __Ii, __Or, __Oi);
+}
 
-            __Or[k] = real;
-            __Oi[k] = imaginary;
-        }
-    } else if (__Setup->transformType == ZROP) {
-        if (direction == vDSP_DFT_FORWARD) {
-            float* realInput = new float[length];
-            for (int i = 0; i < length / 2; i++) {
-                realInput[2 * i + 0] = __Ir[i];
-                realInput[2 * i + 1] = __Ii[i];
-            }
 
-            scale = 2 * static_cast<float>(M_PI) / length;
-            for (int k = 0; k < length / 2; k++) {
-                real = 0;
-                imaginary = 0;
-                kscale = k * scale;
-                for (int n = 0; n < length; n++) {
-                    real += realInput[n] * cos(n * kscale);
-
-                    //Block added to match Apple's special case for the first imaginary output
-                    if (k == 0) {
-                        imaginary += realInput[n] * cos(static_cast<float>(M_PI) * n);
-                    } else {
-                        imaginary -= realInput[n] * sin(n * kscale);
-                    }
-                }
+//Computes the double-precision DFT for a vector
+void vDSP_DFT_ExecuteD(const struct vDSP_DFT_SetupStructD *__Setup, const double *__Ir, const double *__Ii, double *__Or, double *__Oi) {
+    if (!__Setup || !__Setup->twiddles) {
+        return;
+    }
 
-                __Or[k] = real * 2;
-                __Oi[k] = imaginary * 2;
-            }
+    dftExecute<double>(*__Setup->twiddles, __Setup->transformType, __Setup->transformDirection, __Ir, __Ii, __Or, __Oi);
+}
 
-            delete realInput;
-        } else if (direction == vDSP_DFT_INVERSE) {
-            float* realOutput = new float[length];
-            scale = 2 * static_cast<float>(M_PI) / length;
-            for (int k = 0; k < length; k++) {
-                real = 0;
-                kscale = k * scale;
-                for (int n = 0; n < length; n++) {
-                    real += (__Ir[n] * cos(n * kscale)) - (__Ii[n] * sin(n * kscale));
-                }
 
-                realOutput[k] = real;
-            }
+//Releases a single-precision setup object
+void vDSP_DFT_DestroySetup(vDSP_DFT_Setup __Setup) {
+    if (__Setup) {
+        delete __Setup->twiddles;
+        delete __Setup;
+    }
 
-            for (int i = 0; i < length / 2; i++) {
-                __Or[i] = realOutput[2 * i + 0];
-                __Oi[i] = realOutput[2 * i + 1];
+    return;
+}
 
-                //Block added to match iOS behavior
-                __Or[i] -= __Ir[length / 2];
-                __Oi[i] += __Ir[length / 2];
-            }
 
-            delete realOutput;
-        }
+//Releases a double-precision setup object
+void vDSP_DFT_DestroySetupD(vDSP_DFT_SetupD __Setup) {
+    if (__Setup) {
+        delete __Setup->twiddles;
+        delete __Setup;
     }
+
+    return;
 }
 
 
-//Computes the double-precision DFT for a vector
-void vDSP_DFT_ExecuteD(const struct vDSP_DFT_SetupStructD *__Setup, const double *__Ir, const double *__Ii, double *__Or, double *__Oi) {
-    if (!__Setup) {
+//Creates a setup object holding the twiddle factors for single-precision FFTs of up to 2^__Log2n elements.
+//Only radix-2 transforms are provided.
+FFTSetup vDSP_create_fftsetup(vDSP_Length __Log2n, FFTRadix __Radix) {
+    if (__Radix != kFFTRadix2) {
+        return nullptr;
+    }
+
+    std::unique_ptr<OpaqueFFTSetup> setup(new (std::nothrow) OpaqueFFTSetup());
+    if (!setup) {
+        return nullptr;
+    }
+
+    setup->twiddles = getStageTwiddles<float>(__Log2n);
+    return setup->twiddles ? setup.release() : nullptr;
+}
+
+
+//Creates a setup object holding the twiddle factors for double-precision FFTs of up to 2^__Log2n elements.
+//Only radix-2 transforms are provided.
+FFTSetupD vDSP_create_fftsetupD(vDSP_Length __Log2n, FFTRadix __Radix) {
+    if (__Radix != kFFTRadix2) {
+        return nullptr;
+    }
+
+    std::unique_ptr<OpaqueFFTSetupD> setup(new (std::nothrow) OpaqueFFTSetupD());
+    if (!setup) {
+        return nullptr;
+    }
+
+    setup->twiddles = getStageTwiddles<double>(__Log2n);
+    return setup->twiddles ? setup.release() : nullptr;
+}
+
+
+//Releases a single-precision FFT setup object
+void vDSP_destroy_fftsetup(FFTSetup __setup) {
+    delete __setup;
+}
+
+
+//Releases a double-precision FFT setup object
+void vDSP_destroy_fftsetupD(FFTSetupD __setup) {
+    delete __setup;
+}
+
+
+//Computes an in-place single-precision complex FFT
+void vDSP_fft_zip(FFTSetup __Setup, const DSPSplitComplex* __C, vDSP_Stride __IC, vDSP_Length __Log2N, FFTDirection __Direction) {
+    if (!__Setup || __Log2N > __Setup->twiddles->log2n) {
         return;
     }
 
-    int length = __Setup->transformLength;
-    int direction = __Setup->transformDirection;
-    double scale;
-    double kscale;
-    double real;
-    double imaginary;
-
-    if (__Setup->transformType == ZOP) {
-        scale = 2 * M_PI * direction / length;
-        for (int k = 0; k < length; k++) {
-            real = 0;
-            imaginary = 0;
-            kscale = k * scale;
-            for (int n = 0; n < length; n++) {
-                real += (__Ir[n] * cos(n * kscale)) + (__Ii[n] * sin(n * kscale));
-                imaginary += (__Ii[n] * cos(n * kscale)) - (__Ir[n] * sin(n * kscale));
-            }
+    fftStrided<float>(*__Setup->twiddles, __C, __IC, __C, __IC, static_cast<vDSP_Length>(1) << __Log2N, fftComplexTransform<float>,
+                      __Log2N, __Direction);
+}
 
-            __Or[k] = real;
-            __Oi[k] = imaginary;
-        }
-    } else if (__Setup->transformType == ZROP) {
-        if (direction == vDSP_DFT_FORWARD) {
-            double* realInput = new double[length];
-            for (int i = 0; i < length / 2; i++) {
-                realInput[2 * i + 0] = __Ir[i];
-                realInput[2 * i + 1] = __Ii[i];
-            }
 
-            scale = 2 * M_PI / length;
-            for (int k = 0; k < length / 2; k++) {
-                real = 0;
-                imaginary = 0;
-                kscale = k * scale;
-                for (int n = 0; n < length; n++) {
-                    real += realInput[n] * cos(n * kscale);
-
-                    //Block added to match Apple's special case for the first imaginary output
-                    if (k == 0) {
-                        imaginary += realInput[n] * cos(M_PI * n);
-                    } else {
-                        imaginary -= realInput[n] * sin(n * kscale);
-                    }
-                }
+//Computes an in-place double-precision complex FFT
+void vDSP_fft_zipD(FFTSetupD __Setup, const DSPDoubleSplitComplex* __C, vDSP_Stride __IC, vDSP_Length __Log2N, FFTDirection __Direction) {
+    if (!__Setup || __Log2N > __Setup->twiddles->log2n) {
+        return;
+    }
 
-                __Or[k] = real * 2;
-                __Oi[k] = imaginary * 2;
-            }
+    fftStrided<double>(*__Setup->twiddles, __C, __IC, __C, __IC, static_cast<vDSP_Length>(1) << __Log2N, fftComplexTransform<double>,
+                       __Log2N, __Direction);
+}
 
-            delete realInput;
-        } else if (direction == vDSP_DFT_INVERSE) {
-            double* realOutput = new double[length];
-            scale = 2 * M_PI / length;
-            for (int k = 0; k < length; k++) {
-                real = 0;
-                kscale = k * scale;
-                for (int n = 0; n < length; n++) {
-                    real += (__Ir[n] * cos(n * kscale)) - (__Ii[n] * sin(n * kscale));
-                }
 
-                realOutput[k] = real;
-            }
+//Computes an out-of-place single-precision complex FFT
+void vDSP_fft_zop(FFTSetup __Setup,
+                  const DSPSplitComplex* __A,
+                  vDSP_Stride __IA,
+                  const DSPSplitComplex* __C,
+                  vDSP_Stride __IC,
+                  vDSP_Length __Log2N,
+                  FFTDirection __Direction) {
+    if (!__Setup || __Log2N > __Setup->twiddles->log2n) {
+        return;
+    }
 
-            for (int i = 0; i < length / 2; i++) {
-                __Or[i] = realOutput[2 * i + 0];
-                __Oi[i] = realOutput[2 * i + 1];
+    fftStrided<float>(*__Setup->twiddles, __A, __IA, __C, __IC, static_cast<vDSP_Length>(1) << __Log2N, fftComplexTransform<float>,
+                      __Log2N, __Direction);
+}
 
-                //Block added to match iOS behavior
-                __Or[i] -= __Ir[length / 2];
-                __Oi[i] += __Ir[length / 2];
-            }
 
-            delete realOutput;
-        }
+//Computes an out-of-place double-precision complex FFT
+void vDSP_fft_zopD(FFTSetupD __Setup,
+                   const DSPDoubleSplitComplex* __A,
+                   vDSP_Stride __IA,
+                   const DSPDoubleSplitComplex* __C,
+                   vDSP_Stride __IC,
+                   vDSP_Length __Log2N,
+                   FFTDirection __Direction) {
+    if (!__Setup || __Log2N > __Setup->twiddles->log2n) {
+        return;
     }
+
+    fftStrided<double>(*__Setup->twiddles, __A, __IA, __C, __IC, static_cast<vDSP_Length>(1) << __Log2N, fftComplexTransform<double>,
+                       __Log2N, __Direction);
 }
 
 
-//Releases a single-precision setup object
-void vDSP_DFT_DestroySetup(vDSP_DFT_Setup __Setup) {
-    if (__Setup) {
-        delete __Setup;
+//Computes an in-place single-precision real FFT on 2^__Log2N real values packed as even/odd pairs (see vDSP_ctoz)
+void vDSP_fft_zrip(FFTSetup __Setup, const DSPSplitComplex* __C, vDSP_Stride __IC, vDSP_Length __Log2N, FFTDirection __Direction) {
+    if (!__Setup || __Log2N == 0 || __Log2N > __Setup->twiddles->log2n) {
+        return;
     }
 
-    return;
+    fftStrided<float>(*__Setup->twiddles, __C, __IC, __C, __IC, static_cast<vDSP_Length>(1) << (__Log2N - 1), fftRealTransform<float>,
+                      __Log2N, __Direction);
 }
 
 
-//Releases a double-precision setup object
-void vDSP_DFT_DestroySetupD(vDSP_DFT_SetupD __Setup) {
-    if (__Setup) {
-        delete __Setup;
+//Computes an in-place double-precision real FFT on 2^__Log2N real values packed as even/odd pairs (see vDSP_ctozD)
+void vDSP_fft_zripD(FFTSetupD __Setup, const DSPDoubleSplitComplex* __C, vDSP_Stride __IC, vDSP_Length __Log2N, FFTDirection __Direction) {
+    if (!__Setup || __Log2N == 0 || __Log2N > __Setup->twiddles->log2n) {
+        return;
     }
 
-    return;
-}
\ No newline at end of file
+    fftStrided<double>(*__Setup->twiddles, __C, __IC, __C, __IC, static_cast<vDSP_Length>(1) << (__Log2N - 1), fftRealTransform<double>,
+                       __Log2N, __Direction);
+}
+
+
+//Computes an out-of-place single-precision real FFT on 2^__Log2N real values packed as even/odd pairs
+void vDSP_fft_zrop(FFTSetup __Setup,
+                   const DSPSplitComplex* __A,
+                   vDSP_Stride __IA,
+                   const DSPSplitComplex* __C,
+                   vDSP_Stride __IC,
+                   vDSP_Length __Log2N,
+                   FFTDirection __Direction) {
+    if (!__Setup || __Log2N == 0 || __Log2N > __Setup->twiddles->log2n) {
+        return;
+    }
+
+    fftStrided<float>(*__Setup->twiddles, __A, __IA, __C, __IC, static_cast<vDSP_Length>(1) << (__Log2N - 1), fftRealTransform<float>,
+                      __Log2N, __Direction);
+}
+
+
+//Computes an out-of-place double-precision real FFT on 2^__Log2N real values packed as even/odd pairs
+void vDSP_fft_zropD(FFTSetupD __Setup,
+                    const DSPDoubleSplitComplex* __A,
+                    vDSP_Stride __IA,
+                    const DSPDoubleSplitComplex* __C,
+                    vDSP_Stride __IC,
+                    vDSP_Length __Log2N,
+                    FFTDirection __Direction) {
+    if (!__Setup || __Log2N == 0 || __Log2N > __Setup->twiddles->log2n) {
+        return;
+    }
+
+    fftStrided<double>(*__Setup->twiddles, __A, __IA, __C, __IC, static_cast<vDSP_Length>(1) << (__Log2N - 1), fftRealTransform<double>,
+                       __Log2N, __Direction);
+}
@@ -19,22 +19,69 @@
 #include "ErrorHandling.h"
 #include "LoggingNative.h"
 #include <algorithm>
+#include <cmath>
+#include <memory>
 #include <new>
+#include <system_error>
+#include <thread>
+#include <vector>
 
 static const wchar_t* TAG = L"vImage";
 
-/**
-@Status Interoperable
-*/
-vImage_Error vImageBoxConvolve_ARGB8888(const vImage_Buffer* src,
-                                        const vImage_Buffer* dest,
-                                        void* tempBuffer,
-                                        vImagePixelCount srcOffsetToROI_X,
-                                        vImagePixelCount srcOffsetToROI_Y,
-                                        uint32_t kernel_height,
-                                        uint32_t kernel_width,
-                                        const Pixel_8888 backgroundColor,
-                                        vImage_Flags flags) {
+// Edge handling for the convolution engine, in the order of precedence the flags are honored
+enum _vImageConvolveEdgeMode {
+    _vImageConvolveEdgeCopyInPlace,
+    _vImageConvolveEdgeTruncateKernel,
+    _vImageConvolveEdgeBackgroundColorFill,
+    _vImageConvolveEdgeExtend,
+};
+
+// A 1D filter expressed as a cascade of box filters. A box of width n is one stage and a tent of width 2n - 1 is two boxes of width n,
+// which lets both be evaluated with running sums at a constant cost per pixel regardless of the kernel size.
+struct _vImageBoxCascade {
+    uint32_t stageCount;
+    uint32_t stageLengths[2];
+
+    uint64_t weight() const {
+        return (stageCount == 1) ? stageLengths[0] : static_cast<uint64_t>(stageLengths[0]) * stageLengths[1];
+    }
+};
+
+struct _vImageConvolveJob {
+    const vImage_Buffer* src;
+    const vImage_Buffer* dest;
+    ptrdiff_t srcOffsetToROI_X;
+    ptrdiff_t srcOffsetToROI_Y;
+    uint32_t kernelHeight;
+    uint32_t kernelWidth;
+    _vImageConvolveEdgeMode edgeMode;
+    Pixel_8888_s background;
+
+    // Lanes of a gathered source row: one 32-bit lane per channel of dest->width + kernelWidth - 1 pixels
+    size_t paddedRowLanes() const {
+        return (dest->width + kernelWidth - 1) * 4;
+    }
+
+    size_t destRowLanes() const {
+        return dest->width * 4;
+    }
+};
+
+
+static inline size_t _vImageAlignScratch(size_t bytes) {
+    return _vImageAlignSizeT(bytes, 16);
+}
+
+static vImage_Error _vImageValidateConvolve(const vImage_Buffer* src,
+                                            const vImage_Buffer* dest,
+                                            vImagePixelCount srcOffsetToROI_X,
+                                            vImagePixelCount srcOffsetToROI_Y,
+                                            uint32_t kernel_height,
+                                            uint32_t kernel_width,
+                                            const Pixel_8888 backgroundColor,
+                                            vImage_Flags flags) {
+    const unsigned long maxVal = 2147483647;
+
     if (src == nullptr || dest == nullptr || src->data == nullptr || dest->data == nullptr) {
         return kvImageNullPointerArgument;
     } else if (!(kernel_height & kernel_width & 1)) {
@@ -48,10 +95,11 @@ vImage_Error vImageBoxConvolve_ARGB8888(const vImage_Buffer* src,
     } else if (!(flags & kvImageCopyInPlace) && !(flags & kvImageBackgroundColorFill) && !(flags & kvImageEdgeExtend) &&
                !(flags & kvImageTruncateKernel)) {
         return kvImageInvalidEdgeStyle;
+    } else if (!(flags & (kvImageCopyInPlace | kvImageTruncateKernel)) && (flags & kvImageBackgroundColorFill) &&
+               (backgroundColor == nullptr)) {
+        return kvImageNullPointerArgument;
     }
 
-    const unsigned long maxVal = 2147483647;
-
     //  Caveat: We return kvImageInvalidParameter for height, width, srcOffsetToROI_X, and srcOffsetToROI_Y >=2^31
     //  For 32 bit OS, we don't expect size >= 2^31. Hence it is not supported in current release.
     //  TODO for 64-bit
@@ -60,775 +108,1359 @@ vImage_Error vImageBoxConvolve_ARGB8888(const vImage_Buffer* src,
         return kvImageInvalidParameter;
     }
 
-    int KW_d2 = kernel_width / 2;
-    int KH_d2 = kernel_height / 2;
+    return kvImageNoError;
+}
 
-    //  The following 4 variable denote the location of the first and last pixel to have the kernel
-    //  completely overlapping with source image
-    uint32_t start_i = 0;
-    uint32_t start_j = 0;
-    uint32_t end_i = dest->height - 1;
-    uint32_t end_j = dest->width - 1;
+static _vImageConvolveJob _vImageMakeConvolveJob(const vImage_Buffer* src,
+                                                 const vImage_Buffer* dest,
+                                                 vImagePixelCount srcOffsetToROI_X,
+                                                 vImagePixelCount srcOffsetToROI_Y,
+                                                 uint32_t kernel_height,
+                                                 uint32_t kernel_width,
+                                                 const Pixel_8888 backgroundColor,
+                                                 vImage_Flags flags) {
+    _vImageConvolveJob job;
+    job.src = src;
+    job.dest = dest;
+    job.srcOffsetToROI_X = static_cast<ptrdiff_t>(srcOffsetToROI_X);
+    job.srcOffsetToROI_Y = static_cast<ptrdiff_t>(srcOffsetToROI_Y);
+    job.kernelHeight = kernel_height;
+    job.kernelWidth = kernel_width;
+    memset(&job.background, 0, sizeof(job.background));
 
-    if (static_cast<int>(srcOffsetToROI_Y) < KH_d2) {
-        start_i = KH_d2 - srcOffsetToROI_Y;
+    if (flags & kvImageCopyInPlace) {
+        job.edgeMode = _vImageConvolveEdgeCopyInPlace;
+    } else if (flags & kvImageTruncateKernel) {
+        job.edgeMode = _vImageConvolveEdgeTruncateKernel;
+    } else if (flags & kvImageBackgroundColorFill) {
+        job.edgeMode = _vImageConvolveEdgeBackgroundColorFill;
+        memcpy(job.background.val, backgroundColor, sizeof(job.background.val));
+    } else {
+        job.edgeMode = _vImageConvolveEdgeExtend;
+    }
+
+    return job;
+}
+
+// Images below this many pixels per band are not worth splitting across threads
+static const size_t c_vImageMinPixelsPerBand = 64 * 1024;
+static const size_t c_vImageMaxBands = 16;
+
+// Number of row bands a destination of the given size is split into, each processed on its own thread.
+// Bands are kept at least minBandRows tall so that per-band overlap stays small.
+static size_t _vImageRowBandCount(size_t width, size_t height, size_t minBandRows, vImage_Flags flags) {
+    if (flags & kvImageDoNotTile) {
+        return 1;
     }
 
-    if (static_cast<int>(srcOffsetToROI_X) < KW_d2) {
-        start_j = KW_d2 - srcOffsetToROI_X;
+    const size_t threads = std::max<size_t>(1, std::thread::hardware_concurrency());
+    const size_t byPixels = (width * height) / c_vImageMinPixelsPerBand;
+    const size_t byRows = height / std::max<size_t>(1, minBandRows);
+    return std::max<size_t>(1, std::min(std::min(threads, c_vImageMaxBands), std::min(byPixels, byRows)));
+}
+
+static inline size_t _vImageRowBandHeight(size_t height, size_t bandCount) {
+    return (height + bandCount - 1) / bandCount;
+}
+
+// Runs body(band, firstRow, endRow) for every band of rows, using worker threads for all but the first band
+template <typename Body>
+static void _vImageForEachRowBand(size_t height, size_t bandCount, const Body& body) {
+    const size_t bandRows = _vImageRowBandHeight(height, bandCount);
+    std::thread workers[c_vImageMaxBands];
+    size_t workerCount = 0;
+
+    for (size_t band = 1; band < bandCount; ++band) {
+        const size_t firstRow = band * bandRows;
+        const size_t endRow = std::min<size_t>(firstRow + bandRows, height);
+        if (firstRow >= endRow) {
+            break;
+        }
+
+        try {
+            workers[workerCount] = std::thread([&body, band, firstRow, endRow]() { body(band, firstRow, endRow); });
+            ++workerCount;
+        } catch (const std::system_error&) {
+            body(band, firstRow, endRow);
+        }
     }
 
-    if (src->height < (srcOffsetToROI_Y + dest->height + KH_d2)) {
-        end_i = src->height - srcOffsetToROI_Y - KH_d2 - 1;
+    body(0, 0, std::min<size_t>(bandRows, height));
+
+    for (size_t i = 0; i < workerCount; ++i) {
+        workers[i].join();
     }
+}
+
+// Every convolution band re-filters kernelHeight - 1 rows of overlap, so keep bands comfortably taller than the kernel
+static inline size_t _vImageConvolveBandCount(const _vImageConvolveJob& job, vImage_Flags flags) {
+    return _vImageRowBandCount(job.dest->width, job.dest->height, 2 * job.kernelHeight, flags);
+}
+
+// Gathers the source pixels under one destination row, widened to a 32-bit lane per channel. srcRow may lie outside the source
+// image, and the row is padded by kernelWidth / 2 pixels on each side following the job's edge mode.
+static void _vImageGatherConvolveRow(const _vImageConvolveJob& job, ptrdiff_t srcRow, int32_t* lanes) {
+    const ptrdiff_t srcHeight = static_cast<ptrdiff_t>(job.src->height);
+    const ptrdiff_t srcWidth = static_cast<ptrdiff_t>(job.src->width);
+    const ptrdiff_t count = static_cast<ptrdiff_t>(job.dest->width + job.kernelWidth - 1);
+    const ptrdiff_t firstColumn = job.srcOffsetToROI_X - static_cast<ptrdiff_t>(job.kernelWidth / 2);
+
+    Pixel_8888_s outside = job.background;
+    const bool rowInside = (srcRow >= 0) && (srcRow < srcHeight);
+    if (!rowInside) {
+        if ((job.edgeMode == _vImageConvolveEdgeBackgroundColorFill) || (job.edgeMode == _vImageConvolveEdgeTruncateKernel)) {
+            for (ptrdiff_t j = 0; j < count; ++j) {
+                lanes[4 * j + 0] = outside.val[0];
+                lanes[4 * j + 1] = outside.val[1];
+                lanes[4 * j + 2] = outside.val[2];
+                lanes[4 * j + 3] = outside.val[3];
+            }
 
-    if (src->width < (srcOffsetToROI_X + dest->width + KW_d2)) {
-        end_j = src->width - srcOffsetToROI_X - KW_d2 - 1;
+            return;
+        }
+
+        srcRow = (srcRow < 0) ? 0 : srcHeight - 1;
     }
 
-    //  The following two variable denote the no of rows required for temporary storage for first pass
-    //  above and below the RoI
-    int top = KH_d2 - start_i;
-    int below = end_i + 1 + KH_d2 - dest->height;
+    const Pixel_8888_s* srcPixels =
+        reinterpret_cast<const Pixel_8888_s*>(static_cast<const uint8_t*>(job.src->data) + srcRow * job.src->rowBytes);
 
-    //  returns the size of temporary buffer data
-    if (flags & kvImageGetTempBufferSize) {
-        return (dest->height + (top + below) * dest->width) * sizeof(Pixel_8888_s);
+    //  Columns [insideBegin, insideEnd) of the padded row come straight from the source row
+    const ptrdiff_t insideBegin = std::min(count, std::max<ptrdiff_t>(0, -firstColumn));
+    const ptrdiff_t insideEnd = std::max(insideBegin, std::min(count, srcWidth - firstColumn));
+
+    if (job.edgeMode != _vImageConvolveEdgeBackgroundColorFill && job.edgeMode != _vImageConvolveEdgeTruncateKernel) {
+        outside = srcPixels[0];
     }
 
-    //  Pointer to access the temporary buffer data.
-    Pixel_8888_s* temp_buf;
-    bool tempBuffer_flag = 0;
+    for (ptrdiff_t j = 0; j < insideBegin; ++j) {
+        lanes[4 * j + 0] = outside.val[0];
+        lanes[4 * j + 1] = outside.val[1];
+        lanes[4 * j + 2] = outside.val[2];
+        lanes[4 * j + 3] = outside.val[3];
+    }
 
-    if (tempBuffer == nullptr) {
-        temp_buf = new (std::nothrow) Pixel_8888_s[(dest->height + (top + below) * dest->width)];
-        if (temp_buf == nullptr) {
-            return kvImageMemoryAllocationError;
+    ptrdiff_t j = insideBegin;
+
+#if (VIMAGE_SSE == 1)
+    if (c_vImageUseSse2 == true) {
+        const __m128i vZero = _mm_setzero_si128();
+        for (; j + 4 <= insideEnd; j += 4) {
+            const __m128i vPixels = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&srcPixels[firstColumn + j]));
+            const __m128i vLow = _mm_unpacklo_epi8(vPixels, vZero);
+            const __m128i vHigh = _mm_unpackhi_epi8(vPixels, vZero);
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(&lanes[4 * j + 0]), _mm_unpacklo_epi16(vLow, vZero));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(&lanes[4 * j + 4]), _mm_unpackhi_epi16(vLow, vZero));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(&lanes[4 * j + 8]), _mm_unpacklo_epi16(vHigh, vZero));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(&lanes[4 * j + 12]), _mm_unpackhi_epi16(vHigh, vZero));
         }
-        tempBuffer_flag = 1;
-    } else {
-        temp_buf = static_cast<Pixel_8888_s*>(tempBuffer);
     }
+#endif
 
-    uint32_t sum[4] = { 0 };
-    uint32_t src_i;
-    uint32_t src_j;
-    Pixel_8888_s* src_buf = static_cast<Pixel_8888_s*>(src->data);
-    Pixel_8888_s* dest_buf = static_cast<Pixel_8888_s*>(dest->data);
-    size_t src_rowstride = src->rowBytes / sizeof(Pixel_8888);
-    size_t dest_rowstride = dest->rowBytes / sizeof(Pixel_8888);
+    for (; j < insideEnd; ++j) {
+        const Pixel_8888_s& pixel = srcPixels[firstColumn + j];
+        lanes[4 * j + 0] = pixel.val[0];
+        lanes[4 * j + 1] = pixel.val[1];
+        lanes[4 * j + 2] = pixel.val[2];
+        lanes[4 * j + 3] = pixel.val[3];
+    }
 
-    //  This block deals with code for flag kvImageCopyInPlace, which require the pixel to be copied as is
-    //  from source image when the kernel does not overlap with the image data
-    if (flags & kvImageCopyInPlace) {
-        bool sum_flag = 0;
-
-        //  First pass (horizontal)
-        for (uint32_t i = 0; i < dest->height; ++i) {
-            src_i = srcOffsetToROI_Y + i;
-            src_j = srcOffsetToROI_X;
-            sum_flag = 0;
-            sum[0] = 0;
-            sum[1] = 0;
-            sum[2] = 0;
-            sum[3] = 0;
-
-            for (uint32_t j = 0; j < dest->width; ++j, src_j++) {
-                //  Copying the pixel data as is from source for no kernel overlap section
-                if (j < start_j || j > end_j) {
-                    dest_buf[i * dest_rowstride + j] = src_buf[src_i * src_rowstride + src_j];
-                } else {
-                    if (sum_flag == 0) {
-                        sum_flag = 1;
-                        for (int k = -KW_d2; k <= KW_d2; ++k) {
-                            sum[0] += src_buf[src_i * src_rowstride + src_j + k].val[0];
-                            sum[1] += src_buf[src_i * src_rowstride + src_j + k].val[1];
-                            sum[2] += src_buf[src_i * src_rowstride + src_j + k].val[2];
-                            sum[3] += src_buf[src_i * src_rowstride + src_j + k].val[3];
-                        }
-                    } else {
-                        sum[0] += -src_buf[src_i * src_rowstride + src_j - KW_d2 - 1].val[0] +
-                                  src_buf[src_i * src_rowstride + src_j + KW_d2].val[0];
-                        sum[1] += -src_buf[src_i * src_rowstride + src_j - KW_d2 - 1].val[1] +
-                                  src_buf[src_i * src_rowstride + src_j + KW_d2].val[1];
-                        sum[2] += -src_buf[src_i * src_rowstride + src_j - KW_d2 - 1].val[2] +
-                                  src_buf[src_i * src_rowstride + src_j + KW_d2].val[2];
-                        sum[3] += -src_buf[src_i * src_rowstride + src_j - KW_d2 - 1].val[3] +
-                                  src_buf[src_i * src_rowstride + src_j + KW_d2].val[3];
-                    }
+    if (job.edgeMode != _vImageConvolveEdgeBackgroundColorFill && job.edgeMode != _vImageConvolveEdgeTruncateKernel) {
+        outside = srcPixels[srcWidth - 1];
+    }
 
-                    dest_buf[i * dest_rowstride + j].val[0] = sum[0] > (255 * kernel_width) ? 255 : sum[0] / kernel_width;
-                    dest_buf[i * dest_rowstride + j].val[1] = sum[1] > (255 * kernel_width) ? 255 : sum[1] / kernel_width;
-                    dest_buf[i * dest_rowstride + j].val[2] = sum[2] > (255 * kernel_width) ? 255 : sum[2] / kernel_width;
-                    dest_buf[i * dest_rowstride + j].val[3] = sum[3] > (255 * kernel_width) ? 255 : sum[3] / kernel_width;
-                }
+    for (; j < count; ++j) {
+        lanes[4 * j + 0] = outside.val[0];
+        lanes[4 * j + 1] = outside.val[1];
+        lanes[4 * j + 2] = outside.val[2];
+        lanes[4 * j + 3] = outside.val[3];
+    }
+}
+
+// Replaces the first count - length + 1 elements of values (each of laneCount lanes) with the sum of length consecutive elements
+static void _vImageRunningSum(int32_t* values, size_t count, uint32_t length, size_t laneCount) {
+    const size_t outputs = count - length + 1;
+
+#if (VIMAGE_SSE == 1)
+    if ((c_vImageUseSse2 == true) && (laneCount == 4)) {
+        __m128i vSum = _mm_setzero_si128();
+        for (uint32_t k = 0; k < length; ++k) {
+            vSum = _mm_add_epi32(vSum, _mm_loadu_si128(reinterpret_cast<const __m128i*>(&values[4 * k])));
+        }
+
+        for (size_t i = 0; i < outputs; ++i) {
+            const __m128i vLeaving = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&values[4 * i]));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(&values[4 * i]), vSum);
+            if (i + 1 < outputs) {
+                const __m128i vEntering = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&values[4 * (i + length)]));
+                vSum = _mm_add_epi32(vSum, _mm_sub_epi32(vEntering, vLeaving));
             }
         }
 
-        //  first pass above("top") the RoI
-        for (int i = start_i - KH_d2; i < 0; ++i) {
-            src_i = srcOffsetToROI_Y + i;
-            src_j = srcOffsetToROI_X;
-            sum_flag = 0;
-            sum[0] = 0;
-            sum[1] = 0;
-            sum[2] = 0;
-            sum[3] = 0;
-
-            for (uint32_t j = 0; j < dest->width; ++j, src_j++) {
-                //  Copying the pixel data as is from source for no kernel overlap section
-                if (j < start_j || j > end_j) {
-                    temp_buf[(top + i) * dest_rowstride] = src_buf[src_i * src_rowstride + src_j];
-                } else {
-                    if (sum_flag == 0) {
-                        sum_flag = 1;
-                        for (int k = -KW_d2; k <= KW_d2; ++k) {
-                            sum[0] += src_buf[src_i * src_rowstride + src_j + k].val[0];
-                            sum[1] += src_buf[src_i * src_rowstride + src_j + k].val[1];
-                            sum[2] += src_buf[src_i * src_rowstride + src_j + k].val[2];
-                            sum[3] += src_buf[src_i * src_rowstride + src_j + k].val[3];
-                        }
-                    } else {
-                        sum[0] = sum[0] - src_buf[src_i * src_rowstride + src_j - KW_d2 - 1].val[0] +
-                                 src_buf[src_i * src_rowstride + src_j + KW_d2].val[0];
-                        sum[1] = sum[1] - src_buf[src_i * src_rowstride + src_j - KW_d2 - 1].val[1] +
-                                 src_buf[src_i * src_rowstride + src_j + KW_d2].val[1];
-                        sum[2] = sum[2] - src_buf[src_i * src_rowstride + src_j - KW_d2 - 1].val[2] +
-                                 src_buf[src_i * src_rowstride + src_j + KW_d2].val[2];
-                        sum[3] = sum[3] - src_buf[src_i * src_rowstride + src_j - KW_d2 - 1].val[3] +
-                                 src_buf[src_i * src_rowstride + src_j + KW_d2].val[3];
-                    }
+        return;
+    }
+#endif
 
-                    temp_buf[(top + i) * dest_rowstride + j].val[0] = sum[0] > (255 * kernel_width) ? 255 : sum[0] / kernel_width;
-                    temp_buf[(top + i) * dest_rowstride + j].val[1] = sum[1] > (255 * kernel_width) ? 255 : sum[1] / kernel_width;
-                    temp_buf[(top + i) * dest_rowstride + j].val[2] = sum[2] > (255 * kernel_width) ? 255 : sum[2] / kernel_width;
-                    temp_buf[(top + i) * dest_rowstride + j].val[3] = sum[3] > (255 * kernel_width) ? 255 : sum[3] / kernel_width;
-                }
+    for (size_t lane = 0; lane < laneCount; ++lane) {
+        int32_t sum = 0;
+        for (uint32_t k = 0; k < length; ++k) {
+            sum += values[k * laneCount + lane];
+        }
+
+        for (size_t i = 0; i < outputs; ++i) {
+            const int32_t leaving = values[i * laneCount + lane];
+            values[i * laneCount + lane] = sum;
+            if (i + 1 < outputs) {
+                sum += values[(i + length) * laneCount + lane] - leaving;
             }
         }
+    }
+}
 
-        //  first pass below the RoI
-        for (uint32_t i = dest->height; i <= end_i + KH_d2; ++i) {
-            src_i = srcOffsetToROI_Y + i;
-            src_j = srcOffsetToROI_X;
-            sum_flag = 0;
-            sum[0] = 0;
-            sum[1] = 0;
-            sum[2] = 0;
-            sum[3] = 0;
-
-            for (uint32_t j = 0; j < dest->width; ++j, src_j++) {
-                //  Copying the pixel data as is from source for no kernel overlap section
-                if (j < start_j || j > end_j) {
-                    temp_buf[(top + (i - dest->height)) * dest_rowstride + j] = src_buf[src_i * src_rowstride + src_j];
-                } else {
-                    if (sum_flag == 0) {
-                        sum_flag = 1;
-                        for (int k = -KW_d2; k <= KW_d2; ++k) {
-                            sum[0] += src_buf[src_i * src_rowstride + src_j + k].val[0];
-                            sum[1] += src_buf[src_i * src_rowstride + src_j + k].val[1];
-                            sum[2] += src_buf[src_i * src_rowstride + src_j + k].val[2];
-                            sum[3] += src_buf[src_i * src_rowstride + src_j + k].val[3];
-                        }
-                    } else {
-                        sum[0] = sum[0] - src_buf[src_i * src_rowstride + src_j - KW_d2 - 1].val[0] +
-                                 src_buf[src_i * src_rowstride + src_j + KW_d2].val[0];
-                        sum[1] = sum[1] - src_buf[src_i * src_rowstride + src_j - KW_d2 - 1].val[1] +
-                                 src_buf[src_i * src_rowstride + src_j + KW_d2].val[1];
-                        sum[2] = sum[2] - src_buf[src_i * src_rowstride + src_j - KW_d2 - 1].val[2] +
-                                 src_buf[src_i * src_rowstride + src_j + KW_d2].val[2];
-                        sum[3] = sum[3] - src_buf[src_i * src_rowstride + src_j - KW_d2 - 1].val[3] +
-                                 src_buf[src_i * src_rowstride + src_j + KW_d2].val[3];
-                    }
+static void _vImageApplyBoxCascade(const _vImageBoxCascade& cascade, int32_t* values, size_t count, size_t laneCount) {
+    for (uint32_t stage = 0; stage < cascade.stageCount; ++stage) {
+        _vImageRunningSum(values, count, cascade.stageLengths[stage], laneCount);
+        count -= cascade.stageLengths[stage] - 1;
+    }
+}
 
-                    temp_buf[(top + (i - dest->height)) * dest_rowstride + j].val[0] =
-                        sum[0] > (255 * kernel_width) ? 255 : sum[0] / kernel_width;
-                    temp_buf[(top + (i - dest->height)) * dest_rowstride + j].val[1] =
-                        sum[1] > (255 * kernel_width) ? 255 : sum[1] / kernel_width;
-                    temp_buf[(top + (i - dest->height)) * dest_rowstride + j].val[2] =
-                        sum[2] > (255 * kernel_width) ? 255 : sum[2] / kernel_width;
-                    temp_buf[(top + (i - dest->height)) * dest_rowstride + j].val[3] =
-                        sum[3] > (255 * kernel_width) ? 255 : sum[3] / kernel_width;
-                }
+// One vertical box stage: a ring of the last `length` input rows and their running sum
+struct _vImageVerticalBoxStage {
+    int32_t* ring;
+    int32_t* sum;
+    uint32_t length;
+    uint32_t pushed;
+};
+
+// Adds row to the stage's window, dropping the oldest row once the window is full. Returns the window sum when it covers `length` rows.
+static const int32_t* _vImagePushVerticalBoxRow(_vImageVerticalBoxStage& stage, const int32_t* row, size_t laneCount) {
+    int32_t* slot = stage.ring + (stage.pushed % stage.length) * laneCount;
+    const bool full = stage.pushed >= stage.length;
+    size_t i = 0;
+
+#if (VIMAGE_SSE == 1)
+    if (c_vImageUseSse2 == true) {
+        for (; i + 4 <= laneCount; i += 4) {
+            const __m128i vRow = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&row[i]));
+            __m128i vSum = _mm_add_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(&stage.sum[i])), vRow);
+            if (full) {
+                vSum = _mm_sub_epi32(vSum, _mm_loadu_si128(reinterpret_cast<const __m128i*>(&slot[i])));
             }
+
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(&stage.sum[i]), vSum);
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(&slot[i]), vRow);
         }
+    }
+#endif
 
-        //  Second pass (vertical)
-        for (uint32_t j = start_j; j <= end_j; ++j) {
-            sum_flag = 0;
-            sum[0] = 0;
-            sum[1] = 0;
-            sum[2] = 0;
-            sum[3] = 0;
-
-            for (int i = start_i; i <= static_cast<int>(end_i); ++i) {
-                if (sum_flag == 0) {
-                    sum_flag = 1;
-                    for (int k = -KH_d2; k <= KH_d2; ++k) {
-                        if (i + k < 0) {
-                            sum[0] += temp_buf[(top + (i + k)) * dest_rowstride + j].val[0];
-                            sum[1] += temp_buf[(top + (i + k)) * dest_rowstride + j].val[1];
-                            sum[2] += temp_buf[(top + (i + k)) * dest_rowstride + j].val[2];
-                            sum[3] += temp_buf[(top + (i + k)) * dest_rowstride + j].val[3];
-                        } else {
-                            sum[0] += dest_buf[(i + k) * dest_rowstride + j].val[0];
-                            sum[1] += dest_buf[(i + k) * dest_rowstride + j].val[1];
-                            sum[2] += dest_buf[(i + k) * dest_rowstride + j].val[2];
-                            sum[3] += dest_buf[(i + k) * dest_rowstride + j].val[3];
-                        }
-                    }
-                } else {
-                    if (i - KH_d2 - 1 < 0) {
-                        sum[0] -= temp_buf[(top + (i - KH_d2 - 1)) * dest_rowstride + j].val[0];
-                        sum[1] -= temp_buf[(top + (i - KH_d2 - 1)) * dest_rowstride + j].val[1];
-                        sum[2] -= temp_buf[(top + (i - KH_d2 - 1)) * dest_rowstride + j].val[2];
-                        sum[3] -= temp_buf[(top + (i - KH_d2 - 1)) * dest_rowstride + j].val[3];
-                    } else {
-                        sum[0] -= dest_buf[(i - KH_d2 - 1) * dest_rowstride + j].val[0];
-                        sum[1] -= dest_buf[(i - KH_d2 - 1) * dest_rowstride + j].val[1];
-                        sum[2] -= dest_buf[(i - KH_d2 - 1) * dest_rowstride + j].val[2];
-                        sum[3] -= dest_buf[(i - KH_d2 - 1) * dest_rowstride + j].val[3];
-                    }
+    for (; i < laneCount; ++i) {
+        stage.sum[i] += row[i] - (full ? slot[i] : 0);
+        slot[i] = row[i];
+    }
 
-                    if (i + KH_d2 >= static_cast<int>(dest->height)) {
-                        sum[0] += temp_buf[(top + (i + KH_d2) - dest->height) * dest_rowstride + j].val[0];
-                        sum[1] += temp_buf[(top + (i + KH_d2) - dest->height) * dest_rowstride + j].val[1];
-                        sum[2] += temp_buf[(top + (i + KH_d2) - dest->height) * dest_rowstride + j].val[2];
-                        sum[3] += temp_buf[(top + (i + KH_d2) - dest->height) * dest_rowstride + j].val[3];
-                    } else {
-                        sum[0] += dest_buf[(i + KH_d2) * dest_rowstride + j].val[0];
-                        sum[1] += dest_buf[(i + KH_d2) * dest_rowstride + j].val[1];
-                        sum[2] += dest_buf[(i + KH_d2) * dest_rowstride + j].val[2];
-                        sum[3] += dest_buf[(i + KH_d2) * dest_rowstride + j].val[3];
-                    }
-                }
+    ++stage.pushed;
+    return (stage.pushed >= stage.length) ? stage.sum : nullptr;
+}
 
-                temp_buf[(top + below) * dest_rowstride + i - start_i].val[0] =
-                    sum[0] > (255 * kernel_height) ? 255 : sum[0] / kernel_height;
-                temp_buf[(top + below) * dest_rowstride + i - start_i].val[1] =
-                    sum[1] > (255 * kernel_height) ? 255 : sum[1] / kernel_height;
-                temp_buf[(top + below) * dest_rowstride + i - start_i].val[2] =
-                    sum[2] > (255 * kernel_height) ? 255 : sum[2] / kernel_height;
-                temp_buf[(top + below) * dest_rowstride + i - start_i].val[3] =
-                    sum[3] > (255 * kernel_height) ? 255 : sum[3] / kernel_height;
-            }
+// Scales, rounds and saturates a row of 32-bit lanes into destination pixels; scales holds one factor per pixel
+static void _vImageStoreConvolveRow(const int32_t* lanes, const float* scales, Pixel_8888_s* destPixels, size_t width) {
+    size_t j = 0;
 
-            for (uint32_t i = start_i; i <= end_i; ++i) {
-                dest_buf[i * dest_rowstride + j] = temp_buf[(top + below) * dest_rowstride + i - start_i];
+#if (VIMAGE_SSE == 1)
+    if (c_vImageUseSse2 == true) {
+        const __m128 vHalf = _mm_set1_ps(0.5f);
+        for (; j + 4 <= width; j += 4) {
+            __m128i vRounded[4];
+            for (size_t k = 0; k < 4; ++k) {
+                const __m128 vValue = _mm_cvtepi32_ps(_mm_loadu_si128(reinterpret_cast<const __m128i*>(&lanes[4 * (j + k)])));
+                vRounded[k] = _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(vValue, _mm_set1_ps(scales[j + k])), vHalf));
             }
+
+            const __m128i vPacked =
+                _mm_packus_epi16(_mm_packs_epi32(vRounded[0], vRounded[1]), _mm_packs_epi32(vRounded[2], vRounded[3]));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(&destPixels[j]), vPacked);
         }
+    }
+#endif
 
-        for (uint32_t i = 0; i < start_i; ++i) {
-            src_i = srcOffsetToROI_Y + i;
-            src_j = srcOffsetToROI_X + start_j;
-            for (uint32_t j = start_j; j <= end_j; ++j, src_j++) {
-                dest_buf[i * dest_rowstride + j] = src_buf[src_i * src_rowstride + src_j];
-            }
+    for (; j < width; ++j) {
+        for (size_t k = 0; k < 4; ++k) {
+            const float value = static_cast<float>(lanes[4 * j + k]) * scales[j] + 0.5f;
+            destPixels[j].val[k] = (value <= 0.0f) ? 0 : (value >= 255.0f) ? 255 : static_cast<uint8_t>(value);
         }
+    }
+}
 
-        for (uint32_t i = end_i + 1; i < dest->height; ++i) {
-            src_i = srcOffsetToROI_Y + i;
-            src_j = srcOffsetToROI_X + start_j;
-            for (uint32_t j = start_j; j <= end_j; ++j, src_j++) {
-                dest_buf[i * dest_rowstride + j] = src_buf[src_i * src_rowstride + src_j];
-            }
+// For kvImageCopyInPlace, destination pixels whose kernel does not fit inside the source are copied from the source unchanged
+static void _vImageCopyUncoveredPixels(const _vImageConvolveJob& job, size_t destRow, Pixel_8888_s* destPixels) {
+    const ptrdiff_t srcRow = job.srcOffsetToROI_Y + static_cast<ptrdiff_t>(destRow);
+    const ptrdiff_t halfHeight = job.kernelHeight / 2;
+    const ptrdiff_t halfWidth = job.kernelWidth / 2;
+    const Pixel_8888_s* srcPixels =
+        reinterpret_cast<const Pixel_8888_s*>(static_cast<const uint8_t*>(job.src->data) + srcRow * job.src->rowBytes) +
+        job.srcOffsetToROI_X;
+    const ptrdiff_t width = static_cast<ptrdiff_t>(job.dest->width);
+
+    if ((srcRow < halfHeight) || (srcRow + halfHeight >= static_cast<ptrdiff_t>(job.src->height))) {
+        memcpy(destPixels, srcPixels, width * sizeof(Pixel_8888_s));
+        return;
+    }
+
+    const ptrdiff_t coveredBegin = std::min(width, std::max<ptrdiff_t>(0, halfWidth - job.srcOffsetToROI_X));
+    const ptrdiff_t coveredEnd =
+        std::max(coveredBegin, std::min(width, static_cast<ptrdiff_t>(job.src->width) - halfWidth - job.srcOffsetToROI_X));
+
+    for (ptrdiff_t j = 0; j < coveredBegin; ++j) {
+        destPixels[j] = srcPixels[j];
+    }
+
+    for (ptrdiff_t j = coveredEnd; j < width; ++j) {
+        destPixels[j] = srcPixels[j];
+    }
+}
+
+// Per-element weight of a box cascade over an axis when samples outside [0, extent) are dropped, as kvImageTruncateKernel requires.
+// Writes outputs elements starting at the output whose window begins at `first`.
+static void _vImageTruncatedCascadeWeights(
+    const _vImageBoxCascade& cascade, ptrdiff_t first, size_t outputs, uint32_t kernelLength, ptrdiff_t extent, int32_t* weights) {
+    const size_t count = outputs + kernelLength - 1;
+    for (size_t i = 0; i < count; ++i) {
+        const ptrdiff_t position = first + static_cast<ptrdiff_t>(i);
+        weights[i] = (position >= 0 && position < extent) ? 1 : 0;
+    }
+
+    _vImageApplyBoxCascade(cascade, weights, count, 1);
+}
+
+// Separable running-sum convolution shared by the box and tent filters. Each band gathers its source rows, filters them horizontally
+// in place with the cascade, then feeds them through one ring-buffered vertical stage per cascade stage.
+static vImage_Error _vImageBoxCascadeConvolve_ARGB8888(const _vImageConvolveJob& job,
+                                                      const _vImageBoxCascade& horizontal,
+                                                      const _vImageBoxCascade& vertical,
+                                                      void* tempBuffer,
+                                                      vImage_Flags flags) {
+    if ((255 * std::max(horizontal.weight(), vertical.weight())) > 0x7fffffffull) {
+        return kvImageInvalidKernelSize;
+    }
+
+    const size_t width = job.dest->width;
+    const size_t bandCount = _vImageConvolveBandCount(job, flags);
+    const size_t bandRows = _vImageRowBandHeight(job.dest->height, bandCount);
+    const size_t feedRows = bandRows + job.kernelHeight - 1;
+    const size_t destLanes = job.destRowLanes();
+
+    //  Shared: column weights and scales. Per band: the padded row, the vertical rings and sums, row weights and per-pixel scales.
+    size_t stageRows = 0;
+    for (uint32_t stage = 0; stage < vertical.stageCount; ++stage) {
+        stageRows += vertical.stageLengths[stage] + 1;
+    }
+
+    const size_t sharedBytes = _vImageAlignScratch((width + job.kernelWidth - 1) * sizeof(int32_t)) + _vImageAlignScratch(width * sizeof(float));
+    const size_t bandBytes = _vImageAlignScratch(job.paddedRowLanes() * sizeof(int32_t)) +
+                             _vImageAlignScratch(stageRows * destLanes * sizeof(int32_t)) +
+                             _vImageAlignScratch(feedRows * sizeof(int32_t)) + _vImageAlignScratch(width * sizeof(float));
+    const size_t tempBytes = sharedBytes + bandCount * bandBytes + 16;
+
+    if (flags & kvImageGetTempBufferSize) {
+        return static_cast<vImage_Error>(tempBytes);
+    }
+
+    std::unique_ptr<uint8_t[]> ownedTemp;
+    uint8_t* temp = static_cast<uint8_t*>(tempBuffer);
+    if (temp == nullptr) {
+        ownedTemp.reset(new (std::nothrow) uint8_t[tempBytes]);
+        if (!ownedTemp) {
+            return kvImageMemoryAllocationError;
         }
+
+        temp = ownedTemp.get();
     }
 
-    //  This block deals with code for flag kvImageTruncateKernel, which require the kernel to be truncated
-    //  when it does not overlap with the image data
-    else if (flags & kvImageTruncateKernel) {
-        uint32_t divisor;
-
-        //  First pass (horizontal)
-        for (int i = static_cast<int>(start_i) - KH_d2; i <= static_cast<int>(end_i) + KH_d2; ++i) {
-            src_i = srcOffsetToROI_Y + i;
-            src_j = srcOffsetToROI_X;
-            sum[0] = 0;
-            sum[1] = 0;
-            sum[2] = 0;
-            sum[3] = 0;
-            divisor = kernel_width - start_j;
-
-            for (int k = start_j - KW_d2; k <= KW_d2; ++k) {
-                sum[0] += src_buf[src_i * src_rowstride + src_j + k].val[0];
-                sum[1] += src_buf[src_i * src_rowstride + src_j + k].val[1];
-                sum[2] += src_buf[src_i * src_rowstride + src_j + k].val[2];
-                sum[3] += src_buf[src_i * src_rowstride + src_j + k].val[3];
-            }
+    temp += (16 - (reinterpret_cast<uintptr_t>(temp) & 15)) & 15;
 
-            if (i < 0) {
-                temp_buf[(top + i) * dest_rowstride].val[0] = sum[0] > (255 * divisor) ? 255 : sum[0] / divisor;
-                temp_buf[(top + i) * dest_rowstride].val[1] = sum[1] > (255 * divisor) ? 255 : sum[1] / divisor;
-                temp_buf[(top + i) * dest_rowstride].val[2] = sum[2] > (255 * divisor) ? 255 : sum[2] / divisor;
-                temp_buf[(top + i) * dest_rowstride].val[3] = sum[3] > (255 * divisor) ? 255 : sum[3] / divisor;
-            } else if (i >= static_cast<int>(dest->height)) {
-                temp_buf[(top + (i - dest->height)) * dest_rowstride].val[0] = sum[0] > (255 * divisor) ? 255 : sum[0] / divisor;
-                temp_buf[(top + (i - dest->height)) * dest_rowstride].val[1] = sum[1] > (255 * divisor) ? 255 : sum[1] / divisor;
-                temp_buf[(top + (i - dest->height)) * dest_rowstride].val[2] = sum[2] > (255 * divisor) ? 255 : sum[2] / divisor;
-                temp_buf[(top + (i - dest->height)) * dest_rowstride].val[3] = sum[3] > (255 * divisor) ? 255 : sum[3] / divisor;
-            } else {
-                dest_buf[i * dest_rowstride].val[0] = sum[0] > (255 * divisor) ? 255 : sum[0] / divisor;
-                dest_buf[i * dest_rowstride].val[1] = sum[1] > (255 * divisor) ? 255 : sum[1] / divisor;
-                dest_buf[i * dest_rowstride].val[2] = sum[2] > (255 * divisor) ? 255 : sum[2] / divisor;
-                dest_buf[i * dest_rowstride].val[3] = sum[3] > (255 * divisor) ? 255 : sum[3] / divisor;
-            }
+    //  Horizontal normalization: the full cascade weight, or per column for truncated kernels
+    int32_t* columnWeights = reinterpret_cast<int32_t*>(temp);
+    float* columnScales = reinterpret_cast<float*>(temp + _vImageAlignScratch((width + job.kernelWidth - 1) * sizeof(int32_t)));
+    const bool truncate = (job.edgeMode == _vImageConvolveEdgeTruncateKernel);
 
-            src_j++;
-
-            for (uint32_t j = 1; j < dest->width; ++j, src_j++) {
-                if (j <= start_j) {
-                    divisor++;
-                    sum[0] += src_buf[src_i * src_rowstride + src_j + KW_d2].val[0];
-                    sum[1] += src_buf[src_i * src_rowstride + src_j + KW_d2].val[1];
-                    sum[2] += src_buf[src_i * src_rowstride + src_j + KW_d2].val[2];
-                    sum[3] += src_buf[src_i * src_rowstride + src_j + KW_d2].val[3];
-                } else if (j <= end_j) {
-                    sum[0] +=
-                        src_buf[src_i * src_rowstride + src_j + KW_d2].val[0] - src_buf[src_i * src_rowstride + src_j - KW_d2 - 1].val[0];
-                    sum[1] +=
-                        src_buf[src_i * src_rowstride + src_j + KW_d2].val[1] - src_buf[src_i * src_rowstride + src_j - KW_d2 - 1].val[1];
-                    sum[2] +=
-                        src_buf[src_i * src_rowstride + src_j + KW_d2].val[2] - src_buf[src_i * src_rowstride + src_j - KW_d2 - 1].val[2];
-                    sum[3] +=
-                        src_buf[src_i * src_rowstride + src_j + KW_d2].val[3] - src_buf[src_i * src_rowstride + src_j - KW_d2 - 1].val[3];
-                } else {
-                    divisor--;
-                    sum[0] -= src_buf[src_i * src_rowstride + src_j - KW_d2 - 1].val[0];
-                    sum[1] -= src_buf[src_i * src_rowstride + src_j - KW_d2 - 1].val[1];
-                    sum[2] -= src_buf[src_i * src_rowstride + src_j - KW_d2 - 1].val[2];
-                    sum[3] -= src_buf[src_i * src_rowstride + src_j - KW_d2 - 1].val[3];
-                }
+    if (truncate) {
+        _vImageTruncatedCascadeWeights(horizontal,
+                                       job.srcOffsetToROI_X - static_cast<ptrdiff_t>(job.kernelWidth / 2),
+                                       width,
+                                       job.kernelWidth,
+                                       static_cast<ptrdiff_t>(job.src->width),
+                                       columnWeights);
+    } else {
+        std::fill(columnWeights, columnWeights + width, static_cast<int32_t>(horizontal.weight()));
+    }
 
-                if (i < 0) {
-                    temp_buf[(top + i) * dest_rowstride + j].val[0] = sum[0] > (255 * divisor) ? 255 : sum[0] / divisor;
-                    temp_buf[(top + i) * dest_rowstride + j].val[1] = sum[1] > (255 * divisor) ? 255 : sum[1] / divisor;
-                    temp_buf[(top + i) * dest_rowstride + j].val[2] = sum[2] > (255 * divisor) ? 255 : sum[2] / divisor;
-                    temp_buf[(top + i) * dest_rowstride + j].val[3] = sum[3] > (255 * divisor) ? 255 : sum[3] / divisor;
-                } else if (i >= static_cast<int>(dest->height)) {
-                    temp_buf[(top + (i - dest->height)) * dest_rowstride + j].val[0] = sum[0] > (255 * divisor) ? 255 : sum[0] / divisor;
-                    temp_buf[(top + (i - dest->height)) * dest_rowstride + j].val[1] = sum[1] > (255 * divisor) ? 255 : sum[1] / divisor;
-                    temp_buf[(top + (i - dest->height)) * dest_rowstride + j].val[2] = sum[2] > (255 * divisor) ? 255 : sum[2] / divisor;
-                    temp_buf[(top + (i - dest->height)) * dest_rowstride + j].val[3] = sum[3] > (255 * divisor) ? 255 : sum[3] / divisor;
-                } else {
-                    dest_buf[i * dest_rowstride + j].val[0] = sum[0] > (255 * divisor) ? 255 : sum[0] / divisor;
-                    dest_buf[i * dest_rowstride + j].val[1] = sum[1] > (255 * divisor) ? 255 : sum[1] / divisor;
-                    dest_buf[i * dest_rowstride + j].val[2] = sum[2] > (255 * divisor) ? 255 : sum[2] / divisor;
-                    dest_buf[i * dest_rowstride + j].val[3] = sum[3] > (255 * divisor) ? 255 : sum[3] / divisor;
+    //  The exact sums fit in 32 bits for all but very large kernels; past that each row is normalized horizontally before
+    //  the vertical pass, at the cost of one extra rounding.
+    const bool normalizeRows = (255ull * horizontal.weight() * vertical.weight()) > 0x7fffffffull;
+    for (size_t j = 0; j < width; ++j) {
+        columnScales[j] = 1.0f / static_cast<float>(columnWeights[j]);
+    }
+
+    _vImageForEachRowBand(job.dest->height, bandCount, [&](size_t band, size_t firstRow, size_t endRow) {
+        uint8_t* scratch = temp + sharedBytes + band * bandBytes;
+        int32_t* paddedRow = reinterpret_cast<int32_t*>(scratch);
+        scratch += _vImageAlignScratch(job.paddedRowLanes() * sizeof(int32_t));
+        int32_t* stageMemory = reinterpret_cast<int32_t*>(scratch);
+        scratch += _vImageAlignScratch(stageRows * destLanes * sizeof(int32_t));
+        int32_t* rowWeights = reinterpret_cast<int32_t*>(scratch);
+        scratch += _vImageAlignScratch(feedRows * sizeof(int32_t));
+        float* pixelScales = reinterpret_cast<float*>(scratch);
+
+        _vImageVerticalBoxStage stages[2];
+        for (uint32_t stage = 0; stage < vertical.stageCount; ++stage) {
+            stages[stage].length = vertical.stageLengths[stage];
+            stages[stage].pushed = 0;
+            stages[stage].sum = stageMemory;
+            stages[stage].ring = stageMemory + destLanes;
+            std::fill(stages[stage].sum, stages[stage].sum + destLanes, 0);
+            stageMemory += (stages[stage].length + 1) * destLanes;
+        }
+
+        const ptrdiff_t firstSrcRow =
+            job.srcOffsetToROI_Y + static_cast<ptrdiff_t>(firstRow) - static_cast<ptrdiff_t>(job.kernelHeight / 2);
+        const size_t rows = endRow - firstRow;
+
+        if (truncate) {
+            _vImageTruncatedCascadeWeights(
+                vertical, firstSrcRow, rows, job.kernelHeight, static_cast<ptrdiff_t>(job.src->height), rowWeights);
+        } else {
+            std::fill(rowWeights, rowWeights + rows, static_cast<int32_t>(vertical.weight()));
+        }
+
+        for (size_t feed = 0; feed < rows + job.kernelHeight - 1; ++feed) {
+            _vImageGatherConvolveRow(job, firstSrcRow + static_cast<ptrdiff_t>(feed), paddedRow);
+            _vImageApplyBoxCascade(horizontal, paddedRow, width + job.kernelWidth - 1, 4);
+
+            if (normalizeRows) {
+                for (size_t j = 0; j < width; ++j) {
+                    for (size_t k = 0; k < 4; ++k) {
+                        paddedRow[4 * j + k] = static_cast<int32_t>(static_cast<float>(paddedRow[4 * j + k]) * columnScales[j] + 0.5f);
+                    }
                 }
             }
-        }
 
-        //  Second pass (vertical)
-        for (uint32_t j = 0; j < dest->width; ++j) {
-            sum[0] = 0;
-            sum[1] = 0;
-            sum[2] = 0;
-            sum[3] = 0;
-            divisor = kernel_height - start_i;
-
-            for (int k = start_i - KH_d2; k < 0; ++k) {
-                sum[0] += temp_buf[(top + k) * dest_rowstride + j].val[0];
-                sum[1] += temp_buf[(top + k) * dest_rowstride + j].val[1];
-                sum[2] += temp_buf[(top + k) * dest_rowstride + j].val[2];
-                sum[3] += temp_buf[(top + k) * dest_rowstride + j].val[3];
+            const int32_t* filtered = paddedRow;
+            for (uint32_t stage = 0; (stage < vertical.stageCount) && (filtered != nullptr); ++stage) {
+                filtered = _vImagePushVerticalBoxRow(stages[stage], filtered, destLanes);
             }
 
-            for (int k = 0; k <= KH_d2; ++k) {
-                sum[0] += dest_buf[k * dest_rowstride + j].val[0];
-                sum[1] += dest_buf[k * dest_rowstride + j].val[1];
-                sum[2] += dest_buf[k * dest_rowstride + j].val[2];
-                sum[3] += dest_buf[k * dest_rowstride + j].val[3];
+            if (filtered == nullptr) {
+                continue;
             }
 
-            temp_buf[(top + below) * dest_rowstride].val[0] = sum[0] > (255 * divisor) ? 255 : sum[0] / divisor;
-            temp_buf[(top + below) * dest_rowstride].val[1] = sum[1] > (255 * divisor) ? 255 : sum[1] / divisor;
-            temp_buf[(top + below) * dest_rowstride].val[2] = sum[2] > (255 * divisor) ? 255 : sum[2] / divisor;
-            temp_buf[(top + below) * dest_rowstride].val[3] = sum[3] > (255 * divisor) ? 255 : sum[3] / divisor;
-
-            for (int i = 1; i < static_cast<int>(dest->height); ++i) {
-                if (i > static_cast<int>(start_i)) {
-                    divisor--;
-                    if (i - KH_d2 - 1 < 0) {
-                        sum[0] -= temp_buf[(top + (i - KH_d2 - 1)) * dest_rowstride + j].val[0];
-                        sum[1] -= temp_buf[(top + (i - KH_d2 - 1)) * dest_rowstride + j].val[1];
-                        sum[2] -= temp_buf[(top + (i - KH_d2 - 1)) * dest_rowstride + j].val[2];
-                        sum[3] -= temp_buf[(top + (i - KH_d2 - 1)) * dest_rowstride + j].val[3];
-                    } else {
-                        sum[0] -= dest_buf[(i - KH_d2 - 1) * dest_rowstride + j].val[0];
-                        sum[1] -= dest_buf[(i - KH_d2 - 1) * dest_rowstride + j].val[1];
-                        sum[2] -= dest_buf[(i - KH_d2 - 1) * dest_rowstride + j].val[2];
-                        sum[3] -= dest_buf[(i - KH_d2 - 1) * dest_rowstride + j].val[3];
+            const size_t row = feed - (job.kernelHeight - 1);
+            const float rowScale = 1.0f / static_cast<float>(rowWeights[row]);
+            for (size_t j = 0; j < width; ++j) {
+                pixelScales[j] = normalizeRows ? rowScale : columnScales[j] * rowScale;
+            }
+
+            Pixel_8888_s* destPixels =
+                reinterpret_cast<Pixel_8888_s*>(static_cast<uint8_t*>(job.dest->data) + (firstRow + row) * job.dest->rowBytes);
+            _vImageStoreConvolveRow(filtered, pixelScales, destPixels, width);
+
+            if (job.edgeMode == _vImageConvolveEdgeCopyInPlace) {
+                _vImageCopyUncoveredPixels(job, firstRow + row, destPixels);
+            }
+        }
+    });
+
+    return kvImageNoError;
+}
+
+// Direct 2D convolution for arbitrary integer kernels. Shares the row gathering, edge handling and banding of the running-sum engine,
+// but costs kernel_height * kernel_width multiply-adds per pixel.
+static vImage_Error _vImageKernelConvolve_ARGB8888(
+    const _vImageConvolveJob& job, const int16_t* kernel, int32_t divisor, void* tempBuffer, vImage_Flags flags) {
+    const size_t width = job.dest->width;
+    const size_t kernelHeight = job.kernelHeight;
+    const size_t kernelWidth = job.kernelWidth;
+    const size_t bandCount = _vImageConvolveBandCount(job, flags);
+    const size_t paddedLanes = job.paddedRowLanes();
+    const size_t destLanes = job.destRowLanes();
+    const bool truncate = (job.edgeMode == _vImageConvolveEdgeTruncateKernel);
+
+    //  Shared: the kernel's 2D prefix sums for truncated kernels. Per band: the ring of gathered rows, the accumulator and the scales.
+    const size_t sharedBytes = _vImageAlignScratch((kernelHeight + 1) * (kernelWidth + 1) * sizeof(int64_t));
+    const size_t bandBytes = _vImageAlignScratch(kernelHeight * paddedLanes * sizeof(int32_t)) +
+                             _vImageAlignScratch(destLanes * sizeof(int32_t)) + _vImageAlignScratch(width * sizeof(float));
+    const size_t tempBytes = sharedBytes + bandCount * bandBytes + 16;
+
+    if (flags & kvImageGetTempBufferSize) {
+        return static_cast<vImage_Error>(tempBytes);
+    }
+
+    std::unique_ptr<uint8_t[]> ownedTemp;
+    uint8_t* temp = static_cast<uint8_t*>(tempBuffer);
+    if (temp == nullptr) {
+        ownedTemp.reset(new (std::nothrow) uint8_t[tempBytes]);
+        if (!ownedTemp) {
+            return kvImageMemoryAllocationError;
+        }
+
+        temp = ownedTemp.get();
+    }
+
+    temp += (16 - (reinterpret_cast<uintptr_t>(temp) & 15)) & 15;
+
+    if (divisor == 0) {
+        divisor = 1;
+    }
+
+    int64_t* prefix = reinterpret_cast<int64_t*>(temp);
+    for (size_t j = 0; j <= kernelWidth; ++j) {
+        prefix[j] = 0;
+    }
+
+    for (size_t i = 0; i < kernelHeight; ++i) {
+        int64_t rowSum = 0;
+        prefix[(i + 1) * (kernelWidth + 1)] = 0;
+        for (size_t j = 0; j < kernelWidth; ++j) {
+            rowSum += kernel[i * kernelWidth + j];
+            prefix[(i + 1) * (kernelWidth + 1) + j + 1] = prefix[i * (kernelWidth + 1) + j + 1] + rowSum;
+        }
+    }
+
+    const int64_t kernelSum = prefix[kernelHeight * (kernelWidth + 1) + kernelWidth];
+    const ptrdiff_t halfHeight = kernelHeight / 2;
+    const ptrdiff_t halfWidth = kernelWidth / 2;
+
+    _vImageForEachRowBand(job.dest->height, bandCount, [&](size_t band, size_t firstRow, size_t endRow) {
+        uint8_t* scratch = temp + sharedBytes + band * bandBytes;
+        int32_t* ring = reinterpret_cast<int32_t*>(scratch);
+        scratch += _vImageAlignScratch(kernelHeight * paddedLanes * sizeof(int32_t));
+        int32_t* accumulator = reinterpret_cast<int32_t*>(scratch);
+        scratch += _vImageAlignScratch(destLanes * sizeof(int32_t));
+        float* pixelScales = reinterpret_cast<float*>(scratch);
+
+        const ptrdiff_t firstSrcRow = job.srcOffsetToROI_Y + static_cast<ptrdiff_t>(firstRow) - halfHeight;
+        const float fullScale = 1.0f / static_cast<float>(divisor);
+        std::fill(pixelScales, pixelScales + width, fullScale);
+
+        for (size_t k = 0; k + 1 < kernelHeight; ++k) {
+            _vImageGatherConvolveRow(job, firstSrcRow + static_cast<ptrdiff_t>(k), ring + k * paddedLanes);
+        }
+
+        for (size_t row = firstRow; row < endRow; ++row) {
+            //  Slot of the ring that holds source row (row - firstRow + k) is (row - firstRow + k) % kernelHeight
+            const size_t base = row - firstRow;
+            _vImageGatherConvolveRow(
+                job, firstSrcRow + static_cast<ptrdiff_t>(base + kernelHeight - 1), ring + ((base + kernelHeight - 1) % kernelHeight) * paddedLanes);
+            std::fill(accumulator, accumulator + destLanes, 0);
+
+            for (size_t k = 0; k < kernelHeight; ++k) {
+                const int32_t* lanes = ring + ((base + k) % kernelHeight) * paddedLanes;
+                for (size_t c = 0; c < kernelWidth; ++c) {
+                    const int32_t weight = kernel[k * kernelWidth + c];
+                    if (weight == 0) {
+                        continue;
                     }
-                }
 
-                if (i <= static_cast<int>(end_i)) {
-                    divisor++;
-                    if (i + KH_d2 >= static_cast<int>(dest->height)) {
-                        sum[0] += temp_buf[(top + (i + KH_d2) - dest->height) * dest_rowstride + j].val[0];
-                        sum[1] += temp_buf[(top + (i + KH_d2) - dest->height) * dest_rowstride + j].val[1];
-                        sum[2] += temp_buf[(top + (i + KH_d2) - dest->height) * dest_rowstride + j].val[2];
-                        sum[3] += temp_buf[(top + (i + KH_d2) - dest->height) * dest_rowstride + j].val[3];
-                    } else {
-                        sum[0] += dest_buf[(i + KH_d2) * dest_rowstride + j].val[0];
-                        sum[1] += dest_buf[(i + KH_d2) * dest_rowstride + j].val[1];
-                        sum[2] += dest_buf[(i + KH_d2) * dest_rowstride + j].val[2];
-                        sum[3] += dest_buf[(i + KH_d2) * dest_rowstride + j].val[3];
+                    const int32_t* source = lanes + 4 * c;
+                    size_t i = 0;
+
+#if (VIMAGE_SSE == 1)
+                    if (c_vImageUseSse2 == true) {
+                        //  Source lanes are 0..255, so their high halves are zero and a 16-bit multiply-add yields the exact product
+                        const __m128i vWeight = _mm_set1_epi32(static_cast<uint16_t>(weight));
+                        for (; i + 4 <= destLanes; i += 4) {
+                            const __m128i vSource = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&source[i]));
+                            const __m128i vSum = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&accumulator[i]));
+                            _mm_storeu_si128(reinterpret_cast<__m128i*>(&accumulator[i]),
+                                             _mm_add_epi32(vSum, _mm_madd_epi16(vSource, vWeight)));
+                        }
+                    }
+#endif
+
+                    for (; i < destLanes; ++i) {
+                        accumulator[i] += weight * source[i];
                     }
                 }
+            }
 
-                temp_buf[(top + below) * dest_rowstride + i].val[0] = sum[0] > (255 * divisor) ? 255 : sum[0] / divisor;
-                temp_buf[(top + below) * dest_rowstride + i].val[1] = sum[1] > (255 * divisor) ? 255 : sum[1] / divisor;
-                temp_buf[(top + below) * dest_rowstride + i].val[2] = sum[2] > (255 * divisor) ? 255 : sum[2] / divisor;
-                temp_buf[(top + below) * dest_rowstride + i].val[3] = sum[3] > (255 * divisor) ? 255 : sum[3] / divisor;
+            if (truncate) {
+                //  Scale by the ratio of the full kernel sum to the sum of the part of the kernel that overlaps the image
+                const ptrdiff_t srcRow = job.srcOffsetToROI_Y + static_cast<ptrdiff_t>(row);
+                const size_t top = static_cast<size_t>(std::max<ptrdiff_t>(0, halfHeight - srcRow));
+                const size_t bottom = static_cast<size_t>(
+                    std::min<ptrdiff_t>(kernelHeight, static_cast<ptrdiff_t>(job.src->height) - srcRow + halfHeight));
+
+                for (size_t j = 0; j < width; ++j) {
+                    const ptrdiff_t srcColumn = job.srcOffsetToROI_X + static_cast<ptrdiff_t>(j);
+                    const size_t left = static_cast<size_t>(std::max<ptrdiff_t>(0, halfWidth - srcColumn));
+                    const size_t right = static_cast<size_t>(
+                        std::min<ptrdiff_t>(kernelWidth, static_cast<ptrdiff_t>(job.src->width) - srcColumn + halfWidth));
+                    const int64_t usedSum = prefix[bottom * (kernelWidth + 1) + right] - prefix[top * (kernelWidth + 1) + right] -
+                                            prefix[bottom * (kernelWidth + 1) + left] + prefix[top * (kernelWidth + 1) + left];
+
+                    pixelScales[j] = (usedSum == 0 || kernelSum == 0) ?
+                                         fullScale :
+                                         static_cast<float>(static_cast<double>(kernelSum) / (static_cast<double>(usedSum) * divisor));
+                }
             }
 
-            for (uint32_t i = 0; i < dest->height; ++i) {
-                dest_buf[i * dest_rowstride + j] = temp_buf[(top + below) * dest_rowstride + i];
+            Pixel_8888_s* destPixels = reinterpret_cast<Pixel_8888_s*>(static_cast<uint8_t*>(job.dest->data) + row * job.dest->rowBytes);
+            _vImageStoreConvolveRow(accumulator, pixelScales, destPixels, width);
+
+            if (job.edgeMode == _vImageConvolveEdgeCopyInPlace) {
+                _vImageCopyUncoveredPixels(job, row, destPixels);
             }
         }
+    });
+
+    return kvImageNoError;
+}
+
+/**
+@Status Interoperable
+@Notes Uses a separable running-sum filter, so the cost per pixel does not depend on the kernel size
+*/
+vImage_Error vImageBoxConvolve_ARGB8888(const vImage_Buffer* src,
+                                        const vImage_Buffer* dest,
+                                        void* tempBuffer,
+                                        vImagePixelCount srcOffsetToROI_X,
+                                        vImagePixelCount srcOffsetToROI_Y,
+                                        uint32_t kernel_height,
+                                        uint32_t kernel_width,
+                                        const Pixel_8888 backgroundColor,
+                                        vImage_Flags flags) {
+    const vImage_Error result =
+        _vImageValidateConvolve(src, dest, srcOffsetToROI_X, srcOffsetToROI_Y, kernel_height, kernel_width, backgroundColor, flags);
+    if (result != kvImageNoError) {
+        return result;
     }
 
-    //  This block deals with code for flag kvImageBackgroundColorFill, which requires all pixels outside image to be
-    //  set to the parameter backgroundColor
-    else if (flags & kvImageBackgroundColorFill) {
-        if (backgroundColor == nullptr) {
-            return kvImageNullPointerArgument;
-        }
+    const _vImageBoxCascade horizontal = { 1, { kernel_width, 0 } };
+    const _vImageBoxCascade vertical = { 1, { kernel_height, 0 } };
+    return _vImageBoxCascadeConvolve_ARGB8888(
+        _vImageMakeConvolveJob(src, dest, srcOffsetToROI_X, srcOffsetToROI_Y, kernel_height, kernel_width, backgroundColor, flags),
+        horizontal,
+        vertical,
+        tempBuffer,
+        flags);
+}
 
-        //  First pass (horizontal)
-        for (int i = static_cast<int>(start_i) - KH_d2; i <= static_cast<int>(end_i) + KH_d2; ++i) {
-            src_i = srcOffsetToROI_Y + i;
-            src_j = srcOffsetToROI_X;
-            sum[0] = backgroundColor[0] * start_j;
-            sum[1] = backgroundColor[1] * start_j;
-            sum[2] = backgroundColor[2] * start_j;
-            sum[3] = backgroundColor[3] * start_j;
-
-            for (int k = start_j - KW_d2; k <= KW_d2; ++k) {
-                sum[0] += src_buf[src_i * src_rowstride + src_j + k].val[0];
-                sum[1] += src_buf[src_i * src_rowstride + src_j + k].val[1];
-                sum[2] += src_buf[src_i * src_rowstride + src_j + k].val[2];
-                sum[3] += src_buf[src_i * src_rowstride + src_j + k].val[3];
-            }
+/**
+@Status Interoperable
+@Notes The tent of width 2n - 1 is applied as two box passes of width n per axis
+*/
+vImage_Error vImageTentConvolve_ARGB8888(const vImage_Buffer* src,
+                                         const vImage_Buffer* dest,
+                                         void* tempBuffer,
+                                         vImagePixelCount srcOffsetToROI_X,
+                                         vImagePixelCount srcOffsetToROI_Y,
+                                         uint32_t kernel_height,
+                                         uint32_t kernel_width,
+                                         const Pixel_8888 backgroundColor,
+                                         vImage_Flags flags) {
+    const vImage_Error result =
+        _vImageValidateConvolve(src, dest, srcOffsetToROI_X, srcOffsetToROI_Y, kernel_height, kernel_width, backgroundColor, flags);
+    if (result != kvImageNoError) {
+        return result;
+    }
+
+    const _vImageBoxCascade horizontal = { 2, { (kernel_width + 1) / 2, (kernel_width + 1) / 2 } };
+    const _vImageBoxCascade vertical = { 2, { (kernel_height + 1) / 2, (kernel_height + 1) / 2 } };
+    return _vImageBoxCascadeConvolve_ARGB8888(
+        _vImageMakeConvolveJob(src, dest, srcOffsetToROI_X, srcOffsetToROI_Y, kernel_height, kernel_width, backgroundColor, flags),
+        horizontal,
+        vertical,
+        tempBuffer,
+        flags);
+}
+
+/**
+@Status Interoperable
+@Notes The kernel is applied without rotation, as on the reference platform. Sums are 32-bit, so sum(|kernel|) * 255 must fit in an int32_t.
+*/
+vImage_Error vImageConvolve_ARGB8888(const vImage_Buffer* src,
+                                     const vImage_Buffer* dest,
+                                     void* tempBuffer,
+                                     vImagePixelCount srcOffsetToROI_X,
+                                     vImagePixelCount srcOffsetToROI_Y,
+                                     const int16_t* kernel,
+                                     uint32_t kernel_height,
+                                     uint32_t kernel_width,
+                                     int32_t divisor,
+                                     const Pixel_8888 backgroundColor,
+                                     vImage_Flags flags) {
+    if (kernel == nullptr) {
+        return kvImageNullPointerArgument;
+    }
 
-            if (i < 0) {
-                temp_buf[(top + i) * dest_rowstride].val[0] = sum[0] > (255 * kernel_width) ? 255 : sum[0] / kernel_width;
-                temp_buf[(top + i) * dest_rowstride].val[1] = sum[1] > (255 * kernel_width) ? 255 : sum[1] / kernel_width;
-                temp_buf[(top + i) * dest_rowstride].val[2] = sum[2] > (255 * kernel_width) ? 255 : sum[2] / kernel_width;
-                temp_buf[(top + i) * dest_rowstride].val[3] = sum[3] > (255 * kernel_width) ? 255 : sum[3] / kernel_width;
-            } else if (i >= static_cast<int>(dest->height)) {
-                temp_buf[(top + (i - dest->height)) * dest_rowstride].val[0] = sum[0] > (255 * kernel_width) ? 255 : sum[0] / kernel_width;
-                temp_buf[(top + (i - dest->height)) * dest_rowstride].val[1] = sum[1] > (255 * kernel_width) ? 255 : sum[1] / kernel_width;
-                temp_buf[(top + (i - dest->height)) * dest_rowstride].val[2] = sum[2] > (255 * kernel_width) ? 255 : sum[2] / kernel_width;
-                temp_buf[(top + (i - dest->height)) * dest_rowstride].val[3] = sum[3] > (255 * kernel_width) ? 255 : sum[3] / kernel_width;
-            } else {
-                dest_buf[i * dest_rowstride].val[0] = sum[0] > (255 * kernel_width) ? 255 : sum[0] / kernel_width;
-                dest_buf[i * dest_rowstride].val[1] = sum[1] > (255 * kernel_width) ? 255 : sum[1] / kernel_width;
-                dest_buf[i * dest_rowstride].val[2] = sum[2] > (255 * kernel_width) ? 255 : sum[2] / kernel_width;
-                dest_buf[i * dest_rowstride].val[3] = sum[3] > (255 * kernel_width) ? 255 : sum[3] / kernel_width;
+    const vImage_Error result =
+        _vImageValidateConvolve(src, dest, srcOffsetToROI_X, srcOffsetToROI_Y, kernel_height, kernel_width, backgroundColor, flags);
+    if (result != kvImageNoError) {
+        return result;
+    }
+
+    return _vImageKernelConvolve_ARGB8888(
+        _vImageMakeConvolveJob(src, dest, srcOffsetToROI_X, srcOffsetToROI_Y, kernel_height, kernel_width, backgroundColor, flags),
+        kernel,
+        divisor,
+        tempBuffer,
+        flags);
+}
+
+static inline ptrdiff_t _vImageFloorDivide(ptrdiff_t numerator, ptrdiff_t denominator) {
+    const ptrdiff_t quotient = numerator / denominator;
+    return ((numerator % denominator != 0) && ((numerator < 0) != (denominator < 0))) ? quotient - 1 : quotient;
+}
+
+static inline Pixel_8888_s* _vImageRowPixels(const vImage_Buffer* buffer, size_t row) {
+    return reinterpret_cast<Pixel_8888_s*>(static_cast<uint8_t*>(buffer->data) + row * buffer->rowBytes);
+}
+
+#if (VIMAGE_SSE == 1)
+// Reverses the order of the four pixels in a block
+static inline __m128i _vImageReversePixels(__m128i pixels) {
+    return _mm_shuffle_epi32(pixels, _MM_SHUFFLE(0, 1, 2, 3));
+}
+
+// Transposes a 4x4 block of pixels held one row per register
+static inline void _vImageTransposePixels(__m128i rows[4]) {
+    const __m128i t0 = _mm_unpacklo_epi32(rows[0], rows[1]);
+    const __m128i t1 = _mm_unpacklo_epi32(rows[2], rows[3]);
+    const __m128i t2 = _mm_unpackhi_epi32(rows[0], rows[1]);
+    const __m128i t3 = _mm_unpackhi_epi32(rows[2], rows[3]);
+    rows[0] = _mm_unpacklo_epi64(t0, t1);
+    rows[1] = _mm_unpackhi_epi64(t0, t1);
+    rows[2] = _mm_unpacklo_epi64(t2, t3);
+    rows[3] = _mm_unpackhi_epi64(t2, t3);
+}
+#endif
+
+/**
+@Status Interoperable
+@Notes Supports in-place operation
+*/
+vImage_Error vImageHorizontalReflect_ARGB8888(const vImage_Buffer* src, const vImage_Buffer* dest, vImage_Flags flags) {
+    if (src == nullptr || dest == nullptr || src->data == nullptr || dest->data == nullptr) {
+        TraceError(TAG, L"One or more NULL parameters passed in");
+        return kvImageNullPointerArgument;
+    } else if ((src->width != dest->width) || (src->height != dest->height)) {
+        TraceError(TAG, L"Buffer sizes don't match");
+        return kvImageBufferSizeMismatch;
+    }
+
+    const size_t width = src->width;
+
+    for (size_t i = 0; i < src->height; ++i) {
+        const Pixel_8888_s* srcPixels = _vImageRowPixels(src, i);
+        Pixel_8888_s* destPixels = _vImageRowPixels(dest, i);
+        size_t left = 0;
+
+        //  Both ends of a row are read before either is written, so src and dest may be the same buffer
+#if (VIMAGE_SSE == 1)
+        if (c_vImageUseSse2 == true) {
+            for (; left + 8 <= width - left; left += 4) {
+                const size_t right = width - left - 4;
+                const __m128i vLeft = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&srcPixels[left]));
+                const __m128i vRight = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&srcPixels[right]));
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(&destPixels[left]), _vImageReversePixels(vRight));
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(&destPixels[right]), _vImageReversePixels(vLeft));
             }
+        }
+#endif
 
-            src_j++;
-
-            for (uint32_t j = 1; j < dest->width; ++j, src_j++) {
-                if (j <= start_j) {
-                    sum[0] += src_buf[src_i * src_rowstride + src_j + KW_d2].val[0] - backgroundColor[0];
-                    sum[1] += src_buf[src_i * src_rowstride + src_j + KW_d2].val[1] - backgroundColor[1];
-                    sum[2] += src_buf[src_i * src_rowstride + src_j + KW_d2].val[2] - backgroundColor[2];
-                    sum[3] += src_buf[src_i * src_rowstride + src_j + KW_d2].val[3] - backgroundColor[3];
-                } else if (j <= end_j) {
-                    sum[0] +=
-                        src_buf[src_i * src_rowstride + src_j + KW_d2].val[0] - src_buf[src_i * src_rowstride + src_j - KW_d2 - 1].val[0];
-                    sum[1] +=
-                        src_buf[src_i * src_rowstride + src_j + KW_d2].val[1] - src_buf[src_i * src_rowstride + src_j - KW_d2 - 1].val[1];
-                    sum[2] +=
-                        src_buf[src_i * src_rowstride + src_j + KW_d2].val[2] - src_buf[src_i * src_rowstride + src_j - KW_d2 - 1].val[2];
-                    sum[3] +=
-                        src_buf[src_i * src_rowstride + src_j + KW_d2].val[3] - src_buf[src_i * src_rowstride + src_j - KW_d2 - 1].val[3];
-                } else {
-                    sum[0] += -src_buf[src_i * src_rowstride + src_j - KW_d2 - 1].val[0] + backgroundColor[0];
-                    sum[1] += -src_buf[src_i * src_rowstride + src_j - KW_d2 - 1].val[1] + backgroundColor[1];
-                    sum[2] += -src_buf[src_i * src_rowstride + src_j - KW_d2 - 1].val[2] + backgroundColor[2];
-                    sum[3] += -src_buf[src_i * src_rowstride + src_j - KW_d2 - 1].val[3] + backgroundColor[3];
+        for (; left < width - left; ++left) {
+            const size_t right = width - 1 - left;
+            const Pixel_8888_s leftPixel = srcPixels[left];
+            destPixels[left] = srcPixels[right];
+            destPixels[right] = leftPixel;
+        }
+    }
+
+    return kvImageNoError;
+}
+
+/**
+@Status Interoperable
+@Notes Supports in-place operation
+*/
+vImage_Error vImageVerticalReflect_ARGB8888(const vImage_Buffer* src, const vImage_Buffer* dest, vImage_Flags flags) {
+    if (src == nullptr || dest == nullptr || src->data == nullptr || dest->data == nullptr) {
+        TraceError(TAG, L"One or more NULL parameters passed in");
+        return kvImageNullPointerArgument;
+    } else if ((src->width != dest->width) || (src->height != dest->height)) {
+        TraceError(TAG, L"Buffer sizes don't match");
+        return kvImageBufferSizeMismatch;
+    }
+
+    const size_t lineBytes = src->width * sizeof(Pixel_8888_s);
+    std::unique_ptr<uint8_t[]> swapRow(new (std::nothrow) uint8_t[lineBytes]);
+    if (!swapRow) {
+        return kvImageMemoryAllocationError;
+    }
+
+    for (size_t top = 0, bottom = src->height - 1; top <= bottom && bottom < src->height; ++top, --bottom) {
+        memcpy(swapRow.get(), _vImageRowPixels(src, top), lineBytes);
+        memmove(_vImageRowPixels(dest, top), _vImageRowPixels(src, bottom), lineBytes);
+        memcpy(_vImageRowPixels(dest, bottom), swapRow.get(), lineBytes);
+
+        if (bottom == 0) {
+            break;
+        }
+    }
+
+    return kvImageNoError;
+}
+
+/**
+@Status Interoperable
+@Notes The rotated image is centered in dest; uncovered destination pixels are set to backColor
+*/
+vImage_Error vImageRotate90_ARGB8888(
+    const vImage_Buffer* src, const vImage_Buffer* dest, uint8_t rotationConstant, const Pixel_8888 backColor, vImage_Flags flags) {
+    if (src == nullptr || dest == nullptr || src->data == nullptr || dest->data == nullptr) {
+        TraceError(TAG, L"One or more NULL parameters passed in");
+        return kvImageNullPointerArgument;
+    } else if (rotationConstant > kRotate270DegreesCounterClockwise) {
+        TraceError(TAG, L"Invalid rotation constant");
+        return kvImageInvalidParameter;
+    } else if (src->data == dest->data) {
+        return kvImageOutOfPlaceOperationRequired;
+    }
+
+    const ptrdiff_t srcWidth = static_cast<ptrdiff_t>(src->width);
+    const ptrdiff_t srcHeight = static_cast<ptrdiff_t>(src->height);
+    const bool quarterTurn = (rotationConstant & 1) != 0;
+    const ptrdiff_t rotatedWidth = quarterTurn ? srcHeight : srcWidth;
+    const ptrdiff_t rotatedHeight = quarterTurn ? srcWidth : srcHeight;
+
+    //  Offset of the rotated image within dest
+    const ptrdiff_t offsetX = _vImageFloorDivide(static_cast<ptrdiff_t>(dest->width) - rotatedWidth, 2);
+    const ptrdiff_t offsetY = _vImageFloorDivide(static_cast<ptrdiff_t>(dest->height) - rotatedHeight, 2);
+
+    Pixel_8888_s background;
+    memset(&background, 0, sizeof(background));
+    if (backColor != nullptr) {
+        memcpy(background.val, backColor, sizeof(background.val));
+    }
+
+    //  Source pixel of rotated-image pixel (x, y) for each rotation
+    auto sourcePixel = [&](ptrdiff_t x, ptrdiff_t y) -> const Pixel_8888_s& {
+        switch (rotationConstant) {
+            case kRotate90DegreesCounterClockwise:
+                return _vImageRowPixels(src, x)[srcWidth - 1 - y];
+            case kRotate180DegreesCounterClockwise:
+                return _vImageRowPixels(src, srcHeight - 1 - y)[srcWidth - 1 - x];
+            case kRotate270DegreesCounterClockwise:
+                return _vImageRowPixels(src, srcHeight - 1 - x)[y];
+            default:
+                return _vImageRowPixels(src, y)[x];
+        }
+    };
+
+    //  Quarter turns read the source down its columns, so walk the destination in tiles that keep the source rows cache resident
+    const ptrdiff_t tileSize = 64;
+    const ptrdiff_t firstX = std::max<ptrdiff_t>(0, offsetX);
+    const ptrdiff_t endX = std::min<ptrdiff_t>(dest->width, offsetX + rotatedWidth);
+
+    for (ptrdiff_t tileY = 0; tileY < static_cast<ptrdiff_t>(dest->height); tileY += tileSize) {
+        const ptrdiff_t tileEndY = std::min<ptrdiff_t>(dest->height, tileY + tileSize);
+
+        for (ptrdiff_t y = tileY; y < tileEndY; ++y) {
+            Pixel_8888_s* destPixels = _vImageRowPixels(dest, y);
+            const bool rowCovered = (y >= offsetY) && (y < offsetY + rotatedHeight);
+            const ptrdiff_t coveredBegin = rowCovered ? firstX : dest->width;
+            const ptrdiff_t coveredEnd = rowCovered ? std::max(firstX, endX) : dest->width;
+            std::fill(destPixels, destPixels + coveredBegin, background);
+            std::fill(destPixels + coveredEnd, destPixels + dest->width, background);
+        }
+
+        const ptrdiff_t coveredY = std::max<ptrdiff_t>(tileY, offsetY);
+        const ptrdiff_t coveredEndY = std::min<ptrdiff_t>(tileEndY, offsetY + rotatedHeight);
+
+        for (ptrdiff_t tileX = firstX; tileX < endX; tileX += tileSize) {
+            const ptrdiff_t tileEndX = std::min<ptrdiff_t>(endX, tileX + tileSize);
+            ptrdiff_t y = coveredY;
+
+#if (VIMAGE_SSE == 1)
+            if (c_vImageUseSse2 == true) {
+                for (; y + 4 <= coveredEndY; y += 4) {
+                    ptrdiff_t x = tileX;
+                    for (; x + 4 <= tileEndX; x += 4) {
+                        const ptrdiff_t rotatedX = x - offsetX;
+                        const ptrdiff_t rotatedY = y - offsetY;
+                        __m128i block[4];
+
+                        switch (rotationConstant) {
+                            case kRotate90DegreesCounterClockwise:
+                                //  Source rows rotatedX..+3, columns ending at srcWidth - 1 - rotatedY
+                                for (ptrdiff_t k = 0; k < 4; ++k) {
+                                    block[k] = _mm_loadu_si128(
+                                        reinterpret_cast<const __m128i*>(&_vImageRowPixels(src, rotatedX + k)[srcWidth - 4 - rotatedY]));
+                                }
+
+                                _vImageTransposePixels(block);
+                                std::swap(block[0], block[3]);
+                                std::swap(block[1], block[2]);
+                                break;
+                            case kRotate270DegreesCounterClockwise:
+                                //  Source rows ending at srcHeight - 1 - rotatedX, columns rotatedY..+3
+                                for (ptrdiff_t k = 0; k < 4; ++k) {
+                                    block[k] = _mm_loadu_si128(
+                                        reinterpret_cast<const __m128i*>(&_vImageRowPixels(src, srcHeight - 4 - rotatedX + k)[rotatedY]));
+                                }
+
+                                _vImageTransposePixels(block);
+                                for (ptrdiff_t k = 0; k < 4; ++k) {
+                                    block[k] = _vImageReversePixels(block[k]);
+                                }
+                                break;
+                            case kRotate180DegreesCounterClockwise:
+                                for (ptrdiff_t k = 0; k < 4; ++k) {
+                                    block[k] = _vImageReversePixels(_mm_loadu_si128(reinterpret_cast<const __m128i*>(
+                                        &_vImageRowPixels(src, srcHeight - 1 - rotatedY - k)[srcWidth - 4 - rotatedX])));
+                                }
+                                break;
+                            default:
+                                for (ptrdiff_t k = 0; k < 4; ++k) {
+                                    block[k] =
+                                        _mm_loadu_si128(reinterpret_cast<const __m128i*>(&_vImageRowPixels(src, rotatedY + k)[rotatedX]));
+                                }
+                                break;
+                        }
+
+                        for (ptrdiff_t k = 0; k < 4; ++k) {
+                            _mm_storeu_si128(reinterpret_cast<__m128i*>(&_vImageRowPixels(dest, y + k)[x]), block[k]);
+                        }
+                    }
+
+                    for (ptrdiff_t k = 0; k < 4; ++k) {
+                        Pixel_8888_s* destPixels = _vImageRowPixels(dest, y + k);
+                        for (ptrdiff_t xx = x; xx < tileEndX; ++xx) {
+                            destPixels[xx] = sourcePixel(xx - offsetX, y + k - offsetY);
+                        }
+                    }
                 }
+            }
+#endif
 
-                if (i < 0) {
-                    temp_buf[(top + i) * dest_rowstride + j].val[0] = sum[0] > (255 * kernel_width) ? 255 : sum[0] / kernel_width;
-                    temp_buf[(top + i) * dest_rowstride + j].val[1] = sum[1] > (255 * kernel_width) ? 255 : sum[1] / kernel_width;
-                    temp_buf[(top + i) * dest_rowstride + j].val[2] = sum[2] > (255 * kernel_width) ? 255 : sum[2] / kernel_width;
-                    temp_buf[(top + i) * dest_rowstride + j].val[3] = sum[3] > (255 * kernel_width) ? 255 : sum[3] / kernel_width;
-                } else if (i >= static_cast<int>(dest->height)) {
-                    temp_buf[(top + (i - dest->height)) * dest_rowstride + j].val[0] =
-                        sum[0] > (255 * kernel_width) ? 255 : sum[0] / kernel_width;
-                    temp_buf[(top + (i - dest->height)) * dest_rowstride + j].val[1] =
-                        sum[1] > (255 * kernel_width) ? 255 : sum[1] / kernel_width;
-                    temp_buf[(top + (i - dest->height)) * dest_rowstride + j].val[2] =
-                        sum[2] > (255 * kernel_width) ? 255 : sum[2] / kernel_width;
-                    temp_buf[(top + (i - dest->height)) * dest_rowstride + j].val[3] =
-                        sum[3] > (255 * kernel_width) ? 255 : sum[3] / kernel_width;
-                } else {
-                    dest_buf[i * dest_rowstride + j].val[0] = sum[0] > (255 * kernel_width) ? 255 : sum[0] / kernel_width;
-                    dest_buf[i * dest_rowstride + j].val[1] = sum[1] > (255 * kernel_width) ? 255 : sum[1] / kernel_width;
-                    dest_buf[i * dest_rowstride + j].val[2] = sum[2] > (255 * kernel_width) ? 255 : sum[2] / kernel_width;
-                    dest_buf[i * dest_rowstride + j].val[3] = sum[3] > (255 * kernel_width) ? 255 : sum[3] / kernel_width;
+            for (; y < coveredEndY; ++y) {
+                Pixel_8888_s* destPixels = _vImageRowPixels(dest, y);
+                for (ptrdiff_t x = tileX; x < tileEndX; ++x) {
+                    destPixels[x] = sourcePixel(x - offsetX, y - offsetY);
                 }
             }
         }
+    }
 
-        //  Second pass (vertical)
-        for (uint32_t j = 0; j < dest->width; ++j) {
-            sum[0] = backgroundColor[0] * start_i;
-            sum[1] = backgroundColor[1] * start_i;
-            sum[2] = backgroundColor[2] * start_i;
-            sum[3] = backgroundColor[3] * start_i;
-
-            for (int k = start_i - KH_d2; k < 0; ++k) {
-                sum[0] += temp_buf[(top + k) * dest_rowstride + j].val[0];
-                sum[1] += temp_buf[(top + k) * dest_rowstride + j].val[1];
-                sum[2] += temp_buf[(top + k) * dest_rowstride + j].val[2];
-                sum[3] += temp_buf[(top + k) * dest_rowstride + j].val[3];
-            }
+    return kvImageNoError;
+}
 
-            for (int k = 0; k <= KH_d2; ++k) {
-                sum[0] += dest_buf[k * dest_rowstride + j].val[0];
-                sum[1] += dest_buf[k * dest_rowstride + j].val[1];
-                sum[2] += dest_buf[k * dest_rowstride + j].val[2];
-                sum[3] += dest_buf[k * dest_rowstride + j].val[3];
-            }
+// Resampling coefficients for one axis: output i reads counts[i] consecutive source pixels from starts[i],
+// weighted by weights[i * tapStride + t] in 2.14 fixed point
+struct _vImageResampleTable {
+    int32_t* starts;
+    int32_t* counts;
+    int16_t* weights;
+    size_t tapStride;
+};
+
+static const int c_vImageResampleWeightBits = 14;
+
+// Intermediate rows keep this many fractional bits after the horizontal pass
+static const int c_vImageResampleIntermediateBits = 6;
+
+static inline double _vImageLanczos(double x, double lobes) {
+    if (x == 0.0) {
+        return 1.0;
+    } else if (std::fabs(x) >= lobes) {
+        return 0.0;
+    }
 
-            temp_buf[(top + below) * dest_rowstride].val[0] = sum[0] > (255 * kernel_height) ? 255 : sum[0] / kernel_height;
-            temp_buf[(top + below) * dest_rowstride].val[1] = sum[1] > (255 * kernel_height) ? 255 : sum[1] / kernel_height;
-            temp_buf[(top + below) * dest_rowstride].val[2] = sum[2] > (255 * kernel_height) ? 255 : sum[2] / kernel_height;
-            temp_buf[(top + below) * dest_rowstride].val[3] = sum[3] > (255 * kernel_height) ? 255 : sum[3] / kernel_height;
-
-            for (int i = 1; i < static_cast<int>(dest->height); ++i) {
-                if (i <= static_cast<int>(start_i)) {
-                    sum[0] -= backgroundColor[0];
-                    sum[1] -= backgroundColor[1];
-                    sum[2] -= backgroundColor[2];
-                    sum[3] -= backgroundColor[3];
-                } else if (i <= KH_d2) {
-                    sum[0] -= temp_buf[(top + (i - KH_d2 - 1)) * dest_rowstride + j].val[0];
-                    sum[1] -= temp_buf[(top + (i - KH_d2 - 1)) * dest_rowstride + j].val[1];
-                    sum[2] -= temp_buf[(top + (i - KH_d2 - 1)) * dest_rowstride + j].val[2];
-                    sum[3] -= temp_buf[(top + (i - KH_d2 - 1)) * dest_rowstride + j].val[3];
-                } else {
-                    sum[0] -= dest_buf[(i - KH_d2 - 1) * dest_rowstride + j].val[0];
-                    sum[1] -= dest_buf[(i - KH_d2 - 1) * dest_rowstride + j].val[1];
-                    sum[2] -= dest_buf[(i - KH_d2 - 1) * dest_rowstride + j].val[2];
-                    sum[3] -= dest_buf[(i - KH_d2 - 1) * dest_rowstride + j].val[3];
-                }
+    const double pi = 3.14159265358979323846;
+    const double px = pi * x;
+    return lobes * std::sin(px) * std::sin(px / lobes) / (px * px);
+}
 
-                if (i > static_cast<int>(end_i)) {
-                    sum[0] += backgroundColor[0];
-                    sum[1] += backgroundColor[1];
-                    sum[2] += backgroundColor[2];
-                    sum[3] += backgroundColor[3];
-                } else if (i >= static_cast<int>(dest->height) - KH_d2) {
-                    sum[0] += temp_buf[(top + (i + KH_d2) - dest->height) * dest_rowstride + j].val[0];
-                    sum[1] += temp_buf[(top + (i + KH_d2) - dest->height) * dest_rowstride + j].val[1];
-                    sum[2] += temp_buf[(top + (i + KH_d2) - dest->height) * dest_rowstride + j].val[2];
-                    sum[3] += temp_buf[(top + (i + KH_d2) - dest->height) * dest_rowstride + j].val[3];
-                } else {
-                    sum[0] += dest_buf[(i + KH_d2) * dest_rowstride + j].val[0];
-                    sum[1] += dest_buf[(i + KH_d2) * dest_rowstride + j].val[1];
-                    sum[2] += dest_buf[(i + KH_d2) * dest_rowstride + j].val[2];
-                    sum[3] += dest_buf[(i + KH_d2) * dest_rowstride + j].val[3];
-                }
+static inline size_t _vImageResampleTapStride(size_t srcLength, size_t destLength, double lobes) {
+    const double filterScale = std::max(1.0, static_cast<double>(srcLength) / destLength);
+    return _vImageAlignSizeT(static_cast<size_t>(std::ceil(2.0 * lobes * filterScale)) + 2, 2);
+}
 
-                temp_buf[(top + below) * dest_rowstride + i].val[0] = sum[0] > (255 * kernel_height) ? 255 : sum[0] / kernel_height;
-                temp_buf[(top + below) * dest_rowstride + i].val[1] = sum[1] > (255 * kernel_height) ? 255 : sum[1] / kernel_height;
-                temp_buf[(top + below) * dest_rowstride + i].val[2] = sum[2] > (255 * kernel_height) ? 255 : sum[2] / kernel_height;
-                temp_buf[(top + below) * dest_rowstride + i].val[3] = sum[3] > (255 * kernel_height) ? 255 : sum[3] / kernel_height;
-            }
+static inline size_t _vImageResampleTableBytes(size_t destLength, size_t tapStride) {
+    return 2 * _vImageAlignScratch(destLength * sizeof(int32_t)) + _vImageAlignScratch(destLength * tapStride * sizeof(int16_t));
+}
+
+// Fills table with Lanczos coefficients mapping srcLength pixels onto destLength pixels. Pixel centers are aligned, the kernel is
+// widened by the scale factor when shrinking, and taps past either edge fold onto the edge pixel.
+static void _vImageBuildResampleTable(_vImageResampleTable& table, uint8_t* memory, size_t srcLength, size_t destLength, double lobes) {
+    table.tapStride = _vImageResampleTapStride(srcLength, destLength, lobes);
+    table.starts = reinterpret_cast<int32_t*>(memory);
+    table.counts = reinterpret_cast<int32_t*>(memory + _vImageAlignScratch(destLength * sizeof(int32_t)));
+    table.weights = reinterpret_cast<int16_t*>(memory + 2 * _vImageAlignScratch(destLength * sizeof(int32_t)));
+
+    const double scale = static_cast<double>(srcLength) / destLength;
+    const double filterScale = std::max(1.0, scale);
+    const double support = lobes * filterScale;
+    const ptrdiff_t last = static_cast<ptrdiff_t>(srcLength) - 1;
+    std::vector<double> taps(table.tapStride);
+
+    for (size_t i = 0; i < destLength; ++i) {
+        const double center = (i + 0.5) * scale - 0.5;
+        const ptrdiff_t first = static_cast<ptrdiff_t>(std::ceil(center - support));
+        const ptrdiff_t end = static_cast<ptrdiff_t>(std::floor(center + support)) + 1;
+        const ptrdiff_t start = std::min(std::max<ptrdiff_t>(0, first), last);
+        const ptrdiff_t count = std::max<ptrdiff_t>(1, std::min(end, last + 1) - start);
+
+        std::fill(taps.begin(), taps.end(), 0.0);
+        double total = 0.0;
+        for (ptrdiff_t k = first; k < end; ++k) {
+            const double weight = _vImageLanczos((k - center) / filterScale, lobes);
+            const ptrdiff_t tap = std::min(std::max<ptrdiff_t>(0, k), last) - start;
+            taps[std::min(tap, count - 1)] += weight;
+            total += weight;
+        }
 
-            for (uint32_t i = 0; i < dest->height; ++i) {
-                dest_buf[i * dest_rowstride + j] = temp_buf[(top + below) * dest_rowstride + i];
+        //  Quantize, then push the rounding error onto the largest tap so the weights sum to exactly one
+        int16_t* weights = table.weights + i * table.tapStride;
+        int32_t sum = 0;
+        ptrdiff_t largest = 0;
+        for (ptrdiff_t t = 0; t < static_cast<ptrdiff_t>(table.tapStride); ++t) {
+            weights[t] = (t < count) ? static_cast<int16_t>(std::floor(taps[t] / total * (1 << c_vImageResampleWeightBits) + 0.5)) : 0;
+            sum += weights[t];
+            if (std::abs(weights[t]) > std::abs(weights[largest])) {
+                largest = t;
             }
         }
+
+        weights[largest] = static_cast<int16_t>(weights[largest] + (1 << c_vImageResampleWeightBits) - sum);
+        table.starts[i] = static_cast<int32_t>(start);
+        table.counts[i] = static_cast<int32_t>(count);
     }
+}
+
+// Resamples one source row horizontally into 16-bit lanes with c_vImageResampleIntermediateBits fractional bits
+static void _vImageResampleRowHorizontal(const _vImageResampleTable& table, const Pixel_8888_s* srcPixels, int16_t* lanes, size_t width) {
+    const int shift = c_vImageResampleWeightBits - c_vImageResampleIntermediateBits;
 
-    //  This block deals with code for flag kvImageEdgeExtend, which requires all pixels outside image to be
-    //  replicated by the edges of the image outwards.
-    else if (flags & kvImageEdgeExtend) {
-        //  For storing the first and the last pixel if the image is to be extended
-        Pixel_8888_s first_pixel;
-        Pixel_8888_s last_pixel;
-
-        //  First pass (horizontal)
-        for (int i = static_cast<int>(start_i) - KH_d2; i <= static_cast<int>(end_i) + KH_d2; ++i) {
-            src_i = srcOffsetToROI_Y + i;
-            src_j = srcOffsetToROI_X;
-            first_pixel = src_buf[src_i * src_rowstride + src_j + (start_j - KW_d2)];
-            last_pixel = src_buf[src_i * src_rowstride + src_j + end_j + KW_d2];
-            sum[0] = first_pixel.val[0] * start_j;
-            sum[1] = first_pixel.val[1] * start_j;
-            sum[2] = first_pixel.val[2] * start_j;
-            sum[3] = first_pixel.val[3] * start_j;
-
-            for (int k = start_j - KW_d2; k <= KW_d2; ++k) {
-                sum[0] += src_buf[src_i * src_rowstride + src_j + k].val[0];
-                sum[1] += src_buf[src_i * src_rowstride + src_j + k].val[1];
-                sum[2] += src_buf[src_i * src_rowstride + src_j + k].val[2];
-                sum[3] += src_buf[src_i * src_rowstride + src_j + k].val[3];
+    for (size_t j = 0; j < width; ++j) {
+        const Pixel_8888_s* taps = srcPixels + table.starts[j];
+        const int16_t* weights = table.weights + j * table.tapStride;
+        const int32_t count = table.counts[j];
+
+#if (VIMAGE_SSE == 1)
+        if (c_vImageUseSse2 == true) {
+            const __m128i vZero = _mm_setzero_si128();
+            __m128i vSum = _mm_set1_epi32(1 << (shift - 1));
+            int32_t t = 0;
+
+            //  Interleave the channels of two taps so one multiply-add applies both weights
+            for (; t + 2 <= count; t += 2) {
+                const __m128i vPair = _mm_unpacklo_epi8(_mm_cvtsi32_si128(*reinterpret_cast<const int32_t*>(&taps[t])),
+                                                        _mm_cvtsi32_si128(*reinterpret_cast<const int32_t*>(&taps[t + 1])));
+                const __m128i vWeights = _mm_set1_epi32(static_cast<uint16_t>(weights[t]) | (static_cast<uint32_t>(static_cast<uint16_t>(weights[t + 1])) << 16));
+                vSum = _mm_add_epi32(vSum, _mm_madd_epi16(_mm_unpacklo_epi8(vPair, vZero), vWeights));
             }
 
-            if (i < 0) {
-                temp_buf[(top + i) * dest_rowstride].val[0] = sum[0] > (255 * kernel_width) ? 255 : sum[0] / kernel_width;
-                temp_buf[(top + i) * dest_rowstride].val[1] = sum[1] > (255 * kernel_width) ? 255 : sum[1] / kernel_width;
-                temp_buf[(top + i) * dest_rowstride].val[2] = sum[2] > (255 * kernel_width) ? 255 : sum[2] / kernel_width;
-                temp_buf[(top + i) * dest_rowstride].val[3] = sum[3] > (255 * kernel_width) ? 255 : sum[3] / kernel_width;
-            } else if (i >= static_cast<int>(dest->height)) {
-                temp_buf[(top + (i - dest->height)) * dest_rowstride].val[0] = sum[0] > (255 * kernel_width) ? 255 : sum[0] / kernel_width;
-                temp_buf[(top + (i - dest->height)) * dest_rowstride].val[1] = sum[1] > (255 * kernel_width) ? 255 : sum[1] / kernel_width;
-                temp_buf[(top + (i - dest->height)) * dest_rowstride].val[2] = sum[2] > (255 * kernel_width) ? 255 : sum[2] / kernel_width;
-                temp_buf[(top + (i - dest->height)) * dest_rowstride].val[3] = sum[3] > (255 * kernel_width) ? 255 : sum[3] / kernel_width;
-            } else {
-                dest_buf[i * dest_rowstride].val[0] = sum[0] > (255 * kernel_width) ? 255 : sum[0] / kernel_width;
-                dest_buf[i * dest_rowstride].val[1] = sum[1] > (255 * kernel_width) ? 255 : sum[1] / kernel_width;
-                dest_buf[i * dest_rowstride].val[2] = sum[2] > (255 * kernel_width) ? 255 : sum[2] / kernel_width;
-                dest_buf[i * dest_rowstride].val[3] = sum[3] > (255 * kernel_width) ? 255 : sum[3] / kernel_width;
+            if (t < count) {
+                const __m128i vPixel = _mm_unpacklo_epi8(_mm_cvtsi32_si128(*reinterpret_cast<const int32_t*>(&taps[t])), vZero);
+                const __m128i vWeights = _mm_set1_epi32(static_cast<uint16_t>(weights[t]));
+                vSum = _mm_add_epi32(vSum, _mm_madd_epi16(_mm_unpacklo_epi16(vPixel, vZero), vWeights));
             }
 
-            src_j++;
-
-            for (uint32_t j = 1; j < dest->width; ++j, src_j++) {
-                if (j <= start_j) {
-                    sum[0] += src_buf[src_i * src_rowstride + src_j + KW_d2].val[0] - first_pixel.val[0];
-                    sum[1] += src_buf[src_i * src_rowstride + src_j + KW_d2].val[1] - first_pixel.val[1];
-                    sum[2] += src_buf[src_i * src_rowstride + src_j + KW_d2].val[2] - first_pixel.val[2];
-                    sum[3] += src_buf[src_i * src_rowstride + src_j + KW_d2].val[3] - first_pixel.val[3];
-                } else if (j <= end_j) {
-                    sum[0] +=
-                        src_buf[src_i * src_rowstride + src_j + KW_d2].val[0] - src_buf[src_i * src_rowstride + src_j - KW_d2 - 1].val[0];
-                    sum[1] +=
-                        src_buf[src_i * src_rowstride + src_j + KW_d2].val[1] - src_buf[src_i * src_rowstride + src_j - KW_d2 - 1].val[1];
-                    sum[2] +=
-                        src_buf[src_i * src_rowstride + src_j + KW_d2].val[2] - src_buf[src_i * src_rowstride + src_j - KW_d2 - 1].val[2];
-                    sum[3] +=
-                        src_buf[src_i * src_rowstride + src_j + KW_d2].val[3] - src_buf[src_i * src_rowstride + src_j - KW_d2 - 1].val[3];
-                } else {
-                    sum[0] += last_pixel.val[0] - src_buf[src_i * src_rowstride + src_j - KW_d2 - 1].val[0];
-                    sum[1] += last_pixel.val[1] - src_buf[src_i * src_rowstride + src_j - KW_d2 - 1].val[1];
-                    sum[2] += last_pixel.val[2] - src_buf[src_i * src_rowstride + src_j - KW_d2 - 1].val[2];
-                    sum[3] += last_pixel.val[3] - src_buf[src_i * src_rowstride + src_j - KW_d2 - 1].val[3];
-                }
+            _mm_storel_epi64(reinterpret_cast<__m128i*>(&lanes[4 * j]), _mm_packs_epi32(_mm_srai_epi32(vSum, shift), vZero));
+            continue;
+        }
+#endif
 
-                if (i < 0) {
-                    temp_buf[(top + i) * dest_rowstride + j].val[0] = sum[0] > (255 * kernel_width) ? 255 : sum[0] / kernel_width;
-                    temp_buf[(top + i) * dest_rowstride + j].val[1] = sum[1] > (255 * kernel_width) ? 255 : sum[1] / kernel_width;
-                    temp_buf[(top + i) * dest_rowstride + j].val[2] = sum[2] > (255 * kernel_width) ? 255 : sum[2] / kernel_width;
-                    temp_buf[(top + i) * dest_rowstride + j].val[3] = sum[3] > (255 * kernel_width) ? 255 : sum[3] / kernel_width;
-                } else if (i >= static_cast<int>(dest->height)) {
-                    temp_buf[(top + (i - dest->height)) * dest_rowstride + j].val[0] =
-                        sum[0] > (255 * kernel_width) ? 255 : sum[0] / kernel_width;
-                    temp_buf[(top + (i - dest->height)) * dest_rowstride + j].val[1] =
-                        sum[1] > (255 * kernel_width) ? 255 : sum[1] / kernel_width;
-                    temp_buf[(top + (i - dest->height)) * dest_rowstride + j].val[2] =
-                        sum[2] > (255 * kernel_width) ? 255 : sum[2] / kernel_width;
-                    temp_buf[(top + (i - dest->height)) * dest_rowstride + j].val[3] =
-                        sum[3] > (255 * kernel_width) ? 255 : sum[3] / kernel_width;
-                } else {
-                    dest_buf[i * dest_rowstride + j].val[0] = sum[0] > (255 * kernel_width) ? 255 : sum[0] / kernel_width;
-                    dest_buf[i * dest_rowstride + j].val[1] = sum[1] > (255 * kernel_width) ? 255 : sum[1] / kernel_width;
-                    dest_buf[i * dest_rowstride + j].val[2] = sum[2] > (255 * kernel_width) ? 255 : sum[2] / kernel_width;
-                    dest_buf[i * dest_rowstride + j].val[3] = sum[3] > (255 * kernel_width) ? 255 : sum[3] / kernel_width;
-                }
+        for (size_t k = 0; k < 4; ++k) {
+            int32_t sum = 1 << (shift - 1);
+            for (int32_t t = 0; t < count; ++t) {
+                sum += weights[t] * taps[t].val[k];
             }
+
+            lanes[4 * j + k] = static_cast<int16_t>(std::min(32767, std::max(-32768, sum >> shift)));
         }
+    }
+}
+
+// Resamples intermediate rows vertically into one destination row; rows[t] is the row for tap t
+static void _vImageResampleRowVertical(const int16_t* const* rows, const int16_t* weights, int32_t count, Pixel_8888_s* destPixels, size_t width) {
+    const int shift = c_vImageResampleWeightBits + c_vImageResampleIntermediateBits;
+    const size_t laneCount = width * 4;
+    size_t i = 0;
 
-        //  Second pass (vertical)
-        for (uint32_t j = 0; j < dest->width; ++j) {
-            if (top > 0) {
-                first_pixel = temp_buf[j];
-            } else {
-                first_pixel = dest_buf[j];
+#if (VIMAGE_SSE == 1)
+    if (c_vImageUseSse2 == true) {
+        for (; i + 8 <= laneCount; i += 8) {
+            __m128i vLow = _mm_set1_epi32(1 << (shift - 1));
+            __m128i vHigh = vLow;
+            int32_t t = 0;
+
+            for (; t + 2 <= count; t += 2) {
+                const __m128i vRow0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&rows[t][i]));
+                const __m128i vRow1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&rows[t + 1][i]));
+                const __m128i vWeights = _mm_set1_epi32(static_cast<uint16_t>(weights[t]) | (static_cast<uint32_t>(static_cast<uint16_t>(weights[t + 1])) << 16));
+                vLow = _mm_add_epi32(vLow, _mm_madd_epi16(_mm_unpacklo_epi16(vRow0, vRow1), vWeights));
+                vHigh = _mm_add_epi32(vHigh, _mm_madd_epi16(_mm_unpackhi_epi16(vRow0, vRow1), vWeights));
             }
 
-            if (below > 0) {
-                last_pixel = temp_buf[(top + below - 1) * dest_rowstride + j];
-            } else {
-                last_pixel = dest_buf[(dest->height - 1) * dest_rowstride + j];
+            if (t < count) {
+                const __m128i vRow0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&rows[t][i]));
+                const __m128i vWeights = _mm_set1_epi32(static_cast<uint16_t>(weights[t]));
+                vLow = _mm_add_epi32(vLow, _mm_madd_epi16(_mm_unpacklo_epi16(vRow0, _mm_setzero_si128()), vWeights));
+                vHigh = _mm_add_epi32(vHigh, _mm_madd_epi16(_mm_unpackhi_epi16(vRow0, _mm_setzero_si128()), vWeights));
             }
 
-            sum[0] = first_pixel.val[0] * start_i;
-            sum[1] = first_pixel.val[1] * start_i;
-            sum[2] = first_pixel.val[2] * start_i;
-            sum[3] = first_pixel.val[3] * start_i;
+            const __m128i vPacked = _mm_packs_epi32(_mm_srai_epi32(vLow, shift), _mm_srai_epi32(vHigh, shift));
+            _mm_storel_epi64(reinterpret_cast<__m128i*>(reinterpret_cast<uint8_t*>(destPixels) + i), _mm_packus_epi16(vPacked, vPacked));
+        }
+    }
+#endif
 
-            for (int k = start_i - KH_d2; k < 0; ++k) {
-                sum[0] += temp_buf[(top + k) * dest_rowstride + j].val[0];
-                sum[1] += temp_buf[(top + k) * dest_rowstride + j].val[1];
-                sum[2] += temp_buf[(top + k) * dest_rowstride + j].val[2];
-                sum[3] += temp_buf[(top + k) * dest_rowstride + j].val[3];
-            }
+    uint8_t* destBytes = reinterpret_cast<uint8_t*>(destPixels);
+    for (; i < laneCount; ++i) {
+        int32_t sum = 1 << (shift - 1);
+        for (int32_t t = 0; t < count; ++t) {
+            sum += weights[t] * rows[t][i];
+        }
+
+        sum >>= shift;
+        destBytes[i] = static_cast<uint8_t>(std::min(255, std::max(0, sum)));
+    }
+}
+
+/**
+@Status Caveat
+@Notes Resamples with a Lanczos3 kernel, or Lanczos5 with kvImageHighQualityResampling. Edges are always extended.
+*/
+vImage_Error vImageScale_ARGB8888(const vImage_Buffer* src, const vImage_Buffer* dest, void* tempBuffer, vImage_Flags flags) {
+    if (src == nullptr || dest == nullptr || src->data == nullptr || dest->data == nullptr) {
+        TraceError(TAG, L"One or more NULL parameters passed in");
+        return kvImageNullPointerArgument;
+    } else if ((src->width == 0) || (src->height == 0) || (dest->width == 0) || (dest->height == 0)) {
+        return kvImageInvalidParameter;
+    } else if (src->data == dest->data) {
+        return kvImageOutOfPlaceOperationRequired;
+    }
+
+    const double lobes = (flags & kvImageHighQualityResampling) ? 5.0 : 3.0;
+    const size_t width = dest->width;
+    const size_t horizontalStride = _vImageResampleTapStride(src->width, dest->width, lobes);
+    const size_t verticalStride = _vImageResampleTapStride(src->height, dest->height, lobes);
+    const size_t bandCount = _vImageRowBandCount(dest->width, dest->height, 16, flags);
+    const size_t bandRows = _vImageRowBandHeight(dest->height, bandCount);
 
-            for (int k = 0; k <= KH_d2; ++k) {
-                sum[0] += dest_buf[k * dest_rowstride + j].val[0];
-                sum[1] += dest_buf[k * dest_rowstride + j].val[1];
-                sum[2] += dest_buf[k * dest_rowstride + j].val[2];
-                sum[3] += dest_buf[k * dest_rowstride + j].val[3];
+    //  Each band resamples horizontally only the source rows its own output rows reach, so bound that span for sizing
+    const size_t bandSourceRows =
+        std::min<size_t>(src->height, static_cast<size_t>(std::ceil(bandRows * static_cast<double>(src->height) / dest->height)) + verticalStride + 1);
+
+    const size_t sharedBytes = _vImageResampleTableBytes(dest->width, horizontalStride) + _vImageResampleTableBytes(dest->height, verticalStride);
+    const size_t bandBytes = _vImageAlignScratch(bandSourceRows * width * 4 * sizeof(int16_t)) + _vImageAlignScratch(verticalStride * sizeof(int16_t*));
+    const size_t tempBytes = sharedBytes + bandCount * bandBytes + 16;
+
+    if (flags & kvImageGetTempBufferSize) {
+        return static_cast<vImage_Error>(tempBytes);
+    }
+
+    std::unique_ptr<uint8_t[]> ownedTemp;
+    uint8_t* temp = static_cast<uint8_t*>(tempBuffer);
+    if (temp == nullptr) {
+        ownedTemp.reset(new (std::nothrow) uint8_t[tempBytes]);
+        if (!ownedTemp) {
+            return kvImageMemoryAllocationError;
+        }
+
+        temp = ownedTemp.get();
+    }
+
+    temp += (16 - (reinterpret_cast<uintptr_t>(temp) & 15)) & 15;
+
+    _vImageResampleTable horizontal;
+    _vImageResampleTable vertical;
+    _vImageBuildResampleTable(horizontal, temp, src->width, dest->width, lobes);
+    _vImageBuildResampleTable(vertical, temp + _vImageResampleTableBytes(dest->width, horizontalStride), src->height, dest->height, lobes);
+
+    _vImageForEachRowBand(dest->height, bandCount, [&](size_t band, size_t firstRow, size_t endRow) {
+        uint8_t* scratch = temp + sharedBytes + band * bandBytes;
+        int16_t* intermediate = reinterpret_cast<int16_t*>(scratch);
+        const int16_t** rows = reinterpret_cast<const int16_t**>(scratch + _vImageAlignScratch(bandSourceRows * width * 4 * sizeof(int16_t)));
+
+        const size_t firstSourceRow = vertical.starts[firstRow];
+        size_t endSourceRow = firstSourceRow;
+        for (size_t i = firstRow; i < endRow; ++i) {
+            endSourceRow = std::max<size_t>(endSourceRow, vertical.starts[i] + vertical.counts[i]);
+        }
+
+        endSourceRow = std::min(endSourceRow, firstSourceRow + bandSourceRows);
+        for (size_t row = firstSourceRow; row < endSourceRow; ++row) {
+            _vImageResampleRowHorizontal(horizontal, _vImageRowPixels(src, row), intermediate + (row - firstSourceRow) * width * 4, width);
+        }
+
+        for (size_t i = firstRow; i < endRow; ++i) {
+            const int32_t count = vertical.counts[i];
+            for (int32_t t = 0; t < count; ++t) {
+                const size_t row = std::min<size_t>(vertical.starts[i] + t, endSourceRow - 1);
+                rows[t] = intermediate + (row - firstSourceRow) * width * 4;
             }
 
-            temp_buf[(top + below) * dest_rowstride].val[0] = sum[0] > (255 * kernel_height) ? 255 : sum[0] / kernel_height;
-            temp_buf[(top + below) * dest_rowstride].val[1] = sum[1] > (255 * kernel_height) ? 255 : sum[1] / kernel_height;
-            temp_buf[(top + below) * dest_rowstride].val[2] = sum[2] > (255 * kernel_height) ? 255 : sum[2] / kernel_height;
-            temp_buf[(top + below) * dest_rowstride].val[3] = sum[3] > (255 * kernel_height) ? 255 : sum[3] / kernel_height;
-
-            for (int i = 1; i < static_cast<int>(dest->height); ++i) {
-                if (i <= static_cast<int>(start_i)) {
-                    sum[0] -= first_pixel.val[0];
-                    sum[1] -= first_pixel.val[1];
-                    sum[2] -= first_pixel.val[2];
-                    sum[3] -= first_pixel.val[3];
-                } else if (i <= KH_d2) {
-                    sum[0] -= temp_buf[(top + (i - KH_d2 - 1)) * dest_rowstride + j].val[0];
-                    sum[1] -= temp_buf[(top + (i - KH_d2 - 1)) * dest_rowstride + j].val[1];
-                    sum[2] -= temp_buf[(top + (i - KH_d2 - 1)) * dest_rowstride + j].val[2];
-                    sum[3] -= temp_buf[(top + (i - KH_d2 - 1)) * dest_rowstride + j].val[3];
-                } else {
-                    sum[0] -= dest_buf[(i - KH_d2 - 1) * dest_rowstride + j].val[0];
-                    sum[1] -= dest_buf[(i - KH_d2 - 1) * dest_rowstride + j].val[1];
-                    sum[2] -= dest_buf[(i - KH_d2 - 1) * dest_rowstride + j].val[2];
-                    sum[3] -= dest_buf[(i - KH_d2 - 1) * dest_rowstride + j].val[3];
+            _vImageResampleRowVertical(rows, vertical.weights + i * vertical.tapStride, count, _vImageRowPixels(dest, i), width);
+        }
+    });
+
+    return kvImageNoError;
+}
+
+// Fetches a source pixel for resampling; coordinates outside the image give the background or the nearest edge pixel
+static inline const Pixel_8888_s& _vImageEdgePixel(
+    const vImage_Buffer* src, ptrdiff_t x, ptrdiff_t y, bool extendEdges, const Pixel_8888_s& background) {
+    const ptrdiff_t width = static_cast<ptrdiff_t>(src->width);
+    const ptrdiff_t height = static_cast<ptrdiff_t>(src->height);
+    if (x < 0 || y < 0 || x >= width || y >= height) {
+        if (!extendEdges) {
+            return background;
+        }
+
+        x = std::min(std::max<ptrdiff_t>(0, x), width - 1);
+        y = std::min(std::max<ptrdiff_t>(0, y), height - 1);
+    }
+
+    return _vImageRowPixels(src, y)[x];
+}
+
+/**
+@Status Caveat
+@Notes Resamples bilinearly. transform maps source pixel coordinates to destination pixel coordinates, with pixel centers on integers.
+       No temporary buffer is needed, so tempBuffer is ignored and kvImageGetTempBufferSize returns 0.
+*/
+vImage_Error vImageAffineWarp_ARGB8888(const vImage_Buffer* src,
+                                       const vImage_Buffer* dest,
+                                       void* /* tempBuffer */,
+                                       const vImage_AffineTransform* transform,
+                                       const Pixel_8888 backColor,
+                                       vImage_Flags flags) {
+    if (src == nullptr || dest == nullptr || src->data == nullptr || dest->data == nullptr || transform == nullptr) {
+        TraceError(TAG, L"One or more NULL parameters passed in");
+        return kvImageNullPointerArgument;
+    } else if (!(flags & (kvImageBackgroundColorFill | kvImageEdgeExtend))) {
+        return kvImageInvalidEdgeStyle;
+    } else if (!(flags & kvImageEdgeExtend) && (backColor == nullptr)) {
+        return kvImageNullPointerArgument;
+    } else if (src->data == dest->data) {
+        return kvImageOutOfPlaceOperationRequired;
+    }
+
+    if (flags & kvImageGetTempBufferSize) {
+        return 0;
+    }
+
+    //  Sample the source through the inverse transform
+    const double determinant = static_cast<double>(transform->a) * transform->d - static_cast<double>(transform->b) * transform->c;
+    if (determinant == 0.0) {
+        TraceError(TAG, L"Transform is not invertible");
+        return kvImageInvalidParameter;
+    }
+
+    const double inverseA = transform->d / determinant;
+    const double inverseB = -transform->b / determinant;
+    const double inverseC = -transform->c / determinant;
+    const double inverseD = transform->a / determinant;
+    const double inverseX = -(inverseA * transform->tx + inverseC * transform->ty);
+    const double inverseY = -(inverseB * transform->tx + inverseD * transform->ty);
+
+    const bool extendEdges = (flags & kvImageEdgeExtend) != 0;
+    Pixel_8888_s background;
+    memset(&background, 0, sizeof(background));
+    if (!extendEdges) {
+        memcpy(background.val, backColor, sizeof(background.val));
+    }
+
+    const ptrdiff_t srcWidth = static_cast<ptrdiff_t>(src->width);
+    const ptrdiff_t srcHeight = static_cast<ptrdiff_t>(src->height);
+    const size_t bandCount = _vImageRowBandCount(dest->width, dest->height, 16, flags);
+
+    _vImageForEachRowBand(dest->height, bandCount, [&](size_t /* band */, size_t firstRow, size_t endRow) {
+        for (size_t i = firstRow; i < endRow; ++i) {
+            Pixel_8888_s* destPixels = _vImageRowPixels(dest, i);
+            const double rowX = inverseC * i + inverseX;
+            const double rowY = inverseD * i + inverseY;
+
+            for (size_t j = 0; j < dest->width; ++j) {
+                double sx = rowX + inverseA * j;
+                double sy = rowY + inverseB * j;
+                if (extendEdges) {
+                    //  Clamping the sample point is equivalent to clamping each tap
+                    sx = std::min(std::max(0.0, sx), static_cast<double>(srcWidth - 1));
+                    sy = std::min(std::max(0.0, sy), static_cast<double>(srcHeight - 1));
+                }
+
+                const double floorX = std::floor(sx);
+                const double floorY = std::floor(sy);
+
+                //  Bilinear weights in 1.7 fixed point, so each product of two fits the 16-bit multiply-add
+                int32_t fractionX = static_cast<int32_t>((sx - floorX) * 128.0 + 0.5);
+                int32_t fractionY = static_cast<int32_t>((sy - floorY) * 128.0 + 0.5);
+                ptrdiff_t x0 = static_cast<ptrdiff_t>(floorX);
+                ptrdiff_t y0 = static_cast<ptrdiff_t>(floorY);
+                if (fractionX == 128) {
+                    fractionX = 0;
+                    ++x0;
+                }
+
+                if (fractionY == 128) {
+                    fractionY = 0;
+                    ++y0;
+                }
+
+                if (x0 < -1 || y0 < -1 || x0 >= srcWidth || y0 >= srcHeight) {
+                    destPixels[j] = background;
+                    continue;
                 }
 
-                if (i > static_cast<int>(end_i)) {
-                    sum[0] += last_pixel.val[0];
-                    sum[1] += last_pixel.val[1];
-                    sum[2] += last_pixel.val[2];
-                    sum[3] += last_pixel.val[3];
-                } else if (i >= static_cast<int>(dest->height) - KH_d2) {
-                    sum[0] += temp_buf[(top + (i + KH_d2) - dest->height) * dest_rowstride + j].val[0];
-                    sum[1] += temp_buf[(top + (i + KH_d2) - dest->height) * dest_rowstride + j].val[1];
-                    sum[2] += temp_buf[(top + (i + KH_d2) - dest->height) * dest_rowstride + j].val[2];
-                    sum[3] += temp_buf[(top + (i + KH_d2) - dest->height) * dest_rowstride + j].val[3];
+                const int32_t weight00 = (128 - fractionX) * (128 - fractionY);
+                const int32_t weight10 = fractionX * (128 - fractionY);
+                const int32_t weight01 = (128 - fractionX) * fractionY;
+                const int32_t weight11 = fractionX * fractionY;
+
+                const Pixel_8888_s* p00;
+                const Pixel_8888_s* p10;
+                const Pixel_8888_s* p01;
+                const Pixel_8888_s* p11;
+                if (x0 >= 0 && y0 >= 0 && x0 + 1 < srcWidth && y0 + 1 < srcHeight) {
+                    p00 = &_vImageRowPixels(src, y0)[x0];
+                    p10 = p00 + 1;
+                    p01 = &_vImageRowPixels(src, y0 + 1)[x0];
+                    p11 = p01 + 1;
                 } else {
-                    sum[0] += dest_buf[(i + KH_d2) * dest_rowstride + j].val[0];
-                    sum[1] += dest_buf[(i + KH_d2) * dest_rowstride + j].val[1];
-                    sum[2] += dest_buf[(i + KH_d2) * dest_rowstride + j].val[2];
-                    sum[3] += dest_buf[(i + KH_d2) * dest_rowstride + j].val[3];
+                    p00 = &_vImageEdgePixel(src, x0, y0, extendEdges, background);
+                    p10 = &_vImageEdgePixel(src, x0 + 1, y0, extendEdges, background);
+                    p01 = &_vImageEdgePixel(src, x0, y0 + 1, extendEdges, background);
+                    p11 = &_vImageEdgePixel(src, x0 + 1, y0 + 1, extendEdges, background);
                 }
 
-                temp_buf[(top + below) * dest_rowstride + i].val[0] = sum[0] > (255 * kernel_height) ? 255 : sum[0] / kernel_height;
-                temp_buf[(top + below) * dest_rowstride + i].val[1] = sum[1] > (255 * kernel_height) ? 255 : sum[1] / kernel_height;
-                temp_buf[(top + below) * dest_rowstride + i].val[2] = sum[2] > (255 * kernel_height) ? 255 : sum[2] / kernel_height;
-                temp_buf[(top + below) * dest_rowstride + i].val[3] = sum[3] > (255 * kernel_height) ? 255 : sum[3] / kernel_height;
-            }
+#if (VIMAGE_SSE == 1)
+                if (c_vImageUseSse2 == true) {
+                    const __m128i vZero = _mm_setzero_si128();
+                    const __m128i vTop = _mm_unpacklo_epi8(_mm_unpacklo_epi8(_mm_cvtsi32_si128(*reinterpret_cast<const int32_t*>(p00)),
+                                                                             _mm_cvtsi32_si128(*reinterpret_cast<const int32_t*>(p10))),
+                                                           vZero);
+                    const __m128i vBottom = _mm_unpacklo_epi8(_mm_unpacklo_epi8(_mm_cvtsi32_si128(*reinterpret_cast<const int32_t*>(p01)),
+                                                                                _mm_cvtsi32_si128(*reinterpret_cast<const int32_t*>(p11))),
+                                                              vZero);
+                    __m128i vSum = _mm_add_epi32(_mm_madd_epi16(vTop, _mm_set1_epi32(weight00 | (weight10 << 16))),
+                                                 _mm_madd_epi16(vBottom, _mm_set1_epi32(weight01 | (weight11 << 16))));
+                    vSum = _mm_srli_epi32(_mm_add_epi32(vSum, _mm_set1_epi32(1 << 13)), 14);
+                    const __m128i vPacked = _mm_packs_epi32(vSum, vZero);
+                    *reinterpret_cast<int32_t*>(&destPixels[j]) = _mm_cvtsi128_si32(_mm_packus_epi16(vPacked, vPacked));
+                    continue;
+                }
+#endif
 
-            for (uint32_t i = 0; i < dest->height; ++i) {
-                dest_buf[i * dest_rowstride + j] = temp_buf[(top + below) * dest_rowstride + i];
+                for (size_t k = 0; k < 4; ++k) {
+                    destPixels[j].val[k] = static_cast<uint8_t>(
+                        (p00->val[k] * weight00 + p10->val[k] * weight10 + p01->val[k] * weight01 + p11->val[k] * weight11 + (1 << 13)) >> 14);
+                }
             }
         }
-    } else {
-        return kvImageUnknownFlagsBit;
-    }
-
-    //  Deallocating the temporary buffer
-    if (tempBuffer_flag == 1) {
-        delete[] temp_buf;
-    }
+    });
 
     return kvImageNoError;
 }
@@ -25,6 +25,11 @@
 
 #include <cassowary-0.60/ClSimplexSolver.h>
 #include <cassowary-0.60/ClLinearEquation.h>
+#include <cassowary-0.60/ClEditConstraint.h>
+
+#include <algorithm>
+#include <memory>
+#include <vector>
 
 enum AutoLayoutDirection {
     Horizontal,
@@ -33,7 +38,89 @@ enum AutoLayoutDirection {
     NumDirections
 };
 
-static ClSimplexSolver c_solver;
+// The tableau for one island of items that constraints connect. An item gets an island of its own with its first constraint,
+// and two islands merge when a constraint spans them, so editing one table cell never pivots rows that belong to another.
+// Solving is deferred until a value is read or a frame is suggested, so constraints added during a layout pass cost one solve.
+class AutoLayoutSolver {
+public:
+    AutoLayoutSolver() {
+        _solver.SetAutosolve(false);
+    }
+
+    // Follows merges to the solver that currently owns the island, updating the caller's reference on the way
+    static AutoLayoutSolver& Current(std::shared_ptr<AutoLayoutSolver>& solver) {
+        while (solver->_mergedInto) {
+            solver = solver->_mergedInto;
+        }
+
+        return *solver;
+    }
+
+    // Moves the smaller island's constraints into the larger one's tableau; both references end up at the survivor
+    static void Merge(std::shared_ptr<AutoLayoutSolver>& first, std::shared_ptr<AutoLayoutSolver>& second) {
+        Current(first);
+        Current(second);
+        if (first == second) {
+            return;
+        }
+
+        const bool intoFirst = first->_constraints.size() >= second->_constraints.size();
+        std::shared_ptr<AutoLayoutSolver> into = intoFirst ? first : second;
+        std::shared_ptr<AutoLayoutSolver> from = intoFirst ? second : first;
+
+        // Stays and edits are re-anchored at the values the absorbed island last solved to
+        from->Solve();
+        for (ClConstraint* constraint : from->_constraints) {
+            from->_solver.RemoveConstraint(constraint);
+            into->_solver.AddConstraint(constraint);
+        }
+
+        into->_constraints.insert(into->_constraints.end(), from->_constraints.begin(), from->_constraints.end());
+        from->_constraints.clear();
+        from->_mergedInto = into;
+
+        first = into;
+        second = into;
+    }
+
+    void AddConstraint(ClConstraint* constraint) {
+        _solver.AddConstraint(constraint);
+        _constraints.push_back(constraint);
+    }
+
+    void RemoveConstraint(ClConstraint* constraint) {
+        _solver.RemoveConstraint(constraint);
+        _constraints.erase(std::find(_constraints.begin(), _constraints.end(), constraint));
+    }
+
+    void ChangeWeight(ClConstraint* constraint, double weight) {
+        // The tableau only re-optimizes a weight change while autosolving
+        _solver.SetAutosolve(true);
+        _solver.ChangeWeight(constraint, weight);
+        _solver.SetAutosolve(false);
+    }
+
+    // Suggests a new value for a variable held by an edit constraint; Resolve applies every suggestion at once
+    void SuggestValue(ClVariable variable, double value) {
+        _solver.Solve();
+        _solver.SuggestValue(variable, value);
+    }
+
+    void Resolve() {
+        _solver.Resolve();
+    }
+
+    void Solve() {
+        _solver.Solve();
+    }
+
+private:
+    ClSimplexSolver _solver;
+
+    // Kept in the order they were added, so a merged tableau is built the way a single solver would have been
+    std::vector<ClConstraint*> _constraints;
+    std::shared_ptr<AutoLayoutSolver> _mergedInto;
+};
 
 // Just to ensure linkage
 extern "C" bool InitializeAutoLayout() {
@@ -48,7 +135,11 @@ public:
           _stays{ ClStayConstraint(_vars[Left], ClsStrong()),
                   ClStayConstraint(_vars[Right], ClsStrong()),
                   ClStayConstraint(_vars[Top], ClsStrong()),
-                  ClStayConstraint(_vars[Bottom], ClsStrong()) } {
+                  ClStayConstraint(_vars[Bottom], ClsStrong()) },
+          _edits{ ClEditConstraint(_vars[Left], ClsStrong(), 2.0),
+                  ClEditConstraint(_vars[Right], ClsStrong(), 2.0),
+                  ClEditConstraint(_vars[Top], ClsStrong(), 2.0),
+                  ClEditConstraint(_vars[Bottom], ClsStrong(), 2.0) } {
         _staysAdded = false;
         _associatedConstraints = [NSMutableArray new];
     }
@@ -57,8 +148,8 @@ public:
         RemoveStays();
         for (int i = 0; i < NumDirections; i++) {
             if (_contentHuggingConstraint[i].FIsInSolver()) {
-                c_solver.RemoveConstraint(&_contentHuggingConstraint[i]);
-                c_solver.RemoveConstraint(&_contentCompressionResistanceConstraint[i]);
+                Solver().RemoveConstraint(&_contentHuggingConstraint[i]);
+                Solver().RemoveConstraint(&_contentCompressionResistanceConstraint[i]);
             }
         }
         [_associatedConstraints release];
@@ -71,21 +162,53 @@ public:
 
             // In the paper all stays should be weak, but I don't think we're using them the same way.
             // If they're weak, they just end up getting pushed around by the edit vars.
-            c_solver.AddConstraint(_stays[Left]);
-            c_solver.AddConstraint(_stays[Right]);
-            c_solver.AddConstraint(_stays[Top]);
-            c_solver.AddConstraint(_stays[Bottom]);
+            // The edit vars stay in the solver for as long as the stays do, so frame changes are only a suggest and resolve.
+            for (int i = Left; i <= Bottom; i++) {
+                Solver().AddConstraint(&_stays[i]);
+                Solver().AddConstraint(&_edits[i]);
+            }
         }
     }
 
     void RemoveStays() {
         if (_staysAdded) {
             _staysAdded = false;
-            c_solver.RemoveConstraint(&_stays[Left]);
-            c_solver.RemoveConstraint(&_stays[Right]);
-            c_solver.RemoveConstraint(&_stays[Top]);
-            c_solver.RemoveConstraint(&_stays[Bottom]);
+            for (int i = Left; i <= Bottom; i++) {
+                Solver().RemoveConstraint(&_edits[i]);
+                Solver().RemoveConstraint(&_stays[i]);
+            }
+        }
+    }
+
+    // Items only get a tableau with their first constraint, since most views never take part in any
+    AutoLayoutSolver& Solver() {
+        if (!_solver) {
+            _solver = std::make_shared<AutoLayoutSolver>();
+        }
+
+        return AutoLayoutSolver::Current(_solver);
+    }
+
+    // Brings the variables up to date with any constraints added since the island was last solved
+    void Solve() {
+        if (_solver) {
+            Solver().Solve();
+        }
+    }
+
+    // Puts two items in one island; an item without a tableau yet joins the other's
+    static void Join(AutoLayoutProperties& first, AutoLayoutProperties& second) {
+        if (!first._solver && !second._solver) {
+            first.Solver();
+        }
+        if (!first._solver) {
+            first._solver = second._solver;
+        }
+        if (!second._solver) {
+            second._solver = first._solver;
         }
+
+        AutoLayoutSolver::Merge(first._solver, second._solver);
     }
 
     enum {
@@ -97,11 +220,14 @@ public:
 
     ClVariable _vars[4];
     ClStayConstraint _stays[4];
+    ClEditConstraint _edits[4];
     bool _staysAdded;
     ClLinearInequality _contentHuggingConstraint[NumDirections];
     ClLinearInequality _contentCompressionResistanceConstraint[NumDirections];
 
     NSMutableArray* _associatedConstraints;
+
+    std::shared_ptr<AutoLayoutSolver> _solver;
 };
 
 // Since categories can't have ivars, we bundle up a couple C++ classes in NSObjects and associate them to the UIView/UILayoutGuide/NSLayoutConstraint
@@ -121,6 +247,7 @@ public:
 @interface _NSLayoutConstraintStorage : NSObject {
 @public
     ClConstraint* _constraint;
+    std::shared_ptr<AutoLayoutSolver> _solver;
 }
 @end
 
@@ -151,6 +278,7 @@ public:
     if (!constraintStorage->_constraint) {
         // TODO: Care about reading direction.
         ClLinearExpression lex[2];
+        AutoLayoutProperties* itemProperties[2] = {};
         UIView* items[] = { self.firstItem, self.secondItem };
         int attributes[] = { self.firstAttribute, self.secondAttribute };
 
@@ -172,6 +300,7 @@ public:
             }
 
             auto layoutProps = item._autoLayoutProperties;
+            itemProperties[n] = layoutProps;
 
             switch (attribute) {
                 case NSLayoutAttributeLeading:
@@ -269,8 +398,13 @@ public:
                 assert(0);
         }
 
-        c_solver.AddConstraint(constraintStorage->_constraint);
+        if (itemProperties[1]) {
+            AutoLayoutProperties::Join(*itemProperties[0], *itemProperties[1]);
+        }
 
+        AutoLayoutSolver& solver = itemProperties[0]->Solver();
+        constraintStorage->_solver = itemProperties[0]->_solver;
+        solver.AddConstraint(constraintStorage->_constraint);
     }
 }
 
@@ -301,10 +435,11 @@ public:
     _NSLayoutConstraintStorage* constraintStorage = [self _constraintStorage];
     if (constraintStorage->_constraint) {
         if (constraintStorage->_constraint->FIsInSolver()) {
-            c_solver.RemoveConstraint(constraintStorage->_constraint);
+            AutoLayoutSolver::Current(constraintStorage->_solver).RemoveConstraint(constraintStorage->_constraint);
         }
         delete constraintStorage->_constraint;
         constraintStorage->_constraint = NULL;
+        constraintStorage->_solver = nullptr;
     }
 }
 @end
@@ -317,6 +452,7 @@ public:
 
 - (CGRect)autoLayoutGetRect {
     AutoLayoutProperties* autoLayoutProperties = self._autoLayoutProperties;
+    autoLayoutProperties->Solve();
 
     float left = (float)autoLayoutProperties->_vars[AutoLayoutProperties::Left].Value();
     float top = (float)autoLayoutProperties->_vars[AutoLayoutProperties::Top].Value();
@@ -340,6 +476,7 @@ public:
 
 - (CGRect)autoLayoutGetRect {
     AutoLayoutProperties* autoLayoutProperties = self._autoLayoutProperties;
+    autoLayoutProperties->Solve();
 
     float left = (float)autoLayoutProperties->_vars[AutoLayoutProperties::Left].Value();
     float top = (float)autoLayoutProperties->_vars[AutoLayoutProperties::Top].Value();
@@ -366,6 +503,7 @@ public:
     CGPoint oldPointBR;
 
     AutoLayoutProperties* autoLayoutProperties = self._autoLayoutProperties;
+    autoLayoutProperties->Solve();
 
     oldPointTL.x = (float)autoLayoutProperties->_vars[AutoLayoutProperties::Left].Value();
     oldPointTL.y = (float)autoLayoutProperties->_vars[AutoLayoutProperties::Top].Value();
@@ -419,8 +557,8 @@ public:
 
     if (contentSize.width == -1.0f /*UIViewNoIntrinsicMetric*/ || contentSize.width == 0) {
         if (layoutProperties->_contentHuggingConstraint[Horizontal].FIsInSolver()) {
-            c_solver.RemoveConstraint(&layoutProperties->_contentHuggingConstraint[Horizontal]);
-            c_solver.RemoveConstraint(&layoutProperties->_contentCompressionResistanceConstraint[Horizontal]);
+            layoutProperties->Solver().RemoveConstraint(&layoutProperties->_contentHuggingConstraint[Horizontal]);
+            layoutProperties->Solver().RemoveConstraint(&layoutProperties->_contentCompressionResistanceConstraint[Horizontal]);
         }
     } else {
         if (layoutProperties->_contentHuggingConstraint[Horizontal].FIsInSolver()) {
@@ -429,12 +567,12 @@ public:
                 layoutProperties->_contentCompressionResistanceConstraint[Horizontal].ChangeConstant(contentSize.width);
             }
             if ([self contentHuggingPriorityForAxis:UILayoutConstraintAxisHorizontal] != layoutProperties->_contentHuggingConstraint[Horizontal].weight()) {
-                c_solver.ChangeWeight(&layoutProperties->_contentHuggingConstraint[Horizontal], [self contentHuggingPriorityForAxis:UILayoutConstraintAxisHorizontal]);
+                layoutProperties->Solver().ChangeWeight(&layoutProperties->_contentHuggingConstraint[Horizontal], [self contentHuggingPriorityForAxis:UILayoutConstraintAxisHorizontal]);
             }
             if ([self contentCompressionResistancePriorityForAxis:UILayoutConstraintAxisHorizontal] !=
                 layoutProperties->_contentCompressionResistanceConstraint[Horizontal].weight()) {
-                c_solver.ChangeWeight(&layoutProperties->_contentCompressionResistanceConstraint[Horizontal],
-                                     [self contentCompressionResistancePriorityForAxis:UILayoutConstraintAxisHorizontal]);
+                layoutProperties->Solver().ChangeWeight(&layoutProperties->_contentCompressionResistanceConstraint[Horizontal],
+                                                      [self contentCompressionResistancePriorityForAxis:UILayoutConstraintAxisHorizontal]);
             }
         }
         if (!layoutProperties->_contentHuggingConstraint[Horizontal].FIsInSolver()) {
@@ -452,14 +590,14 @@ public:
                                    contentSize.width,
                                    ClsWeak(),
                                    [self contentCompressionResistancePriorityForAxis:UILayoutConstraintAxisHorizontal]);
-            c_solver.AddConstraint(&layoutProperties->_contentHuggingConstraint[Horizontal]);
-            c_solver.AddConstraint(&layoutProperties->_contentCompressionResistanceConstraint[Horizontal]);
+            layoutProperties->Solver().AddConstraint(&layoutProperties->_contentHuggingConstraint[Horizontal]);
+            layoutProperties->Solver().AddConstraint(&layoutProperties->_contentCompressionResistanceConstraint[Horizontal]);
         }
     }
     if (contentSize.height == -1.0f /*UIViewNoIntrinsicMetric*/ || contentSize.height == 0) {
         if (layoutProperties->_contentHuggingConstraint[Vertical].FIsInSolver()) {
-            c_solver.RemoveConstraint(&layoutProperties->_contentHuggingConstraint[Vertical]);
-            c_solver.RemoveConstraint(&layoutProperties->_contentCompressionResistanceConstraint[Vertical]);
+            layoutProperties->Solver().RemoveConstraint(&layoutProperties->_contentHuggingConstraint[Vertical]);
+            layoutProperties->Solver().RemoveConstraint(&layoutProperties->_contentCompressionResistanceConstraint[Vertical]);
         }
     } else {
         if (layoutProperties->_contentHuggingConstraint[Vertical].FIsInSolver()) {
@@ -468,12 +606,12 @@ public:
                 layoutProperties->_contentCompressionResistanceConstraint[Vertical].ChangeConstant(contentSize.height);
             }
             if ([self contentHuggingPriorityForAxis:UILayoutConstraintAxisVertical] != layoutProperties->_contentHuggingConstraint[Vertical].weight()) {
-                c_solver.ChangeWeight(&layoutProperties->_contentHuggingConstraint[Vertical], [self contentHuggingPriorityForAxis:UILayoutConstraintAxisVertical]);
+                layoutProperties->Solver().ChangeWeight(&layoutProperties->_contentHuggingConstraint[Vertical], [self contentHuggingPriorityForAxis:UILayoutConstraintAxisVertical]);
             }
             if ([self contentCompressionResistancePriorityForAxis:UILayoutConstraintAxisVertical] !=
                 layoutProperties->_contentCompressionResistanceConstraint[Vertical].weight()) {
-                c_solver.ChangeWeight(&layoutProperties->_contentCompressionResistanceConstraint[Vertical],
-                                     [self contentCompressionResistancePriorityForAxis:UILayoutConstraintAxisVertical]);
+                layoutProperties->Solver().ChangeWeight(&layoutProperties->_contentCompressionResistanceConstraint[Vertical],
+                                                      [self contentCompressionResistancePriorityForAxis:UILayoutConstraintAxisVertical]);
             }
         }
         if (!layoutProperties->_contentHuggingConstraint[Vertical].FIsInSolver()) {
@@ -491,8 +629,8 @@ public:
                                    contentSize.height,
                                    ClsWeak(),
                                    [self contentCompressionResistancePriorityForAxis:UILayoutConstraintAxisVertical]);
-            c_solver.AddConstraint(&layoutProperties->_contentHuggingConstraint[Vertical]);
-            c_solver.AddConstraint(&layoutProperties->_contentCompressionResistanceConstraint[Vertical]);
+            layoutProperties->Solver().AddConstraint(&layoutProperties->_contentHuggingConstraint[Vertical]);
+            layoutProperties->Solver().AddConstraint(&layoutProperties->_contentCompressionResistanceConstraint[Vertical]);
         }
     }
 }
@@ -531,30 +669,28 @@ public:
             
         convFrame = [self convertRect:curBounds toView:[self autolayoutRoot]];
 
-        if ((layoutProperties->_vars[AutoLayoutProperties::Right].Value() != convFrame.origin.x + convFrame.size.width) ||
-            (layoutProperties->_vars[AutoLayoutProperties::Left].Value() != convFrame.origin.x)) {
+        AutoLayoutSolver& solver = layoutProperties->Solver();
+        bool suggested = false;
 
-            c_solver.AddEditVar(layoutProperties->_vars[AutoLayoutProperties::Right], ClsStrong(), 2.0);
-            c_solver.AddEditVar(layoutProperties->_vars[AutoLayoutProperties::Left], ClsStrong(), 2.0);
+        // Compare against solved values, since constraints may have been added since the island was last solved
+        solver.Solve();
 
-            c_solver.BeginEdit();
-            c_solver.SuggestValue(layoutProperties->_vars[AutoLayoutProperties::Right], convFrame.origin.x + convFrame.size.width);
-            c_solver.SuggestValue(layoutProperties->_vars[AutoLayoutProperties::Left], convFrame.origin.x);
-            c_solver.Resolve();
-            c_solver.EndEdit(); // Removes edit constraints.    
+        if ((layoutProperties->_vars[AutoLayoutProperties::Right].Value() != convFrame.origin.x + convFrame.size.width) ||
+            (layoutProperties->_vars[AutoLayoutProperties::Left].Value() != convFrame.origin.x)) {
+            solver.SuggestValue(layoutProperties->_vars[AutoLayoutProperties::Right], convFrame.origin.x + convFrame.size.width);
+            solver.SuggestValue(layoutProperties->_vars[AutoLayoutProperties::Left], convFrame.origin.x);
+            suggested = true;
         }
 
         if ((layoutProperties->_vars[AutoLayoutProperties::Bottom].Value() != convFrame.origin.y + convFrame.size.height) ||
             (layoutProperties->_vars[AutoLayoutProperties::Top].Value() != convFrame.origin.y)) {
+            solver.SuggestValue(layoutProperties->_vars[AutoLayoutProperties::Bottom], convFrame.origin.y + convFrame.size.height);
+            solver.SuggestValue(layoutProperties->_vars[AutoLayoutProperties::Top], convFrame.origin.y);
+            suggested = true;
+        }
 
-            c_solver.AddEditVar(layoutProperties->_vars[AutoLayoutProperties::Bottom], ClsStrong(), 2.0);
-            c_solver.AddEditVar(layoutProperties->_vars[AutoLayoutProperties::Top], ClsStrong(), 2.0);
-
-            c_solver.BeginEdit();
-            c_solver.SuggestValue(layoutProperties->_vars[AutoLayoutProperties::Bottom], convFrame.origin.y + convFrame.size.height);
-            c_solver.SuggestValue(layoutProperties->_vars[AutoLayoutProperties::Top], convFrame.origin.y);
-            c_solver.Resolve();
-            c_solver.EndEdit(); // Removes edit constraints. 
+        if (suggested) {
+            solver.Resolve();
         }
     } else {
         [self autoLayoutInvalidateContentSize];
@@ -18,6 +18,9 @@
 #import <StubReturn.h>
 #import <Starboard.h>
 #import <math.h>
+#import <algorithm>
+#import <system_error>
+#import <thread>
 #import <vector>
 #import <CoreGraphics/CGContext.h>
 #import <CoreGraphics/CGGeometry.h>
@@ -27,19 +30,11 @@
 #import "CGImageInternal.h"
 #import "_CGLifetimeBridgingType.h"
 #import "CGSurfaceInfoInternal.h"
+#import "CGPixelConverters.h"
 
 extern "C" {
 #import <png.h>
-};
-
-// This is the format libpng expects.
-struct _RGBA_swizzle {
-    BYTE r, g, b, a;
-};
-
-// This is what comes out of pixman.
-struct _BGRA_swizzle {
-    BYTE b, g, r, a;
+#import <zlib.h>
 };
 
 #include "LoggingNative.h"
@@ -249,9 +244,29 @@ CGImageRef CGImageCreateCopy(CGImageRef ref) {
 
 /**
  @Status Caveat
- @Notes No actual conversion between colorspaces, simply copies and reinterprets data in new colorspace
+ @Notes Grayscale images are expanded to RGB; otherwise no actual conversion between colorspaces, simply copies and
+        reinterprets data in new colorspace
 */
 CGImageRef CGImageCreateCopyWithColorSpace(CGImageRef ref, CGColorSpaceRef colorSpace) {
+    if ((ref->Backing()->SurfaceFormat() == _ColorGrayscale) && (((__CGColorSpace*)colorSpace)->colorSpaceModel == kCGColorSpaceModelRGB)) {
+        CGImageRef newImage = new CGBitmapImage(_CGSurfaceInfoInit(ref->Backing()->Width(), ref->Backing()->Height(), _ColorXBGR));
+
+        const BYTE* srcIn = (const BYTE*)ref->Backing()->LockImageData();
+        BYTE* destOut = (BYTE*)newImage->Backing()->LockImageData();
+
+        for (int curY = 0; curY < ref->Backing()->Height(); curY++) {
+            _CGPixelGrayToRGBA(destOut, srcIn, ref->Backing()->Width());
+
+            srcIn += ref->Backing()->BytesPerRow();
+            destOut += newImage->Backing()->BytesPerRow();
+        }
+
+        ref->Backing()->ReleaseImageData();
+        newImage->Backing()->ReleaseImageData();
+
+        return newImage;
+    }
+
     __CGSurfaceInfo surfaceInfo;
     ref->Backing()->GetSurfaceInfoWithoutPixelPtr(&surfaceInfo);
 
@@ -619,8 +634,8 @@ size_t CGImageGetBytesPerRow(CGImageRef img) {
 
 /**
  @Status Caveat
- @Notes Limited bitmap formats available. Decode, shouldInterpolate, intent parameters
-        and some byte orders ignored.
+ @Notes Limited bitmap formats available; 16-bit components are rounded to 8 bits. Decode, shouldInterpolate,
+        intent parameters and some byte orders ignored.
 */
 CGImageRef CGImageCreate(size_t width,
                          size_t height,
@@ -655,10 +670,39 @@ CGImageRef CGImageCreate(size_t width,
         colorSpaceAllocated = true;
     }
 
+    //  There are no 16-bit surfaces: 16-bit components are rounded to 8 bits, kept in the order they're in
+    const CGColorSpaceModel colorSpaceModel = ((__CGColorSpace*)colorSpace)->colorSpaceModel;
+    const bool narrow = (bitsPerComponent == 16) && ((colorSpaceModel == kCGColorSpaceModelRGB && bitsPerPixel == 64) ||
+                                                     (colorSpaceModel == kCGColorSpaceModelMonochrome && bitsPerPixel == 16));
+    const bool littleEndian = (bitmapInfo & kCGBitmapByteOrderMask) == kCGBitmapByteOrder16Little;
+    if (narrow) {
+        bitsPerComponent = 8;
+        bitsPerPixel /= 2;
+        bitmapInfo = (bitmapInfo & ~kCGBitmapByteOrderMask) | kCGBitmapByteOrder32Big;
+    }
+
     __CGSurfaceFormat format = _CGImageGetFormat(bitsPerComponent, bitsPerPixel, colorSpace, bitmapInfo);
 
-    if (format != _ColorIndexed) {
-        __CGSurfaceInfo surfaceInfo = __CGSurfaceInfo(((__CGColorSpace*)colorSpace)->colorSpaceModel,
+    if (narrow) {
+        __CGSurfaceInfo surfaceInfo =
+            __CGSurfaceInfo(colorSpaceModel, bitmapInfo, bitsPerComponent, bitsPerPixel >> 3, width, height, 0, NULL, format);
+
+        newImage = new CGBitmapImage(surfaceInfo);
+        BYTE* curPosOut = (BYTE*)newImage->Backing()->LockImageData();
+        int stride = newImage->Backing()->BytesPerRow();
+
+        CGPixelRowConverter narrowRow = littleEndian ? _CGPixelNarrow16<false> : _CGPixelNarrow16<true>;
+        const size_t components = width * (bitsPerPixel >> 3);
+        const BYTE* curPosIn = (const BYTE*)data;
+        for (unsigned y = 0; y < height; y++) {
+            narrowRow(curPosOut, curPosIn, components);
+            curPosOut += stride;
+            curPosIn += bytesPerRow;
+        }
+
+        newImage->Backing()->ReleaseImageData();
+    } else if (format != _ColorIndexed) {
+        __CGSurfaceInfo surfaceInfo = __CGSurfaceInfo(colorSpaceModel,
                                                       bitmapInfo,
                                                       bitsPerComponent,
                                                       bitsPerPixel >> 3,
@@ -673,30 +717,16 @@ CGImageRef CGImageCreate(size_t width,
         __CGSurfaceInfo surfaceInfo = _CGSurfaceInfoInit(width, height, _ColorBGR);
 
         newImage = new CGBitmapImage(surfaceInfo);
-        void* pData = newImage->Backing()->LockImageData();
+        BYTE* curPosOut = (BYTE*)newImage->Backing()->LockImageData();
         int stride = newImage->Backing()->BytesPerRow();
 
-        char* curPosOut = (char*)pData;
-        char* curPosIn = (char*)data;
-        for (unsigned y = 0; y < height; y++) {
-            char* curLineOut = curPosOut;
-            char* curLineIn = curPosIn;
-            for (unsigned x = 0; x < width; x++) {
-                BYTE c = *curLineIn;
-
-                if (c <= ((__CGColorSpace*)colorSpace)->lastColor) {
-                    BYTE* palette = (BYTE*)&((__CGColorSpace*)colorSpace)->palette[c * 3];
-                    *(curLineOut++) = *(palette++);
-                    *(curLineOut++) = *(palette++);
-                    *(curLineOut++) = *(palette++);
-                } else {
-                    *(curLineOut++) = 0;
-                    *(curLineOut++) = 0;
-                    *(curLineOut++) = 0;
-                }
-                curLineIn++;
-            }
+        //  Indices past the color table are black
+        __CGColorSpace* indexedColorSpace = (__CGColorSpace*)colorSpace;
+        const CGPixelPalette palette((const uint8_t*)indexedColorSpace->palette, std::max(indexedColorSpace->lastColor + 1, 0));
 
+        const BYTE* curPosIn = (const BYTE*)data;
+        for (unsigned y = 0; y < height; y++) {
+            _CGPixelExpandPalette(curPosOut, curPosIn, width, palette);
             curPosOut += stride;
             curPosIn += width;
         }
@@ -719,6 +749,222 @@ static void PNGWriteFunc(png_structp png_ptr, png_bytep data, png_size_t length)
     [dataOut appendBytes:data length:length];
 }
 
+// The PNG pixel layout a backing format is written as, and the row converter that produces it
+struct _CGImagePNGLayout {
+    CGPixelRowConverter convert;
+    int colorType;
+    size_t bytesPerPixel;
+};
+
+static void _CGImageSwapRedBlueUnpremultiplied(uint8_t* dest, const uint8_t* src, size_t count) {
+    _CGPixelSwapRedBlue32(dest, src, count);
+    _CGPixelUnpremultiply32(dest, dest, count);
+}
+
+static bool _CGImageGetPNGLayout(__CGSurfaceFormat format, CGBitmapInfo bitmapInfo, _CGImagePNGLayout* layout) {
+    //  PNG stores color unassociated with alpha
+    const CGBitmapInfo alphaInfo = bitmapInfo & kCGBitmapAlphaInfoMask;
+    const bool premultiplied = (alphaInfo == kCGImageAlphaPremultipliedFirst) || (alphaInfo == kCGImageAlphaPremultipliedLast);
+
+    switch (format) {
+        // PIXMAN_g8 | PIXMAN_a8
+        case _ColorGrayscale:
+        case _ColorA8:
+            *layout = { _CGPixelCopy<1>, PNG_COLOR_TYPE_GRAY, 1 };
+            return true;
+
+        // PIXMAN_b8g8r8
+        case _ColorBGR:
+            *layout = { _CGPixelCopy<3>, PNG_COLOR_TYPE_RGB, 3 };
+            return true;
+
+        // PIXMAN_r5g6b5
+        case _Color565:
+            *layout = { _CGPixel565ToRGB, PNG_COLOR_TYPE_RGB, 3 };
+            return true;
+
+        // PIXMAN_a8r8g8b8
+        case _ColorARGB:
+            *layout = { premultiplied ? _CGImageSwapRedBlueUnpremultiplied : _CGPixelSwapRedBlue32, PNG_COLOR_TYPE_RGB_ALPHA, 4 };
+            return true;
+
+        // PIXMAN_a8b8g8r8
+        case _ColorABGR:
+            *layout = { premultiplied ? _CGPixelUnpremultiply32 : _CGPixelCopy<4>, PNG_COLOR_TYPE_RGB_ALPHA, 4 };
+            return true;
+
+        // PIXMAN_x8b8g8r8 | PIXMAN_b8g8r8x8
+        case _ColorXBGR:
+        case _ColorBGRX:
+            *layout = { _CGPixelCopy<4>, PNG_COLOR_TYPE_RGB_ALPHA, 4 };
+            return true;
+
+        default:
+            // Any other backing formats are outside the scope of libpng, and extremely unlikely to be used.
+            return false;
+    }
+}
+
+// The rows of an image, as they're written: oriented, and converted to the PNG layout
+struct _CGImagePNGSource {
+    const BYTE* data;
+    ptrdiff_t xStride;
+    ptrdiff_t yStride;
+    size_t width;
+    size_t height;
+    size_t bytesPerPixel;
+    _CGImagePNGLayout layout;
+
+    // Converts row y into out, through gather when the orientation leaves the row's pixels apart in memory
+    void ReadRow(size_t y, uint8_t* gather, uint8_t* out) const {
+        const BYTE* row = data + static_cast<ptrdiff_t>(y) * yStride;
+        if (xStride == static_cast<ptrdiff_t>(bytesPerPixel)) {
+            layout.convert(out, row, width);
+            return;
+        }
+
+        for (size_t x = 0; x < width; x++) {
+            memcpy(gather + x * bytesPerPixel, row + static_cast<ptrdiff_t>(x) * xStride, bytesPerPixel);
+        }
+        layout.convert(out, gather, width);
+    }
+};
+
+// Image data is deflated in bands of rows on separate threads. Each band is flushed to a byte boundary so that the bands
+// concatenate into one zlib stream, and each starts with its deflate window primed with the filtered rows before it, as a
+// single stream's would be, so that splitting the image costs little in size.
+static const size_t c_PNGMinBytesPerBand = 256 * 1024;
+static const size_t c_PNGMaxBands = 16;
+static const size_t c_PNGWindowSize = 32 * 1024;
+
+struct _CGImagePNGBand {
+    std::vector<uint8_t> deflated;
+    uLong adler = adler32(0, Z_NULL, 0);
+    size_t length = 0;
+    bool failed = false;
+};
+
+// Deflates filtered bytes onto out, flushing as asked
+static bool _CGImageDeflate(z_stream& stream, const uint8_t* data, size_t length, int flush, std::vector<uint8_t>& out) {
+    uint8_t buffer[16 * 1024];
+    stream.next_in = const_cast<Bytef*>(data);
+    stream.avail_in = static_cast<uInt>(length);
+    do {
+        stream.next_out = buffer;
+        stream.avail_out = sizeof(buffer);
+        if (deflate(&stream, flush) == Z_STREAM_ERROR) {
+            return false;
+        }
+        out.insert(out.end(), buffer, buffer + sizeof(buffer) - stream.avail_out);
+    } while (stream.avail_out == 0);
+
+    return true;
+}
+
+static void _CGImageDeflatePNGBand(const _CGImagePNGSource& source, size_t firstRow, size_t endRow, bool last, _CGImagePNGBand& band) {
+    const size_t rowBytes = source.width * source.layout.bytesPerPixel;
+    const size_t filteredBytes = rowBytes + 1;
+
+    std::vector<uint8_t> scratch(7 * rowBytes + source.width * source.bytesPerPixel + filteredBytes);
+    uint8_t* prior = scratch.data();
+    uint8_t* row = prior + rowBytes;
+    uint8_t* candidates = row + rowBytes;
+    uint8_t* gather = candidates + 4 * rowBytes;
+    uint8_t* filtered = gather + source.width * source.bytesPerPixel;
+
+    //  Filter the rows ahead of the band that fill the window, to prime it
+    const size_t primeRows = std::min(firstRow, (c_PNGWindowSize + filteredBytes - 1) / filteredBytes);
+    size_t y = firstRow - primeRows;
+    if (y > 0) {
+        source.ReadRow(y - 1, gather, prior);
+    }
+
+    std::vector<uint8_t> window;
+    window.reserve(primeRows * filteredBytes);
+    for (; y < firstRow; y++) {
+        source.ReadRow(y, gather, row);
+        _CGPixelFilterPNGRow(row, prior, rowBytes, source.layout.bytesPerPixel, candidates, filtered);
+        window.insert(window.end(), filtered, filtered + filteredBytes);
+        std::swap(prior, row);
+    }
+
+    z_stream stream = {};
+    if (deflateInit2(&stream, Z_DEFAULT_COMPRESSION, Z_DEFLATED, -MAX_WBITS, 8, Z_DEFAULT_STRATEGY) != Z_OK) {
+        band.failed = true;
+        return;
+    }
+
+    const size_t windowBytes = std::min(window.size(), c_PNGWindowSize);
+    if (windowBytes > 0) {
+        deflateSetDictionary(&stream, window.data() + window.size() - windowBytes, static_cast<uInt>(windowBytes));
+    }
+
+    for (; y < endRow && !band.failed; y++) {
+        source.ReadRow(y, gather, row);
+        _CGPixelFilterPNGRow(row, prior, rowBytes, source.layout.bytesPerPixel, candidates, filtered);
+        std::swap(prior, row);
+
+        band.adler = adler32(band.adler, filtered, static_cast<uInt>(filteredBytes));
+        band.length += filteredBytes;
+        band.failed = !_CGImageDeflate(stream, filtered, filteredBytes, Z_NO_FLUSH, band.deflated);
+    }
+
+    if (!band.failed) {
+        band.failed = !_CGImageDeflate(stream, nullptr, 0, last ? Z_FINISH : Z_SYNC_FLUSH, band.deflated);
+    }
+    deflateEnd(&stream);
+}
+
+// Filters and deflates the image's rows into a zlib stream, split across the returned bands
+static bool _CGImageDeflatePNGRows(const _CGImagePNGSource& source, std::vector<_CGImagePNGBand>& bands) {
+    const size_t imageBytes = (source.width * source.layout.bytesPerPixel + 1) * source.height;
+    const size_t threads = std::max<size_t>(1, std::thread::hardware_concurrency());
+    const size_t bandCount = std::max<size_t>(1, std::min({ threads, c_PNGMaxBands, imageBytes / c_PNGMinBytesPerBand, source.height }));
+    const size_t bandRows = (source.height + bandCount - 1) / bandCount;
+
+    bands.resize((source.height + bandRows - 1) / bandRows);
+    auto deflateBand = [&source, &bands, bandRows](size_t index) {
+        const size_t firstRow = index * bandRows;
+        const size_t endRow = std::min(firstRow + bandRows, source.height);
+        _CGImageDeflatePNGBand(source, firstRow, endRow, index == bands.size() - 1, bands[index]);
+    };
+
+    std::thread workers[c_PNGMaxBands];
+    size_t workerCount = 0;
+    for (size_t index = 1; index < bands.size(); index++) {
+        try {
+            workers[workerCount] = std::thread(deflateBand, index);
+            workerCount++;
+        } catch (const std::system_error&) {
+            deflateBand(index);
+        }
+    }
+
+    deflateBand(0);
+
+    for (size_t i = 0; i < workerCount; i++) {
+        workers[i].join();
+    }
+
+    //  The zlib header, for the default compression and window, and the checksum of the whole stream
+    uLong adler = adler32(0, Z_NULL, 0);
+    for (const _CGImagePNGBand& band : bands) {
+        if (band.failed) {
+            return false;
+        }
+        adler = adler32_combine(adler, band.adler, static_cast<z_off_t>(band.length));
+    }
+
+    const uint8_t header[] = { 0x78, 0x9C };
+    bands.front().deflated.insert(bands.front().deflated.begin(), header, header + sizeof(header));
+
+    const uint8_t trailer[] = {
+        static_cast<uint8_t>(adler >> 24), static_cast<uint8_t>(adler >> 16), static_cast<uint8_t>(adler >> 8), static_cast<uint8_t>(adler)
+    };
+    bands.back().deflated.insert(bands.back().deflated.end(), trailer, trailer + sizeof(trailer));
+    return true;
+}
+
 NSData* _CGImagePNGRepresentation(UIImage* img) {
     if (img == nil) {
         TraceWarning(TAG, L"UIImagePNGRepresentation: img = nil!");
@@ -737,22 +983,11 @@ NSData* _CGImagePNGRepresentation(UIImage* img) {
         FAIL_FAST_HR(E_UNEXPECTED);
     }
 
-    png_structp png_ptr;
-    png_infop info_ptr;
-
-    // Initialize write structure
-    png_ptr = png_create_write_struct(PNG_LIBPNG_VER_STRING, NULL, NULL, NULL);
-
-    // Initialize info structure
-    info_ptr = png_create_info_struct(png_ptr);
-
-    if (setjmp(png_jmpbuf(png_ptr))) {
-        TraceError(TAG, L"Error during png creation");
-        return nil;
+    _CGImagePNGSource source;
+    if (!_CGImageGetPNGLayout(pImage->Backing()->SurfaceFormat(), pImage->Backing()->BitmapInfo(), &source.layout)) {
+        FAIL_FAST_HR_MSG(E_UNEXPECTED, "Unsupported backing format!");
     }
 
-    png_set_write_fn(png_ptr, (void*)ret, PNGWriteFunc, NULL);
-
     int width = pImage->Backing()->Width();
     int height = pImage->Backing()->Height();
     int xStrideImg = pImage->Backing()->BytesPerPixel();
@@ -796,147 +1031,60 @@ NSData* _CGImagePNGRepresentation(UIImage* img) {
             break;
     }
 
-    int xStrideOut;
-    int yStrideOut;
-    __CGSurfaceFormat backingFormat = pImage->Backing()->SurfaceFormat();
+    source.data = pImgData;
+    source.xStride = xStrideImg;
+    source.yStride = yStrideImg;
+    source.width = width;
+    source.height = height;
+    source.bytesPerPixel = pImage->Backing()->BytesPerPixel();
 
-    // Write header (8 bit colour depth)
-    switch (backingFormat) {
-        case _Color565:
-        case _ColorBGR:
-            png_set_IHDR(png_ptr,
-                         info_ptr,
-                         width,
-                         height,
-                         8,
-                         PNG_COLOR_TYPE_RGB,
-                         PNG_INTERLACE_NONE,
-                         PNG_COMPRESSION_TYPE_BASE,
-                         PNG_FILTER_TYPE_BASE);
-            xStrideOut = 3;
-            break;
+    std::vector<_CGImagePNGBand> bands;
+    bool deflated = _CGImageDeflatePNGRows(source, bands);
+    pImage->Backing()->ReleaseImageData();
 
-        case _ColorGrayscale:
-        case _ColorA8:
-            png_set_IHDR(png_ptr,
-                         info_ptr,
-                         width,
-                         height,
-                         8,
-                         PNG_COLOR_TYPE_GRAY,
-                         PNG_INTERLACE_NONE,
-                         PNG_COMPRESSION_TYPE_BASE,
-                         PNG_FILTER_TYPE_BASE);
-            xStrideOut = 1;
-            break;
+    if (!deflated) {
+        TraceError(TAG, L"Error during png compression");
+        return nil;
+    }
 
-        case _ColorARGB:
-        case _ColorABGR:
-        case _ColorBGRX:
-        case _ColorXBGR:
-            png_set_IHDR(png_ptr,
-                         info_ptr,
-                         width,
-                         height,
-                         8,
-                         PNG_COLOR_TYPE_RGB_ALPHA,
-                         PNG_INTERLACE_NONE,
-                         PNG_COMPRESSION_TYPE_BASE,
-                         PNG_FILTER_TYPE_BASE);
-            xStrideOut = 4;
-            break;
+    png_structp png_ptr;
+    png_infop info_ptr;
 
-        default:
-            // Any other backing formats are outside the scope of libpng, and extremely unlikely to be used.
-            FAIL_FAST_HR_MSG(E_UNEXPECTED, "Unsupported backing format!");
-            break;
+    // Initialize write structure
+    png_ptr = png_create_write_struct(PNG_LIBPNG_VER_STRING, NULL, NULL, NULL);
+
+    // Initialize info structure
+    info_ptr = png_create_info_struct(png_ptr);
+
+    if (setjmp(png_jmpbuf(png_ptr))) {
+        TraceError(TAG, L"Error during png creation");
+        png_destroy_write_struct(&png_ptr, &info_ptr);
+        return nil;
     }
 
-    yStrideOut = xStrideOut * width;
+    png_set_write_fn(png_ptr, (void*)ret, PNGWriteFunc, NULL);
+
+    // Write header (8 bit colour depth)
+    png_set_IHDR(png_ptr,
+                 info_ptr,
+                 width,
+                 height,
+                 8,
+                 source.layout.colorType,
+                 PNG_INTERLACE_NONE,
+                 PNG_COMPRESSION_TYPE_BASE,
+                 PNG_FILTER_TYPE_BASE);
 
     png_write_info(png_ptr, info_ptr);
 
-    int x, y;
-    int bytesperpixel = pImage->Backing()->BytesPerPixel();
-    BYTE* pRow = static_cast<BYTE*>(IwMalloc(yStrideOut));
-    FAIL_FAST_HR_IF_NULL(E_OUTOFMEMORY, pRow);
-    for (y = 0; y < height; y++) {
-        BYTE* rowStart = pImgData;
-        BYTE* rowOut = pRow;
-
-        for (x = 0; x < width; x++) {
-            BYTE* pixel = rowStart;
-            _RGBA_swizzle* outSwizzle = reinterpret_cast<_RGBA_swizzle*>(rowOut);
-            _BGRA_swizzle* pixelSwizzle = reinterpret_cast<_BGRA_swizzle*>(pixel);
-            switch (backingFormat) {
-                // PIXMAN_g8 | PIXMAN_a8
-                case _ColorGrayscale:
-                case _ColorA8:
-                    *rowOut = *pixel;
-                    break;
-
-                // PIXMAN_b8g8r8
-                case _ColorBGR: {
-                    outSwizzle->r = pixelSwizzle->b;
-                    outSwizzle->g = pixelSwizzle->g;
-                    outSwizzle->b = pixelSwizzle->r;
-                } break;
-
-                // PIXMAN_r5g6b5
-                case _Color565: {
-                    unsigned short shortPixel = *reinterpret_cast<unsigned short*>(pixel);
-
-                    // Mask out the RGB portions
-                    outSwizzle->r = (BYTE)(shortPixel >> 11);
-                    outSwizzle->g = (BYTE)((shortPixel >> 5) & 0x3F);
-                    outSwizzle->b = (BYTE)(shortPixel & 0x1F);
-
-                    // Scale component to BYTE with LSB extension. (00011b << 3 becomes 11111b, 00010b becomes 10000b)
-                    outSwizzle->r = (outSwizzle->r << 3) | (((outSwizzle->r & 0x1) << 3) - (outSwizzle->r & 0x1));
-                    outSwizzle->g = (outSwizzle->g << 2) | (((outSwizzle->g & 0x1) << 2) - (outSwizzle->g & 0x1));
-                    outSwizzle->b = (outSwizzle->b << 3) | (((outSwizzle->b & 0x1) << 3) - (outSwizzle->b & 0x1));
-                } break;
-
-                // PIXMAN_a8r8g8b8
-                case _ColorARGB: {
-                    outSwizzle->r = pixelSwizzle->r;
-                    outSwizzle->g = pixelSwizzle->g;
-                    outSwizzle->b = pixelSwizzle->b;
-                    outSwizzle->a = pixelSwizzle->a;
-                } break;
-
-                // PIXMAN_x8b8g8r8 | PIXMAN_a8b8g8r8
-                case _ColorXBGR:
-                case _ColorABGR: {
-                    outSwizzle->r = pixelSwizzle->b;
-                    outSwizzle->g = pixelSwizzle->g;
-                    outSwizzle->b = pixelSwizzle->r;
-                    outSwizzle->a = pixelSwizzle->a;
-                } break;
-
-                // PIXMAN_b8g8r8x8
-                case _ColorBGRX: {
-                    outSwizzle->r = pixelSwizzle->b;
-                    outSwizzle->g = pixelSwizzle->g;
-                    outSwizzle->b = pixelSwizzle->r;
-                    outSwizzle->a = pixelSwizzle->a;
-                } break;
-
-                default:
-                    // Impossible state, we should have failed higher up.
-                    FAIL_FAST_HR(E_UNEXPECTED);
-                    break;
-            }
-            rowOut += xStrideOut;
-            rowStart += xStrideImg;
+    //  The image data was compressed here rather than by libpng, so is written as chunks of its own, one per band
+    for (const _CGImagePNGBand& band : bands) {
+        if (!band.deflated.empty()) {
+            png_write_chunk(png_ptr, reinterpret_cast<png_const_bytep>("IDAT"), band.deflated.data(), band.deflated.size());
         }
-        pImgData += yStrideImg;
-        png_write_row(png_ptr, pRow);
     }
-    IwFree(pRow);
-    pImage->Backing()->ReleaseImageData();
+    png_write_chunk(png_ptr, reinterpret_cast<png_const_bytep>("IEND"), NULL, 0);
 
-    png_write_end(png_ptr, NULL);
     png_destroy_write_struct(&png_ptr, &info_ptr);
 
     return ret;
@@ -14,104 +14,86 @@
 //
 //******************************************************************************
 
-#import <StubReturn.h>
+#import "CGPDFInternal.h"
 #import <CoreGraphics/CGPDFArray.h>
 
 /**
- @Status Stub
- @Notes
+ @Status Interoperable
 */
 bool CGPDFArrayGetArray(CGPDFArrayRef array, size_t index, CGPDFArrayRef _Nullable* value) {
-    UNIMPLEMENTED();
-    return StubReturn();
+    return array && _CGPDFObjectGetValue(array->Get(index), kCGPDFObjectTypeArray, value);
 }
 
 /**
- @Status Stub
- @Notes
+ @Status Interoperable
 */
 bool CGPDFArrayGetBoolean(CGPDFArrayRef array, size_t index, CGPDFBoolean* value) {
-    UNIMPLEMENTED();
-    return StubReturn();
+    return array && _CGPDFObjectGetValue(array->Get(index), kCGPDFObjectTypeBoolean, value);
 }
 
 /**
- @Status Stub
- @Notes
+ @Status Interoperable
 */
 size_t CGPDFArrayGetCount(CGPDFArrayRef array) {
-    UNIMPLEMENTED();
-    return StubReturn();
+    return array ? array->objects.size() : 0;
 }
 
 /**
- @Status Stub
- @Notes
+ @Status Interoperable
 */
 bool CGPDFArrayGetDictionary(CGPDFArrayRef array, size_t index, CGPDFDictionaryRef _Nullable* value) {
-    UNIMPLEMENTED();
-    return StubReturn();
+    return array && _CGPDFObjectGetValue(array->Get(index), kCGPDFObjectTypeDictionary, value);
 }
 
 /**
- @Status Stub
- @Notes
+ @Status Interoperable
 */
 bool CGPDFArrayGetInteger(CGPDFArrayRef array, size_t index, CGPDFInteger* value) {
-    UNIMPLEMENTED();
-    return StubReturn();
+    return array && _CGPDFObjectGetValue(array->Get(index), kCGPDFObjectTypeInteger, value);
 }
 
 /**
- @Status Stub
- @Notes
+ @Status Interoperable
 */
 bool CGPDFArrayGetName(CGPDFArrayRef array, size_t index, const char* _Nullable* value) {
-    UNIMPLEMENTED();
-    return StubReturn();
+    return array && _CGPDFObjectGetValue(array->Get(index), kCGPDFObjectTypeName, value);
 }
 
 /**
- @Status Stub
- @Notes
+ @Status Interoperable
 */
 bool CGPDFArrayGetNull(CGPDFArrayRef array, size_t index) {
-    UNIMPLEMENTED();
-    return StubReturn();
+    return array && _CGPDFObjectGetValue(array->Get(index), kCGPDFObjectTypeNull, nullptr);
 }
 
 /**
- @Status Stub
- @Notes
+ @Status Interoperable
 */
 bool CGPDFArrayGetNumber(CGPDFArrayRef array, size_t index, CGPDFReal* value) {
-    UNIMPLEMENTED();
-    return StubReturn();
+    return array && _CGPDFObjectGetValue(array->Get(index), kCGPDFObjectTypeReal, value);
 }
 
 /**
- @Status Stub
- @Notes
+ @Status Interoperable
 */
 bool CGPDFArrayGetObject(CGPDFArrayRef array, size_t index, CGPDFObjectRef _Nullable* value) {
-    UNIMPLEMENTED();
-    return StubReturn();
+    CGPDFObjectRef object = array ? array->Get(index) : nullptr;
+    if (object && value) {
+        *value = object;
+    }
+    return object != nullptr;
 }
 
 /**
- @Status Stub
- @Notes
+ @Status Interoperable
 */
 bool CGPDFArrayGetStream(CGPDFArrayRef array, size_t index, CGPDFStreamRef _Nullable* value) {
-    UNIMPLEMENTED();
-    return StubReturn();
+    return array && _CGPDFObjectGetValue(array->Get(index), kCGPDFObjectTypeStream, value);
 }
 
 /**
- @Status Stub
- @Notes
+ @Status Interoperable
 */
 bool CGPDFArrayGetString(CGPDFArrayRef array, size_t index, CGPDFStringRef _Nullable* value) {
-    UNIMPLEMENTED();
-    return StubReturn();
+    return array && _CGPDFObjectGetValue(array->Get(index), kCGPDFObjectTypeString, value);
 }
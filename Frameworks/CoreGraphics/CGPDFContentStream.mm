@@ -14,60 +14,106 @@
 //
 //******************************************************************************
 
-#import <StubReturn.h>
+#import <CoreFoundation/CFArray.h>
 #import <CoreGraphics/CGPDFContentStream.h>
+#import "CGPDFInternal.h"
 
 /**
- @Status Stub
- @Notes
+ @Status Interoperable
 */
 CGPDFContentStreamRef CGPDFContentStreamCreateWithPage(CGPDFPageRef page) {
-    UNIMPLEMENTED();
-    return StubReturn();
+    if (!page) {
+        return nullptr;
+    }
+
+    CGPDFContentStreamRef cs = _CGPDFRetain(new __CGPDFContentStream());
+    cs->resources = page->resources;
+    cs->page = CGPDFPageRetain(page);
+
+    //  A page's contents are a stream, or an array of streams to be read as though one
+    CGPDFStreamRef stream = nullptr;
+    CGPDFArrayRef streams = nullptr;
+    if (CGPDFDictionaryGetStream(page->dictionary, "Contents", &stream)) {
+        cs->streams.push_back(stream);
+    } else if (CGPDFDictionaryGetArray(page->dictionary, "Contents", &streams)) {
+        for (size_t i = 0; i < CGPDFArrayGetCount(streams); ++i) {
+            if (CGPDFArrayGetStream(streams, i, &stream)) {
+                cs->streams.push_back(stream);
+            }
+        }
+    }
+
+    return cs;
 }
 
 /**
- @Status Stub
- @Notes
+ @Status Interoperable
 */
 CGPDFContentStreamRef CGPDFContentStreamCreateWithStream(CGPDFStreamRef stream,
                                                          CGPDFDictionaryRef streamResources,
                                                          CGPDFContentStreamRef parent) {
-    UNIMPLEMENTED();
-    return StubReturn();
+    if (!stream) {
+        return nullptr;
+    }
+
+    CGPDFContentStreamRef cs = _CGPDFRetain(new __CGPDFContentStream());
+    cs->streams.push_back(stream);
+    cs->resources = streamResources;
+    cs->parent = CGPDFContentStreamRetain(parent);
+    return cs;
 }
 
 /**
- @Status Stub
- @Notes
+ @Status Interoperable
 */
 CFArrayRef CGPDFContentStreamGetStreams(CGPDFContentStreamRef cs) {
-    UNIMPLEMENTED();
-    return StubReturn();
+    if (!cs) {
+        return nullptr;
+    }
+
+    if (!cs->streamArray) {
+        cs->streamArray = CFArrayCreate(nullptr,
+                                        const_cast<const void**>(reinterpret_cast<void* const*>(cs->streams.data())),
+                                        cs->streams.size(),
+                                        nullptr);
+    }
+    return cs->streamArray;
 }
 
 /**
- @Status Stub
- @Notes
+ @Status Interoperable
 */
 CGPDFObjectRef CGPDFContentStreamGetResource(CGPDFContentStreamRef cs, const char* category, const char* name) {
-    UNIMPLEMENTED();
-    return StubReturn();
+    //  Forms and patterns inherit the resources of the content they're drawn from
+    for (; cs; cs = cs->parent) {
+        CGPDFDictionaryRef resources = nullptr;
+        CGPDFObjectRef resource = nullptr;
+        if (CGPDFDictionaryGetDictionary(cs->resources, category, &resources) && CGPDFDictionaryGetObject(resources, name, &resource)) {
+            return resource;
+        }
+    }
+    return nullptr;
 }
 
 /**
- @Status Stub
- @Notes
+ @Status Interoperable
 */
 CGPDFContentStreamRef CGPDFContentStreamRetain(CGPDFContentStreamRef cs) {
-    UNIMPLEMENTED();
-    return StubReturn();
+    return _CGPDFRetain(cs);
 }
 
 /**
- @Status Stub
- @Notes
+ @Status Interoperable
 */
 void CGPDFContentStreamRelease(CGPDFContentStreamRef cs) {
-    UNIMPLEMENTED();
+    if (!_CGPDFRelease(cs)) {
+        return;
+    }
+
+    if (cs->streamArray) {
+        CFRelease(cs->streamArray);
+    }
+    CGPDFContentStreamRelease(cs->parent);
+    CGPDFPageRelease(cs->page);
+    delete cs;
 }
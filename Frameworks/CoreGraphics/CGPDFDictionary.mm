@@ -14,103 +14,95 @@
 //
 //******************************************************************************
 
-#import <StubReturn.h>
+#import "CGPDFInternal.h"
 #import <CoreGraphics/CGPDFDictionary.h>
 
 /**
- @Status Stub
- @Notes
+ @Status Interoperable
 */
 void CGPDFDictionaryApplyFunction(CGPDFDictionaryRef dict, CGPDFDictionaryApplierFunction function, void* info) {
-    UNIMPLEMENTED();
+    if (!dict || !function) {
+        return;
+    }
+
+    for (const auto& entry : dict->entries) {
+        CGPDFObjectRef value = _CGPDFResolve(dict->file, &entry.second);
+        if (value) {
+            function(entry.first, value, info);
+        }
+    }
 }
 
 /**
- @Status Stub
- @Notes
+ @Status Interoperable
 */
 bool CGPDFDictionaryGetArray(CGPDFDictionaryRef dict, const char* key, CGPDFArrayRef _Nullable* value) {
-    UNIMPLEMENTED();
-    return StubReturn();
+    return dict && key && _CGPDFObjectGetValue(dict->Get(key), kCGPDFObjectTypeArray, value);
 }
 
 /**
- @Status Stub
- @Notes
+ @Status Interoperable
 */
 bool CGPDFDictionaryGetBoolean(CGPDFDictionaryRef dict, const char* key, CGPDFBoolean* value) {
-    UNIMPLEMENTED();
-    return StubReturn();
+    return dict && key && _CGPDFObjectGetValue(dict->Get(key), kCGPDFObjectTypeBoolean, value);
 }
 
 /**
- @Status Stub
- @Notes
+ @Status Interoperable
 */
 size_t CGPDFDictionaryGetCount(CGPDFDictionaryRef dict) {
-    UNIMPLEMENTED();
-    return StubReturn();
+    return dict ? dict->entries.size() : 0;
 }
 
 /**
- @Status Stub
- @Notes
+ @Status Interoperable
 */
 bool CGPDFDictionaryGetDictionary(CGPDFDictionaryRef dict, const char* key, CGPDFDictionaryRef _Nullable* value) {
-    UNIMPLEMENTED();
-    return StubReturn();
+    return dict && key && _CGPDFObjectGetValue(dict->Get(key), kCGPDFObjectTypeDictionary, value);
 }
 
 /**
- @Status Stub
- @Notes
+ @Status Interoperable
 */
 bool CGPDFDictionaryGetInteger(CGPDFDictionaryRef dict, const char* key, CGPDFInteger* value) {
-    UNIMPLEMENTED();
-    return StubReturn();
+    return dict && key && _CGPDFObjectGetValue(dict->Get(key), kCGPDFObjectTypeInteger, value);
 }
 
 /**
- @Status Stub
- @Notes
+ @Status Interoperable
 */
 bool CGPDFDictionaryGetName(CGPDFDictionaryRef dict, const char* key, const char* _Nullable* value) {
-    UNIMPLEMENTED();
-    return StubReturn();
+    return dict && key && _CGPDFObjectGetValue(dict->Get(key), kCGPDFObjectTypeName, value);
 }
 
 /**
- @Status Stub
- @Notes
+ @Status Interoperable
 */
 bool CGPDFDictionaryGetNumber(CGPDFDictionaryRef dict, const char* key, CGPDFReal* value) {
-    UNIMPLEMENTED();
-    return StubReturn();
+    return dict && key && _CGPDFObjectGetValue(dict->Get(key), kCGPDFObjectTypeReal, value);
 }
 
 /**
- @Status Stub
- @Notes
+ @Status Interoperable
 */
 bool CGPDFDictionaryGetObject(CGPDFDictionaryRef dict, const char* key, CGPDFObjectRef _Nullable* value) {
-    UNIMPLEMENTED();
-    return StubReturn();
+    CGPDFObjectRef object = (dict && key) ? dict->Get(key) : nullptr;
+    if (object && value) {
+        *value = object;
+    }
+    return object != nullptr;
 }
 
 /**
- @Status Stub
- @Notes
+ @Status Interoperable
 */
 bool CGPDFDictionaryGetStream(CGPDFDictionaryRef dict, const char* key, CGPDFStreamRef _Nullable* value) {
-    UNIMPLEMENTED();
-    return StubReturn();
+    return dict && key && _CGPDFObjectGetValue(dict->Get(key), kCGPDFObjectTypeStream, value);
 }
 
 /**
- @Status Stub
- @Notes
+ @Status Interoperable
 */
 bool CGPDFDictionaryGetString(CGPDFDictionaryRef dict, const char* key, CGPDFStringRef _Nullable* value) {
-    UNIMPLEMENTED();
-    return StubReturn();
+    return dict && key && _CGPDFObjectGetValue(dict->Get(key), kCGPDFObjectTypeString, value);
 }
@@ -15,41 +15,95 @@
 //******************************************************************************
 
 #import <StubReturn.h>
+#import <Starboard.h>
+#import <Foundation/NSData.h>
+#import <Foundation/NSURL.h>
 #import <CoreGraphics/CGPDFDocument.h>
+#import "CFBridgeBase.h"
+#import "CGPDFInternal.h"
+
+#include "LoggingNative.h"
+
+static const wchar_t* TAG = L"CGPDFDocument";
+
+// Permission bits of an encrypted document's /P entry
+static const CGPDFInteger c_permissionPrint = 1 << 2;
+static const CGPDFInteger c_permissionCopy = 1 << 4;
+
+struct __CGPDFDocument : public CFBridgeBase<__CGPDFDocument> {
+    // The file, in memory or mapped, which the parsed objects point into
+    StrongId<NSData> _data;
+    std::unique_ptr<PDFFile> _file;
+};
+
+static CGPDFDocumentRef __CGPDFDocumentCreate(NSData* data) {
+    if (!data) {
+        return nullptr;
+    }
+
+    __CGPDFDocument* document = __CGPDFDocument::alloc(nil);
+    document->_data = data;
+    document->_file.reset(new PDFFile(static_cast<const uint8_t*>([data bytes]), [data length], document));
+    if (!document->_file->Open()) {
+        TraceError(TAG, L"Unable to read PDF document");
+        CFRelease(document);
+        return nullptr;
+    }
+
+    return document;
+}
+
+static bool __CGPDFDocumentAllows(CGPDFDocumentRef document, CGPDFInteger permission) {
+    if (!CGPDFDocumentIsEncrypted(document)) {
+        return document != nullptr;
+    }
+
+    CGPDFDictionaryRef encrypt = nullptr;
+    CGPDFInteger permissions = 0;
+    return CGPDFDictionaryGetDictionary(document->_file->Trailer(), "Encrypt", &encrypt) &&
+           CGPDFDictionaryGetInteger(encrypt, "P", &permissions) && (permissions & permission) != 0;
+}
 
 /**
- @Status Stub
- @Notes
+ @Status Interoperable
 */
 CGPDFDocumentRef CGPDFDocumentCreateWithProvider(CGDataProviderRef provider) {
-    UNIMPLEMENTED();
-    return StubReturn();
+    //  Data providers are NSData, which the document keeps rather than copying
+    return __CGPDFDocumentCreate(static_cast<NSData*>(provider));
 }
 
 /**
- @Status Stub
- @Notes
+ @Status Caveat
+ @Notes Only supports file:/// URLs
 */
 CGPDFDocumentRef CGPDFDocumentCreateWithURL(CFURLRef url) {
-    UNIMPLEMENTED();
-    return StubReturn();
+    NSString* path = [static_cast<NSURL*>(url) path];
+    if (!path) {
+        return nullptr;
+    }
+
+    //  Mapping the file means only the pages read are ever paged in
+    NSData* data = [NSData dataWithContentsOfFile:path options:NSDataReadingMappedIfSafe error:nullptr];
+    return __CGPDFDocumentCreate(data);
 }
 
 /**
- @Status Stub
- @Notes
+ @Status Interoperable
 */
 void CGPDFDocumentRelease(CGPDFDocumentRef document) {
-    UNIMPLEMENTED();
+    if (document) {
+        CFRelease(document);
+    }
 }
 
 /**
- @Status Stub
- @Notes
+ @Status Interoperable
 */
 CGPDFDocumentRef CGPDFDocumentRetain(CGPDFDocumentRef document) {
-    UNIMPLEMENTED();
-    return StubReturn();
+    if (document) {
+        CFRetain(document);
+    }
+    return document;
 }
 
 /**
@@ -62,99 +116,91 @@ CFTypeID CGPDFDocumentGetTypeID() {
 }
 
 /**
- @Status Stub
- @Notes
+ @Status Interoperable
 */
 CGPDFDictionaryRef CGPDFDocumentGetCatalog(CGPDFDocumentRef document) {
-    UNIMPLEMENTED();
-    return StubReturn();
+    return document ? document->_file->Catalog() : nullptr;
 }
 
 /**
- @Status Stub
- @Notes
+ @Status Interoperable
 */
 size_t CGPDFDocumentGetNumberOfPages(CGPDFDocumentRef document) {
-    UNIMPLEMENTED();
-    return StubReturn();
+    return document ? document->_file->PageCount() : 0;
 }
 
 /**
- @Status Stub
- @Notes
+ @Status Interoperable
+ @Notes Only the page tree nodes on the way to the page, and their kids' dictionaries, are parsed
 */
 CGPDFPageRef CGPDFDocumentGetPage(CGPDFDocumentRef document, size_t pageNumber) {
-    UNIMPLEMENTED();
-    return StubReturn();
+    return document ? document->_file->Page(pageNumber) : nullptr;
 }
 
 /**
- @Status Stub
- @Notes
+ @Status Interoperable
 */
 void CGPDFDocumentGetVersion(CGPDFDocumentRef document, int* majorVersion, int* minorVersion) {
-    UNIMPLEMENTED();
+    if (document) {
+        document->_file->GetVersion(majorVersion, minorVersion);
+    }
 }
 
 /**
- @Status Stub
- @Notes
+ @Status Interoperable
 */
 CGPDFDictionaryRef CGPDFDocumentGetInfo(CGPDFDocumentRef document) {
-    UNIMPLEMENTED();
-    return StubReturn();
+    CGPDFDictionaryRef info = nullptr;
+    return document && CGPDFDictionaryGetDictionary(document->_file->Trailer(), "Info", &info) ? info : nullptr;
 }
 
 /**
- @Status Stub
- @Notes
+ @Status Interoperable
 */
 CGPDFArrayRef CGPDFDocumentGetID(CGPDFDocumentRef document) {
-    UNIMPLEMENTED();
-    return StubReturn();
+    CGPDFArrayRef identifier = nullptr;
+    return document && CGPDFDictionaryGetArray(document->_file->Trailer(), "ID", &identifier) ? identifier : nullptr;
 }
 
 /**
- @Status Stub
- @Notes
+ @Status Caveat
+ @Notes Encrypted documents can't be unlocked, so report their permissions only
 */
 bool CGPDFDocumentAllowsCopying(CGPDFDocumentRef document) {
-    UNIMPLEMENTED();
-    return StubReturn();
+    return __CGPDFDocumentAllows(document, c_permissionCopy);
 }
 
 /**
- @Status Stub
- @Notes
+ @Status Caveat
+ @Notes Encrypted documents can't be unlocked, so report their permissions only
 */
 bool CGPDFDocumentAllowsPrinting(CGPDFDocumentRef document) {
-    UNIMPLEMENTED();
-    return StubReturn();
+    return __CGPDFDocumentAllows(document, c_permissionPrint);
 }
 
 /**
- @Status Stub
- @Notes
+ @Status Interoperable
 */
 bool CGPDFDocumentIsEncrypted(CGPDFDocumentRef document) {
-    UNIMPLEMENTED();
-    return StubReturn();
+    return document && CGPDFDictionaryGetObject(document->_file->Trailer(), "Encrypt", nullptr);
 }
 
 /**
- @Status Stub
- @Notes
+ @Status Caveat
+ @Notes Encrypted documents are never unlocked
 */
 bool CGPDFDocumentIsUnlocked(CGPDFDocumentRef document) {
-    UNIMPLEMENTED();
-    return StubReturn();
+    return document && !CGPDFDocumentIsEncrypted(document);
 }
 
 /**
- @Status Stub
- @Notes
+ @Status Caveat
+ @Notes Decryption is not supported, so encrypted documents stay locked
 */
 bool CGPDFDocumentUnlockWithPassword(CGPDFDocumentRef document, const char* password) {
-    UNIMPLEMENTED();
-    return StubReturn();
+    return CGPDFDocumentIsUnlocked(document);
+}
+
+size_t _CGPDFDocumentGetParsedObjectCount(CGPDFDocumentRef document) {
+    return document ? document->_file->ParsedObjectCount() : 0;
 }
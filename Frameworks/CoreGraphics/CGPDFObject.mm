@@ -14,23 +14,19 @@
 //
 //******************************************************************************
 
-#import <StubReturn.h>
+#import "CGPDFInternal.h"
 #import <CoreGraphics/CGPDFObject.h>
 
 /**
- @Status Stub
- @Notes
+ @Status Interoperable
 */
 CGPDFObjectType CGPDFObjectGetType(CGPDFObjectRef object) {
-    UNIMPLEMENTED();
-    return StubReturn();
+    return object ? object->value.type : kCGPDFObjectTypeNull;
 }
 
 /**
- @Status Stub
- @Notes
+ @Status Interoperable
 */
 bool CGPDFObjectGetValue(CGPDFObjectRef object, CGPDFObjectType type, void* value) {
-    UNIMPLEMENTED();
-    return StubReturn();
+    return _CGPDFObjectGetValue(object, type, value);
 }
@@ -14,39 +14,43 @@
 //
 //******************************************************************************
 
-#import <StubReturn.h>
 #import <CoreGraphics/CGPDFOperatorTable.h>
+#import "CGPDFInternal.h"
 
 /**
- @Status Stub
- @Notes
+ @Status Interoperable
 */
 CGPDFOperatorTableRef CGPDFOperatorTableCreate() {
-    UNIMPLEMENTED();
-    return StubReturn();
+    return _CGPDFRetain(new __CGPDFOperatorTable());
 }
 
 /**
- @Status Stub
- @Notes
+ @Status Interoperable
 */
 void CGPDFOperatorTableSetCallback(CGPDFOperatorTableRef table, const char* name, CGPDFOperatorCallback callback) {
-    UNIMPLEMENTED();
+    if (!table || !name) {
+        return;
+    }
+
+    if (callback) {
+        table->callbacks[name] = callback;
+    } else {
+        table->callbacks.erase(name);
+    }
 }
 
 /**
- @Status Stub
- @Notes
+ @Status Interoperable
 */
 CGPDFOperatorTableRef CGPDFOperatorTableRetain(CGPDFOperatorTableRef table) {
-    UNIMPLEMENTED();
-    return StubReturn();
+    return _CGPDFRetain(table);
 }
 
 /**
- @Status Stub
- @Notes
+ @Status Interoperable
 */
 void CGPDFOperatorTableRelease(CGPDFOperatorTableRef table) {
-    UNIMPLEMENTED();
+    if (_CGPDFRelease(table)) {
+        delete table;
+    }
 }
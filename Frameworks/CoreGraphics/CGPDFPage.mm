@@ -15,23 +15,52 @@
 //******************************************************************************
 
 #import <StubReturn.h>
+#import <CoreGraphics/CGAffineTransform.h>
+#import <CoreGraphics/CGPDFDocument.h>
 #import <CoreGraphics/CGPDFPage.h>
+#import "CGPDFInternal.h"
+
+#include <math.h>
+
+// The page size assumed when a page has no media box: US Letter
+static const CGRect c_defaultMediaBox = { { 0.0f, 0.0f }, { 612.0f, 792.0f } };
+
+static bool __CGPDFPageGetRect(const __CGPDFObject* object, CGRect* rect) {
+    CGPDFArrayRef array = nullptr;
+    CGPDFReal values[4];
+    if (!_CGPDFObjectGetValue(object, kCGPDFObjectTypeArray, &array) || CGPDFArrayGetCount(array) != 4) {
+        return false;
+    }
+
+    for (size_t i = 0; i < 4; ++i) {
+        if (!CGPDFArrayGetNumber(array, i, &values[i])) {
+            return false;
+        }
+    }
+
+    //  Rectangles may be given by any two opposite corners
+    *rect = CGRectStandardize(CGRectMake(values[0], values[1], values[2] - values[0], values[3] - values[1]));
+    return true;
+}
 
 /**
- @Status Stub
- @Notes
+ @Status Interoperable
 */
 CGPDFPageRef CGPDFPageRetain(CGPDFPageRef page) {
-    UNIMPLEMENTED();
-    return StubReturn();
+    //  Pages belong to their document, and keep it alive for as long as they are
+    if (page) {
+        CGPDFDocumentRetain(page->document);
+    }
+    return page;
 }
 
 /**
- @Status Stub
- @Notes
+ @Status Interoperable
 */
 void CGPDFPageRelease(CGPDFPageRef page) {
-    UNIMPLEMENTED();
+    if (page) {
+        CGPDFDocumentRelease(page->document);
+    }
 }
 
 /**
@@ -44,55 +73,103 @@ CFTypeID CGPDFPageGetTypeID() {
 }
 
 /**
- @Status Stub
- @Notes
+ @Status Interoperable
 */
 CGRect CGPDFPageGetBoxRect(CGPDFPageRef page, CGPDFBox box) {
-    UNIMPLEMENTED();
-    return StubReturn();
+    if (!page) {
+        return CGRectNull;
+    }
+
+    CGRect mediaBox;
+    if (!__CGPDFPageGetRect(page->mediaBox, &mediaBox)) {
+        mediaBox = c_defaultMediaBox;
+    }
+
+    if (box == kCGPDFMediaBox) {
+        return mediaBox;
+    }
+
+    //  The crop box is clipped to the media box, and the other boxes default to it
+    CGRect cropBox;
+    if (!__CGPDFPageGetRect(page->cropBox, &cropBox) || CGRectIsEmpty(cropBox = CGRectIntersection(cropBox, mediaBox))) {
+        cropBox = mediaBox;
+    }
+
+    const char* key = nullptr;
+    switch (box) {
+        case kCGPDFBleedBox:
+            key = "BleedBox";
+            break;
+        case kCGPDFTrimBox:
+            key = "TrimBox";
+            break;
+        case kCGPDFArtBox:
+            key = "ArtBox";
+            break;
+        default:
+            return cropBox;
+    }
+
+    CGRect rect;
+    if (!__CGPDFPageGetRect(page->dictionary->Get(key), &rect) || CGRectIsEmpty(rect = CGRectIntersection(rect, cropBox))) {
+        rect = cropBox;
+    }
+    return rect;
 }
 
 /**
- @Status Stub
- @Notes
+ @Status Interoperable
 */
 CGPDFDictionaryRef CGPDFPageGetDictionary(CGPDFPageRef page) {
-    UNIMPLEMENTED();
-    return StubReturn();
+    return page ? page->dictionary : nullptr;
 }
 
 /**
- @Status Stub
- @Notes
+ @Status Interoperable
 */
 CGPDFDocumentRef CGPDFPageGetDocument(CGPDFPageRef page) {
-    UNIMPLEMENTED();
-    return StubReturn();
+    return page ? page->document : nullptr;
 }
 
 /**
- @Status Stub
- @Notes
+ @Status Interoperable
 */
 CGAffineTransform CGPDFPageGetDrawingTransform(CGPDFPageRef page, CGPDFBox box, CGRect rect, int rotate, bool preserveAspectRatio) {
-    UNIMPLEMENTED();
-    return StubReturn();
+    if (!page) {
+        return CGAffineTransformIdentity;
+    }
+
+    const CGRect boxRect = CGPDFPageGetBoxRect(page, box);
+    const int rotation = (((page->rotation + rotate) / 90 * 90) % 360 + 360) % 360;
+
+    //  The box is rotated clockwise, as PDF pages are, and then fitted into rect without being scaled up
+    CGSize size = boxRect.size;
+    if (rotation == 90 || rotation == 270) {
+        std::swap(size.width, size.height);
+    }
+
+    CGFloat scaleX = size.width > 0 ? std::min(rect.size.width / size.width, static_cast<CGFloat>(1.0)) : 1.0;
+    CGFloat scaleY = size.height > 0 ? std::min(rect.size.height / size.height, static_cast<CGFloat>(1.0)) : 1.0;
+    if (preserveAspectRatio) {
+        scaleX = scaleY = std::min(scaleX, scaleY);
+    }
+
+    CGAffineTransform transform = CGAffineTransformMakeTranslation(-CGRectGetMidX(boxRect), -CGRectGetMidY(boxRect));
+    transform = CGAffineTransformConcat(transform, CGAffineTransformMakeRotation(-rotation * M_PI / 180.0));
+    transform = CGAffineTransformConcat(transform, CGAffineTransformMakeScale(scaleX, scaleY));
+    return CGAffineTransformConcat(transform, CGAffineTransformMakeTranslation(CGRectGetMidX(rect), CGRectGetMidY(rect)));
 }
 
 /**
- @Status Stub
- @Notes
+ @Status Interoperable
 */
 size_t CGPDFPageGetPageNumber(CGPDFPageRef page) {
-    UNIMPLEMENTED();
-    return StubReturn();
+    return page ? page->number : 0;
 }
 
 /**
- @Status Stub
- @Notes
+ @Status Interoperable
 */
 int CGPDFPageGetRotationAngle(CGPDFPageRef page) {
-    UNIMPLEMENTED();
-    return StubReturn();
+    return page ? static_cast<int>(page->rotation) : 0;
 }
@@ -0,0 +1,1571 @@
+//******************************************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+//
+// This code is licensed under the MIT License (MIT).
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+//******************************************************************************
+
+#include "CGPDFInternal.h"
+
+#include <limits.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unordered_set>
+#include <zlib.h>
+
+namespace {
+
+// Decoded object streams kept around, for objects read one after another from the same stream
+const size_t c_objectStreamCacheSize = 8;
+
+// How much of a compressed content stream is decoded at a time
+const size_t c_contentWindowSize = 16 * 1024;
+
+const int c_maximumNesting = 256;
+const int c_maximumPageTreeDepth = 64;
+const uint32_t c_maximumObjectNumber = 8 * 1024 * 1024;
+
+// How far from the end of the file startxref is looked for
+const size_t c_startxrefSearchLength = 4096;
+
+const uint8_t c_streamSeparator = ' ';
+
+bool isWhitespace(int c) {
+    return c == 0 || c == '\t' || c == '\n' || c == '\f' || c == '\r' || c == ' ';
+}
+
+bool isDelimiter(int c) {
+    switch (c) {
+        case '(':
+        case ')':
+        case '<':
+        case '>':
+        case '[':
+        case ']':
+        case '{':
+        case '}':
+        case '/':
+        case '%':
+            return true;
+        default:
+            return false;
+    }
+}
+
+bool isRegular(int c) {
+    return c >= 0 && !isWhitespace(c) && !isDelimiter(c);
+}
+
+int hexValue(int c) {
+    if (c >= '0' && c <= '9') {
+        return c - '0';
+    } else if (c >= 'a' && c <= 'f') {
+        return c - 'a' + 10;
+    } else if (c >= 'A' && c <= 'F') {
+        return c - 'A' + 10;
+    }
+    return -1;
+}
+
+bool getInteger(CGPDFDictionaryRef dictionary, const char* key, CGPDFInteger& value) {
+    return dictionary && _CGPDFObjectGetValue(dictionary->Get(key), kCGPDFObjectTypeInteger, &value);
+}
+
+CGPDFDictionaryRef getDictionary(CGPDFDictionaryRef dictionary, const char* key) {
+    CGPDFDictionaryRef value = nullptr;
+    return dictionary && _CGPDFObjectGetValue(dictionary->Get(key), kCGPDFObjectTypeDictionary, &value) ? value : nullptr;
+}
+
+bool isName(const __CGPDFObject* object, const char* name) {
+    return object && object->value.type == kCGPDFObjectTypeName && strcmp(object->value.name, name) == 0;
+}
+
+const uint8_t* findBytes(const uint8_t* begin, const uint8_t* end, const char* bytes) {
+    const size_t length = strlen(bytes);
+    const uint8_t* found = std::search(begin, end, bytes, bytes + length);
+    return found == end ? nullptr : found;
+}
+
+// Reads a cross-reference table entry, "offset generation n" or "f". Entries are meant to be 20 bytes, but not all writers
+// pad them correctly, so they're read as digits and whitespace, which is still much quicker than as objects.
+bool readXrefEntry(PDFByteSource& source, uint64_t& offset, uint32_t& generation, bool& inUse) {
+    auto readNumber = [&source](uint64_t& value) {
+        while (isWhitespace(source.Peek())) {
+            source.Next();
+        }
+
+        int c = source.Peek();
+        if (c < '0' || c > '9') {
+            return false;
+        }
+
+        value = 0;
+        for (; c >= '0' && c <= '9'; c = source.Peek()) {
+            value = value * 10 + (source.Next() - '0');
+        }
+        return true;
+    };
+
+    uint64_t number;
+    if (!readNumber(offset) || !readNumber(number)) {
+        return false;
+    }
+    generation = static_cast<uint32_t>(number);
+
+    while (isWhitespace(source.Peek())) {
+        source.Next();
+    }
+
+    const int type = source.Next();
+    inUse = type == 'n';
+    return type == 'n' || type == 'f';
+}
+
+// Inflates zlib data, keeping whatever was decoded before any corruption, as readers are expected to
+bool inflateData(const std::string& input, std::string& output) {
+    z_stream stream = {};
+    if (inflateInit(&stream) != Z_OK) {
+        return false;
+    }
+
+    stream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(input.data()));
+    stream.avail_in = static_cast<uInt>(input.size());
+
+    output.clear();
+    uint8_t buffer[c_contentWindowSize];
+    int result;
+    do {
+        stream.next_out = buffer;
+        stream.avail_out = sizeof(buffer);
+        result = inflate(&stream, Z_NO_FLUSH);
+        output.append(reinterpret_cast<char*>(buffer), sizeof(buffer) - stream.avail_out);
+    } while (result == Z_OK && (stream.avail_out == 0 || stream.avail_in > 0));
+
+    inflateEnd(&stream);
+    return result == Z_STREAM_END || !output.empty();
+}
+
+bool decodeHex(const std::string& input, std::string& output) {
+    output.clear();
+    int high = -1;
+    for (char c : input) {
+        if (c == '>') {
+            break;
+        }
+
+        const int value = hexValue(static_cast<uint8_t>(c));
+        if (value < 0) {
+            continue;
+        }
+
+        if (high < 0) {
+            high = value;
+        } else {
+            output.push_back(static_cast<char>(high << 4 | value));
+            high = -1;
+        }
+    }
+
+    if (high >= 0) {
+        output.push_back(static_cast<char>(high << 4));
+    }
+    return true;
+}
+
+bool decodeAscii85(const std::string& input, std::string& output) {
+    output.clear();
+    uint32_t tuple = 0;
+    int count = 0;
+    for (size_t i = 0; i < input.size(); ++i) {
+        const char c = input[i];
+        if (c == '~') {
+            break;
+        } else if (c == 'z' && count == 0) {
+            output.append(4, '\0');
+        } else if (c >= '!' && c <= 'u') {
+            tuple = tuple * 85 + (c - '!');
+            if (++count == 5) {
+                for (int shift = 24; shift >= 0; shift -= 8) {
+                    output.push_back(static_cast<char>(tuple >> shift));
+                }
+                tuple = 0;
+                count = 0;
+            }
+        }
+    }
+
+    //  A final partial group is padded with u's, and only its leading bytes kept
+    if (count > 1) {
+        for (int i = count; i < 5; ++i) {
+            tuple = tuple * 85 + 84;
+        }
+        for (int i = 0; i < count - 1; ++i) {
+            output.push_back(static_cast<char>(tuple >> (24 - 8 * i)));
+        }
+    }
+    return true;
+}
+
+bool decodeRunLength(const std::string& input, std::string& output) {
+    output.clear();
+    for (size_t i = 0; i < input.size();) {
+        const uint8_t length = static_cast<uint8_t>(input[i++]);
+        if (length == 128) {
+            break;
+        } else if (length < 128) {
+            const size_t count = std::min(static_cast<size_t>(length) + 1, input.size() - i);
+            output.append(input, i, count);
+            i += count;
+        } else if (i < input.size()) {
+            output.append(257 - length, input[i++]);
+        }
+    }
+    return true;
+}
+
+// Undoes the TIFF and PNG predictors that Flate (and LZW) data may be encoded with, as described by params
+bool unpredict(std::string& data, CGPDFDictionaryRef params) {
+    CGPDFInteger predictor = 1;
+    if (!getInteger(params, "Predictor", predictor) || predictor <= 1) {
+        return true;
+    }
+
+    CGPDFInteger colors = 1;
+    CGPDFInteger bitsPerComponent = 8;
+    CGPDFInteger columns = 1;
+    getInteger(params, "Colors", colors);
+    getInteger(params, "BitsPerComponent", bitsPerComponent);
+    getInteger(params, "Columns", columns);
+    if (colors < 1 || bitsPerComponent < 1 || columns < 1 || colors > INT_MAX || bitsPerComponent > INT_MAX || columns > INT_MAX) {
+        return false;
+    }
+
+    //  Each product of two values no larger than INT_MAX fits in 64 bits, whatever the size of CGPDFInteger
+    const uint64_t bitsPerPixel = static_cast<uint64_t>(colors) * static_cast<uint64_t>(bitsPerComponent);
+    if (bitsPerPixel > INT_MAX || bitsPerPixel * static_cast<uint64_t>(columns) > INT_MAX) {
+        return false;
+    }
+
+    const size_t bytesPerPixel = std::max<size_t>(1, static_cast<size_t>(bitsPerPixel + 7) / 8);
+    const size_t rowLength = static_cast<size_t>(bitsPerPixel * static_cast<uint64_t>(columns) + 7) / 8;
+
+    if (predictor == 2) {
+        if (bitsPerComponent != 8) {
+            return false;
+        }
+
+        for (size_t row = 0; row + rowLength <= data.size(); row += rowLength) {
+            for (size_t i = bytesPerPixel; i < rowLength; ++i) {
+                data[row + i] = static_cast<char>(data[row + i] + data[row + i - bytesPerPixel]);
+            }
+        }
+        return true;
+    }
+
+    //  PNG predictors prefix each row with the filter it was encoded with
+    std::string output;
+    output.reserve(data.size() / (rowLength + 1) * rowLength);
+    std::vector<uint8_t> prior(rowLength, 0);
+    std::vector<uint8_t> current(rowLength);
+    for (size_t row = 0; row + rowLength + 1 <= data.size(); row += rowLength + 1) {
+        const uint8_t filter = static_cast<uint8_t>(data[row]);
+        const uint8_t* input = reinterpret_cast<const uint8_t*>(data.data()) + row + 1;
+        for (size_t i = 0; i < rowLength; ++i) {
+            const int left = i >= bytesPerPixel ? current[i - bytesPerPixel] : 0;
+            const int up = prior[i];
+            const int upLeft = i >= bytesPerPixel ? prior[i - bytesPerPixel] : 0;
+            int value = input[i];
+            switch (filter) {
+                case 1:
+                    value += left;
+                    break;
+                case 2:
+                    value += up;
+                    break;
+                case 3:
+                    value += (left + up) / 2;
+                    break;
+                case 4: {
+                    const int estimate = left + up - upLeft;
+                    const int distanceLeft = abs(estimate - left);
+                    const int distanceUp = abs(estimate - up);
+                    const int distanceUpLeft = abs(estimate - upLeft);
+                    if (distanceLeft <= distanceUp && distanceLeft <= distanceUpLeft) {
+                        value += left;
+                    } else {
+                        value += distanceUp <= distanceUpLeft ? up : upLeft;
+                    }
+                    break;
+                }
+                default:
+                    break;
+            }
+            current[i] = static_cast<uint8_t>(value);
+        }
+
+        output.append(reinterpret_cast<const char*>(current.data()), rowLength);
+        prior.swap(current);
+    }
+
+    data.swap(output);
+    return true;
+}
+
+// The one filter a stream is encoded with, or "" for none, or nullptr for several
+const char* singleFilter(CGPDFStreamRef stream) {
+    const __CGPDFObject* filter = stream->dictionary->Get("Filter");
+    if (!filter) {
+        filter = stream->dictionary->Get("F");
+    }
+
+    if (!filter) {
+        return "";
+    } else if (filter->value.type == kCGPDFObjectTypeName) {
+        return filter->value.name;
+    } else if (filter->value.type == kCGPDFObjectTypeArray) {
+        if (filter->value.array->objects.empty()) {
+            return "";
+        }
+        const __CGPDFObject* first = filter->value.array->Get(0);
+        if (filter->value.array->objects.size() == 1 && first && first->value.type == kCGPDFObjectTypeName) {
+            return first->value.name;
+        }
+    }
+    return nullptr;
+}
+
+} // namespace
+
+CGPDFObjectRef _CGPDFResolve(PDFFile* file, const __CGPDFObject* object) {
+    //  An object may itself be nothing but a reference to another
+    for (int i = 0; object && object->value.type == c_CGPDFObjectTypeReference; ++i) {
+        if (!file || i == 8) {
+            return nullptr;
+        }
+        object = file->Resolve(object->value.reference.number);
+    }
+    return const_cast<CGPDFObjectRef>(object);
+}
+
+bool _CGPDFObjectGetValue(const __CGPDFObject* object, CGPDFObjectType type, void* value) {
+    if (!object) {
+        return false;
+    }
+
+    const CGPDFValue& source = object->value;
+    if (type == kCGPDFObjectTypeReal && source.type == kCGPDFObjectTypeInteger) {
+        if (value) {
+            *static_cast<CGPDFReal*>(value) = static_cast<CGPDFReal>(source.integer);
+        }
+        return true;
+    }
+
+    if (source.type != type) {
+        return false;
+    }
+
+    if (value) {
+        switch (type) {
+            case kCGPDFObjectTypeBoolean:
+                *static_cast<CGPDFBoolean*>(value) = source.boolean;
+                break;
+            case kCGPDFObjectTypeInteger:
+                *static_cast<CGPDFInteger*>(value) = source.integer;
+                break;
+            case kCGPDFObjectTypeReal:
+                *static_cast<CGPDFReal*>(value) = source.real;
+                break;
+            case kCGPDFObjectTypeName:
+                *static_cast<const char**>(value) = source.name;
+                break;
+            case kCGPDFObjectTypeString:
+                *static_cast<CGPDFStringRef*>(value) = source.string;
+                break;
+            case kCGPDFObjectTypeArray:
+                *static_cast<CGPDFArrayRef*>(value) = source.array;
+                break;
+            case kCGPDFObjectTypeDictionary:
+                *static_cast<CGPDFDictionaryRef*>(value) = source.dictionary;
+                break;
+            case kCGPDFObjectTypeStream:
+                *static_cast<CGPDFStreamRef*>(value) = source.stream;
+                break;
+            default:
+                break;
+        }
+    }
+    return true;
+}
+
+bool _CGPDFStreamDecode(CGPDFStreamRef stream, std::string& data, CGPDFDataFormat* format) {
+    if (format) {
+        *format = CGPDFDataFormatRaw;
+    }
+    data.assign(reinterpret_cast<const char*>(stream->data), stream->length);
+
+    //  Inline images abbreviate the keys, and their values
+    const __CGPDFObject* filter = stream->dictionary->Get("Filter");
+    const __CGPDFObject* params = stream->dictionary->Get("DecodeParms");
+    if (!filter) {
+        filter = stream->dictionary->Get("F");
+        params = stream->dictionary->Get("DP");
+    }
+
+    std::vector<const __CGPDFObject*> filters;
+    std::vector<const __CGPDFObject*> parameters;
+    if (filter && filter->value.type == kCGPDFObjectTypeArray) {
+        for (size_t i = 0; i < filter->value.array->objects.size(); ++i) {
+            filters.push_back(filter->value.array->Get(i));
+            parameters.push_back(params && params->value.type == kCGPDFObjectTypeArray ? params->value.array->Get(i) : nullptr);
+        }
+    } else if (filter) {
+        filters.push_back(filter);
+        parameters.push_back(params);
+    }
+
+    std::string decoded;
+    for (size_t i = 0; i < filters.size(); ++i) {
+        const char* name = nullptr;
+        if (!_CGPDFObjectGetValue(filters[i], kCGPDFObjectTypeName, &name)) {
+            return false;
+        }
+
+        CGPDFDictionaryRef filterParams = nullptr;
+        _CGPDFObjectGetValue(parameters[i], kCGPDFObjectTypeDictionary, &filterParams);
+
+        if (strcmp(name, "FlateDecode") == 0 || strcmp(name, "Fl") == 0) {
+            if (!inflateData(data, decoded) || !unpredict(decoded, filterParams)) {
+                return false;
+            }
+        } else if (strcmp(name, "ASCIIHexDecode") == 0 || strcmp(name, "AHx") == 0) {
+            decodeHex(data, decoded);
+        } else if (strcmp(name, "ASCII85Decode") == 0 || strcmp(name, "A85") == 0) {
+            decodeAscii85(data, decoded);
+        } else if (strcmp(name, "RunLengthDecode") == 0 || strcmp(name, "RL") == 0) {
+            decodeRunLength(data, decoded);
+        } else if (strcmp(name, "DCTDecode") == 0 || strcmp(name, "DCT") == 0) {
+            //  Image data is left for image decoders to make sense of
+            if (format) {
+                *format = CGPDFDataFormatJPEGEncoded;
+            }
+            return true;
+        } else if (strcmp(name, "JPXDecode") == 0) {
+            if (format) {
+                *format = CGPDFDataFormatJPEG2000;
+            }
+            return true;
+        } else {
+            return false;
+        }
+        data.swap(decoded);
+    }
+    return true;
+}
+
+CGPDFObjectRef __CGPDFArray::Get(size_t index) const {
+    return index < objects.size() ? _CGPDFResolve(file, &objects[index]) : nullptr;
+}
+
+CGPDFObjectRef __CGPDFDictionary::Get(const char* key) const {
+    for (const auto& entry : entries) {
+        if (strcmp(entry.first, key) == 0) {
+            return _CGPDFResolve(file, &entry.second);
+        }
+    }
+    return nullptr;
+}
+
+const char* PDFObjectArena::Name(const std::string& name) {
+    return _names.insert(name).first->c_str();
+}
+
+CGPDFStringRef PDFObjectArena::String(const std::string& bytes) {
+    _strings.push_back({ bytes });
+    return &_strings.back();
+}
+
+CGPDFArrayRef PDFObjectArena::Array(PDFFile* file) {
+    _arrays.push_back({ file, {} });
+    return &_arrays.back();
+}
+
+CGPDFDictionaryRef PDFObjectArena::Dictionary(PDFFile* file) {
+    _dictionaries.push_back({ file, {} });
+    return &_dictionaries.back();
+}
+
+CGPDFStreamRef PDFObjectArena::Stream(PDFFile* file, CGPDFDictionaryRef dictionary, const uint8_t* data, size_t length) {
+    _streams.push_back({ file, dictionary, data, length });
+    return &_streams.back();
+}
+
+CGPDFObjectRef PDFObjectArena::Object(const __CGPDFObject& object) {
+    _objects.push_back(object);
+    return &_objects.back();
+}
+
+const uint8_t* PDFObjectArena::Data(std::string&& data) {
+    _data.push_back(std::move(data));
+    return reinterpret_cast<const uint8_t*>(_data.back().data());
+}
+
+void PDFObjectArena::Clear() {
+    _strings.clear();
+    _arrays.clear();
+    _dictionaries.clear();
+    _streams.clear();
+    _objects.clear();
+    _data.clear();
+}
+
+bool PDFParser::nextToken(Token& token) {
+    if (_pending > 0) {
+        std::swap(token, _tokens[--_pending]);
+    } else {
+        readToken(token);
+    }
+    return token.type != Token::c_end && token.type != Token::c_error;
+}
+
+void PDFParser::readToken(Token& token) {
+    int c;
+    for (;;) {
+        c = _source.Next();
+        if (c == '%') {
+            while ((c = _source.Peek()) >= 0 && c != '\r' && c != '\n') {
+                _source.Next();
+            }
+        } else if (c < 0 || !isWhitespace(c)) {
+            break;
+        }
+    }
+
+    token.text.clear();
+    switch (c) {
+        case -1:
+            token.type = Token::c_end;
+            return;
+
+        case '[':
+            token.type = Token::c_arrayBegin;
+            return;
+
+        case ']':
+            token.type = Token::c_arrayEnd;
+            return;
+
+        case '(':
+            token.type = Token::c_string;
+            readLiteralString(token.text);
+            return;
+
+        case '<':
+            if (_source.Peek() == '<') {
+                _source.Next();
+                token.type = Token::c_dictionaryBegin;
+            } else {
+                token.type = Token::c_string;
+                readHexString(token.text);
+            }
+            return;
+
+        case '>':
+            token.type = _source.Next() == '>' ? Token::c_dictionaryEnd : Token::c_error;
+            return;
+
+        case '/':
+            token.type = readName(token.text) ? Token::c_name : Token::c_error;
+            return;
+
+        case ')':
+            token.type = Token::c_error;
+            return;
+
+        case '{':
+        case '}':
+            //  Calculator functions' braces
+            token.type = Token::c_keyword;
+            token.text.push_back(static_cast<char>(c));
+            return;
+
+        default:
+            break;
+    }
+
+    token.text.push_back(static_cast<char>(c));
+    while (isRegular(_source.Peek())) {
+        token.text.push_back(static_cast<char>(_source.Next()));
+    }
+
+    //  Numbers are an optional sign, then digits with at most one point among them
+    const char* text = token.text.c_str();
+    const char* digits = (*text == '+' || *text == '-') ? text + 1 : text;
+    bool point = false;
+    bool digit = false;
+    bool number = *digits != '\0';
+    for (const char* p = digits; *p && number; ++p) {
+        if (*p == '.' && !point) {
+            point = true;
+        } else if (*p >= '0' && *p <= '9') {
+            digit = true;
+        } else {
+            number = false;
+        }
+    }
+
+    if (!number || !digit) {
+        token.type = Token::c_keyword;
+    } else if (point || digits[strspn(digits, "0123456789")] != '\0' || strlen(digits) > 18) {
+        token.type = Token::c_real;
+        token.real = static_cast<CGPDFReal>(strtod(text, nullptr));
+    } else {
+        //  Integers that CGPDFInteger can't hold are read as reals, as longer ones are
+        const long long value = strtoll(text, nullptr, 10);
+        if (value < LONG_MIN || value > LONG_MAX) {
+            token.type = Token::c_real;
+            token.real = static_cast<CGPDFReal>(value);
+        } else {
+            token.type = Token::c_integer;
+            token.integer = static_cast<CGPDFInteger>(value);
+        }
+    }
+}
+
+void PDFParser::readLiteralString(std::string& text) {
+    int nesting = 1;
+    for (int c; (c = _source.Next()) >= 0;) {
+        switch (c) {
+            case '(':
+                ++nesting;
+                break;
+
+            case ')':
+                if (--nesting == 0) {
+                    return;
+                }
+                break;
+
+            case '\r':
+                //  Any end of line is read as a line feed
+                if (_source.Peek() == '\n') {
+                    _source.Next();
+                }
+                c = '\n';
+                break;
+
+            case '\\':
+                c = _source.Next();
+                switch (c) {
+                    case 'n':
+                        c = '\n';
+                        break;
+                    case 'r':
+                        c = '\r';
+                        break;
+                    case 't':
+                        c = '\t';
+                        break;
+                    case 'b':
+                        c = '\b';
+                        break;
+                    case 'f':
+                        c = '\f';
+                        break;
+                    case '\r':
+                        if (_source.Peek() == '\n') {
+                            _source.Next();
+                        }
+                        continue;
+                    case '\n':
+                        continue;
+                    case -1:
+                        return;
+                    default:
+                        if (c >= '0' && c <= '7') {
+                            int value = c - '0';
+                            for (int i = 0; i < 2 && _source.Peek() >= '0' && _source.Peek() <= '7'; ++i) {
+                                value = value * 8 + (_source.Next() - '0');
+                            }
+                            c = value & 0xff;
+                        }
+                        break;
+                }
+                break;
+
+            default:
+                break;
+        }
+        text.push_back(static_cast<char>(c));
+    }
+}
+
+void PDFParser::readHexString(std::string& text) {
+    int high = -1;
+    for (int c; (c = _source.Next()) >= 0 && c != '>';) {
+        const int value = hexValue(c);
+        if (value < 0) {
+            continue;
+        }
+
+        if (high < 0) {
+            high = value;
+        } else {
+            text.push_back(static_cast<char>(high << 4 | value));
+            high = -1;
+        }
+    }
+
+    if (high >= 0) {
+        text.push_back(static_cast<char>(high << 4));
+    }
+}
+
+bool PDFParser::readName(std::string& text) {
+    while (isRegular(_source.Peek())) {
+        int c = _source.Next();
+        if (c == '#') {
+            const int high = hexValue(_source.Peek());
+            if (high >= 0) {
+                _source.Next();
+                const int low = hexValue(_source.Peek());
+                if (low >= 0) {
+                    _source.Next();
+                    c = high << 4 | low;
+                }
+            }
+        }
+        text.push_back(static_cast<char>(c));
+    }
+    return true;
+}
+
+PDFParser::Result PDFParser::Next(__CGPDFObject& object) {
+    Token token;
+    if (!nextToken(token)) {
+        return token.type == Token::c_end ? c_end : c_error;
+    }
+    return parse(token, object, 0);
+}
+
+PDFParser::Result PDFParser::parse(Token& token, __CGPDFObject& object, int depth) {
+    if (depth > c_maximumNesting) {
+        return c_error;
+    }
+
+    switch (token.type) {
+        case Token::c_integer: {
+            object.value.type = kCGPDFObjectTypeInteger;
+            object.value.integer = token.integer;
+            if (!_file || token.integer < 0) {
+                return c_object;
+            }
+
+            //  A reference looks like two integers until its R
+            Token generation;
+            if (nextToken(generation) && generation.type == Token::c_integer && generation.integer >= 0) {
+                Token keyword;
+                if (nextToken(keyword) && keyword.type == Token::c_keyword && keyword.text == "R") {
+                    object.value.type = c_CGPDFObjectTypeReference;
+                    object.value.reference.number = static_cast<uint32_t>(token.integer);
+                    object.value.reference.generation = static_cast<uint32_t>(generation.integer);
+                    return c_object;
+                }
+                std::swap(_tokens[_pending++], keyword);
+            }
+            std::swap(_tokens[_pending++], generation);
+            return c_object;
+        }
+
+        case Token::c_real:
+            object.value.type = kCGPDFObjectTypeReal;
+            object.value.real = token.real;
+            return c_object;
+
+        case Token::c_name:
+            object.value.type = kCGPDFObjectTypeName;
+            object.value.name = _arena.Name(token.text);
+            return c_object;
+
+        case Token::c_string:
+            object.value.type = kCGPDFObjectTypeString;
+            object.value.string = _arena.String(token.text);
+            return c_object;
+
+        case Token::c_arrayBegin: {
+            CGPDFArrayRef array = _arena.Array(_file);
+            for (Token element; nextToken(element) && element.type != Token::c_arrayEnd;) {
+                __CGPDFObject value;
+                const Result result = parse(element, value, depth + 1);
+                if (result == c_error) {
+                    return c_error;
+                } else if (result == c_object) {
+                    array->objects.push_back(value);
+                }
+            }
+
+            object.value.type = kCGPDFObjectTypeArray;
+            object.value.array = array;
+            return c_object;
+        }
+
+        case Token::c_dictionaryBegin: {
+            CGPDFDictionaryRef dictionary = _arena.Dictionary(_file);
+            for (Token key; nextToken(key) && key.type != Token::c_dictionaryEnd;) {
+                if (key.type != Token::c_name) {
+                    return c_error;
+                }
+
+                Token valueToken;
+                if (!nextToken(valueToken) || valueToken.type == Token::c_dictionaryEnd) {
+                    break;
+                }
+
+                __CGPDFObject value;
+                const Result result = parse(valueToken, value, depth + 1);
+                if (result == c_error) {
+                    return c_error;
+                }
+
+                //  A null value is the same as no entry at all
+                if (result == c_object && value.value.type != kCGPDFObjectTypeNull) {
+                    dictionary->entries.emplace_back(_arena.Name(key.text), value);
+                }
+            }
+
+            object.value.type = kCGPDFObjectTypeDictionary;
+            object.value.dictionary = dictionary;
+            return c_object;
+        }
+
+        case Token::c_keyword:
+            if (token.text == "true" || token.text == "false") {
+                object.value.type = kCGPDFObjectTypeBoolean;
+                object.value.boolean = token.text == "true";
+                return c_object;
+            } else if (token.text == "null") {
+                object.value.type = kCGPDFObjectTypeNull;
+                return c_object;
+            }
+
+            _keyword.swap(token.text);
+            return c_keyword;
+
+        default:
+            return c_error;
+    }
+}
+
+PDFParser::Result PDFParser::ReadInlineImage(__CGPDFObject& object) {
+    CGPDFDictionaryRef dictionary = _arena.Dictionary(_file);
+    for (;;) {
+        __CGPDFObject key;
+        const Result result = Next(key);
+        if (result == c_keyword && _keyword == "ID") {
+            break;
+        } else if (result != c_object || key.value.type != kCGPDFObjectTypeName) {
+            return c_error;
+        }
+
+        __CGPDFObject value;
+        if (Next(value) != c_object) {
+            return c_error;
+        }
+        dictionary->entries.emplace_back(key.value.name, value);
+    }
+
+    //  The data starts after a single whitespace character, and ends before EI on its own
+    _source.Next();
+    std::string data;
+    for (;;) {
+        const int c = _source.Next();
+        if (c < 0) {
+            return c_error;
+        }
+        data.push_back(static_cast<char>(c));
+
+        const size_t length = data.size();
+        if (length >= 3 && data[length - 1] == 'I' && data[length - 2] == 'E' && isWhitespace(static_cast<uint8_t>(data[length - 3])) &&
+            !isRegular(_source.Peek())) {
+            data.resize(length - 3);
+            break;
+        }
+    }
+
+    const size_t length = data.size();
+    object.value.type = kCGPDFObjectTypeStream;
+    object.value.stream = _arena.Stream(_file, dictionary, _arena.Data(std::move(data)), length);
+    return c_object;
+}
+
+PDFFile::PDFFile(const uint8_t* data, size_t length, CGPDFDocumentRef document) : _data(data), _length(length), _document(document) {
+}
+
+PDFFile::~PDFFile() {
+}
+
+bool PDFFile::Open() {
+    std::lock_guard<std::recursive_mutex> lock(_lock);
+
+    const uint8_t* end = _data + _length;
+    const uint8_t* header = findBytes(_data, std::min(end, _data + 1024), "%PDF-");
+    if (header) {
+        _majorVersion = atoi(reinterpret_cast<const char*>(header) + 5);
+        const uint8_t* point = findBytes(header, std::min(end, header + 16), ".");
+        _minorVersion = point ? atoi(reinterpret_cast<const char*>(point) + 1) : 0;
+    }
+
+    //  The last startxref points at the newest cross-reference section
+    const uint8_t* tail = _length > c_startxrefSearchLength ? end - c_startxrefSearchLength : _data;
+    const uint8_t* startxref = nullptr;
+    for (const uint8_t* found = tail; (found = findBytes(found, end, "startxref")) != nullptr; found += 9) {
+        startxref = found;
+    }
+
+    bool opened = false;
+    if (startxref) {
+        PDFMemorySource source(_data, _length);
+        source.Seek(startxref - _data + 9);
+        PDFParser parser(source, _arena, nullptr);
+        __CGPDFObject offset;
+        opened = parser.Next(offset) == PDFParser::c_object && offset.value.type == kCGPDFObjectTypeInteger && offset.value.integer >= 0 &&
+                 readXref(static_cast<size_t>(offset.value.integer)) && Catalog();
+    }
+
+    return opened || (repair() && Catalog());
+}
+
+bool PDFFile::readXref(size_t offset) {
+    std::unordered_set<size_t> visited;
+    for (;;) {
+        if (offset >= _length || !visited.insert(offset).second) {
+            return false;
+        }
+
+        PDFMemorySource source(_data, _length);
+        source.Seek(offset);
+        PDFParser parser(source, _arena, this);
+
+        CGPDFDictionaryRef trailer = nullptr;
+        __CGPDFObject object;
+        if (parser.Next(object) == PDFParser::c_keyword && parser.Keyword() == "xref") {
+            if (!readXrefTable(source) || parser.Next(object) != PDFParser::c_object ||
+                object.value.type != kCGPDFObjectTypeDictionary) {
+                return false;
+            }
+            trailer = object.value.dictionary;
+
+            //  Hybrid files list the objects in object streams in a cross-reference stream too
+            CGPDFInteger streamOffset;
+            if (getInteger(trailer, "XRefStm", streamOffset) && streamOffset >= 0) {
+                readXrefStream(static_cast<size_t>(streamOffset), nullptr);
+            }
+        } else if (!readXrefStream(offset, &trailer)) {
+            return false;
+        }
+
+        if (!_trailer || !_trailer->Get("Root")) {
+            _trailer = trailer;
+        }
+
+        CGPDFInteger previous;
+        if (!getInteger(trailer, "Prev", previous) || previous < 0) {
+            return _trailer != nullptr;
+        }
+        offset = static_cast<size_t>(previous);
+    }
+}
+
+bool PDFFile::readXrefTable(PDFMemorySource& source) {
+    //  Subsection headers are read without looking ahead for references, so that the entries after them can be read directly
+    PDFParser parser(source, _arena, nullptr);
+    for (;;) {
+        __CGPDFObject start;
+        __CGPDFObject count;
+        const PDFParser::Result result = parser.Next(start);
+        if (result == PDFParser::c_keyword && parser.Keyword() == "trailer") {
+            return true;
+        } else if (result != PDFParser::c_object || start.value.type != kCGPDFObjectTypeInteger || start.value.integer < 0 ||
+                   parser.Next(count) != PDFParser::c_object || count.value.type != kCGPDFObjectTypeInteger || count.value.integer < 0) {
+            return false;
+        }
+
+        for (CGPDFInteger i = 0; i < count.value.integer; ++i) {
+            uint64_t offset;
+            uint32_t generation;
+            bool inUse;
+            if (!readXrefEntry(source, offset, generation, inUse)) {
+                return false;
+            }
+
+            if (inUse && offset > 0) {
+                setEntry(static_cast<uint32_t>(start.value.integer + i), { XrefEntry::c_inUse, generation, offset });
+            }
+        }
+    }
+}
+
+bool PDFFile::readXrefStream(size_t offset, CGPDFDictionaryRef* trailer) {
+    const __CGPDFObject* object = parseIndirect(offset, UINT32_MAX);
+    CGPDFStreamRef stream = nullptr;
+    if (!_CGPDFObjectGetValue(object, kCGPDFObjectTypeStream, &stream)) {
+        return false;
+    }
+
+    CGPDFDictionaryRef dictionary = stream->dictionary;
+    CGPDFArrayRef widths = nullptr;
+    CGPDFInteger size = 0;
+    if (!_CGPDFObjectGetValue(dictionary->Get("W"), kCGPDFObjectTypeArray, &widths) || widths->objects.size() < 3 ||
+        !getInteger(dictionary, "Size", size)) {
+        return false;
+    }
+
+    CGPDFInteger width[3];
+    for (size_t i = 0; i < 3; ++i) {
+        if (!_CGPDFObjectGetValue(widths->Get(i), kCGPDFObjectTypeInteger, &width[i]) || width[i] < 0 || width[i] > 8) {
+            return false;
+        }
+    }
+
+    std::vector<CGPDFInteger> sections;
+    CGPDFArrayRef index = nullptr;
+    if (_CGPDFObjectGetValue(dictionary->Get("Index"), kCGPDFObjectTypeArray, &index)) {
+        for (size_t i = 0; i < index->objects.size(); ++i) {
+            CGPDFInteger value = 0;
+            _CGPDFObjectGetValue(index->Get(i), kCGPDFObjectTypeInteger, &value);
+            sections.push_back(value);
+        }
+    } else {
+        sections = { 0, size };
+    }
+
+    std::string data;
+    if (!_CGPDFStreamDecode(stream, data, nullptr)) {
+        return false;
+    }
+
+    const size_t entryLength = static_cast<size_t>(width[0] + width[1] + width[2]);
+    const uint8_t* entry = reinterpret_cast<const uint8_t*>(data.data());
+    const uint8_t* end = entry + data.size();
+    auto field = [&entry](CGPDFInteger width, uint64_t defaultValue) {
+        uint64_t value = width ? 0 : defaultValue;
+        for (CGPDFInteger i = 0; i < width; ++i) {
+            value = value << 8 | *entry++;
+        }
+        return value;
+    };
+
+    for (size_t section = 0; section + 1 < sections.size(); section += 2) {
+        for (CGPDFInteger i = 0; i < sections[section + 1] && entry + entryLength <= end; ++i) {
+            const uint64_t type = field(width[0], 1);
+            const uint64_t second = field(width[1], 0);
+            const uint64_t third = field(width[2], 0);
+            const uint32_t number = static_cast<uint32_t>(sections[section] + i);
+            if (type == 1) {
+                setEntry(number, { XrefEntry::c_inUse, static_cast<uint32_t>(third), second });
+            } else if (type == 2) {
+                setEntry(number, { XrefEntry::c_compressed, static_cast<uint32_t>(third), second });
+            }
+        }
+    }
+
+    if (trailer) {
+        *trailer = dictionary;
+    }
+    return true;
+}
+
+void PDFFile::setEntry(uint32_t number, XrefEntry entry) {
+    if (number >= c_maximumObjectNumber) {
+        return;
+    }
+
+    if (number >= _xref.size()) {
+        _xref.resize(number + 1, { XrefEntry::c_free, 0, 0 });
+    }
+
+    //  Sections are read newest first, so an object's first entry is the one that counts
+    if (_xref[number].type == XrefEntry::c_free) {
+        _xref[number] = entry;
+    }
+}
+
+// Rebuilds the cross-reference table of a damaged file by finding every "number generation obj" in it
+bool PDFFile::repair() {
+    _xref.clear();
+    _objects.clear();
+    _resolving.clear();
+    _objectStreams.clear();
+    _trailer = nullptr;
+
+    const uint8_t* end = _data + _length;
+    std::vector<std::pair<uint32_t, size_t>> found;
+    for (const uint8_t* keyword = _data; (keyword = findBytes(keyword, end, "obj")) != nullptr; keyword += 3) {
+        if (keyword + 3 < end && isRegular(keyword[3])) {
+            continue;
+        }
+
+        const uint8_t* p = keyword;
+        auto skipBack = [&p, this](bool (*test)(int)) {
+            const uint8_t* start = p;
+            while (p > _data && test(p[-1])) {
+                --p;
+            }
+            return p != start;
+        };
+        auto isDigit = [](int c) { return c >= '0' && c <= '9'; };
+
+        if (skipBack(isWhitespace) && skipBack(isDigit) && skipBack(isWhitespace) && skipBack(isDigit) &&
+            (p == _data || !isRegular(p[-1]))) {
+            const unsigned long number = strtoul(reinterpret_cast<const char*>(p), nullptr, 10);
+            if (number < c_maximumObjectNumber) {
+                found.emplace_back(static_cast<uint32_t>(number), p - _data);
+            }
+        }
+    }
+
+    //  Later definitions of an object replace earlier ones
+    for (auto it = found.rbegin(); it != found.rend(); ++it) {
+        setEntry(it->first, { XrefEntry::c_inUse, 0, it->second });
+    }
+
+    //  Objects in object streams can only be found through the streams
+    CGPDFDictionaryRef catalogTrailer = nullptr;
+    for (const auto& object : found) {
+        const __CGPDFObject* resolved = Resolve(object.first);
+        CGPDFStreamRef stream = nullptr;
+        CGPDFDictionaryRef dictionary = nullptr;
+        if (_CGPDFObjectGetValue(resolved, kCGPDFObjectTypeStream, &stream)) {
+            if (isName(stream->dictionary->Get("Type"), "ObjStm")) {
+                std::shared_ptr<ObjectStream> objects = objectStream(object.first);
+                for (size_t i = 0; objects && i < objects->objects.size(); ++i) {
+                    setEntry(objects->objects[i].first, { XrefEntry::c_compressed, static_cast<uint32_t>(i), object.first });
+                }
+            } else if (isName(stream->dictionary->Get("Type"), "XRef") && stream->dictionary->Get("Root")) {
+                _trailer = stream->dictionary;
+            }
+        } else if (_CGPDFObjectGetValue(resolved, kCGPDFObjectTypeDictionary, &dictionary) && isName(dictionary->Get("Type"), "Catalog")) {
+            catalogTrailer = _arena.Dictionary(this);
+            __CGPDFObject root;
+            root.value.type = c_CGPDFObjectTypeReference;
+            root.value.reference.number = object.first;
+            root.value.reference.generation = 0;
+            catalogTrailer->entries.emplace_back(_arena.Name("Root"), root);
+        }
+    }
+
+    for (const uint8_t* keyword = _data; (keyword = findBytes(keyword, end, "trailer")) != nullptr; keyword += 7) {
+        PDFMemorySource source(_data, _length);
+        source.Seek(keyword - _data + 7);
+        PDFParser parser(source, _arena, this);
+        __CGPDFObject trailer;
+        if (parser.Next(trailer) == PDFParser::c_object && trailer.value.type == kCGPDFObjectTypeDictionary &&
+            trailer.value.dictionary->Get("Root")) {
+            _trailer = trailer.value.dictionary;
+        }
+    }
+
+    if (!_trailer) {
+        _trailer = catalogTrailer;
+    }
+    return _trailer != nullptr;
+}
+
+CGPDFObjectRef PDFFile::Resolve(uint32_t number) {
+    std::lock_guard<std::recursive_mutex> lock(_lock);
+    if (number >= _xref.size()) {
+        return nullptr;
+    }
+
+    if (_objects.size() < _xref.size()) {
+        _objects.resize(_xref.size(), nullptr);
+        _resolving.resize(_xref.size(), false);
+    }
+
+    if (_objects[number] || _resolving[number]) {
+        return _objects[number];
+    }
+
+    const XrefEntry entry = _xref[number];
+    _resolving[number] = true;
+    CGPDFObjectRef object = nullptr;
+    if (entry.type == XrefEntry::c_inUse) {
+        object = parseIndirect(static_cast<size_t>(entry.offset), number);
+    } else if (entry.type == XrefEntry::c_compressed) {
+        object = parseCompressed(static_cast<uint32_t>(entry.offset), entry.generation, number);
+    }
+    _resolving[number] = false;
+
+    if (object) {
+        _objects[number] = object;
+        ++_parsedCount;
+    }
+    return object;
+}
+
+// Parses "number generation obj", the object, and for a stream its data, at offset. Any number is accepted for UINT32_MAX.
+CGPDFObjectRef PDFFile::parseIndirect(size_t offset, uint32_t number) {
+    if (offset >= _length) {
+        return nullptr;
+    }
+
+    PDFMemorySource source(_data, _length);
+    source.Seek(offset);
+    PDFParser parser(source, _arena, this);
+
+    __CGPDFObject objectNumber;
+    __CGPDFObject generation;
+    if (parser.Next(objectNumber) != PDFParser::c_object || objectNumber.value.type != kCGPDFObjectTypeInteger ||
+        parser.Next(generation) != PDFParser::c_object || generation.value.type != kCGPDFObjectTypeInteger ||
+        parser.Next(generation) != PDFParser::c_keyword || parser.Keyword() != "obj" ||
+        (number != UINT32_MAX && objectNumber.value.integer != static_cast<CGPDFInteger>(number))) {
+        return nullptr;
+    }
+
+    __CGPDFObject object;
+    const PDFParser::Result result = parser.Next(object);
+    if (result == PDFParser::c_keyword && parser.Keyword() == "endobj") {
+        object.value.type = kCGPDFObjectTypeNull;
+    } else if (result != PDFParser::c_object) {
+        return nullptr;
+    }
+
+    if (object.value.type == kCGPDFObjectTypeDictionary) {
+        __CGPDFObject keyword;
+        if (parser.Next(keyword) == PDFParser::c_keyword && parser.Keyword() == "stream" &&
+            !readStream(source, object.value.dictionary, object)) {
+            return nullptr;
+        }
+    }
+
+    return _arena.Object(object);
+}
+
+bool PDFFile::readStream(PDFMemorySource& source, CGPDFDictionaryRef dictionary, __CGPDFObject& object) {
+    //  The data starts after the end of line that follows the keyword
+    if (source.Peek() == '\r') {
+        source.Next();
+    }
+    if (source.Peek() == '\n') {
+        source.Next();
+    }
+
+    const size_t start = source.Offset();
+    const uint8_t* end = _data + _length;
+
+    //  A length that doesn't end at endstream is wrong, and the data runs to endstream instead
+    CGPDFInteger length = -1;
+    getInteger(dictionary, "Length", length);
+    bool valid = length >= 0 && static_cast<uint64_t>(length) <= _length - start;
+    if (valid) {
+        const uint8_t* p = _data + start + length;
+        while (p < end && isWhitespace(*p)) {
+            ++p;
+        }
+        valid = static_cast<size_t>(end - p) >= 9 && memcmp(p, "endstream", 9) == 0;
+    }
+
+    if (!valid) {
+        const uint8_t* found = findBytes(_data + start, end, "endstream");
+        if (!found) {
+            return false;
+        }
+
+        if (found > _data + start && found[-1] == '\n') {
+            --found;
+        }
+        if (found > _data + start && found[-1] == '\r') {
+            --found;
+        }
+        length = found - (_data + start);
+    }
+
+    object.value.type = kCGPDFObjectTypeStream;
+    object.value.stream = _arena.Stream(this, dictionary, _data + start, static_cast<size_t>(length));
+    return true;
+}
+
+CGPDFObjectRef PDFFile::parseCompressed(uint32_t streamNumber, uint32_t index, uint32_t number) {
+    std::shared_ptr<ObjectStream> stream = objectStream(streamNumber);
+    if (!stream) {
+        return nullptr;
+    }
+
+    //  The index is only a hint
+    size_t offset = SIZE_MAX;
+    if (index < stream->objects.size() && stream->objects[index].first == number) {
+        offset = stream->objects[index].second;
+    } else {
+        for (const auto& object : stream->objects) {
+            if (object.first == number) {
+                offset = object.second;
+            }
+        }
+    }
+
+    if (offset >= stream->data.size()) {
+        return nullptr;
+    }
+
+    PDFMemorySource source(reinterpret_cast<const uint8_t*>(stream->data.data()), stream->data.size());
+    source.Seek(offset);
+    PDFParser parser(source, _arena, this);
+    __CGPDFObject object;
+    if (parser.Next(object) != PDFParser::c_object) {
+        return nullptr;
+    }
+    return _arena.Object(object);
+}
+
+std::shared_ptr<PDFFile::ObjectStream> PDFFile::objectStream(uint32_t number) {
+    for (auto it = _objectStreams.begin(); it != _objectStreams.end(); ++it) {
+        if (it->first == number) {
+            _objectStreams.splice(_objectStreams.begin(), _objectStreams, it);
+            return it->second;
+        }
+    }
+
+    CGPDFStreamRef stream = nullptr;
+    CGPDFInteger count = 0;
+    CGPDFInteger first = 0;
+    if (!_CGPDFObjectGetValue(Resolve(number), kCGPDFObjectTypeStream, &stream) || !getInteger(stream->dictionary, "N", count) ||
+        !getInteger(stream->dictionary, "First", first) || count < 0 || first < 0) {
+        return nullptr;
+    }
+
+    auto objects = std::make_shared<ObjectStream>();
+    if (!_CGPDFStreamDecode(stream, objects->data, nullptr)) {
+        return nullptr;
+    }
+
+    //  The stream starts with pairs of object number and offset from First
+    PDFMemorySource source(reinterpret_cast<const uint8_t*>(objects->data.data()),
+                           std::min(objects->data.size(), static_cast<size_t>(first)));
+    PDFObjectArena arena;
+    PDFParser parser(source, arena, nullptr);
+    for (CGPDFInteger i = 0; i < count; ++i) {
+        __CGPDFObject objectNumber;
+        __CGPDFObject offset;
+        if (parser.Next(objectNumber) != PDFParser::c_object || objectNumber.value.type != kCGPDFObjectTypeInteger ||
+            parser.Next(offset) != PDFParser::c_object || offset.value.type != kCGPDFObjectTypeInteger) {
+            break;
+        }
+        objects->objects.emplace_back(static_cast<uint32_t>(objectNumber.value.integer), static_cast<size_t>(first + offset.value.integer));
+    }
+
+    _objectStreams.emplace_front(number, objects);
+    if (_objectStreams.size() > c_objectStreamCacheSize) {
+        _objectStreams.pop_back();
+    }
+    return objects;
+}
+
+CGPDFDictionaryRef PDFFile::Catalog() {
+    return getDictionary(_trailer, "Root");
+}
+
+void PDFFile::GetVersion(int* major, int* minor) const {
+    if (major) {
+        *major = _majorVersion;
+    }
+    if (minor) {
+        *minor = _minorVersion;
+    }
+}
+
+size_t PDFFile::PageCount() {
+    //  Every page is an object of its own, so a larger /Count can only be wrong
+    CGPDFInteger count = 0;
+    if (!getInteger(getDictionary(Catalog(), "Pages"), "Count", count) || count <= 0) {
+        return 0;
+    }
+
+    return std::min(static_cast<size_t>(count), _xref.size());
+}
+
+const std::vector<size_t>& PDFFile::pageTreeOffsets(CGPDFDictionaryRef node, CGPDFArrayRef kids) {
+    auto found = _pageTreeOffsets.find(node);
+    if (found != _pageTreeOffsets.end()) {
+        return found->second;
+    }
+
+    std::vector<size_t> offsets;
+    offsets.reserve(kids->objects.size() + 1);
+    size_t total = 0;
+    for (size_t i = 0; i < kids->objects.size(); ++i) {
+        offsets.emplace_back(total);
+
+        CGPDFDictionaryRef kid = nullptr;
+        if (!_CGPDFObjectGetValue(kids->Get(i), kCGPDFObjectTypeDictionary, &kid)) {
+            continue;
+        }
+
+        //  Pages count for one; intermediate nodes without a usable /Count for none
+        CGPDFInteger kidCount = 1;
+        if (kid->Get("Kids") && !getInteger(kid, "Count", kidCount)) {
+            kidCount = 0;
+        }
+        total += std::min(static_cast<size_t>(std::max<CGPDFInteger>(kidCount, 0)), _xref.size());
+    }
+    offsets.emplace_back(total);
+
+    return _pageTreeOffsets.emplace(node, std::move(offsets)).first->second;
+}
+
+CGPDFPageRef PDFFile::Page(size_t number) {
+    std::lock_guard<std::recursive_mutex> lock(_lock);
+    const size_t count = PageCount();
+    if (number < 1 || number > count) {
+        return nullptr;
+    }
+
+    if (_pages.size() < count) {
+        _pages.resize(count);
+    }
+    if (_pages[number - 1]) {
+        return _pages[number - 1].get();
+    }
+
+    std::unique_ptr<__CGPDFPage> page(new __CGPDFPage{ _document, number, nullptr, nullptr, nullptr, nullptr, 0 });
+    CGPDFDictionaryRef node = getDictionary(Catalog(), "Pages");
+    size_t index = number - 1;
+    for (int depth = 0; node && depth < c_maximumPageTreeDepth; ++depth) {
+        //  Pages inherit these from their ancestors
+        if (CGPDFDictionaryRef resources = getDictionary(node, "Resources")) {
+            page->resources = resources;
+        }
+        if (const __CGPDFObject* mediaBox = node->Get("MediaBox")) {
+            page->mediaBox = mediaBox;
+        }
+        if (const __CGPDFObject* cropBox = node->Get("CropBox")) {
+            page->cropBox = cropBox;
+        }
+        getInteger(node, "Rotate", page->rotation);
+
+        CGPDFArrayRef kids = nullptr;
+        if (!_CGPDFObjectGetValue(node->Get("Kids"), kCGPDFObjectTypeArray, &kids)) {
+            if (index == 0) {
+                page->dictionary = node;
+            }
+            break;
+        }
+
+        //  The last kid whose pages start at or before the one wanted; kids without pages share the next one's offset
+        const std::vector<size_t>& offsets = pageTreeOffsets(node, kids);
+        if (index >= offsets.back()) {
+            break;
+        }
+
+        const size_t kid = std::upper_bound(offsets.begin(), offsets.end() - 1, index) - offsets.begin() - 1;
+        CGPDFDictionaryRef next = nullptr;
+        _CGPDFObjectGetValue(kids->Get(kid), kCGPDFObjectTypeDictionary, &next);
+        index -= offsets[kid];
+        node = next;
+    }
+
+    if (!page->dictionary) {
+        return nullptr;
+    }
+
+    page->rotation = ((page->rotation / 90 * 90) % 360 + 360) % 360;
+    _pages[number - 1] = std::move(page);
+    return _pages[number - 1].get();
+}
+
+struct PDFContentSource::Inflater {
+    z_stream stream;
+    uint8_t window[c_contentWindowSize];
+};
+
+PDFContentSource::PDFContentSource(const std::vector<CGPDFStreamRef>& streams) : _streams(streams) {
+}
+
+PDFContentSource::~PDFContentSource() {
+    endInflate();
+}
+
+void PDFContentSource::endInflate() {
+    if (_inflater) {
+        inflateEnd(&_inflater->stream);
+        _inflater.reset();
+    }
+}
+
+bool PDFContentSource::Refill() {
+    for (;;) {
+        if (_inflater) {
+            z_stream& stream = _inflater->stream;
+            stream.next_out = _inflater->window;
+            stream.avail_out = sizeof(_inflater->window);
+            const int result = inflate(&stream, Z_NO_FLUSH);
+            const size_t produced = sizeof(_inflater->window) - stream.avail_out;
+            if (produced > 0) {
+                _position = _inflater->window;
+                _end = _position + produced;
+                if (result != Z_OK) {
+                    //  Whatever came before the end, or an error, is still read
+                    stream.avail_in = 0;
+                }
+                return true;
+            }
+            endInflate();
+        }
+
+        //  The streams of a page's contents are read as though one, with whitespace between them
+        if (_separate) {
+            _separate = false;
+            _position = &c_streamSeparator;
+            _end = _position + 1;
+            return true;
+        }
+
+        if (_next >= _streams.size()) {
+            return false;
+        }
+
+        if (startStream()) {
+            return true;
+        }
+    }
+}
+
+// Sets up the window for the next stream, returning false when there's nothing in it yet
+bool PDFContentSource::startStream() {
+    CGPDFStreamRef stream = _streams[_next++];
+    _separate = true;
+
+    const char* filter = singleFilter(stream);
+    CGPDFDictionaryRef params = getDictionary(stream->dictionary, "DecodeParms");
+    CGPDFInteger predictor = 1;
+    if (filter && *filter == '\0') {
+        _position = stream->data;
+        _end = stream->data + stream->length;
+        return stream->length > 0;
+    } else if (filter && (strcmp(filter, "FlateDecode") == 0 || strcmp(filter, "Fl") == 0) &&
+               (!getInteger(params, "Predictor", predictor) || predictor <= 1)) {
+        _inflater.reset(new Inflater());
+        if (inflateInit(&_inflater->stream) != Z_OK) {
+            _inflater.reset();
+            return false;
+        }
+        _inflater->stream.next_in = const_cast<Bytef*>(stream->data);
+        _inflater->stream.avail_in = static_cast<uInt>(stream->length);
+        return false;
+    }
+
+    //  Anything else is decoded whole
+    if (!_CGPDFStreamDecode(stream, _decoded, nullptr)) {
+        _decoded.clear();
+    }
+    _position = reinterpret_cast<const uint8_t*>(_decoded.data());
+    _end = _position + _decoded.size();
+    return !_decoded.empty();
+}
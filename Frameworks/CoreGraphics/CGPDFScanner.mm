@@ -14,130 +14,181 @@
 //
 //******************************************************************************
 
-#import <StubReturn.h>
 #import <CoreGraphics/CGPDFScanner.h>
+#import "CGPDFInternal.h"
+
+static bool __CGPDFScannerPop(CGPDFScannerRef scanner, CGPDFObjectType type, void* value) {
+    if (!scanner || scanner->operands.empty()) {
+        return false;
+    }
+
+    //  The operand is popped whether or not it's of the type asked for, as it is on the reference platform
+    const __CGPDFObject operand = scanner->operands.back();
+    scanner->operands.pop_back();
+    return _CGPDFObjectGetValue(&operand, type, value);
+}
 
 /**
- @Status Stub
- @Notes
+ @Status Interoperable
 */
 CGPDFScannerRef CGPDFScannerCreate(CGPDFContentStreamRef cs, CGPDFOperatorTableRef table, void* info) {
-    UNIMPLEMENTED();
-    return StubReturn();
+    CGPDFScannerRef scanner = _CGPDFRetain(new __CGPDFScanner());
+    scanner->contentStream = CGPDFContentStreamRetain(cs);
+    scanner->table = CGPDFOperatorTableRetain(table);
+    scanner->info = info;
+    return scanner;
 }
 
 /**
- @Status Stub
- @Notes
+ @Status Interoperable
 */
 CGPDFScannerRef CGPDFScannerRetain(CGPDFScannerRef scanner) {
-    UNIMPLEMENTED();
-    return StubReturn();
+    return _CGPDFRetain(scanner);
 }
 
 /**
- @Status Stub
- @Notes
+ @Status Interoperable
 */
 void CGPDFScannerRelease(CGPDFScannerRef scanner) {
-    UNIMPLEMENTED();
+    if (!_CGPDFRelease(scanner)) {
+        return;
+    }
+
+    CGPDFContentStreamRelease(scanner->contentStream);
+    CGPDFOperatorTableRelease(scanner->table);
+    delete scanner;
 }
 
 /**
- @Status Stub
- @Notes
+ @Status Interoperable
+ @Notes Compressed content is decoded a window at a time as it's scanned, rather than all at once
 */
 bool CGPDFScannerScan(CGPDFScannerRef scanner) {
-    UNIMPLEMENTED();
-    return StubReturn();
+    if (!scanner || !scanner->contentStream) {
+        return false;
+    }
+
+    PDFContentSource source(scanner->contentStream->streams);
+    PDFParser parser(source, scanner->arena, nullptr);
+    bool scanned = true;
+    for (;;) {
+        __CGPDFObject object;
+        const PDFParser::Result result = parser.Next(object);
+        if (result == PDFParser::c_end) {
+            break;
+        } else if (result == PDFParser::c_error) {
+            scanned = false;
+            break;
+        } else if (result == PDFParser::c_object) {
+            scanner->operands.push_back(object);
+            continue;
+        }
+
+        //  Inline images are called back for as EI, with the image as a stream operand
+        std::string name = parser.Keyword();
+        if (name == "BI") {
+            if (parser.ReadInlineImage(object) != PDFParser::c_object) {
+                scanned = false;
+                break;
+            }
+            scanner->operands.clear();
+            scanner->operands.push_back(object);
+            name = "EI";
+        }
+
+        if (scanner->table) {
+            auto callback = scanner->table->callbacks.find(name);
+            if (callback != scanner->table->callbacks.end()) {
+                callback->second(scanner, scanner->info);
+            }
+        }
+
+        //  Operands only live until their operator returns
+        scanner->operands.clear();
+        scanner->arena.Clear();
+    }
+
+    scanner->operands.clear();
+    scanner->arena.Clear();
+    return scanned;
 }
 
 /**
- @Status Stub
- @Notes
+ @Status Interoperable
 */
 CGPDFContentStreamRef CGPDFScannerGetContentStream(CGPDFScannerRef scanner) {
-    UNIMPLEMENTED();
-    return StubReturn();
+    return scanner ? scanner->contentStream : nullptr;
 }
 
 /**
- @Status Stub
- @Notes
+ @Status Interoperable
 */
 bool CGPDFScannerPopObject(CGPDFScannerRef scanner, CGPDFObjectRef _Nullable* value) {
-    UNIMPLEMENTED();
-    return StubReturn();
+    if (!scanner || scanner->operands.empty()) {
+        return false;
+    }
+
+    //  The object has to outlive its place on the operand stack
+    CGPDFObjectRef object = scanner->arena.Object(scanner->operands.back());
+    scanner->operands.pop_back();
+    if (value) {
+        *value = object;
+    }
+    return true;
 }
 
 /**
- @Status Stub
- @Notes
+ @Status Interoperable
 */
 bool CGPDFScannerPopBoolean(CGPDFScannerRef scanner, CGPDFBoolean* value) {
-    UNIMPLEMENTED();
-    return StubReturn();
+    return __CGPDFScannerPop(scanner, kCGPDFObjectTypeBoolean, value);
 }
 
 /**
- @Status Stub
- @Notes
+ @Status Interoperable
 */
 bool CGPDFScannerPopInteger(CGPDFScannerRef scanner, CGPDFInteger* value) {
-    UNIMPLEMENTED();
-    return StubReturn();
+    return __CGPDFScannerPop(scanner, kCGPDFObjectTypeInteger, value);
 }
 
 /**
- @Status Stub
- @Notes
+ @Status Interoperable
 */
 bool CGPDFScannerPopNumber(CGPDFScannerRef scanner, CGPDFReal* value) {
-    UNIMPLEMENTED();
-    return StubReturn();
+    return __CGPDFScannerPop(scanner, kCGPDFObjectTypeReal, value);
 }
 
 /**
- @Status Stub
- @Notes
+ @Status Interoperable
 */
 bool CGPDFScannerPopName(CGPDFScannerRef scanner, const char* _Nullable* value) {
-    UNIMPLEMENTED();
-    return StubReturn();
+    return __CGPDFScannerPop(scanner, kCGPDFObjectTypeName, value);
 }
 
 /**
- @Status Stub
- @Notes
+ @Status Interoperable
 */
 bool CGPDFScannerPopString(CGPDFScannerRef scanner, CGPDFStringRef _Nullable* value) {
-    UNIMPLEMENTED();
-    return StubReturn();
+    return __CGPDFScannerPop(scanner, kCGPDFObjectTypeString, value);
 }
 
 /**
- @Status Stub
- @Notes
+ @Status Interoperable
 */
 bool CGPDFScannerPopArray(CGPDFScannerRef scanner, CGPDFArrayRef _Nullable* value) {
-    UNIMPLEMENTED();
-    return StubReturn();
+    return __CGPDFScannerPop(scanner, kCGPDFObjectTypeArray, value);
 }
 
 /**
- @Status Stub
- @Notes
+ @Status Interoperable
 */
 bool CGPDFScannerPopDictionary(CGPDFScannerRef scanner, CGPDFDictionaryRef _Nullable* value) {
-    UNIMPLEMENTED();
-    return StubReturn();
+    return __CGPDFScannerPop(scanner, kCGPDFObjectTypeDictionary, value);
 }
 
 /**
- @Status Stub
- @Notes
+ @Status Interoperable
 */
 bool CGPDFScannerPopStream(CGPDFScannerRef scanner, CGPDFStreamRef _Nullable* value) {
-    UNIMPLEMENTED();
-    return StubReturn();
+    return __CGPDFScannerPop(scanner, kCGPDFObjectTypeStream, value);
 }
@@ -14,23 +14,26 @@
 //
 //******************************************************************************
 
-#import <StubReturn.h>
+#import <Foundation/NSData.h>
 #import <CoreGraphics/CGPDFStream.h>
+#import "CGPDFInternal.h"
 
 /**
- @Status Stub
- @Notes
+ @Status Caveat
+ @Notes Decodes the Flate, ASCIIHex, ASCII85 and RunLength filters; LZW and CCITTFax encoded streams can't be copied
 */
 CFDataRef CGPDFStreamCopyData(CGPDFStreamRef stream, CGPDFDataFormat* format) {
-    UNIMPLEMENTED();
-    return StubReturn();
+    std::string data;
+    if (!stream || !_CGPDFStreamDecode(stream, data, format)) {
+        return nullptr;
+    }
+
+    return static_cast<CFDataRef>([[NSData alloc] initWithBytes:data.data() length:data.size()]);
 }
 
 /**
- @Status Stub
- @Notes
+ @Status Interoperable
 */
 CGPDFDictionaryRef CGPDFStreamGetDictionary(CGPDFStreamRef stream) {
-    UNIMPLEMENTED();
-    return StubReturn();
+    return stream ? stream->dictionary : nullptr;
 }
@@ -14,41 +14,124 @@
 //
 //******************************************************************************
 
-#import <StubReturn.h>
+#import <Foundation/NSDate.h>
+#import <Foundation/NSString.h>
 #import <CoreGraphics/CGPDFString.h>
+#import "CGPDFInternal.h"
+
+// Reads count digits of a date string, if there are that many left
+static bool __CGPDFStringReadDigits(const char*& text, const char* end, int count, int* value) {
+    if (end - text < count) {
+        return false;
+    }
+
+    int result = 0;
+    for (int i = 0; i < count; ++i) {
+        if (text[i] < '0' || text[i] > '9') {
+            return false;
+        }
+        result = result * 10 + (text[i] - '0');
+    }
+
+    *value = result;
+    text += count;
+    return true;
+}
+
+// Days from 1970-01-01 to a date in the proleptic Gregorian calendar
+static int64_t __CGPDFStringDaysFromEpoch(int64_t year, int month, int day) {
+    year -= month <= 2;
+    const int64_t era = (year >= 0 ? year : year - 399) / 400;
+    const int64_t yearOfEra = year - era * 400;
+    const int64_t dayOfYear = (153 * (month + (month > 2 ? -3 : 9)) + 2) / 5 + day - 1;
+    const int64_t dayOfEra = yearOfEra * 365 + yearOfEra / 4 - yearOfEra / 100 + dayOfYear;
+    return era * 146097 + dayOfEra - 719468;
+}
 
 /**
- @Status Stub
- @Notes
+ @Status Interoperable
 */
 CFStringRef CGPDFStringCopyTextString(CGPDFStringRef string) {
-    UNIMPLEMENTED();
-    return StubReturn();
+    if (!string) {
+        return nullptr;
+    }
+
+    //  Text strings are UTF-16 when they start with its byte order mark, and PDFDocEncoded otherwise, which
+    //  is Latin-1 for everything but a few rarely used characters
+    const std::string& bytes = string->bytes;
+    if (bytes.size() >= 2 && static_cast<uint8_t>(bytes[0]) == 0xfe && static_cast<uint8_t>(bytes[1]) == 0xff) {
+        return static_cast<CFStringRef>(
+            [[NSString alloc] initWithBytes:bytes.data() + 2 length:(bytes.size() - 2) & ~1 encoding:NSUTF16BigEndianStringEncoding]);
+    } else if (bytes.size() >= 3 && bytes.compare(0, 3, "\xef\xbb\xbf") == 0) {
+        return static_cast<CFStringRef>(
+            [[NSString alloc] initWithBytes:bytes.data() + 3 length:bytes.size() - 3 encoding:NSUTF8StringEncoding]);
+    }
+
+    return static_cast<CFStringRef>([[NSString alloc] initWithBytes:bytes.data() length:bytes.size() encoding:NSISOLatin1StringEncoding]);
 }
 
 /**
- @Status Stub
- @Notes
+ @Status Interoperable
 */
 CFDateRef CGPDFStringCopyDate(CGPDFStringRef string) {
-    UNIMPLEMENTED();
-    return StubReturn();
+    if (!string) {
+        return nullptr;
+    }
+
+    //  Dates are D:YYYYMMDDHHmmSSOHH'mm', where everything after the year is optional
+    const char* text = string->bytes.c_str();
+    const char* end = text + string->bytes.size();
+    if (end - text >= 2 && text[0] == 'D' && text[1] == ':') {
+        text += 2;
+    }
+
+    int year;
+    int month = 1;
+    int day = 1;
+    int hour = 0;
+    int minute = 0;
+    int second = 0;
+    if (!__CGPDFStringReadDigits(text, end, 4, &year)) {
+        return nullptr;
+    }
+
+    if (__CGPDFStringReadDigits(text, end, 2, &month) && __CGPDFStringReadDigits(text, end, 2, &day) &&
+        __CGPDFStringReadDigits(text, end, 2, &hour) && __CGPDFStringReadDigits(text, end, 2, &minute)) {
+        __CGPDFStringReadDigits(text, end, 2, &second);
+    }
+
+    if (month < 1 || month > 12 || day < 1 || day > 31 || hour > 23 || minute > 59 || second > 59) {
+        return nullptr;
+    }
+
+    int offset = 0;
+    if (text < end && (*text == '+' || *text == '-')) {
+        const int sign = *text++ == '-' ? -1 : 1;
+        int offsetHours = 0;
+        int offsetMinutes = 0;
+        if (__CGPDFStringReadDigits(text, end, 2, &offsetHours)) {
+            if (text < end && *text == '\'') {
+                ++text;
+            }
+            __CGPDFStringReadDigits(text, end, 2, &offsetMinutes);
+        }
+        offset = sign * (offsetHours * 3600 + offsetMinutes * 60);
+    }
+
+    const int64_t seconds = __CGPDFStringDaysFromEpoch(year, month, day) * 86400 + hour * 3600 + minute * 60 + second - offset;
+    return static_cast<CFDateRef>([[NSDate alloc] initWithTimeIntervalSince1970:static_cast<NSTimeInterval>(seconds)]);
 }
 
 /**
- @Status Stub
- @Notes
+ @Status Interoperable
 */
 const unsigned char* CGPDFStringGetBytePtr(CGPDFStringRef string) {
-    UNIMPLEMENTED();
-    return StubReturn();
+    return string ? reinterpret_cast<const unsigned char*>(string->bytes.data()) : nullptr;
 }
 
 /**
- @Status Stub
- @Notes
+ @Status Interoperable
 */
 size_t CGPDFStringGetLength(CGPDFStringRef string) {
-    UNIMPLEMENTED();
-    return StubReturn();
+    return string ? string->bytes.size() : 0;
 }
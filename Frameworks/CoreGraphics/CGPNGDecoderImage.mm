@@ -39,6 +39,7 @@
 #import <math.h>
 #import <stdlib.h>
 #import "CGContextInternal.h"
+#import "CGPixelConverters.h"
 
 extern "C" {
 #import <png.h>
@@ -89,70 +90,34 @@ static void PNG_error(png_structp png_ptr, png_const_charp str_err) {
     return;
 }
 
-static inline int multiply_alpha(int alpha, int color) {
-    int temp = (alpha * color) + 0x80;
-    return ((temp + (temp >> 8)) >> 8);
-}
-
 /* Premultiplies data and converts RGBA bytes => native endian */
 static void premultiply_data(png_structp png, png_row_infop row_info, png_bytep data) {
-    unsigned int i;
     int* cgbiFlag = (int*)png_get_user_chunk_ptr(png);
-    uint8_t* base = (uint8_t*)data;
     CGImageRef pImage = (CGImageRef)png_get_user_transform_ptr(png);
+    const size_t count = row_info->rowbytes / 4;
 
-    for (i = 0; i < row_info->rowbytes; i += 4) {
-        uint8_t alpha = base[3];
-
-        if (alpha == 0) {
-            *((uint32_t*)base) = 0;
-            if (pImage) {
-                pImage->_has32BitAlpha = true;
-            }
-        } else {
-            uint8_t red = base[0];
-            uint8_t green = base[1];
-            uint8_t blue = base[2];
-
-            if (alpha != 0xff) {
-                if (!*cgbiFlag) {
-                    red = multiply_alpha(alpha, red);
-                    green = multiply_alpha(alpha, green);
-                    blue = multiply_alpha(alpha, blue);
-                }
-                if (pImage) {
-                    pImage->_has32BitAlpha = true;
-                }
-            }
-
-#ifndef QNX
-            *((uint32_t*)base) = (alpha << 24) | (blue << 16) | (green << 8) | red;
-#else
-            *((uint32_t*)base) = (alpha << 24) | (red << 16) | (green << 8) | blue;
-#endif
+    if (!_CGPixelIsOpaque32(data, count)) {
+        if (pImage) {
+            pImage->_has32BitAlpha = true;
         }
 
-        base += 4;
+        //  CgBI images are stored premultiplied already
+        if (!*cgbiFlag) {
+            _CGPixelPremultiply32(data, data, count);
+        }
     }
+
+#ifdef QNX
+    _CGPixelSwapRedBlue32(data, data, count);
+#endif
 }
 
 /* Converts RGBx bytes to native endian xRGB */
 static void convert_bytes_to_data(png_structp png, png_row_infop row_info, png_bytep data) {
-    unsigned int i;
-    uint8_t* base = (uint8_t*)data;
-
-    for (i = 0; i < row_info->rowbytes; i += 4) {
-        uint8_t red = base[0];
-        uint8_t green = base[1];
-        uint8_t blue = base[2];
-
-#ifndef QNX
-        *((uint32_t*)base) = (0xff << 24) | (blue << 16) | (green << 8) | red;
-#else
-        *((uint32_t*)base) = (0xff << 24) | (red << 16) | (green << 8) | blue;
+    //  libpng fills x with 0xff, so only the byte order may need changing
+#ifdef QNX
+    _CGPixelSwapRedBlue32(data, data, row_info->rowbytes / 4);
 #endif
-        base += 4;
-    }
 }
 
 void CGPNGImageBacking::DiscardIfPossible() {
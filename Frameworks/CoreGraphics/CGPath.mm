@@ -18,6 +18,7 @@
 #import "CGPathInternal.h"
 #import "CGPathInternal.h"
 #include "LoggingNative.h"
+#include "PathStroker.h"
 #import <CoreGraphics/CGBitmapContext.h>
 #import <CoreGraphics/CGColorSpace.h>
 #import <CoreGraphics/CGContext.h>
@@ -157,17 +158,41 @@ void _CGPathGetBoundingBoxInternal(CGPathRef pathref, CGRect* rectOut) {
     pathref->_getBoundingBox(rectOut);
 }
 
+void __CGPath::_reserve(NSUInteger count) {
+    if (count <= _max) {
+        return;
+    }
+
+    //  Grow geometrically, so that building a path of n elements copies O(n) of them
+    _max = std::max(count, std::max<NSUInteger>(_max * 2, 32));
+    _elements = (CGPathElementInternal*)IwRealloc(_elements, _max * sizeof(CGPathElementInternal));
+    // Re-init all existing elements
+    for (unsigned i = 0; i < _count; i++) {
+        _elements[i].init();
+    }
+}
+
+void __CGPath::_invalidate() {
+    std::lock_guard<std::mutex> lock(_hitTesterLock);
+    _hitTester.reset();
+}
+
+const PathHitTester& __CGPath::_getHitTester() {
+    std::lock_guard<std::mutex> lock(_hitTesterLock);
+    if (!_hitTester) {
+        _hitTester.reset(new PathHitTester(_elements, _count));
+    }
+
+    return *_hitTester;
+}
+
 void _CGPathAddElement(
     CGPathRef path, CGPathElementType type, CGPoint p0 = CGPointZero, CGPoint p1 = CGPointZero, CGPoint p2 = CGPointZero) {
-    if (path->_count + 1 >= path->_max) {
-        path->_max += 32;
-        path->_elements = (CGPathElementInternal*)IwRealloc(path->_elements, path->_max * sizeof(CGPathElementInternal));
-        // Re-init all existing elements
-        for (int i = 0; i < path->_count; i++) {
-            CGPathElementInternal* element = &path->_elements[i];
-            element->init();
-        }
+    if (path->_hitTester) {
+        path->_invalidate();
     }
+
+    path->_reserve(path->_count + 1);
     CGPathElementInternal* element = &path->_elements[path->_count];
     // The new element needs to call init
     // because it was created with alloc
@@ -208,9 +233,8 @@ CGMutablePathRef CGPathCreateMutableCopy(CGPathRef path) {
     }
 
     auto ret = __CGPath::alloc(nil);
-    ret->_max = path->_max;
+    ret->_reserve(path->_count);
     ret->_count = path->_count;
-    ret->_elements = (CGPathElementInternal*)IwRealloc(ret->_elements, ret->_max * sizeof(CGPathElementInternal));
     memcpy(ret->_elements, path->_elements, path->_count * sizeof(CGPathElementInternal));
     // All of the new elements need to call init
     // because they were created with alloc + memcpy
@@ -471,34 +495,23 @@ void CGPathAddPath(CGMutablePathRef path, const CGAffineTransform* m, CGPathRef
     CGPathRef pathObj = path;
     CGPathRef copyObj = toAdd;
 
-    if (pathObj->_count + copyObj->_count >= pathObj->_max) {
-        pathObj->_max += copyObj->_count;
-        pathObj->_elements = (CGPathElementInternal*)IwRealloc(pathObj->_elements, pathObj->_max * sizeof(CGPathElementInternal));
-    }
+    pathObj->_invalidate();
+    pathObj->_reserve(pathObj->_count + copyObj->_count);
 
-    for (unsigned i = 0; i < copyObj->_count; i++) {
-        pathObj->_elements[pathObj->_count] = copyObj->_elements[i];
-        pathObj->_count++;
+    //  Adding a path to itself copies what it held beforehand
+    const unsigned copyCount = copyObj->_count;
+    for (unsigned i = 0; i < copyCount; i++) {
         CGPathElementInternal* c = &pathObj->_elements[pathObj->_count];
+        *c = copyObj->_elements[i];
+        pathObj->_count++;
 
         if (m) {
-            switch (c->type) {
-                case kCGPathElementMoveToPoint:
-                case kCGPathElementAddLineToPoint:
-                    c->points[0] = CGPointApplyAffineTransform(c->points[0], *m);
-                    break;
-                default:
-                    // Append the path anyway, without transforming.
-                    break;
+            const int pointCount = _CGPathPointCountForElementType(c->type);
+            for (int j = 0; j < pointCount; j++) {
+                c->points[j] = CGPointApplyAffineTransform(c->points[j], *m);
             }
         }
     }
-
-    // we need to re init the elements to setup the pointers propertly
-    for (int i = 0; i < path->_count; i++) {
-        CGPathElementInternal* element = &path->_elements[i];
-        element->init();
-    }
 }
 
 /**
@@ -601,20 +614,21 @@ CGPathRef CGPathRetain(CGPathRef path) {
 }
 
 /**
- @Status Caveat
- @Notes transform property not supported
+ @Status Interoperable
 */
 void CGPathAddQuadCurveToPoint(CGMutablePathRef path, const CGAffineTransform* m, CGFloat cpx, CGFloat cpy, CGFloat x, CGFloat y) {
     if (path == NULL) {
         return;
     }
 
-    assert(!m);
-    CGPathRef pathObj = path;
-
     CGPoint cp = { cpx, cpy };
     CGPoint p = { x, y };
 
+    if (m) {
+        cp = CGPointApplyAffineTransform(cp, *m);
+        p = CGPointApplyAffineTransform(p, *m);
+    }
+
     _CGPathAddElement(path, kCGPathElementAddQuadCurveToPoint, cp, p);
 }
 
@@ -744,60 +758,109 @@ bool CGPathContainsPoint(CGPathRef path, const CGAffineTransform* m, CGPoint poi
     if (m) {
         point = CGPointApplyAffineTransform(point, *m);
     }
-    // check if the point is outside this box already, if it is, return false
-    CGRect boundingBox = CGPathGetBoundingBox(path);
-    if (!CGRectContainsPoint(boundingBox, point)) {
-        return false;
+
+    return path->_getHitTester().Contains(point, eoFill);
+}
+
+namespace {
+
+// Builds a path from the outlines and dashes written by PathStroker and DashPath, transforming them on the way
+class PathBuilder {
+public:
+    PathBuilder(CGMutablePathRef path, const CGAffineTransform* transform) : _path(path), _transform(transform) {
     }
 
-    CGContextRef context =
-        CGBitmapContextCreate(0, boundingBox.origin.x + boundingBox.size.width, boundingBox.origin.y + boundingBox.size.height, 1, 1, 0, 0);
+    void MoveTo(CGPoint point) {
+        CGPathMoveToPoint(_path, _transform, point.x, point.y);
+    }
 
-    CGContextAddPath(context, path);
+    void LineTo(CGPoint point) {
+        CGPathAddLineToPoint(_path, _transform, point.x, point.y);
+    }
 
-    bool inPath = CGContextIsPointInPath(context, eoFill, point.x, point.y);
+    void CurveTo(CGPoint control1, CGPoint control2, CGPoint point) {
+        CGPathAddCurveToPoint(_path, _transform, control1.x, control1.y, control2.x, control2.y, point.x, point.y);
+    }
 
-    CGContextRelease(context);
+    void Close() {
+        CGPathCloseSubpath(_path);
+    }
 
-    return inPath;
-}
+private:
+    CGMutablePathRef _path;
+    const CGAffineTransform* _transform;
+};
+
+} // namespace
 
 /**
- @Status Stub
- @Notes
+ @Status Caveat
+ @Notes Curves are flattened into lines in the dashed path.
 */
 CGPathRef CGPathCreateCopyByDashingPath(
     CGPathRef path, const CGAffineTransform* transform, CGFloat phase, const CGFloat* lengths, size_t count) {
-    UNIMPLEMENTED();
-    return StubReturn();
+    if (path == NULL) {
+        return NULL;
+    }
+
+    if (lengths == NULL || count == 0) {
+        return CGPathCreateCopyByTransformingPath(path, transform);
+    }
+
+    CGMutablePathRef ret = CGPathCreateMutable();
+    PathBuilder builder(ret, transform);
+    if (!DashPath(FlattenedSubpaths(path->_elements, path->_count), phase, lengths, count, builder)) {
+        CGPathRelease(ret);
+        return CGPathCreateCopyByTransformingPath(path, transform);
+    }
+
+    return ret;
 }
 
 /**
- @Status Stub
- @Notes
+ @Status Caveat
+ @Notes Curves are flattened into lines before they are outlined; round joins and caps are drawn as curves.
 */
 CGPathRef CGPathCreateCopyByStrokingPath(
     CGPathRef path, const CGAffineTransform* transform, CGFloat lineWidth, CGLineCap lineCap, CGLineJoin lineJoin, CGFloat miterLimit) {
-    UNIMPLEMENTED();
-    return StubReturn();
+    if (path == NULL) {
+        return NULL;
+    }
+
+    CGMutablePathRef ret = CGPathCreateMutable();
+    PathBuilder builder(ret, transform);
+    PathStroker<PathBuilder>(builder, lineWidth, lineCap, lineJoin, miterLimit).Stroke(FlattenedSubpaths(path->_elements, path->_count));
+
+    return ret;
 }
 
 /**
- @Status Stub
- @Notes
+ @Status Interoperable
 */
 CGPathRef CGPathCreateCopyByTransformingPath(CGPathRef path, const CGAffineTransform* transform) {
-    UNIMPLEMENTED();
-    return StubReturn();
+    return CGPathCreateMutableCopyByTransformingPath(path, transform);
 }
 
 /**
- @Status Stub
- @Notes
+ @Status Interoperable
 */
 CGMutablePathRef CGPathCreateMutableCopyByTransformingPath(CGPathRef path, const CGAffineTransform* transform) {
-    UNIMPLEMENTED();
-    return StubReturn();
+    if (path == NULL) {
+        return NULL;
+    }
+
+    CGMutablePathRef ret = CGPathCreateMutableCopy(path);
+    if (transform) {
+        for (unsigned i = 0; i < ret->_count; i++) {
+            CGPathElementInternal& element = ret->_elements[i];
+            const int pointCount = _CGPathPointCountForElementType(element.type);
+            for (int j = 0; j < pointCount; j++) {
+                element.points[j] = CGPointApplyAffineTransform(element.points[j], *transform);
+            }
+        }
+    }
+
+    return ret;
 }
 
 /**
@@ -24,6 +24,11 @@
 #import <Foundation/NSAttributedString.h>
 
 #include <algorithm>
+#include <bitset>
+#include <map>
+#include <memory>
+#include <tuple>
+#include <unordered_map>
 
 extern "C" {
 #include <ft2build.h>
@@ -61,6 +66,26 @@ static const int c_carriage_return = 13;
     _characters = (WORD*)IwMalloc(sizeof(WORD) * _charactersLen);
     [_string getCharacters:_characters];
 
+    //  Split it into its attribute runs once, rather than on every layout
+    CFIndex index = 0;
+    while (index < _charactersLen) {
+        NSRange range;
+        NSDictionary* attribs = [str attributesAtIndex:index effectiveRange:&range];
+        UIFont* font = [attribs objectForKey:(NSString*)kCTFontAttributeName];
+        if (font == nil) {
+            font = [_LazyUIFont systemFontOfSize:default_system_font_size];
+        }
+
+        _CTTypesetterRun run;
+        run._range = NSMakeRange(index, range.location + range.length - index);
+        run._attributes = attribs;
+        run._font = font;
+        _runs.emplace_back(std::move(run));
+
+        index = range.location + range.length;
+    }
+    _advances.resize(_charactersLen);
+
     return self;
 }
 
@@ -82,6 +107,120 @@ static float fractionPixels(float pixels) {
     return pixels / c_pixel_fraction;
 }
 
+namespace {
+// The advances of one face at one size. Most text is Latin-1, which is kept in a flat table; anything else is hashed.
+class GlyphAdvanceCache {
+public:
+    explicit GlyphAdvanceCache(FT_Face face)
+        : _face(face), _ascender(face->size->metrics.ascender), _descender(face->size->metrics.descender) {
+    }
+
+    // Only with _CGFontLock held, and the face set to the size the cache was made for
+    FT_Pos Advance(WORD character) {
+        if (character < c_latin1Count) {
+            if (!_latin1Loaded[character]) {
+                _latin1[character] = load(character);
+                _latin1Loaded[character] = true;
+            }
+            return _latin1[character];
+        }
+
+        auto found = _others.find(character);
+        if (found == _others.end()) {
+            found = _others.emplace(character, load(character)).first;
+        }
+        return found->second;
+    }
+
+    FT_Pos Ascender() const {
+        return _ascender;
+    }
+
+    FT_Pos Descender() const {
+        return _descender;
+    }
+
+private:
+    static const size_t c_latin1Count = 256;
+
+    FT_Pos load(WORD character) {
+        FT_UInt index = FT_Get_Char_Index(_face, character);
+        if (FT_Load_Glyph(_face, index, FT_LOAD_NO_HINTING) != 0) {
+            TraceWarning(TAG, L"Glyph %d not found", character);
+            return 0;
+        }
+        return _face->glyph->advance.x;
+    }
+
+    FT_Face _face;
+    FT_Pos _ascender;
+    FT_Pos _descender;
+    std::bitset<c_latin1Count> _latin1Loaded;
+    FT_Pos _latin1[c_latin1Count];
+    std::unordered_map<WORD, FT_Pos> _others;
+};
+}
+
+// Shared by every typesetter, and so every framesetter, keyed by the face and the scales its size and horizontal scale
+// set. Guarded by _CGFontLock, which is held for FreeType calls anyway. Faces live as long as the process.
+static std::map<std::tuple<FT_Face, FT_Fixed, FT_Fixed>, std::unique_ptr<GlyphAdvanceCache>> _glyphAdvanceCaches;
+static const size_t c_maxGlyphAdvanceCaches = 64;
+
+static GlyphAdvanceCache& _GetGlyphAdvanceCache(FT_Face face) {
+    auto key = std::make_tuple(face, face->size->metrics.x_scale, face->size->metrics.y_scale);
+    auto found = _glyphAdvanceCaches.find(key);
+    if (found == _glyphAdvanceCaches.end()) {
+        if (_glyphAdvanceCaches.size() >= c_maxGlyphAdvanceCaches) {
+            _glyphAdvanceCaches.clear();
+        }
+        found = _glyphAdvanceCaches.emplace(key, std::unique_ptr<GlyphAdvanceCache>(new GlyphAdvanceCache(face))).first;
+    }
+    return *found->second;
+}
+
+// Looks up a run's metrics, and its characters' advances, the first time a line reaches it
+static void _MeasureRun(_CTTypesetter* typeSetter, _CTTypesetterRun& run) {
+    UIFont* font = run._font;
+    FT_Face face = (FT_Face)[font _sizingFontHandle];
+    run._leading = [font leading];
+
+    const WORD* chars = typeSetter->_characters + run._range.location;
+    int32_t* advances = typeSetter->_advances.data() + run._range.location;
+
+    _CGFontLock();
+    CGFontSetFTFontSize(font, face, [font pointSize]);
+    GlyphAdvanceCache& cache = _GetGlyphAdvanceCache(face);
+
+    for (NSUInteger i = 0; i < run._range.length; ++i) {
+        WORD character = chars[i];
+        if (character == c_linefeed || character == c_carriage_return) {
+            advances[i] = 0;
+        } else {
+            // FT does not seem to be able to print tabs, so we have to replace it with a space for now
+            advances[i] = static_cast<int32_t>(cache.Advance(character == '\t' ? ' ' : character));
+        }
+    }
+
+    run._ascender = fractionPixels(cache.Ascender());
+    run._descender = fractionPixels(cache.Descender());
+    run._fontHeight = fractionPixels((cache.Ascender() - cache.Descender()) * c_spacing);
+    _CGFontUnlock();
+
+    run._measured = true;
+}
+
+static _CTTypesetterRun& _RunAtIndex(_CTTypesetter* typeSetter, CFIndex index) {
+    auto found = std::upper_bound(typeSetter->_runs.begin(),
+                                  typeSetter->_runs.end(),
+                                  index,
+                                  [](CFIndex value, const _CTTypesetterRun& run) { return value < (CFIndex)run._range.location; });
+    _CTTypesetterRun& run = *(found - 1);
+    if (!run._measured) {
+        _MeasureRun(typeSetter, run);
+    }
+    return run;
+}
+
 static CFIndex _DoWrap(CTTypesetterRef ts, CFRange range, WidthFinderFunc widthFunc, void* widthParam, double offset, CTLineRef* outLine) {
     _CTTypesetter* typeSetter = (_CTTypesetter*)ts;
     _CTLine* line = NULL;
@@ -103,9 +242,15 @@ static CFIndex _DoWrap(CTTypesetterRef ts, CFRange range, WidthFinderFunc widthF
 
     CFIndex lineStart = NULL;
 
+    //  Only lines need the glyphs; suggesting a break just measures
     std::vector<CGPoint> glyphOrigins;
     std::vector<CGSize> glyphAdvances;
     std::vector<WORD> characters;
+    if (line) {
+        glyphOrigins.reserve(range.length);
+        glyphAdvances.reserve(range.length);
+        characters.reserve(range.length);
+    }
     float lineWidth = 0.0f;
 
     FT_Pos penX = 0;
@@ -121,16 +266,11 @@ static CFIndex _DoWrap(CTTypesetterRef ts, CFRange range, WidthFinderFunc widthF
 
     lineStart = curIndex;
 
-    NSRange curAttributeRange = { 0 };
-    FT_Face curFace;
-    float curFontHeight = 0.0f;
+    const _CTTypesetterRun* curRun = nullptr;
     float maxWidth = FLT_MAX;
 
     //  Lookup each glyph
     while (curIndex < count) {
-        glyphOrigins.push_back(CGPointMake(fractionPixels(penX), 0.0f));
-        glyphAdvances.push_back(CGSizeMake(0, 0));
-
         int curChar = chars[curIndex];
 
         // FT does not seem to be able to print tabs, so we have to replace it with a space for now
@@ -138,15 +278,16 @@ static CFIndex _DoWrap(CTTypesetterRef ts, CFRange range, WidthFinderFunc widthF
             curChar = ' ';
         }
 
-        if (curChar == c_linefeed || curChar == c_carriage_return) {
-            characters.push_back((WORD)0);
-        } else {
-            characters.push_back((WORD)curChar);
+        if (line) {
+            glyphOrigins.push_back(CGPointMake(fractionPixels(penX), 0.0f));
+            glyphAdvances.push_back(CGSizeMake(0, 0));
+            if (curChar == c_linefeed || curChar == c_carriage_return) {
+                characters.push_back((WORD)0);
+            } else {
+                characters.push_back((WORD)curChar);
+            }
         }
 
-        auto& glyphOrigin = glyphOrigins.back();
-        auto& glyphAdvance = glyphAdvances.back();
-
         if ((chars[curIndex] == c_linefeed) || (curIndex > lineStart && chars[curIndex - 1] == c_carriage_return)) {
             if ((curIndex > 0 && chars[curIndex - 1] == c_carriage_return && chars[curIndex] != c_linefeed)) {
                 --curIndex;
@@ -169,44 +310,22 @@ static CFIndex _DoWrap(CTTypesetterRef ts, CFRange range, WidthFinderFunc widthF
             break;
         }
 
-        FT_Vector advance;
-
-        advance.x = 0;
-        advance.y = 0;
+        FT_Pos advance = 0;
 
         //  Have we reached a new attribute range?
-        if (curIndex < curAttributeRange.location || curIndex >= (curAttributeRange.location + curAttributeRange.length)) {
-            //  Grab and set the new font
-            NSDictionary* attribs = [typeSetter->_attributedString attributesAtIndex:curIndex effectiveRange:&curAttributeRange];
-            UIFont* font = [attribs objectForKey:(NSString*)kCTFontAttributeName];
-            if (font == nil) {
-                font = [_LazyUIFont systemFontOfSize:default_system_font_size];
-            }
-            curFace = (FT_Face)[font _sizingFontHandle];
-            CGFontSetFTFontSize(font, curFace, [font pointSize]);
+        if (curRun == nullptr || curIndex < (CFIndex)curRun->_range.location ||
+            curIndex >= (CFIndex)(curRun->_range.location + curRun->_range.length)) {
+            curRun = &_RunAtIndex(typeSetter, curIndex);
 
-            float fontHeight = fractionPixels((curFace->size->metrics.ascender - curFace->size->metrics.descender) * c_spacing);
             float curX = fractionPixels(penX);
-            float width = widthFunc(widthParam, curIndex, curX, fontHeight);
+            float width = widthFunc(widthParam, curIndex, curX, curRun->_fontHeight);
 
             maxWidth = curX + width;
         }
 
         //  Grab the width of the current character
-        FT_Error error;
-
         if (curChar != c_carriage_return) {
-            FT_UInt index = 0;
-            index = FT_Get_Char_Index(curFace, curChar);
-
-            error = FT_Load_Glyph(curFace, index, FT_LOAD_NO_HINTING);
-            FT_GlyphSlot slot = curFace->glyph;
-
-            if (error == 0) {
-                advance.x = slot->advance.x;
-            } else {
-                TraceWarning(TAG, L"Glyph %d not found", curChar);
-            }
+            advance = typeSetter->_advances[curIndex];
 
             if (isSpaceOrTab(curChar)) {
                 //  Soft linebreak possibility
@@ -217,9 +336,11 @@ static CFIndex _DoWrap(CTTypesetterRef ts, CFRange range, WidthFinderFunc widthF
                 }
             }
 
-            penX += advance.x;
+            penX += advance;
 
-            glyphAdvance.width = fractionPixels(advance.x);
+            if (line) {
+                glyphAdvances.back().width = fractionPixels(advance);
+            }
         }
 
         float curWidth;
@@ -232,7 +353,7 @@ static CFIndex _DoWrap(CTTypesetterRef ts, CFRange range, WidthFinderFunc widthF
             } else {
                 if (lineStart != curIndex) {
                     //  Back out the last character
-                    penX -= advance.x;
+                    penX -= advance;
                     lastGlyphToPrintPos = curIndex - 1;
                 } else {
                     lastGlyphToPrintPos = curIndex;
@@ -280,8 +401,8 @@ static CFIndex _DoWrap(CTTypesetterRef ts, CFRange range, WidthFinderFunc widthF
         unsigned glyphIdx = 0;
 
         while (curIdx < lineRange.location + lineRange.length) {
-            id attribs = [typeSetter->_attributedString attributesAtIndex:curIdx effectiveRange:&curRange];
-            int fragmentLen = curRange.location + curRange.length - curIdx;
+            const _CTTypesetterRun& typesetterRun = _RunAtIndex(typeSetter, curIdx);
+            curRange = typesetterRun._range;
 
             NSRange runRange;
             runRange.location = curIdx;
@@ -291,30 +412,12 @@ static CFIndex _DoWrap(CTTypesetterRef ts, CFRange range, WidthFinderFunc widthF
             }
 
             _CTRun* run = [[_CTRun alloc] init];
-            UIFont* runFont = [attribs objectForKey:(id)kCTFontAttributeName];
-            if (runFont == nil) {
-                runFont = [_LazyUIFont systemFontOfSize:15];
-            }
-            [run->_attributes setObject:runFont forKey:(id)kCTFontAttributeName];
+            [run->_attributes addEntriesFromDictionary:typesetterRun._attributes];
+            [run->_attributes setObject:typesetterRun._font forKey:(id)kCTFontAttributeName];
 
-            if ([runFont ascender] > ascender) {
-                ascender = [runFont ascender];
-            }
-            if ([runFont descender] < descender) {
-                descender = [runFont descender];
-            }
-            if ([runFont leading] > leading) {
-                leading = [runFont leading];
-            }
-
-            // adding all the other attributes
-            NSEnumerator* enumerator = [attribs keyEnumerator];
-            id key;
-            while ((key = [enumerator nextObject])) {
-                if ([run->_attributes valueForKey:key] == nil) {
-                    [run->_attributes setObject:[attribs objectForKey:key] forKey:key];
-                }
-            }
+            ascender = std::max(ascender, typesetterRun._ascender);
+            descender = std::min(descender, typesetterRun._descender);
+            leading = std::max(leading, typesetterRun._leading);
 
             run->_range.location = runRange.location;
             run->_range.length = runRange.length;
@@ -32,6 +32,7 @@
 #import <MainDispatcher.h>
 
 #import <atomic>
+#import <memory>
 
 using namespace Microsoft::WRL;
 using namespace ABI::Windows::ApplicationModel::Core;
@@ -60,10 +61,10 @@ extern "C" void ScheduleMainRunLoop() {
  * Method that processes events for the main runloop.
  * Note: This method should only be called from the main UI thread.
  */
-void _ProcessMainRunLoop(int signaled) {
+void _ProcessMainRunLoop(int signaled, const SocketWait* sockets) {
     if ([NSThread currentThread] == [NSThread mainThread]) {
         NSRunLoop* runLoop = [NSRunLoop currentRunLoop];
-        [runLoop _processMainRunLoop:signaled];
+        [runLoop _processMainRunLoop:signaled sockets:sockets];
     } else {
         // Main runloop should only be scheduled from the main UI thread.
         FAIL_FAST_MSG("Main runloop should only be scheduled from the main UI thread!");
@@ -74,9 +75,9 @@ void _ProcessMainRunLoop(int signaled) {
  * Method that schedules the main runloop on the UI thread.
  * Note: This method always schedules the work asynchronously on the UI thread to let the caller stack unwind.
  */
-void _DispatchMainRunLoopOnUIThread(int signaledEvent) {
-    auto dispatchCallback = WRLHelpers::MakeAgileCallback<IDispatchedHandler>([signaledEvent]() -> HRESULT {
-        _ProcessMainRunLoop(signaledEvent);
+void _DispatchMainRunLoopOnUIThread(int signaledEvent, std::shared_ptr<SocketWait> sockets = nullptr) {
+    auto dispatchCallback = WRLHelpers::MakeAgileCallback<IDispatchedHandler>([signaledEvent, sockets]() -> HRESULT {
+        _ProcessMainRunLoop(signaledEvent, sockets.get());
         ScheduleMainRunLoop();
         return S_OK;
     });
@@ -127,13 +128,17 @@ int MainRunLoopTimedMultipleWait(EbrEvent* events, int numEvents, double timeout
             ComPtr<IThreadPoolStatics> threadpool;
             THROW_IF_FAILED(
                 GetActivationFactory(Wrappers::HStringReference(RuntimeClass_Windows_System_Threading_ThreadPool).Get(), &threadpool));
+
+            //  The wait polls its own copy of the sockets, since the run loop may be re-entered and prepare its descriptors again
+            //  before the wait finishes; the results go back with the dispatch.
+            std::shared_ptr<SocketWait> polled(sockets ? _NSRunLoopCopySocketWait(sockets) : nullptr, IwFree);
             auto agileCallback =
-                WRLHelpers::MakeAgileCallback<IWorkItemHandler>([events, numEvents, timeout, sockets](_In_ IAsyncAction*) -> HRESULT {
-                    int signaledEvent = EbrEventTimedMultipleWait(events, numEvents, timeout, sockets);
+                WRLHelpers::MakeAgileCallback<IWorkItemHandler>([events, numEvents, timeout, polled](_In_ IAsyncAction*) -> HRESULT {
+                    int signaledEvent = EbrEventTimedMultipleWait(events, numEvents, timeout, polled.get());
                     waitHasBeenScheduled.store(false);
 
                     //  Dispatch the main runloop on the UI thread.
-                    _DispatchMainRunLoopOnUIThread(signaledEvent);
+                    _DispatchMainRunLoopOnUIThread(signaledEvent, polled);
 
                     return S_OK;
                 });
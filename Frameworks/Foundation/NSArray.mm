@@ -1013,8 +1013,7 @@ static CFComparisonResult _CFComparatorFunctionFromComparator(const void* val1,
 }
 
 /**
- @Status Caveat
- @Notes Options are currently ignored
+ @Status Interoperable
 */
 - (NSArray*)sortedArrayWithOptions:(NSSortOptions)opts usingComparator:(NSComparator)cmptr {
     NSMutableArray* ret = [NSMutableArray arrayWithArray:self];
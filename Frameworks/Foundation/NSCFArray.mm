@@ -92,6 +92,18 @@ BRIDGED_CLASS_REQUIRED_IMPLS(CFArrayRef, CFArrayGetTypeID, NSArray, NSCFArray)
     return (id)CFArrayGetValueAtIndex((CFArrayRef)self, index);
 }
 
+- (void)getObjects:(id*)objects range:(NSRange)range {
+    if (range.location + range.length > CFArrayGetCount((CFArrayRef)self)) {
+        [NSException raise:@"Array out of bounds"
+                    format:@"getObjects:range: range {%d, %d} beyond count %d, throwing exception\n",
+                           range.location,
+                           range.length,
+                           CFArrayGetCount((CFArrayRef)self)];
+        return;
+    }
+    CFArrayGetValues((CFArrayRef)self, CFRangeMake(range.location, range.length), (const void**)objects);
+}
+
 - (void)removeObjectAtIndex:(NSUInteger)index {
     BRIDGED_THROW_IF_IMMUTABLE(_CFArrayIsMutable, CFArrayRef);
     CFArrayRemoveValueAtIndex(static_cast<CFMutableArrayRef>(self), index);
@@ -20,10 +20,33 @@
 #include "NSCFData.h"
 #include <CoreFoundation/CFData.h>
 #include "BridgeHelpers.h"
+#include <objc/blocks_runtime.h>
 
 @interface NSCFData : NSMutableData
 @end
 
+// CFAllocator callbacks that hand a CFData's bytes to an NSData deallocator block. The allocator's info is a copied block
+// taking the bytes; the allocator is released, and with it the block, after the bytes are deallocated.
+static void _NSCFDataInvokeDeallocator(void* ptr, void* info) {
+    reinterpret_cast<void (^)(void*)>(info)(ptr);
+}
+
+static void _NSCFDataReleaseDeallocator(const void* info) {
+    Block_release(info);
+}
+
+static CFAllocatorRef _NSCFDataCreateBytesDeallocator(NSUInteger length, void (^deallocator)(void*, NSUInteger)) {
+    void (^freeBytes)(void*) = Block_copy(^(void* bytes) {
+        deallocator(bytes, length);
+    });
+
+    CFAllocatorContext context = {};
+    context.info = freeBytes;
+    context.release = _NSCFDataReleaseDeallocator;
+    context.deallocate = _NSCFDataInvokeDeallocator;
+    return CFAllocatorCreate(kCFAllocatorDefault, &context);
+}
+
 #pragma region NSDataPrototype
 @implementation NSDataPrototype
 
@@ -39,6 +62,18 @@ PROTOTYPE_CLASS_REQUIRED_IMPLS(NSCFData)
         (CFDataCreateWithBytesNoCopy(kCFAllocatorDefault, reinterpret_cast<const byte*>(bytes), length, deallocator))));
 }
 
+- (_Nullable instancetype)initWithBytesNoCopy:(void*)bytes
+                                       length:(NSUInteger)length
+                                  deallocator:(void (^)(void* bytes, NSUInteger length))deallocator {
+    if (!deallocator) {
+        return [self initWithBytesNoCopy:bytes length:length freeWhenDone:NO];
+    }
+
+    woc::unique_cf<CFAllocatorRef> bytesDeallocator(_NSCFDataCreateBytesDeallocator(length, deallocator));
+    return reinterpret_cast<NSDataPrototype*>(static_cast<NSData*>(
+        (CFDataCreateWithBytesNoCopy(kCFAllocatorDefault, reinterpret_cast<const byte*>(bytes), length, bytesDeallocator.get()))));
+}
+
 @end
 #pragma endregion
 
@@ -66,6 +101,20 @@ PROTOTYPE_CLASS_REQUIRED_IMPLS(NSCFData)
     return reinterpret_cast<NSMutableDataPrototype*>(data);
 }
 
+- (_Nullable instancetype)initWithBytesNoCopy:(void*)bytes
+                                       length:(NSUInteger)length
+                                  deallocator:(void (^)(void* bytes, NSUInteger length))deallocator {
+    // As above, the bytes are copied and handed back right away
+    NSMutableData* data = static_cast<NSMutableData*>(CFDataCreateMutable(kCFAllocatorDefault, 0));
+    [data appendBytes:bytes length:length];
+
+    if (deallocator) {
+        deallocator(bytes, length);
+    }
+
+    return reinterpret_cast<NSMutableDataPrototype*>(data);
+}
+
 - (_Nullable instancetype)initWithCapacity:(NSUInteger)capacity {
     return reinterpret_cast<NSMutableDataPrototype*>(CFDataCreateMutable(kCFAllocatorDefault, 0));
 }
@@ -17,64 +17,93 @@
 #import <Foundation/NSCache.h>
 
 #import <Starboard/SmartTypes.h>
+#import "NSCacheInternal.h"
 
+#include <algorithm>
+#include <atomic>
 #include <list>
+#include <memory>
+#include <mutex>
+#include <thread>
 #include <unordered_map>
+#include <vector>
 
-@interface _NSCacheEntry : NSObject
-@property (nonatomic, assign) NSUInteger cost;
-@property (nonatomic, retain) id key;
-@property (nonatomic, retain) id object;
-@property (nonatomic, assign) BOOL discardable;
-@end
+namespace {
 
-@implementation _NSCacheEntry
-+ (instancetype)cacheEntryWithCost:(NSUInteger)cost key:(id)key object:(id)object {
-    return [[[self alloc] initWithCost:cost key:key object:object] autorelease];
-}
+struct _NSCacheEntry {
+    StrongId<id> key;
+    StrongId<id> object;
+    NSUInteger hash;
+    NSUInteger cost;
+    bool discardable;
 
-- (instancetype)initWithCost:(NSUInteger)cost key:(id)key object:(id)object {
-    if (self = [super init]) {
-        _cost = cost;
-        _key = [key retain];
-        _object = [object retain];
-        _discardable = [object conformsToProtocol:@protocol(NSDiscardableContent)];
-    }
-    return self;
-}
+    // Position in the shard's costed list; only valid when cost is non-zero
+    std::list<_NSCacheEntry*>::iterator costPosition;
+};
 
-- (void)dealloc {
-    [_key release];
-    [_object release];
-    [super dealloc];
-}
-@end
+// Index key that carries the key's hash, so lookups, rehashes and erases never send -hash again
+struct _NSCacheKey {
+    id key;
+    NSUInteger hash;
+};
 
-namespace std {
-template <>
-struct hash<id> {
-    size_t operator()(const id& obj) const {
-        return [obj hash];
+struct _NSCacheKeyHash {
+    size_t operator()(const _NSCacheKey& key) const {
+        return key.hash;
     }
 };
-template <>
-struct equal_to<id> {
-    bool operator()(const id& left, const id& right) const {
-        return [left isEqual:right];
+
+struct _NSCacheKeyEqual {
+    bool operator()(const _NSCacheKey& left, const _NSCacheKey& right) const {
+        return (left.key == right.key) || ((left.hash == right.hash) && [left.key isEqual:right.key]);
     }
 };
+
+using _NSCacheEntryList = std::list<_NSCacheEntry>;
+using _NSCacheIndex = std::unordered_map<_NSCacheKey, _NSCacheEntryList::iterator, _NSCacheKeyHash, _NSCacheKeyEqual>;
+
+// An independently locked slice of the cache. Both lists are ordered most recently used first; promotion splices nodes to the
+// front, which neither allocates nor invalidates the iterators held by the index.
+struct _NSCacheShard {
+    std::recursive_mutex lock;
+    _NSCacheEntryList entries;
+    std::list<_NSCacheEntry*> costedEntries;
+    _NSCacheIndex index;
+    NSUInteger totalCost = 0;
+};
+
+// Striping is only worth it with enough entries per shard that per-shard LRU order stays close to the cache-wide order
+static const NSUInteger c_NSCacheMaxDefaultShards = 16;
+static const NSUInteger c_NSCacheMinEntriesPerShard = 1024;
+
+// Spreads poorly distributed hashes, such as those of small NSNumbers, across the shards
+static NSUInteger _NSCacheShardIndex(NSUInteger hash, NSUInteger shardCount) {
+    uint32_t mixed = static_cast<uint32_t>(hash ^ (static_cast<uint64_t>(hash) >> 32));
+    mixed = (mixed ^ (mixed >> 16)) * 0x45d9f3b;
+    mixed ^= mixed >> 16;
+    return mixed % shardCount;
 }
 
-using cacheType = std::list<StrongId<_NSCacheEntry>>;
+// An entry that has been unlinked from its shard but whose delegate callback and discard are still pending
+struct _NSCacheEviction {
+    StrongId<id> object;
+    bool discardable;
+};
+
+} // namespace
+
 @interface NSCache () {
-    cacheType _cacheEntries;
-    std::unordered_map<id, cacheType::iterator> _iterators;
+    std::unique_ptr<_NSCacheShard[]> _shards;
+    NSUInteger _shardCapacity;
 
-    NSUInteger _countLimit;
+    // Shards in use; only changes while every shard is locked and empty
+    std::atomic<NSUInteger> _shardCount;
+    bool _adaptsShardCount;
 
-    NSUInteger _totalCost;
-    NSUInteger _totalCostLimit;
+    std::atomic<NSUInteger> _countLimit;
+    std::atomic<NSUInteger> _totalCostLimit;
 
+    std::mutex _delegateLock;
     id<NSCacheDelegate> _delegate;
     struct {
         uint8_t hasWillEvict : 1;
@@ -85,8 +114,9 @@ using cacheType = std::list<StrongId<_NSCacheEntry>>;
 @implementation NSCache
 
 - (instancetype)init {
-    if (self = [super init]) {
-        _evictsObjectsWithDiscardedContent = YES;
+    const NSUInteger cores = std::max(1u, std::thread::hardware_concurrency());
+    if (self = [self _initWithStripeCount:std::min(c_NSCacheMaxDefaultShards, cores)]) {
+        _adaptsShardCount = true;
     }
     return self;
 }
@@ -96,31 +126,42 @@ using cacheType = std::list<StrongId<_NSCacheEntry>>;
     [super dealloc];
 }
 
+- (_NSCacheShard&)_shardForHash:(NSUInteger)hash {
+    return _shards[_NSCacheShardIndex(hash, _shardCount)];
+}
+
 /**
  @Status Interoperable
 */
 - (id)objectForKey:(id)key {
-    @synchronized(self) {
-        const auto found = _iterators.find(key);
-        if (found != _iterators.end()) {
-            auto cacheIterator = found->second;
-            StrongId<_NSCacheEntry> cacheEntry(*cacheIterator);
-
-            if (_evictsObjectsWithDiscardedContent && [cacheEntry discardable]) {
-                id<NSDiscardableContent> discardable = (id<NSDiscardableContent>)[cacheEntry object];
-                if (discardable.isContentDiscarded) {
-                    [self _evictEntry:cacheEntry force:true];
-                    return nil;
-                }
+    const NSUInteger hash = [key hash];
+    _NSCacheShard& shard = [self _shardForHash:hash];
+    std::vector<_NSCacheEviction> evictions;
+    StrongId<id> object;
+
+    {
+        std::lock_guard<std::recursive_mutex> lock(shard.lock);
+        const auto found = shard.index.find(_NSCacheKey{ key, hash });
+        if (found == shard.index.end()) {
+            return nil;
+        }
+
+        const auto position = found->second;
+        if (_evictsObjectsWithDiscardedContent && position->discardable &&
+            [static_cast<id<NSDiscardableContent>>(position->object.get()) isContentDiscarded]) {
+            [self _unlinkEntry:found fromShard:shard into:evictions];
+        } else {
+            shard.entries.splice(shard.entries.begin(), shard.entries, position);
+            if (position->cost > 0) {
+                shard.costedEntries.splice(shard.costedEntries.begin(), shard.costedEntries, position->costPosition);
             }
 
-            _cacheEntries.erase(cacheIterator);
-            _iterators.erase(found);
-            [self _insertEntry:cacheEntry];
-            return [cacheEntry object];
+            object = position->object;
         }
-        return nil;
     }
+
+    [self _finishEvictions:evictions];
+    return [[object.get() retain] autorelease];
 }
 
 /**
@@ -134,167 +175,263 @@ using cacheType = std::list<StrongId<_NSCacheEntry>>;
  @Status Interoperable
 */
 - (void)setObject:(id)obj forKey:(id)key cost:(NSUInteger)cost {
-    @synchronized(self) {
-        [self removeObjectForKey:key];
-        [self _insertEntry:[_NSCacheEntry cacheEntryWithCost:cost key:key object:obj]];
-        _totalCost += cost;
-
-        // since this starts at the end, it shouldn't evict our new entry unless it's too large.
-        // if it's too large, we will evict the new entry immediately. this matches the reference
-        // platform behaviour.
-        [self _evictEntriesOverCharge];
+    const NSUInteger hash = [key hash];
+    std::vector<_NSCacheEviction> evictions;
+
+    {
+        //  An empty cache may change its shard count between picking a shard and locking it; pick again if it did
+        NSUInteger shardCount;
+        std::unique_lock<std::recursive_mutex> lock;
+        do {
+            shardCount = _shardCount;
+            lock = std::unique_lock<std::recursive_mutex>(_shards[_NSCacheShardIndex(hash, shardCount)].lock);
+        } while (shardCount != _shardCount);
+
+        _NSCacheShard& shard = _shards[_NSCacheShardIndex(hash, shardCount)];
+        const auto found = shard.index.find(_NSCacheKey{ key, hash });
+        if (found != shard.index.end()) {
+            [self _unlinkEntry:found fromShard:shard into:evictions];
+        }
+
+        shard.entries.emplace_front();
+        _NSCacheEntry& entry = shard.entries.front();
+        entry.key = key;
+        entry.object = obj;
+        entry.hash = hash;
+        entry.cost = cost;
+        entry.discardable = [obj conformsToProtocol:@protocol(NSDiscardableContent)];
+        if (cost > 0) {
+            shard.costedEntries.emplace_front(&entry);
+            entry.costPosition = shard.costedEntries.begin();
+        }
+
+        shard.index.emplace(_NSCacheKey{ entry.key, hash }, shard.entries.begin());
+        shard.totalCost += cost;
+
+        // Eviction starts at the least recently used end, so it won't evict our new entry unless that alone is over a limit.
+        // If it is, the new entry is evicted immediately. This matches the reference platform behaviour.
+        [self _evictEntriesOverChargeInShard:shard into:evictions];
     }
-}
 
-// invariant: under lock
-- (void)_insertEntry:(_NSCacheEntry*)entry {
-    auto it = _cacheEntries.emplace(_cacheEntries.begin(), entry);
-    _iterators[entry.key] = it;
+    [self _finishEvictions:evictions];
 }
 
 /**
  @Status Interoperable
 */
 - (void)removeObjectForKey:(id)key {
-    @synchronized(self) {
-        const auto found = _iterators.find(key);
-        if (found == _iterators.end()) {
+    const NSUInteger hash = [key hash];
+    _NSCacheShard& shard = [self _shardForHash:hash];
+    std::vector<_NSCacheEviction> evictions;
+
+    {
+        std::lock_guard<std::recursive_mutex> lock(shard.lock);
+        const auto found = shard.index.find(_NSCacheKey{ key, hash });
+        if (found == shard.index.end()) {
             return;
         }
-        [self _evictEntry:*found->second force:true];
+
+        [self _unlinkEntry:found fromShard:shard into:evictions];
     }
+
+    [self _finishEvictions:evictions];
 }
 
 /**
  @Status Interoperable
 */
 - (void)removeAllObjects {
-    @synchronized(self) {
-        for (auto& entry : _cacheEntries) {
-            if (_delegateFlags.hasWillEvict) {
-                [_delegate cache:self willEvictObject:[entry object]];
-            }
-            if ([entry discardable]) {
-                [[entry object] discardContentIfPossible];
-            }
+    std::vector<_NSCacheEviction> evictions;
+
+    for (NSUInteger i = 0; i < _shardCapacity; ++i) {
+        _NSCacheShard& shard = _shards[i];
+        std::lock_guard<std::recursive_mutex> lock(shard.lock);
+        for (auto& entry : shard.entries) {
+            evictions.emplace_back(_NSCacheEviction{ std::move(entry.object), entry.discardable });
         }
 
-        _cacheEntries.clear();
-        _iterators.clear();
-        _totalCost = 0;
+        shard.index.clear();
+        shard.costedEntries.clear();
+        shard.entries.clear();
+        shard.totalCost = 0;
     }
+
+    [self _finishEvictions:evictions];
 }
 
 /**
  @Status Interoperable
 */
 - (NSUInteger)countLimit {
-    @synchronized(self) {
-        return _countLimit;
-    }
+    return _countLimit;
 }
 
 /**
  @Status Interoperable
 */
 - (void)setCountLimit:(NSUInteger)countLimit {
-    @synchronized(self) {
-        _countLimit = countLimit;
-        [self _evictEntriesOverCharge];
-    }
+    _countLimit = countLimit;
+
+    [self _updateShardCount];
+    [self _evictEntriesOverCharge];
 }
 
 /**
  @Status Interoperable
 */
 - (NSUInteger)totalCostLimit {
-    @synchronized(self) {
-        return _totalCostLimit;
-    }
+    return _totalCostLimit;
 }
 
 /**
  @Status Interoperable
 */
 - (void)setTotalCostLimit:(NSUInteger)totalCostLimit {
-    @synchronized(self) {
-        _totalCostLimit = totalCostLimit;
-        [self _evictEntriesOverCharge];
-    }
+    _totalCostLimit = totalCostLimit;
+
+    [self _updateShardCount];
+    [self _evictEntriesOverCharge];
 }
 
 /**
  @Status Interoperable
 */
 - (id<NSCacheDelegate>)delegate {
-    @synchronized(self) {
-        return _delegate;
-    }
+    std::lock_guard<std::mutex> lock(_delegateLock);
+    return _delegate;
 }
 
 /**
  @Status Interoperable
 */
 - (void)setDelegate:(id<NSCacheDelegate>)delegate {
-    @synchronized(self) {
-        _delegate = delegate;
-        _delegateFlags.hasWillEvict = [_delegate respondsToSelector:@selector(cache:willEvictObject:)];
-    }
+    std::lock_guard<std::mutex> lock(_delegateLock);
+    _delegate = delegate;
+    _delegateFlags.hasWillEvict = [_delegate respondsToSelector:@selector(cache:willEvictObject:)];
 }
 
-// invariant: under lock
-- (NSUInteger)_evictEntry:(_NSCacheEntry*)entry force:(bool)force {
-    // Since we're removing potentially the last reference to entry, we need to keep it alive so that
-    // we can poke at its internals.
-    StrongId<_NSCacheEntry> strongEntry(entry);
-
-    NSUInteger cost = [entry cost];
+// invariant: under shard lock
+// Unlinks an entry from its shard, deferring the delegate callback and discard to _finishEvictions: so that they run with the
+// shard unlocked and can safely call back into the cache.
+- (void)_unlinkEntry:(_NSCacheIndex::iterator)found fromShard:(_NSCacheShard&)shard into:(std::vector<_NSCacheEviction>&)evictions {
+    const auto position = found->second;
+    evictions.emplace_back(_NSCacheEviction{ std::move(position->object), position->discardable });
 
-    id object = entry.object;
-    if (_delegateFlags.hasWillEvict) {
-        [_delegate cache:self willEvictObject:object];
+    shard.totalCost -= position->cost;
+    if (position->cost > 0) {
+        shard.costedEntries.erase(position->costPosition);
     }
 
-    if (entry.discardable) {
-        id<NSDiscardableContent> discardable = (id<NSDiscardableContent>)object;
-        [discardable discardContentIfPossible];
+    // The index holds an unretained key owned by the entry, so remove it first
+    shard.index.erase(found);
+    shard.entries.erase(position);
+}
+
+- (void)_finishEvictions:(std::vector<_NSCacheEviction>&)evictions {
+    if (evictions.empty()) {
+        return;
     }
 
-    _totalCost -= cost;
+    id<NSCacheDelegate> delegate = nil;
+    bool notify = false;
+    {
+        std::lock_guard<std::mutex> lock(_delegateLock);
+        delegate = [[_delegate retain] autorelease];
+        notify = _delegateFlags.hasWillEvict;
+    }
 
-    // std::unordered_map<K, V> will re-hash a value of type K on erase(iterator);
-    // since _cacheEntries holds the owning reference and _iterators does not, we need
-    // to ensure that entry (and therefore entry.key) outlive _cacheEntries' ownership of them.
-    const auto found = _iterators.find([entry key]);
-    _cacheEntries.erase(found->second);
-    _iterators.erase(found);
+    for (auto& eviction : evictions) {
+        if (notify) {
+            [delegate cache:self willEvictObject:eviction.object];
+        }
 
-    return cost;
+        if (eviction.discardable) {
+            [static_cast<id<NSDiscardableContent>>(eviction.object.get()) discardContentIfPossible];
+        }
+    }
 }
 
-// invariant: under lock
-- (void)_evictEntriesOverCharge {
-    if (_cacheEntries.size() == 0) {
-        return;
+// Shards a default cache uses under its current limits. Each shard evicts on its own, so a cost limit, which a single
+// entry may take most of, or a count limit too small to spread keeps the cache in one shard with exact LRU eviction.
+- (NSUInteger)_preferredShardCount {
+    if (_totalCostLimit != 0) {
+        return 1;
     }
 
-    long long overCost = _totalCost > 0 ? ((long long)_totalCost - _totalCostLimit) : 0;
-    long long overCount = _countLimit > 0 ? ((long long)_cacheEntries.size() - _countLimit) : 0;
-    if (overCost <= 0 && overCount <= 0) {
+    if (_countLimit != 0) {
+        return std::min(_shardCapacity, std::max<NSUInteger>(1, _countLimit / c_NSCacheMinEntriesPerShard));
+    }
+
+    return _shardCapacity;
+}
+
+// Moves a default cache to the shard count its limits call for, as long as it is still empty
+- (void)_updateShardCount {
+    if (!_adaptsShardCount) {
         return;
     }
 
-    auto rit = _cacheEntries.end();
-    do {
-        _NSCacheEntry* entry = (id) * --rit;
-        auto cost = [entry cost];
-        bool evict = (overCount > 0 || (cost > 0 && overCost > 0));
-        if (evict) {
-            ++rit; // we'll decrement over this next time through
-            overCost -= [self _evictEntry:entry force:false];
-            overCount--;
-            continue;
+    std::vector<std::unique_lock<std::recursive_mutex>> locks;
+    locks.reserve(_shardCapacity);
+    for (NSUInteger i = 0; i < _shardCapacity; ++i) {
+        locks.emplace_back(_shards[i].lock);
+        if (!_shards[i].entries.empty()) {
+            return;
         }
-    } while ((overCost > 0 || overCount > 0) && rit != _cacheEntries.begin());
+    }
+
+    _shardCount = [self _preferredShardCount];
 }
+
+// Per-shard share of a limit, rounded up so that an unstriped cache keeps the exact limit
+- (NSUInteger)_shardLimit:(NSUInteger)limit {
+    const NSUInteger shardCount = _shardCount;
+    return (limit / shardCount) + ((limit % shardCount) ? 1 : 0);
+}
+
+// invariant: under shard lock
+- (void)_evictEntriesOverChargeInShard:(_NSCacheShard&)shard into:(std::vector<_NSCacheEviction>&)evictions {
+    const NSUInteger countLimit = [self _shardLimit:_countLimit];
+    const NSUInteger totalCostLimit = [self _shardLimit:_totalCostLimit];
+
+    // The count limit evicts least recently used entries whatever their cost
+    while ((countLimit > 0) && (shard.entries.size() > countLimit)) {
+        const _NSCacheEntry& entry = shard.entries.back();
+        [self _unlinkEntry:shard.index.find(_NSCacheKey{ entry.key, entry.hash }) fromShard:shard into:evictions];
+    }
+
+    // Only entries with a cost can relieve the cost limit, so walk the costed list instead of skipping free entries
+    while ((totalCostLimit > 0) && (shard.totalCost > totalCostLimit) && !shard.costedEntries.empty()) {
+        const _NSCacheEntry& entry = *shard.costedEntries.back();
+        [self _unlinkEntry:shard.index.find(_NSCacheKey{ entry.key, entry.hash }) fromShard:shard into:evictions];
+    }
+}
+
+- (void)_evictEntriesOverCharge {
+    std::vector<_NSCacheEviction> evictions;
+    for (NSUInteger i = 0; i < _shardCapacity; ++i) {
+        _NSCacheShard& shard = _shards[i];
+        std::lock_guard<std::recursive_mutex> lock(shard.lock);
+        [self _evictEntriesOverChargeInShard:shard into:evictions];
+    }
+
+    [self _finishEvictions:evictions];
+}
+@end
+
+@implementation NSCache (Internal)
+
+- (instancetype)_initWithStripeCount:(NSUInteger)stripeCount {
+    if (self = [super init]) {
+        _evictsObjectsWithDiscardedContent = YES;
+        _countLimit = 0;
+        _totalCostLimit = 0;
+        _shardCapacity = std::max<NSUInteger>(1, stripeCount);
+        _shardCount = _shardCapacity;
+        _adaptsShardCount = false;
+        _shards.reset(new _NSCacheShard[_shardCapacity]);
+    }
+    return self;
+}
+
 @end
@@ -17,8 +17,12 @@
 #import "Starboard.h"
 #import "StubReturn.h"
 #import <algorithm>
+#import <atomic>
+#import <map>
 #import <memory>
+#import <mutex>
 #import <string>
+#import <io.h>
 #import "Foundation/NSMutableData.h"
 #import "Foundation/NSError.h"
 #import "Foundation/NSScanner.h"
@@ -39,6 +43,7 @@
 #import <sstream>
 #import <iomanip>
 #import "NSCFData.h"
+#import "NSDataInternal.h"
 #import "NSRaise.h"
 #import "StringHelpers.h"
 #import "LoggingNative.h"
@@ -52,6 +57,157 @@ using namespace Windows::Foundation;
 
 // TODO: BUG 192601: Enable ARC on this file once the code gen error is fixed
 
+#pragma region Mapped Files
+namespace {
+
+// Files shorter than this are read even when mapping is allowed: a view costs at least one 64KB allocation granule
+const size_t c_minimumMappedFileLength = 64 * 1024;
+
+// A read-only view of a whole file. Every NSData over the view, zero-copy subdata included, shares ownership of it through
+// its deallocator, so the file stays mapped until the last of them is freed.
+class MappedFileView {
+public:
+    MappedFileView(const uint8_t* bytes, size_t length) : _bytes(bytes), _length(length) {
+    }
+
+    MappedFileView(const MappedFileView&) = delete;
+    MappedFileView& operator=(const MappedFileView&) = delete;
+
+    ~MappedFileView();
+
+    const uint8_t* bytes() const {
+        return _bytes;
+    }
+
+    size_t length() const {
+        return _length;
+    }
+
+private:
+    const uint8_t* _bytes;
+    size_t _length;
+};
+
+// Live views by base address, so that subdataWithRange: can tell whether the bytes it is slicing are mapped
+class MappedFileViewRegistry {
+public:
+    void add(const std::shared_ptr<MappedFileView>& view) {
+        std::lock_guard<std::mutex> lock(_lock);
+        _views[view->bytes()] = view;
+        _count = _views.size();
+    }
+
+    void remove(const MappedFileView* view) {
+        std::lock_guard<std::mutex> lock(_lock);
+        _views.erase(view->bytes());
+        _count = _views.size();
+    }
+
+    // The view holding all of [bytes, bytes + length), or nullptr
+    std::shared_ptr<MappedFileView> find(const void* bytes, size_t length) {
+        if (_count == 0) {
+            return nullptr;
+        }
+
+        const uint8_t* begin = static_cast<const uint8_t*>(bytes);
+        std::lock_guard<std::mutex> lock(_lock);
+        auto it = _views.upper_bound(begin);
+        if (it == _views.begin()) {
+            return nullptr;
+        }
+
+        std::shared_ptr<MappedFileView> view = std::prev(it)->second.lock();
+        if (!view || begin + length > view->bytes() + view->length()) {
+            return nullptr;
+        }
+
+        return view;
+    }
+
+private:
+    std::mutex _lock;
+    std::map<const uint8_t*, std::weak_ptr<MappedFileView>> _views;
+    std::atomic<size_t> _count{ 0 };
+};
+
+MappedFileViewRegistry& _mappedFileViews() {
+    static MappedFileViewRegistry* registry = new MappedFileViewRegistry();
+    return *registry;
+}
+
+MappedFileView::~MappedFileView() {
+    _mappedFileViews().remove(this);
+    UnmapViewOfFile(_bytes);
+}
+
+// Maps a file read-only. Returns nullptr, leaving the caller to read the file, when it can't be mapped or mapping isn't
+// worthwhile: the file is small, or NSDataReadingMappedIfSafe was asked for and the file lives on a remote volume whose
+// contents could vanish from under the mapping.
+std::shared_ptr<MappedFileView> _mapFile(const char* fileName, NSDataReadingOptions options) {
+    EbrFile* file = EbrFopen(fileName, "rb");
+    if (!file) {
+        return nullptr;
+    }
+
+    auto closeFile = wil::ScopeExit([&]() { EbrFclose(file); });
+
+    FILE* nativeFile = EbrNativeFILE(file);
+    HANDLE fileHandle = nativeFile ? reinterpret_cast<HANDLE>(_get_osfhandle(_fileno(nativeFile))) : INVALID_HANDLE_VALUE;
+    LARGE_INTEGER fileLength;
+    if (fileHandle == INVALID_HANDLE_VALUE || !GetFileSizeEx(fileHandle, &fileLength) || fileLength.QuadPart == 0 ||
+        static_cast<uint64_t>(fileLength.QuadPart) > SIZE_MAX) {
+        return nullptr;
+    }
+
+    if ((options & NSDataReadingMappedAlways) == 0) {
+        FILE_REMOTE_PROTOCOL_INFO remoteInfo;
+        if (fileLength.QuadPart < c_minimumMappedFileLength ||
+            GetFileInformationByHandleEx(fileHandle, FileRemoteProtocolInfo, &remoteInfo, sizeof(remoteInfo))) {
+            return nullptr;
+        }
+    }
+
+    HANDLE mapping = CreateFileMappingFromApp(fileHandle, nullptr, PAGE_READONLY, 0, nullptr);
+    if (!mapping) {
+        TraceVerbose(TAG, L"Unable to map %hs: %d", fileName, GetLastError());
+        return nullptr;
+    }
+
+    //  The view keeps the mapping object alive after its handle is closed
+    void* bytes = MapViewOfFileFromApp(mapping, FILE_MAP_READ, 0, 0);
+    CloseHandle(mapping);
+    if (!bytes) {
+        TraceVerbose(TAG, L"Unable to map a view of %hs: %d", fileName, GetLastError());
+        return nullptr;
+    }
+
+    auto view = std::make_shared<MappedFileView>(static_cast<const uint8_t*>(bytes), static_cast<size_t>(fileLength.QuadPart));
+    _mappedFileViews().add(view);
+    return view;
+}
+
+} // namespace
+
+// Raises NSRangeException unless range lies within data of the given length. Written so that no sum can wrap around.
+static void _checkRange(NSRange range, NSUInteger length) {
+    if (range.location > length || range.length > length - range.location) {
+        [NSException raise:NSRangeException
+                    format:@"Specified range %@ exceeds data's length %lu", NSStringFromRange(range), static_cast<unsigned long>(length)];
+    }
+}
+
+// Initializes data over part of a mapped file without copying it
+static NSData* _initWithMappedFileView(NSData* self, const std::shared_ptr<MappedFileView>& view, const uint8_t* bytes, NSUInteger length) {
+    std::shared_ptr<MappedFileView> owner = view;
+    return [self initWithBytesNoCopy:const_cast<uint8_t*>(bytes)
+                              length:length
+                         deallocator:^(void*, NSUInteger) {
+                             //  The view is released along with this block, after the data is done with its bytes
+                             (void)owner;
+                         }];
+}
+#pragma endregion
+
 @implementation NSData
 
 BASE_CLASS_REQUIRED_IMPLS(NSData, NSDataPrototype, CFDataGetTypeID);
@@ -277,20 +433,21 @@ BASE_CLASS_REQUIRED_IMPLS(NSData, NSDataPrototype, CFDataGetTypeID);
  @Status Interoperable
 */
 - (void)getBytes:(void*)dest range:(NSRange)range {
-    if (range.location + range.length > [self length]) {
-        [NSException raise:NSRangeException
-                    format:@"Specified range { %d, %d } exceeds data's length %d", range.location, range.length, [self length]];
+    _checkRange(range, [self length]);
+
+    //  Copying a large range out of a mapped file reads it front to back
+    if (range.length >= c_minimumMappedFileLength) {
+        [self _adviseAccessPattern:_NSDataAccessPatternSequential range:range];
     }
+
     memcpy_s(dest, range.length, reinterpret_cast<const void*>(reinterpret_cast<const byte*>(self.bytes) + range.location), range.length);
 }
 
 /**
- @Status Caveat
- @Notes File is not mapped; defers to initWithContentsOfFile:
+ @Status Interoperable
 */
 - (instancetype)initWithContentsOfMappedFile:(NSString*)filename {
-    TraceVerbose(TAG, L"Not actually mapping file ...");
-    return [self initWithContentsOfFile:filename];
+    return [self initWithContentsOfFile:filename options:NSDataReadingMappedAlways error:nullptr];
 }
 
 /**
@@ -314,6 +471,7 @@ BASE_CLASS_REQUIRED_IMPLS(NSData, NSDataPrototype, CFDataGetTypeID);
     }
     EbrFile* fpOut = EbrFopen((const char*)fname, "wb");
     if (fpOut) {
+        [self _adviseAccessPattern:_NSDataAccessPatternSequential range:NSMakeRange(0, [self length])];
         EbrFwrite([self bytes], 1, [self length], fpOut);
         EbrFclose(fpOut);
 
@@ -346,6 +504,7 @@ BASE_CLASS_REQUIRED_IMPLS(NSData, NSDataPrototype, CFDataGetTypeID);
     TraceVerbose(TAG, L"NSData writing %hs (%d bytes)", fname, [self length]);
     EbrFile* fpOut = EbrFopen((const char*)fname, "wb");
     if (fpOut) {
+        [self _adviseAccessPattern:_NSDataAccessPatternSequential range:NSMakeRange(0, [self length])];
         EbrFwrite([self bytes], 1, [self length], fpOut);
         EbrFclose(fpOut);
         return YES;
@@ -378,8 +537,7 @@ BASE_CLASS_REQUIRED_IMPLS(NSData, NSDataPrototype, CFDataGetTypeID);
 }
 
 /**
- @Status Caveat
- @Notes File is not mapped; defers to initWithContentsOfFile:
+ @Status Interoperable
 */
 + (instancetype)dataWithContentsOfMappedFile:(NSString*)filename {
     return [[[self alloc] initWithContentsOfMappedFile:filename] autorelease];
@@ -387,7 +545,8 @@ BASE_CLASS_REQUIRED_IMPLS(NSData, NSDataPrototype, CFDataGetTypeID);
 
 /**
  @Status Caveat
- @Notes options parameter not supported
+ @Notes NSDataReadingUncached is not supported. Files shorter than 64KB are read rather than mapped unless
+        NSDataReadingMappedAlways is specified.
 */
 - (instancetype)initWithContentsOfFile:(NSString*)filename options:(NSDataReadingOptions)options error:(NSError**)error {
     if (!filename) {
@@ -400,6 +559,12 @@ BASE_CLASS_REQUIRED_IMPLS(NSData, NSDataPrototype, CFDataGetTypeID);
 
     char* fname = (char*)[filename UTF8String];
 
+    if (options & (NSDataReadingMappedIfSafe | NSDataReadingMappedAlways)) {
+        if (auto view = _mapFile(fname, options)) {
+            return _initWithMappedFileView(self, view, view->bytes(), view->length());
+        }
+    }
+
     TraceVerbose(TAG, L"NSData extended-opening %hs", fname);
     EbrFile* fpIn = EbrFopen(fname, "rb");
     if (fpIn) {
@@ -458,13 +623,18 @@ BASE_CLASS_REQUIRED_IMPLS(NSData, NSDataPrototype, CFDataGetTypeID);
 }
 
 /**
- @Status Stub
+ @Status Caveat
+ @Notes Subclasses that do not override this initializer receive a copy of bytes; deallocator is called immediately.
 */
 - (instancetype)initWithBytesNoCopy:(void*)bytes
                              length:(NSUInteger)length
                         deallocator:(void (^)(void* bytes, NSUInteger length))deallocator {
-    UNIMPLEMENTED();
-    return nil;
+    self = [self initWithBytes:bytes length:length];
+    if (deallocator) {
+        deallocator(bytes, length);
+    }
+
+    return self;
 }
 
 /**
@@ -513,7 +683,7 @@ BASE_CLASS_REQUIRED_IMPLS(NSData, NSDataPrototype, CFDataGetTypeID);
 
 /**
  @Status Caveat
- @Notes options parameter not supported
+ @Notes NSDataReadingUncached is not supported. See initWithContentsOfFile:options:error:
 */
 + (instancetype)dataWithContentsOfFile:(NSString*)filename options:(NSDataReadingOptions)options error:(NSError**)error {
     return [[[self alloc] initWithContentsOfFile:filename options:options error:error] autorelease];
@@ -521,7 +691,7 @@ BASE_CLASS_REQUIRED_IMPLS(NSData, NSDataPrototype, CFDataGetTypeID);
 
 /**
  @Status Caveat
- @Notes options parameter not supported
+ @Notes NSDataReadingUncached is not supported. See initWithContentsOfFile:options:error:
 */
 + (instancetype)dataWithContentsOfURL:(NSURL*)url options:(NSDataReadingOptions)options error:(NSError**)error {
     return [[[self alloc] initWithContentsOfURL:url options:options error:error] autorelease];
@@ -543,7 +713,7 @@ BASE_CLASS_REQUIRED_IMPLS(NSData, NSDataPrototype, CFDataGetTypeID);
 
 /**
  @Status Caveat
- @Notes options parameter not supported
+ @Notes NSDataReadingUncached is not supported. See initWithContentsOfFile:options:error:
 */
 - (instancetype)initWithContentsOfURL:(NSURL*)url options:(NSDataReadingOptions)options error:(NSError**)error {
     TraceVerbose(TAG, L"initWithContentsOfURL: %hs", [[url absoluteString] UTF8String]);
@@ -561,10 +731,19 @@ BASE_CLASS_REQUIRED_IMPLS(NSData, NSDataPrototype, CFDataGetTypeID);
 
 /**
  @Status Interoperable
+ @Notes Subdata of file-mapped data shares the mapping instead of copying.
 */
 - (instancetype)subdataWithRange:(NSRange)range {
-    return [NSData dataWithBytes:reinterpret_cast<const void*>(reinterpret_cast<const byte*>(self.bytes) + range.location)
-                          length:range.length];
+    _checkRange(range, [self length]);
+
+    const uint8_t* bytes = reinterpret_cast<const uint8_t*>(self.bytes) + range.location;
+    if (range.length > 0) {
+        if (auto view = _mappedFileViews().find(bytes, range.length)) {
+            return [_initWithMappedFileView([NSData alloc], view, bytes, range.length) autorelease];
+        }
+    }
+
+    return [NSData dataWithBytes:bytes length:range.length];
 }
 
 /**
@@ -683,3 +862,27 @@ BASE_CLASS_REQUIRED_IMPLS(NSData, NSDataPrototype, CFDataGetTypeID);
 }
 
 @end
+
+@implementation NSData (Internal)
+
+- (void)_adviseAccessPattern:(_NSDataAccessPattern)pattern range:(NSRange)range {
+    _checkRange(range, [self length]);
+
+    //  Windows has no per-range read-ahead policy for mapped views; the nearest hint is to prefetch the pages about to be read.
+    //  Random and Normal access are left to demand paging, which already faults in one page at a time.
+    if ((pattern != _NSDataAccessPatternSequential && pattern != _NSDataAccessPatternWillNeed) || range.length == 0) {
+        return;
+    }
+
+    const uint8_t* bytes = static_cast<const uint8_t*>([self bytes]) + range.location;
+    if (!_mappedFileViews().find(bytes, range.length)) {
+        return;
+    }
+
+    WIN32_MEMORY_RANGE_ENTRY entry = { const_cast<uint8_t*>(bytes), range.length };
+    if (!PrefetchVirtualMemory(GetCurrentProcess(), 1, &entry, 0)) {
+        TraceVerbose(TAG, L"Unable to prefetch %lu mapped bytes: %d", static_cast<unsigned long>(range.length), GetLastError());
+    }
+}
+
+@end
@@ -16,282 +16,1070 @@
 
 #import <Foundation/Foundation.h>
 #import <Foundation/FoundationErrors.h>
+#import <CoreFoundation/CoreFoundation.h>
 #include "Starboard.h"
-#include "StubReturn.h"
 
-#include <COMIncludes.h>
-#include <wrl\client.h>
-#include <wrl\wrappers\corewrappers.h>
-#include <windows.foundation.collections.h>
-#include <windows.data.json.h>
-#include <COMIncludes_End.h>
+#include <algorithm>
+#include <cmath>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <vector>
 
-#include "StringHelpers.h"
-#include "WRLHelpers.h"
+#if defined(_M_IX86) || defined(_M_X64) || defined(__SSE2__)
+#define NSJSON_SSE 1
+#include <emmintrin.h>
+#else
+#define NSJSON_SSE 0
+#endif
 
-using namespace ABI::Windows::Foundation::Collections;
-using namespace ABI::Windows::Data::Json;
-using namespace Microsoft::WRL;
-using namespace Windows::Foundation;
+#if defined(_M_ARM) || defined(__ARM_NEON)
+#define NSJSON_NEON 1
+#include <arm_neon.h>
+#else
+#define NSJSON_NEON 0
+#endif
 
-#define NSJSONTYPENAMELENGTH 20
+namespace {
 
-@implementation NSJSONSerialization
+#pragma region Scanning
+// Structural scanning. JSON text spends most of its bytes inside strings and, when pretty-printed, in indentation, so these
+// are the two runs skipped sixteen bytes at a time; everything else is a handful of bytes between them.
 
-// Helper to convert between NSJSon object model and winRT object model.
-// Specifically converts between base foundation types like Dictionary/Array and
-// coverts to a Windows::Data::Json::IJsonValue object.
-ComPtr<IJsonValue> _NSJSONToWDJJsonValue(id object, BOOL isTop) {
-    ComPtr<IJsonValue> ret;
+#if NSJSON_NEON
+// Offset of the first non-zero byte of a 16-byte comparison result, or 16 if there is none
+inline unsigned _firstSetByte(uint8x16_t hits) {
+    const uint64_t low = vgetq_lane_u64(vreinterpretq_u64_u8(hits), 0);
+    if (low) {
+        return __builtin_ctzll(low) / 8;
+    }
 
-    ComPtr<IJsonValueStatics> jsonValueStatics;
-    THROW_NS_IF_FAILED(GetActivationFactory(Wrappers::HStringReference(RuntimeClass_Windows_Data_Json_JsonValue).Get(), &jsonValueStatics));
+    const uint64_t high = vgetq_lane_u64(vreinterpretq_u64_u8(hits), 1);
+    return high ? 8 + __builtin_ctzll(high) / 8 : 16;
+}
+#endif
 
-    if ([object isKindOfClass:[NSDictionary class]]) {
-        ComPtr<IJsonObject> jsonObject;
-        THROW_NS_IF_FAILED(ActivateInstance(Wrappers::HStringReference(RuntimeClass_Windows_Data_Json_JsonObject).Get(), &jsonObject));
-        THROW_NS_IF_FAILED(jsonObject.As(&ret));
+// The first byte at or after p that ends a run of plain string content: a quote, a backslash or a control character
+inline const uint8_t* _scanStringContent(const uint8_t* p, const uint8_t* end) {
+#if NSJSON_SSE
+    const __m128i quote = _mm_set1_epi8('"');
+    const __m128i backslash = _mm_set1_epi8('\\');
+    const __m128i lastControl = _mm_set1_epi8(0x1f);
+    for (; end - p >= 16; p += 16) {
+        const __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
 
-        for (id key in(NSDictionary*)object) {
-            id value = [(NSDictionary*)object objectForKey:key];
-            ComPtr<IJsonValue> jsonValue = _NSJSONToWDJJsonValue(value, NO);
-
-            auto wrlKey = Strings::NarrowToWide<HSTRING>(key);
-            THROW_NS_IF_FAILED(jsonObject->SetNamedValue(wrlKey.Get(), jsonValue.Get()));
+        //  SSE2 only compares signed bytes; bytes <= 0x1f unsigned are exactly those left unchanged by an unsigned min
+        const __m128i hits = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(bytes, quote), _mm_cmpeq_epi8(bytes, backslash)),
+                                          _mm_cmpeq_epi8(_mm_min_epu8(bytes, lastControl), bytes));
+        const int mask = _mm_movemask_epi8(hits);
+        if (mask) {
+            return p + __builtin_ctz(mask);
         }
-    } else if ([object isKindOfClass:[NSArray class]]) {
-        ComPtr<IJsonArray> array;
-        THROW_NS_IF_FAILED(ActivateInstance(Wrappers::HStringReference(RuntimeClass_Windows_Data_Json_JsonArray).Get(), &array));
-        THROW_NS_IF_FAILED(array.As(&ret));
-        for (id value in(NSArray*)object) {
-            ComPtr<IJsonValue> jsonValue = _NSJSONToWDJJsonValue(value, NO);
+    }
+#elif NSJSON_NEON
+    for (; end - p >= 16; p += 16) {
+        const uint8x16_t bytes = vld1q_u8(p);
+        const uint8x16_t hits =
+            vorrq_u8(vorrq_u8(vceqq_u8(bytes, vdupq_n_u8('"')), vceqq_u8(bytes, vdupq_n_u8('\\'))), vcleq_u8(bytes, vdupq_n_u8(0x1f)));
+        const unsigned offset = _firstSetByte(hits);
+        if (offset < 16) {
+            return p + offset;
+        }
+    }
+#endif
+
+    while (p < end && *p != '"' && *p != '\\' && *p >= 0x20) {
+        ++p;
+    }
+
+    return p;
+}
+
+inline bool _isWhitespace(uint8_t c) {
+    return c == ' ' || c == '\n' || c == '\r' || c == '\t';
+}
 
-            ComPtr<IVector<IJsonValue*>> jsonArray;
-            THROW_NS_IF_FAILED(ret.As(&jsonArray));
-            THROW_NS_IF_FAILED(jsonArray->Append(jsonValue.Get()));
+inline const uint8_t* _skipWhitespace(const uint8_t* p, const uint8_t* end) {
+    //  Minified documents have no whitespace at all; don't pay for a vector load to find that out
+    if (p == end || !_isWhitespace(*p)) {
+        return p;
+    }
+
+#if NSJSON_SSE
+    const __m128i space = _mm_set1_epi8(' ');
+    const __m128i newline = _mm_set1_epi8('\n');
+    const __m128i carriageReturn = _mm_set1_epi8('\r');
+    const __m128i tab = _mm_set1_epi8('\t');
+    for (; end - p >= 16; p += 16) {
+        const __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+        const __m128i whitespace = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(bytes, space), _mm_cmpeq_epi8(bytes, newline)),
+                                                _mm_or_si128(_mm_cmpeq_epi8(bytes, carriageReturn), _mm_cmpeq_epi8(bytes, tab)));
+        const int mask = _mm_movemask_epi8(whitespace) ^ 0xffff;
+        if (mask) {
+            return p + __builtin_ctz(mask);
         }
-    } else if ((!isTop) && [object isKindOfClass:[NSNumber class]]) {
-        // Check if the number is NSCFBoolean
-        if ([object isKindOfClass:[static_cast<NSNumber*>(kCFBooleanTrue) class]]) {
-            // NSNumber represents a boolean
-            THROW_NS_IF_FAILED(jsonValueStatics->CreateBooleanValue([(NSNumber*)object boolValue], ret.GetAddressOf()));
-        } else {
-            THROW_NS_IF_FAILED(jsonValueStatics->CreateNumberValue([(NSNumber*)object doubleValue], ret.GetAddressOf()));
+    }
+#elif NSJSON_NEON
+    for (; end - p >= 16; p += 16) {
+        const uint8x16_t bytes = vld1q_u8(p);
+        const uint8x16_t whitespace = vorrq_u8(vorrq_u8(vceqq_u8(bytes, vdupq_n_u8(' ')), vceqq_u8(bytes, vdupq_n_u8('\n'))),
+                                               vorrq_u8(vceqq_u8(bytes, vdupq_n_u8('\r')), vceqq_u8(bytes, vdupq_n_u8('\t'))));
+        const unsigned offset = _firstSetByte(vmvnq_u8(whitespace));
+        if (offset < 16) {
+            return p + offset;
         }
-    } else if ((!isTop) && [object isKindOfClass:[NSString class]]) {
-        THROW_NS_IF_FAILED(jsonValueStatics->CreateStringValue(Strings::NarrowToWide<HSTRING>(object).Get(), ret.GetAddressOf()));
-    } else if ((!isTop) && [object isKindOfClass:[NSNull class]]) {
-        ComPtr<IJsonValueStatics2> jsonValueStatics2;
+    }
+#endif
+
+    while (p < end && _isWhitespace(*p)) {
+        ++p;
+    }
+
+    return p;
+}
 
-        THROW_NS_IF_FAILED(jsonValueStatics.As(&jsonValueStatics2));
-        THROW_NS_IF_FAILED(jsonValueStatics2->CreateNullValue(ret.GetAddressOf()));
+inline int _hexDigitValue(uint8_t c) {
+    if (c >= '0' && c <= '9') {
+        return c - '0';
+    } else if (c >= 'a' && c <= 'f') {
+        return c - 'a' + 10;
+    } else if (c >= 'A' && c <= 'F') {
+        return c - 'A' + 10;
+    }
+
+    return -1;
+}
+
+void _appendUTF8(std::string& out, uint32_t codePoint) {
+    if (codePoint < 0x80) {
+        out.push_back(static_cast<char>(codePoint));
+    } else if (codePoint < 0x800) {
+        out.push_back(static_cast<char>(0xc0 | (codePoint >> 6)));
+        out.push_back(static_cast<char>(0x80 | (codePoint & 0x3f)));
+    } else if (codePoint < 0x10000) {
+        out.push_back(static_cast<char>(0xe0 | (codePoint >> 12)));
+        out.push_back(static_cast<char>(0x80 | ((codePoint >> 6) & 0x3f)));
+        out.push_back(static_cast<char>(0x80 | (codePoint & 0x3f)));
     } else {
-        // Top level object must be one of NSDictionary or NSArray
-        if (isTop) {
-            THROW_NS_HR_MSG(E_INVALIDARG, "Invalid top-level type (%@) in JSON write", [object class]);
-        } else {
-            THROW_NS_HR_MSG(E_INVALIDARG, "Invalid type (%@) in JSON write", [object class]);
+        out.push_back(static_cast<char>(0xf0 | (codePoint >> 18)));
+        out.push_back(static_cast<char>(0x80 | ((codePoint >> 12) & 0x3f)));
+        out.push_back(static_cast<char>(0x80 | ((codePoint >> 6) & 0x3f)));
+        out.push_back(static_cast<char>(0x80 | (codePoint & 0x3f)));
+    }
+}
+#pragma endregion
+
+#pragma region Reading
+// Dictionary keys seen so far in a document, so that the thousands of records in a typical array share one NSString per
+// key instead of allocating one per occurrence.
+class JSONKeyTable {
+public:
+    JSONKeyTable() : _slots(c_initialSlots), _count(0) {
+    }
+
+    JSONKeyTable(const JSONKeyTable&) = delete;
+    JSONKeyTable& operator=(const JSONKeyTable&) = delete;
+
+    ~JSONKeyTable() {
+        for (const Slot& slot : _slots) {
+            [slot.key release];
         }
     }
 
-    return ret;
-}
+    // A retained key for the UTF-8 bytes, or nil if they are not valid UTF-8
+    NSString* keyForBytes(const uint8_t* bytes, size_t length) {
+        if (length > c_maxInternedLength) {
+            return _createString(bytes, length);
+        }
+
+        //  FNV-1a
+        uint32_t hash = 2166136261u;
+        for (size_t i = 0; i < length; ++i) {
+            hash = (hash ^ bytes[i]) * 16777619u;
+        }
+
+        const size_t mask = _slots.size() - 1;
+        for (size_t index = hash & mask;; index = (index + 1) & mask) {
+            Slot& slot = _slots[index];
+            if (!slot.key) {
+                NSString* key = _createString(bytes, length);
+                if (!key || _count >= c_maxKeys) {
+                    return key;
+                }
+
+                slot.hash = hash;
+                slot.bytes.assign(reinterpret_cast<const char*>(bytes), length);
+                slot.key = [key retain];
+                if (++_count * 2 > _slots.size()) {
+                    _grow();
+                }
+
+                return key;
+            }
 
-// Copies IJsonObject* (a mapping from string to WDJJsonValue*) to NSMutableDictionary
-id _WDJJsonObjectToNSJSON(const ComPtr<IJsonObject>& object, NSError** error) {
-    ComPtr<IMap<HSTRING, IJsonValue*>> map;
+            if (slot.hash == hash && slot.bytes.size() == length && memcmp(slot.bytes.data(), bytes, length) == 0) {
+                return [slot.key retain];
+            }
+        }
+    }
 
-    THROW_NS_IF_FAILED(object.As(&map));
-    NSMutableDictionary* ret = [NSMutableDictionary new];
+private:
+    static const size_t c_initialSlots = 64;
 
-    // clang-format off
-    HRESULT hr = WRLHelpers::ForEach(
-        map,
-        [&ret, &error](
-            const ComPtr<ABI::Windows::Foundation::Collections::IKeyValuePair<HSTRING, IJsonValue*>>& pair,
-            boolean* stop) {
-            
-            // Get V from KVP and then add to dictionary
-            ComPtr<IJsonValue> value;
-            RETURN_IF_FAILED(pair->get_Value(&value));
+    // Long keys are rarely repeated, and documents with more distinct keys than this are maps keyed by data, not records
+    static const size_t c_maxInternedLength = 64;
+    static const size_t c_maxKeys = 4096;
 
-            Wrappers::HString key;
-            RETURN_IF_FAILED(pair->get_Key(key.GetAddressOf()));
+    struct Slot {
+        uint32_t hash = 0;
+        std::string bytes;
+        NSString* key = nil;
+    };
 
-            [ret setObject:_WDJJsonValueToNSJSON(value, error, YES) forKey:Strings::WideToNSString(key.Get())];
+    static NSString* _createString(const uint8_t* bytes, size_t length) {
+        return static_cast<NSString*>(CFStringCreateWithBytes(nullptr, bytes, length, kCFStringEncodingUTF8, false));
+    }
 
+    void _grow() {
+        std::vector<Slot> slots(_slots.size() * 2);
+        const size_t mask = slots.size() - 1;
+        for (Slot& slot : _slots) {
+            if (slot.key) {
+                size_t index = slot.hash & mask;
+                while (slots[index].key) {
+                    index = (index + 1) & mask;
+                }
 
-            if (*error != nil) {
-                ret = nil;
-                *stop = true;
+                slots[index] = std::move(slot);
             }
+        }
 
-            return S_OK;
-        });
-    // clang-format on
+        _slots.swap(slots);
+    }
 
-    // Written as a separate line to avoid warnings about unused returns from inner lambda macros. Not exactly sure why but
-    // this placates things.
-    THROW_NS_IF_FAILED(hr);
+    std::vector<Slot> _slots;
+    size_t _count;
+};
 
-    return ret;
-}
+// Single-pass reader from UTF-8 JSON text to Foundation objects. Containers are built bottom-up from a stack of finished
+// values, so nesting depth costs heap rather than native stack.
+class JSONReader {
+public:
+    JSONReader(const uint8_t* bytes, size_t length, NSJSONReadingOptions options)
+        : _begin(bytes), _p(bytes), _end(bytes + length), _options(options), _error(nil) {
+    }
 
-// Copies ComPtr<IJsonArray> (an array of WDJJsonValue*) to NSMutableArray
-id _WDJJsonArrayToNSJSON(const ComPtr<IJsonArray>& array, NSError** error) {
-    NSMutableArray* ret = [NSMutableArray new];
+    JSONReader(const JSONReader&) = delete;
+    JSONReader& operator=(const JSONReader&) = delete;
 
-    ComPtr<IVector<IJsonValue*>> vector;
-    THROW_NS_IF_FAILED(array.As(&vector));
+    ~JSONReader() {
+        for (id value : _values) {
+            [value release];
+        }
+    }
+
+    // The document's top-level value, autoreleased, or nil with *error describing why the text was rejected
+    id read(NSError** error) {
+        id result = _readDocument();
+        if (!result && error) {
+            *error = _error;
+        }
+
+        return [result autorelease];
+    }
+
+private:
+    struct Container {
+        bool isDictionary;
+        size_t firstValue;
+    };
+
+    id _readDocument() {
+        _p = _skipWhitespace(_p, _end);
+        if (_p == _end) {
+            return _fail(@"No value");
+        }
 
-    // clang-format off
-    THROW_NS_IF_FAILED(WRLHelpers::ForEach(
-        vector,
-        [&ret, &error](
-            const ComPtr<IJsonValue>& value,
-            boolean* stop) {
+        if ((_options & NSJSONReadingAllowFragments) == 0 && *_p != '{' && *_p != '[') {
+            return _failWithDescription(@"JSON text did not start with array or object and option to allow fragments not set.");
+        }
 
-            [ret addObject:_WDJJsonValueToNSJSON(value, error, YES)];
-            if (*error != nil) {
-                ret = nil;
-                *stop = true;
+        for (;;) {
+            //  Expecting a value: open a container, or read a leaf and then close as many containers as it finishes
+            _p = _skipWhitespace(_p, _end);
+            if (_p == _end) {
+                return _fail(@"Unexpected end of file while parsing value");
             }
 
-            return S_OK;
-        }));
-    // clang-format on
+            id value = nil;
+            if (*_p == '{' || *_p == '[') {
+                const bool isDictionary = *_p == '{';
+                _p = _skipWhitespace(_p + 1, _end);
+                if (_p < _end && *_p == (isDictionary ? '}' : ']')) {
+                    ++_p;
+                    value = isDictionary ? _createDictionary(0) : _createArray(0);
+                } else {
+                    _containers.push_back({ isDictionary, _values.size() });
+                    if (isDictionary && !_readKey()) {
+                        return nil;
+                    }
 
-    return ret;
-}
+                    continue;
+                }
+            } else if (!(value = _readLeaf())) {
+                return nil;
+            }
+
+            for (;;) {
+                if (_containers.empty()) {
+                    _p = _skipWhitespace(_p, _end);
+                    if (_p != _end) {
+                        [value release];
+                        return _fail(@"Garbage at end");
+                    }
+
+                    return value;
+                }
+
+                _values.push_back(value);
+                const Container container = _containers.back();
+
+                _p = _skipWhitespace(_p, _end);
+                if (_p == _end) {
+                    return _fail(container.isDictionary ? @"Unterminated dictionary" : @"Unterminated array");
+                }
+
+                if (*_p == ',') {
+                    ++_p;
+                    if (container.isDictionary && !_readKey()) {
+                        return nil;
+                    }
+
+                    break;
+                }
 
-// Copies ComPtr<IJsonValue> to the appropriate foundation type
-id _WDJJsonValueToNSJSON(const ComPtr<IJsonValue>& value, NSError** error, BOOL allowFragment) {
-    JsonValueType valueType;
-    THROW_NS_IF_FAILED(value->get_ValueType(&valueType));
-
-    switch (valueType) {
-        case JsonValueType_Null:
-            return [NSNull null];
-        case JsonValueType_Boolean:
-            if (allowFragment) {
-                boolean boolValue = false;
-                THROW_NS_IF_FAILED(value->GetBoolean(&boolValue));
-                return [NSNumber numberWithBool:boolValue];
-            }
-        // drop through to error case if allowFragment is false
-        case JsonValueType_Number:
-            if (allowFragment) {
-                double doubleValue = 0;
-                THROW_NS_IF_FAILED(value->GetNumber(&doubleValue));
-                return [NSNumber numberWithDouble:doubleValue];
-            }
-        // drop through to error case if allowFragment is false
-        case JsonValueType_String:
-            if (allowFragment) {
-                Wrappers::HString string;
-                THROW_NS_IF_FAILED(value->GetString(string.GetAddressOf()));
-                return Strings::WideToNSString(string.Get());
-            } else {
-                // error case - Fragment detected but NSJSONReadingAllowFragments option not specified.
-                *error = [NSError errorWithDomain:NSCocoaErrorDomain
-                                             code:NSPropertyListReadCorruptError
-                                         userInfo:@{
-                                             NSDebugDescriptionKey :
-                                                 @"JSON text did not start with array or object and option to allow fragments not set."
-                                         }];
+                if (*_p != (container.isDictionary ? '}' : ']')) {
+                    return _fail(container.isDictionary ? @"Badly formed dictionary" : @"Badly formed array");
+                }
+
+                ++_p;
+                _containers.pop_back();
+                value = container.isDictionary ? _createDictionary(container.firstValue) : _createArray(container.firstValue);
             }
-            break;
-        case JsonValueType_Array: {
-            // Recursively copy the contents of the array to a new NSMutableArray
-            ComPtr<IJsonArray> array;
-            THROW_NS_IF_FAILED(value->GetArray(&array));
-            return _WDJJsonArrayToNSJSON(array, error);
         }
-        case JsonValueType_Object: {
-            // Recursively copy the contents of the dictionary to a new NSMutableDictionary
-            ComPtr<IJsonObject> object;
-            THROW_NS_IF_FAILED(value->GetObject(&object));
-            return _WDJJsonObjectToNSJSON(object, error);
+    }
+
+    // Reads a dictionary key and the colon after it, leaving the key on the value stack
+    bool _readKey() {
+        _p = _skipWhitespace(_p, _end);
+        if (_p == _end || *_p != '"') {
+            _fail(@"No string key for value in object");
+            return false;
+        }
+
+        id key = _readString(true);
+        if (!key) {
+            return false;
+        }
+
+        _values.push_back(key);
+        _p = _skipWhitespace(_p, _end);
+        if (_p == _end || *_p != ':') {
+            _fail(@"No ':' after key in object");
+            return false;
+        }
+
+        ++_p;
+        return true;
+    }
+
+    // A retained string, number, boolean or null
+    id _readLeaf() {
+        switch (*_p) {
+            case '"':
+                return _readString(false);
+            case 't':
+                return _readLiteral("true", [(NSNumber*)kCFBooleanTrue retain]);
+            case 'f':
+                return _readLiteral("false", [(NSNumber*)kCFBooleanFalse retain]);
+            case 'n':
+                return _readLiteral("null", [[NSNull null] retain]);
+            default:
+                if (*_p == '-' || (*_p >= '0' && *_p <= '9')) {
+                    return _readNumber();
+                }
+
+                return _fail(@"Invalid value");
+        }
+    }
+
+    id _readLiteral(const char* literal, id value) {
+        const size_t length = strlen(literal);
+        if (static_cast<size_t>(_end - _p) < length || memcmp(_p, literal, length) != 0) {
+            [value release];
+            return _fail(@"Invalid value");
+        }
+
+        _p += length;
+        return value;
+    }
+
+    id _readString(bool isKey) {
+        const uint8_t* start = ++_p;
+        const uint8_t* stop = _scanStringContent(start, _end);
+        if (stop < _end && *stop == '"') {
+            _p = stop + 1;
+            return _createString(start, stop - start, isKey);
+        }
+
+        //  Slow path: unescape into the scratch buffer, still skipping plain runs in bulk
+        _scratch.assign(reinterpret_cast<const char*>(start), stop - start);
+        for (_p = stop;;) {
+            if (_p == _end) {
+                return _fail(@"Unterminated string");
+            }
+
+            if (*_p == '"') {
+                ++_p;
+                return _createString(reinterpret_cast<const uint8_t*>(_scratch.data()), _scratch.size(), isKey);
+            }
+
+            if (*_p < 0x20) {
+                return _fail(@"Unescaped control character");
+            }
+
+            if (++_p == _end) {
+                return _fail(@"Unterminated string");
+            }
+
+            switch (*_p++) {
+                case '"':
+                    _scratch.push_back('"');
+                    break;
+                case '\\':
+                    _scratch.push_back('\\');
+                    break;
+                case '/':
+                    _scratch.push_back('/');
+                    break;
+                case 'b':
+                    _scratch.push_back('\b');
+                    break;
+                case 'f':
+                    _scratch.push_back('\f');
+                    break;
+                case 'n':
+                    _scratch.push_back('\n');
+                    break;
+                case 'r':
+                    _scratch.push_back('\r');
+                    break;
+                case 't':
+                    _scratch.push_back('\t');
+                    break;
+                case 'u': {
+                    uint32_t codePoint;
+                    if (!_readEscapedCodePoint(&codePoint)) {
+                        return nil;
+                    }
+
+                    _appendUTF8(_scratch, codePoint);
+                    break;
+                }
+                default:
+                    return _fail(@"Invalid escape sequence");
+            }
+
+            stop = _scanStringContent(_p, _end);
+            _scratch.append(reinterpret_cast<const char*>(_p), stop - _p);
+            _p = stop;
+        }
+    }
+
+    bool _readHexQuad(uint32_t* value) {
+        if (_end - _p < 4) {
+            _fail(@"Invalid unicode escape sequence");
+            return false;
+        }
+
+        *value = 0;
+        for (int i = 0; i < 4; ++i) {
+            const int digit = _hexDigitValue(*_p++);
+            if (digit < 0) {
+                _fail(@"Invalid unicode escape sequence");
+                return false;
+            }
+
+            *value = (*value << 4) | digit;
+        }
+
+        return true;
+    }
+
+    // Reads the digits of a \u escape, and of the low surrogate escape that must follow a high surrogate
+    bool _readEscapedCodePoint(uint32_t* codePoint) {
+        if (!_readHexQuad(codePoint)) {
+            return false;
+        }
+
+        if (*codePoint >= 0xdc00 && *codePoint <= 0xdfff) {
+            _fail(@"Unable to convert hex escape sequence (no high character) to UTF8-encoded character");
+            return false;
+        }
+
+        if (*codePoint >= 0xd800 && *codePoint <= 0xdbff) {
+            uint32_t low;
+            if (_end - _p < 2 || _p[0] != '\\' || _p[1] != 'u') {
+                _fail(@"Unable to convert hex escape sequence (no low character) to UTF8-encoded character");
+                return false;
+            }
+
+            _p += 2;
+            if (!_readHexQuad(&low)) {
+                return false;
+            }
+
+            if (low < 0xdc00 || low > 0xdfff) {
+                _fail(@"Unable to convert hex escape sequence (invalid low character) to UTF8-encoded character");
+                return false;
+            }
+
+            *codePoint = 0x10000 + ((*codePoint - 0xd800) << 10) + (low - 0xdc00);
+        }
+
+        return true;
+    }
+
+    id _readNumber() {
+        static const double c_exactPowersOfTen[] = { 1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+                                                     1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22 };
+
+        const uint8_t* start = _p;
+        const bool negative = *_p == '-';
+        if (negative) {
+            ++_p;
+        }
+
+        //  Accumulate up to 19 significant digits exactly; further digits only move the decimal exponent
+        uint64_t mantissa = 0;
+        int digits = 0;
+        int exponent = 0;
+        bool isInteger = true;
+
+        if (_p == _end || *_p < '0' || *_p > '9') {
+            return _fail(@"Invalid number");
+        }
+
+        if (*_p == '0') {
+            ++_p;
+        } else {
+            for (; _p < _end && *_p >= '0' && *_p <= '9'; ++_p) {
+                if (digits < 19) {
+                    mantissa = mantissa * 10 + (*_p - '0');
+                    ++digits;
+                } else {
+                    ++exponent;
+                    isInteger = false;
+                }
+            }
+        }
+
+        if (_p < _end && *_p == '.') {
+            isInteger = false;
+            if (++_p == _end || *_p < '0' || *_p > '9') {
+                return _fail(@"Invalid number");
+            }
+
+            for (; _p < _end && *_p >= '0' && *_p <= '9'; ++_p) {
+                if (digits < 19 && (mantissa != 0 || *_p != '0')) {
+                    mantissa = mantissa * 10 + (*_p - '0');
+                    ++digits;
+                    --exponent;
+                } else if (mantissa == 0) {
+                    --exponent;
+                }
+            }
+        }
+
+        if (_p < _end && (*_p == 'e' || *_p == 'E')) {
+            isInteger = false;
+            ++_p;
+            const bool negativeExponent = _p < _end && *_p == '-';
+            if (_p < _end && (*_p == '-' || *_p == '+')) {
+                ++_p;
+            }
+
+            if (_p == _end || *_p < '0' || *_p > '9') {
+                return _fail(@"Invalid number");
+            }
+
+            int explicitExponent = 0;
+            for (; _p < _end && *_p >= '0' && *_p <= '9'; ++_p) {
+                explicitExponent = std::min(explicitExponent * 10 + (*_p - '0'), 100000);
+            }
+
+            exponent += negativeExponent ? -explicitExponent : explicitExponent;
+        }
+
+        if (isInteger) {
+            if (!negative && mantissa <= static_cast<uint64_t>(INT64_MAX)) {
+                return [[NSNumber alloc] initWithLongLong:static_cast<long long>(mantissa)];
+            } else if (negative && mantissa <= static_cast<uint64_t>(INT64_MAX) + 1) {
+                return [[NSNumber alloc] initWithLongLong:static_cast<long long>(0 - mantissa)];
+            } else if (!negative) {
+                return [[NSNumber alloc] initWithUnsignedLongLong:mantissa];
+            }
+        }
+
+        double value;
+        if (digits <= 15 && exponent >= -22 && exponent <= 22) {
+            //  Both operands are exact, so the single rounding of the multiply or divide gives the correctly rounded result
+            value = static_cast<double>(mantissa);
+            value = (exponent < 0) ? value / c_exactPowersOfTen[-exponent] : value * c_exactPowersOfTen[exponent];
+            if (negative) {
+                value = -value;
+            }
+        } else {
+            std::string text(reinterpret_cast<const char*>(start), _p - start);
+            value = strtod(text.c_str(), nullptr);
+        }
+
+        if (!std::isfinite(value)) {
+            return _fail(@"Number wound up as NaN");
+        }
+
+        return [[NSNumber alloc] initWithDouble:value];
+    }
+
+    id _createString(const uint8_t* bytes, size_t length, bool isKey) {
+        id string;
+        if (isKey) {
+            string = _keys.keyForBytes(bytes, length);
+        } else if (_options & NSJSONReadingMutableLeaves) {
+            string = [[NSMutableString alloc] initWithBytes:bytes length:length encoding:NSUTF8StringEncoding];
+        } else {
+            string = static_cast<NSString*>(CFStringCreateWithBytes(nullptr, bytes, length, kCFStringEncodingUTF8, false));
+        }
+
+        if (!string) {
+            return _fail(@"Unable to convert data to string");
+        }
+
+        return string;
+    }
+
+    // Builds an array from, and releases, the values at and above firstValue on the value stack
+    id _createArray(size_t firstValue) {
+        const size_t count = _values.size() - firstValue;
+        const id* objects = count ? &_values[firstValue] : nullptr;
+        id array = (_options & NSJSONReadingMutableContainers) ? [[NSMutableArray alloc] initWithObjects:objects count:count] :
+                                                                 [[NSArray alloc] initWithObjects:objects count:count];
+        _popValues(firstValue);
+        return array;
+    }
+
+    // As _createArray, for the alternating keys and values of a dictionary
+    id _createDictionary(size_t firstValue) {
+        const size_t count = (_values.size() - firstValue) / 2;
+        _dictionaryKeys.resize(count);
+        _dictionaryObjects.resize(count);
+        for (size_t i = 0; i < count; ++i) {
+            _dictionaryKeys[i] = _values[firstValue + 2 * i];
+            _dictionaryObjects[i] = _values[firstValue + 2 * i + 1];
+        }
+
+        const id* keys = count ? _dictionaryKeys.data() : nullptr;
+        const id* objects = count ? _dictionaryObjects.data() : nullptr;
+        id dictionary = (_options & NSJSONReadingMutableContainers) ?
+                            [[NSMutableDictionary alloc] initWithObjects:objects forKeys:keys count:count] :
+                            [[NSDictionary alloc] initWithObjects:objects forKeys:keys count:count];
+        _popValues(firstValue);
+        return dictionary;
+    }
+
+    void _popValues(size_t firstValue) {
+        for (size_t i = firstValue; i < _values.size(); ++i) {
+            [_values[i] release];
+        }
+
+        _values.resize(firstValue);
+    }
+
+    id _fail(NSString* reason) {
+        return _failWithDescription([NSString stringWithFormat:@"%@ around character %lu.", reason, (unsigned long)(_p - _begin)]);
+    }
+
+    id _failWithDescription(NSString* description) {
+        if (!_error) {
+            _error = [NSError errorWithDomain:NSCocoaErrorDomain
+                                         code:NSPropertyListReadCorruptError
+                                     userInfo:@{ NSDebugDescriptionKey : description }];
+        }
+
+        return nil;
+    }
+
+    const uint8_t* _begin;
+    const uint8_t* _p;
+    const uint8_t* _end;
+    NSJSONReadingOptions _options;
+    NSError* _error;
+
+    std::vector<id> _values;
+    std::vector<Container> _containers;
+    std::vector<id> _dictionaryKeys;
+    std::vector<id> _dictionaryObjects;
+    std::string _scratch;
+    JSONKeyTable _keys;
+};
+
+// JSON text may be UTF-8, UTF-16 or UTF-32 in either byte order. The encoding comes from the byte order mark or, failing
+// that, from where the zero bytes fall in the first two characters, which are always ASCII. *markLength is set to the
+// length of the byte order mark, if any.
+CFStringEncoding _detectEncoding(const uint8_t* bytes, size_t length, size_t* markLength) {
+    *markLength = 0;
+    if (length >= 4) {
+        if (bytes[0] == 0 && bytes[1] == 0 && bytes[2] == 0xfe && bytes[3] == 0xff) {
+            *markLength = 4;
+            return kCFStringEncodingUTF32BE;
+        } else if (bytes[0] == 0xff && bytes[1] == 0xfe && bytes[2] == 0 && bytes[3] == 0) {
+            *markLength = 4;
+            return kCFStringEncodingUTF32LE;
+        } else if (bytes[0] == 0 && bytes[1] == 0 && bytes[2] == 0 && bytes[3] != 0) {
+            return kCFStringEncodingUTF32BE;
+        } else if (bytes[0] != 0 && bytes[1] == 0 && bytes[2] == 0 && bytes[3] == 0) {
+            return kCFStringEncodingUTF32LE;
+        }
+    }
+
+    if (length >= 3 && bytes[0] == 0xef && bytes[1] == 0xbb && bytes[2] == 0xbf) {
+        *markLength = 3;
+        return kCFStringEncodingUTF8;
+    }
+
+    if (length >= 2) {
+        if (bytes[0] == 0xfe && bytes[1] == 0xff) {
+            *markLength = 2;
+            return kCFStringEncodingUTF16BE;
+        } else if (bytes[0] == 0xff && bytes[1] == 0xfe) {
+            *markLength = 2;
+            return kCFStringEncodingUTF16LE;
+        } else if (bytes[0] == 0 && bytes[1] != 0) {
+            return kCFStringEncodingUTF16BE;
+        } else if (bytes[0] != 0 && bytes[1] == 0) {
+            return kCFStringEncodingUTF16LE;
         }
-        default:
-            *error = [NSError errorWithDomain:NSCocoaErrorDomain code:NSPropertyListReadCorruptError userInfo:nil];
-            return [NSNull null];
     }
 
-    return [NSNull null];
+    return kCFStringEncodingUTF8;
 }
 
-/**
- @Status Caveat
- @Notes Does not support NSJSONWritingPrettyPrinted
-*/
-+ (NSData*)dataWithJSONObject:(id)obj options:(NSJSONWritingOptions)opt error:(NSError**)error {
-    NSError* internalError = nil;
-    // THROW_NS_IF_NULL(E_INVALIDARG, obj);
+id _readJSON(const uint8_t* bytes, size_t length, NSJSONReadingOptions options, NSError** error) {
+    size_t markLength;
+    const CFStringEncoding encoding = _detectEncoding(bytes, length, &markLength);
+    bytes += markLength;
+    length -= markLength;
 
-    ComPtr<IJsonValue> jsonValue = _NSJSONToWDJJsonValue(obj, YES);
-    Wrappers::HString stringObject;
+    if (encoding == kCFStringEncodingUTF8) {
+        return JSONReader(bytes, length, options).read(error);
+    }
 
-    THROW_NS_IF_FAILED(jsonValue->Stringify(stringObject.GetAddressOf()));
+    //  Everything else is transcoded to UTF-8 up front; the reader only ever sees one encoding
+    woc::unique_cf<CFStringRef> text(CFStringCreateWithBytes(nullptr, bytes, length, encoding, false));
+    if (!text) {
+        if (error) {
+            *error = [NSError errorWithDomain:NSCocoaErrorDomain
+                                         code:NSPropertyListReadCorruptError
+                                     userInfo:@{ NSDebugDescriptionKey : @"Unable to convert data to a string using the detected encoding." }];
+        }
+
+        return nil;
+    }
 
-    return [Strings::WideToNSString(stringObject.Get()) dataUsingEncoding:NSUTF8StringEncoding];
+    const CFRange range = { 0, CFStringGetLength(text.get()) };
+    CFIndex utf8Length = 0;
+    CFStringGetBytes(text.get(), range, kCFStringEncodingUTF8, 0, false, nullptr, 0, &utf8Length);
+    std::vector<uint8_t> utf8(std::max<CFIndex>(utf8Length, 1));
+    CFStringGetBytes(text.get(), range, kCFStringEncodingUTF8, 0, false, utf8.data(), utf8Length, nullptr);
+    return JSONReader(utf8.data(), utf8Length, options).read(error);
 }
+#pragma endregion
 
-/**
- @Status Caveat
- @Notes Only UTF8 encoding is supported
-*/
-+ (id)JSONObjectWithData:(NSData*)data options:(NSJSONReadingOptions)opt error:(NSError**)error {
-    NSError* internalError = nil;
+#pragma region Writing
+// Serializes Foundation objects to UTF-8 JSON text in one pass over the object graph
+class JSONWriter {
+public:
+    explicit JSONWriter(NSJSONWritingOptions options) : _prettyPrinted((options & NSJSONWritingPrettyPrinted) != 0) {
+    }
 
-    THROW_NS_IF_NULL(E_INVALIDARG, data);
+    // Raises NSInvalidArgumentException for objects that can't be represented
+    void writeTopLevel(id object) {
+        if (![object isKindOfClass:[NSArray class]] && ![object isKindOfClass:[NSDictionary class]]) {
+            [NSException raise:NSInvalidArgumentException format:@"Invalid top-level type (%@) in JSON write", [object class]];
+        }
 
-    ComPtr<IJsonValueStatics> jsonValueStatics;
-    THROW_NS_IF_FAILED(GetActivationFactory(Wrappers::HStringReference(RuntimeClass_Windows_Data_Json_JsonValue).Get(), &jsonValueStatics));
+        _write(object, 0);
+    }
 
-    NSString* jsonString = [[[NSString alloc] initWithData:data encoding:NSUTF8StringEncoding] autorelease];
+    const std::string& output() const {
+        return _output;
+    }
 
-    boolean didParse = false;
-    ComPtr<IJsonValue> result;
-    THROW_NS_IF_FAILED(jsonValueStatics->TryParse(Strings::NarrowToWide<HSTRING>(jsonString).Get(), &result, &didParse));
+private:
+    void _write(id object, unsigned depth) {
+        if ([object isKindOfClass:[NSString class]]) {
+            _writeString(object);
+        } else if ([object isKindOfClass:[NSNumber class]]) {
+            _writeNumber(object);
+        } else if ([object isKindOfClass:[NSNull class]]) {
+            _output.append("null");
+        } else if ([object isKindOfClass:[NSArray class]]) {
+            _output.push_back('[');
+            bool first = true;
+            for (id value in static_cast<NSArray*>(object)) {
+                _writeSeparator(&first, depth + 1);
+                _write(value, depth + 1);
+            }
 
-    id ret = nil;
-    if (didParse) {
-        ret = _WDJJsonValueToNSJSON(result, &internalError, (opt & NSJSONReadingAllowFragments));
-    } else {
-        internalError = [NSError errorWithDomain:NSCocoaErrorDomain
-                                            code:NSPropertyListReadCorruptError
-                                        userInfo:@{
-                                            NSDebugDescriptionKey : @"Invalid JSON string."
-                                        }];
+            _writeClose(']', depth, first);
+        } else if ([object isKindOfClass:[NSDictionary class]]) {
+            _output.push_back('{');
+            bool first = true;
+            NSDictionary* dictionary = static_cast<NSDictionary*>(object);
+            for (id key in dictionary) {
+                if (![key isKindOfClass:[NSString class]]) {
+                    [NSException raise:NSInvalidArgumentException format:@"Invalid (non-string) key in JSON dictionary"];
+                }
+
+                _writeSeparator(&first, depth + 1);
+                _writeString(key);
+                _output.append(_prettyPrinted ? " : " : ":");
+                _write([dictionary objectForKey:key], depth + 1);
+            }
+
+            _writeClose('}', depth, first);
+        } else {
+            [NSException raise:NSInvalidArgumentException format:@"Invalid type (%@) in JSON write", [object class]];
+        }
     }
 
-    if (internalError) {
-        ret = nil;
-        if (error) {
-            *error = internalError;
+    void _writeSeparator(bool* first, unsigned depth) {
+        if (!*first) {
+            _output.push_back(',');
+        }
+
+        *first = false;
+        _writeNewline(depth);
+    }
+
+    void _writeClose(char close, unsigned depth, bool empty) {
+        //  Empty containers still get their own line, as on the reference platform
+        if (_prettyPrinted && empty) {
+            _output.push_back('\n');
+        }
+
+        _writeNewline(depth);
+        _output.push_back(close);
+    }
+
+    void _writeNewline(unsigned depth) {
+        if (_prettyPrinted) {
+            _output.push_back('\n');
+            _output.append(depth * 2, ' ');
+        }
+    }
+
+    void _writeNumber(NSNumber* number) {
+        if ([number isKindOfClass:[static_cast<NSNumber*>(kCFBooleanTrue) class]]) {
+            _output.append([number boolValue] ? "true" : "false");
+            return;
+        }
+
+        char buffer[32];
+        const char type = [number objCType][0];
+        if (type == 'f' || type == 'd') {
+            const double value = [number doubleValue];
+            if (!std::isfinite(value)) {
+                [NSException raise:NSInvalidArgumentException format:@"Invalid number value (%@) in JSON write", number];
+            }
+
+            //  The shortest of the usual precisions that reads back as the same double
+            for (int precision = 15; precision <= 17; ++precision) {
+                snprintf(buffer, sizeof(buffer), "%.*g", precision, value);
+                if (strtod(buffer, nullptr) == value) {
+                    break;
+                }
+            }
+        } else if (type >= 'A' && type <= 'Z') {
+            snprintf(buffer, sizeof(buffer), "%llu", [number unsignedLongLongValue]);
+        } else {
+            snprintf(buffer, sizeof(buffer), "%lld", [number longLongValue]);
+        }
+
+        _output.append(buffer);
+    }
+
+    void _writeString(NSString* string) {
+        CFStringRef cfString = static_cast<CFStringRef>(string);
+        const uint8_t* bytes = reinterpret_cast<const uint8_t*>(CFStringGetCStringPtr(cfString, kCFStringEncodingUTF8));
+        size_t length;
+        if (bytes) {
+            //  Only ASCII strings hand out a UTF-8 pointer, so the length in characters is the length in bytes
+            length = CFStringGetLength(cfString);
+        } else {
+            const CFRange range = { 0, CFStringGetLength(cfString) };
+            _utf8.resize(std::max<CFIndex>(CFStringGetMaximumSizeForEncoding(range.length, kCFStringEncodingUTF8), 1));
+            CFIndex usedLength = 0;
+            CFStringGetBytes(cfString, range, kCFStringEncodingUTF8, 0, false, _utf8.data(), _utf8.size(), &usedLength);
+            bytes = _utf8.data();
+            length = usedLength;
+        }
+
+        _output.push_back('"');
+        const uint8_t* end = bytes + length;
+        for (const uint8_t* p = bytes; p < end;) {
+            //  The scan stops at quotes, backslashes and control characters; solidus is the only other escaped byte
+            const uint8_t* stop = _scanStringContent(p, end);
+            const uint8_t* solidus = static_cast<const uint8_t*>(memchr(p, '/', stop - p));
+            if (solidus) {
+                stop = solidus;
+            }
+
+            _output.append(reinterpret_cast<const char*>(p), stop - p);
+            if (stop == end) {
+                break;
+            }
+
+            _writeEscaped(*stop);
+            p = stop + 1;
         }
+
+        _output.push_back('"');
     }
 
-    return ret;
+    void _writeEscaped(uint8_t c) {
+        switch (c) {
+            case '"':
+                _output.append("\\\"");
+                break;
+            case '\\':
+                _output.append("\\\\");
+                break;
+            case '/':
+                _output.append("\\/");
+                break;
+            case '\b':
+                _output.append("\\b");
+                break;
+            case '\f':
+                _output.append("\\f");
+                break;
+            case '\n':
+                _output.append("\\n");
+                break;
+            case '\r':
+                _output.append("\\r");
+                break;
+            case '\t':
+                _output.append("\\t");
+                break;
+            default: {
+                char buffer[8];
+                snprintf(buffer, sizeof(buffer), "\\u%04x", c);
+                _output.append(buffer);
+                break;
+            }
+        }
+    }
+
+    bool _prettyPrinted;
+    std::string _output;
+    std::vector<uint8_t> _utf8;
+};
+#pragma endregion
+
+} // namespace
+
+@implementation NSJSONSerialization
+
+/**
+ @Status Interoperable
+*/
++ (NSData*)dataWithJSONObject:(id)obj options:(NSJSONWritingOptions)opt error:(NSError**)error {
+    JSONWriter writer(opt);
+    writer.writeTopLevel(obj);
+    return [NSData dataWithBytes:writer.output().data() length:writer.output().size()];
+}
+
+/**
+ @Status Interoperable
+*/
++ (id)JSONObjectWithData:(NSData*)data options:(NSJSONReadingOptions)opt error:(NSError**)error {
+    if (!data) {
+        [NSException raise:NSInvalidArgumentException format:@"data parameter is nil"];
+    }
+
+    return _readJSON(static_cast<const uint8_t*>([data bytes]), [data length], opt, error);
 }
 
 /**
- @Status Stub
- @Notes
+ @Status Interoperable
+ @Notes The stream must already be open. It is read to the end before parsing begins.
 */
 + (id)JSONObjectWithStream:(NSInputStream*)stream options:(NSJSONReadingOptions)opt error:(NSError* _Nullable*)error {
-    UNIMPLEMENTED();
-    return StubReturn();
+    if (!stream) {
+        [NSException raise:NSInvalidArgumentException format:@"stream parameter is nil"];
+    }
+
+    std::vector<uint8_t> text;
+    size_t length = 0;
+    for (;;) {
+        text.resize(std::max<size_t>(length + 64 * 1024, text.size()));
+        const NSInteger bytesRead = [stream read:text.data() + length maxLength:text.size() - length];
+        if (bytesRead < 0) {
+            if (error) {
+                *error = [stream streamError];
+            }
+
+            return nil;
+        }
+
+        if (bytesRead == 0) {
+            break;
+        }
+
+        length += bytesRead;
+    }
+
+    return _readJSON(text.data(), length, opt, error);
 }
 
 /**
- @Status Stub
- @Notes
+ @Status Interoperable
+ @Notes The stream must already be open.
 */
 + (NSInteger)writeJSONObject:(id)obj toStream:(NSOutputStream*)stream options:(NSJSONWritingOptions)opt error:(NSError* _Nullable*)error {
-    UNIMPLEMENTED();
-    return StubReturn();
+    JSONWriter writer(opt);
+    writer.writeTopLevel(obj);
+
+    const std::string& text = writer.output();
+    size_t written = 0;
+    while (written < text.size()) {
+        const NSInteger bytesWritten =
+            [stream write:reinterpret_cast<const uint8_t*>(text.data()) + written maxLength:text.size() - written];
+        if (bytesWritten <= 0) {
+            if (error) {
+                *error = [stream streamError];
+            }
+
+            return 0;
+        }
+
+        written += bytesWritten;
+    }
+
+    return written;
 }
 
 // Returns true if the dictionary or array value is a valid JSON leaf
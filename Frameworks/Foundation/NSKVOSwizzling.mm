@@ -68,6 +68,7 @@ static void _NSKVOEnsureObjectIsKVOAware(id object) {
     object_addMethod_np(object, @selector(removeObjectForKey:), reinterpret_cast<IMP>(NSKVO$removeObjectForKey$), "v@:@");
 
     object_addMethod_np(object, @selector(_isKVOAware), reinterpret_cast<IMP>(NSKVO$nilIMP), "v@:");
+    _NSKVCInvalidateAccessorCache(object_getClass(object));
 }
 
 #pragma region Method Implementations
@@ -323,8 +324,14 @@ static void _NSKVOEnsureSimpleKeyWillNotify(id object, NSString* key, const char
             return;
     }
 
+    //  Observing a key again leaves the object's KVO subclass as it was, and KVC's cache with it
+    if (class_getMethodImplementation(ABI_ISA(object), sel) == newImpl) {
+        return;
+    }
+
     _associateSelectorWithKey(object, sel, key);
     object_addMethod_np(object, sel, newImpl, types);
+    _NSKVCInvalidateAccessorCache(object_getClass(object));
 }
 
 static void replaceAndAssociateWithKey(id object, SEL sel, NSString* key, IMP imp) {
@@ -336,8 +343,13 @@ static void replaceAndAssociateWithKey(id object, SEL sel, NSString* key, IMP im
             return;
         }
 
+        if (class_getMethodImplementation(ABI_ISA(object), sel) == imp) {
+            return;
+        }
+
         _associateSelectorWithKey(object, sel, key);
         object_replaceMethod_np(object, sel, imp, method_getTypeEncoding(method));
+        _NSKVCInvalidateAccessorCache(object_getClass(object));
     }
 }
 
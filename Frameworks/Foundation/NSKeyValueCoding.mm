@@ -16,6 +16,7 @@
 
 #import <Foundation/Foundation.h>
 #import <Foundation/NSKeyValueCoding.h>
+#import <Starboard/SmartTypes.h>
 #import <Starboard/String.h>
 
 #import "NSDelayedPerform.h"
@@ -33,8 +34,11 @@
 
 #include <functional>
 #include <memory>
+#include <mutex>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string>
+#include <unordered_map>
 #include <unordered_set>
 #include <vector>
 #include <algorithm>
@@ -66,6 +70,91 @@ NSString* _NSKVCSplitKeypath(NSString* keyPath, NSString* __autoreleasing* pRema
     return keyPath;
 }
 
+namespace {
+
+// Everything KVC looks up for one key of one class. Selectors are cached rather than IMPs so that per-object overrides, such
+// as the notifying setters installed by KVO, are still reached through objc_msgSend.
+struct KVCKeyInfo {
+    SEL getter = nullptr;
+    StrongId<NSMethodSignature> getterSignature;
+    SEL setter = nullptr;
+    StrongId<NSMethodSignature> setterSignature;
+    bool hasArrayAdapter = false;
+    struct objc_ivar* ivar = nullptr;
+};
+
+// Resolved keys shared by every thread, by class and then by key. Entries are immutable once published; invalidation only
+// drops the cache's references, so callers still holding an entry finish with the answer they were given.
+class KVCKeyInfoCache {
+public:
+    std::shared_ptr<const KVCKeyInfo> find(Class cls, const char* key, uint64_t* generation) {
+        std::lock_guard<std::mutex> lock(_lock);
+
+        //  The record is created here rather than on insert, so that invalidating a superclass while key is being resolved
+        //  is seen by the insert that follows
+        ClassEntries& classEntries = _classes[cls];
+        *generation = classEntries.generation;
+
+        auto entry = classEntries.keys.find(key);
+        return (entry != classEntries.keys.end()) ? entry->second : nullptr;
+    }
+
+    // Publishes info unless cls was invalidated after generation was read, in which case info may already be stale and is
+    // handed back to the caller without being kept. A racing insert of the same key wins.
+    std::shared_ptr<const KVCKeyInfo> insert(Class cls, const char* key, uint64_t generation, std::shared_ptr<const KVCKeyInfo> info) {
+        std::lock_guard<std::mutex> lock(_lock);
+        ClassEntries& classEntries = _classes[cls];
+        if (generation != classEntries.generation) {
+            return info;
+        }
+
+        return classEntries.keys.emplace(key, std::move(info)).first->second;
+    }
+
+    // Drops the entries of cls and of every cached subclass of it. Lookups of other classes are unaffected.
+    void invalidate(Class cls) {
+        std::lock_guard<std::mutex> lock(_lock);
+        _invalidate(_classes[cls]);
+
+        for (auto& classEntries : _classes) {
+            Class entryClass = class_getSuperclass(classEntries.first);
+            while (entryClass && entryClass != cls) {
+                entryClass = class_getSuperclass(entryClass);
+            }
+
+            if (entryClass) {
+                _invalidate(classEntries.second);
+            }
+        }
+    }
+
+private:
+    // A class's generation outlives its entries, so that resolutions started before an invalidation are never published
+    struct ClassEntries {
+        uint64_t generation = 0;
+        std::unordered_map<std::string, std::shared_ptr<const KVCKeyInfo>> keys;
+    };
+
+    static void _invalidate(ClassEntries& classEntries) {
+        ++classEntries.generation;
+        classEntries.keys.clear();
+    }
+
+    std::mutex _lock;
+    std::unordered_map<Class, ClassEntries> _classes;
+};
+
+KVCKeyInfoCache& _KVCKeyInfoCache() {
+    static KVCKeyInfoCache* cache = new KVCKeyInfoCache();
+    return *cache;
+}
+
+} // namespace
+
+void _NSKVCInvalidateAccessorCache(Class cls) {
+    _KVCKeyInfoCache().invalidate(cls);
+}
+
 @implementation NSObject (NSKeyValueCoding)
 
 /**
@@ -93,8 +182,7 @@ static bool _ivarIsKVCCompliant(Ivar ivar, const char* propName) {
 }
 // clang-format on
 
-struct objc_ivar* KVCIvarForPropertyName(NSObject* self, const char* propName) {
-    Class cls = object_getClass(self);
+static struct objc_ivar* _KVCResolveIvar(Class cls, const char* propName) {
     if (![cls accessInstanceVariablesDirectly]) {
         return nullptr;
     }
@@ -113,7 +201,7 @@ struct objc_ivar* KVCIvarForPropertyName(NSObject* self, const char* propName) {
     return nullptr;
 }
 
-SEL KVCGetterForPropertyName(NSObject* self, const char* key) {
+static SEL _KVCResolveGetter(NSObject* self, const char* key) {
     SEL sel = nullptr;
     auto len = strlen(key);
     char* buf = (char*)_alloca(3 + len + 1);
@@ -147,6 +235,29 @@ SEL KVCGetterForPropertyName(NSObject* self, const char* key) {
     return nullptr;
 }
 
+static SEL _KVCResolveSetter(NSObject* self, const char* key) {
+    SEL sel = nullptr;
+    auto len = strlen(key);
+    // For the key "example", we must construct the following buffer:
+    // _ _ _ _ x a m p l e _ \0
+    // and fill it with the following characters:
+    // s e t E x a m p l e : \0
+    char* buf = (char*)_alloca(3 + len + 2);
+    strcpy_s(buf + 4, len, key + 1);
+    buf[0] = 's';
+    buf[1] = 'e';
+    buf[2] = 't';
+    buf[3] = toupper(key[0]);
+    buf[3 + len] = ':';
+    buf[3 + len + 1] = '\0';
+    sel = sel_getUid(buf);
+    if ([self respondsToSelector:sel]) {
+        return sel;
+    }
+
+    return nullptr;
+}
+
 template <typename T>
 static id quickGet(id self, SEL getter) {
     T ret = ((T (*)(id, SEL))objc_msgSend)(self, getter);
@@ -167,13 +278,11 @@ id quickGet<Class>(id self, SEL getter) {
     case encodingChar: \
         *ret = quickGet<type>(self, getter); \
         return true;
-bool KVCGetViaAccessor(NSObject* self, SEL getter, id* ret) {
+static bool _KVCGetViaAccessor(NSObject* self, SEL getter, NSMethodSignature* sig, id* ret) {
     if (!getter) {
         return false;
     }
 
-    NSMethodSignature* sig = [self methodSignatureForSelector:getter];
-
     const char* valueType = [sig methodReturnType];
     // We can't box or unbox char* or arbitrary pointers.
     if (valueType[0] == '*' || valueType[0] == '^' || valueType[0] == '?' || valueType[0] == ':') {
@@ -214,6 +323,10 @@ bool KVCGetViaAccessor(NSObject* self, SEL getter, id* ret) {
     return true;
 }
 
+bool KVCGetViaAccessor(NSObject* self, SEL getter, id* ret) {
+    return getter && _KVCGetViaAccessor(self, getter, [self methodSignatureForSelector:getter], ret);
+}
+
 bool KVCGetViaIvar(id self, struct objc_ivar* ivar, id* ret) {
     if (!ivar) {
         return false;
@@ -231,7 +344,7 @@ bool KVCGetViaIvar(id self, struct objc_ivar* ivar, id* ret) {
     return true;
 }
 
-static bool tryGetArrayAdapter(id self, const char* key, id* ret) {
+static bool _KVCResolveArrayAdapter(id self, const char* key) {
     auto countSelectorString(woc::string::format("countOf%c%s", toupper(key[0]), &key[1]));
     auto objectInAtSelectorString(woc::string::format("objectIn%c%sAtIndex:", toupper(key[0]), &key[1]));
     auto objectsAtSelectorString(woc::string::format("%sAtIndexes:", key));
@@ -247,10 +360,63 @@ static bool tryGetArrayAdapter(id self, const char* key, id* ret) {
         return false;
     }
 
-    *ret = [_NSKeyProxyArray proxyArrayForObject:self key:[NSString stringWithUTF8String:key] ivar:nullptr];
     return true;
 }
 
+// Classes that answer respondsToSelector: or methodSignatureForSelector: themselves may answer differently per instance, so
+// their keys are resolved on every call instead of being cached.
+static bool _KVCCanCacheKeysOfClass(Class cls) {
+    static IMP respondsToSelectorImp = class_getMethodImplementation([NSObject class], @selector(respondsToSelector:));
+    static IMP methodSignatureImp = class_getMethodImplementation([NSObject class], @selector(methodSignatureForSelector:));
+    return class_getMethodImplementation(cls, @selector(respondsToSelector:)) == respondsToSelectorImp &&
+           class_getMethodImplementation(cls, @selector(methodSignatureForSelector:)) == methodSignatureImp;
+}
+
+static std::shared_ptr<const KVCKeyInfo> _KVCKeyInfoForKey(NSObject* self, const char* key) {
+    Class cls = object_getClass(self);
+    const bool cacheable = _KVCCanCacheKeysOfClass(cls);
+
+    uint64_t generation = 0;
+    if (cacheable) {
+        if (auto info = _KVCKeyInfoCache().find(cls, key, &generation)) {
+            return info;
+        }
+    }
+
+    //  Resolve outside the cache lock: respondsToSelector: may run +resolveInstanceMethod:, which can run arbitrary code
+    auto info = std::make_shared<KVCKeyInfo>();
+    info->getter = _KVCResolveGetter(self, key);
+    if (info->getter) {
+        info->getterSignature = [self methodSignatureForSelector:info->getter];
+    }
+
+    info->setter = _KVCResolveSetter(self, key);
+    if (info->setter) {
+        info->setterSignature = [self methodSignatureForSelector:info->setter];
+    }
+
+    info->hasArrayAdapter = _KVCResolveArrayAdapter(self, key);
+    info->ivar = _KVCResolveIvar(cls, key);
+
+    if (!cacheable) {
+        return info;
+    }
+
+    return _KVCKeyInfoCache().insert(cls, key, generation, std::move(info));
+}
+
+struct objc_ivar* KVCIvarForPropertyName(NSObject* self, const char* propName) {
+    return _KVCKeyInfoForKey(self, propName)->ivar;
+}
+
+SEL KVCGetterForPropertyName(NSObject* self, const char* key) {
+    return _KVCKeyInfoForKey(self, key)->getter;
+}
+
+SEL KVCSetterForPropertyName(NSObject* self, const char* key) {
+    return _KVCKeyInfoForKey(self, key)->setter;
+}
+
 /**
  @Status Caveat
  @Notes Does not support aggregate functions.
@@ -289,20 +455,18 @@ static bool tryGetArrayAdapter(id self, const char* key, id* ret) {
         return [self valueForUndefinedKey:key];
     }
 
-    const char* rawKey = [key UTF8String];
-    auto accessor = KVCGetterForPropertyName(self, rawKey);
+    auto info = _KVCKeyInfoForKey(self, [key UTF8String]);
     id ret = nil;
-    if (KVCGetViaAccessor(self, accessor, &ret)) {
+    if (_KVCGetViaAccessor(self, info->getter, info->getterSignature, &ret)) {
         return ret;
     }
 
-    if (tryGetArrayAdapter(self, rawKey, &ret)) {
-        return ret;
+    if (info->hasArrayAdapter) {
+        return [_NSKeyProxyArray proxyArrayForObject:self key:key ivar:nullptr];
     }
     // TODO: Add NSMutableSet adapter and its support machinery.
 
-    auto ivar = KVCIvarForPropertyName(self, rawKey);
-    if (ivar && KVCGetViaIvar(self, ivar, &ret)) {
+    if (info->ivar && KVCGetViaIvar(self, info->ivar, &ret)) {
         return ret;
     }
 
@@ -318,11 +482,7 @@ static bool tryGetArrayAdapter(id self, const char* key, id* ret) {
         return [self valueForUndefinedKey:key];
     }
 
-    const char* rawKey = [key UTF8String];
-
-    auto accessor = KVCGetterForPropertyName(self, rawKey);
-    struct objc_ivar* ivar = KVCIvarForPropertyName(self, rawKey);
-
+    struct objc_ivar* ivar = KVCIvarForPropertyName(self, [key UTF8String]);
     return [_NSMutableKeyProxyArray proxyArrayForObject:self key:key ivar:ivar];
 }
 
@@ -351,29 +511,6 @@ static bool tryGetArrayAdapter(id self, const char* key, id* ret) {
     return nil;
 }
 
-SEL KVCSetterForPropertyName(NSObject* self, const char* key) {
-    SEL sel = nullptr;
-    auto len = strlen(key);
-    // For the key "example", we must construct the following buffer:
-    // _ _ _ _ x a m p l e _ \0
-    // and fill it with the following characters:
-    // s e t E x a m p l e : \0
-    char* buf = (char*)_alloca(3 + len + 2);
-    strcpy_s(buf + 4, len, key + 1);
-    buf[0] = 's';
-    buf[1] = 'e';
-    buf[2] = 't';
-    buf[3] = toupper(key[0]);
-    buf[3 + len] = ':';
-    buf[3 + len + 1] = '\0';
-    sel = sel_getUid(buf);
-    if ([self respondsToSelector:sel]) {
-        return sel;
-    }
-
-    return nullptr;
-}
-
 template <typename T>
 static bool quickSet(id self, SEL setter, id value, const char* valueType) {
     uint8_t* data = static_cast<uint8_t*>(_alloca(objc_sizeof_type(valueType)));
@@ -404,13 +541,11 @@ bool quickSet<Class>(id self, SEL setter, id value, const char* valueType) {
             return true; \
         } \
         break;
-bool KVCSetViaAccessor(NSObject* self, SEL setter, id value) {
+static bool _KVCSetViaAccessor(NSObject* self, SEL setter, NSMethodSignature* sig, id value) {
     if (!setter) {
         return false;
     }
 
-    NSMethodSignature* sig = [self methodSignatureForSelector:setter];
-
     // 3 arguments: self, selector, new value.
     if (sig && [sig numberOfArguments] == 3) {
         const char* valueType = [sig getArgumentTypeAtIndex:2];
@@ -436,6 +571,10 @@ bool KVCSetViaAccessor(NSObject* self, SEL setter, id value) {
     return false;
 }
 
+bool KVCSetViaAccessor(NSObject* self, SEL setter, id value) {
+    return setter && _KVCSetViaAccessor(self, setter, [self methodSignatureForSelector:setter], value);
+}
+
 bool KVCSetViaIvar(NSObject* self, struct objc_ivar* ivar, id value) {
     if (!ivar) {
         return false;
@@ -466,12 +605,12 @@ bool KVCSetViaIvar(NSObject* self, struct objc_ivar* ivar, id value) {
         return;
     }
 
-    const char* rawKey = [key UTF8String];
-    if (KVCSetViaAccessor(self, KVCSetterForPropertyName(self, rawKey), val)) {
+    auto info = _KVCKeyInfoForKey(self, [key UTF8String]);
+    if (_KVCSetViaAccessor(self, info->setter, info->setterSignature, val)) {
         return;
     }
 
-    auto ivar = KVCIvarForPropertyName(self, rawKey);
+    auto ivar = info->ivar;
     if (ivar) {
         BOOL shouldNotify = [[self class] automaticallyNotifiesObserversForKey:key];
 
@@ -23,8 +23,16 @@
 #import "NSRaise.h"
 #import "NSCFArray.h"
 #import "BridgeHelpers.h"
+#import <Foundation/NSSortDescriptor.h>
+#import <Starboard/SmartTypes.h>
+#import <dispatch/dispatch.h>
 
 #include <algorithm>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
 
 static const wchar_t* TAG = L"NSMutableArray";
 
@@ -226,54 +234,140 @@ using NSCompareFunc = NSInteger (*)(id, id, void*);
     return NSInvalidAbstractInvocation();
 }
 
-static void swap(NSMutableArray* self, uint32_t a, uint32_t b) {
-    if (a == b)
-        return;
+// Below this many objects per chunk, a concurrent sort runs on the calling thread alone
+static const size_t c_minConcurrentSortChunk = 4096;
 
-    id obj1 = [self objectAtIndex:a];
-    id obj2 = [self objectAtIndex:b];
+namespace {
 
-    [obj1 retain];
-    [obj2 retain];
-    [self replaceObjectAtIndex:b withObject:obj1];
-    [self replaceObjectAtIndex:a withObject:obj2];
-    [obj1 release];
-    [obj2 release];
-}
+// Holds the first exception thrown by the work items of a dispatch_apply, so it can be rethrown on the calling thread
+// instead of escaping a dispatch worker. Once one work item has thrown, the rest are skipped.
+class ConcurrentSortFailure {
+public:
+    template <typename TFunc>
+    void run(const TFunc& func) {
+        if (failed()) {
+            return;
+        }
+
+        try {
+            func();
+        } catch (...) {
+            std::lock_guard<std::mutex> lock(_lock);
+            if (!_exception) {
+                _exception = std::current_exception();
+            }
+        }
+    }
 
-static void shortsort(NSMutableArray* self, uint32_t lo, uint32_t hi, NSCompareFunc compFunc, void* context) {
-    int p, max;
+    bool failed() {
+        std::lock_guard<std::mutex> lock(_lock);
+        return static_cast<bool>(_exception);
+    }
 
-    while (hi > lo) {
-        max = lo;
-        for (p = lo + 1; p <= (int)hi; p += 1) {
-            if ((compFunc([self objectAtIndex:p], [self objectAtIndex:max], context)) > 0)
-                max = p;
+    void rethrowIfFailed() {
+        std::lock_guard<std::mutex> lock(_lock);
+        if (_exception) {
+            std::rethrow_exception(_exception);
         }
+    }
+
+private:
+    std::mutex _lock;
+    std::exception_ptr _exception;
+};
+
+} // namespace
 
-        swap(self, max, hi);
-        hi -= 1;
+// Stable sort of items[0, count). With concurrent set, chunks are sorted across the global dispatch queue and then merged
+// pairwise, a level at a time, through a single scratch buffer. If less throws, the exception reaches the caller and items
+// is left in an unspecified order.
+template <typename T, typename TLess>
+static void _sortItems(T* items, size_t count, bool concurrent, const TLess& less) {
+    const size_t chunkCount =
+        concurrent ? std::min<size_t>(std::max(1u, std::thread::hardware_concurrency()), count / c_minConcurrentSortChunk) : 1;
+
+    if (chunkCount < 2) {
+        std::stable_sort(items, items + count, less);
+        return;
+    }
+
+    std::vector<size_t> bounds(chunkCount + 1);
+    for (size_t i = 0; i <= chunkCount; ++i) {
+        bounds[i] = count * i / chunkCount;
+    }
+
+    const TLess* lessPtr = &less;
+    size_t* boundsPtr = bounds.data();
+    ConcurrentSortFailure failure;
+    ConcurrentSortFailure* failurePtr = &failure;
+    dispatch_apply(chunkCount, dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0), ^(size_t chunk) {
+        failurePtr->run([=]() { std::stable_sort(items + boundsPtr[chunk], items + boundsPtr[chunk + 1], *lessPtr); });
+    });
+    failure.rethrowIfFailed();
+
+    std::vector<T> scratch(count);
+    T* source = items;
+    T* destination = scratch.data();
+
+    while (bounds.size() > 2) {
+        const size_t runCount = bounds.size() - 1;
+        boundsPtr = bounds.data();
+
+        //  Merging the left run first keeps equal objects in their original order
+        dispatch_apply((runCount + 1) / 2, dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0), ^(size_t pair) {
+            T* first = source + boundsPtr[pair * 2];
+            T* middle = source + boundsPtr[pair * 2 + 1];
+            T* last = source + boundsPtr[std::min(pair * 2 + 2, runCount)];
+            failurePtr->run([=]() { std::merge(first, middle, middle, last, destination + boundsPtr[pair * 2], *lessPtr); });
+        });
+        failure.rethrowIfFailed();
+
+        std::vector<size_t> merged;
+        for (size_t i = 0; i < bounds.size(); i += 2) {
+            merged.push_back(bounds[i]);
+        }
+        if (merged.back() != count) {
+            merged.push_back(count);
+        }
+
+        bounds.swap(merged);
+        std::swap(source, destination);
     }
-}
 
-static signed int selComp(NSMutableArray* self, int i1, int i2, SEL selector) {
-    typedef int (*ftype)(id, SEL, id);
-    return ((ftype)objc_msgSend)([self objectAtIndex:i1], selector, [self objectAtIndex:i2]);
+    if (source != items) {
+        std::copy(source, source + count, items);
+    }
 }
 
-static void shortsort(NSMutableArray* self, uint32_t lo, uint32_t hi, SEL selector) {
-    DWORD p, max;
+// Replaces the objects in range with the first range.length entries of objects
+static void _storeSortedObjects(NSMutableArray* self, NSRange range, id* objects) {
+    //  Storing an object releases the one it replaces, which may be the array's only reference to an object not yet stored
+    for (NSUInteger i = 0; i < range.length; ++i) {
+        [objects[i] retain];
+    }
+
+    for (NSUInteger i = 0; i < range.length; ++i) {
+        [self replaceObjectAtIndex:range.location + i withObject:objects[i]];
+    }
 
-    while (hi > lo) {
-        max = lo;
-        for (p = lo + 1; p <= hi; p += 1) {
-            if (selComp(self, p, max, selector) > 0)
-                max = p;
-        }
+    for (NSUInteger i = 0; i < range.length; ++i) {
+        [objects[i] release];
+    }
+}
 
-        swap(self, max, hi);
-        hi -= 1;
+// Copies the objects in range out of the array once, sorts them stably and writes them back. Sorting works on the copy, so
+// the array is left untouched if the comparison throws, including on a dispatch worker during a concurrent sort.
+template <typename TLess>
+static void _sortRange(NSMutableArray* self, NSRange range, bool concurrent, const TLess& less) {
+    if (range.length < 2) {
+        return;
     }
+
+    std::vector<id> objects(range.length);
+    [self getObjects:objects.data() range:range];
+
+    _sortItems(objects.data(), objects.size(), concurrent, less);
+    _storeSortedObjects(self, range, objects.data());
 }
 
 /**
@@ -283,8 +377,6 @@ static void shortsort(NSMutableArray* self, uint32_t lo, uint32_t hi, SEL select
     [self sortUsingFunction:CFNSBlockCompare context:comparator];
 }
 
-#define CUTOFF 8
-
 /**
  @Status Interoperable
 */
@@ -298,171 +390,121 @@ static void shortsort(NSMutableArray* self, uint32_t lo, uint32_t hi, SEL select
  @Status Interoperable
 */
 - (void)sortUsingFunction:(NSCompareFunc)compFunc context:(void*)context range:(NSRange)range {
-    uint32_t base = range.location;
-    uint32_t num = range.length;
-
-    uint32_t lo, hi;
-    uint32_t mid;
-    uint32_t loguy, higuy;
-    uint32_t size;
-    uint32_t lostk[30], histk[30];
-    int stkptr;
-
-    if (num < 2)
-        return;
-    stkptr = 0;
+    _sortRange(self, range, false, [compFunc, context](id obj1, id obj2) { return compFunc(obj1, obj2, context) < 0; });
+}
 
-    lo = base;
-    hi = base + (num - 1);
+/**
+ @Status Interoperable
+*/
+- (void)sortUsingSelector:(SEL)selector {
+    typedef NSComparisonResult (*compareImp)(id, SEL, id);
 
-recurse:
-    size = (hi - lo) + 1;
+    _sortRange(self, NSMakeRange(0, [self count]), false, [selector](id obj1, id obj2) {
+        return ((compareImp)objc_msgSend)(obj1, selector, obj2) < 0;
+    });
+}
 
-    if (size <= CUTOFF) {
-        shortsort(self, lo, hi, compFunc, context);
-    } else {
-        mid = lo + (size / 2);
-        swap(self, mid, lo);
+namespace {
 
-        loguy = lo;
-        higuy = hi + 1;
+// A sort descriptor whose key values have been read out of every object up front, so that each comparison costs one compare
+// message instead of two key path lookups. Subclasses of NSSortDescriptor may override compareObject:toObject:, so they
+// are asked directly.
+class CachedSortDescriptor {
+public:
+    CachedSortDescriptor(NSSortDescriptor* descriptor, const std::vector<id>& objects) : _descriptor(descriptor), _objects(objects) {
+        if ([descriptor class] != [NSSortDescriptor class]) {
+            return;
+        }
 
-        for (;;) {
-            do {
-                loguy += 1;
-            } while (loguy <= hi && (compFunc([self objectAtIndex:loguy], [self objectAtIndex:lo], context)) <= 0);
+        _cached = true;
+        _comparator = [descriptor comparator];
+        _selector = [descriptor selector];
+        _ascending = [descriptor ascending];
 
-            do {
-                higuy -= 1;
-            } while (higuy > lo && (compFunc([self objectAtIndex:higuy], [self objectAtIndex:lo], context)) >= 0);
+        NSString* key = [descriptor key];
+        if (key == nil) {
+            return;
+        }
 
-            if (higuy < loguy)
-                break;
-            swap(self, loguy, higuy);
+        _keyValues.reserve(objects.size());
+        @autoreleasepool {
+            for (id object : objects) {
+                _keyValues.emplace_back([object valueForKeyPath:key]);
+            }
         }
+    }
 
-        swap(self, lo, higuy);
+    NSComparisonResult compare(size_t index1, size_t index2) const {
+        if (!_cached) {
+            return [_descriptor compareObject:_objects[index1] toObject:_objects[index2]];
+        }
 
-        if (higuy - 1 - lo >= hi - loguy) {
-            if (lo + 1 < higuy) {
-                lostk[stkptr] = lo;
-                histk[stkptr] = higuy - 1;
-                ++stkptr;
-            }
+        id value1 = _keyValues.empty() ? _objects[index1] : static_cast<id>(_keyValues[index1]);
+        id value2 = _keyValues.empty() ? _objects[index2] : static_cast<id>(_keyValues[index2]);
 
-            if (loguy < hi) {
-                lo = loguy;
-                goto recurse;
-            }
+        NSComparisonResult result;
+        if (_comparator) {
+            result = _comparator(value1, value2);
         } else {
-            if (loguy < hi) {
-                lostk[stkptr] = loguy;
-                histk[stkptr] = hi;
-                ++stkptr;
-            }
-
-            if (lo + 1 < higuy) {
-                hi = higuy - 1;
-                goto recurse;
-            }
+            typedef NSComparisonResult (*compareImp)(id, SEL, id);
+            result = ((compareImp)objc_msgSend)(value1, _selector, value2);
         }
-    }
 
-    --stkptr;
-    if (stkptr >= 0) {
-        lo = lostk[stkptr];
-        hi = histk[stkptr];
-        goto recurse;
+        return _ascending ? result : static_cast<NSComparisonResult>(-result);
     }
-}
+
+private:
+    NSSortDescriptor* _descriptor;
+    const std::vector<id>& _objects;
+    bool _cached = false;
+    std::vector<StrongId<NSObject>> _keyValues;
+    NSComparator _comparator = nil;
+    SEL _selector = nullptr;
+    bool _ascending = true;
+};
+
+} // namespace
 
 /**
  @Status Interoperable
 */
-- (void)sortUsingSelector:(SEL)selector {
-    uint32_t base = 0;
-    uint32_t num = [self count];
-
-    uint32_t lo, hi;
-    uint32_t mid;
-    uint32_t loguy, higuy;
-    unsigned size;
-    uint32_t lostk[30], histk[30];
-    int stkptr;
-
-    if (num < 2)
+- (void)sortUsingDescriptors:(NSArray*)descriptors {
+    const NSUInteger count = [self count];
+    if (count < 2 || [descriptors count] == 0) {
         return;
-    stkptr = 0;
-
-    lo = base;
-    hi = base + (num - 1);
-
-recurse:
-    size = (hi - lo) + 1;
-
-    if (size <= CUTOFF) {
-        shortsort(self, lo, hi, selector);
-    } else {
-        mid = lo + (size / 2);
-        swap(self, mid, lo);
-
-        loguy = lo;
-        higuy = hi + 1;
-
-        for (;;) {
-            do {
-                loguy += 1;
-            } while (loguy <= hi && selComp(self, loguy, lo, selector) <= 0);
-
-            do {
-                higuy -= 1;
-            } while (higuy > lo && selComp(self, higuy, lo, selector) >= 0);
-
-            if (higuy < loguy)
-                break;
-            swap(self, loguy, higuy);
-        }
+    }
 
-        swap(self, lo, higuy);
+    std::vector<id> objects(count);
+    [self getObjects:objects.data() range:NSMakeRange(0, count)];
 
-        if (higuy - 1 - lo >= hi - loguy) {
-            if (lo + 1 < higuy) {
-                lostk[stkptr] = lo;
-                histk[stkptr] = higuy - 1;
-                ++stkptr;
-            }
+    std::vector<std::unique_ptr<CachedSortDescriptor>> cached;
+    for (NSSortDescriptor* descriptor in descriptors) {
+        cached.emplace_back(new CachedSortDescriptor(descriptor, objects));
+    }
 
-            if (loguy < hi) {
-                lo = loguy;
-                goto recurse;
-            }
-        } else {
-            if (loguy < hi) {
-                lostk[stkptr] = loguy;
-                histk[stkptr] = hi;
-                ++stkptr;
-            }
+    //  Sort positions rather than objects so that every descriptor can index its cached key values
+    std::vector<NSUInteger> order(count);
+    for (NSUInteger i = 0; i < count; ++i) {
+        order[i] = i;
+    }
 
-            if (lo + 1 < higuy) {
-                hi = higuy - 1;
-                goto recurse;
+    _sortItems(order.data(), count, false, [&cached](NSUInteger index1, NSUInteger index2) {
+        for (const auto& descriptor : cached) {
+            NSComparisonResult result = descriptor->compare(index1, index2);
+            if (result != NSOrderedSame) {
+                return result == NSOrderedAscending;
             }
         }
-    }
 
-    --stkptr;
-    if (stkptr >= 0) {
-        lo = lostk[stkptr];
-        hi = histk[stkptr];
-        goto recurse;
+        return false;
+    });
+
+    std::vector<id> sorted(count);
+    for (NSUInteger i = 0; i < count; ++i) {
+        sorted[i] = objects[order[i]];
     }
-}
 
-/**
- @Status Interoperable
-*/
-- (void)sortUsingDescriptors:(NSArray*)descriptors {
-    [self sortUsingFunction:CFNSDescriptorCompare context:descriptors];
+    _storeSortedObjects(self, NSMakeRange(0, count), sorted.data());
 }
 
 /**
@@ -558,31 +600,13 @@ recurse:
 
 /**
  @Status Interoperable
- @Notes NSSortConcurrent is ignored, but this is compatible with reference documentation
+ @Notes Every sort is stable. NSSortConcurrent sorts and merges large arrays across the global dispatch queue, so cmptr must
+        be safe to call from several threads at once.
 */
 - (void)sortWithOptions:(NSSortOptions)opts usingComparator:(NSComparator)cmptr {
-    if (opts & NSSortStable) {
-        CFMutableDictionaryRef originalIndices = CFDictionaryCreateMutable(kCFAllocatorDefault, [self count], nullptr, nullptr);
-
-        // Construct a dictionary mapping of objects in the array to their original indices
-        for (int i = 0; i < [self count]; i++) {
-            CFDictionaryAddValue(originalIndices, (const void*)[self objectAtIndex:i], (const void*)i);
-        }
-
-        [self sortUsingFunction:CFNSBlockCompare context:^NSComparisonResult(id obj1, id obj2) {
-            NSComparisonResult result = cmptr(obj1, obj2);
-            if (result != NSOrderedSame) {
-                return result;
-            }
-
-            // If the caller-provided comparator result is NSOrderedSame, ensure stability is enforced by comparing the original object indices.
-            return ((NSUInteger)CFDictionaryGetValue(originalIndices, obj1) > (NSUInteger)CFDictionaryGetValue(originalIndices, obj2)) ?
-                NSOrderedDescending : NSOrderedAscending;
-        }];
-        CFRelease(originalIndices);
-    } else {
-        [self sortUsingFunction:CFNSBlockCompare context:cmptr];
-    }
+    _sortRange(self, NSMakeRange(0, [self count]), (opts & NSSortConcurrent) != 0, [cmptr](id obj1, id obj2) {
+        return cmptr(obj1, obj2) < 0;
+    });
 }
 
 @end
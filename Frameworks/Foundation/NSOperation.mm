@@ -40,6 +40,7 @@ OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
 #import <mutex>
 
 #import "NSOperationInternal.h"
+#import "NSOperationQueueInternal.h"
 
 static wchar_t TAG[] = L"NSOperation";
 
@@ -320,10 +321,18 @@ static const NSString* NSOperationContext = @"context";
  @Status Interoperable
 */
 - (void)waitUntilFinished {
-    std::lock_guard<std::recursive_mutex> lock(_finishLock);
-    while (![self isFinished]) {
-        _finishCondition.wait(_finishLock);
+    if ([self isFinished]) {
+        return;
+    }
+
+    _NSOperationQueueWillBlock();
+    { // _finishLock scope
+        std::lock_guard<std::recursive_mutex> lock(_finishLock);
+        while (![self isFinished]) {
+            _finishCondition.wait(_finishLock);
+        }
     }
+    _NSOperationQueueDidUnblock();
 }
 
 /**
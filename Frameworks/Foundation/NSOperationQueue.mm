@@ -20,199 +20,450 @@ OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
 #import "Starboard.h"
 #import "Foundation/NSOperation.h"
 #import "Foundation/NSMutableArray.h"
-#import "Platform/EbrPlatform.h"
 #import "Foundation/NSString.h"
 #import "Foundation/NSOperationQueue.h"
 #import "Foundation/NSThread.h"
 #import "Foundation/NSAutoreleasePool.h"
-#import "Foundation/NSLock.h"
-#import <time.h>
+#import "Foundation/NSKeyValueObserving.h"
 #import "LoggingNative.h"
 #import "NSOperationInternal.h"
+#import "NSOperationQueueInternal.h"
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <system_error>
+#include <thread>
+#include <unordered_set>
+#include <vector>
 
 static const wchar_t* TAG = L"NSOperationQueue";
 
-typedef void* gpointer;
+static void* _NSOperationQueueReadyContext = &_NSOperationQueueReadyContext;
 
-struct NSAtomicListNode {
-    struct NSAtomicListNode* next;
-    StrongId<NSObject> elt;
-};
-typedef struct NSAtomicListNode* NSAtomicListRef;
+@interface NSOperationQueue ()
+- (void)_runQueuedOperation;
+- (void)_parkOperation:(NSOperation*)op;
+- (void)_observeParkedOperation:(NSOperation*)op;
+@end
 
-struct NSOperationQueuePriv {
-    NSAtomicListRef myQueues[NSOperationQueuePriority_Count];
-    NSAtomicListRef queues[NSOperationQueuePriority_Count];
+namespace {
+
+// Pool threads are shared by every operation queue, so keep enough of them that a few operations blocked waiting on
+// other operations cannot starve the rest, even on machines with few cores.
+static const size_t c_NSOperationMinWorkerCount = 4;
+
+// Worker threads shared by every NSOperationQueue. Each worker owns a deque of queues that have an operation ready to run;
+// it services its own deque in FIFO order and, once that is empty, steals from the far end of the others' deques.
+// Workers are detached and live for the rest of the process.
+//
+// A worker that blocks waiting on other operations is replaced by a spare worker, which only steals, so the operations
+// being waited on can still run. Spare workers exit once they find no work and enough workers are unblocked again.
+class NSOperationWorkerPool {
+public:
+    static NSOperationWorkerPool& shared() {
+        static NSOperationWorkerPool* pool = new NSOperationWorkerPool();
+        return *pool;
+    }
 
-    NSThread* _thread;
-    pthread_mutex_t _threadRunningLock;
+    size_t workerCount() const {
+        return _workerCount;
+    }
 
-    DWORD _maxConcurrentOperationCount;
-    id workAvailable;
-    id suspendedCondition;
-    id allWorkDone;
-    id curOperation;
-    BOOL isSuspended;
+    // Schedules one operation from queue to run; the queue is retained until it has run.
+    void submit(NSOperationQueue* queue) {
+        std::call_once(_startWorkers, [this]() { _start(); });
 
-    id _name;
+        const size_t index = (s_workerIndex < _workerCount) ? s_workerIndex : (_nextInjection++ % _workerCount);
+        {
+            //  Counted before it can be taken, so a worker that takes it never sees the count go below zero
+            std::lock_guard<std::mutex> sleepLock(_sleepLock);
+            ++_pending;
 
-    NSOperationQueuePriv() {
-        memset(this, 0, sizeof(NSOperationQueuePriv));
-        _threadRunningLock = PTHREAD_MUTEX_INITIALIZER;
+            std::lock_guard<std::mutex> lock(_workers[index].lock);
+            _workers[index].tasks.emplace_back([queue retain]);
+        }
+
+        _wake.notify_one();
     }
-};
 
-extern pthread_key_t g_currentDispatchQueue;
+    // Called on any thread before it waits on other operations; starts a spare worker if the caller is a pool worker
+    // and too few workers would be left running.
+    void willBlock() {
+        if (s_workerIndex == SIZE_MAX) {
+            return;
+        }
 
-static inline gpointer CompareExchangePointer(volatile gpointer* dest, gpointer exch, gpointer comp) {
-    return (gpointer)EbrCompareExchange((volatile int*)dest, (long)exch, (long)comp);
-}
+        {
+            std::lock_guard<std::mutex> lock(_sleepLock);
+            ++_blockedCount;
+            if (_threadCount - _blockedCount >= _workerCount) {
+                return;
+            }
 
-NSAtomicListRef NSAtomicListSteal(NSAtomicListRef* listPtr) {
-    NSAtomicListRef ret;
-    do {
-        ret = *listPtr;
-    } while (CompareExchangePointer((void**)listPtr, NULL, ret) != ret);
-    return ret;
-}
+            ++_threadCount;
+        }
 
-void NSAtomicListReverse(NSAtomicListRef* listPtr) {
-    struct NSAtomicListNode* cur = *listPtr;
-    struct NSAtomicListNode* prev = NULL;
-    struct NSAtomicListNode* next = NULL;
+        _startWorker(_workerCount);
+    }
 
-    if (!cur) {
-        return;
+    void didUnblock() {
+        if (s_workerIndex == SIZE_MAX) {
+            return;
+        }
+
+        std::lock_guard<std::mutex> lock(_sleepLock);
+        --_blockedCount;
+        if (_hasSpareWorkers()) {
+            _wake.notify_all();
+        }
+    }
+
+private:
+    struct Worker {
+        std::mutex lock;
+        std::deque<NSOperationQueue*> tasks;
+    };
+
+    NSOperationWorkerPool()
+        : _workerCount(std::max<size_t>(c_NSOperationMinWorkerCount, std::thread::hardware_concurrency())),
+          _workers(new Worker[_workerCount]) {
     }
 
-    do {
-        next = cur->next;
-        cur->next = prev;
+    void _start() {
+        {
+            std::lock_guard<std::mutex> lock(_sleepLock);
+            _threadCount += _workerCount;
+        }
 
-        if (next) {
-            prev = cur;
-            cur = next;
+        for (size_t i = 0; i < _workerCount; ++i) {
+            //  Tasks already sent to a missing worker's deque are stolen by the others
+            _startWorker(i);
         }
-    } while (next);
+    }
 
-    *listPtr = cur;
-}
+    // Workers at index _workerCount and above are spares, which own no deque; the caller has counted the thread
+    void _startWorker(size_t index) {
+        try {
+            std::thread(&NSOperationWorkerPool::_workerMain, this, index).detach();
+        } catch (const std::system_error&) {
+            TraceError(TAG, L"Failed to start operation worker %u", static_cast<unsigned int>(index));
 
-NSObject* NSAtomicListPop(NSAtomicListRef* listPtr) {
-    struct NSAtomicListNode* node = *listPtr;
-    if (!node) {
-        return NULL;
+            std::lock_guard<std::mutex> lock(_sleepLock);
+            --_threadCount;
+        }
     }
 
-    *listPtr = node->next;
+    // invariant: under _sleepLock
+    bool _hasSpareWorkers() const {
+        return _threadCount - _blockedCount > _workerCount;
+    }
 
-    NSObject* elt = [[node->elt retain] autorelease];
-    delete node;
-    return elt;
-}
+    NSOperationQueue* _take(size_t index) {
+        const bool ownsDeque = index < _workerCount;
+        if (ownsDeque) {
+            std::lock_guard<std::mutex> lock(_workers[index].lock);
+            auto& tasks = _workers[index].tasks;
+            if (!tasks.empty()) {
+                NSOperationQueue* queue = tasks.front();
+                tasks.pop_front();
+                return queue;
+            }
+        }
 
-NSObject* NSAtomicListPeek(NSAtomicListRef* listPtr) {
-    struct NSAtomicListNode* node = *listPtr;
-    if (!node) {
-        return NULL;
+        for (size_t i = ownsDeque ? 1 : 0; i < _workerCount; ++i) {
+            Worker& victim = _workers[(index + i) % _workerCount];
+            std::lock_guard<std::mutex> lock(victim.lock);
+            if (!victim.tasks.empty()) {
+                NSOperationQueue* queue = victim.tasks.back();
+                victim.tasks.pop_back();
+                return queue;
+            }
+        }
+
+        return nil;
     }
 
-    return node->elt;
-}
+    void _workerMain(size_t index) {
+        s_workerIndex = index;
+        const bool isSpare = index >= _workerCount;
+
+        for (;;) {
+            NSOperationQueue* queue = _take(index);
+            if (queue == nil) {
+                std::unique_lock<std::mutex> lock(_sleepLock);
+                if (isSpare && _hasSpareWorkers()) {
+                    --_threadCount;
+                    return;
+                }
+
+                _wake.wait(lock, [this, isSpare]() { return (_pending > 0) || (isSpare && _hasSpareWorkers()); });
+                continue;
+            }
+
+            {
+                std::lock_guard<std::mutex> lock(_sleepLock);
+                --_pending;
+            }
+
+            [queue _runQueuedOperation];
+            [queue release];
+        }
+    }
+
+    static thread_local size_t s_workerIndex;
+
+    const size_t _workerCount;
+    std::unique_ptr<Worker[]> _workers;
+    std::once_flag _startWorkers;
+    std::atomic<size_t> _nextInjection{ 0 };
 
-void NSAtomicListInsert(NSAtomicListRef* listPtr, NSObject* elt) {
-    struct NSAtomicListNode* node = new NSAtomicListNode();
-    node->elt = elt;
+    //  Tasks sitting in any deque; workers sleep only when there are none
+    std::mutex _sleepLock;
+    std::condition_variable _wake;
+    size_t _pending = 0;
 
-    do {
-        node->next = *listPtr;
-    } while (CompareExchangePointer((void**)listPtr, node, node->next) != node->next);
+    //  Worker threads alive, spares included, and how many of them are waiting on other operations
+    size_t _threadCount = 0;
+    size_t _blockedCount = 0;
+};
+
+thread_local size_t NSOperationWorkerPool::s_workerIndex = SIZE_MAX;
+
+thread_local NSOperationQueue* s_currentQueue = nil;
+
+} // namespace
+
+void _NSOperationQueueWillBlock() {
+    NSOperationWorkerPool::shared().willBlock();
 }
 
+void _NSOperationQueueDidUnblock() {
+    NSOperationWorkerPool::shared().didUnblock();
+}
+
+struct NSOperationQueuePriv {
+    // Guards everything below. Never held while calling into an operation: NSOperation sends KVO notifications, which
+    // re-enter the queue, while holding its own locks.
+    std::mutex lock;
+    std::condition_variable allWorkDone;
+
+    // Operations ready to start, highest priority first and in FIFO order within a priority
+    std::deque<StrongId<NSOperation>> ready[NSOperationQueuePriority_Count];
+
+    // Operations waiting on dependencies; they move to ready when they post an isReady change
+    std::vector<StrongId<NSOperation>> waiting;
+
+    // Operations this queue observes for isReady; the observation is removed when they are dequeued
+    std::unordered_set<NSOperation*> observed;
+
+    std::vector<StrongId<NSOperation>> running;
+
+    // Operations handed to the worker pool or the main run loop but not yet started
+    size_t scheduled = 0;
+
+    NSInteger maxConcurrentOperationCount = NSOperationQueueDefaultMaxConcurrentOperationCount;
+    bool isSuspended = false;
+
+    // The main queue runs its operations on the main thread, through the main dispatch queue, instead of the worker pool
+    bool isMainQueue = false;
+
+    StrongId<NSString> name;
+
+    size_t readyCount() const {
+        size_t count = 0;
+        for (const auto& list : ready) {
+            count += list.size();
+        }
+
+        return count;
+    }
+
+    bool hasMoreWork() const {
+        return !running.empty() || !waiting.empty() || (readyCount() > 0);
+    }
+};
+
 static id _mainQueue;
 
 @interface NSOperationQueue () {
-    struct NSOperationQueuePriv* priv;
+    std::unique_ptr<NSOperationQueuePriv> priv;
     dispatch_queue_t _completionQueue;
 }
 @end
 
 @implementation NSOperationQueue
-static void ClearList(NSAtomicListRef* listPtr) {
-    for (int i = 0; i < NSOperationQueuePriority_Count; i++) {
-        while (NSAtomicListPop(&listPtr[i])) {
-            ;
-        }
+
+static unsigned QueueIndexForPriority(NSOperationQueuePriority priority) {
+    if (priority < NSOperationQueuePriorityNormal) {
+        return 2;
+    } else if (priority > NSOperationQueuePriorityNormal) {
+        return 0;
     }
+
+    return 1;
+}
+
+// invariant: under priv->lock
+- (size_t)_concurrencyLimit {
+    if (priv->maxConcurrentOperationCount == NSOperationQueueDefaultMaxConcurrentOperationCount) {
+        return NSOperationWorkerPool::shared().workerCount();
+    }
+
+    return static_cast<size_t>(std::max<NSInteger>(0, priv->maxConcurrentOperationCount));
 }
 
-static BOOL RunOperationFromLists(NSAtomicListRef* listPtr, NSAtomicListRef* sourceListPtr, id* curOperation) {
-    StrongId<NSOperation> op = NSAtomicListPop(listPtr);
-    if (op == nil) {
-        *listPtr = NSAtomicListSteal(sourceListPtr);
-        // source lists are in LIFO order, but we want to execute operations in the order they were enqueued
-        // so we reverse the list before we do anything with it
-        NSAtomicListReverse(listPtr);
-        op = NSAtomicListPop(listPtr);
+// invariant: under priv->lock
+// Schedules one run for each ready operation that may start without exceeding the concurrency limit.
+- (void)_scheduleWork {
+    if (priv->isSuspended) {
+        return;
     }
 
-    if (op != nil) {
-        if ([op isReady]) {
-            *curOperation = op;
-            [op start];
-            *curOperation = nil;
+    const size_t limit = [self _concurrencyLimit];
+    const size_t readyCount = priv->readyCount();
+    while ((priv->scheduled < readyCount) && (priv->running.size() + priv->scheduled < limit)) {
+        ++priv->scheduled;
+        if (priv->isMainQueue) {
+            dispatch_async(dispatch_get_main_queue(), ^{
+                [self _runQueuedOperation];
+            });
         } else {
-            NSAtomicListInsert(sourceListPtr, op);
-            // We claim that we have done some work here.
-            // Otherwise, this work session is considered to be over and we clear the pending queue.
-            return TRUE;
+            NSOperationWorkerPool::shared().submit(self);
+        }
+    }
+}
+
+// invariant: under priv->lock
+- (StrongId<NSOperation>)_dequeueOperation {
+    for (auto& list : priv->ready) {
+        if (!list.empty()) {
+            StrongId<NSOperation> op = std::move(list.front());
+            list.pop_front();
+            return op;
         }
     }
 
-    return op != nil;
+    return nil;
 }
 
-- (id)_workThread {
-    BOOL stop = FALSE;
+- (void)_runOperation:(StrongId<NSOperation>)op wasObserved:(bool)wasObserved {
+    if (wasObserved) {
+        [op removeObserver:self forKeyPath:@"isReady" context:_NSOperationQueueReadyContext];
+    }
 
-    while (!stop) {
-        [self _doMainWork];
-        pthread_mutex_lock(&priv->_threadRunningLock);
-        if (![self hasMoreWork]) {
-            stop = TRUE;
-            priv->_thread = nil;
+    //  A dependency added since the operation was queued sends it back to wait
+    //  It moves from running to waiting in one step, so the queue never looks empty in between
+    if (![op isReady]) {
+        {
+            std::lock_guard<std::mutex> lock(priv->lock);
+            priv->running.erase(std::find(priv->running.begin(), priv->running.end(), op));
+            [self _parkOperation:op];
+            [self _scheduleWork];
         }
-        pthread_mutex_unlock(&priv->_threadRunningLock);
+
+        [self _observeParkedOperation:op];
+        return;
     }
-    [priv->allWorkDone signal];
 
-    return self;
+    NSOperationQueue* previousQueue = s_currentQueue;
+    s_currentQueue = self;
+    NSAutoreleasePool* pool = [NSAutoreleasePool new];
+    [op start];
+    [pool release];
+    s_currentQueue = previousQueue;
+
+    std::lock_guard<std::mutex> lock(priv->lock);
+    priv->running.erase(std::find(priv->running.begin(), priv->running.end(), op));
+    [self _scheduleWork];
+    if (!priv->hasMoreWork()) {
+        priv->allWorkDone.notify_all();
+    }
 }
 
-- (NSOperationQueue*)_doMainWork {
-    memset(priv->myQueues, 0, sizeof(priv->myQueues));
+// Runs on a pool worker, or on the main thread for the main queue: starts the highest priority ready operation, unless the
+// queue has since been suspended, emptied by another thread, or had its concurrency limit lowered.
+- (void)_runQueuedOperation {
+    StrongId<NSOperation> op;
+    bool wasObserved = false;
+    {
+        std::lock_guard<std::mutex> lock(priv->lock);
+        --priv->scheduled;
+        if (priv->isSuspended || (priv->running.size() >= [self _concurrencyLimit])) {
+            return;
+        }
 
-    BOOL didWork;
+        op = [self _dequeueOperation];
+        if (op == nil) {
+            return;
+        }
 
-    id innerPool = [[NSAutoreleasePool alloc] init];
+        priv->running.emplace_back(op);
+        wasObserved = priv->observed.erase(op) != 0;
+    }
 
-    do {
-        didWork = FALSE;
+    [self _runOperation:op wasObserved:wasObserved];
+}
 
-        for (int i = 0; i < NSOperationQueuePriority_Count; i++) {
-            [priv->suspendedCondition lock];
-            while (priv->isSuspended) {
-                [priv->suspendedCondition wait];
+- (void)observeValueForKeyPath:(NSString*)keyPath ofObject:(id)object change:(NSDictionary*)change context:(void*)context {
+    if (context != _NSOperationQueueReadyContext) {
+        [super observeValueForKeyPath:keyPath ofObject:object change:change context:context];
+        return;
+    }
+
+    //  Ask before taking the queue lock: the operation holds its own lock while it notifies us
+    if (![object isReady]) {
+        return;
+    }
+
+    const unsigned priority = QueueIndexForPriority([object queuePriority]);
+    std::lock_guard<std::mutex> lock(priv->lock);
+    auto found = std::find(priv->waiting.begin(), priv->waiting.end(), object);
+    if (found != priv->waiting.end()) {
+        priv->ready[priority].emplace_back(std::move(*found));
+        priv->waiting.erase(found);
+        [self _scheduleWork];
+    }
+}
+
+// invariant: under priv->lock
+// Parks an operation until it becomes ready; the caller observes it with _observeParkedOperation: once the lock is released.
+- (void)_parkOperation:(NSOperation*)op {
+    priv->waiting.emplace_back(op);
+    priv->observed.emplace(op);
+}
+
+// Must not be called under priv->lock. The initial notification covers a dependency that finished between the caller's
+// check and the observer being added.
+- (void)_observeParkedOperation:(NSOperation*)op {
+    [op addObserver:self forKeyPath:@"isReady" options:NSKeyValueObservingOptionInitial context:_NSOperationQueueReadyContext];
+}
+
+- (NSOperationQueue*)_doMainWork {
+    //  Called by the main run loop; runs whatever the main dispatch queue has not yet picked up
+    for (;;) {
+        StrongId<NSOperation> op;
+        bool wasObserved = false;
+        {
+            std::lock_guard<std::mutex> lock(priv->lock);
+            if (priv->isSuspended || (priv->running.size() + priv->scheduled >= [self _concurrencyLimit])) {
+                break;
             }
-            [priv->suspendedCondition unlock];
 
-            if (RunOperationFromLists(&priv->myQueues[i], &priv->queues[i], &priv->curOperation)) {
-                didWork = TRUE;
+            op = [self _dequeueOperation];
+            if (op == nil) {
+                break;
             }
+
+            priv->running.emplace_back(op);
+            wasObserved = priv->observed.erase(op) != 0;
         }
-    } while (didWork);
 
-    [innerPool release];
+        [self _runOperation:op wasObserved:wasObserved];
+    }
 
     return self;
 }
@@ -221,17 +472,8 @@ static BOOL RunOperationFromLists(NSAtomicListRef* listPtr, NSAtomicListRef* sou
  @Status Interoperable
 */
 - (BOOL)hasMoreWork {
-    if (priv->curOperation != nil) {
-        return TRUE;
-    }
-
-    for (int i = 0; i < NSOperationQueuePriority_Count; i++) {
-        if (priv->queues[i] != NULL) {
-            return TRUE;
-        }
-    }
-
-    return FALSE;
+    std::lock_guard<std::mutex> lock(priv->lock);
+    return priv->hasMoreWork();
 }
 
 /**
@@ -239,14 +481,7 @@ static BOOL RunOperationFromLists(NSAtomicListRef* listPtr, NSAtomicListRef* sou
 */
 - (id)init {
     if (self = [super init]) {
-        priv = new NSOperationQueuePriv();
-
-        priv->_maxConcurrentOperationCount = 1;
-        priv->workAvailable = [[NSCondition alloc] init];
-        priv->suspendedCondition = [[NSCondition alloc] init];
-        priv->allWorkDone = [[NSCondition alloc] init];
-        priv->isSuspended = 0;
-
+        priv.reset(new NSOperationQueuePriv());
         _completionQueue = dispatch_queue_create("NSOperation finish queue", nullptr);
     }
 
@@ -254,13 +489,9 @@ static BOOL RunOperationFromLists(NSAtomicListRef* listPtr, NSAtomicListRef* sou
 }
 
 - (id)_initMainThread {
-    priv = new NSOperationQueuePriv();
-
-    priv->_maxConcurrentOperationCount = 1;
-    priv->workAvailable = [[NSCondition alloc] init];
-    priv->suspendedCondition = [[NSCondition alloc] init];
-    priv->allWorkDone = [[NSCondition alloc] init];
-    priv->isSuspended = 0;
+    priv.reset(new NSOperationQueuePriv());
+    priv->maxConcurrentOperationCount = 1;
+    priv->isMainQueue = true;
 
     return self;
 }
@@ -269,35 +500,22 @@ static BOOL RunOperationFromLists(NSAtomicListRef* listPtr, NSAtomicListRef* sou
  @Status Interoperable
 */
 - (void)addOperation:(id)op {
-    /*
-    //  Add any dependencies
-    id dependencies = [op dependencies];
-    int count = [dependencies count];
-    for ( int i = 0; i < count; i ++ ) {
-    id curDep = [dependencies objectAtIndex:i];
-    [self addOperation:curDep];
-    }
-    */
-
     [op _setCompletionQueue:_completionQueue];
 
-    unsigned priority = 1;
-    if ([op queuePriority] < NSOperationQueuePriorityNormal) {
-        priority = 2;
-    } else if ([op queuePriority] > NSOperationQueuePriorityNormal) {
-        priority = 0;
+    const unsigned priority = QueueIndexForPriority([op queuePriority]);
+    if ([op isReady]) {
+        std::lock_guard<std::mutex> lock(priv->lock);
+        priv->ready[priority].emplace_back(op);
+        [self _scheduleWork];
+        return;
     }
 
-    NSAtomicListInsert(&priv->queues[priority], op);
-    [priv->workAvailable signal];
-
-    pthread_mutex_lock(&priv->_threadRunningLock);
-    if (priv->_thread == nil) {
-        priv->_thread = [[NSThread alloc] initWithTarget:self selector:@selector(_workThread) object:nil];
-        [priv->_thread start];
-        [priv->_thread release];
+    {
+        std::lock_guard<std::mutex> lock(priv->lock);
+        [self _parkOperation:op];
     }
-    pthread_mutex_unlock(&priv->_threadRunningLock);
+
+    [self _observeParkedOperation:op];
 }
 
 /**
@@ -326,19 +544,34 @@ static BOOL RunOperationFromLists(NSAtomicListRef* listPtr, NSAtomicListRef* sou
 }
 
 /**
- @Status Stub
+ @Status Interoperable
+ @Notes Operations run on a worker pool shared by all queues and sized to the processor count;
+        NSOperationQueueDefaultMaxConcurrentOperationCount allows one operation per worker.
 */
 - (void)setMaxConcurrentOperationCount:(NSInteger)count {
-    UNIMPLEMENTED();
-    priv->_maxConcurrentOperationCount = count;
+    std::lock_guard<std::mutex> lock(priv->lock);
+    priv->maxConcurrentOperationCount = count;
+    [self _scheduleWork];
 }
 
 /**
- @Status Stub
+ @Status Interoperable
 */
 - (NSInteger)maxConcurrentOperationCount {
-    UNIMPLEMENTED();
-    return priv->_maxConcurrentOperationCount;
+    std::lock_guard<std::mutex> lock(priv->lock);
+    return priv->maxConcurrentOperationCount;
+}
+
+// Running operations first, then queued ones in the order they will start, then those waiting on dependencies
+- (std::vector<StrongId<NSOperation>>)_allOperations {
+    std::lock_guard<std::mutex> lock(priv->lock);
+    std::vector<StrongId<NSOperation>> ret(priv->running);
+    for (const auto& list : priv->ready) {
+        ret.insert(ret.end(), list.begin(), list.end());
+    }
+
+    ret.insert(ret.end(), priv->waiting.begin(), priv->waiting.end());
+    return ret;
 }
 
 /**
@@ -346,32 +579,8 @@ static BOOL RunOperationFromLists(NSAtomicListRef* listPtr, NSAtomicListRef* sou
 */
 - (id)operations {
     id ret = [NSMutableArray array];
-
-    TraceVerbose(TAG, L"Should lock queue for this");
-    id cur = priv->curOperation;
-    if (cur != nil) {
-        [ret addObject:cur];
-    }
-
-    for (int i = 0; i < NSOperationQueuePriority_Count; i++) {
-        if (priv->queues[i] != NULL) {
-            NSAtomicListNode* curNode = priv->queues[i];
-
-            while (curNode != NULL) {
-                id node = curNode->elt;
-                [ret addObject:node];
-                curNode = curNode->next;
-            }
-        }
-        if (priv->myQueues[i] != NULL) {
-            NSAtomicListNode* curNode = priv->myQueues[i];
-
-            while (curNode != NULL) {
-                id node = curNode->elt;
-                [ret addObject:node];
-                curNode = curNode->next;
-            }
-        }
+    for (const auto& op : [self _allOperations]) {
+        [ret addObject:op];
     }
 
     return ret;
@@ -381,64 +590,17 @@ static BOOL RunOperationFromLists(NSAtomicListRef* listPtr, NSAtomicListRef* sou
  @Status Interoperable
 */
 - (unsigned)operationCount {
-    DWORD ret = 0;
-
-    id cur = priv->curOperation;
-    if (cur != nil) {
-        ret++;
-    }
-    for (int i = 0; i < NSOperationQueuePriority_Count; i++) {
-        if (priv->queues[i] != NULL) {
-            NSAtomicListNode* curNode = priv->queues[i];
-
-            while (curNode != NULL) {
-                ret++;
-                curNode = curNode->next;
-            }
-        }
-        if (priv->myQueues[i] != NULL) {
-            NSAtomicListNode* curNode = priv->myQueues[i];
-
-            while (curNode != NULL) {
-                ret++;
-                curNode = curNode->next;
-            }
-        }
-    }
-
-    return ret;
+    std::lock_guard<std::mutex> lock(priv->lock);
+    return static_cast<unsigned>(priv->running.size() + priv->waiting.size() + priv->readyCount());
 }
 
 /**
  @Status Interoperable
 */
 - (void)cancelAllOperations {
-    TraceVerbose(TAG, L"Should lock queue for this");
-
-    id cur = priv->curOperation;
-    if (cur != nil) {
-        [cur cancel];
-    }
-
-    for (int i = 0; i < NSOperationQueuePriority_Count; i++) {
-        if (priv->queues[i] != NULL) {
-            NSAtomicListNode* curNode = priv->queues[i];
-
-            while (curNode != NULL) {
-                id node = curNode->elt;
-                [node cancel];
-                curNode = curNode->next;
-            }
-        }
-        if (priv->myQueues[i] != NULL) {
-            NSAtomicListNode* curNode = priv->myQueues[i];
-
-            while (curNode != NULL) {
-                id node = curNode->elt;
-                [node cancel];
-                curNode = curNode->next;
-            }
-        }
+    //  Cancelling makes waiting operations ready, which re-enters the queue, so cancel outside the lock
+    for (const auto& op : [self _allOperations]) {
+        [op cancel];
     }
 }
 
@@ -446,16 +608,16 @@ static BOOL RunOperationFromLists(NSAtomicListRef* listPtr, NSAtomicListRef* sou
  @Status Interoperable
 */
 - (void)waitUntilAllOperationsAreFinished {
-    BOOL isWorking;
-
-    [priv->workAvailable lock];
-    isWorking = [self hasMoreWork];
+    if (![self hasMoreWork]) {
+        return;
+    }
 
-    if (isWorking) {
-        [priv->allWorkDone wait];
-        isWorking = [self hasMoreWork];
+    _NSOperationQueueWillBlock();
+    {
+        std::unique_lock<std::mutex> lock(priv->lock);
+        priv->allWorkDone.wait(lock, [this]() { return !priv->hasMoreWork(); });
     }
-    [priv->workAvailable unlock];
+    _NSOperationQueueDidUnblock();
 }
 
 /**
@@ -473,23 +635,19 @@ static BOOL RunOperationFromLists(NSAtomicListRef* listPtr, NSAtomicListRef* sou
  @Status Interoperable
 */
 - (BOOL)isSuspended {
-    [priv->suspendedCondition lock];
-    int ret = priv->isSuspended;
-    [priv->suspendedCondition unlock];
-
-    return ret;
+    std::lock_guard<std::mutex> lock(priv->lock);
+    return priv->isSuspended;
 }
 
 /**
  @Status Interoperable
 */
 - (id)resume {
-    [priv->suspendedCondition lock];
+    std::lock_guard<std::mutex> lock(priv->lock);
     if (priv->isSuspended) {
-        priv->isSuspended = FALSE;
-        [priv->suspendedCondition broadcast];
+        priv->isSuspended = false;
+        [self _scheduleWork];
     }
-    [priv->suspendedCondition unlock];
 
     return self;
 }
@@ -498,9 +656,9 @@ static BOOL RunOperationFromLists(NSAtomicListRef* listPtr, NSAtomicListRef* sou
  @Status Interoperable
 */
 - (id)suspend {
-    [priv->suspendedCondition lock];
-    priv->isSuspended = TRUE;
-    [priv->suspendedCondition unlock];
+    //  Operations already running are unaffected; queued ones stay queued until the queue resumes
+    std::lock_guard<std::mutex> lock(priv->lock);
+    priv->isSuspended = true;
 
     return self;
 }
@@ -509,22 +667,22 @@ static BOOL RunOperationFromLists(NSAtomicListRef* listPtr, NSAtomicListRef* sou
  @Status Interoperable
 */
 - (void)setName:(id)name {
-    id oldName = priv->_name;
-    priv->_name = [name copy];
-    [oldName release];
+    std::lock_guard<std::mutex> lock(priv->lock);
+    priv->name.attach([name copy]);
 }
 
 /**
  @Status Interoperable
 */
 - (id)name {
-    if (priv->_name == nil) {
+    std::lock_guard<std::mutex> lock(priv->lock);
+    if (priv->name == nil) {
         char szName[255];
         sprintf_s(szName, sizeof(szName), "NSOperationQueue %08x", (unsigned int)self);
-        priv->_name = [[NSString stringWithCString:szName] retain];
+        priv->name = [NSString stringWithCString:szName];
     }
 
-    return priv->_name;
+    return [[priv->name retain] autorelease];
 }
 
 /**
@@ -542,13 +700,16 @@ static BOOL RunOperationFromLists(NSAtomicListRef* listPtr, NSAtomicListRef* sou
  @Status Interoperable
 */
 - (void)dealloc {
-    [priv->workAvailable release];
-    [priv->suspendedCondition release];
-    [priv->allWorkDone release];
-    pthread_mutex_destroy(&priv->_threadRunningLock);
-    delete priv;
+    //  Pool tasks retain the queue, so nothing is running or scheduled; only operations parked on dependencies remain
+    for (NSOperation* op : priv->observed) {
+        [op removeObserver:self forKeyPath:@"isReady" context:_NSOperationQueueReadyContext];
+    }
+
+    priv.reset();
 
-    dispatch_release(_completionQueue);
+    if (_completionQueue) {
+        dispatch_release(_completionQueue);
+    }
 
     [super dealloc];
 }
@@ -571,13 +732,15 @@ static BOOL RunOperationFromLists(NSAtomicListRef* listPtr, NSAtomicListRef* sou
  @Status Interoperable
 */
 + (id)currentQueue {
+    if (s_currentQueue != nil) {
+        return s_currentQueue;
+    }
+
     if ([NSThread isMainThread]) {
         return [self mainQueue];
     }
 
-    assert(0);
-
-    return self;
+    return nil;
 }
 
 @end
@@ -20,4 +20,9 @@
 
 @interface NSOperationQueue ()
 - (NSOperationQueue*)_doMainWork;
-@end
\ No newline at end of file
+@end
+
+// Bracket a wait on other operations. When the waiting thread is an operation queue worker, the shared worker pool starts
+// another worker in its place, so the operations being waited on can still run.
+void _NSOperationQueueWillBlock();
+void _NSOperationQueueDidUnblock();
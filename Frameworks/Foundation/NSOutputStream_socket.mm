@@ -19,7 +19,6 @@ OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
 #import "NSSSLHandler.h"
 #import "NSOutputStream_socket.h"
 #import "NSSelectInputSource.h"
-#import "NSSelectSet.h"
 #import "NSStreamInternal.h"
 #import "NSRunLoop+Internal.h"
 #import "LoggingNative.h"
@@ -27,18 +26,6 @@ OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
 
 static const wchar_t* TAG = L"NSOutputStream_socket";
 
-static BOOL socketHasSpaceAvailable(id socket) {
-    NSSelectSet* selectSet = [[[NSSelectSet alloc] init] autorelease];
-    NSSelectSet* outputSet;
-
-    [selectSet addObjectForWrite:socket];
-    if ([selectSet waitForSelectWithOutputSet:&outputSet beforeDate:[NSDate date]] == nil) {
-        return [outputSet containsObjectForWrite:socket];
-    }
-
-    return NO;
-}
-
 @implementation NSOutputStream_socket
 - (instancetype)initWithSocket:(NSSocket*)socket streamStatus:(DWORD)status {
     if (self = [super init]) {
@@ -146,11 +133,11 @@ static BOOL socketHasSpaceAvailable(id socket) {
         id sslHandler = [_socket sslHandler];
 
         if (sslHandler == nil) {
-            return socketHasSpaceAvailable(_socket);
+            return [_socket hasSpaceAvailable];
         } else {
             if ([sslHandler writeBytesAvailable] == 0) {
                 return YES;
-            } else if (socketHasSpaceAvailable(_socket)) {
+            } else if ([_socket hasSpaceAvailable]) {
                 [sslHandler transferOneBufferFromSSLToSocket:_socket];
             }
         }
@@ -519,7 +519,7 @@ static void DispatchMainRunLoopWakeup(void* arg) {
     }
 }
 
-- (void)_processMainRunLoop:(int)value {
+- (void)_processMainRunLoop:(int)value sockets:(const SocketWait*)sockets {
     if ([NSThread currentThread] != [NSThread mainThread]) {
         FAIL_FAST_MSG("_processMainRunLoop should only be scheduled on the main UI thread!");
     }
@@ -533,7 +533,7 @@ static void DispatchMainRunLoopWakeup(void* arg) {
     [[NSOperationQueue mainQueue] _doMainWork];
     dispatch_main_queue_callback();
 
-    [state _handleSignaledInput:value];
+    [state _handleSignaledInput:value sockets:sockets];
 
     [pool release];
 }
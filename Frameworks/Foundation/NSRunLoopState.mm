@@ -29,6 +29,10 @@ OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
 #import "LoggingNative.h"
 #import "NSTimerInternal.h"
 
+#include <algorithm>
+#include <unordered_map>
+#include <vector>
+
 static const wchar_t* TAG = L"NSRunLoopState";
 
 int (*g_UIEventMainRunLoopTimedMultipleWaitCallback)(EbrEvent* events,
@@ -123,17 +127,172 @@ bool GetMainDispatchTimerTimeout(double* val) {
     }
 }
 
+namespace {
+
+// The timers of one run loop mode, in a binary min-heap ordered by fire time and then by when each timer was last
+// (re)scheduled, so that timers due at the same moment take turns. A side table maps each timer to its heap slot, making
+// removal and rescheduling O(log N) and the next fire time O(1). The queue does not retain the timers.
+class RunLoopTimerQueue {
+public:
+    struct Entry {
+        CFAbsoluteTime fireTime;
+        NSTimeInterval tolerance;
+        uint64_t sequence;
+        NSTimer* timer;
+    };
+
+    RunLoopTimerQueue() : _nextSequence(0) {
+    }
+
+    RunLoopTimerQueue(const RunLoopTimerQueue&) = delete;
+    RunLoopTimerQueue& operator=(const RunLoopTimerQueue&) = delete;
+
+    bool empty() const {
+        return _heap.empty();
+    }
+
+    const std::vector<Entry>& entries() const {
+        return _heap;
+    }
+
+    bool contains(NSTimer* timer) const {
+        return _positions.find(timer) != _positions.end();
+    }
+
+    // The timer due soonest, or nullptr if there are none
+    const Entry* first() const {
+        return _heap.empty() ? nullptr : &_heap[0];
+    }
+
+    // The latest time the run loop can sleep until without firing any timer later than its tolerance allows. Every other
+    // timer is due no earlier than the smaller child of the root, so only three entries need to be examined.
+    CFAbsoluteTime wakeTime() const {
+        CFAbsoluteTime wakeTime = _heap[0].fireTime + _heap[0].tolerance;
+        for (size_t child = 1; child <= 2 && child < _heap.size(); ++child) {
+            wakeTime = std::min(wakeTime, _heap[child].fireTime);
+        }
+
+        return wakeTime;
+    }
+
+    // Adds or repositions timer
+    void schedule(NSTimer* timer, CFAbsoluteTime fireTime, NSTimeInterval tolerance) {
+        const Entry entry = { fireTime, tolerance, _nextSequence++, timer };
+        auto found = _positions.find(timer);
+        if (found == _positions.end()) {
+            _heap.push_back(entry);
+            _positions[timer] = _heap.size() - 1;
+            _siftUp(_heap.size() - 1);
+        } else {
+            const size_t index = found->second;
+            _heap[index] = entry;
+            _siftDown(_siftUp(index));
+        }
+    }
+
+    bool remove(NSTimer* timer) {
+        auto found = _positions.find(timer);
+        if (found == _positions.end()) {
+            return false;
+        }
+
+        const size_t index = found->second;
+        _positions.erase(found);
+
+        const size_t last = _heap.size() - 1;
+        if (index != last) {
+            _heap[index] = _heap[last];
+            _positions[_heap[index].timer] = index;
+            _heap.pop_back();
+            _siftDown(_siftUp(index));
+        } else {
+            _heap.pop_back();
+        }
+
+        return true;
+    }
+
+private:
+    static bool _isEarlier(const Entry& left, const Entry& right) {
+        return (left.fireTime < right.fireTime) || (left.fireTime == right.fireTime && left.sequence < right.sequence);
+    }
+
+    void _place(size_t index, const Entry& entry) {
+        _heap[index] = entry;
+        _positions[entry.timer] = index;
+    }
+
+    size_t _siftUp(size_t index) {
+        const Entry entry = _heap[index];
+        while (index > 0) {
+            const size_t parent = (index - 1) / 2;
+            if (!_isEarlier(entry, _heap[parent])) {
+                break;
+            }
+
+            _place(index, _heap[parent]);
+            index = parent;
+        }
+
+        _place(index, entry);
+        return index;
+    }
+
+    void _siftDown(size_t index) {
+        const Entry entry = _heap[index];
+        const size_t count = _heap.size();
+        for (;;) {
+            size_t child = 2 * index + 1;
+            if (child >= count) {
+                break;
+            }
+
+            if (child + 1 < count && _isEarlier(_heap[child + 1], _heap[child])) {
+                ++child;
+            }
+
+            if (!_isEarlier(_heap[child], entry)) {
+                break;
+            }
+
+            _place(index, _heap[child]);
+            index = child;
+        }
+
+        _place(index, entry);
+    }
+
+    std::vector<Entry> _heap;
+    std::unordered_map<NSTimer*, size_t> _positions;
+    uint64_t _nextSequence;
+};
+
+} // namespace
+
+struct PolledSocket {
+    NSSelectInputSource* source;
+    SOCKET descriptor;
+};
+
 @interface NSRunLoopState () {
+    RunLoopTimerQueue _timers;
+
+    //  Socket sources, retained, in the order they were added
+    std::vector<NSSelectInputSource*> _waitSocketObjects;
+    bool _waitSocketsChanged;
+
+    //  What the last wait polled. Entry 0 of _pollDescriptors is the wakeup socket and entry i + 1 belongs to _polledSockets[i],
+    //  whose sources are retained. Both stay registered from one wait to the next and are only rebuilt after sources change.
+    std::vector<WSAPOLLFD> _pollDescriptors;
+    std::vector<PolledSocket> _polledSockets;
+    bool _builtWakeupSockets;
+    SOCKET _wakeupSockets[2];
     SocketWait _socks;
-    fd_set _read;
-    fd_set _write;
-    fd_set _error;
 }
 @end
 
 @implementation NSRunLoopState
 - (NSObject*)init {
-    _timers = [NSMutableArray new];
     _observers = [NSMutableArray new];
     _cancelSource = [NSRunLoopSource new];
     [self addInputSource:_cancelSource];
@@ -142,17 +301,20 @@ bool GetMainDispatchTimerTimeout(double* val) {
 }
 
 - (void)dealloc {
-    for (NSTimer* curtimer in _timers) {
-        [curtimer _removedFromMode:self];
+    for (const RunLoopTimerQueue::Entry& entry : _timers.entries()) {
+        [entry.timer _removedFromMode:self];
+        [entry.timer release];
     }
     [_cancelSource release];
     for (int i = 0; i < _numWaitSignals; i++) {
         [_waitSignalObjects[i] release];
     }
-    for (int i = 0; i < _numWaitSockets; i++) {
-        [_waitSocketObjects[i] release];
+    for (NSSelectInputSource* source : _waitSocketObjects) {
+        [source release];
+    }
+    for (const PolledSocket& polled : _polledSockets) {
+        [polled.source release];
     }
-    [_timers release];
 
     if (_builtWakeupSockets) {
         closesocket(_wakeupSockets[0]);
@@ -168,12 +330,16 @@ bool GetMainDispatchTimerTimeout(double* val) {
 }
 
 - (void)addTimer:(NSTimer*)timer {
-    [_timers addObject:timer];
+    if (_timers.contains(timer)) {
+        return;
+    }
+
+    _timers.schedule([timer retain], [timer _fireTime], [timer tolerance]);
     [timer _addedToMode:self];
 }
 
 - (BOOL)containsTimer:(NSTimer*)timer {
-    return [_timers containsObject:timer];
+    return _timers.contains(timer);
 }
 
 - (void)addObserver:(NSTimer*)observer {
@@ -185,8 +351,27 @@ bool GetMainDispatchTimerTimeout(double* val) {
 }
 
 - (void)removeTimer:(NSTimer*)timer {
-    [timer _removedFromMode:self];
-    [_timers removeObject:timer];
+    if (_timers.remove(timer)) {
+        [timer _removedFromMode:self];
+        [timer release];
+    }
+}
+
+- (void)_rescheduleTimer:(NSTimer*)timer {
+    if (_timers.contains(timer)) {
+        _timers.schedule(timer, [timer _fireTime], [timer tolerance]);
+    }
+}
+
+// Drops timers that were invalidated without being removed, as far as the first valid one
+- (void)_removeInvalidTimers {
+    while (const RunLoopTimerQueue::Entry* first = _timers.first()) {
+        if ([first->timer isValid]) {
+            break;
+        }
+
+        [self removeTimer:first->timer];
+    }
 }
 
 - (void)changingIntoMode:(NSString*)mode {
@@ -218,72 +403,42 @@ bool GetMainDispatchTimerTimeout(double* val) {
         return NO;
     }
 
-    NSDate* now = [NSDate date];
-    int i, count = [_timers count];
-    NSTimer* fireTimer = nil;
+    [self _removeInvalidTimers];
 
-    for (i = 0; i < count; i++) {
-        NSTimer* check = [_timers objectAtIndex:i];
-
-        if ([check isValid] && [now compare:[check fireDate]] != -1) {
-            id object = [[_timers objectAtIndex:i] retain];
-            [_timers removeObjectAtIndex:i];
-            [_timers insertObject:object atIndex:[_timers count]];
-            [object release];
-            fireTimer = check;
-            break;
-        }
+    const RunLoopTimerQueue::Entry* first = _timers.first();
+    if (first == nullptr || first->fireTime > CFAbsoluteTimeGetCurrent()) {
+        _starveCount = 0;
+        return NO;
     }
 
-    if (fireTimer != nil) {
-        [fireTimer fire];
-    }
+    NSTimer* fireTimer = [first->timer retain];
 
-    count = [_timers count];
-    while (--count >= 0) {
-        NSTimer* timer = [_timers objectAtIndex:count];
-        if (![timer isValid]) {
-            [timer _removedFromMode:self];
-            [_timers removeObjectAtIndex:count];
-        }
-    }
+    //  Go to the back of the timers due at the same time, in case firing does not move the fire time on
+    _timers.schedule(fireTimer, first->fireTime, first->tolerance);
 
-    if (fireTimer == nil) {
-        _starveCount = 0;
-    } else {
-        _starveCount++;
+    [fireTimer fire];
+    if (![fireTimer isValid]) {
+        [self removeTimer:fireTimer];
     }
 
-    return (fireTimer != nil) ? YES : NO;
+    [fireTimer release];
+
+    _starveCount++;
+    return YES;
 }
 
 - (NSDate*)limitDateForMode:(NSString*)mode {
-    NSDate* limit = nil;
-    int count;
-
-    count = [_timers count];
-    while (--count >= 0) {
-        NSTimer* timer = [_timers objectAtIndex:count];
+    [self _removeInvalidTimers];
 
-        if (![timer isValid]) {
-            [timer _removedFromMode:self];
-            [_timers removeObjectAtIndex:count];
-        } else {
-            if (limit == nil) {
-                limit = [timer fireDate];
-            } else {
-                limit = [limit earlierDate:[timer fireDate]];
-            }
-        }
+    if (!_timers.empty()) {
+        return [NSDate dateWithTimeIntervalSinceReferenceDate:_timers.wakeTime()];
     }
 
-    if (limit == nil) {
-        if (_numWaitSignals > 0 || _numWaitSockets > 0) {
-            limit = [NSDate distantFuture];
-        }
+    if (_numWaitSignals > 0 || !_waitSocketObjects.empty()) {
+        return [NSDate distantFuture];
     }
 
-    return limit;
+    return nil;
 }
 
 - (void)addInputSource:(NSInputSource*)source {
@@ -304,13 +459,13 @@ bool GetMainDispatchTimerTimeout(double* val) {
 
         return;
     } else if ([source isKindOfClass:[NSSelectInputSource class]]) {
-        if (_numWaitSockets >= MAX_WAITSOCKETS) {
-            TraceVerbose(TAG, L"Too many socket sources!  Count=%d", _numWaitSockets);
-            *((char*)0xBAAFF00D) = 0;
+        NSSelectInputSource* socketSource = static_cast<NSSelectInputSource*>(source);
+        if (std::find(_waitSocketObjects.begin(), _waitSocketObjects.end(), socketSource) != _waitSocketObjects.end()) {
+            return;
         }
-        _waitSocketObjects[_numWaitSockets] = [source retain];
-        _waitSockets[_numWaitSockets] = (int)[static_cast<NSSelectInputSource*>(source) descriptor];
-        _numWaitSockets++;
+
+        _waitSocketObjects.push_back([socketSource retain]);
+        _waitSocketsChanged = true;
 
         return;
     } else {
@@ -338,19 +493,12 @@ bool GetMainDispatchTimerTimeout(double* val) {
             TraceWarning(TAG, L"Warning: requested source for removal doesn't exist");
         return;
     } else if ([source isKindOfClass:[NSSelectInputSource class]]) {
-        int idx = NSNotFound;
-        for (int i = 0; i < _numWaitSockets; i++) {
-            if ([source isEqual:_waitSocketObjects[i]]) {
-                idx = i;
-                break;
-            }
-        }
+        auto found = std::find(_waitSocketObjects.begin(), _waitSocketObjects.end(), static_cast<NSSelectInputSource*>(source));
 
-        if (idx != NSNotFound) {
+        if (found != _waitSocketObjects.end()) {
+            _waitSocketObjects.erase(found);
+            _waitSocketsChanged = true;
             [source release];
-            memmove(&_waitSockets[idx], &_waitSockets[idx + 1], (_numWaitSockets - idx - 1) * sizeof(int));
-            memmove(&_waitSocketObjects[idx], &_waitSocketObjects[idx + 1], (_numWaitSockets - idx - 1) * sizeof(id));
-            _numWaitSockets--;
         } else
             TraceWarning(TAG, L"Warning: requested socket for removal doesn't exist");
         return;
@@ -360,61 +508,29 @@ bool GetMainDispatchTimerTimeout(double* val) {
 }
 
 - (void)invalidateTimerWithDelayedPerform:(NSDelayedPerform*)delayed {
-    int count = [_timers count];
-
-    while (--count >= 0) {
-        NSTimer* timer = [_timers objectAtIndex:count];
-        NSObject* check = [timer userInfo];
+    //  Invalidating a timer removes it from the queue, so collect the matches first
+    std::vector<NSTimer*> matches;
+    for (const RunLoopTimerQueue::Entry& entry : _timers.entries()) {
+        NSObject* check = [entry.timer userInfo];
 
         if ([check isKindOfClass:[NSDelayedPerform class]]) {
             if ([static_cast<NSDelayedPerform*>(check) isEqualToPerform:delayed]) {
-                [timer invalidate];
+                matches.push_back([entry.timer retain]);
             }
         }
     }
+
+    for (NSTimer* timer : matches) {
+        [timer invalidate];
+        [timer release];
+    }
 }
 
 - (void)acceptInputForMode:(NSString*)mode beforeDate:(NSDate*)date {
     EbrBlockIfBackground();
 
-    if (_numWaitSockets > 0) {
-        _socks.max = 0;
-        _socks.fdread = (void*)&_read;
-        _socks.fdwrite = (void*)&_write;
-        _socks.fderror = (void*)&_error;
-        FD_ZERO(&_read);
-        FD_ZERO(&_write);
-        FD_ZERO(&_error);
-
-        for (int i = 0; i < _numWaitSockets; i++) {
-            int mask = ((NSSelectInputSource*)_waitSocketObjects[i])->_eventMask;
-            if (mask & NSSelectReadEvent) {
-                FD_SET(_waitSockets[i], &_read);
-                if (_waitSockets[i] > _socks.max)
-                    _socks.max = _waitSockets[i];
-            }
-            if (mask & NSSelectWriteEvent) {
-                FD_SET(_waitSockets[i], &_write);
-                if (_waitSockets[i] > _socks.max)
-                    _socks.max = _waitSockets[i];
-            }
-            if (mask & NSSelectExceptEvent) {
-                FD_SET(_waitSockets[i], &_error);
-                if (_waitSockets[i] > _socks.max)
-                    _socks.max = _waitSockets[i];
-            }
-        }
-
-        if (!_builtWakeupSockets) {
-            dumb_socketpair((SOCKET*)_wakeupSockets, 0);
-            _builtWakeupSockets = true;
-        }
-        _socks.WakeupSocketRead = _wakeupSockets[0];
-        _socks.WakeupSocketWrite = _wakeupSockets[1];
-        FD_SET(_wakeupSockets[0], &_read);
-        if (_wakeupSockets[0] > _socks.max) {
-            _socks.max = _wakeupSockets[0];
-        }
+    if (!_waitSocketObjects.empty()) {
+        [self _preparePollDescriptors];
     }
 
     //  Go through and fire off any sources that are signaled
@@ -455,14 +571,18 @@ bool GetMainDispatchTimerTimeout(double* val) {
     if ([NSThread currentThread] == [NSThread mainThread]) {
         //  If we're on the UI thread, call UIEventTimedMultipleWait, which will yield and schedule
         // the runloop to run again.
-        g_UIEventMainRunLoopTimedMultipleWaitCallback(_waitSignals, _numWaitSignals, timeout, _numWaitSockets > 0 ? &_socks : NULL);
+        g_UIEventMainRunLoopTimedMultipleWaitCallback(_waitSignals, _numWaitSignals, timeout, _waitSocketObjects.empty() ? NULL : &_socks);
     } else {
-        signaled = EbrEventTimedMultipleWait(_waitSignals, _numWaitSignals, timeout, _numWaitSockets > 0 ? &_socks : NULL);
+        signaled = EbrEventTimedMultipleWait(_waitSignals, _numWaitSignals, timeout, _waitSocketObjects.empty() ? NULL : &_socks);
         [self _handleSignaledInput:signaled];
     }
 }
 
 - (void)_handleSignaledInput:(int)signaled {
+    [self _handleSignaledInput:signaled sockets:&_socks];
+}
+
+- (void)_handleSignaledInput:(int)signaled sockets:(const SocketWait*)sockets {
     if (signaled != -1) {
         if (signaled >= _numWaitSignals) {
             TraceWarning(TAG, L"Unable to handle signaled input for nonexistent signal:%d", _numWaitSignals);
@@ -471,33 +591,130 @@ bool GetMainDispatchTimerTimeout(double* val) {
         }
     }
 
-    if (_numWaitSockets > 0 && _socks.result > 0) {
-        for (int i = 0; i < _numWaitSockets; i++) {
-            int mask = ((NSSelectInputSource*)_waitSocketObjects[i])->_eventMask;
-            if (mask & NSSelectReadEvent) {
-                if (FD_ISSET(_waitSockets[i], &_read)) {
-                    [_waitSocketObjects[i] processImmediateEvents:NSSelectReadEvent];
-                }
+    if (sockets != &_socks) {
+        [self _takePollResults:sockets];
+    }
+
+    if (!_polledSockets.empty() && _socks.result > 0) {
+        //  Delegates may add and remove sources, so find everything that is ready before calling any of them
+        std::vector<std::pair<NSSelectInputSource*, NSSelectEventMask>> ready;
+        for (size_t i = 0; i < _polledSockets.size(); i++) {
+            const SHORT revents = _pollDescriptors[i + 1].revents;
+            NSSelectEventMask events = 0;
+            if (revents & (POLLRDNORM | POLLHUP)) {
+                events |= NSSelectReadEvent;
             }
-            if (mask & NSSelectWriteEvent) {
-                if (FD_ISSET(_waitSockets[i], &_write)) {
-                    [_waitSocketObjects[i] processImmediateEvents:NSSelectWriteEvent];
-                }
+            if (revents & POLLWRNORM) {
+                events |= NSSelectWriteEvent;
+            }
+            if (revents & (POLLERR | POLLNVAL)) {
+                events |= NSSelectExceptEvent;
             }
-            if (mask & NSSelectExceptEvent) {
-                if (FD_ISSET(_waitSockets[i], &_error)) {
-                    [_waitSocketObjects[i] processImmediateEvents:NSSelectExceptEvent];
+
+            if (events != 0) {
+                ready.emplace_back([_polledSockets[i].source retain], events);
+            }
+        }
+
+        for (const auto& readySource : ready) {
+            NSSelectInputSource* source = readySource.first;
+            const bool removed = _waitSocketsChanged &&
+                                 std::find(_waitSocketObjects.begin(), _waitSocketObjects.end(), source) == _waitSocketObjects.end();
+
+            if (!removed) {
+                const NSSelectEventMask selectEvents[] = { NSSelectReadEvent, NSSelectWriteEvent, NSSelectExceptEvent };
+                for (NSSelectEventMask selectEvent : selectEvents) {
+                    if (readySource.second & selectEvent) {
+                        [source processImmediateEvents:selectEvent];
+                    }
                 }
             }
+
+            [source release];
         }
     }
 }
 
+// Takes what a wait on a copy of the descriptors found. If the descriptors have been rebuilt since the copy was made, its
+// results are dropped; sockets are polled level-triggered, so the next wait reports them again.
+- (void)_takePollResults:(const SocketWait*)sockets {
+    _socks.result = 0;
+    if (sockets == nullptr || sockets->result <= 0 || static_cast<size_t>(sockets->numDescriptors) != _pollDescriptors.size()) {
+        return;
+    }
+
+    const WSAPOLLFD* polled = static_cast<const WSAPOLLFD*>(sockets->descriptors);
+    for (size_t i = 0; i < _pollDescriptors.size(); i++) {
+        if (polled[i].fd != _pollDescriptors[i].fd) {
+            return;
+        }
+    }
+
+    for (size_t i = 0; i < _pollDescriptors.size(); i++) {
+        _pollDescriptors[i].revents = polled[i].revents;
+    }
+    _socks.result = sockets->result;
+}
+
+// Brings the poll descriptors up to date for the next wait. The descriptor list is only rebuilt after sources have been added or
+// removed; otherwise just the events each source is interested in are refreshed.
+- (void)_preparePollDescriptors {
+    if (!_builtWakeupSockets) {
+        dumb_socketpair(_wakeupSockets, 0);
+        _builtWakeupSockets = true;
+    }
+
+    if (_waitSocketsChanged || _pollDescriptors.empty()) {
+        for (const PolledSocket& polled : _polledSockets) {
+            [polled.source release];
+        }
+
+        _polledSockets.clear();
+        _pollDescriptors.clear();
+        _pollDescriptors.push_back({ _wakeupSockets[0], POLLRDNORM, 0 });
+        for (NSSelectInputSource* source : _waitSocketObjects) {
+            _polledSockets.push_back({ [source retain], static_cast<SOCKET>([source descriptor]) });
+            _pollDescriptors.push_back({ INVALID_SOCKET, 0, 0 });
+        }
+
+        _waitSocketsChanged = false;
+    }
+
+    _pollDescriptors[0].revents = 0;
+    for (size_t i = 0; i < _polledSockets.size(); i++) {
+        const NSSelectEventMask mask = _polledSockets[i].source->_eventMask;
+        WSAPOLLFD& descriptor = _pollDescriptors[i + 1];
+
+        //  Errors and hangups are reported whatever is asked for, so sockets nobody is listening to are left out altogether
+        descriptor.fd = (mask != 0) ? _polledSockets[i].descriptor : INVALID_SOCKET;
+        descriptor.events = ((mask & NSSelectReadEvent) ? POLLRDNORM : 0) | ((mask & NSSelectWriteEvent) ? POLLWRNORM : 0);
+        descriptor.revents = 0;
+    }
+
+    _socks.WakeupSocketRead = static_cast<int>(_wakeupSockets[0]);
+    _socks.WakeupSocketWrite = static_cast<int>(_wakeupSockets[1]);
+    _socks.descriptors = _pollDescriptors.data();
+    _socks.numDescriptors = static_cast<int>(_pollDescriptors.size());
+    _socks.result = 0;
+}
+
 - (NSString*)description {
-    return [NSString stringWithFormat:@"%@, %i inputSources %i sockets", [super description], _numWaitSignals, _numWaitSockets];
+    return [NSString stringWithFormat:@"%@, %i inputSources %i sockets",
+                                      [super description],
+                                      _numWaitSignals,
+                                      static_cast<int>(_waitSocketObjects.size())];
 }
 
 + (void)setUIThreadMainRunLoopWaitFunction:(int (*)(EbrEvent* events, int numEvents, double timeout, SocketWait* sockets))callback {
     g_UIEventMainRunLoopTimedMultipleWaitCallback = callback;
 }
 @end
+
+SocketWait* _NSRunLoopCopySocketWait(const SocketWait* sockets) {
+    const size_t descriptorsSize = sizeof(WSAPOLLFD) * sockets->numDescriptors;
+    SocketWait* copy = static_cast<SocketWait*>(IwMalloc(sizeof(SocketWait) + descriptorsSize));
+    *copy = *sockets;
+    copy->descriptors = copy + 1;
+    memcpy(copy->descriptors, sockets->descriptors, descriptorsSize);
+    return copy;
+}
@@ -13,17 +13,8 @@ WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEM
 COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
 OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE. */
 
-#ifdef WIN32
-#include <WinSock.h>
-#elif defined(WINPHONE) || defined(__OBJC__)
 #include <winsock2.h>
 #undef WIN32
-#else
-#include <sys/socket.h>
-#include <sys/select.h>
-#endif
-
-#include <errno.h>
 
 #include "Starboard.h"
 #include "NSSelectSet.h"
@@ -31,99 +22,48 @@ OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
 #include "NSSocket.h"
 #include "LoggingNative.h"
 
-static const wchar_t* TAG = L"NSSelectSet";
-
-@implementation NSSelectSet
-typedef struct {
-    int max;
-    fd_set* fdset;
-} native_set;
-
-static native_set* native_set_new(int max) {
-    native_set* result = (native_set*)IwCalloc(1, sizeof(native_set));
-
-    result->max = FD_SETSIZE;
-    result->fdset = (fd_set*)IwCalloc(1, sizeof(fd_set));
-
-    return result;
-}
-
-static void native_set_free(native_set* set) {
-    IwFree(set->fdset);
-    IwFree(set);
-}
-
-static void native_set_clear(native_set* set, int descriptor) {
-    FD_CLR(descriptor, set->fdset);
-}
+#include <unordered_map>
+#include <vector>
 
-static void native_set_set(native_set* set, int descriptor) {
-    FD_SET(descriptor, set->fdset);
-}
-
-static BOOL native_set_is_set(native_set* native, int descriptor) {
-    // if(descriptor>native->max)
-    // return NO;
+static const wchar_t* TAG = L"NSSelectSet";
 
-    return FD_ISSET(descriptor, native->fdset);
-}
+namespace {
 
-static int maxDescriptorInSet(id set) {
-    int result = -1;
-    id state = [set objectEnumerator];
-    id socket;
+// One poll entry per descriptor, however many of the three sets it appears in
+struct PolledObjects {
+    std::vector<WSAPOLLFD> descriptors;
+    std::vector<id> readObjects;
+    std::vector<id> writeObjects;
+    std::vector<id> exceptionObjects;
+    std::unordered_map<SOCKET, size_t> indices;
 
-    while ((socket = [state nextObject]) != nil) {
-        int check = [socket descriptor];
+    size_t indexFor(SOCKET descriptor) {
+        auto found = indices.find(descriptor);
+        if (found != indices.end()) {
+            return found->second;
+        }
 
-        if (check > result)
-            result = check;
+        const size_t index = descriptors.size();
+        descriptors.push_back({ descriptor, 0, 0 });
+        readObjects.push_back(nil);
+        writeObjects.push_back(nil);
+        exceptionObjects.push_back(nil);
+        indices.emplace(descriptor, index);
+        return index;
     }
 
-    return result;
-}
-
-static int maxDescriptorInThreeSets(id set1, id set2, id set3) {
-    int check, result = maxDescriptorInSet(set1);
-
-    check = maxDescriptorInSet(set2);
-    if (check > result)
-        result = check;
-
-    check = maxDescriptorInSet(set3);
-    if (check > result)
-        result = check;
-
-    return result;
-}
-
-static void transferSetToNative(id set, native_set* native) {
-    id state = [set objectEnumerator];
-    id socket;
-
-    while ((socket = [state nextObject]) != nil)
-        native_set_set(native, [socket descriptor]);
-}
-
-static void transferNativeToSetWithOriginals(native_set* sset, id set, id original, id cheater) {
-    unsigned int i;
-
-#if defined(WIN32) || defined(WINPHONE)
-    for (i = 0; i < sset->fdset->fd_count; i++) {
-        if (native_set_is_set(sset, sset->fdset->fd_array[i])) {
-            [cheater setDescriptor:sset->fdset->fd_array[i]];
-            [set addObject:[original member:cheater]];
-        }
-    }
-#else
-    for (i = 0; i < sset->max; i++) {
-        if (native_set_is_set(sset, i)) {
-            [cheater setDescriptor:i];
-            [set addObject:[original member:cheater]];
+    void add(NSSet* set, SHORT events, std::vector<id>& objects) {
+        for (id object in set) {
+            const size_t index = indexFor(static_cast<SOCKET>([object descriptor]));
+            descriptors[index].events |= events;
+            objects[index] = object;
         }
     }
-#endif
-}
+};
+
+} // namespace
+
+@implementation NSSelectSet
 
 - (id)init {
     _readSet = [NSMutableSet new];
@@ -162,85 +102,53 @@ static void transferNativeToSetWithOriginals(native_set* sset, id set, id origin
 }
 
 - (id)waitForSelectWithOutputSet:(id*)outputSetX beforeDate:(id)beforeDate {
-    id result = nil;
-    id cheater = [NSSocket socketWithDescriptor:-1];
-    int maxDescriptor = maxDescriptorInThreeSets(_readSet, _writeSet, _exceptionSet);
-    native_set* activeRead = native_set_new(maxDescriptor);
-    native_set* activeWrite = native_set_new(maxDescriptor);
-    native_set* activeExcept = native_set_new(maxDescriptor);
-    struct timeval timeval;
-    NSTimeInterval interval = 1.0;
+    //  Exceptional conditions (errors and hangups) are always reported, so sockets only in the exception set ask for nothing
+    PolledObjects polled;
+    polled.add(_readSet, POLLRDNORM, polled.readObjects);
+    polled.add(_writeSet, POLLWRNORM, polled.writeObjects);
+    polled.add(_exceptionSet, 0, polled.exceptionObjects);
+
+    NSSelectSet* outputSet = [[[NSSelectSet alloc] init] autorelease];
+    *outputSetX = outputSet;
+
+    if (polled.descriptors.empty()) {
+        return nil;
+    }
 
     int numFds = 0;
-    while (result == nil && numFds == 0 && interval > 0.0) {
+    do {
         EbrBlockIfBackground();
-        transferSetToNative(_readSet, activeRead);
-        transferSetToNative(_writeSet, activeWrite);
-        transferSetToNative(_exceptionSet, activeExcept);
-
-        interval = [beforeDate timeIntervalSinceNow];
 
-        if (interval > 1000000)
+        NSTimeInterval interval = [beforeDate timeIntervalSinceNow];
+        if (interval > 1000000) {
             interval = 1000000;
-#ifdef ANDRID
-        if (interval < 10000)
-            interval = 0;
-#else
-        if (interval < 0)
+        }
+        if (interval < 0) {
             interval = 0;
-#endif
-
-        timeval.tv_sec = (long)interval;
-        interval -= timeval.tv_sec;
-        timeval.tv_usec = (long)(interval * 1000000);
-
-        if ((numFds = select(maxDescriptor + 1, activeRead->fdset, activeWrite->fdset, activeExcept->fdset, &timeval)) < 0) {
-#if defined(WIN32) || defined(WINPHONE)
-            DWORD err = WSAGetLastError();
-            TraceError(TAG, L"Select error %d", err);
-#else
-            TraceError(TAG, L"Select error %d", errno);
-#endif
-            if (errno == EINTR) {
-                TraceVerbose(TAG, L"Interrupted, restarting");
-                fflush(stdout);
-                numFds = 0;
-                continue;
-            }
-            /*
-            if(errno!=EINTR) {
-            //result=[NSError errorWithDomain:NSPOSIXErrorDomain code:errno userInfo:nil];
-            assert(0);
-            }
-            */
-            assert(0);
         }
 
-        double nextInterval = [beforeDate timeIntervalSinceNow];
-    }
+        numFds = EbrSocketPoll(polled.descriptors.data(), static_cast<int>(polled.descriptors.size()), static_cast<int>(interval * 1000.0));
+        if (numFds == SOCKET_ERROR) {
+            TraceError(TAG, L"Poll error %d", WSAGetLastError());
+            return nil;
+        }
+    } while (numFds == 0 && [beforeDate timeIntervalSinceNow] > 0.0);
+
+    for (size_t i = 0; numFds > 0 && i < polled.descriptors.size(); i++) {
+        const SHORT revents = polled.descriptors[i].revents;
 
-    if (result == nil) {
-        NSSelectSet* outputSet = [[[NSSelectSet alloc] init] autorelease];
-        if (numFds) {
-            /*
-            for(int i=0;i<activeRead->max;i++){
-            if(native_set_is_set(activeRead,i)){
-            TraceVerbose(TAG, L"%d is readable", i);
-            }
-            }
-            */
-            transferNativeToSetWithOriginals(activeRead, outputSet->_readSet, _readSet, cheater);
-            transferNativeToSetWithOriginals(activeWrite, outputSet->_writeSet, _writeSet, cheater);
-            transferNativeToSetWithOriginals(activeExcept, outputSet->_exceptionSet, _exceptionSet, cheater);
+        if (polled.readObjects[i] && (revents & (POLLRDNORM | POLLHUP | POLLERR))) {
+            [outputSet->_readSet addObject:polled.readObjects[i]];
+        }
+        if (polled.writeObjects[i] && (revents & (POLLWRNORM | POLLERR))) {
+            [outputSet->_writeSet addObject:polled.writeObjects[i]];
+        }
+        if (polled.exceptionObjects[i] && (revents & (POLLERR | POLLHUP | POLLNVAL))) {
+            [outputSet->_exceptionSet addObject:polled.exceptionObjects[i]];
         }
-        *outputSetX = outputSet;
     }
 
-    native_set_free(activeRead);
-    native_set_free(activeWrite);
-    native_set_free(activeExcept);
-
-    return result;
+    return nil;
 }
 
 - (BOOL)containsObjectForRead:(id)object {
@@ -28,6 +28,7 @@
 - (int)hash;
 - (BOOL)isEqual:(NSSocket*)other;
 - (BOOL)hasBytesAvailable;
+- (BOOL)hasSpaceAvailable;
 - (BOOL)setSSLProperties:(id)properties;
 - (BOOL)isConnected;
 - (id)initWithDescriptor:(int)descriptor;
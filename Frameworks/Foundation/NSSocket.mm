@@ -324,6 +324,14 @@ static void* connectFunc(void* p) {
     return FALSE;
 }
 
+- (BOOL)hasSpaceAvailable {
+    WSAPOLLFD descriptor = { static_cast<SOCKET>(_descriptor), POLLWRNORM, 0 };
+    if (WSAPoll(&descriptor, 1, 0) > 0) {
+        return (descriptor.revents & POLLWRNORM) != 0;
+    }
+    return FALSE;
+}
+
 - (BOOL)setSSLProperties:(id)properties {
 #ifndef QNX
     if (_sslHandler == nil) {
@@ -34,6 +34,7 @@ static const wchar_t* TAG = L"NSTimer";
     BOOL _timerTargetReleased;
     double _interval;
     double _nextFireTime;
+    double _tolerance;
     SEL _sel;
     NSObject* _userInfo;
     StrongId<NSMutableArray> _addedToModes;
@@ -48,6 +49,7 @@ static const wchar_t* TAG = L"NSTimer";
         _valid = NO;
         [_timerTarget release];
         _timerTargetReleased = YES;
+        [self _removeFromModes];
     }
 }
 
@@ -66,6 +68,27 @@ static const wchar_t* TAG = L"NSTimer";
     [_addedToModes removeObject:runLoopState];
 }
 
+- (NSTimeInterval)_fireTime {
+    return _nextFireTime;
+}
+
+// Leaves every run loop mode now, rather than whenever each mode next looks at the timer
+- (void)_removeFromModes {
+    [self retain];
+    for (int i = [_addedToModes count] - 1; i >= 0; i--) {
+        NSRunLoopState* runLoopState = [_addedToModes objectAtIndex:i];
+        [runLoopState removeTimer:self];
+    }
+    [self release];
+}
+
+// Tells each mode the timer is scheduled in that its fire time or tolerance has changed
+- (void)_rescheduleInModes {
+    for (NSRunLoopState* runLoopState in static_cast<NSMutableArray*>(_addedToModes)) {
+        [runLoopState _rescheduleTimer:self];
+    }
+}
+
 /**
  @Status Interoperable
 */
@@ -112,6 +135,8 @@ static const wchar_t* TAG = L"NSTimer";
                 } else {
                     _nextFireTime = curTime;
                 }
+
+                [self _rescheduleInModes];
             }
 
             if (_sel != NULL) {
@@ -122,6 +147,7 @@ static const wchar_t* TAG = L"NSTimer";
 
             if (!_repeats) {
                 _valid = NO;
+                [self _removeFromModes];
             }
         }
 
@@ -266,6 +292,7 @@ static const wchar_t* TAG = L"NSTimer";
 */
 - (void)setFireDate:(NSDate*)date {
     _nextFireTime = [date timeIntervalSinceReferenceDate];
+    [self _rescheduleInModes];
 }
 
 /**
@@ -275,4 +302,20 @@ static const wchar_t* TAG = L"NSTimer";
     return [NSDate dateWithTimeIntervalSinceReferenceDate:_nextFireTime];
 }
 
+/**
+ @Status Interoperable
+*/
+- (NSTimeInterval)tolerance {
+    return _tolerance;
+}
+
+/**
+ @Status Interoperable
+ @Notes The run loop may delay a timer by up to its tolerance so that it fires together with other timers.
+*/
+- (void)setTolerance:(NSTimeInterval)tolerance {
+    _tolerance = (tolerance > 0.0) ? tolerance : 0.0;
+    [self _rescheduleInModes];
+}
+
 @end
@@ -21,4 +21,7 @@
 @interface NSTimer ()
 - (void)_removedFromMode:(NSRunLoopState*)runLoopState;
 - (void)_addedToMode:(NSRunLoopState*)runLoopState;
+
+// The raw fire time, in seconds since the reference date, whether or not the timer is still valid
+- (NSTimeInterval)_fireTime;
 @end
\ No newline at end of file
@@ -16,6 +16,7 @@
 
 #include "LoggingNative.h"
 #include "LoggingInternal.h"
+#include "TraceRecorder.h"
 
 #include <mutex>
 #include <stdarg.h>
@@ -39,38 +40,77 @@ void(__stdcall* g_pfnLoggingCallback)(wil::FailureInfo const& failure) WI_NOEXCE
 }
 }
 
+// Messages are only formatted for ETW if a session is listening at their level, or for the debugger in debug builds
+static bool _traceHasListener(unsigned char level) {
+#ifdef _DEBUG
+    return true;
+#else
+    return g_isTestHookEnabled || TraceLoggingProviderEnabled(s_traceLoggingProvider, level, 0);
+#endif
+}
+
 void TraceVerbose(const wchar_t* tag, const wchar_t* format, ...) {
+    if (!TraceIsEnabled(WINEVENT_LEVEL_VERBOSE, tag)) {
+        return;
+    }
+
     va_list varArgs;
     va_start(varArgs, format);
-    _V_TRACE_WIDE(WINEVENT_LEVEL_VERBOSE, LABEL_VERBOSE, tag, format, varArgs);
+    if (!_traceRecord(WINEVENT_LEVEL_VERBOSE, tag, format, varArgs) && _traceHasListener(WINEVENT_LEVEL_VERBOSE)) {
+        _V_TRACE_WIDE(WINEVENT_LEVEL_VERBOSE, LABEL_VERBOSE, tag, format, varArgs);
+    }
     va_end(varArgs);
 }
 
 void TraceInfo(const wchar_t* tag, const wchar_t* format, ...) {
+    if (!TraceIsEnabled(WINEVENT_LEVEL_INFO, tag)) {
+        return;
+    }
+
     va_list varArgs;
     va_start(varArgs, format);
-    _V_TRACE_WIDE(WINEVENT_LEVEL_INFO, LABEL_INFO, tag, format, varArgs);
+    if (!_traceRecord(WINEVENT_LEVEL_INFO, tag, format, varArgs) && _traceHasListener(WINEVENT_LEVEL_INFO)) {
+        _V_TRACE_WIDE(WINEVENT_LEVEL_INFO, LABEL_INFO, tag, format, varArgs);
+    }
     va_end(varArgs);
 }
 
 void TraceWarning(const wchar_t* tag, const wchar_t* format, ...) {
+    if (!TraceIsEnabled(WINEVENT_LEVEL_WARNING, tag)) {
+        return;
+    }
+
     va_list varArgs;
     va_start(varArgs, format);
-    _V_TRACE_WIDE(WINEVENT_LEVEL_WARNING, LABEL_WARNING, tag, format, varArgs);
+    if (!_traceRecord(WINEVENT_LEVEL_WARNING, tag, format, varArgs) && _traceHasListener(WINEVENT_LEVEL_WARNING)) {
+        _V_TRACE_WIDE(WINEVENT_LEVEL_WARNING, LABEL_WARNING, tag, format, varArgs);
+    }
     va_end(varArgs);
 }
 
 void TraceError(const wchar_t* tag, const wchar_t* format, ...) {
+    if (!TraceIsEnabled(WINEVENT_LEVEL_ERROR, tag)) {
+        return;
+    }
+
     va_list varArgs;
     va_start(varArgs, format);
-    _V_TRACE_WIDE(WINEVENT_LEVEL_ERROR, LABEL_ERROR, tag, format, varArgs);
+    if (!_traceRecord(WINEVENT_LEVEL_ERROR, tag, format, varArgs) && _traceHasListener(WINEVENT_LEVEL_ERROR)) {
+        _V_TRACE_WIDE(WINEVENT_LEVEL_ERROR, LABEL_ERROR, tag, format, varArgs);
+    }
     va_end(varArgs);
 }
 
 void TraceCritical(const wchar_t* tag, const wchar_t* format, ...) {
+    if (!TraceIsEnabled(WINEVENT_LEVEL_CRITICAL, tag)) {
+        return;
+    }
+
     va_list varArgs;
     va_start(varArgs, format);
-    _V_TRACE_WIDE(WINEVENT_LEVEL_CRITICAL, LABEL_CRITICAL, tag, format, varArgs);
+    if (!_traceRecord(WINEVENT_LEVEL_CRITICAL, tag, format, varArgs) && _traceHasListener(WINEVENT_LEVEL_CRITICAL)) {
+        _V_TRACE_WIDE(WINEVENT_LEVEL_CRITICAL, LABEL_CRITICAL, tag, format, varArgs);
+    }
     va_end(varArgs);
 }
 
@@ -0,0 +1,1252 @@
+//******************************************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+//
+// This code is licensed under the MIT License (MIT).
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+//******************************************************************************
+
+#include "LoggingNative.h"
+#include "TraceRecorder.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <stdio.h>
+#include <string.h>
+#include <string>
+#include <thread>
+#include <vector>
+#include <wchar.h>
+
+// A recording is a header followed by chunks, each a type byte and its fields:
+//
+//     header:   "WOCTRACE", uint32 version, uint8 sizeof(wchar_t), uint8 sizeof(void*), uint16 reserved
+//     format:   uint32 id, uint32 length, length wchar_t code units
+//     tag:      uint32 id, uint32 length, length wchar_t code units
+//     records:  uint32 thread id, uint32 byte count, the thread's records
+//     dropped:  uint32 thread id, uint32 number of records dropped
+//
+// Every format and tag is defined once, before the first records that use it. A record is a RecordHeader followed by its
+// arguments, in the order the format string's conversions consume them: integers (including * widths and precisions),
+// characters and pointers as 64 bits, floating point values as doubles, and strings as a uint32 length (0xFFFFFFFF for
+// NULL) followed by their code units. Messages whose arguments can't be recorded as-is are formatted at once and recorded
+// as a single string.
+
+namespace {
+
+const char c_magic[8] = { 'W', 'O', 'C', 'T', 'R', 'A', 'C', 'E' };
+const uint32_t c_version = 1;
+const size_t c_headerSize = sizeof(c_magic) + sizeof(uint32_t) + 4;
+
+const uint8_t c_chunkFormat = 1;
+const uint8_t c_chunkTag = 2;
+const uint8_t c_chunkRecords = 3;
+const uint8_t c_chunkDropped = 4;
+
+const uint32_t c_noId = 0xFFFFFFFF;
+const uint32_t c_nullString = 0xFFFFFFFF;
+
+const uint8_t c_flagPreformatted = 0x1;
+
+//  Longer messages are formatted at once and truncated to fit
+const size_t c_maxRecordSize = 1024;
+
+//  Preformatted messages longer than this are recorded as empty strings
+const size_t c_maxFormattedLength = 64 * 1024;
+
+const size_t c_defaultBytesPerThread = 256 * 1024;
+
+struct RecordHeader {
+    uint32_t size;
+    uint32_t formatId;
+    uint32_t tagId;
+    uint8_t level;
+    uint8_t flags;
+    uint16_t reserved;
+    uint64_t timestamp;
+};
+
+//  The longest preformatted message a record holds
+const size_t c_maxMessageLength = (c_maxRecordSize - sizeof(RecordHeader) - sizeof(uint32_t)) / sizeof(wchar_t);
+
+enum class ArgKind : uint8_t { None, Signed, Unsigned, Double, Pointer, Count, WideString, NarrowString, WideChar, NarrowChar };
+
+enum class LengthModifier : uint8_t { Default, Char, Short, Long, LongLong, Size, IntMax, PtrDiff, Int32, Int64, LongDouble, Wide };
+
+// A conversion specification of a format string, interpreted as by the Microsoft CRT's wide character printf functions:
+// %s and %c take wide characters, %hs and %hc narrow ones, %S and %C the opposite of %s and %c.
+struct Conversion {
+    size_t start;
+    size_t end;
+    std::string flags;
+    int width;
+    bool widthStar;
+    int precision;
+    bool precisionStar;
+    LengthModifier length;
+    char type;
+    ArgKind kind;
+};
+
+bool parseFormat(const wchar_t* format, size_t length, std::vector<Conversion>& conversions) {
+    for (size_t i = 0; i < length; ++i) {
+        if (format[i] != L'%') {
+            continue;
+        }
+
+        Conversion conversion = { i, 0, std::string(), -1, false, -1, false, LengthModifier::Default, 0, ArgKind::None };
+        if (++i >= length) {
+            return false;
+        }
+
+        if (format[i] == L'%') {
+            conversion.end = i + 1;
+            conversion.type = '%';
+            conversions.emplace_back(conversion);
+            continue;
+        }
+
+        while (i < length && wcschr(L"-+ #0", format[i])) {
+            conversion.flags += static_cast<char>(format[i++]);
+        }
+
+        if (i < length && format[i] == L'*') {
+            conversion.widthStar = true;
+            ++i;
+        } else {
+            for (; i < length && format[i] >= L'0' && format[i] <= L'9'; ++i) {
+                conversion.width = std::max(conversion.width, 0) * 10 + (format[i] - L'0');
+            }
+        }
+
+        if (i < length && format[i] == L'.') {
+            conversion.precision = 0;
+            if (++i < length && format[i] == L'*') {
+                conversion.precisionStar = true;
+                ++i;
+            } else {
+                for (; i < length && format[i] >= L'0' && format[i] <= L'9'; ++i) {
+                    conversion.precision = conversion.precision * 10 + (format[i] - L'0');
+                }
+            }
+        }
+
+        if (i + 2 < length && wcsncmp(format + i, L"I64", 3) == 0) {
+            conversion.length = LengthModifier::Int64;
+            i += 3;
+        } else if (i + 2 < length && wcsncmp(format + i, L"I32", 3) == 0) {
+            conversion.length = LengthModifier::Int32;
+            i += 3;
+        } else if (i + 1 < length && (wcsncmp(format + i, L"hh", 2) == 0 || wcsncmp(format + i, L"ll", 2) == 0)) {
+            conversion.length = format[i] == L'h' ? LengthModifier::Char : LengthModifier::LongLong;
+            i += 2;
+        } else if (i < length) {
+            switch (format[i]) {
+                case L'h':
+                    conversion.length = LengthModifier::Short;
+                    break;
+                case L'l':
+                    conversion.length = LengthModifier::Long;
+                    break;
+                case L'w':
+                    conversion.length = LengthModifier::Wide;
+                    break;
+                case L'L':
+                    conversion.length = LengthModifier::LongDouble;
+                    break;
+                case L'I':
+                case L'z':
+                    conversion.length = LengthModifier::Size;
+                    break;
+                case L'j':
+                    conversion.length = LengthModifier::IntMax;
+                    break;
+                case L't':
+                    conversion.length = LengthModifier::PtrDiff;
+                    break;
+                default:
+                    --i;
+                    break;
+            }
+            ++i;
+        }
+
+        if (i >= length) {
+            return false;
+        }
+
+        const bool narrow = conversion.length == LengthModifier::Short;
+        const bool wide = conversion.length == LengthModifier::Long || conversion.length == LengthModifier::Wide;
+        switch (format[i]) {
+            case L'd':
+            case L'i':
+                conversion.kind = ArgKind::Signed;
+                break;
+            case L'u':
+            case L'o':
+            case L'x':
+            case L'X':
+                conversion.kind = ArgKind::Unsigned;
+                break;
+            case L'f':
+            case L'F':
+            case L'e':
+            case L'E':
+            case L'g':
+            case L'G':
+            case L'a':
+            case L'A':
+                conversion.kind = ArgKind::Double;
+                break;
+            case L'p':
+                conversion.kind = ArgKind::Pointer;
+                break;
+            case L'n':
+                conversion.kind = ArgKind::Count;
+                break;
+            case L's':
+                conversion.kind = narrow ? ArgKind::NarrowString : ArgKind::WideString;
+                break;
+            case L'S':
+                conversion.kind = wide ? ArgKind::WideString : ArgKind::NarrowString;
+                break;
+            case L'c':
+                conversion.kind = narrow ? ArgKind::NarrowChar : ArgKind::WideChar;
+                break;
+            case L'C':
+                conversion.kind = wide ? ArgKind::WideChar : ArgKind::NarrowChar;
+                break;
+            default:
+                return false;
+        }
+
+        conversion.type = static_cast<char>(format[i]);
+        conversion.end = i + 1;
+        conversions.emplace_back(conversion);
+    }
+
+    return true;
+}
+
+int64_t readSigned(LengthModifier length, va_list& args) {
+    switch (length) {
+        case LengthModifier::Char:
+            return static_cast<signed char>(va_arg(args, int));
+        case LengthModifier::Short:
+            return static_cast<short>(va_arg(args, int));
+        case LengthModifier::Long:
+            return va_arg(args, long);
+        case LengthModifier::LongLong:
+        case LengthModifier::Int64:
+            return va_arg(args, long long);
+        case LengthModifier::Size:
+        case LengthModifier::PtrDiff:
+            return va_arg(args, ptrdiff_t);
+        case LengthModifier::IntMax:
+            return va_arg(args, intmax_t);
+        default:
+            return va_arg(args, int);
+    }
+}
+
+uint64_t readUnsigned(LengthModifier length, va_list& args) {
+    switch (length) {
+        case LengthModifier::Char:
+            return static_cast<unsigned char>(va_arg(args, unsigned int));
+        case LengthModifier::Short:
+            return static_cast<unsigned short>(va_arg(args, unsigned int));
+        case LengthModifier::Long:
+            return va_arg(args, unsigned long);
+        case LengthModifier::LongLong:
+        case LengthModifier::Int64:
+            return va_arg(args, unsigned long long);
+        case LengthModifier::Size:
+        case LengthModifier::PtrDiff:
+            return va_arg(args, size_t);
+        case LengthModifier::IntMax:
+            return va_arg(args, uintmax_t);
+        default:
+            return va_arg(args, unsigned int);
+    }
+}
+
+// A string seen by the recorder: a format string and how to record its arguments, or a tag. Strings are given ids in the
+// order they are seen.
+struct TraceString {
+    std::wstring text;
+    uint32_t id;
+    std::atomic<bool> enabled;
+    bool recordable;
+    std::vector<Conversion> conversions;
+};
+
+// Interns traced strings by their text, without locking once a string has been seen. Only the text counts, since a few
+// callers trace strings formatted into reused buffers and the same literal can live at several addresses.
+class TraceStringTable {
+public:
+    static const size_t c_capacity = 8192;
+    static const size_t c_maxStrings = c_capacity * 3 / 4;
+
+    TraceStringTable() {
+        for (std::atomic<TraceString*>& slot : _slots) {
+            slot.store(nullptr, std::memory_order_relaxed);
+        }
+    }
+
+    // Returns nullptr if the table is full
+    TraceString* Intern(const wchar_t* text, bool isFormat) {
+        size_t length;
+        const size_t start = hash(text, length);
+        TraceString* found = find(text, length, start, std::memory_order_acquire);
+        if (found) {
+            return found;
+        }
+
+        std::lock_guard<std::mutex> lock(_lock);
+        found = find(text, length, start, std::memory_order_relaxed);
+        if (found) {
+            return found;
+        }
+
+        if (_strings.size() >= c_maxStrings) {
+            return nullptr;
+        }
+
+        size_t slot = start;
+        while (_slots[slot].load(std::memory_order_relaxed)) {
+            slot = (slot + 1) & (c_capacity - 1);
+        }
+
+        std::unique_ptr<TraceString> string(new TraceString());
+        string->text.assign(text, length);
+        string->id = static_cast<uint32_t>(_strings.size());
+        string->enabled.store(std::find(_disabled.begin(), _disabled.end(), string->text) == _disabled.end(), std::memory_order_relaxed);
+        string->recordable = isFormat && parseFormat(text, length, string->conversions);
+
+        TraceString* added = string.get();
+        _strings.emplace_back(std::move(string));
+        _slots[slot].store(added, std::memory_order_release);
+        return added;
+    }
+
+    std::wstring Text(uint32_t id) {
+        std::lock_guard<std::mutex> lock(_lock);
+        return id < _strings.size() ? _strings[id]->text : std::wstring();
+    }
+
+    void SetEnabled(const wchar_t* text, bool enabled) {
+        std::lock_guard<std::mutex> lock(_lock);
+        _disabled.erase(std::remove(_disabled.begin(), _disabled.end(), text), _disabled.end());
+        if (!enabled) {
+            _disabled.emplace_back(text);
+        }
+
+        for (const std::unique_ptr<TraceString>& string : _strings) {
+            if (string->text == text) {
+                string->enabled.store(enabled, std::memory_order_relaxed);
+            }
+        }
+    }
+
+private:
+
+    // FNV-1a over the string's code units, which also measures it
+    static size_t hash(const wchar_t* text, size_t& length) {
+        uint64_t value = 0xCBF29CE484222325ull;
+        const wchar_t* end = text;
+        for (; *end; ++end) {
+            value = (value ^ static_cast<uint64_t>(*end)) * 0x100000001B3ull;
+        }
+
+        length = end - text;
+        value ^= value >> 33;
+        return static_cast<size_t>(value) & (c_capacity - 1);
+    }
+
+    // Strings are never removed, so a probe can stop at the first empty slot
+    TraceString* find(const wchar_t* text, size_t length, size_t slot, std::memory_order order) {
+        for (size_t probe = 0; probe < c_capacity; ++probe, slot = (slot + 1) & (c_capacity - 1)) {
+            TraceString* string = _slots[slot].load(order);
+            if (!string) {
+                break;
+            }
+            if (string->text.size() == length && wmemcmp(string->text.data(), text, length) == 0) {
+                return string;
+            }
+        }
+
+        return nullptr;
+    }
+
+    std::atomic<TraceString*> _slots[c_capacity];
+    std::mutex _lock;
+    std::vector<std::unique_ptr<TraceString>> _strings;
+    std::vector<std::wstring> _disabled;
+};
+
+TraceStringTable& formats() {
+    static TraceStringTable s_formats;
+    return s_formats;
+}
+
+TraceStringTable& tags() {
+    static TraceStringTable s_tags;
+    return s_tags;
+}
+
+// A single producer, single consumer ring of one thread's records. The thread writes whole records; the flushing thread
+// takes everything written so far. Records that don't fit are dropped and counted rather than waiting on the flush.
+class TraceThreadBuffer {
+public:
+    TraceThreadBuffer(uint32_t threadId, size_t capacity) : threadId(threadId) {
+        Resize(capacity);
+    }
+
+    // Only while nothing is writing or reading
+    void Resize(size_t capacity) {
+        size_t size = 1024;
+        while (size < capacity) {
+            size <<= 1;
+        }
+
+        _data.assign(size, 0);
+        _head.store(0, std::memory_order_relaxed);
+        _tail.store(0, std::memory_order_relaxed);
+    }
+
+    size_t Capacity() const {
+        return _data.size();
+    }
+
+    void Write(const uint8_t* record, size_t size) {
+        const uint64_t head = _head.load(std::memory_order_relaxed);
+        const uint64_t tail = _tail.load(std::memory_order_acquire);
+        if (_data.size() - (head - tail) < size) {
+            _dropped.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+
+        const size_t mask = _data.size() - 1;
+        const size_t offset = static_cast<size_t>(head) & mask;
+        const size_t first = std::min(size, _data.size() - offset);
+        memcpy(&_data[offset], record, first);
+        memcpy(&_data[0], record + first, size - first);
+        _head.store(head + size, std::memory_order_release);
+    }
+
+    void Read(std::vector<uint8_t>& out) {
+        const uint64_t tail = _tail.load(std::memory_order_relaxed);
+        const uint64_t head = _head.load(std::memory_order_acquire);
+        const size_t size = static_cast<size_t>(head - tail);
+
+        const size_t mask = _data.size() - 1;
+        const size_t offset = static_cast<size_t>(tail) & mask;
+        const size_t first = std::min(size, _data.size() - offset);
+        out.insert(out.end(), _data.begin() + offset, _data.begin() + offset + first);
+        out.insert(out.end(), _data.begin(), _data.begin() + (size - first));
+        _tail.store(head, std::memory_order_release);
+    }
+
+    uint32_t TakeDropped() {
+        return _dropped.exchange(0, std::memory_order_relaxed);
+    }
+
+    const uint32_t threadId;
+
+    // Set by the owning thread around each write, so that recording can be stopped without locking every write
+    std::atomic<bool> writing{ false };
+
+    // Set when the owning thread exits, after which the buffer is freed once drained
+    std::atomic<bool> exited{ false };
+
+private:
+    std::vector<uint8_t> _data;
+    std::atomic<uint64_t> _head{ 0 };
+    std::atomic<uint64_t> _tail{ 0 };
+    std::atomic<uint32_t> _dropped{ 0 };
+};
+
+// Checked on every trace call, so kept apart from the rest of the state
+std::atomic<int> s_level{ TraceLevelVerbose };
+std::atomic<bool> s_tagFilterActive{ false };
+std::atomic<bool> s_recording{ false };
+
+struct RecorderState {
+    std::mutex lock;
+    std::vector<std::unique_ptr<TraceThreadBuffer>> buffers;
+    size_t bytesPerThread = c_defaultBytesPerThread;
+    uint32_t nextThreadId = 1;
+
+    TraceRecordingWriter writer = nullptr;
+    void* context = nullptr;
+    std::vector<bool> writtenFormats;
+    std::vector<bool> writtenTags;
+
+    FILE* file = nullptr;
+    std::thread flusher;
+    std::mutex flusherLock;
+    std::condition_variable flusherWake;
+    bool stopFlusher = false;
+};
+
+// Never destroyed: traces, and static destructors that stop recording, may still reach it while the process exits
+RecorderState& state() {
+    static RecorderState* s_state = new RecorderState();
+    return *s_state;
+}
+
+struct ThreadRecorder {
+    TraceThreadBuffer* buffer = nullptr;
+
+    ~ThreadRecorder() {
+        if (buffer) {
+            buffer->exited.store(true, std::memory_order_release);
+        }
+    }
+};
+
+thread_local ThreadRecorder t_recorder;
+
+TraceThreadBuffer* currentThreadBuffer() {
+    if (!t_recorder.buffer) {
+        RecorderState& recorder = state();
+        std::lock_guard<std::mutex> lock(recorder.lock);
+        recorder.buffers.emplace_back(new TraceThreadBuffer(recorder.nextThreadId++, recorder.bytesPerThread));
+        t_recorder.buffer = recorder.buffers.back().get();
+    }
+
+    return t_recorder.buffer;
+}
+
+uint64_t timestamp() {
+    return static_cast<uint64_t>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+class RecordWriter {
+public:
+    explicit RecordWriter(uint8_t* data) : _data(data), _size(sizeof(RecordHeader)) {
+    }
+
+    template <typename T>
+    bool Put(T value) {
+        return Put(&value, sizeof(value));
+    }
+
+    bool Put(const void* data, size_t size) {
+        if (_size + size > c_maxRecordSize) {
+            return false;
+        }
+
+        memcpy(_data + _size, data, size);
+        _size += size;
+        return true;
+    }
+
+    template <typename Char>
+    bool PutString(const Char* string, int precision) {
+        if (!string) {
+            return Put(c_nullString);
+        }
+
+        size_t length = 0;
+        while ((precision < 0 || length < static_cast<size_t>(precision)) && string[length]) {
+            ++length;
+        }
+
+        return Put(static_cast<uint32_t>(length)) && Put(string, length * sizeof(Char));
+    }
+
+    size_t Size() const {
+        return _size;
+    }
+
+    void Reset() {
+        _size = sizeof(RecordHeader);
+    }
+
+private:
+    uint8_t* _data;
+    size_t _size;
+};
+
+bool recordArguments(const TraceString* format, RecordWriter& writer, va_list& args) {
+    for (const Conversion& conversion : format->conversions) {
+        int precision = conversion.precision;
+        if (conversion.widthStar && !writer.Put<int64_t>(va_arg(args, int))) {
+            return false;
+        }
+        if (conversion.precisionStar) {
+            precision = va_arg(args, int);
+            if (!writer.Put<int64_t>(precision)) {
+                return false;
+            }
+        }
+
+        bool written = true;
+        switch (conversion.kind) {
+            case ArgKind::None:
+                break;
+            case ArgKind::Signed:
+                written = writer.Put<int64_t>(readSigned(conversion.length, args));
+                break;
+            case ArgKind::Unsigned:
+                written = writer.Put<uint64_t>(readUnsigned(conversion.length, args));
+                break;
+            case ArgKind::Double:
+                written = writer.Put<double>(conversion.length == LengthModifier::LongDouble ? static_cast<double>(va_arg(args, long double)) :
+                                                                                               va_arg(args, double));
+                break;
+            case ArgKind::Pointer:
+                written = writer.Put<uint64_t>(reinterpret_cast<uintptr_t>(va_arg(args, void*)));
+                break;
+            case ArgKind::Count:
+                va_arg(args, void*);
+                break;
+            case ArgKind::WideChar:
+            case ArgKind::NarrowChar:
+                written = writer.Put<uint64_t>(static_cast<uint32_t>(va_arg(args, int)));
+                break;
+            case ArgKind::WideString:
+                written = writer.PutString(va_arg(args, const wchar_t*), precision);
+                break;
+            case ArgKind::NarrowString:
+                written = writer.PutString(va_arg(args, const char*), precision);
+                break;
+        }
+
+        if (!written) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+void writeChunk(RecorderState& recorder, uint8_t type, uint32_t first, uint32_t second, const void* data, size_t length) {
+    uint8_t header[9];
+    header[0] = type;
+    memcpy(header + 1, &first, sizeof(first));
+    memcpy(header + 5, &second, sizeof(second));
+    recorder.writer(header, sizeof(header), recorder.context);
+    if (length) {
+        recorder.writer(data, length, recorder.context);
+    }
+}
+
+void writeDefinition(RecorderState& recorder, uint8_t type, uint32_t id, std::vector<bool>& written, TraceStringTable& table) {
+    if (id == c_noId || (id < written.size() && written[id])) {
+        return;
+    }
+
+    if (id >= written.size()) {
+        written.resize(id + 1, false);
+    }
+    written[id] = true;
+
+    const std::wstring text = table.Text(id);
+    writeChunk(recorder, type, id, static_cast<uint32_t>(text.size()), text.data(), text.size() * sizeof(wchar_t));
+}
+
+// Called with the recorder's lock held
+void flushLocked(RecorderState& recorder) {
+    std::vector<uint8_t> records;
+    for (auto it = recorder.buffers.begin(); it != recorder.buffers.end();) {
+        TraceThreadBuffer* buffer = it->get();
+        const bool exited = buffer->exited.load(std::memory_order_acquire);
+
+        records.clear();
+        buffer->Read(records);
+        const uint32_t dropped = buffer->TakeDropped();
+
+        if (recorder.writer) {
+            for (size_t offset = 0; offset + sizeof(RecordHeader) <= records.size();) {
+                RecordHeader header;
+                memcpy(&header, &records[offset], sizeof(header));
+                writeDefinition(recorder, c_chunkFormat, header.formatId, recorder.writtenFormats, formats());
+                writeDefinition(recorder, c_chunkTag, header.tagId, recorder.writtenTags, tags());
+                offset += header.size;
+            }
+
+            if (!records.empty()) {
+                writeChunk(recorder, c_chunkRecords, buffer->threadId, static_cast<uint32_t>(records.size()), records.data(), records.size());
+            }
+            if (dropped) {
+                writeChunk(recorder, c_chunkDropped, buffer->threadId, dropped, nullptr, 0);
+            }
+        }
+
+        if (exited) {
+            it = recorder.buffers.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+void writeToFile(const void* data, size_t length, void* context) {
+    fwrite(data, 1, length, static_cast<FILE*>(context));
+}
+
+// Decoding
+
+class Reader {
+public:
+    Reader(const uint8_t* data, size_t length) : _data(data), _length(length), _offset(0) {
+    }
+
+    template <typename T>
+    bool Get(T& value) {
+        if (_length - _offset < sizeof(T)) {
+            return false;
+        }
+
+        memcpy(&value, _data + _offset, sizeof(T));
+        _offset += sizeof(T);
+        return true;
+    }
+
+    bool GetBytes(const uint8_t*& bytes, size_t length) {
+        if (_length - _offset < length) {
+            return false;
+        }
+
+        bytes = _data + _offset;
+        _offset += length;
+        return true;
+    }
+
+    bool AtEnd() const {
+        return _offset == _length;
+    }
+
+    size_t Remaining() const {
+        return _length - _offset;
+    }
+
+private:
+    const uint8_t* _data;
+    size_t _length;
+    size_t _offset;
+};
+
+void appendUtf8(std::string& out, uint32_t codePoint) {
+    if (codePoint < 0x80) {
+        out += static_cast<char>(codePoint);
+    } else if (codePoint < 0x800) {
+        out += static_cast<char>(0xC0 | (codePoint >> 6));
+        out += static_cast<char>(0x80 | (codePoint & 0x3F));
+    } else if (codePoint < 0x10000) {
+        out += static_cast<char>(0xE0 | (codePoint >> 12));
+        out += static_cast<char>(0x80 | ((codePoint >> 6) & 0x3F));
+        out += static_cast<char>(0x80 | (codePoint & 0x3F));
+    } else {
+        out += static_cast<char>(0xF0 | (codePoint >> 18));
+        out += static_cast<char>(0x80 | ((codePoint >> 12) & 0x3F));
+        out += static_cast<char>(0x80 | ((codePoint >> 6) & 0x3F));
+        out += static_cast<char>(0x80 | (codePoint & 0x3F));
+    }
+}
+
+// Code units of the recording machine's wchar_t, UTF-16 or UTF-32, as code points
+std::vector<uint32_t> decodeUnits(const uint8_t* data, size_t count, size_t unitSize) {
+    std::vector<uint32_t> codePoints;
+    codePoints.reserve(count);
+    for (size_t i = 0; i < count; ++i) {
+        uint32_t unit = 0;
+        if (unitSize == 2) {
+            uint16_t value;
+            memcpy(&value, data + i * 2, 2);
+            unit = value;
+            if (unit >= 0xD800 && unit < 0xDC00 && i + 1 < count) {
+                memcpy(&value, data + (i + 1) * 2, 2);
+                if (value >= 0xDC00 && value < 0xE000) {
+                    unit = 0x10000 + ((unit - 0xD800) << 10) + (value - 0xDC00);
+                    ++i;
+                }
+            }
+        } else {
+            memcpy(&unit, data + i * 4, 4);
+        }
+        codePoints.emplace_back(unit);
+    }
+
+    return codePoints;
+}
+
+std::string toUtf8(const std::vector<uint32_t>& codePoints, size_t first, size_t last) {
+    std::string out;
+    for (size_t i = first; i < last; ++i) {
+        appendUtf8(out, codePoints[i]);
+    }
+
+    return out;
+}
+
+struct DecodedFormat {
+    std::vector<uint32_t> text;
+    std::vector<Conversion> conversions;
+    bool recordable;
+};
+
+struct DecodedRecord {
+    uint64_t timestamp;
+    uint32_t threadId;
+    int level;
+    uint32_t tagId;
+    std::string tag;
+    std::string message;
+};
+
+void pad(std::string& out, const std::string& text, size_t characters, const Conversion& conversion, int width) {
+    const size_t padding = width > 0 && static_cast<size_t>(width) > characters ? width - characters : 0;
+    const bool left = conversion.flags.find('-') != std::string::npos;
+    if (!left) {
+        out.append(padding, ' ');
+    }
+    out += text;
+    if (left) {
+        out.append(padding, ' ');
+    }
+}
+
+bool renderString(std::string& out, Reader& reader, bool wide, size_t wcharSize, const Conversion& conversion, int width) {
+    uint32_t length;
+    if (!reader.Get(length)) {
+        return false;
+    }
+    if (length == c_nullString) {
+        pad(out, "(null)", 6, conversion, width);
+        return true;
+    }
+
+    const size_t unitSize = wide ? wcharSize : 1;
+    const uint8_t* bytes;
+    if (!reader.GetBytes(bytes, length * unitSize)) {
+        return false;
+    }
+
+    if (wide) {
+        const std::vector<uint32_t> codePoints = decodeUnits(bytes, length, unitSize);
+        pad(out, toUtf8(codePoints, 0, codePoints.size()), codePoints.size(), conversion, width);
+    } else {
+        pad(out, std::string(reinterpret_cast<const char*>(bytes), length), length, conversion, width);
+    }
+
+    return true;
+}
+
+bool renderMessage(std::string& out, const DecodedFormat& format, Reader& reader, size_t wcharSize, size_t pointerSize) {
+    size_t literal = 0;
+    for (const Conversion& conversion : format.conversions) {
+        out += toUtf8(format.text, literal, conversion.start);
+        literal = conversion.end;
+
+        int width = conversion.width;
+        int precision = conversion.precision;
+        int64_t star;
+        if (conversion.widthStar) {
+            if (!reader.Get(star)) {
+                return false;
+            }
+            width = static_cast<int>(star);
+        }
+        if (conversion.precisionStar) {
+            if (!reader.Get(star)) {
+                return false;
+            }
+            precision = static_cast<int>(star);
+        }
+
+        std::string spec = "%" + conversion.flags;
+        if (width >= 0) {
+            spec += std::to_string(width);
+        }
+        if (precision >= 0) {
+            spec += "." + std::to_string(precision);
+        }
+
+        char buffer[512];
+        switch (conversion.kind) {
+            case ArgKind::None:
+                out += '%';
+                break;
+            case ArgKind::Count:
+                break;
+            case ArgKind::Signed:
+            case ArgKind::Unsigned: {
+                uint64_t value;
+                if (!reader.Get(value)) {
+                    return false;
+                }
+                spec += "ll";
+                spec += conversion.type;
+                if (conversion.kind == ArgKind::Signed) {
+                    snprintf(buffer, sizeof(buffer), spec.c_str(), static_cast<long long>(value));
+                } else {
+                    snprintf(buffer, sizeof(buffer), spec.c_str(), static_cast<unsigned long long>(value));
+                }
+                out += buffer;
+                break;
+            }
+            case ArgKind::Double: {
+                double value;
+                if (!reader.Get(value)) {
+                    return false;
+                }
+                spec += conversion.type;
+                snprintf(buffer, sizeof(buffer), spec.c_str(), value);
+                out += buffer;
+                break;
+            }
+            case ArgKind::Pointer: {
+                //  As the Microsoft CRT prints them: every digit, in upper case
+                uint64_t value;
+                if (!reader.Get(value)) {
+                    return false;
+                }
+                snprintf(buffer, sizeof(buffer), "%0*llX", static_cast<int>(pointerSize * 2), static_cast<unsigned long long>(value));
+                out += buffer;
+                break;
+            }
+            case ArgKind::WideChar:
+            case ArgKind::NarrowChar: {
+                uint64_t value;
+                if (!reader.Get(value)) {
+                    return false;
+                }
+                std::string character;
+                appendUtf8(character, conversion.kind == ArgKind::WideChar ? static_cast<uint32_t>(value) : static_cast<uint8_t>(value));
+                pad(out, character, 1, conversion, width);
+                break;
+            }
+            case ArgKind::WideString:
+            case ArgKind::NarrowString:
+                if (!renderString(out, reader, conversion.kind == ArgKind::WideString, wcharSize, conversion, width)) {
+                    return false;
+                }
+                break;
+        }
+    }
+
+    out += toUtf8(format.text, literal, format.text.size());
+    return true;
+}
+
+// Formats a message whole. vswprintf doesn't say how long a message that doesn't fit would be, and leaves the buffer's
+// contents unspecified, so the buffer grows until the message fits. Returns an empty string for messages that can't be
+// formatted, or that are too long to be worth formatting.
+std::wstring formatMessage(const wchar_t* format, va_list args) {
+    std::vector<wchar_t> buffer(c_maxRecordSize);
+    for (;;) {
+        va_list argsCopy;
+        va_copy(argsCopy, args);
+        const int length = vswprintf(buffer.data(), buffer.size(), format, argsCopy);
+        va_end(argsCopy);
+
+        if (length >= 0) {
+            return std::wstring(buffer.data(), length);
+        }
+        if (buffer.size() >= c_maxFormattedLength) {
+            return std::wstring();
+        }
+
+        buffer.resize(buffer.size() * 2);
+    }
+}
+
+} // namespace
+
+void TraceSetLevel(int level) {
+    s_level.store(level, std::memory_order_relaxed);
+}
+
+void TraceSetTagEnabled(const wchar_t* tag, bool enabled) {
+    tags().SetEnabled(tag, enabled);
+    if (!enabled) {
+        s_tagFilterActive.store(true, std::memory_order_relaxed);
+    }
+}
+
+bool TraceIsEnabled(int level, const wchar_t* tag) {
+    if (level > s_level.load(std::memory_order_relaxed)) {
+        return false;
+    }
+
+    if (tag && s_tagFilterActive.load(std::memory_order_relaxed)) {
+        const TraceString* string = tags().Intern(tag, false);
+        if (string && !string->enabled.load(std::memory_order_relaxed)) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+bool _traceRecord(int level, const wchar_t* tag, const wchar_t* format, va_list args) {
+    if (!s_recording.load(std::memory_order_relaxed)) {
+        return false;
+    }
+
+    TraceThreadBuffer* buffer = currentThreadBuffer();
+    buffer->writing.store(true, std::memory_order_seq_cst);
+    if (!s_recording.load(std::memory_order_seq_cst)) {
+        buffer->writing.store(false, std::memory_order_release);
+        return false;
+    }
+
+    const TraceString* tagString = tag ? tags().Intern(tag, false) : nullptr;
+    const TraceString* formatString = formats().Intern(format, true);
+
+    uint8_t data[c_maxRecordSize];
+    RecordHeader header = { 0, formatString ? formatString->id : c_noId, tagString ? tagString->id : c_noId, static_cast<uint8_t>(level), 0, 0, timestamp() };
+
+    RecordWriter writer(data);
+    bool recorded = false;
+    if (formatString && formatString->recordable) {
+        va_list argsCopy;
+        va_copy(argsCopy, args);
+        recorded = recordArguments(formatString, writer, argsCopy);
+        va_end(argsCopy);
+    }
+
+    if (!recorded) {
+        const std::wstring message = formatMessage(format, args);
+
+        //  Cut to whatever fits in a record
+        header.formatId = c_noId;
+        header.flags = c_flagPreformatted;
+        writer.Reset();
+        writer.PutString(message.c_str(), static_cast<int>(c_maxMessageLength));
+    }
+
+    //  Keep records 8-byte aligned so the consumer's copies stay aligned
+    const size_t size = (writer.Size() + 7) & ~static_cast<size_t>(7);
+    header.size = static_cast<uint32_t>(size);
+    memcpy(data, &header, sizeof(header));
+    buffer->Write(data, size);
+
+    buffer->writing.store(false, std::memory_order_release);
+    return true;
+}
+
+void TraceStartRecording(size_t bytesPerThread, TraceRecordingWriter writer, void* context) {
+    TraceStopRecording();
+
+    RecorderState& recorder = state();
+    std::lock_guard<std::mutex> lock(recorder.lock);
+
+    recorder.bytesPerThread = bytesPerThread ? bytesPerThread : c_defaultBytesPerThread;
+    for (const std::unique_ptr<TraceThreadBuffer>& buffer : recorder.buffers) {
+        buffer->Resize(recorder.bytesPerThread);
+        buffer->TakeDropped();
+    }
+
+    recorder.writer = writer;
+    recorder.context = context;
+    recorder.writtenFormats.clear();
+    recorder.writtenTags.clear();
+
+    if (writer) {
+        uint8_t header[c_headerSize] = {};
+        memcpy(header, c_magic, sizeof(c_magic));
+        memcpy(header + sizeof(c_magic), &c_version, sizeof(c_version));
+        header[sizeof(c_magic) + 4] = static_cast<uint8_t>(sizeof(wchar_t));
+        header[sizeof(c_magic) + 5] = static_cast<uint8_t>(sizeof(void*));
+        writer(header, sizeof(header), context);
+    }
+
+    s_recording.store(true, std::memory_order_seq_cst);
+}
+
+bool TraceStartFileRecording(const char* path, size_t bytesPerThread) {
+    FILE* file = fopen(path, "wb");
+    if (!file) {
+        return false;
+    }
+
+    TraceStartRecording(bytesPerThread, writeToFile, file);
+
+    RecorderState& recorder = state();
+    recorder.file = file;
+    recorder.stopFlusher = false;
+    recorder.flusher = std::thread([&recorder]() {
+        std::unique_lock<std::mutex> lock(recorder.flusherLock);
+        while (!recorder.flusherWake.wait_for(lock, std::chrono::milliseconds(100), [&recorder]() { return recorder.stopFlusher; })) {
+            TraceFlushRecording();
+        }
+    });
+
+    return true;
+}
+
+void TraceFlushRecording() {
+    RecorderState& recorder = state();
+    std::lock_guard<std::mutex> lock(recorder.lock);
+    flushLocked(recorder);
+    if (recorder.file) {
+        fflush(recorder.file);
+    }
+}
+
+void TraceStopRecording() {
+    RecorderState& recorder = state();
+    s_recording.store(false, std::memory_order_seq_cst);
+
+    if (recorder.flusher.joinable()) {
+        {
+            std::lock_guard<std::mutex> lock(recorder.flusherLock);
+            recorder.stopFlusher = true;
+        }
+        recorder.flusherWake.notify_all();
+        recorder.flusher.join();
+    }
+
+    std::lock_guard<std::mutex> lock(recorder.lock);
+    for (const std::unique_ptr<TraceThreadBuffer>& buffer : recorder.buffers) {
+        while (buffer->writing.load(std::memory_order_acquire)) {
+            std::this_thread::yield();
+        }
+    }
+
+    flushLocked(recorder);
+    if (recorder.file) {
+        fclose(recorder.file);
+        recorder.file = nullptr;
+    }
+
+    recorder.writer = nullptr;
+    recorder.context = nullptr;
+}
+
+int64_t TraceDecodeRecording(const void* data, size_t length, TraceDecodedRecordCallback callback, void* context) {
+    Reader reader(static_cast<const uint8_t*>(data), length);
+
+    const uint8_t* header;
+    if (!reader.GetBytes(header, c_headerSize) || memcmp(header, c_magic, sizeof(c_magic)) != 0) {
+        return -1;
+    }
+
+    uint32_t version;
+    memcpy(&version, header + sizeof(c_magic), sizeof(version));
+    const size_t wcharSize = header[sizeof(c_magic) + 4];
+    const size_t pointerSize = header[sizeof(c_magic) + 5];
+    if (version != c_version || (wcharSize != 2 && wcharSize != 4)) {
+        return -1;
+    }
+
+    std::vector<DecodedFormat> decodedFormats;
+    std::vector<std::string> decodedTags;
+    std::vector<DecodedRecord> records;
+
+    while (!reader.AtEnd()) {
+        uint8_t type;
+        uint32_t first;
+        uint32_t second;
+        if (!reader.Get(type) || !reader.Get(first) || !reader.Get(second)) {
+            return -1;
+        }
+
+        switch (type) {
+            case c_chunkFormat:
+            case c_chunkTag: {
+                //  The recorder never hands out more ids than a table holds, so larger ones only come from a damaged file
+                const uint8_t* bytes;
+                if (first >= TraceStringTable::c_maxStrings || second > reader.Remaining() / wcharSize ||
+                    !reader.GetBytes(bytes, second * wcharSize)) {
+                    return -1;
+                }
+
+                std::vector<uint32_t> text = decodeUnits(bytes, second, wcharSize);
+                if (type == c_chunkTag) {
+                    decodedTags.resize(std::max<size_t>(decodedTags.size(), first + 1));
+                    decodedTags[first] = toUtf8(text, 0, text.size());
+                    break;
+                }
+
+                //  The conversions are parsed here as the recorder parsed them, from the format in this machine's wchar_t
+                std::wstring wide(text.begin(), text.end());
+                decodedFormats.resize(std::max<size_t>(decodedFormats.size(), first + 1));
+                DecodedFormat& format = decodedFormats[first];
+                format.text = std::move(text);
+                format.recordable = parseFormat(wide.c_str(), wide.size(), format.conversions);
+                break;
+            }
+
+            case c_chunkRecords: {
+                const uint8_t* bytes;
+                if (!reader.GetBytes(bytes, second)) {
+                    return -1;
+                }
+
+                for (size_t offset = 0; offset < second;) {
+                    RecordHeader recordHeader;
+                    if (second - offset < sizeof(recordHeader)) {
+                        return -1;
+                    }
+                    memcpy(&recordHeader, bytes + offset, sizeof(recordHeader));
+                    if (recordHeader.size < sizeof(recordHeader) || recordHeader.size > second - offset) {
+                        return -1;
+                    }
+
+                    DecodedRecord record = { recordHeader.timestamp, first, recordHeader.level, recordHeader.tagId, std::string(), std::string() };
+                    Reader arguments(bytes + offset + sizeof(recordHeader), recordHeader.size - sizeof(recordHeader));
+                    if (recordHeader.flags & c_flagPreformatted) {
+                        Conversion conversion = {};
+                        if (!renderString(record.message, arguments, true, wcharSize, conversion, -1)) {
+                            return -1;
+                        }
+                    } else if (recordHeader.formatId < decodedFormats.size() && decodedFormats[recordHeader.formatId].recordable) {
+                        if (!renderMessage(record.message, decodedFormats[recordHeader.formatId], arguments, wcharSize, pointerSize)) {
+                            return -1;
+                        }
+                    } else {
+                        return -1;
+                    }
+
+                    records.emplace_back(std::move(record));
+                    offset += recordHeader.size;
+                }
+                break;
+            }
+
+            case c_chunkDropped: {
+                DecodedRecord record = { records.empty() ? 0 : records.back().timestamp, first, TraceLevelWarning, c_noId, "TraceRecorder", std::string() };
+                record.message = std::to_string(second) + " records dropped";
+                records.emplace_back(std::move(record));
+                break;
+            }
+
+            default:
+                return -1;
+        }
+    }
+
+    //  Tags are defined before the records that use them, but may follow records of other threads that don't
+    for (DecodedRecord& record : records) {
+        if (record.tagId != c_noId && record.tagId < decodedTags.size()) {
+            record.tag = decodedTags[record.tagId];
+        }
+    }
+
+    std::stable_sort(records.begin(), records.end(), [](const DecodedRecord& a, const DecodedRecord& b) { return a.timestamp < b.timestamp; });
+
+    for (const DecodedRecord& record : records) {
+        const TraceDecodedRecord decoded = { record.timestamp, record.threadId, record.level, record.tag.c_str(), record.message.c_str() };
+        callback(&decoded, context);
+    }
+
+    return static_cast<int64_t>(records.size());
+}
@@ -169,8 +169,121 @@ void DoLayerLayouts(CALayer* window, bool doAlwaysLayers) {
     }
 }
 
+//  Layers bigger than this in either dimension are backed by tiles rather than a single texture
+static const int c_maxUntiledBackingSize = 2048;
+static const int c_defaultBackingTileSize = 512;
+
+//  The number of layers currently backed by tiles; while there are any, moving a layer may reveal tiles that need drawing
+static int s_tiledLayerCount = 0;
+
+// The tiles backing a layer too big for a single texture. Each tile is an internal layer that isn't one of the layer's
+// sublayers, whose presentation node sits beneath the layer's sublayers and which holds its own bitmap context.
+class LayerTileStore {
+public:
+    LayerTileStore(int pixelWidth, int pixelHeight, CGSize tileSize, CGPoint origin, float scale)
+        : grid(pixelWidth, pixelHeight, (int)tileSize.width, (int)tileSize.height),
+          tileSize(tileSize),
+          origin(origin),
+          scale(scale),
+          tiles(grid.Count(), nil) {
+        s_tiledLayerCount++;
+    }
+
+    ~LayerTileStore() {
+        for (CALayer* tile : tiles) {
+            if (tile) {
+                [CATransaction _removeLayer:tile];
+                [tile release];
+            }
+        }
+
+        s_tiledLayerCount--;
+    }
+
+    bool Matches(int pixelWidth, int pixelHeight, CGSize size, CGPoint layerOrigin, float layerScale) const {
+        return grid.PixelWidth() == pixelWidth && grid.PixelHeight() == pixelHeight && CGSizeEqualToSize(tileSize, size) &&
+               CGPointEqualToPoint(origin, layerOrigin) && scale == layerScale;
+    }
+
+    LayerTileGrid grid;
+    CGSize tileSize;
+    CGPoint origin;
+    float scale;
+    std::vector<CALayer*> tiles;
+};
+
+//  Returns the part of the layer's bounds that isn't clipped away by its masksToBounds ancestors or by the bounds of its
+//  root layer, in pixels. Layers with a transformed ancestor are treated as wholly visible.
+static LayerPixelRect VisibleLayerPixelRect(CAPrivateInfo* layer) {
+    const LayerPixelRect whole = LayerPixelRect::FromLayerRect(layer->bounds, layer->bounds, layer->contentsScale);
+
+    CGRect visible = layer->bounds;
+    CGPoint offset = { 0.0f, 0.0f };
+    for (CAPrivateInfo* cur = layer; cur->superlayer; ) {
+        CAPrivateInfo* parent = cur->superlayer->priv;
+        if (parent->hidden) {
+            return { 0, 0, 0, 0 };
+        }
+        if (!CATransform3DIsIdentity(cur->transform) || !CATransform3DIsIdentity(parent->sublayerTransform)) {
+            return whole;
+        }
+
+        //  offset maps the layer's coordinates into parent's
+        offset.x += cur->position.x - cur->anchorPoint.x * cur->bounds.size.width - cur->bounds.origin.x;
+        offset.y += cur->position.y - cur->anchorPoint.y * cur->bounds.size.height - cur->bounds.origin.y;
+        cur = parent;
+
+        if (cur->masksToBounds || !cur->superlayer) {
+            const float left = std::max(CGRectGetMinX(visible), CGRectGetMinX(cur->bounds) - offset.x);
+            const float top = std::max(CGRectGetMinY(visible), CGRectGetMinY(cur->bounds) - offset.y);
+            const float right = std::min(CGRectGetMaxX(visible), CGRectGetMaxX(cur->bounds) - offset.x);
+            const float bottom = std::min(CGRectGetMaxY(visible), CGRectGetMaxY(cur->bounds) - offset.y);
+            if (right <= left || bottom <= top) {
+                return { 0, 0, 0, 0 };
+            }
+
+            visible = CGRectMake(left, top, right - left, bottom - top);
+        }
+    }
+
+    return LayerPixelRect::FromLayerRect(visible, layer->bounds, layer->contentsScale).Intersection(whole);
+}
+
+static void SetTileTextures(CAPrivateInfo* layer) {
+    for (CALayer* tile : layer->_tiles->tiles) {
+        if (!tile || !tile->priv->hasNewContents) {
+            continue;
+        }
+
+        tile->priv->hasNewContents = FALSE;
+        DisplayTexture* texture = tile->priv->contents ? GetCACompositor()->GetDisplayTextureForCGImage(tile->priv->contents, true) : NULL;
+        GetCACompositor()->setNodeTexture([CATransaction _currentDisplayTransaction],
+                                          tile->priv->_presentationNode,
+                                          texture,
+                                          tile->priv->contentsSize,
+                                          tile->priv->contentsScale);
+        if (texture) {
+            GetCACompositor()->ReleaseDisplayTexture(texture);
+        }
+    }
+}
+
+//  Moving a layer, or scrolling its contents, can bring undrawn tiles of it or its sublayers into view. Tiles are placed
+//  relative to the bounds origin they were drawn for, so scrolling a tiled layer's own contents redraws them.
+static void TiledLayerMoved(CALayer* layer, bool originChanged) {
+    if (originChanged && layer->priv->_tiles) {
+        [layer setNeedsDisplay];
+    } else if (s_tiledLayerCount > 0) {
+        [layer _displayChanged];
+    }
+}
+
 static void GetNeededDisplays(CAPrivateInfo* state, NodeList<CAPrivateInfo>* list) {
     CAPrivateInfo* cur = state;
+    if (cur->_tiles && !cur->needsDisplay && cur->_tiles->grid.NeedsUpdate(VisibleLayerPixelRect(cur))) {
+        //  Scrolled or moved such that tiles which have yet to be drawn are now visible
+        cur->needsDisplay = TRUE;
+    }
     if (cur->needsDisplay || cur->hasNewContents) {
         list->AddNode(cur);
     }
@@ -221,6 +334,10 @@ static void DoDisplayList(CALayer* layer) {
             if (newTexture) {
                 GetCACompositor()->ReleaseDisplayTexture(newTexture);
             }
+
+            if (cur->_tiles) {
+                SetTileTextures(cur);
+            }
         } else {
             cur->needsDisplay = FALSE;
             cur->hasNewContents = FALSE;
@@ -328,6 +445,9 @@ CAPrivateInfo::~CAPrivateInfo() {
     [maskLayer release];
     maskLayer = nil;
 
+    delete _tiles;
+    _tiles = nullptr;
+
     GetCACompositor()->ReleaseNode(_presentationNode);
     _presentationNode = NULL;
 }
@@ -395,6 +515,7 @@ CGContextRef CreateLayerContentsBitmapContext32(int width, int height) {
 */
 - (void)setNeedsDisplay {
     priv->needsDisplay = TRUE;
+    priv->_dirtyRegion.AddAll();
     [self _displayChanged];
 }
 
@@ -502,45 +623,16 @@ CGContextRef CreateLayerContentsBitmapContext32(int width, int height) {
                      priv->delegate ? object_getClassName(priv->delegate) : "nil");
     }
 
-    if (priv->savedContext != NULL) {
-        CGContextRelease(priv->savedContext);
-        priv->savedContext = NULL;
-    }
-
     if (priv->contentsInset.origin.x != 0.0f || priv->contentsInset.origin.y != 0.0f || priv->contentsInset.size.width != 0.0f ||
         priv->contentsInset.size.height != 0.0f) {
         memset(&priv->contentsInset, 0, sizeof(CGRect));
     }
 
     if (priv->contents == NULL || priv->ownsContents || [self isKindOfClass:[CAShapeLayer class]]) {
-        if (priv->contents) {
-            if (priv->ownsContents) {
-                if (DEBUG_VERBOSE) {
-                    TraceVerbose(TAG, L"Freeing 0x%x with refcount %d", priv->contents, CFGetRetainCount((CFTypeRef)priv->contents));
-                }
-                CGImageRelease(priv->contents);
-            }
-            priv->contents = NULL;
-        }
-
         // Update content size, even in case of the early out below.
         int width = (int)(ceilf(priv->bounds.size.width) * priv->contentsScale);
         int height = (int)(ceilf(priv->bounds.size.height) * priv->contentsScale);
 
-        if (width <= 0 || height <= 0) {
-            return;
-        }
-
-        if (width > 2048) {
-            width = 2048;
-        }
-        if (height > 2048) {
-            height = 2048;
-        }
-
-        priv->contentsSize.width = (float)width;
-        priv->contentsSize.height = (float)height;
-
         // nothing to do?
         bool hasDrawingMethod = false;
         if (priv->delegate != nil && (!object_isMethodFromClass(priv->delegate, @selector(drawRect:), "UIView") ||
@@ -551,16 +643,55 @@ CGContextRef CreateLayerContentsBitmapContext32(int width, int height) {
         if (!object_isMethodFromClass(self, @selector(drawInContext:), "CALayer")) {
             hasDrawingMethod = true;
         }
-        if (!hasDrawingMethod) {
-            return;
+
+        const CGSize tileSize = [self _backingTileSize];
+        const bool tiled = tileSize.width > 0.0f && tileSize.height > 0.0f;
+        const bool opaqueBacking = priv->isOpaque && priv->_backgroundColor == nil;
+
+        //  The existing backing can be redrawn in place, just where it is dirty, if it is still the right size and format and
+        //  the compositor displays it straight from its writable texture
+        bool reuseBacking = false;
+        if (!tiled && width > 0 && height > 0 && hasDrawingMethod && priv->ownsContents && priv->contents && priv->savedContext &&
+            !priv->_dirtyRegion.IsEmpty() && !priv->_dirtyRegion.IsAll()) {
+            CGImageBacking* backing = priv->contents->Backing();
+            reuseBacking = backing->Width() == width && backing->Height() == height &&
+                           (backing->SurfaceFormat() == _ColorBGR) == opaqueBacking && backing->GetDisplayTexture() != NULL;
         }
 
-        bool useVector = false;
+        if (!reuseBacking) {
+            if (priv->savedContext != NULL) {
+                CGContextRelease(priv->savedContext);
+                priv->savedContext = NULL;
+            }
 
-        //  Create the contents
-        CGImageRef target = NULL;
-        CGContextRef drawContext = NULL;
-        CGImageRef vectorTarget = NULL;
+            if (priv->contents) {
+                if (priv->ownsContents) {
+                    if (DEBUG_VERBOSE) {
+                        TraceVerbose(TAG, L"Freeing 0x%x with refcount %d", priv->contents, CFGetRetainCount((CFTypeRef)priv->contents));
+                    }
+                    CGImageRelease(priv->contents);
+                }
+                priv->contents = NULL;
+            }
+        }
+
+        const bool hasContents = width > 0 && height > 0 && hasDrawingMethod;
+        if ((!tiled || !hasContents) && priv->_tiles) {
+            delete priv->_tiles;
+            priv->_tiles = nullptr;
+        }
+
+        if (!hasContents) {
+            priv->_dirtyRegion.Clear();
+            if (width > 0 && height > 0) {
+                priv->contentsSize.width = (float)width;
+                priv->contentsSize.height = (float)height;
+            }
+            return;
+        }
+
+        priv->contentsSize.width = (float)width;
+        priv->contentsSize.height = (float)height;
 
         if ((priv->isOpaque && priv->_backgroundColor == nil) || priv->backgroundColor.a == 1.0) {
             priv->drewOpaque = TRUE;
@@ -568,78 +699,58 @@ CGContextRef CreateLayerContentsBitmapContext32(int width, int height) {
             priv->drewOpaque = FALSE;
         }
 
-        if (!target) {
-            if ((priv->isOpaque && priv->_backgroundColor == nil) || (priv->backgroundColor.a == 1.0 && 0)) {
-                /* CGVectorImage is currently in development - not ready for general use */
-                if (useVector) {
-                    // target = new CGVectorImage(width, height, _ColorBGR);
-                } else {
-                    drawContext = _CGBitmapContextCreateWithFormat(width, height, _ColorBGR);
-                }
-                priv->drewOpaque = TRUE;
-            } else {
-                /* CGVectorImage is currently in development - not ready for general use */
-                if (useVector) {
-                    // target = new CGVectorImage(width, height, _ColorARGB);
-                } else {
-                    drawContext = CreateLayerContentsBitmapContext32(width, height);
-                }
-                priv->drewOpaque = FALSE;
-            }
-            priv->ownsContents = TRUE;
+        if (tiled) {
+            [self _displayTilesOfSize:tileSize pixelWidth:width pixelHeight:height];
+            priv->_dirtyRegion.Clear();
+            priv->hasNewContents = TRUE;
+            return;
         }
-        target = CGBitmapContextGetImage(drawContext);
-
-        CGContextRetain(drawContext);
-        CGImageRetain(target);
-        priv->savedContext = drawContext;
 
-        if (!vectorTarget) {
-            if (priv->_backgroundColor == nil || (int)[static_cast<UIColor*>(priv->_backgroundColor) _type] == solidBrush) {
-                CGContextClearToColor(drawContext,
-                                      priv->backgroundColor.r,
-                                      priv->backgroundColor.g,
-                                      priv->backgroundColor.b,
-                                      priv->backgroundColor.a);
-            } else {
-                CGContextClearToColor(drawContext, 0, 0, 0, 0);
-
-                CGContextSaveGState(drawContext);
-                CGContextSetFillColorWithColor(drawContext, [static_cast<UIColor*>(priv->_backgroundColor) CGColor]);
+        if (reuseBacking) {
+            std::vector<LayerPixelRect> pixelRects;
+            priv->_dirtyRegion.GetPixelRects(priv->bounds, priv->contentsScale, { 0, 0, width, height }, pixelRects);
+            priv->_dirtyRegion.Clear();
+            if (pixelRects.empty()) {
+                return;
+            }
 
-                CGRect wholeRect;
+            std::vector<CGRect> clipRects;
+            for (const LayerPixelRect& rect : pixelRects) {
+                clipRects.emplace_back(rect.ToLayerRect(priv->bounds, priv->contentsScale));
+            }
 
-                wholeRect.origin.x = 0;
-                wholeRect.origin.y = 0;
-                wholeRect.size.width = float(width);
-                wholeRect.size.height = float(height);
+            //  Whatever was drawn outside the dirty rects is still valid, so the contents are kept even if nothing is drawn
+            [self _drawIntoContext:priv->savedContext
+                             height:height
+                             origin:priv->bounds.origin
+                          clipRects:clipRects.data()
+                              count:clipRects.size()];
+            CGContextReleaseLock(priv->savedContext);
 
-                CGContextFillRect(drawContext, wholeRect);
-                CGContextRestoreGState(drawContext);
-            }
+            priv->hasNewContents = TRUE;
+            return;
         }
 
-        if (target->Backing()->Height() != 0) {
-            CGContextTranslateCTM(drawContext, 0, float(target->Backing()->Height()));
-        }
-        if (priv->contentsScale != 1.0f) {
-            CGContextScaleCTM(drawContext, priv->contentsScale, priv->contentsScale);
+        priv->_dirtyRegion.Clear();
+
+        //  Create the contents
+        CGContextRef drawContext = NULL;
+        if (opaqueBacking) {
+            drawContext = _CGBitmapContextCreateWithFormat(width, height, _ColorBGR);
+            priv->drewOpaque = TRUE;
+        } else {
+            drawContext = CreateLayerContentsBitmapContext32(width, height);
+            priv->drewOpaque = FALSE;
         }
+        priv->ownsContents = TRUE;
 
-        CGContextScaleCTM(drawContext, 1.0f, -1.0f);
-        CGContextTranslateCTM(drawContext, -priv->bounds.origin.x, -priv->bounds.origin.y);
+        CGImageRef target = CGBitmapContextGetImage(drawContext);
 
-        CGContextSetDirty(drawContext, false);
-        [self drawInContext:drawContext];
+        CGContextRetain(drawContext);
+        CGImageRetain(target);
+        priv->savedContext = drawContext;
 
-        if (priv->delegate != 0) {
-            // const char *name = ((id) priv->delegate).object_getClassName();
-            if ([priv->delegate respondsToSelector:@selector(displayLayer:)]) {
-                [priv->delegate displayLayer:self];
-            } else {
-                [priv->delegate drawLayer:self inContext:drawContext];
-            }
-        }
+        [self _drawIntoContext:drawContext height:height origin:priv->bounds.origin clipRects:NULL count:0];
 
         CGContextReleaseLock(drawContext);
         CGContextRelease(drawContext);
@@ -650,39 +761,203 @@ CGContextRef CreateLayerContentsBitmapContext32(int width, int height) {
             priv->savedContext = NULL;
             priv->contents = NULL;
         } else {
-            if (vectorTarget) {
-                /*
-                CGVectorImage *vecImg = (CGVectorImage *) target;
+            priv->contents = target;
+        }
+    } else {
+        if (priv->savedContext != NULL) {
+            CGContextRelease(priv->savedContext);
+            priv->savedContext = NULL;
+        }
 
-                priv->contents = vecImg->Rasterize(&priv->contentsInset);
+        if (priv->contents) {
+            priv->contentsSize.width = float(priv->contents->Backing()->Width());
+            priv->contentsSize.height = float(priv->contents->Backing()->Height());
+        }
+    }
 
-                priv->contentsInset.origin.x /= priv->contentsScale;
-                priv->contentsInset.origin.y /= priv->contentsScale;
-                priv->contentsInset.size.width /= priv->contentsScale;
-                priv->contentsInset.size.height /= priv->contentsScale;
+    //  To signal that we need our context converted into a texture and sent to NativeUI (checked in UIApplication.cpp)
+    priv->hasNewContents = TRUE;
+}
+
+//  Draws the layer's background and content into a backing store height pixels tall whose top left corner is at origin in
+//  the layer's coordinates. Given clipRects, in the layer's coordinates, only those parts are cleared and drawn.
+- (void)_drawIntoContext:(CGContextRef)drawContext
+                  height:(int)height
+                  origin:(CGPoint)origin
+               clipRects:(const CGRect*)clipRects
+                   count:(size_t)count {
+    const bool solidBackground =
+        priv->_backgroundColor == nil || (int)[static_cast<UIColor*>(priv->_backgroundColor) _type] == solidBrush;
+
+    CGContextSaveGState(drawContext);
+
+    if (count == 0) {
+        if (solidBackground) {
+            CGContextClearToColor(drawContext,
+                                  priv->backgroundColor.r,
+                                  priv->backgroundColor.g,
+                                  priv->backgroundColor.b,
+                                  priv->backgroundColor.a);
+        } else {
+            CGContextClearToColor(drawContext, 0, 0, 0, 0);
+
+            CGContextSaveGState(drawContext);
+            CGContextSetFillColorWithColor(drawContext, [static_cast<UIColor*>(priv->_backgroundColor) CGColor]);
+
+            CGRect wholeRect;
+
+            wholeRect.origin.x = 0;
+            wholeRect.origin.y = 0;
+            wholeRect.size.width = float(CGBitmapContextGetWidth(drawContext));
+            wholeRect.size.height = float(height);
+
+            CGContextFillRect(drawContext, wholeRect);
+            CGContextRestoreGState(drawContext);
+        }
+    }
+
+    if (height != 0) {
+        CGContextTranslateCTM(drawContext, 0, float(height));
+    }
+    if (priv->contentsScale != 1.0f) {
+        CGContextScaleCTM(drawContext, priv->contentsScale, priv->contentsScale);
+    }
+
+    CGContextScaleCTM(drawContext, 1.0f, -1.0f);
+    CGContextTranslateCTM(drawContext, -origin.x, -origin.y);
+
+    if (count != 0) {
+        CGContextClipToRects(drawContext, clipRects, count);
+
+        CGContextSaveGState(drawContext);
+        if (solidBackground) {
+            CGContextSetRGBFillColor(drawContext,
+                                     priv->backgroundColor.r,
+                                     priv->backgroundColor.g,
+                                     priv->backgroundColor.b,
+                                     priv->backgroundColor.a);
+        } else {
+            CGContextSetFillColorWithColor(drawContext, [static_cast<UIColor*>(priv->_backgroundColor) CGColor]);
+        }
+
+        for (size_t i = 0; i < count; i++) {
+            CGContextClearRect(drawContext, clipRects[i]);
+            CGContextFillRect(drawContext, clipRects[i]);
+        }
+        CGContextRestoreGState(drawContext);
+    }
 
-                CGImageRelease(vecImg);
-                */
+    CGContextSetDirty(drawContext, false);
+    [self drawInContext:drawContext];
+
+    if (priv->delegate != 0) {
+        if ([priv->delegate respondsToSelector:@selector(displayLayer:)]) {
+            [priv->delegate displayLayer:self];
+        } else {
+            [priv->delegate drawLayer:self inContext:drawContext];
+        }
+    }
+
+    CGContextRestoreGState(drawContext);
+}
+
+//  Brings the visible tiles of a tiled layer up to date, drawing only those parts of them that are dirty
+- (void)_displayTilesOfSize:(CGSize)tileSize pixelWidth:(int)width pixelHeight:(int)height {
+    const float scale = priv->contentsScale;
+
+    std::vector<LayerPixelRect> dirtyRects;
+    if (priv->_tiles && !priv->_tiles->Matches(width, height, tileSize, priv->bounds.origin, scale)) {
+        delete priv->_tiles;
+        priv->_tiles = nullptr;
+    }
+
+    if (!priv->_tiles) {
+        priv->_tiles = new LayerTileStore(width, height, tileSize, priv->bounds.origin, scale);
+    } else {
+        priv->_dirtyRegion.GetPixelRects(priv->bounds, scale, { 0, 0, width, height }, dirtyRects);
+    }
+
+    LayerTileStore* store = priv->_tiles;
+    std::vector<LayerTileUpdate> updates;
+    std::vector<size_t> discarded;
+    store->grid.Update(dirtyRects, VisibleLayerPixelRect(priv), updates, discarded);
+
+    for (size_t index : discarded) {
+        CAPrivateInfo* tile = store->tiles[index]->priv;
+        CGContextRelease(tile->savedContext);
+        tile->savedContext = NULL;
+        CGImageRelease(tile->contents);
+        tile->contents = NULL;
+        tile->hasNewContents = TRUE;
+    }
+
+    for (const LayerTileUpdate& update : updates) {
+        const LayerPixelRect tileRect = store->grid.TileRect(update.index);
+
+        CALayer* tileLayer = store->tiles[update.index];
+        if (!tileLayer) {
+            tileLayer = [CALayer new];
+
+            //  Tiles are drawn by their owner, never displayed themselves
+            tileLayer->priv->needsDisplay = FALSE;
+            tileLayer->priv->ownsContents = TRUE;
+            [tileLayer setAnchorPoint:CGPointMake(0.0f, 0.0f)];
+            [tileLayer setContentsScale:scale];
+            [tileLayer setBounds:CGRectMake(0.0f, 0.0f, tileRect.width / scale, tileRect.height / scale)];
+            [tileLayer setPosition:CGPointMake(priv->bounds.origin.x + tileRect.x / scale, priv->bounds.origin.y + tileRect.y / scale)];
+
+            if (priv->firstChild) {
+                [CATransaction _addSublayerToLayer:self sublayer:tileLayer before:priv->firstChild->self];
             } else {
-                priv->contents = target;
+                [CATransaction _addSublayerToLayer:self sublayer:tileLayer];
             }
+
+            store->tiles[update.index] = tileLayer;
+        }
+
+        CAPrivateInfo* tile = tileLayer->priv;
+        if (tile->savedContext && !tile->contents->Backing()->GetDisplayTexture()) {
+            //  Not a writable texture, so the compositor would go on showing the old contents if they were drawn over in place
+            CGContextRelease(tile->savedContext);
+            tile->savedContext = NULL;
+            CGImageRelease(tile->contents);
+            tile->contents = NULL;
         }
-    } else {
-        if (priv->contents) {
-            priv->contentsSize.width = float(priv->contents->Backing()->Width());
-            priv->contentsSize.height = float(priv->contents->Backing()->Height());
 
-            /*
-            if ( priv->contents->_cachedTexture ) {
-            priv->contents->_cachedTexture->Release();
-            priv->contents->_cachedTexture = NULL;
+        const bool whole = update.rects.size() == 1 && update.rects[0].Area() == tileRect.Area();
+        if (!tile->savedContext) {
+            tile->savedContext = CreateLayerContentsBitmapContext32(tileRect.width, tileRect.height);
+            tile->contents = CGImageRetain(CGBitmapContextGetImage(tile->savedContext));
+        }
+
+        std::vector<CGRect> clipRects;
+        if (!whole) {
+            for (const LayerPixelRect& rect : update.rects) {
+                clipRects.emplace_back(rect.ToLayerRect(priv->bounds, scale));
             }
-            */
         }
+
+        [self _drawIntoContext:tile->savedContext
+                         height:tileRect.height
+                         origin:LayerPixelRect{ tileRect.x, tileRect.y, 0, 0 }.ToLayerRect(priv->bounds, scale).origin
+                      clipRects:clipRects.data()
+                          count:clipRects.size()];
+        CGContextReleaseLock(tile->savedContext);
+
+        tile->contentsSize.width = (float)tileRect.width;
+        tile->contentsSize.height = (float)tileRect.height;
+        tile->hasNewContents = TRUE;
+    }
+}
+
+- (CGSize)_backingTileSize {
+    const int width = (int)(ceilf(priv->bounds.size.width) * priv->contentsScale);
+    const int height = (int)(ceilf(priv->bounds.size.height) * priv->contentsScale);
+    if (width > c_maxUntiledBackingSize || height > c_maxUntiledBackingSize) {
+        return CGSizeMake(c_defaultBackingTileSize, c_defaultBackingTileSize);
     }
 
-    //  To signal that we need our context converted into a texture and sent to NativeUI (checked in UIApplication.cpp)
-    priv->hasNewContents = TRUE;
+    return CGSizeZero;
 }
 
 static void doRecursiveAction(CALayer* layer, NSString* actionName) {
@@ -1156,6 +1431,7 @@ static void doRecursiveAction(CALayer* layer, NSString* actionName) {
     [CATransaction _setPropertyForLayer:self name:@"position" value:newPosValue];
     [newPosValue release];
     priv->positionSet = TRUE;
+    TiledLayerMoved(self, false);
 
     if (action != nil) {
         [action runActionForKey:(id)_positionAction object:self arguments:nil];
@@ -1223,6 +1499,7 @@ static void doRecursiveAction(CALayer* layer, NSString* actionName) {
         NSValue* newOriginValue = [[NSValue alloc] initWithCGPoint:priv->bounds.origin];
         [CATransaction _setPropertyForLayer:self name:@"bounds.origin" value:newOriginValue];
         [newOriginValue release];
+        TiledLayerMoved(self, true);
     }
 
     [action runActionForKey:(id)_boundsAction object:self arguments:nil];
@@ -1247,6 +1524,7 @@ static void doRecursiveAction(CALayer* layer, NSString* actionName) {
         action = [self actionForKey:_boundsOriginAction];
         priv->bounds.origin = origin;
         [action runActionForKey:(id)_boundsOriginAction object:self arguments:nil];
+        TiledLayerMoved(self, true);
 
         // In the case of scrollviewer, we should not to update backing CALayer origin, This is related to our new design.
         // previously updating the CALayer origin would resulting in content scrolling. but now scrollviewer
@@ -1483,6 +1761,9 @@ static void doRecursiveAction(CALayer* layer, NSString* actionName) {
         }
     }
 
+    delete priv->_tiles;
+    priv->_tiles = nullptr;
+
     GetCACompositor()->setNodeTexture([CATransaction _currentDisplayTransaction], priv->_presentationNode, NULL, CGSizeMake(0, 0), 0.0f);
     [self setNeedsDisplay];
 }
@@ -2639,11 +2920,12 @@ inline WXUIElement* _getBackingXamlElementForCALayer(CALayer* layer) {
 }
 
 /**
- @Status Stub
- @Notes
+ @Status Interoperable
 */
 - (void)setNeedsDisplayInRect:(CGRect)theRect {
-    UNIMPLEMENTED();
+    priv->needsDisplay = TRUE;
+    priv->_dirtyRegion.Add(theRect);
+    [self _displayChanged];
 }
 
 /**
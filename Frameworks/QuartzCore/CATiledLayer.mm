@@ -16,8 +16,26 @@
 
 #import <StubReturn.h>
 #import <QuartzCore/CATiledLayer.h>
+#import "CALayerInternal.h"
 
 @implementation CATiledLayer
+/**
+ @Status Caveat
+ @Notes levelsOfDetail and levelsOfDetailBias are ignored; tiles are always drawn at the layer's contentsScale.
+*/
+- (instancetype)init {
+    if (self = [super init]) {
+        self.tileSize = CGSizeMake(256.0f, 256.0f);
+        self.levelsOfDetail = 1;
+    }
+
+    return self;
+}
+
+- (CGSize)_backingTileSize {
+    return self.tileSize;
+}
+
 /**
  @Status Stub
  @Notes
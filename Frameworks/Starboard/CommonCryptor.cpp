@@ -14,463 +14,1807 @@
 //
 //******************************************************************************
 
+#include <CommonCrypto/CommonCryptor.h>
+
+#include <algorithm>
+#include <new>
+#include <stdint.h>
+#include <string.h>
+
+#if defined(_M_IX86) || defined(_M_X64) || defined(__i386__) || defined(__x86_64__)
+#define CRYPTOR_X86 1
+#include <immintrin.h>
+#include <wmmintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#endif
+#else
+#define CRYPTOR_X86 0
+#endif
+
+// The ARMv8 AES instructions are optional; GCC and clang only build them when the file targets the crypto extension
+#if defined(_M_ARM64) || (defined(__aarch64__) && (defined(__ARM_FEATURE_CRYPTO) || defined(__ARM_FEATURE_AES)))
+#define CRYPTOR_ARM 1
+#include <arm_neon.h>
+#if defined(_WIN32)
 #include <Windows.h>
-#include <CommonCrypto\CommonCryptor.h>
-#include <COMIncludes.h>
-#include <wrl\wrappers\corewrappers.h>
-#include <wrl\client.h>
-#include <windows.security.cryptography.h>
-#include <windows.storage.streams.h>
-#include <COMIncludes_End.h>
-#include <ErrorHandling.h>
-#include <StubReturn.h>
-#include <RawBuffer.h>
-#include <memory>
-#include <vector>
-
-using namespace Microsoft::WRL;
-using namespace ABI::Windows::Storage::Streams;
-using namespace ABI::Windows::Security::Cryptography;
-using namespace ABI::Windows::Security::Cryptography::Core;
-using namespace Windows::Foundation;
-
-static CCCryptorStatus _cryptorStatusFromHRESULT(HRESULT result) {
-    switch (result) {
-        case E_INVALIDARG:
-            return kCCParamError;
-        case E_OUTOFMEMORY:
-            return kCCMemoryFailure;
-        case E_NOTIMPL:
+#else
+#include <sys/auxv.h>
+#include <asm/hwcap.h>
+#endif
+#else
+#define CRYPTOR_ARM 0
+#endif
+
+#if defined(__GNUC__) || defined(__clang__)
+#define CRYPTOR_TARGET(features) __attribute__((target(features)))
+#else
+#define CRYPTOR_TARGET(features)
+#endif
+
+namespace {
+
+const size_t c_maxBlockSize = 16;
+
+// Blocks handed to the block functions at once by the modes that can work on several blocks in parallel
+const size_t c_batchBlocks = 32;
+
+// Blocks kept in flight together by the hardware AES paths
+const size_t c_interleavedBlocks = 8;
+
+#pragma region Byte order
+
+inline uint16_t loadLittleEndian16(const uint8_t* p) {
+    return static_cast<uint16_t>(p[0] | (p[1] << 8));
+}
+
+inline void storeLittleEndian16(uint8_t* p, uint16_t value) {
+    p[0] = static_cast<uint8_t>(value);
+    p[1] = static_cast<uint8_t>(value >> 8);
+}
+
+inline uint32_t loadLittleEndian32(const uint8_t* p) {
+    return uint32_t(p[0]) | (uint32_t(p[1]) << 8) | (uint32_t(p[2]) << 16) | (uint32_t(p[3]) << 24);
+}
+
+inline void storeLittleEndian32(uint8_t* p, uint32_t value) {
+    p[0] = static_cast<uint8_t>(value);
+    p[1] = static_cast<uint8_t>(value >> 8);
+    p[2] = static_cast<uint8_t>(value >> 16);
+    p[3] = static_cast<uint8_t>(value >> 24);
+}
+
+inline uint64_t loadLittleEndian64(const uint8_t* p) {
+    return uint64_t(loadLittleEndian32(p)) | (uint64_t(loadLittleEndian32(p + 4)) << 32);
+}
+
+inline void storeLittleEndian64(uint8_t* p, uint64_t value) {
+    storeLittleEndian32(p, static_cast<uint32_t>(value));
+    storeLittleEndian32(p + 4, static_cast<uint32_t>(value >> 32));
+}
+
+inline uint64_t loadBigEndian64(const uint8_t* p) {
+    uint64_t value = 0;
+    for (size_t i = 0; i < 8; ++i) {
+        value = (value << 8) | p[i];
+    }
+
+    return value;
+}
+
+inline void storeBigEndian64(uint8_t* p, uint64_t value) {
+    for (size_t i = 0; i < 8; ++i) {
+        p[7 - i] = static_cast<uint8_t>(value >> (8 * i));
+    }
+}
+
+// Adds one to the big-endian integer in the last length bytes of block
+inline void incrementBigEndian(uint8_t* block, size_t length) {
+    for (size_t i = length; i > 0; --i) {
+        if (++block[i - 1] != 0) {
+            break;
+        }
+    }
+}
+
+inline void xorBytes(uint8_t* out, const uint8_t* a, const uint8_t* b, size_t length) {
+    size_t i = 0;
+    for (; i + sizeof(uint64_t) <= length; i += sizeof(uint64_t)) {
+        uint64_t x, y;
+        memcpy(&x, a + i, sizeof(x));
+        memcpy(&y, b + i, sizeof(y));
+        x ^= y;
+        memcpy(out + i, &x, sizeof(x));
+    }
+
+    for (; i < length; ++i) {
+        out[i] = a[i] ^ b[i];
+    }
+}
+
+// Clears key material in a way the optimizer will not drop
+void secureZero(void* p, size_t length) {
+    volatile uint8_t* bytes = static_cast<volatile uint8_t*>(p);
+    while (length--) {
+        *bytes++ = 0;
+    }
+}
+
+#pragma endregion
+
+#pragma region CPU features
+
+#if (CRYPTOR_X86 == 1)
+bool detectAesNi() {
+    int info[4];
+#if defined(_MSC_VER)
+    __cpuid(info, 1);
+#else
+    __cpuid(1, info[0], info[1], info[2], info[3]);
+#endif
+
+    const bool pclmulqdq = (info[2] & (1 << 1)) != 0;
+    const bool ssse3 = (info[2] & (1 << 9)) != 0;
+    const bool aes = (info[2] & (1 << 25)) != 0;
+    return pclmulqdq && ssse3 && aes;
+}
+
+const bool c_aesNi = detectAesNi();
+#endif
+
+#if (CRYPTOR_ARM == 1)
+bool detectArmAes() {
+#if defined(_WIN32)
+    return IsProcessorFeaturePresent(PF_ARM_V8_CRYPTO_INSTRUCTIONS_AVAILABLE) != FALSE;
+#else
+    return (getauxval(AT_HWCAP) & HWCAP_AES) != 0;
+#endif
+}
+
+const bool c_armAes = detectArmAes();
+#endif
+
+#pragma endregion
+
+#pragma region AES
+
+const unsigned c_aesMaxRounds = 14;
+
+struct AesKey {
+    unsigned rounds;
+    uint8_t encrypt[(c_aesMaxRounds + 1) * kCCBlockSizeAES128];
+    union {
+        // Round keys of the equivalent inverse cipher, for the hardware paths
+        uint8_t decrypt[(c_aesMaxRounds + 1) * kCCBlockSizeAES128];
+
+        // Bitsliced encryption round keys, for the portable path
+        uint64_t sliced[c_aesMaxRounds + 1][8];
+    };
+};
+
+// The portable AES works on four blocks at once in bitsliced form: plane k holds bit k of every byte, and bit
+// 16 * block + i of a plane belongs to byte i of that block. Bytes are never used as table indices, so the timing
+// does not depend on the key or the data.
+const size_t c_slicedBlocks = 4;
+
+inline uint64_t everyLane(uint64_t mask16) {
+    return mask16 * 0x0001000100010001ULL;
+}
+
+// Transposes the 8x8 bit matrix whose rows are the bytes of x
+inline uint64_t transposeBits(uint64_t x) {
+    uint64_t t = (x ^ (x >> 7)) & 0x00aa00aa00aa00aaULL;
+    x ^= t ^ (t << 7);
+    t = (x ^ (x >> 14)) & 0x0000cccc0000ccccULL;
+    x ^= t ^ (t << 14);
+    t = (x ^ (x >> 28)) & 0x00000000f0f0f0f0ULL;
+    x ^= t ^ (t << 28);
+    return x;
+}
+
+void sliceBlocks(const uint8_t* blocks, size_t count, uint64_t* planes) {
+    memset(planes, 0, 8 * sizeof(uint64_t));
+    for (size_t word = 0; word < 2 * count; ++word) {
+        const uint64_t bits = transposeBits(loadLittleEndian64(blocks + 8 * word));
+        for (unsigned k = 0; k < 8; ++k) {
+            planes[k] |= ((bits >> (8 * k)) & 0xff) << (8 * word);
+        }
+    }
+}
+
+void unsliceBlocks(const uint64_t* planes, uint8_t* blocks, size_t count) {
+    for (size_t word = 0; word < 2 * count; ++word) {
+        uint64_t bits = 0;
+        for (unsigned k = 0; k < 8; ++k) {
+            bits |= ((planes[k] >> (8 * word)) & 0xff) << (8 * k);
+        }
+
+        storeLittleEndian64(blocks + 8 * word, transposeBits(bits));
+    }
+}
+
+// The AES S-box as the 113 gate circuit of Boyar and Peralta, "A depth-16 circuit for the AES S-box"
+void subBytes(uint64_t* state) {
+    const uint64_t x0 = state[7], x1 = state[6], x2 = state[5], x3 = state[4];
+    const uint64_t x4 = state[3], x5 = state[2], x6 = state[1], x7 = state[0];
+
+    //  Top linear transformation
+    const uint64_t y14 = x3 ^ x5;
+    const uint64_t y13 = x0 ^ x6;
+    const uint64_t y9 = x0 ^ x3;
+    const uint64_t y8 = x0 ^ x5;
+    const uint64_t t0 = x1 ^ x2;
+    const uint64_t y1 = t0 ^ x7;
+    const uint64_t y4 = y1 ^ x3;
+    const uint64_t y12 = y13 ^ y14;
+    const uint64_t y2 = y1 ^ x0;
+    const uint64_t y5 = y1 ^ x6;
+    const uint64_t y3 = y5 ^ y8;
+    const uint64_t t1 = x4 ^ y12;
+    const uint64_t y15 = t1 ^ x5;
+    const uint64_t y20 = t1 ^ x1;
+    const uint64_t y6 = y15 ^ x7;
+    const uint64_t y10 = y15 ^ t0;
+    const uint64_t y11 = y20 ^ y9;
+    const uint64_t y7 = x7 ^ y11;
+    const uint64_t y17 = y10 ^ y11;
+    const uint64_t y19 = y10 ^ y8;
+    const uint64_t y16 = t0 ^ y11;
+    const uint64_t y21 = y13 ^ y16;
+    const uint64_t y18 = x0 ^ y16;
+
+    //  Inversion in GF(2^8) by way of GF(2^4)
+    const uint64_t t2 = y12 & y15;
+    const uint64_t t3 = y3 & y6;
+    const uint64_t t4 = t3 ^ t2;
+    const uint64_t t5 = y4 & x7;
+    const uint64_t t6 = t5 ^ t2;
+    const uint64_t t7 = y13 & y16;
+    const uint64_t t8 = y5 & y1;
+    const uint64_t t9 = t8 ^ t7;
+    const uint64_t t10 = y2 & y7;
+    const uint64_t t11 = t10 ^ t7;
+    const uint64_t t12 = y9 & y11;
+    const uint64_t t13 = y14 & y17;
+    const uint64_t t14 = t13 ^ t12;
+    const uint64_t t15 = y8 & y10;
+    const uint64_t t16 = t15 ^ t12;
+    const uint64_t t17 = t4 ^ t14;
+    const uint64_t t18 = t6 ^ t16;
+    const uint64_t t19 = t9 ^ t14;
+    const uint64_t t20 = t11 ^ t16;
+    const uint64_t t21 = t17 ^ y20;
+    const uint64_t t22 = t18 ^ y19;
+    const uint64_t t23 = t19 ^ y21;
+    const uint64_t t24 = t20 ^ y18;
+
+    const uint64_t t25 = t21 ^ t22;
+    const uint64_t t26 = t21 & t23;
+    const uint64_t t27 = t24 ^ t26;
+    const uint64_t t28 = t25 & t27;
+    const uint64_t t29 = t28 ^ t22;
+    const uint64_t t30 = t23 ^ t24;
+    const uint64_t t31 = t22 ^ t26;
+    const uint64_t t32 = t31 & t30;
+    const uint64_t t33 = t32 ^ t24;
+    const uint64_t t34 = t23 ^ t33;
+    const uint64_t t35 = t27 ^ t33;
+    const uint64_t t36 = t24 & t35;
+    const uint64_t t37 = t36 ^ t34;
+    const uint64_t t38 = t27 ^ t36;
+    const uint64_t t39 = t29 & t38;
+    const uint64_t t40 = t25 ^ t39;
+
+    const uint64_t t41 = t40 ^ t37;
+    const uint64_t t42 = t29 ^ t33;
+    const uint64_t t43 = t29 ^ t40;
+    const uint64_t t44 = t33 ^ t37;
+    const uint64_t t45 = t42 ^ t41;
+    const uint64_t z0 = t44 & y15;
+    const uint64_t z1 = t37 & y6;
+    const uint64_t z2 = t33 & x7;
+    const uint64_t z3 = t43 & y16;
+    const uint64_t z4 = t40 & y1;
+    const uint64_t z5 = t29 & y7;
+    const uint64_t z6 = t42 & y11;
+    const uint64_t z7 = t45 & y17;
+    const uint64_t z8 = t41 & y10;
+    const uint64_t z9 = t44 & y12;
+    const uint64_t z10 = t37 & y3;
+    const uint64_t z11 = t33 & y4;
+    const uint64_t z12 = t43 & y13;
+    const uint64_t z13 = t40 & y5;
+    const uint64_t z14 = t29 & y2;
+    const uint64_t z15 = t42 & y9;
+    const uint64_t z16 = t45 & y14;
+    const uint64_t z17 = t41 & y8;
+
+    //  Bottom linear transformation, which includes the affine map
+    const uint64_t t46 = z15 ^ z16;
+    const uint64_t t47 = z10 ^ z11;
+    const uint64_t t48 = z5 ^ z13;
+    const uint64_t t49 = z9 ^ z10;
+    const uint64_t t50 = z2 ^ z12;
+    const uint64_t t51 = z2 ^ z5;
+    const uint64_t t52 = z7 ^ z8;
+    const uint64_t t53 = z0 ^ z3;
+    const uint64_t t54 = z6 ^ z7;
+    const uint64_t t55 = z16 ^ z17;
+    const uint64_t t56 = z12 ^ t48;
+    const uint64_t t57 = t50 ^ t53;
+    const uint64_t t58 = z4 ^ t46;
+    const uint64_t t59 = z3 ^ t54;
+    const uint64_t t60 = t46 ^ t57;
+    const uint64_t t61 = z14 ^ t57;
+    const uint64_t t62 = t52 ^ t58;
+    const uint64_t t63 = t49 ^ t58;
+    const uint64_t t64 = z4 ^ t59;
+    const uint64_t t65 = t61 ^ t62;
+    const uint64_t t66 = z1 ^ t63;
+    const uint64_t t67 = t64 ^ t65;
+
+    const uint64_t s3 = t53 ^ t66;
+    state[7] = t59 ^ t63;
+    state[6] = t64 ^ ~s3;
+    state[5] = t55 ^ ~t67;
+    state[4] = s3;
+    state[3] = t51 ^ t66;
+    state[2] = t47 ^ t65;
+    state[1] = t56 ^ ~t62;
+    state[0] = t48 ^ ~t60;
+}
+
+// Undoes the affine map that follows inversion in the S-box
+void invAffine(uint64_t* state) {
+    uint64_t affine[8];
+    for (unsigned i = 0; i < 8; ++i) {
+        affine[i] = state[(i + 2) % 8] ^ state[(i + 5) % 8] ^ state[(i + 7) % 8];
+    }
+
+    //  The inverse affine constant 0x05
+    affine[0] = ~affine[0];
+    affine[2] = ~affine[2];
+    memcpy(state, affine, sizeof(affine));
+}
+
+void invSubBytes(uint64_t* state) {
+    //  Inversion is its own inverse, so the inverse S-box is the forward one between two inverse affine maps
+    invAffine(state);
+    subBytes(state);
+    invAffine(state);
+}
+
+// Moves every byte of row `row` left by `columns` columns, wrapping within its block
+inline uint64_t rotateRow(uint64_t plane, unsigned row, unsigned columns) {
+    const uint64_t rowMask = 0x1111u << row;
+    const uint64_t stayMask = rowMask & ((1u << (16 - 4 * columns)) - 1);
+    const uint64_t wrapMask = rowMask & ~stayMask;
+    const uint64_t bits = plane & everyLane(rowMask);
+    return ((bits >> (4 * columns)) & everyLane(stayMask)) | ((bits << (16 - 4 * columns)) & everyLane(wrapMask));
+}
+
+void shiftRows(uint64_t* state, bool inverse) {
+    for (unsigned k = 0; k < 8; ++k) {
+        uint64_t result = state[k] & everyLane(0x1111);
+        for (unsigned row = 1; row < 4; ++row) {
+            result |= rotateRow(state[k], row, inverse ? 4 - row : row);
+        }
+
+        state[k] = result;
+    }
+}
+
+// Each byte takes the value of the byte one (or two) rows below it in the same column
+inline uint64_t rotateColumn1(uint64_t plane) {
+    return ((plane >> 1) & everyLane(0x7777)) | ((plane << 3) & everyLane(0x8888));
+}
+
+inline uint64_t rotateColumn2(uint64_t plane) {
+    return ((plane >> 2) & everyLane(0x3333)) | ((plane << 2) & everyLane(0xcccc));
+}
+
+inline void multiplyByTwo(const uint64_t* a, uint64_t* out) {
+    out[0] = a[7];
+    out[1] = a[0] ^ a[7];
+    out[2] = a[1];
+    out[3] = a[2] ^ a[7];
+    out[4] = a[3] ^ a[7];
+    out[5] = a[4];
+    out[6] = a[5];
+    out[7] = a[6];
+}
+
+void mixColumns(uint64_t* state) {
+    uint64_t rotated[8], sum[8], doubled[8];
+    for (unsigned k = 0; k < 8; ++k) {
+        rotated[k] = rotateColumn1(state[k]);
+        sum[k] = state[k] ^ rotated[k];
+    }
+
+    multiplyByTwo(sum, doubled);
+    for (unsigned k = 0; k < 8; ++k) {
+        state[k] = doubled[k] ^ rotated[k] ^ rotateColumn2(sum[k]);
+    }
+}
+
+void invMixColumns(uint64_t* state) {
+    //  InvMixColumns is MixColumns after multiplying each column by 4x^2 + 5
+    uint64_t sum[8], doubled[8], quadrupled[8];
+    for (unsigned k = 0; k < 8; ++k) {
+        sum[k] = state[k] ^ rotateColumn2(state[k]);
+    }
+
+    multiplyByTwo(sum, doubled);
+    multiplyByTwo(doubled, quadrupled);
+    for (unsigned k = 0; k < 8; ++k) {
+        state[k] ^= quadrupled[k];
+    }
+
+    mixColumns(state);
+}
+
+inline void addRoundKey(uint64_t* state, const uint64_t* roundKey) {
+    for (unsigned k = 0; k < 8; ++k) {
+        state[k] ^= roundKey[k];
+    }
+}
+
+uint32_t subWordPortable(uint32_t word) {
+    uint8_t block[kCCBlockSizeAES128] = {};
+    storeLittleEndian32(block, word);
+
+    uint64_t state[8];
+    sliceBlocks(block, 1, state);
+    subBytes(state);
+    unsliceBlocks(state, block, 1);
+    return loadLittleEndian32(block);
+}
+
+void prepareAesPortable(AesKey& key) {
+    uint8_t lanes[c_slicedBlocks * kCCBlockSizeAES128];
+    for (unsigned round = 0; round <= key.rounds; ++round) {
+        for (size_t lane = 0; lane < c_slicedBlocks; ++lane) {
+            memcpy(lanes + lane * kCCBlockSizeAES128, key.encrypt + round * kCCBlockSizeAES128, kCCBlockSizeAES128);
+        }
+
+        sliceBlocks(lanes, c_slicedBlocks, key.sliced[round]);
+    }
+
+    secureZero(lanes, sizeof(lanes));
+}
+
+void encryptAesPortable(const AesKey& key, const uint8_t* in, uint8_t* out, size_t blocks) {
+    while (blocks > 0) {
+        const size_t count = std::min(blocks, c_slicedBlocks);
+        uint64_t state[8];
+        sliceBlocks(in, count, state);
+
+        addRoundKey(state, key.sliced[0]);
+        for (unsigned round = 1; round < key.rounds; ++round) {
+            subBytes(state);
+            shiftRows(state, false);
+            mixColumns(state);
+            addRoundKey(state, key.sliced[round]);
+        }
+
+        subBytes(state);
+        shiftRows(state, false);
+        addRoundKey(state, key.sliced[key.rounds]);
+
+        unsliceBlocks(state, out, count);
+        in += count * kCCBlockSizeAES128;
+        out += count * kCCBlockSizeAES128;
+        blocks -= count;
+    }
+}
+
+void decryptAesPortable(const AesKey& key, const uint8_t* in, uint8_t* out, size_t blocks) {
+    while (blocks > 0) {
+        const size_t count = std::min(blocks, c_slicedBlocks);
+        uint64_t state[8];
+        sliceBlocks(in, count, state);
+
+        addRoundKey(state, key.sliced[key.rounds]);
+        for (unsigned round = key.rounds - 1; round > 0; --round) {
+            shiftRows(state, true);
+            invSubBytes(state);
+            addRoundKey(state, key.sliced[round]);
+            invMixColumns(state);
+        }
+
+        shiftRows(state, true);
+        invSubBytes(state);
+        addRoundKey(state, key.sliced[0]);
+
+        unsliceBlocks(state, out, count);
+        in += count * kCCBlockSizeAES128;
+        out += count * kCCBlockSizeAES128;
+        blocks -= count;
+    }
+}
+
+// CBC encryption, which is serial: each block is chained into the next through chain
+template <void (*c_encryptBlocks)(const AesKey&, const uint8_t*, uint8_t*, size_t)>
+void cbcEncryptSerial(const AesKey& key, uint8_t* chain, const uint8_t* in, uint8_t* out, size_t blocks) {
+    for (; blocks > 0; --blocks, in += kCCBlockSizeAES128, out += kCCBlockSizeAES128) {
+        xorBytes(chain, chain, in, kCCBlockSizeAES128);
+        c_encryptBlocks(key, chain, chain, 1);
+        memcpy(out, chain, kCCBlockSizeAES128);
+    }
+}
+
+// Counter mode over whole blocks. The big-endian counter in the last counterBytes of counter (16 for CTR, 4 for GCM)
+// is encrypted and XORed into each block, and is left at the value for the next block.
+template <void (*c_encryptBlocks)(const AesKey&, const uint8_t*, uint8_t*, size_t)>
+void counterModeBatched(const AesKey& key, uint8_t* counter, size_t counterBytes, const uint8_t* in, uint8_t* out, size_t blocks) {
+    uint8_t keystream[c_batchBlocks * kCCBlockSizeAES128];
+    while (blocks > 0) {
+        const size_t count = std::min(blocks, c_batchBlocks);
+        for (size_t i = 0; i < count; ++i) {
+            memcpy(keystream + i * kCCBlockSizeAES128, counter, kCCBlockSizeAES128);
+            incrementBigEndian(counter + kCCBlockSizeAES128 - counterBytes, counterBytes);
+        }
+
+        c_encryptBlocks(key, keystream, keystream, count);
+        xorBytes(out, in, keystream, count * kCCBlockSizeAES128);
+
+        in += count * kCCBlockSizeAES128;
+        out += count * kCCBlockSizeAES128;
+        blocks -= count;
+    }
+
+    secureZero(keystream, sizeof(keystream));
+}
+
+#if (CRYPTOR_X86 == 1)
+CRYPTOR_TARGET("aes") uint32_t subWordAesNi(uint32_t word) {
+    //  With the word in every column ShiftRows has no effect, leaving SubBytes
+    const __m128i column = _mm_set1_epi32(static_cast<int>(word));
+    return static_cast<uint32_t>(_mm_cvtsi128_si32(_mm_aesenclast_si128(column, _mm_setzero_si128())));
+}
+
+CRYPTOR_TARGET("aes") void prepareAesNi(AesKey& key) {
+    const __m128i* encrypt = reinterpret_cast<const __m128i*>(key.encrypt);
+    __m128i* decrypt = reinterpret_cast<__m128i*>(key.decrypt);
+
+    _mm_storeu_si128(decrypt, _mm_loadu_si128(encrypt + key.rounds));
+    for (unsigned round = 1; round < key.rounds; ++round) {
+        _mm_storeu_si128(decrypt + round, _mm_aesimc_si128(_mm_loadu_si128(encrypt + key.rounds - round)));
+    }
+
+    _mm_storeu_si128(decrypt + key.rounds, _mm_loadu_si128(encrypt));
+}
+
+// Every round after the first key addition, on c_count independent blocks
+template <bool c_encrypt, size_t c_count>
+CRYPTOR_TARGET("aes") inline void aesNiRounds(const __m128i* roundKeys, unsigned rounds, __m128i* state) {
+    for (unsigned round = 1; round < rounds; ++round) {
+        for (size_t i = 0; i < c_count; ++i) {
+            state[i] = c_encrypt ? _mm_aesenc_si128(state[i], roundKeys[round]) : _mm_aesdec_si128(state[i], roundKeys[round]);
+        }
+    }
+
+    for (size_t i = 0; i < c_count; ++i) {
+        state[i] = c_encrypt ? _mm_aesenclast_si128(state[i], roundKeys[rounds]) : _mm_aesdeclast_si128(state[i], roundKeys[rounds]);
+    }
+}
+
+template <bool c_encrypt, size_t c_count>
+CRYPTOR_TARGET("aes") inline void aesNiBlocks(const __m128i* roundKeys, unsigned rounds, const uint8_t* in, uint8_t* out) {
+    __m128i state[c_count];
+    for (size_t i = 0; i < c_count; ++i) {
+        state[i] = _mm_xor_si128(_mm_loadu_si128(reinterpret_cast<const __m128i*>(in) + i), roundKeys[0]);
+    }
+
+    aesNiRounds<c_encrypt, c_count>(roundKeys, rounds, state);
+    for (size_t i = 0; i < c_count; ++i) {
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out) + i, state[i]);
+    }
+}
+
+template <bool c_encrypt>
+CRYPTOR_TARGET("aes") void cryptAesNi(const uint8_t* keyBytes, unsigned rounds, const uint8_t* in, uint8_t* out, size_t blocks) {
+    __m128i roundKeys[c_aesMaxRounds + 1];
+    for (unsigned round = 0; round <= rounds; ++round) {
+        roundKeys[round] = _mm_loadu_si128(reinterpret_cast<const __m128i*>(keyBytes) + round);
+    }
+
+    for (; blocks >= c_interleavedBlocks; blocks -= c_interleavedBlocks) {
+        aesNiBlocks<c_encrypt, c_interleavedBlocks>(roundKeys, rounds, in, out);
+        in += c_interleavedBlocks * kCCBlockSizeAES128;
+        out += c_interleavedBlocks * kCCBlockSizeAES128;
+    }
+
+    for (; blocks > 0; --blocks) {
+        aesNiBlocks<c_encrypt, 1>(roundKeys, rounds, in, out);
+        in += kCCBlockSizeAES128;
+        out += kCCBlockSizeAES128;
+    }
+}
+
+void encryptAesNi(const AesKey& key, const uint8_t* in, uint8_t* out, size_t blocks) {
+    cryptAesNi<true>(key.encrypt, key.rounds, in, out, blocks);
+}
+
+void decryptAesNi(const AesKey& key, const uint8_t* in, uint8_t* out, size_t blocks) {
+    cryptAesNi<false>(key.decrypt, key.rounds, in, out, blocks);
+}
+
+// Keeps the chaining value and the round keys in registers for the whole run
+CRYPTOR_TARGET("aes") void cbcEncryptAesNi(const AesKey& key, uint8_t* chain, const uint8_t* in, uint8_t* out, size_t blocks) {
+    __m128i roundKeys[c_aesMaxRounds + 1];
+    for (unsigned round = 0; round <= key.rounds; ++round) {
+        roundKeys[round] = _mm_loadu_si128(reinterpret_cast<const __m128i*>(key.encrypt) + round);
+    }
+
+    __m128i state = _mm_loadu_si128(reinterpret_cast<const __m128i*>(chain));
+    for (; blocks > 0; --blocks, in += kCCBlockSizeAES128, out += kCCBlockSizeAES128) {
+        const __m128i data = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in));
+        state = _mm_xor_si128(_mm_xor_si128(state, data), roundKeys[0]);
+        aesNiRounds<true, 1>(roundKeys, key.rounds, &state);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out), state);
+    }
+
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(chain), state);
+}
+
+// Counter blocks are built in registers from a byte-reversed copy of the counter, which integer adds can step
+template <size_t c_count>
+CRYPTOR_TARGET("aes,ssse3") inline void counterBlocksAesNi(const __m128i* roundKeys,
+                                                           unsigned rounds,
+                                                           size_t counterBytes,
+                                                           __m128i& value,
+                                                           uint64_t& low,
+                                                           const uint8_t* in,
+                                                           uint8_t* out) {
+    const __m128i reverse = _mm_set_epi8(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15);
+    __m128i state[c_count];
+    for (size_t i = 0; i < c_count; ++i) {
+        state[i] = _mm_xor_si128(_mm_shuffle_epi8(value, reverse), roundKeys[0]);
+        if (counterBytes == 4) {
+            value = _mm_add_epi32(value, _mm_set_epi32(0, 0, 0, 1));
+        } else {
+            value = _mm_add_epi64(value, _mm_set_epi32(0, 0, 0, 1));
+            if (++low == 0) {
+                value = _mm_add_epi64(value, _mm_set_epi32(0, 1, 0, 0));
+            }
+        }
+    }
+
+    aesNiRounds<true, c_count>(roundKeys, rounds, state);
+    for (size_t i = 0; i < c_count; ++i) {
+        const __m128i data = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in) + i);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out) + i, _mm_xor_si128(data, state[i]));
+    }
+}
+
+CRYPTOR_TARGET("aes,ssse3")
+void counterModeAesNi(const AesKey& key, uint8_t* counter, size_t counterBytes, const uint8_t* in, uint8_t* out, size_t blocks) {
+    __m128i roundKeys[c_aesMaxRounds + 1];
+    for (unsigned round = 0; round <= key.rounds; ++round) {
+        roundKeys[round] = _mm_loadu_si128(reinterpret_cast<const __m128i*>(key.encrypt) + round);
+    }
+
+    const __m128i reverse = _mm_set_epi8(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15);
+    __m128i value = _mm_shuffle_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(counter)), reverse);
+    uint64_t low = loadBigEndian64(counter + 8);
+
+    for (; blocks >= c_interleavedBlocks; blocks -= c_interleavedBlocks) {
+        counterBlocksAesNi<c_interleavedBlocks>(roundKeys, key.rounds, counterBytes, value, low, in, out);
+        in += c_interleavedBlocks * kCCBlockSizeAES128;
+        out += c_interleavedBlocks * kCCBlockSizeAES128;
+    }
+
+    for (; blocks > 0; --blocks) {
+        counterBlocksAesNi<1>(roundKeys, key.rounds, counterBytes, value, low, in, out);
+        in += kCCBlockSizeAES128;
+        out += kCCBlockSizeAES128;
+    }
+
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(counter), _mm_shuffle_epi8(value, reverse));
+}
+#endif
+
+#if (CRYPTOR_ARM == 1)
+uint32_t subWordArm(uint32_t word) {
+    //  With the word in every column ShiftRows has no effect, leaving SubBytes
+    const uint8x16_t column = vreinterpretq_u8_u32(vdupq_n_u32(word));
+    return vgetq_lane_u32(vreinterpretq_u32_u8(vaeseq_u8(column, vdupq_n_u8(0))), 0);
+}
+
+void prepareAesArm(AesKey& key) {
+    vst1q_u8(key.decrypt, vld1q_u8(key.encrypt + key.rounds * kCCBlockSizeAES128));
+    for (unsigned round = 1; round < key.rounds; ++round) {
+        vst1q_u8(key.decrypt + round * kCCBlockSizeAES128, vaesimcq_u8(vld1q_u8(key.encrypt + (key.rounds - round) * kCCBlockSizeAES128)));
+    }
+
+    vst1q_u8(key.decrypt + key.rounds * kCCBlockSizeAES128, vld1q_u8(key.encrypt));
+}
+
+template <bool c_encrypt>
+void cryptAesArm(const uint8_t* keyBytes, unsigned rounds, const uint8_t* in, uint8_t* out, size_t blocks) {
+    uint8x16_t roundKeys[c_aesMaxRounds + 1];
+    for (unsigned round = 0; round <= rounds; ++round) {
+        roundKeys[round] = vld1q_u8(keyBytes + round * kCCBlockSizeAES128);
+    }
+
+    while (blocks > 0) {
+        const size_t count = std::min(blocks, c_interleavedBlocks);
+        uint8x16_t state[c_interleavedBlocks];
+        for (size_t i = 0; i < count; ++i) {
+            state[i] = vld1q_u8(in + i * kCCBlockSizeAES128);
+        }
+
+        for (unsigned round = 0; round + 1 < rounds; ++round) {
+            for (size_t i = 0; i < count; ++i) {
+                state[i] = c_encrypt ? vaesmcq_u8(vaeseq_u8(state[i], roundKeys[round])) :
+                                       vaesimcq_u8(vaesdq_u8(state[i], roundKeys[round]));
+            }
+        }
+
+        for (size_t i = 0; i < count; ++i) {
+            state[i] = c_encrypt ? vaeseq_u8(state[i], roundKeys[rounds - 1]) : vaesdq_u8(state[i], roundKeys[rounds - 1]);
+            vst1q_u8(out + i * kCCBlockSizeAES128, veorq_u8(state[i], roundKeys[rounds]));
+        }
+
+        in += count * kCCBlockSizeAES128;
+        out += count * kCCBlockSizeAES128;
+        blocks -= count;
+    }
+}
+
+void encryptAesArm(const AesKey& key, const uint8_t* in, uint8_t* out, size_t blocks) {
+    cryptAesArm<true>(key.encrypt, key.rounds, in, out, blocks);
+}
+
+void decryptAesArm(const AesKey& key, const uint8_t* in, uint8_t* out, size_t blocks) {
+    cryptAesArm<false>(key.decrypt, key.rounds, in, out, blocks);
+}
+#endif
+
+struct AesImplementation {
+    uint32_t (*subWord)(uint32_t word);
+    void (*prepare)(AesKey& key);
+    void (*encrypt)(const AesKey& key, const uint8_t* in, uint8_t* out, size_t blocks);
+    void (*decrypt)(const AesKey& key, const uint8_t* in, uint8_t* out, size_t blocks);
+    void (*cbcEncrypt)(const AesKey& key, uint8_t* chain, const uint8_t* in, uint8_t* out, size_t blocks);
+    void (*counterMode)(const AesKey& key, uint8_t* counter, size_t counterBytes, const uint8_t* in, uint8_t* out, size_t blocks);
+};
+
+AesImplementation selectAes() {
+#if (CRYPTOR_X86 == 1)
+    if (c_aesNi) {
+        return { subWordAesNi, prepareAesNi, encryptAesNi, decryptAesNi, cbcEncryptAesNi, counterModeAesNi };
+    }
+#elif (CRYPTOR_ARM == 1)
+    if (c_armAes) {
+        return {
+            subWordArm, prepareAesArm, encryptAesArm, decryptAesArm, cbcEncryptSerial<encryptAesArm>, counterModeBatched<encryptAesArm>
+        };
+    }
+#endif
+    return { subWordPortable,
+             prepareAesPortable,
+             encryptAesPortable,
+             decryptAesPortable,
+             cbcEncryptSerial<encryptAesPortable>,
+             counterModeBatched<encryptAesPortable> };
+}
+
+const AesImplementation c_aes = selectAes();
+
+bool isAesKeyLength(size_t keyLength) {
+    return keyLength == kCCKeySizeAES128 || keyLength == kCCKeySizeAES192 || keyLength == kCCKeySizeAES256;
+}
+
+void expandAesKey(const uint8_t* keyBytes, size_t keyLength, AesKey& key) {
+    //  FIPS-197 key expansion, on words that hold their bytes in little-endian order
+    const size_t keyWords = keyLength / 4;
+    key.rounds = static_cast<unsigned>(keyWords + 6);
+    const size_t totalWords = 4 * (key.rounds + 1);
+
+    uint32_t words[4 * (c_aesMaxRounds + 1)];
+    for (size_t i = 0; i < keyWords; ++i) {
+        words[i] = loadLittleEndian32(keyBytes + i * 4);
+    }
+
+    uint32_t roundConstant = 1;
+    for (size_t i = keyWords; i < totalWords; ++i) {
+        uint32_t temp = words[i - 1];
+        if (i % keyWords == 0) {
+            temp = c_aes.subWord((temp >> 8) | (temp << 24)) ^ roundConstant;
+            roundConstant = ((roundConstant << 1) ^ (0x11b & (0 - (roundConstant >> 7)))) & 0xff;
+        } else if (keyWords > 6 && i % keyWords == 4) {
+            temp = c_aes.subWord(temp);
+        }
+
+        words[i] = words[i - keyWords] ^ temp;
+    }
+
+    for (size_t i = 0; i < totalWords; ++i) {
+        storeLittleEndian32(key.encrypt + i * 4, words[i]);
+    }
+
+    secureZero(words, sizeof(words));
+    c_aes.prepare(key);
+}
+
+#pragma endregion
+
+#pragma region GHASH
+
+// H for GHASH. The portable multiply works on big-endian halves; the carry-less multiply path keeps H^1..H^4
+// byte-reflected so that four blocks share one reduction.
+struct GhashKey {
+    uint64_t high;
+    uint64_t low;
+    uint8_t powers[4][kCCBlockSizeAES128];
+};
+
+// Y = Y * H in GF(2^128), one bit at a time with masks rather than branches
+void ghashMultiplyPortable(uint64_t& yHigh, uint64_t& yLow, uint64_t hHigh, uint64_t hLow) {
+    uint64_t zHigh = 0;
+    uint64_t zLow = 0;
+    uint64_t vHigh = hHigh;
+    uint64_t vLow = hLow;
+
+    for (unsigned i = 0; i < 128; ++i) {
+        const uint64_t bit = (i < 64) ? (yHigh >> (63 - i)) & 1 : (yLow >> (127 - i)) & 1;
+        const uint64_t mask = 0 - bit;
+        zHigh ^= vHigh & mask;
+        zLow ^= vLow & mask;
+
+        const uint64_t carry = 0 - (vLow & 1);
+        vLow = (vLow >> 1) | (vHigh << 63);
+        vHigh = (vHigh >> 1) ^ (0xe100000000000000ULL & carry);
+    }
+
+    yHigh = zHigh;
+    yLow = zLow;
+}
+
+void ghashPortable(const GhashKey& key, uint8_t* y, const uint8_t* data, size_t blocks) {
+    uint64_t yHigh = loadBigEndian64(y);
+    uint64_t yLow = loadBigEndian64(y + 8);
+
+    for (; blocks > 0; --blocks, data += kCCBlockSizeAES128) {
+        yHigh ^= loadBigEndian64(data);
+        yLow ^= loadBigEndian64(data + 8);
+        ghashMultiplyPortable(yHigh, yLow, key.high, key.low);
+    }
+
+    storeBigEndian64(y, yHigh);
+    storeBigEndian64(y + 8, yLow);
+}
+
+void prepareGhashPortable(GhashKey& key) {
+    (void)key;
+}
+
+#if (CRYPTOR_X86 == 1)
+CRYPTOR_TARGET("pclmul,ssse3") inline __m128i byteReverse(__m128i value) {
+    return _mm_shuffle_epi8(value, _mm_set_epi8(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15));
+}
+
+// The 256 bit carry-less product of two byte-reflected elements, before reduction
+CRYPTOR_TARGET("pclmul,ssse3") inline void clmulProduct(__m128i a, __m128i b, __m128i& low, __m128i& high) {
+    const __m128i middle = _mm_xor_si128(_mm_clmulepi64_si128(a, b, 0x10), _mm_clmulepi64_si128(a, b, 0x01));
+    low = _mm_xor_si128(_mm_clmulepi64_si128(a, b, 0x00), _mm_slli_si128(middle, 8));
+    high = _mm_xor_si128(_mm_clmulepi64_si128(a, b, 0x11), _mm_srli_si128(middle, 8));
+}
+
+// Reduces a product modulo x^128 + x^7 + x^2 + x + 1, following Intel's carry-less multiplication white paper
+CRYPTOR_TARGET("pclmul,ssse3") inline __m128i clmulReduce(__m128i low, __m128i high) {
+    //  Shift the product left by one bit to account for the reflected bit order
+    __m128i carryLow = _mm_srli_epi32(low, 31);
+    __m128i carryHigh = _mm_srli_epi32(high, 31);
+    low = _mm_slli_epi32(low, 1);
+    high = _mm_slli_epi32(high, 1);
+
+    const __m128i crossing = _mm_srli_si128(carryLow, 12);
+    carryHigh = _mm_slli_si128(carryHigh, 4);
+    carryLow = _mm_slli_si128(carryLow, 4);
+    low = _mm_or_si128(low, carryLow);
+    high = _mm_or_si128(_mm_or_si128(high, carryHigh), crossing);
+
+    __m128i first = _mm_xor_si128(_mm_xor_si128(_mm_slli_epi32(low, 31), _mm_slli_epi32(low, 30)), _mm_slli_epi32(low, 25));
+    const __m128i firstHigh = _mm_srli_si128(first, 4);
+    first = _mm_slli_si128(first, 12);
+    low = _mm_xor_si128(low, first);
+
+    __m128i second = _mm_xor_si128(_mm_xor_si128(_mm_srli_epi32(low, 1), _mm_srli_epi32(low, 2)), _mm_srli_epi32(low, 7));
+    second = _mm_xor_si128(second, firstHigh);
+    low = _mm_xor_si128(low, second);
+    return _mm_xor_si128(high, low);
+}
+
+CRYPTOR_TARGET("pclmul,ssse3") inline __m128i clmulMultiply(__m128i a, __m128i b) {
+    __m128i low, high;
+    clmulProduct(a, b, low, high);
+    return clmulReduce(low, high);
+}
+
+CRYPTOR_TARGET("pclmul,ssse3") void prepareGhashClmul(GhashKey& key) {
+    uint8_t h[kCCBlockSizeAES128];
+    storeBigEndian64(h, key.high);
+    storeBigEndian64(h + 8, key.low);
+
+    const __m128i h1 = byteReverse(_mm_loadu_si128(reinterpret_cast<const __m128i*>(h)));
+    __m128i power = h1;
+    for (size_t i = 0; i < 4; ++i) {
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(key.powers[i]), power);
+        power = clmulMultiply(power, h1);
+    }
+
+    secureZero(h, sizeof(h));
+}
+
+CRYPTOR_TARGET("pclmul,ssse3") void ghashClmul(const GhashKey& key, uint8_t* y, const uint8_t* data, size_t blocks) {
+    const __m128i h1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(key.powers[0]));
+    const __m128i h2 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(key.powers[1]));
+    const __m128i h3 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(key.powers[2]));
+    const __m128i h4 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(key.powers[3]));
+    const __m128i* input = reinterpret_cast<const __m128i*>(data);
+
+    __m128i state = byteReverse(_mm_loadu_si128(reinterpret_cast<const __m128i*>(y)));
+
+    //  (Y + X1)H^4 + X2 H^3 + X3 H^2 + X4 H, reduced once
+    for (; blocks >= 4; blocks -= 4, input += 4) {
+        __m128i low, high, productLow, productHigh;
+        clmulProduct(_mm_xor_si128(state, byteReverse(_mm_loadu_si128(input))), h4, low, high);
+        clmulProduct(byteReverse(_mm_loadu_si128(input + 1)), h3, productLow, productHigh);
+        low = _mm_xor_si128(low, productLow);
+        high = _mm_xor_si128(high, productHigh);
+        clmulProduct(byteReverse(_mm_loadu_si128(input + 2)), h2, productLow, productHigh);
+        low = _mm_xor_si128(low, productLow);
+        high = _mm_xor_si128(high, productHigh);
+        clmulProduct(byteReverse(_mm_loadu_si128(input + 3)), h1, productLow, productHigh);
+        low = _mm_xor_si128(low, productLow);
+        high = _mm_xor_si128(high, productHigh);
+        state = clmulReduce(low, high);
+    }
+
+    for (; blocks > 0; --blocks, ++input) {
+        state = clmulMultiply(_mm_xor_si128(state, byteReverse(_mm_loadu_si128(input))), h1);
+    }
+
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(y), byteReverse(state));
+}
+#endif
+
+struct GhashImplementation {
+    void (*prepare)(GhashKey& key);
+    void (*update)(const GhashKey& key, uint8_t* y, const uint8_t* data, size_t blocks);
+};
+
+GhashImplementation selectGhash() {
+#if (CRYPTOR_X86 == 1)
+    if (c_aesNi) {
+        return { prepareGhashClmul, ghashClmul };
+    }
+#endif
+    return { prepareGhashPortable, ghashPortable };
+}
+
+const GhashImplementation c_ghash = selectGhash();
+
+// Hashes data into y, zero padding a trailing partial block
+void ghashPadded(const GhashKey& key, uint8_t* y, const uint8_t* data, size_t length) {
+    const size_t blocks = length / kCCBlockSizeAES128;
+    c_ghash.update(key, y, data, blocks);
+
+    const size_t tail = length % kCCBlockSizeAES128;
+    if (tail > 0) {
+        uint8_t last[kCCBlockSizeAES128] = {};
+        memcpy(last, data + blocks * kCCBlockSizeAES128, tail);
+        c_ghash.update(key, y, last, 1);
+    }
+}
+
+#pragma endregion
+
+#pragma region DES
+
+const uint8_t c_desInitialPermutation[64] = {
+    58, 50, 42, 34, 26, 18, 10, 2, 60, 52, 44, 36, 28, 20, 12, 4, 62, 54, 46, 38, 30, 22, 14, 6, 64, 56, 48, 40, 32, 24, 16, 8,
+    57, 49, 41, 33, 25, 17, 9,  1, 59, 51, 43, 35, 27, 19, 11, 3, 61, 53, 45, 37, 29, 21, 13, 5, 63, 55, 47, 39, 31, 23, 15, 7,
+};
+
+const uint8_t c_desFinalPermutation[64] = {
+    40, 8, 48, 16, 56, 24, 64, 32, 39, 7, 47, 15, 55, 23, 63, 31, 38, 6, 46, 14, 54, 22, 62, 30, 37, 5, 45, 13, 53, 21, 61, 29,
+    36, 4, 44, 12, 52, 20, 60, 28, 35, 3, 43, 11, 51, 19, 59, 27, 34, 2, 42, 10, 50, 18, 58, 26, 33, 1, 41, 9,  49, 17, 57, 25,
+};
+
+const uint8_t c_desExpansion[48] = {
+    32, 1,  2,  3,  4,  5,  4,  5,  6,  7,  8,  9,  8,  9,  10, 11, 12, 13, 12, 13, 14, 15, 16, 17,
+    16, 17, 18, 19, 20, 21, 20, 21, 22, 23, 24, 25, 24, 25, 26, 27, 28, 29, 28, 29, 30, 31, 32, 1,
+};
+
+const uint8_t c_desPermutation[32] = {
+    16, 7, 20, 21, 29, 12, 28, 17, 1, 15, 23, 26, 5, 18, 31, 10, 2, 8, 24, 14, 32, 27, 3, 9, 19, 13, 30, 6, 22, 11, 4, 25,
+};
+
+const uint8_t c_desPermutedChoice1[56] = {
+    57, 49, 41, 33, 25, 17, 9,  1,  58, 50, 42, 34, 26, 18, 10, 2,  59, 51, 43, 35, 27, 19, 11, 3,  60, 52, 44, 36,
+    63, 55, 47, 39, 31, 23, 15, 7,  62, 54, 46, 38, 30, 22, 14, 6,  61, 53, 45, 37, 29, 21, 13, 5,  28, 20, 12, 4,
+};
+
+const uint8_t c_desPermutedChoice2[48] = {
+    14, 17, 11, 24, 1,  5,  3,  28, 15, 6,  21, 10, 23, 19, 12, 4,  26, 8,  16, 7,  27, 20, 13, 2,
+    41, 52, 31, 37, 47, 55, 30, 40, 51, 45, 33, 48, 44, 49, 39, 56, 34, 53, 46, 42, 50, 36, 29, 32,
+};
+
+const uint8_t c_desKeyShifts[16] = { 1, 1, 2, 2, 2, 2, 2, 2, 1, 2, 2, 2, 2, 2, 2, 1 };
+
+const uint8_t c_desSubstitution[8][64] = {
+    { 14, 4,  13, 1, 2,  15, 11, 8,  3,  10, 6,  12, 5,  9,  0, 7, 0, 15, 7,  4,  14, 2,  13, 1,  10, 6, 12, 11, 9,  5,  3,  8,
+      4,  1,  14, 8, 13, 6,  2,  11, 15, 12, 9,  7,  3,  10, 5, 0, 15, 12, 8, 2,  4,  9,  1,  7,  5,  11, 3, 14, 10, 0, 6,  13 },
+    { 15, 1,  8,  14, 6,  11, 3,  4,  9,  7, 2,  13, 12, 0, 5,  10, 3,  13, 4, 7,  15, 2,  8,  14, 12, 0, 1,  10, 6,  9,  11, 5,
+      0,  14, 7,  11, 10, 4,  13, 1,  5,  8, 12, 6,  9,  3, 2,  15, 13, 8,  10, 1, 3,  15, 4,  2,  11, 6, 7,  12, 0,  5,  14, 9 },
+    { 10, 0,  9,  14, 6, 3,  15, 5,  1,  13, 12, 7,  11, 4,  2,  8,  13, 7,  0, 9,  3,  4,  6,  10, 2,  8,  5,  14, 12, 11, 15, 1,
+      13, 6,  4,  9,  8, 15, 3,  0,  11, 1,  2,  12, 5,  10, 14, 7,  1,  10, 13, 0, 6,  9,  8,  7,  4,  15, 14, 3,  11, 5,  2,  12 },
+    { 7,  13, 14, 3,  0,  6,  9,  10, 1,  2,  8,  5,  11, 12, 4,  15, 13, 8,  11, 5,  6,  15, 0,  3,  4,  7, 2,  12, 1,  10, 14, 9,
+      10, 6,  9,  0,  12, 11, 7,  13, 15, 1,  3,  14, 5,  2,  8,  4,  3,  15, 0,  6,  10, 1,  13, 8,  9,  4, 5,  11, 12, 7,  2,  14 },
+    { 2,  12, 4,  1,  7,  10, 11, 6,  8,  5,  3,  15, 13, 0, 14, 9,  14, 11, 2,  12, 4,  7,  13, 1,  5,  0,  15, 10, 3,  9, 8,  6,
+      4,  2,  1,  11, 10, 13, 7,  8,  15, 9,  12, 5,  6,  3, 0,  14, 11, 8,  12, 7,  1,  14, 2,  13, 6,  15, 0,  9,  10, 4, 5,  3 },
+    { 12, 1,  10, 15, 9, 2,  6,  8,  0,  13, 3,  4,  14, 7,  5,  11, 10, 15, 4,  2,  7,  12, 9,  5,  6,  1,  13, 14, 0,  11, 3, 8,
+      9,  14, 15, 5,  2, 8,  12, 3,  7,  0,  4,  10, 1,  13, 11, 6,  4,  3,  2,  12, 9,  5,  15, 10, 11, 14, 1,  7,  6,  0,  8, 13 },
+    { 4,  11, 2,  14, 15, 0, 8,  13, 3,  12, 9, 7,  5,  10, 6, 1,  13, 0,  11, 7,  4,  9,  1,  10, 14, 3,  5,  12, 2,  15, 8,  6,
+      1,  4,  11, 13, 12, 3, 7,  14, 10, 15, 6, 8,  0,  5,  9, 2,  6,  11, 13, 8,  1,  4,  10, 7,  9,  5,  0,  15, 14, 2,  3,  12 },
+    { 13, 2,  8,  4, 6,  15, 11, 1,  10, 9,  3,  14, 5,  0,  12, 7,  1,  15, 13, 8,  10, 3,  7,  4,  12, 5,  6,  11, 0,  14, 9,  2,
+      7,  11, 4,  1, 9,  12, 14, 2,  0,  6,  10, 13, 15, 3,  5,  8,  2,  1,  14, 7,  4,  10, 8,  13, 15, 12, 9,  0,  3,  5,  6,  11 },
+};
+
+// Permutes the bits of input; table entries number the input bits from 1 at the most significant end
+uint64_t desPermute(uint64_t input, const uint8_t* table, size_t outputBits, size_t inputBits) {
+    uint64_t output = 0;
+    for (size_t i = 0; i < outputBits; ++i) {
+        output = (output << 1) | ((input >> (inputBits - table[i])) & 1);
+    }
+
+    return output;
+}
+
+void desKeySchedule(const uint8_t* keyBytes, uint64_t* subkeys) {
+    const uint64_t choice = desPermute(loadBigEndian64(keyBytes), c_desPermutedChoice1, 56, 64);
+    uint32_t c = static_cast<uint32_t>(choice >> 28);
+    uint32_t d = static_cast<uint32_t>(choice & 0xfffffff);
+
+    for (size_t round = 0; round < 16; ++round) {
+        const unsigned shift = c_desKeyShifts[round];
+        c = ((c << shift) | (c >> (28 - shift))) & 0xfffffff;
+        d = ((d << shift) | (d >> (28 - shift))) & 0xfffffff;
+        subkeys[round] = desPermute((static_cast<uint64_t>(c) << 28) | d, c_desPermutedChoice2, 48, 56);
+    }
+}
+
+uint32_t desFeistel(uint32_t half, uint64_t subkey) {
+    const uint64_t expanded = desPermute(half, c_desExpansion, 48, 32) ^ subkey;
+
+    uint32_t substituted = 0;
+    for (size_t box = 0; box < 8; ++box) {
+        const unsigned six = static_cast<unsigned>(expanded >> (42 - 6 * box)) & 0x3f;
+        const unsigned row = ((six & 0x20) >> 4) | (six & 1);
+        const unsigned column = (six >> 1) & 0xf;
+        substituted = (substituted << 4) | c_desSubstitution[box][row * 16 + column];
+    }
+
+    return static_cast<uint32_t>(desPermute(substituted, c_desPermutation, 32, 32));
+}
+
+uint64_t desBlock(uint64_t block, const uint64_t* subkeys, bool decrypt) {
+    block = desPermute(block, c_desInitialPermutation, 64, 64);
+    uint32_t left = static_cast<uint32_t>(block >> 32);
+    uint32_t right = static_cast<uint32_t>(block);
+
+    for (size_t round = 0; round < 16; ++round) {
+        const uint32_t next = left ^ desFeistel(right, subkeys[decrypt ? 15 - round : round]);
+        left = right;
+        right = next;
+    }
+
+    return desPermute((static_cast<uint64_t>(right) << 32) | left, c_desFinalPermutation, 64, 64);
+}
+
+#pragma endregion
+
+#pragma region RC2
+
+// RFC 2268
+const uint8_t c_rc2PiTable[256] = {
+    0xd9, 0x78, 0xf9, 0xc4, 0x19, 0xdd, 0xb5, 0xed, 0x28, 0xe9, 0xfd, 0x79, 0x4a, 0xa0, 0xd8, 0x9d, 0xc6, 0x7e, 0x37, 0x83, 0x2b, 0x76,
+    0x53, 0x8e, 0x62, 0x4c, 0x64, 0x88, 0x44, 0x8b, 0xfb, 0xa2, 0x17, 0x9a, 0x59, 0xf5, 0x87, 0xb3, 0x4f, 0x13, 0x61, 0x45, 0x6d, 0x8d,
+    0x09, 0x81, 0x7d, 0x32, 0xbd, 0x8f, 0x40, 0xeb, 0x86, 0xb7, 0x7b, 0x0b, 0xf0, 0x95, 0x21, 0x22, 0x5c, 0x6b, 0x4e, 0x82, 0x54, 0xd6,
+    0x65, 0x93, 0xce, 0x60, 0xb2, 0x1c, 0x73, 0x56, 0xc0, 0x14, 0xa7, 0x8c, 0xf1, 0xdc, 0x12, 0x75, 0xca, 0x1f, 0x3b, 0xbe, 0xe4, 0xd1,
+    0x42, 0x3d, 0xd4, 0x30, 0xa3, 0x3c, 0xb6, 0x26, 0x6f, 0xbf, 0x0e, 0xda, 0x46, 0x69, 0x07, 0x57, 0x27, 0xf2, 0x1d, 0x9b, 0xbc, 0x94,
+    0x43, 0x03, 0xf8, 0x11, 0xc7, 0xf6, 0x90, 0xef, 0x3e, 0xe7, 0x06, 0xc3, 0xd5, 0x2f, 0xc8, 0x66, 0x1e, 0xd7, 0x08, 0xe8, 0xea, 0xde,
+    0x80, 0x52, 0xee, 0xf7, 0x84, 0xaa, 0x72, 0xac, 0x35, 0x4d, 0x6a, 0x2a, 0x96, 0x1a, 0xd2, 0x71, 0x5a, 0x15, 0x49, 0x74, 0x4b, 0x9f,
+    0xd0, 0x5e, 0x04, 0x18, 0xa4, 0xec, 0xc2, 0xe0, 0x41, 0x6e, 0x0f, 0x51, 0xcb, 0xcc, 0x24, 0x91, 0xaf, 0x50, 0xa1, 0xf4, 0x70, 0x39,
+    0x99, 0x7c, 0x3a, 0x85, 0x23, 0xb8, 0xb4, 0x7a, 0xfc, 0x02, 0x36, 0x5b, 0x25, 0x55, 0x97, 0x31, 0x2d, 0x5d, 0xfa, 0x98, 0xe3, 0x8a,
+    0x92, 0xae, 0x05, 0xdf, 0x29, 0x10, 0x67, 0x6c, 0xba, 0xc9, 0xd3, 0x00, 0xe6, 0xcf, 0xe1, 0x9e, 0xa8, 0x2c, 0x63, 0x16, 0x01, 0x3f,
+    0x58, 0xe2, 0x89, 0xa9, 0x0d, 0x38, 0x34, 0x1b, 0xab, 0x33, 0xff, 0xb0, 0xbb, 0x48, 0x0c, 0x5f, 0xb9, 0xb1, 0xcd, 0x2e, 0xc5, 0xf3,
+    0xdb, 0x47, 0xe5, 0xa5, 0x9c, 0x77, 0x0a, 0xa6, 0x20, 0x68, 0xfe, 0x7f, 0xc1, 0xad,
+};
+
+// The effective key length is the full key length, as on the reference platform
+void rc2KeySchedule(const uint8_t* keyBytes, size_t keyLength, uint16_t* subkeys) {
+    uint8_t expanded[128];
+    memcpy(expanded, keyBytes, keyLength);
+
+    for (size_t i = keyLength; i < 128; ++i) {
+        expanded[i] = c_rc2PiTable[(expanded[i - 1] + expanded[i - keyLength]) & 0xff];
+    }
+
+    const size_t effectiveBits = keyLength * 8;
+    const size_t effectiveBytes = (effectiveBits + 7) / 8;
+    const unsigned mask = 0xff >> (8 * effectiveBytes - effectiveBits);
+    expanded[128 - effectiveBytes] = c_rc2PiTable[expanded[128 - effectiveBytes] & mask];
+
+    for (size_t i = 128 - effectiveBytes; i > 0; --i) {
+        expanded[i - 1] = c_rc2PiTable[expanded[i] ^ expanded[i - 1 + effectiveBytes]];
+    }
+
+    for (size_t i = 0; i < 64; ++i) {
+        subkeys[i] = loadLittleEndian16(expanded + 2 * i);
+    }
+
+    secureZero(expanded, sizeof(expanded));
+}
+
+const unsigned c_rc2Rotations[4] = { 1, 2, 3, 5 };
+
+void rc2Encrypt(const uint16_t* subkeys, const uint8_t* in, uint8_t* out) {
+    uint16_t r[4];
+    for (size_t i = 0; i < 4; ++i) {
+        r[i] = loadLittleEndian16(in + 2 * i);
+    }
+
+    size_t j = 0;
+    for (unsigned round = 0; round < 16; ++round) {
+        for (size_t i = 0; i < 4; ++i) {
+            const unsigned mixed = r[i] + subkeys[j++] + (r[(i + 3) % 4] & r[(i + 2) % 4]) + (~r[(i + 3) % 4] & r[(i + 1) % 4]);
+            const unsigned word = mixed & 0xffff;
+            r[i] = static_cast<uint16_t>((word << c_rc2Rotations[i]) | (word >> (16 - c_rc2Rotations[i])));
+        }
+
+        //  Mashing rounds follow the fifth and eleventh mixing rounds
+        if (round == 4 || round == 10) {
+            for (size_t i = 0; i < 4; ++i) {
+                r[i] = static_cast<uint16_t>(r[i] + subkeys[r[(i + 3) % 4] & 63]);
+            }
+        }
+    }
+
+    for (size_t i = 0; i < 4; ++i) {
+        storeLittleEndian16(out + 2 * i, r[i]);
+    }
+}
+
+void rc2Decrypt(const uint16_t* subkeys, const uint8_t* in, uint8_t* out) {
+    uint16_t r[4];
+    for (size_t i = 0; i < 4; ++i) {
+        r[i] = loadLittleEndian16(in + 2 * i);
+    }
+
+    size_t j = 64;
+    for (unsigned round = 16; round > 0; --round) {
+        for (size_t i = 4; i > 0; --i) {
+            const unsigned word = r[i - 1];
+            const unsigned rotated = ((word >> c_rc2Rotations[i - 1]) | (word << (16 - c_rc2Rotations[i - 1]))) & 0xffff;
+            const unsigned mixed = subkeys[--j] + (r[(i + 2) % 4] & r[(i + 1) % 4]) + (~r[(i + 2) % 4] & r[i % 4]);
+            r[i - 1] = static_cast<uint16_t>(rotated - mixed);
+        }
+
+        if (round == 12 || round == 6) {
+            for (size_t i = 4; i > 0; --i) {
+                r[i - 1] = static_cast<uint16_t>(r[i - 1] - subkeys[r[(i + 2) % 4] & 63]);
+            }
+        }
+    }
+
+    for (size_t i = 0; i < 4; ++i) {
+        storeLittleEndian16(out + 2 * i, r[i]);
+    }
+}
+
+#pragma endregion
+
+#pragma region RC4
+
+struct Rc4State {
+    uint8_t s[256];
+    uint8_t i;
+    uint8_t j;
+};
+
+void rc4KeySchedule(const uint8_t* keyBytes, size_t keyLength, Rc4State& state) {
+    for (size_t i = 0; i < 256; ++i) {
+        state.s[i] = static_cast<uint8_t>(i);
+    }
+
+    uint8_t j = 0;
+    for (size_t i = 0; i < 256; ++i) {
+        j = static_cast<uint8_t>(j + state.s[i] + keyBytes[i % keyLength]);
+        std::swap(state.s[i], state.s[j]);
+    }
+
+    state.i = 0;
+    state.j = 0;
+}
+
+void rc4Crypt(Rc4State& state, const uint8_t* in, uint8_t* out, size_t length) {
+    uint8_t i = state.i;
+    uint8_t j = state.j;
+    for (size_t n = 0; n < length; ++n) {
+        i = static_cast<uint8_t>(i + 1);
+        j = static_cast<uint8_t>(j + state.s[i]);
+        std::swap(state.s[i], state.s[j]);
+        out[n] = in[n] ^ state.s[static_cast<uint8_t>(state.s[i] + state.s[j])];
+    }
+
+    state.i = i;
+    state.j = j;
+}
+
+#pragma endregion
+
+CCCryptorStatus validateKey(CCAlgorithm alg, const void* key, size_t keyLength) {
+    switch (alg) {
+        case kCCAlgorithmAES:
+            return (key && isAesKeyLength(keyLength)) ? kCCSuccess : kCCParamError;
+        case kCCAlgorithmDES:
+            return (key && keyLength == kCCKeySizeDES) ? kCCSuccess : kCCParamError;
+        case kCCAlgorithm3DES:
+            return (key && keyLength == kCCKeySize3DES) ? kCCSuccess : kCCParamError;
+        case kCCAlgorithmRC4:
+            return (key && keyLength >= kCCKeySizeMinRC4 && keyLength <= kCCKeySizeMaxRC4) ? kCCSuccess : kCCParamError;
+        case kCCAlgorithmRC2:
+            return (key && keyLength >= kCCKeySizeMinRC2 && keyLength <= kCCKeySizeMaxRC2) ? kCCSuccess : kCCParamError;
+        case kCCAlgorithmCAST:
+        case kCCAlgorithmBlowfish:
             return kCCUnimplemented;
-        case SEC_E_BUFFER_TOO_SMALL:
-            return kCCBufferTooSmall;
-        case SEC_E_CANNOT_PACK:
-            return kCCAlignmentError;
-        case CRYPT_E_BAD_ENCODE:
-            return kCCDecodeError;
-        case S_OK:
-            return kCCSuccess;
         default:
-            // In case of some other HRESULT, hand that back to the caller without translating.
-            LOG_HR_MSG(result, "Unable to translate HRESULT to CCCryptorStatus.");
-            break;
+            return kCCParamError;
     }
-
-    return result;
 }
 
+} // namespace
+
+// All state lives inline, so that one-shot calls can keep it on the stack
 struct CC_Cryptor_State {
-    CC_Cryptor_State(CCOperation op, CCAlgorithm alg, CCOptions options, const void* key, size_t keyLength, const void* iv)
-        : _op(op),
-          _alg(alg),
-          _options(options),
-          _key(key),
-          _keyLength(keyLength),
-          _blockSize(0),
-          _iv(iv),
-          _ivBuffer(nullptr),
-          _inputBuffer() {
-        if (_alg == kCCAlgorithmAES) {
-            _blockSize = 16;
-        } else if (_alg == kCCAlgorithmRC4) {
-            _blockSize = 1;
-        } else {
-            _blockSize = 8;
+    CCCryptorStatus init(CCOperation op, CCMode mode, CCAlgorithm alg, bool padding, const void* key, size_t keyLength, const void* iv) {
+        memset(this, 0, sizeof(*this));
+
+        if (op != kCCEncrypt && op != kCCDecrypt) {
+            return kCCParamError;
         }
-    }
 
-    ~CC_Cryptor_State() {
-    }
+        const CCCryptorStatus keyStatus = validateKey(alg, key, keyLength);
+        if (keyStatus != kCCSuccess) {
+            return keyStatus;
+        }
+
+        if ((alg == kCCAlgorithmRC4) != (mode == kCCModeRC4)) {
+            return kCCParamError;
+        }
 
-    static std::unique_ptr<CC_Cryptor_State> init(
-        CCOperation op, CCAlgorithm alg, CCOptions options, const void* key, size_t keyLength, const void* iv, CCCryptorStatus* statusOut) {
+        if (mode != kCCModeECB && mode != kCCModeCBC && mode != kCCModeCTR && mode != kCCModeRC4) {
+            return kCCUnimplemented;
+        }
 
-        std::unique_ptr<CC_Cryptor_State> pState = std::make_unique<CC_Cryptor_State>(op, alg, options, key, keyLength, iv);
+        _op = op;
+        _alg = alg;
+        _mode = mode;
+        _padding = padding && (mode == kCCModeECB || mode == kCCModeCBC);
 
-        HRESULT initResult = pState->_init();
-        if (FAILED(initResult)) {
-            *statusOut = _cryptorStatusFromHRESULT(initResult);
-            return nullptr;
+        const uint8_t* keyBytes = static_cast<const uint8_t*>(key);
+        switch (alg) {
+            case kCCAlgorithmAES:
+                _blockSize = kCCBlockSizeAES128;
+                expandAesKey(keyBytes, keyLength, _key.aes);
+                break;
+            case kCCAlgorithmDES:
+                _blockSize = kCCBlockSizeDES;
+                desKeySchedule(keyBytes, _key.des[0]);
+                break;
+            case kCCAlgorithm3DES:
+                _blockSize = kCCBlockSize3DES;
+                for (size_t i = 0; i < 3; ++i) {
+                    desKeySchedule(keyBytes + i * kCCKeySizeDES, _key.des[i]);
+                }
+                break;
+            case kCCAlgorithmRC2:
+                _blockSize = kCCBlockSizeRC2;
+                rc2KeySchedule(keyBytes, keyLength, _key.rc2);
+                break;
+            case kCCAlgorithmRC4:
+                _blockSize = 1;
+                rc4KeySchedule(keyBytes, keyLength, _key.rc4.initial);
+                break;
         }
 
-        *statusOut = kCCSuccess;
-        return pState;
+        reset(iv);
+        return kCCSuccess;
     }
 
-    CCCryptorStatus update(const void* dataIn, size_t dataInLength, void* dataOut, size_t dataOutAvailable, size_t* dataOutMoved) {
-        return _cryptorStatusFromHRESULT(_update(dataIn, dataInLength, dataOut, dataOutAvailable, dataOutMoved));
-    }
+    void reset(const void* iv) {
+        //  A missing IV is all zeros
+        if (iv && _mode != kCCModeECB && _mode != kCCModeRC4) {
+            memcpy(_chain, iv, _blockSize);
+        } else {
+            memset(_chain, 0, sizeof(_chain));
+        }
 
-    CCCryptorStatus final(void* dataOut, size_t dataOutAvailable, size_t* dataOutMoved) {
-        return _cryptorStatusFromHRESULT(_final(dataOut, dataOutAvailable, dataOutMoved));
+        if (_mode == kCCModeRC4) {
+            _key.rc4.current = _key.rc4.initial;
+        }
+
+        _bufferLength = 0;
+        _keystreamUsed = _blockSize;
     }
 
-    CCCryptorStatus reset(const void* iv) {
-        _iv = iv;
-        _ivBuffer = nullptr;
-        _inputBuffer.clear();
-        _cryptographicKey = nullptr;
+    CCCryptorStatus update(const void* dataIn, size_t dataInLength, void* dataOut, size_t dataOutAvailable, size_t* dataOutMoved) {
+        *dataOutMoved = 0;
+        const uint8_t* in = static_cast<const uint8_t*>(dataIn);
+        uint8_t* out = static_cast<uint8_t*>(dataOut);
+
+        if (_mode == kCCModeRC4 || _mode == kCCModeCTR) {
+            if (dataOutAvailable < dataInLength) {
+                return kCCBufferTooSmall;
+            }
+
+            if (_mode == kCCModeRC4) {
+                rc4Crypt(_key.rc4.current, in, out, dataInLength);
+            } else {
+                _counterMode(in, out, dataInLength);
+            }
+
+            *dataOutMoved = dataInLength;
+            return kCCSuccess;
+        }
+
+        const size_t output = _updateOutputLength(dataInLength);
+        if (output > dataOutAvailable) {
+            return kCCBufferTooSmall;
+        }
+
+        size_t remaining = output;
+        if (_bufferLength > 0 && remaining > 0) {
+            const size_t fill = _blockSize - _bufferLength;
+            memcpy(_buffer + _bufferLength, in, fill);
+            in += fill;
+            dataInLength -= fill;
+
+            _blocks(_buffer, out, 1);
+            out += _blockSize;
+            remaining -= _blockSize;
+            _bufferLength = 0;
+        }
+
+        _blocks(in, out, remaining / _blockSize);
+        in += remaining;
+        dataInLength -= remaining;
 
-        HRESULT initResult = _init();
-        if (FAILED(initResult)) {
-            return _cryptorStatusFromHRESULT(initResult);
+        //  An empty update may pass a NULL dataIn, which memcpy must not be given even for zero bytes
+        if (dataInLength > 0) {
+            memcpy(_buffer + _bufferLength, in, dataInLength);
+            _bufferLength += dataInLength;
         }
 
+        *dataOutMoved = output;
         return kCCSuccess;
     }
 
-    static CCCryptorStatus oneShot(CCOperation op,
-                                   CCAlgorithm alg,
-                                   CCOptions options,
-                                   const void* key,
-                                   size_t keyLength,
-                                   const void* iv,
-                                   const void* dataIn,
-                                   size_t dataInLength,
-                                   void* dataOut,
-                                   size_t dataOutAvailable,
-                                   size_t* dataOutMoved) {
-        CCCryptorStatus status;
+    CCCryptorStatus final(void* dataOut, size_t dataOutAvailable, size_t* dataOutMoved) {
         *dataOutMoved = 0;
+        uint8_t* out = static_cast<uint8_t*>(dataOut);
+
+        if (_mode == kCCModeRC4 || _mode == kCCModeCTR) {
+            return kCCSuccess;
+        }
+
+        if (_op == kCCEncrypt) {
+            if (!_padding) {
+                return (_bufferLength == 0) ? kCCSuccess : kCCAlignmentError;
+            }
+
+            if (dataOutAvailable < _blockSize) {
+                return kCCBufferTooSmall;
+            }
 
-        std::unique_ptr<CC_Cryptor_State> pState = CC_Cryptor_State::init(op, alg, options, key, keyLength, iv, &status);
-        if (status != kCCSuccess) {
-            return status;
+            const size_t pad = _blockSize - _bufferLength;
+            memset(_buffer + _bufferLength, static_cast<int>(pad), pad);
+            _blocks(_buffer, out, 1);
+            _bufferLength = 0;
+            *dataOutMoved = _blockSize;
+            return kCCSuccess;
         }
 
-        size_t dataMoved1 = 0;
-        status = pState->update(dataIn, dataInLength, dataOut, dataOutAvailable, &dataMoved1);
-        *dataOutMoved = dataMoved1;
-        if (status != kCCSuccess) {
-            return status;
+        if (_bufferLength == 0) {
+            return kCCSuccess;
         }
 
-        size_t dataMoved2 = 0;
-        status = pState->final((uint8_t*)dataOut + dataMoved1, dataOutAvailable - dataMoved1, &dataMoved2);
-        *dataOutMoved = dataMoved1 + dataMoved2;
-        return status;
-    }
+        if (!_padding || _bufferLength != _blockSize) {
+            return kCCAlignmentError;
+        }
 
-    size_t outputLength(size_t inputLength, bool final) {
-        // For stream ciphers, the output size is always equal to the input size. For block ciphers, the output size will always be less
-        // than or equal to the input size plus the size of one block
+        uint8_t plain[c_maxBlockSize];
+        _blocks(_buffer, plain, 1);
+        _bufferLength = 0;
 
-        if (_alg == kCCAlgorithmRC4) {
-            return inputLength;
+        //  Check every padding byte regardless of where the first mismatch is
+        const size_t pad = plain[_blockSize - 1];
+        unsigned bad = (pad == 0) | (pad > _blockSize);
+        for (size_t i = 0; i < _blockSize; ++i) {
+            const unsigned inPadding = (i + pad >= _blockSize);
+            bad |= inPadding & (plain[i] != pad);
+        }
+
+        if (bad) {
+            secureZero(plain, sizeof(plain));
+            return kCCDecodeError;
+        }
+
+        const size_t length = _blockSize - pad;
+        if (dataOutAvailable < length) {
+            secureZero(plain, sizeof(plain));
+            return kCCBufferTooSmall;
         }
 
-        // Round down the input length to the nearest block
-        size_t output = inputLength - (inputLength % _blockSize);
+        memcpy(out, plain, length);
+        secureZero(plain, sizeof(plain));
+        *dataOutMoved = length;
+        return kCCSuccess;
+    }
 
-        // If final is false, the return value indicates the output space needed for update.
-        if (!final) {
-            return output;
+    size_t outputLength(size_t inputLength, bool final) const {
+        //  For stream ciphers, the output size is always equal to the input size. For block ciphers, the output size will always
+        //  be less than or equal to the input size plus the size of one block
+        if (_mode == kCCModeRC4 || _mode == kCCModeCTR) {
+            return inputLength;
         }
 
-        // If final is true and padding is enabled, add a block
-        if (_options & kCCOptionPKCS7Padding) {
+        const size_t total = _bufferLength + inputLength;
+        size_t output = total - (total % _blockSize);
+        if (final && _padding) {
             output += _blockSize;
         }
 
         return output;
     }
 
-private:
-    HRESULT _validateParams() {
-        // Validate operation parameter
-        if (_op != kCCEncrypt && _op != kCCDecrypt) {
-            RETURN_HR_MSG(E_INVALIDARG, "Expected operation kCCEncrypt or kCCDecrypt");
-        }
+    bool allocated;
 
-        // Validate algorithm/key parameter
-        switch (_alg) {
-        case kCCAlgorithmAES:
-            if (!_key || (_keyLength != kCCKeySizeAES128 && _keyLength != kCCKeySizeAES192 && _keyLength != kCCKeySizeAES256)) {
-                RETURN_HR_MSG(E_INVALIDARG, "Invalid key for specified algorithm kCCAlgorithmAES");
-            }
-            break;
-        case kCCAlgorithmDES:
-            if (!_key || _keyLength != kCCKeySizeDES) {
-                RETURN_HR_MSG(E_INVALIDARG, "Invalid key for specified algorithm kCCAlgorithmDES");
-            }
-            break;
-        case kCCAlgorithm3DES:
-            if (!_key || _keyLength != kCCKeySize3DES) {
-                RETURN_HR_MSG(E_INVALIDARG, "Invalid key for specified algorithm kCCAlgorithm3DES");
-            }
-            break;
-        case kCCAlgorithmCAST:
-            UNIMPLEMENTED_WITH_MSG("kCCAlgorithmCAST is not supported");
-            return E_NOTIMPL;
-        case kCCAlgorithmRC4:
-            if ((!_key) || (_keyLength < kCCKeySizeMinRC4) || (_keyLength > kCCKeySizeMaxRC4)) {
-                RETURN_HR_MSG(E_INVALIDARG, "Invalid key for specified algorithm kCCAlgorithmRC4");
-            }
-            break;
-        case kCCAlgorithmRC2:
-            if ((!_key) || (_keyLength < kCCKeySizeMinRC2) || (_keyLength > kCCKeySizeMaxRC2)) {
-                RETURN_HR_MSG(E_INVALIDARG, "Invalid key for specified algorithm kCCAlgorithmRC2");
-            }
-            break;
-        case kCCAlgorithmBlowfish:
-            UNIMPLEMENTED_WITH_MSG("kCCAlgorithmBlowfish is not supported");
-            return E_NOTIMPL;
-        default:
-            RETURN_HR_MSG(E_INVALIDARG, "Unknown algorithm");
-            break;
+private:
+    // Output of an update; decrypting with padding holds back the last whole block, which may be the padded one
+    size_t _updateOutputLength(size_t inputLength) const {
+        const size_t total = _bufferLength + inputLength;
+        size_t output = total - (total % _blockSize);
+        if (_padding && _op == kCCDecrypt && output == total && output > 0) {
+            output -= _blockSize;
         }
 
-        return S_OK;
+        return output;
     }
 
-    HRESULT _init() {
-        RETURN_IF_FAILED(_validateParams());
+    void _encryptBlocks(const uint8_t* in, uint8_t* out, size_t blocks) {
+        if (_alg == kCCAlgorithmAES) {
+            c_aes.encrypt(_key.aes, in, out, blocks);
+            return;
+        }
 
-        ComPtr<ISymmetricKeyAlgorithmProviderStatics> symmetricKeyAlgorithmProviderStatics;
-        ComPtr<ISymmetricAlgorithmNamesStatics> symmetricAlgorithmNamesStatics;
-        ComPtr<ICryptographicBufferStatics> cryptographicBufferStatics;
-        RETURN_IF_FAILED_LOG(
-            GetActivationFactory(Wrappers::HStringReference(RuntimeClass_Windows_Security_Cryptography_Core_SymmetricKeyAlgorithmProvider)
-                                     .Get(),
-                                 &symmetricKeyAlgorithmProviderStatics));
-        RETURN_IF_FAILED_LOG(
-            GetActivationFactory(Wrappers::HStringReference(RuntimeClass_Windows_Security_Cryptography_Core_SymmetricAlgorithmNames).Get(),
-                                 &symmetricAlgorithmNamesStatics));
-        RETURN_IF_FAILED_LOG(
-            GetActivationFactory(Wrappers::HStringReference(RuntimeClass_Windows_Security_Cryptography_CryptographicBuffer).Get(),
-                                 &cryptographicBufferStatics));
+        for (; blocks > 0; --blocks, in += _blockSize, out += _blockSize) {
+            _legacyBlock(in, out, true);
+        }
+    }
 
-        Microsoft::WRL::Wrappers::HString name;
-        unsigned char allZeroIV[16] = {};
+    void _decryptBlocks(const uint8_t* in, uint8_t* out, size_t blocks) {
+        if (_alg == kCCAlgorithmAES) {
+            c_aes.decrypt(_key.aes, in, out, blocks);
+            return;
+        }
 
-        // Retrieve algorithm name
-        switch (_options) {
-            case kCCOptionPKCS7Padding:
-                if (!_iv) {
-                    _iv = allZeroIV;
-                }
+        for (; blocks > 0; --blocks, in += _blockSize, out += _blockSize) {
+            _legacyBlock(in, out, false);
+        }
+    }
 
-                switch (_alg) {
-                    case kCCAlgorithmAES:
-                        RETURN_IF_FAILED_LOG(symmetricAlgorithmNamesStatics->get_AesCbcPkcs7(name.GetAddressOf()));
-                        break;
-                    case kCCAlgorithmDES:
-                        RETURN_IF_FAILED_LOG(symmetricAlgorithmNamesStatics->get_DesCbcPkcs7(name.GetAddressOf()));
-                        break;
-                    case kCCAlgorithm3DES:
-                        RETURN_IF_FAILED_LOG(symmetricAlgorithmNamesStatics->get_TripleDesCbcPkcs7(name.GetAddressOf()));
-                        break;
-                    case kCCAlgorithmRC4:
-                        RETURN_HR_MSG(E_INVALIDARG, "Padding is not a valid option on stream ciphers.");
-                    case kCCAlgorithmRC2:
-                        RETURN_IF_FAILED_LOG(symmetricAlgorithmNamesStatics->get_Rc2CbcPkcs7(name.GetAddressOf()));
-                        break;
-                    default:
-                        return E_INVALIDARG;
-                        break;
-                }
+    void _legacyBlock(const uint8_t* in, uint8_t* out, bool encrypt) {
+        switch (_alg) {
+            case kCCAlgorithmDES:
+                storeBigEndian64(out, desBlock(loadBigEndian64(in), _key.des[0], !encrypt));
                 break;
-            case kCCOptionECBMode:
-                _iv = nullptr;
-                switch (_alg) {
-                    case kCCAlgorithmAES:
-                        RETURN_IF_FAILED_LOG(symmetricAlgorithmNamesStatics->get_AesEcb(name.GetAddressOf()));
-                        break;
-                    case kCCAlgorithmDES:
-                        RETURN_IF_FAILED_LOG(symmetricAlgorithmNamesStatics->get_DesEcb(name.GetAddressOf()));
-                        break;
-                    case kCCAlgorithm3DES:
-                        RETURN_IF_FAILED_LOG(symmetricAlgorithmNamesStatics->get_TripleDesEcb(name.GetAddressOf()));
-                        break;
-                    case kCCAlgorithmRC4:
-                        RETURN_HR_MSG(E_INVALIDARG, "ECB mode is not a valid option on stream ciphers.");
-                    case kCCAlgorithmRC2:
-                        RETURN_IF_FAILED_LOG(symmetricAlgorithmNamesStatics->get_Rc2Ecb(name.GetAddressOf()));
-                        break;
-                    default:
-                        return E_INVALIDARG;
-                        break;
+            case kCCAlgorithm3DES: {
+                uint64_t block = loadBigEndian64(in);
+                if (encrypt) {
+                    block = desBlock(desBlock(desBlock(block, _key.des[0], false), _key.des[1], true), _key.des[2], false);
+                } else {
+                    block = desBlock(desBlock(desBlock(block, _key.des[2], true), _key.des[1], false), _key.des[0], true);
                 }
+
+                storeBigEndian64(out, block);
                 break;
-            case (kCCOptionPKCS7Padding | kCCOptionECBMode):
-                _iv = nullptr;
-                switch (_alg) {
-                    case kCCAlgorithmAES:
-                        RETURN_IF_FAILED_LOG(symmetricAlgorithmNamesStatics->get_AesEcbPkcs7(name.GetAddressOf()));
-                        break;
-                    case kCCAlgorithmDES:
-                        RETURN_IF_FAILED_LOG(symmetricAlgorithmNamesStatics->get_DesEcbPkcs7(name.GetAddressOf()));
-                        break;
-                    case kCCAlgorithm3DES:
-                        RETURN_IF_FAILED_LOG(symmetricAlgorithmNamesStatics->get_TripleDesEcbPkcs7(name.GetAddressOf()));
-                        break;
-                    case kCCAlgorithmRC4:
-                        RETURN_HR_MSG(E_INVALIDARG, "Padding/ECB mode is not a valid option on stream ciphers.");
-                    case kCCAlgorithmRC2:
-                        RETURN_IF_FAILED_LOG(symmetricAlgorithmNamesStatics->get_Rc2EcbPkcs7(name.GetAddressOf()));
-                        break;
-                    default:
-                        return E_INVALIDARG;
-                        break;
+            }
+            case kCCAlgorithmRC2:
+                if (encrypt) {
+                    rc2Encrypt(_key.rc2, in, out);
+                } else {
+                    rc2Decrypt(_key.rc2, in, out);
                 }
                 break;
-            default:
-                if (!(_iv || (_alg == kCCAlgorithmRC4))) {
-                    _iv = allZeroIV;
-                }
+        }
+    }
 
-                switch (_alg) {
-                    case kCCAlgorithmAES:
-                        RETURN_IF_FAILED_LOG(symmetricAlgorithmNamesStatics->get_AesCbc(name.GetAddressOf()));
-                        break;
-                    case kCCAlgorithmDES:
-                        RETURN_IF_FAILED_LOG(symmetricAlgorithmNamesStatics->get_DesCbc(name.GetAddressOf()));
-                        break;
-                    case kCCAlgorithm3DES:
-                        RETURN_IF_FAILED_LOG(symmetricAlgorithmNamesStatics->get_TripleDesCbc(name.GetAddressOf()));
-                        break;
-                    case kCCAlgorithmRC4:
-                        RETURN_IF_FAILED_LOG(symmetricAlgorithmNamesStatics->get_Rc4(name.GetAddressOf()));
-                        break;
-                    case kCCAlgorithmRC2:
-                        RETURN_IF_FAILED_LOG(symmetricAlgorithmNamesStatics->get_Rc2Cbc(name.GetAddressOf()));
-                        break;
-                    default:
-                        return E_INVALIDARG;
-                        break;
-                }
-                break;
+    // Runs whole blocks through ECB or CBC. in and out may be the same buffer.
+    void _blocks(const uint8_t* in, uint8_t* out, size_t blocks) {
+        if (_mode == kCCModeECB) {
+            if (_op == kCCEncrypt) {
+                _encryptBlocks(in, out, blocks);
+            } else {
+                _decryptBlocks(in, out, blocks);
+            }
+
+            return;
         }
 
-        // Initialize key buffer
-        ComPtr<ISymmetricKeyAlgorithmProvider> symmetricKeyAlgorithmProvider;
-        RETURN_IF_FAILED_LOG(symmetricKeyAlgorithmProviderStatics->OpenAlgorithm(name.Get(), &symmetricKeyAlgorithmProvider));
-        ComPtr<IBuffer> keyBuffer;
-        RETURN_IF_FAILED_LOG(BufferFromRawData(&keyBuffer, (unsigned char*)_key, _keyLength));
-        RETURN_IF_FAILED_LOG(symmetricKeyAlgorithmProvider->CreateSymmetricKey(keyBuffer.Get(), &_cryptographicKey));
+        if (_op == kCCEncrypt) {
+            //  Each block depends on the one before, so CBC encryption is serial
+            if (_alg == kCCAlgorithmAES) {
+                c_aes.cbcEncrypt(_key.aes, _chain, in, out, blocks);
+                return;
+            }
 
-        // Initialize iv buffer
-        if (_iv) {
-            RETURN_IF_FAILED_LOG(cryptographicBufferStatics->CreateFromByteArray(_blockSize, (unsigned char*)_iv, &_ivBuffer));
-        } else {
-             _ivBuffer = nullptr;
+            for (; blocks > 0; --blocks, in += _blockSize, out += _blockSize) {
+                xorBytes(_chain, _chain, in, _blockSize);
+                _encryptBlocks(_chain, _chain, 1);
+                memcpy(out, _chain, _blockSize);
+            }
+
+            return;
         }
 
-        return S_OK;
+        //  CBC decryption of a batch runs in parallel; the ciphertext is kept aside in case out overwrites it
+        uint8_t cipher[c_batchBlocks * c_maxBlockSize];
+        while (blocks > 0) {
+            const size_t count = std::min(blocks, c_batchBlocks);
+            const size_t length = count * _blockSize;
+            memcpy(cipher, in, length);
+
+            _decryptBlocks(cipher, out, count);
+            xorBytes(out, out, _chain, _blockSize);
+            xorBytes(out + _blockSize, out + _blockSize, cipher, length - _blockSize);
+            memcpy(_chain, cipher + length - _blockSize, _blockSize);
+
+            in += length;
+            out += length;
+            blocks -= count;
+        }
     }
 
-    HRESULT _performOp(void* dataOut, size_t dataOutAvailable, size_t dataOutSize, size_t dataInSize, size_t* dataOutMoved, bool final) {
-        ComPtr<ICryptographicBufferStatics> cryptographicBufferStatics;
-        RETURN_IF_FAILED_LOG(
-            GetActivationFactory(Wrappers::HStringReference(RuntimeClass_Windows_Security_Cryptography_CryptographicBuffer).Get(),
-                &cryptographicBufferStatics));
-
-        // Create an IBuffer for input data, remove data from internal storage
-        ComPtr<IBuffer> dataInBuffer;
-        RETURN_IF_FAILED_LOG(BufferFromRawData(&dataInBuffer, _inputBuffer.data(), dataInSize));
+    void _counterMode(const uint8_t* in, uint8_t* out, size_t length) {
+        //  Use up the keystream left over from the last call first
+        while (length > 0 && _keystreamUsed < _blockSize) {
+            *out++ = *in++ ^ _keystream[_keystreamUsed++];
+            --length;
+        }
 
-        ComPtr<ICryptographicEngineStatics> cryptographicEngineStatics;
+        const size_t blocks = length / _blockSize;
+        if (_alg == kCCAlgorithmAES) {
+            c_aes.counterMode(_key.aes, _chain, kCCBlockSizeAES128, in, out, blocks);
+        } else {
+            uint8_t keystream[c_batchBlocks * c_maxBlockSize];
+            for (size_t done = 0; done < blocks;) {
+                const size_t count = std::min(blocks - done, c_batchBlocks);
+                for (size_t i = 0; i < count; ++i) {
+                    memcpy(keystream + i * _blockSize, _chain, _blockSize);
+                    incrementBigEndian(_chain, _blockSize);
+                }
 
-        RETURN_IF_FAILED_LOG(
-            GetActivationFactory(Wrappers::HStringReference(RuntimeClass_Windows_Security_Cryptography_Core_CryptographicEngine).Get(),
-                &cryptographicEngineStatics));
+                _encryptBlocks(keystream, keystream, count);
+                xorBytes(out + done * _blockSize, in + done * _blockSize, keystream, count * _blockSize);
+                done += count;
+            }
+        }
 
-        ComPtr<IBuffer> dataOutBuffer;
+        in += blocks * _blockSize;
+        out += blocks * _blockSize;
+        length -= blocks * _blockSize;
 
-        // Peform the Encrypt/Decrypt operation
-        if (_op == kCCEncrypt) {
-            RETURN_IF_FAILED_LOG(
-                cryptographicEngineStatics->Encrypt(_cryptographicKey.Get(), dataInBuffer.Get(), _ivBuffer.Get(), &dataOutBuffer));
-        } else {
-            RETURN_IF_FAILED_LOG(
-                cryptographicEngineStatics->Decrypt(_cryptographicKey.Get(), dataInBuffer.Get(), _ivBuffer.Get(), &dataOutBuffer));
+        if (length > 0) {
+            _encryptBlocks(_chain, _keystream, 1);
+            incrementBigEndian(_chain, _blockSize);
+            xorBytes(out, in, _keystream, length);
+            _keystreamUsed = length;
         }
+    }
 
-        // Copy the output to the out pointer
-        ComPtr<IBufferByteAccess> bufferAccess;
-        RETURN_IF_FAILED_LOG(dataOutBuffer.As(&bufferAccess));
-        BYTE* pRawOutput;
-        RETURN_IF_FAILED_LOG(bufferAccess->Buffer(&pRawOutput));
-        memcpy_s(dataOut, dataOutAvailable, pRawOutput, dataOutSize);
+    CCOperation _op;
+    CCAlgorithm _alg;
+    CCMode _mode;
+    bool _padding;
+    size_t _blockSize;
 
-        *dataOutMoved = dataOutSize;
+    union {
+        AesKey aes;
+        uint64_t des[3][16];
+        uint16_t rc2[64];
+        struct {
+            Rc4State initial;
+            Rc4State current;
+        } rc4;
+    } _key;
+
+    // The CBC chaining value or the CTR counter
+    uint8_t _chain[c_maxBlockSize];
+
+    // Input short of a whole block, or the held back last block when decrypting with padding
+    uint8_t _buffer[c_maxBlockSize];
+    size_t _bufferLength;
+
+    uint8_t _keystream[c_maxBlockSize];
+    size_t _keystreamUsed;
+};
 
-        // If this is the final operation, we are done
-        if (final) {
-            return S_OK;
-        }
+namespace {
 
-        // Last encrypted block becomes the new initialization vector
-        if (_alg != kCCAlgorithmRC4 && !(_options & kCCOptionECBMode)) {
-            if (_op == kCCEncrypt) {
-                RETURN_IF_FAILED_LOG(
-                    cryptographicBufferStatics->CreateFromByteArray(_blockSize, pRawOutput + dataOutSize - _blockSize, &_ivBuffer));
-            } else {
-                RETURN_IF_FAILED_LOG(cryptographicBufferStatics->CreateFromByteArray(_blockSize,
-                    _inputBuffer.data() + dataOutSize - _blockSize,
-                    &_ivBuffer));
-            }
-        }
+CCMode modeFromOptions(CCAlgorithm alg, CCOptions options) {
+    if (alg == kCCAlgorithmRC4) {
+        return kCCModeRC4;
+    }
 
-        _inputBuffer.erase(_inputBuffer.begin(), _inputBuffer.begin() + dataOutSize);
+    return (options & kCCOptionECBMode) ? kCCModeECB : kCCModeCBC;
+}
 
-        return S_OK;
+CCCryptorStatus createCryptor(CCOperation op,
+                              CCMode mode,
+                              CCAlgorithm alg,
+                              bool padding,
+                              const void* key,
+                              size_t keyLength,
+                              const void* iv,
+                              CCCryptorRef* cryptorRef) {
+    if (!cryptorRef) {
+        return kCCParamError;
     }
 
-    HRESULT _update(const void* dataIn, size_t dataInLength, void* dataOut, size_t dataOutAvailable, size_t* dataOutMoved) {
-        *dataOutMoved = 0;
-        size_t inputSize = _inputBuffer.size() + dataInLength;
+    *cryptorRef = nullptr;
 
-        // Determine the size of data to encrypt or decrypt. This will be a multiple of the block size.
-        size_t dataInOutLength = inputSize - (inputSize % _blockSize);
-        if (dataInOutLength > dataOutAvailable) {
-            return SEC_E_BUFFER_TOO_SMALL;
-        }
+    CC_Cryptor_State* state = new (std::nothrow) CC_Cryptor_State;
+    if (!state) {
+        return kCCMemoryFailure;
+    }
+
+    const CCCryptorStatus status = state->init(op, mode, alg, padding, key, keyLength, iv);
+    if (status != kCCSuccess) {
+        delete state;
+        return status;
+    }
 
-        _inputBuffer.insert(_inputBuffer.end(), (uint8_t*)dataIn, (uint8_t*)dataIn + dataInLength);
+    state->allocated = true;
+    *cryptorRef = state;
+    return kCCSuccess;
+}
 
-        // If there isn't an entire block worth of data to encrypt, simply return.
-        if (dataInOutLength == 0) {
-            return S_OK;
-        }
+CCCryptorStatus validateOptions(CCAlgorithm alg, CCOptions options) {
+    if (options & ~(kCCOptionPKCS7Padding | kCCOptionECBMode)) {
+        return kCCParamError;
+    }
 
-        // Perform the operation
-        return _performOp(dataOut, dataOutAvailable, dataInOutLength, dataInOutLength, dataOutMoved, false);
+    //  Padding and ECB mode are not valid options on stream ciphers
+    if (alg == kCCAlgorithmRC4 && options != 0) {
+        return kCCParamError;
     }
 
-    HRESULT _final(void* dataOut, size_t dataOutAvailable, size_t* dataOutMoved) {
-        *dataOutMoved = 0;
+    return kCCSuccess;
+}
+
+CCCryptorStatus gcmOneShot(CCOperation op,
+                           CCAlgorithm alg,
+                           const void* key,
+                           size_t keyLength,
+                           const void* iv,
+                           size_t ivLength,
+                           const void* aData,
+                           size_t aDataLength,
+                           const void* dataIn,
+                           size_t dataInLength,
+                           void* dataOut,
+                           uint8_t* tag,
+                           size_t tagLength) {
+    if (alg != kCCAlgorithmAES || !key || !isAesKeyLength(keyLength) || !iv || ivLength == 0 || (!aData && aDataLength > 0) ||
+        (dataInLength > 0 && (!dataIn || !dataOut)) || !tag || tagLength == 0 || tagLength > kCCBlockSizeAES128) {
+        return kCCParamError;
+    }
+
+    const uint8_t* in = static_cast<const uint8_t*>(dataIn);
+    uint8_t* out = static_cast<uint8_t*>(dataOut);
+
+    AesKey aesKey;
+    expandAesKey(static_cast<const uint8_t*>(key), keyLength, aesKey);
+
+    uint8_t block[kCCBlockSizeAES128] = {};
+    c_aes.encrypt(aesKey, block, block, 1);
+
+    GhashKey ghashKey;
+    ghashKey.high = loadBigEndian64(block);
+    ghashKey.low = loadBigEndian64(block + 8);
+    c_ghash.prepare(ghashKey);
+
+    //  The pre-counter block: a 96 bit IV followed by a 32 bit one, or the GHASH of any other IV and its length
+    uint8_t counter[kCCBlockSizeAES128] = {};
+    if (ivLength == 12) {
+        memcpy(counter, iv, ivLength);
+        counter[15] = 1;
+    } else {
+        ghashPadded(ghashKey, counter, static_cast<const uint8_t*>(iv), ivLength);
+        uint8_t lengths[kCCBlockSizeAES128] = {};
+        storeBigEndian64(lengths + 8, static_cast<uint64_t>(ivLength) * 8);
+        c_ghash.update(ghashKey, counter, lengths, 1);
+    }
+
+    uint8_t tagMask[kCCBlockSizeAES128];
+    c_aes.encrypt(aesKey, counter, tagMask, 1);
 
-        if (_inputBuffer.size() == 0) {
-            return S_OK;
+    uint8_t hash[kCCBlockSizeAES128] = {};
+    ghashPadded(ghashKey, hash, static_cast<const uint8_t*>(aData), aDataLength);
+
+    //  Counter mode with a 32 bit counter from J0 + 1, hashing each chunk of ciphertext as it goes by
+    incrementBigEndian(counter + 12, 4);
+    const size_t chunkLength = c_batchBlocks * kCCBlockSizeAES128;
+    for (size_t offset = 0; offset < dataInLength; offset += chunkLength) {
+        const size_t length = std::min(dataInLength - offset, chunkLength);
+        if (op == kCCDecrypt) {
+            ghashPadded(ghashKey, hash, in + offset, length);
         }
 
-        // There can be no leftover data unless kCCOptionPKCS7Padding is specified
-        if (!(_options & kCCOptionPKCS7Padding)) {
-            return SEC_E_CANNOT_PACK;
+        const size_t blocks = length / kCCBlockSizeAES128;
+        c_aes.counterMode(aesKey, counter, 4, in + offset, out + offset, blocks);
+
+        const size_t tail = length % kCCBlockSizeAES128;
+        if (tail > 0) {
+            uint8_t last[kCCBlockSizeAES128] = {};
+            memcpy(last, in + offset + blocks * kCCBlockSizeAES128, tail);
+            c_aes.counterMode(aesKey, counter, 4, last, last, 1);
+            memcpy(out + offset + blocks * kCCBlockSizeAES128, last, tail);
+            secureZero(last, sizeof(last));
         }
 
-        // round up input to the nearest block
-        size_t dataOutSize = _inputBuffer.size() + (_blockSize - _inputBuffer.size() % _blockSize);
+        if (op == kCCEncrypt) {
+            ghashPadded(ghashKey, hash, out + offset, length);
+        }
+    }
 
-        if (dataOutAvailable < dataOutSize) {
-            return SEC_E_BUFFER_TOO_SMALL;
+    uint8_t lengths[kCCBlockSizeAES128];
+    storeBigEndian64(lengths, static_cast<uint64_t>(aDataLength) * 8);
+    storeBigEndian64(lengths + 8, static_cast<uint64_t>(dataInLength) * 8);
+    c_ghash.update(ghashKey, hash, lengths, 1);
+    xorBytes(hash, hash, tagMask, kCCBlockSizeAES128);
+
+    CCCryptorStatus status = kCCSuccess;
+    if (op == kCCEncrypt) {
+        memcpy(tag, hash, tagLength);
+    } else {
+        unsigned difference = 0;
+        for (size_t i = 0; i < tagLength; ++i) {
+            difference |= hash[i] ^ tag[i];
         }
 
-        return _performOp(dataOut, dataOutAvailable, _blockSize, _inputBuffer.size(), dataOutMoved, true);
+        if (difference != 0) {
+            secureZero(out, dataInLength);
+            status = kCCDecodeError;
+        }
     }
 
-    CCOperation _op;
-    CCAlgorithm _alg;
-    CCOptions _options;
-    const void* _key;
-    size_t _keyLength;
-    size_t _blockSize;
-    const void* _iv;
-    ComPtr<ICryptographicKey> _cryptographicKey;
-    ComPtr<IBuffer> _ivBuffer;
-    std::vector<uint8_t> _inputBuffer;
-};
+    secureZero(&aesKey, sizeof(aesKey));
+    secureZero(&ghashKey, sizeof(ghashKey));
+    secureZero(tagMask, sizeof(tagMask));
+    secureZero(hash, sizeof(hash));
+    return status;
+}
+
+} // namespace
 
 /**
 @Status Caveat
@@ -478,20 +1822,51 @@ private:
 */
 CCCryptorStatus CCCryptorCreate(
     CCOperation op, CCAlgorithm alg, CCOptions options, const void* key, size_t keyLength, const void* iv, CCCryptorRef* cryptorRef) {
-    *cryptorRef = nullptr;
+    const CCCryptorStatus status = validateOptions(alg, options);
+    if (status != kCCSuccess) {
+        if (cryptorRef) {
+            *cryptorRef = nullptr;
+        }
 
-    CCCryptorStatus status;
-    std::unique_ptr<CC_Cryptor_State> pState = CC_Cryptor_State::init(op, alg, options, key, keyLength, iv, &status);
-    if (status == kCCSuccess) {
-        *cryptorRef = pState.release();
+        return status;
     }
 
-    return status;
+    return createCryptor(
+        op, modeFromOptions(alg, options), alg, (options & kCCOptionPKCS7Padding) != 0, key, keyLength, iv, cryptorRef);
 }
 
 /**
 @Status Caveat
-@Notes Ignores caller-supplied memory and overwrites cryptorRef with dynamically allocated memory.
+@Notes Supports kCCModeECB, kCCModeCBC, kCCModeCTR (big-endian counter) and kCCModeRC4. A tweak, or any numRounds other
+       than 0 for the algorithm's default, returns kCCUnimplemented.
+*/
+CCCryptorStatus CCCryptorCreateWithMode(CCOperation op,
+                                        CCMode mode,
+                                        CCAlgorithm alg,
+                                        CCPadding padding,
+                                        const void* iv,
+                                        const void* key,
+                                        size_t keyLength,
+                                        const void* tweak,
+                                        size_t tweakLength,
+                                        int numRounds,
+                                        CCModeOptions options,
+                                        CCCryptorRef* cryptorRef) {
+    const bool unsupportedOptions = options != 0 && !(mode == kCCModeCTR && options == kCCModeOptionCTR_BE);
+    if (unsupportedOptions || tweak || tweakLength != 0 || numRounds != 0) {
+        if (cryptorRef) {
+            *cryptorRef = nullptr;
+        }
+
+        return kCCUnimplemented;
+    }
+
+    return createCryptor(op, mode, alg, padding == ccPKCS7Padding, key, keyLength, iv, cryptorRef);
+}
+
+/**
+@Status Interoperable
+@Notes Builds the cryptor in the caller-supplied memory, aligning it within data as needed.
 */
 CCCryptorStatus CCCryptorCreateFromData(CCOperation op,
                                         CCAlgorithm alg,
@@ -507,23 +1882,44 @@ CCCryptorStatus CCCryptorCreateFromData(CCOperation op,
         return kCCParamError;
     }
 
-    *dataUsed = 0;
     *cryptorRef = nullptr;
+    *dataUsed = sizeof(CC_Cryptor_State) + alignof(CC_Cryptor_State) - 1;
+    if (!data || dataLength < *dataUsed) {
+        return kCCBufferTooSmall;
+    }
 
-    CCCryptorStatus status;
-    std::unique_ptr<CC_Cryptor_State> pState = CC_Cryptor_State::init(op, alg, options, key, keyLength, iv, &status);
-    if (status == kCCSuccess) {
-        *cryptorRef = pState.release();
+    CCCryptorStatus status = validateOptions(alg, options);
+    if (status != kCCSuccess) {
+        return status;
     }
 
-    return status;
+    const uintptr_t aligned = (reinterpret_cast<uintptr_t>(data) + alignof(CC_Cryptor_State) - 1) & ~(alignof(CC_Cryptor_State) - 1);
+    CC_Cryptor_State* state = new (reinterpret_cast<void*>(aligned)) CC_Cryptor_State;
+    status = state->init(op, modeFromOptions(alg, options), alg, (options & kCCOptionPKCS7Padding) != 0, key, keyLength, iv);
+    if (status != kCCSuccess) {
+        secureZero(state, sizeof(*state));
+        return status;
+    }
+
+    state->allocated = false;
+    *cryptorRef = state;
+    return kCCSuccess;
 }
 
 /**
 @Status Interoperable
 */
 CCCryptorStatus CCCryptorRelease(CCCryptorRef cryptorRef) {
-    delete cryptorRef;
+    if (!cryptorRef) {
+        return kCCSuccess;
+    }
+
+    const bool allocated = cryptorRef->allocated;
+    secureZero(cryptorRef, sizeof(*cryptorRef));
+    if (allocated) {
+        delete cryptorRef;
+    }
+
     return kCCSuccess;
 }
 
@@ -532,7 +1928,7 @@ CCCryptorStatus CCCryptorRelease(CCCryptorRef cryptorRef) {
 */
 CCCryptorStatus CCCryptorUpdate(
     CCCryptorRef cryptorRef, const void* dataIn, size_t dataInLength, void* dataOut, size_t dataOutAvailable, size_t* dataOutMoved) {
-    if (!cryptorRef) {
+    if (!cryptorRef || !dataOutMoved || (dataInLength > 0 && !dataIn) || (dataOutAvailable > 0 && !dataOut)) {
         return kCCParamError;
     }
 
@@ -543,7 +1939,7 @@ CCCryptorStatus CCCryptorUpdate(
 @Status Interoperable
 */
 CCCryptorStatus CCCryptorFinal(CCCryptorRef cryptorRef, void* dataOut, size_t dataOutAvailable, size_t* dataOutMoved) {
-    if (!dataOutMoved || !cryptorRef) {
+    if (!dataOutMoved || !cryptorRef || (dataOutAvailable > 0 && !dataOut)) {
         return kCCParamError;
     }
 
@@ -555,7 +1951,6 @@ CCCryptorStatus CCCryptorFinal(CCCryptorRef cryptorRef, void* dataOut, size_t da
 */
 size_t CCCryptorGetOutputLength(CCCryptorRef cryptorRef, size_t inputLength, bool final) {
     if (!cryptorRef) {
-        LOG_HR(E_INVALIDARG);
         return 0;
     }
 
@@ -570,7 +1965,8 @@ CCCryptorStatus CCCryptorReset(CCCryptorRef cryptorRef, const void* iv) {
         return kCCParamError;
     }
 
-    return cryptorRef->reset(iv);
+    cryptorRef->reset(iv);
+    return kCCSuccess;
 }
 
 /**
@@ -587,5 +1983,91 @@ CCCryptorStatus CCCrypt(CCOperation op,
                         void* dataOut,
                         size_t dataOutAvailable,
                         size_t* dataOutMoved) {
-    return CC_Cryptor_State::oneShot(op, alg, options, key, keyLength, iv, dataIn, dataInLength, dataOut, dataOutAvailable, dataOutMoved);
-}
\ No newline at end of file
+    if (!dataOutMoved) {
+        return kCCParamError;
+    }
+
+    *dataOutMoved = 0;
+    CCCryptorStatus status = validateOptions(alg, options);
+    if (status != kCCSuccess) {
+        return status;
+    }
+
+    //  The cryptor lives on the stack; a one-shot call makes no allocations
+    CC_Cryptor_State state;
+    status = state.init(op, modeFromOptions(alg, options), alg, (options & kCCOptionPKCS7Padding) != 0, key, keyLength, iv);
+    if (status == kCCSuccess) {
+        size_t updateMoved = 0;
+        status = CCCryptorUpdate(&state, dataIn, dataInLength, dataOut, dataOutAvailable, &updateMoved);
+        *dataOutMoved = updateMoved;
+
+        if (status == kCCSuccess) {
+            size_t finalMoved = 0;
+            status = CCCryptorFinal(&state, static_cast<uint8_t*>(dataOut) + updateMoved, dataOutAvailable - updateMoved, &finalMoved);
+            *dataOutMoved += finalMoved;
+        }
+    }
+
+    secureZero(&state, sizeof(state));
+    return status;
+}
+
+/**
+@Status Interoperable
+*/
+CCCryptorStatus CCCryptorGCMOneshotEncrypt(CCAlgorithm alg,
+                                           const void* key,
+                                           size_t keyLength,
+                                           const void* iv,
+                                           size_t ivLength,
+                                           const void* aData,
+                                           size_t aDataLength,
+                                           const void* dataIn,
+                                           size_t dataInLength,
+                                           void* cipherDataOut,
+                                           void* tagOut,
+                                           size_t tagLength) {
+    return gcmOneShot(kCCEncrypt,
+                      alg,
+                      key,
+                      keyLength,
+                      iv,
+                      ivLength,
+                      aData,
+                      aDataLength,
+                      dataIn,
+                      dataInLength,
+                      cipherDataOut,
+                      static_cast<uint8_t*>(tagOut),
+                      tagLength);
+}
+
+/**
+@Status Interoperable
+*/
+CCCryptorStatus CCCryptorGCMOneshotDecrypt(CCAlgorithm alg,
+                                           const void* key,
+                                           size_t keyLength,
+                                           const void* iv,
+                                           size_t ivLength,
+                                           const void* aData,
+                                           size_t aDataLength,
+                                           const void* dataIn,
+                                           size_t dataInLength,
+                                           void* dataOut,
+                                           const void* tagIn,
+                                           size_t tagLength) {
+    return gcmOneShot(kCCDecrypt,
+                      alg,
+                      key,
+                      keyLength,
+                      iv,
+                      ivLength,
+                      aData,
+                      aDataLength,
+                      dataIn,
+                      dataInLength,
+                      dataOut,
+                      const_cast<uint8_t*>(static_cast<const uint8_t*>(tagIn)),
+                      tagLength);
+}
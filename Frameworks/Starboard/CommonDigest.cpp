@@ -14,383 +14,1536 @@
 //
 //******************************************************************************
 
+#include <CommonCrypto/CommonDigest.h>
+
+#include <algorithm>
+#include <stdint.h>
+#include <string.h>
+
+#if defined(_M_IX86) || defined(_M_X64) || defined(__i386__) || defined(__x86_64__)
+#define DIGEST_X86 1
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#endif
+#else
+#define DIGEST_X86 0
+#endif
+
+// The ARMv8 hash instructions are optional; GCC and clang only build them when the file targets the crypto extension
+#if defined(_M_ARM64) || (defined(__aarch64__) && (defined(__ARM_FEATURE_CRYPTO) || defined(__ARM_FEATURE_SHA2)))
+#define DIGEST_ARM 1
+#include <arm_neon.h>
+#if defined(_WIN32)
 #include <Windows.h>
-#include <bcrypt.h>
-#include <CommonCrypto\CommonDigest.h>
-#include <CommonCrypto\CommonCryptor.h>
-#include <ErrorHandling.h>
-#include <assert.h>
-#include <StubReturn.h>
+#else
+#include <sys/auxv.h>
+#include <asm/hwcap.h>
+#endif
+#else
+#define DIGEST_ARM 0
+#endif
 
-struct CC_Digest_State {
-    CC_Digest_State(const unsigned int digestLength, const LPCWSTR algorithm) :
-        _hAlg(INVALID_HANDLE_VALUE),
-        _hHash(INVALID_HANDLE_VALUE),
-        _pHashObject(nullptr),
-        _algorithm(algorithm),
-        _digestLength(digestLength) {
-        _init();
+#if defined(__GNUC__) || defined(__clang__)
+#define DIGEST_TARGET(features) __attribute__((target(features)))
+#else
+#define DIGEST_TARGET(features)
+#endif
+
+namespace {
+
+enum DigestAlgorithm : CC_LONG {
+    c_digestMD2 = 0x4d443200,
+    c_digestMD4,
+    c_digestMD5,
+    c_digestSHA1,
+    c_digestSHA224,
+    c_digestSHA256,
+    c_digestSHA384,
+    c_digestSHA512,
+};
+
+#pragma region Byte order
+
+inline uint32_t loadBigEndian32(const uint8_t* p) {
+    return (uint32_t(p[0]) << 24) | (uint32_t(p[1]) << 16) | (uint32_t(p[2]) << 8) | uint32_t(p[3]);
+}
+
+inline uint64_t loadBigEndian64(const uint8_t* p) {
+    return (uint64_t(loadBigEndian32(p)) << 32) | loadBigEndian32(p + 4);
+}
+
+inline uint32_t loadLittleEndian32(const uint8_t* p) {
+    return uint32_t(p[0]) | (uint32_t(p[1]) << 8) | (uint32_t(p[2]) << 16) | (uint32_t(p[3]) << 24);
+}
+
+inline void storeBigEndian32(uint8_t* p, uint32_t value) {
+    p[0] = uint8_t(value >> 24);
+    p[1] = uint8_t(value >> 16);
+    p[2] = uint8_t(value >> 8);
+    p[3] = uint8_t(value);
+}
+
+inline void storeBigEndian64(uint8_t* p, uint64_t value) {
+    storeBigEndian32(p, uint32_t(value >> 32));
+    storeBigEndian32(p + 4, uint32_t(value));
+}
+
+inline void storeLittleEndian32(uint8_t* p, uint32_t value) {
+    p[0] = uint8_t(value);
+    p[1] = uint8_t(value >> 8);
+    p[2] = uint8_t(value >> 16);
+    p[3] = uint8_t(value >> 24);
+}
+
+inline void storeLittleEndian64(uint8_t* p, uint64_t value) {
+    storeLittleEndian32(p, uint32_t(value));
+    storeLittleEndian32(p + 4, uint32_t(value >> 32));
+}
+
+inline uint32_t rotateLeft(uint32_t value, unsigned bits) {
+    return (value << bits) | (value >> (32 - bits));
+}
+
+inline uint32_t rotateRight(uint32_t value, unsigned bits) {
+    return (value >> bits) | (value << (32 - bits));
+}
+
+inline uint64_t rotateRight(uint64_t value, unsigned bits) {
+    return (value >> bits) | (value << (64 - bits));
+}
+
+#pragma endregion
+
+#pragma region Constants
+
+const uint8_t c_md2Substitution[256] = {
+    41,  46,  67,  201, 162, 216, 124, 1,   61,  54,  84,  161, 236, 240, 6,   19,  98,  167, 5,   243, 192, 199, 115, 140, 152, 147,
+    43,  217, 188, 76,  130, 202, 30,  155, 87,  60,  253, 212, 224, 22,  103, 66,  111, 24,  138, 23,  229, 18,  190, 78,  196, 214,
+    218, 158, 222, 73,  160, 251, 245, 142, 187, 47,  238, 122, 169, 104, 121, 145, 21,  178, 7,   63,  148, 194, 16,  137, 11,  34,
+    95,  33,  128, 127, 93,  154, 90,  144, 50,  39,  53,  62,  204, 231, 191, 247, 151, 3,   255, 25,  48,  179, 72,  165, 181, 209,
+    215, 94,  146, 42,  172, 86,  170, 198, 79,  184, 56,  210, 150, 164, 125, 182, 118, 252, 107, 226, 156, 116, 4,   241, 69,  157,
+    112, 89,  100, 113, 135, 32,  134, 91,  207, 101, 230, 45,  168, 2,   27,  96,  37,  173, 174, 176, 185, 246, 28,  70,  97,  105,
+    52,  64,  126, 15,  85,  71,  163, 35,  221, 81,  175, 58,  195, 92,  249, 206, 186, 197, 234, 38,  44,  83,  13,  110, 133, 40,
+    132, 9,   211, 223, 205, 244, 65,  129, 77,  82,  106, 220, 55,  200, 108, 193, 171, 250, 36,  225, 123, 8,   12,  189, 177, 74,
+    120, 136, 149, 139, 227, 99,  232, 109, 233, 203, 213, 254, 59,  0,   29,  57,  242, 239, 183, 14,  102, 88,  208, 228, 166, 119,
+    114, 248, 235, 117, 75,  10,  49,  68,  80,  180, 143, 237, 31,  26,  219, 153, 141, 51,  159, 17,  131, 20,
+};
+
+const uint32_t c_md5Constants[64] = {
+    0xd76aa478, 0xe8c7b756, 0x242070db, 0xc1bdceee, 0xf57c0faf, 0x4787c62a, 0xa8304613, 0xfd469501, 0x698098d8, 0x8b44f7af, 0xffff5bb1,
+    0x895cd7be, 0x6b901122, 0xfd987193, 0xa679438e, 0x49b40821, 0xf61e2562, 0xc040b340, 0x265e5a51, 0xe9b6c7aa, 0xd62f105d, 0x02441453,
+    0xd8a1e681, 0xe7d3fbc8, 0x21e1cde6, 0xc33707d6, 0xf4d50d87, 0x455a14ed, 0xa9e3e905, 0xfcefa3f8, 0x676f02d9, 0x8d2a4c8a, 0xfffa3942,
+    0x8771f681, 0x6d9d6122, 0xfde5380c, 0xa4beea44, 0x4bdecfa9, 0xf6bb4b60, 0xbebfbc70, 0x289b7ec6, 0xeaa127fa, 0xd4ef3085, 0x04881d05,
+    0xd9d4d039, 0xe6db99e5, 0x1fa27cf8, 0xc4ac5665, 0xf4292244, 0x432aff97, 0xab9423a7, 0xfc93a039, 0x655b59c3, 0x8f0ccc92, 0xffeff47d,
+    0x85845dd1, 0x6fa87e4f, 0xfe2ce6e0, 0xa3014314, 0x4e0811a1, 0xf7537e82, 0xbd3af235, 0x2ad7d2bb, 0xeb86d391,
+};
+
+// Per-round left rotations of MD5, four for each of its four rounds
+const uint8_t c_md5Shifts[16] = { 7, 12, 17, 22, 5, 9, 14, 20, 4, 11, 16, 23, 6, 10, 15, 21 };
+
+// Which message word each MD5 step consumes
+const uint8_t c_md5MessageIndex[64] = {
+    0, 1, 2,  3,  4,  5,  6,  7,  8,  9,  10, 11, 12, 13, 14, 15, 1, 6, 11, 0,  5,  10, 15, 4,  9,  14, 3,  8,  13, 2,  7,  12,
+    5, 8, 11, 14, 1,  4,  7,  10, 13, 0,  3,  6,  9,  12, 15, 2,  0, 7, 14, 5,  12, 3,  10, 1,  8,  15, 6,  13, 4,  11, 2,  9,
+};
+
+const uint32_t c_md5Initial[4] = { 0x67452301, 0xefcdab89, 0x98badcfe, 0x10325476 };
+
+const uint32_t c_sha1Initial[5] = { 0x67452301, 0xefcdab89, 0x98badcfe, 0x10325476, 0xc3d2e1f0 };
+
+const uint32_t c_sha1Constants[4] = { 0x5a827999, 0x6ed9eba1, 0x8f1bbcdc, 0xca62c1d6 };
+
+alignas(16) const uint32_t c_sha256Constants[64] = {
+    0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5, 0xd807aa98, 0x12835b01, 0x243185be,
+    0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174, 0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa,
+    0x5cb0a9dc, 0x76f988da, 0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967, 0x27b70a85,
+    0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85, 0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3,
+    0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070, 0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f,
+    0x682e6ff3, 0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2,
+};
+
+const uint32_t c_sha224Initial[8] = { 0xc1059ed8, 0x367cd507, 0x3070dd17, 0xf70e5939, 0xffc00b31, 0x68581511, 0x64f98fa7, 0xbefa4fa4 };
+
+const uint32_t c_sha256Initial[8] = { 0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a, 0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19 };
+
+const uint64_t c_sha512Constants[80] = {
+    0x428a2f98d728ae22, 0x7137449123ef65cd, 0xb5c0fbcfec4d3b2f, 0xe9b5dba58189dbbc, 0x3956c25bf348b538, 0x59f111f1b605d019,
+    0x923f82a4af194f9b, 0xab1c5ed5da6d8118, 0xd807aa98a3030242, 0x12835b0145706fbe, 0x243185be4ee4b28c, 0x550c7dc3d5ffb4e2,
+    0x72be5d74f27b896f, 0x80deb1fe3b1696b1, 0x9bdc06a725c71235, 0xc19bf174cf692694, 0xe49b69c19ef14ad2, 0xefbe4786384f25e3,
+    0x0fc19dc68b8cd5b5, 0x240ca1cc77ac9c65, 0x2de92c6f592b0275, 0x4a7484aa6ea6e483, 0x5cb0a9dcbd41fbd4, 0x76f988da831153b5,
+    0x983e5152ee66dfab, 0xa831c66d2db43210, 0xb00327c898fb213f, 0xbf597fc7beef0ee4, 0xc6e00bf33da88fc2, 0xd5a79147930aa725,
+    0x06ca6351e003826f, 0x142929670a0e6e70, 0x27b70a8546d22ffc, 0x2e1b21385c26c926, 0x4d2c6dfc5ac42aed, 0x53380d139d95b3df,
+    0x650a73548baf63de, 0x766a0abb3c77b2a8, 0x81c2c92e47edaee6, 0x92722c851482353b, 0xa2bfe8a14cf10364, 0xa81a664bbc423001,
+    0xc24b8b70d0f89791, 0xc76c51a30654be30, 0xd192e819d6ef5218, 0xd69906245565a910, 0xf40e35855771202a, 0x106aa07032bbd1b8,
+    0x19a4c116b8d2d0c8, 0x1e376c085141ab53, 0x2748774cdf8eeb99, 0x34b0bcb5e19b48a8, 0x391c0cb3c5c95a63, 0x4ed8aa4ae3418acb,
+    0x5b9cca4f7763e373, 0x682e6ff3d6b2b8a3, 0x748f82ee5defb2fc, 0x78a5636f43172f60, 0x84c87814a1f0ab72, 0x8cc702081a6439ec,
+    0x90befffa23631e28, 0xa4506cebde82bde9, 0xbef9a3f7b2c67915, 0xc67178f2e372532b, 0xca273eceea26619c, 0xd186b8c721c0c207,
+    0xeada7dd6cde0eb1e, 0xf57d4f7fee6ed178, 0x06f067aa72176fba, 0x0a637dc5a2c898a6, 0x113f9804bef90dae, 0x1b710b35131c471b,
+    0x28db77f523047d84, 0x32caab7b40c72493, 0x3c9ebe0a15c9bebc, 0x431d67c49c100d4c, 0x4cc5d4becb3e42b6, 0x597f299cfc657e2a,
+    0x5fcb6fab3ad6faec, 0x6c44198c4a475817,
+};
+
+const uint64_t c_sha384Initial[8] = {
+    0xcbbb9d5dc1059ed8, 0x629a292a367cd507, 0x9159015a3070dd17, 0x152fecd8f70e5939,
+    0x67332667ffc00b31, 0x8eb44a8768581511, 0xdb0c2e0d64f98fa7, 0x47b5481dbefa4fa4,
+};
+
+const uint64_t c_sha512Initial[8] = {
+    0x6a09e667f3bcc908, 0xbb67ae8584caa73b, 0x3c6ef372fe94f82b, 0xa54ff53a5f1d36f1,
+    0x510e527fade682d1, 0x9b05688c2b3e6c1f, 0x1f83d9abfb41bd6b, 0x5be0cd19137e2179,
+};
+
+#pragma endregion
+
+#pragma region Portable block functions
+
+// state holds the 16 byte digest followed by the 16 byte running checksum
+void md2Compress(uint8_t* state, const uint8_t* blocks, size_t count) {
+    uint8_t* checksum = state + 16;
+
+    for (; count > 0; --count, blocks += CC_MD2_BLOCK_BYTES) {
+        uint8_t x[48];
+        for (size_t i = 0; i < 16; ++i) {
+            x[i] = state[i];
+            x[i + 16] = blocks[i];
+            x[i + 32] = state[i] ^ blocks[i];
+        }
+
+        uint8_t t = 0;
+        for (unsigned round = 0; round < 18; ++round) {
+            for (size_t i = 0; i < 48; ++i) {
+                t = x[i] ^= c_md2Substitution[t];
+            }
+
+            t = uint8_t(t + round);
+        }
+
+        memcpy(state, x, 16);
+
+        uint8_t last = checksum[15];
+        for (size_t i = 0; i < 16; ++i) {
+            last = checksum[i] ^= c_md2Substitution[blocks[i] ^ last];
+        }
     }
+}
 
-    ~CC_Digest_State() {
-        if (_hAlg != INVALID_HANDLE_VALUE) {
-            BCryptCloseAlgorithmProvider(_hAlg, 0);
-            _hAlg = INVALID_HANDLE_VALUE;
+void md4Compress(uint32_t* state, const uint8_t* blocks, size_t count) {
+    for (; count > 0; --count, blocks += CC_MD4_BLOCK_BYTES) {
+        uint32_t x[16];
+        for (size_t i = 0; i < 16; ++i) {
+            x[i] = loadLittleEndian32(blocks + i * 4);
         }
-        if (_hHash != INVALID_HANDLE_VALUE) {
-            BCryptDestroyHash(_hHash);
-            _hHash = INVALID_HANDLE_VALUE;
+
+        uint32_t a = state[0], b = state[1], c = state[2], d = state[3];
+        static const uint8_t c_shifts[3][4] = { { 3, 7, 11, 19 }, { 3, 5, 9, 13 }, { 3, 9, 11, 15 } };
+        static const uint8_t c_round3Index[16] = { 0, 8, 4, 12, 2, 10, 6, 14, 1, 9, 5, 13, 3, 11, 7, 15 };
+
+        for (unsigned i = 0; i < 48; ++i) {
+            uint32_t f;
+            uint32_t word;
+            if (i < 16) {
+                f = (b & c) | (~b & d);
+                word = x[i];
+            } else if (i < 32) {
+                f = ((b & c) | (b & d) | (c & d)) + 0x5a827999;
+                word = x[(i % 4) * 4 + (i - 16) / 4];
+            } else {
+                f = (b ^ c ^ d) + 0x6ed9eba1;
+                word = x[c_round3Index[i - 32]];
+            }
+
+            const uint32_t rotated = rotateLeft(a + f + word, c_shifts[i / 16][i % 4]);
+            a = d;
+            d = c;
+            c = b;
+            b = rotated;
         }
-        delete[] _pHashObject;
-        _pHashObject = nullptr;
+
+        state[0] += a;
+        state[1] += b;
+        state[2] += c;
+        state[3] += d;
     }
+}
 
-    static int init(CC_Digest_State** ctx, unsigned int digestLength, LPCWSTR algorithm) {
-        if (!ctx) {
-            return -1;
+void md5Compress(uint32_t* state, const uint8_t* blocks, size_t count) {
+    for (; count > 0; --count, blocks += CC_MD5_BLOCK_BYTES) {
+        uint32_t x[16];
+        for (size_t i = 0; i < 16; ++i) {
+            x[i] = loadLittleEndian32(blocks + i * 4);
         }
 
-        *ctx = nullptr;
+        uint32_t a = state[0], b = state[1], c = state[2], d = state[3];
+        for (unsigned i = 0; i < 64; ++i) {
+            uint32_t f;
+            if (i < 16) {
+                f = d ^ (b & (c ^ d));
+            } else if (i < 32) {
+                f = c ^ (d & (b ^ c));
+            } else if (i < 48) {
+                f = b ^ c ^ d;
+            } else {
+                f = c ^ (b | ~d);
+            }
 
-        CC_Digest_State* state = new CC_Digest_State(digestLength, algorithm);
-        if (!_isValidState(state)) {
-            return -1;
+            const uint32_t rotated = b + rotateLeft(a + f + c_md5Constants[i] + x[c_md5MessageIndex[i]], c_md5Shifts[(i / 16) * 4 + i % 4]);
+            a = d;
+            d = c;
+            c = b;
+            b = rotated;
         }
 
-        *ctx = state;
-        return 1;
+        state[0] += a;
+        state[1] += b;
+        state[2] += c;
+        state[3] += d;
     }
+}
+
+void sha1CompressPortable(uint32_t* state, const uint8_t* blocks, size_t count) {
+    for (; count > 0; --count, blocks += CC_SHA1_BLOCK_BYTES) {
+        uint32_t w[16];
+        for (size_t i = 0; i < 16; ++i) {
+            w[i] = loadBigEndian32(blocks + i * 4);
+        }
+
+        uint32_t a = state[0], b = state[1], c = state[2], d = state[3], e = state[4];
+        for (unsigned i = 0; i < 80; ++i) {
+            if (i >= 16) {
+                w[i % 16] = rotateLeft(w[(i + 13) % 16] ^ w[(i + 8) % 16] ^ w[(i + 2) % 16] ^ w[i % 16], 1);
+            }
 
-    // internal implemention of update for all hash contexts
-    static int update(CC_Digest_State** ctx, const void* data, CC_LONG len) {
-        CC_Digest_State* state = ctx ? *ctx : nullptr;
-        if (!_isValidState(state)) {
-            *ctx = nullptr;
-            return -1;
+            uint32_t f;
+            if (i < 20) {
+                f = d ^ (b & (c ^ d));
+            } else if (i < 40 || i >= 60) {
+                f = b ^ c ^ d;
+            } else {
+                f = (b & c) | (d & (b | c));
+            }
+
+            const uint32_t temp = rotateLeft(a, 5) + f + e + c_sha1Constants[i / 20] + w[i % 16];
+            e = d;
+            d = c;
+            c = rotateLeft(b, 30);
+            b = a;
+            a = temp;
         }
 
-        return state->_hashData(reinterpret_cast<const BYTE*>(data), len);
+        state[0] += a;
+        state[1] += b;
+        state[2] += c;
+        state[3] += d;
+        state[4] += e;
     }
+}
 
-    // internal implementaion of final for all hash contexts
-    static int final(unsigned char* digest, CC_Digest_State** ctx) {
-        CC_Digest_State* state = ctx ? *ctx : nullptr;
-        if (!_isValidState(state)) {
-            *ctx = nullptr;
-            return -1;
+void sha256CompressPortable(uint32_t* state, const uint8_t* blocks, size_t count) {
+    for (; count > 0; --count, blocks += CC_SHA256_BLOCK_BYTES) {
+        uint32_t w[16];
+        for (size_t i = 0; i < 16; ++i) {
+            w[i] = loadBigEndian32(blocks + i * 4);
         }
 
-        state->_finishHash(digest);
-        delete state;
+        uint32_t a = state[0], b = state[1], c = state[2], d = state[3], e = state[4], f = state[5], g = state[6], h = state[7];
+        for (unsigned i = 0; i < 64; ++i) {
+            if (i >= 16) {
+                const uint32_t w15 = w[(i + 1) % 16];
+                const uint32_t w2 = w[(i + 14) % 16];
+                const uint32_t s0 = rotateRight(w15, 7) ^ rotateRight(w15, 18) ^ (w15 >> 3);
+                const uint32_t s1 = rotateRight(w2, 17) ^ rotateRight(w2, 19) ^ (w2 >> 10);
+                w[i % 16] += s0 + w[(i + 9) % 16] + s1;
+            }
 
-        return 1;
+            const uint32_t t1 = h + (rotateRight(e, 6) ^ rotateRight(e, 11) ^ rotateRight(e, 25)) + (g ^ (e & (f ^ g))) +
+                                c_sha256Constants[i] + w[i % 16];
+            const uint32_t t2 = (rotateRight(a, 2) ^ rotateRight(a, 13) ^ rotateRight(a, 22)) + ((a & b) | (c & (a | b)));
+            h = g;
+            g = f;
+            f = e;
+            e = d + t1;
+            d = c;
+            c = b;
+            b = a;
+            a = t1 + t2;
+        }
+
+        state[0] += a;
+        state[1] += b;
+        state[2] += c;
+        state[3] += d;
+        state[4] += e;
+        state[5] += f;
+        state[6] += g;
+        state[7] += h;
     }
+}
+
+void sha512Compress(uint64_t* state, const uint8_t* blocks, size_t count) {
+    for (; count > 0; --count, blocks += CC_SHA512_BLOCK_BYTES) {
+        uint64_t w[16];
+        for (size_t i = 0; i < 16; ++i) {
+            w[i] = loadBigEndian64(blocks + i * 8);
+        }
 
-    // internal implementation of the one shot methods for all hash contexts
-    static unsigned char* oneShotDigest(int(*init)(CC_Digest_State**),
-        int(*update)(CC_Digest_State** ctx, const void* data, CC_LONG len),
-        int(*final)(unsigned char* digest, CC_Digest_State** ctx),
-        const void* input,
-        CC_LONG length,
-        unsigned char* digest) {
-        CC_Digest_State* ctx;
+        uint64_t a = state[0], b = state[1], c = state[2], d = state[3], e = state[4], f = state[5], g = state[6], h = state[7];
+        for (unsigned i = 0; i < 80; ++i) {
+            if (i >= 16) {
+                const uint64_t w15 = w[(i + 1) % 16];
+                const uint64_t w2 = w[(i + 14) % 16];
+                const uint64_t s0 = rotateRight(w15, 1) ^ rotateRight(w15, 8) ^ (w15 >> 7);
+                const uint64_t s1 = rotateRight(w2, 19) ^ rotateRight(w2, 61) ^ (w2 >> 6);
+                w[i % 16] += s0 + w[(i + 9) % 16] + s1;
+            }
 
-        if (init(&ctx) < 0) {
-            return nullptr;
+            const uint64_t t1 = h + (rotateRight(e, 14) ^ rotateRight(e, 18) ^ rotateRight(e, 41)) + (g ^ (e & (f ^ g))) +
+                                c_sha512Constants[i] + w[i % 16];
+            const uint64_t t2 = (rotateRight(a, 28) ^ rotateRight(a, 34) ^ rotateRight(a, 39)) + ((a & b) | (c & (a | b)));
+            h = g;
+            g = f;
+            f = e;
+            e = d + t1;
+            d = c;
+            c = b;
+            b = a;
+            a = t1 + t2;
         }
 
-        int updateResult = update(&ctx, input, length);
+        state[0] += a;
+        state[1] += b;
+        state[2] += c;
+        state[3] += d;
+        state[4] += e;
+        state[5] += f;
+        state[6] += g;
+        state[7] += h;
+    }
+}
+
+#pragma endregion
+
+#pragma region x86 SHA extensions
+
+#if (DIGEST_X86 == 1)
+void cpuid(int info[4], int leaf, int subleaf) {
+#if defined(_MSC_VER)
+    __cpuidex(info, leaf, subleaf);
+#else
+    __cpuid_count(leaf, subleaf, info[0], info[1], info[2], info[3]);
+#endif
+}
+
+DIGEST_TARGET("xsave") uint64_t enabledProcessorState() {
+    return _xgetbv(0);
+}
+
+struct X86Features {
+    bool sha;
+    bool avx2;
+};
+
+X86Features detectX86Features() {
+    X86Features features = { false, false };
+
+    int info[4];
+    cpuid(info, 0, 0);
+    if (info[0] < 7) {
+        return features;
+    }
 
-        // Final should be called even if update fails.
-        if (final(digest, &ctx) < 0) {
-            return nullptr;
+    cpuid(info, 1, 0);
+    const bool ssse3 = (info[2] & (1 << 9)) != 0;
+    const bool sse41 = (info[2] & (1 << 19)) != 0;
+    const bool osxsave = (info[2] & (1 << 27)) != 0;
+    const bool avx = (info[2] & (1 << 28)) != 0;
+
+    cpuid(info, 7, 0);
+    features.sha = ssse3 && sse41 && (info[1] & (1 << 29)) != 0;
+
+    //  AVX2 also needs the OS to save the YMM registers
+    features.avx2 = osxsave && avx && ((enabledProcessorState() & 0x6) == 0x6) && (info[1] & (1 << 5)) != 0;
+    return features;
+}
+
+const X86Features c_x86Features = detectX86Features();
+
+DIGEST_TARGET("sha,sse4.1") void sha1CompressX86(uint32_t* state, const uint8_t* blocks, size_t count) {
+    const __m128i byteSwap = _mm_set_epi64x(0x0001020304050607ULL, 0x08090a0b0c0d0e0fULL);
+
+    __m128i abcd = _mm_shuffle_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(state)), 0x1b);
+    __m128i e0 = _mm_set_epi32(static_cast<int>(state[4]), 0, 0, 0);
+
+    for (; count > 0; --count, blocks += CC_SHA1_BLOCK_BYTES) {
+        const __m128i abcdSaved = abcd;
+        const __m128i eSaved = e0;
+
+        __m128i w[20];
+        for (int i = 0; i < 4; ++i) {
+            w[i] = _mm_shuffle_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(blocks + i * 16)), byteSwap);
+        }
+        for (int i = 4; i < 20; ++i) {
+            w[i] = _mm_sha1msg2_epu32(_mm_xor_si128(_mm_sha1msg1_epu32(w[i - 4], w[i - 3]), w[i - 2]), w[i - 1]);
         }
 
-        if (updateResult < 0) {
-            return nullptr;
+        //  Each group of four rounds takes E from the A of four rounds earlier
+        __m128i e = _mm_add_epi32(e0, w[0]);
+        __m128i previous = abcd;
+        abcd = _mm_sha1rnds4_epu32(abcd, e, 0);
+        for (int i = 1; i < 5; ++i) {
+            e = _mm_sha1nexte_epu32(previous, w[i]);
+            previous = abcd;
+            abcd = _mm_sha1rnds4_epu32(abcd, e, 0);
+        }
+        for (int i = 5; i < 10; ++i) {
+            e = _mm_sha1nexte_epu32(previous, w[i]);
+            previous = abcd;
+            abcd = _mm_sha1rnds4_epu32(abcd, e, 1);
+        }
+        for (int i = 10; i < 15; ++i) {
+            e = _mm_sha1nexte_epu32(previous, w[i]);
+            previous = abcd;
+            abcd = _mm_sha1rnds4_epu32(abcd, e, 2);
+        }
+        for (int i = 15; i < 20; ++i) {
+            e = _mm_sha1nexte_epu32(previous, w[i]);
+            previous = abcd;
+            abcd = _mm_sha1rnds4_epu32(abcd, e, 3);
         }
 
-        return digest;
+        e0 = _mm_sha1nexte_epu32(previous, eSaved);
+        abcd = _mm_add_epi32(abcd, abcdSaved);
     }
 
-private:
-    NTSTATUS _init() {
-        DWORD cbHashObject;
-        DWORD cbResult;
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(state), _mm_shuffle_epi32(abcd, 0x1b));
+    state[4] = static_cast<uint32_t>(_mm_extract_epi32(e0, 3));
+}
+
+DIGEST_TARGET("sha,sse4.1") void sha256CompressX86(uint32_t* state, const uint8_t* blocks, size_t count) {
+    const __m128i byteSwap = _mm_set_epi64x(0x0c0d0e0f08090a0bULL, 0x0405060700010203ULL);
+
+    //  The round instructions keep the state as ABEF and CDGH
+    __m128i cdab = _mm_shuffle_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(state)), 0xb1);
+    __m128i efgh = _mm_shuffle_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(state + 4)), 0x1b);
+    __m128i abef = _mm_alignr_epi8(cdab, efgh, 8);
+    __m128i cdgh = _mm_blend_epi16(efgh, cdab, 0xf0);
 
-        RETURN_IF_NTSTATUS_FAILED_LOG(BCryptOpenAlgorithmProvider(&_hAlg, _algorithm, NULL, 0));
-        RETURN_IF_NTSTATUS_FAILED_LOG(
-            BCryptGetProperty(_hAlg, BCRYPT_OBJECT_LENGTH, reinterpret_cast<PBYTE>(&cbHashObject), sizeof(DWORD), &cbResult, 0));
+    for (; count > 0; --count, blocks += CC_SHA256_BLOCK_BYTES) {
+        const __m128i abefSaved = abef;
+        const __m128i cdghSaved = cdgh;
 
-        _pHashObject = new BYTE[cbHashObject];
-        if (_pHashObject == nullptr) {
-            RETURN_IF_NTSTATUS_FAILED_MSG(STATUS_NO_MEMORY, "CC_Digest_State Unable to allocate Hash object");
+        __m128i w[16];
+        for (int i = 0; i < 16; ++i) {
+            if (i < 4) {
+                w[i] = _mm_shuffle_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(blocks + i * 16)), byteSwap);
+            } else {
+                const __m128i partial = _mm_add_epi32(_mm_sha256msg1_epu32(w[i - 4], w[i - 3]), _mm_alignr_epi8(w[i - 1], w[i - 2], 4));
+                w[i] = _mm_sha256msg2_epu32(partial, w[i - 1]);
+            }
+
+            __m128i message = _mm_add_epi32(w[i], _mm_load_si128(reinterpret_cast<const __m128i*>(c_sha256Constants + i * 4)));
+            cdgh = _mm_sha256rnds2_epu32(cdgh, abef, message);
+            message = _mm_shuffle_epi32(message, 0x0e);
+            abef = _mm_sha256rnds2_epu32(abef, cdgh, message);
         }
 
-        RETURN_IF_NTSTATUS_FAILED_LOG(BCryptCreateHash(_hAlg, &_hHash, _pHashObject, cbHashObject, NULL, 0, 0));
+        abef = _mm_add_epi32(abef, abefSaved);
+        cdgh = _mm_add_epi32(cdgh, cdghSaved);
+    }
+
+    const __m128i feba = _mm_shuffle_epi32(abef, 0x1b);
+    const __m128i dchg = _mm_shuffle_epi32(cdgh, 0xb1);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(state), _mm_blend_epi16(feba, dchg, 0xf0));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(state + 4), _mm_alignr_epi8(dchg, feba, 8));
+}
+#endif
+
+#pragma endregion
 
-        return 0;
+#pragma region ARMv8 crypto extensions
+
+#if (DIGEST_ARM == 1)
+bool detectArmHashInstructions() {
+#if defined(_WIN32)
+    return IsProcessorFeaturePresent(PF_ARM_V8_CRYPTO_INSTRUCTIONS_AVAILABLE) != FALSE;
+#else
+    const unsigned long capabilities = getauxval(AT_HWCAP);
+    return (capabilities & HWCAP_SHA1) && (capabilities & HWCAP_SHA2);
+#endif
+}
+
+const bool c_armHashInstructions = detectArmHashInstructions();
+
+inline uint32x4_t loadBigEndianArm(const uint8_t* p) {
+    return vreinterpretq_u32_u8(vrev32q_u8(vld1q_u8(p)));
+}
+
+void sha1CompressArm(uint32_t* state, const uint8_t* blocks, size_t count) {
+    uint32x4_t abcd = vld1q_u32(state);
+    uint32_t e0 = state[4];
+
+    for (; count > 0; --count, blocks += CC_SHA1_BLOCK_BYTES) {
+        const uint32x4_t abcdSaved = abcd;
+        const uint32_t eSaved = e0;
+
+        uint32x4_t w[20];
+        for (int i = 0; i < 4; ++i) {
+            w[i] = loadBigEndianArm(blocks + i * 16);
+        }
+        for (int i = 4; i < 20; ++i) {
+            w[i] = vsha1su1q_u32(vsha1su0q_u32(w[i - 4], w[i - 3], w[i - 2]), w[i - 1]);
+        }
+
+        uint32_t e = e0;
+        for (int i = 0; i < 20; ++i) {
+            const uint32x4_t message = vaddq_u32(w[i], vdupq_n_u32(c_sha1Constants[i / 5]));
+            const uint32_t nextE = vsha1h_u32(vgetq_lane_u32(abcd, 0));
+            if (i < 5) {
+                abcd = vsha1cq_u32(abcd, e, message);
+            } else if (i < 10 || i >= 15) {
+                abcd = vsha1pq_u32(abcd, e, message);
+            } else {
+                abcd = vsha1mq_u32(abcd, e, message);
+            }
+
+            e = nextE;
+        }
+
+        e0 = e + eSaved;
+        abcd = vaddq_u32(abcd, abcdSaved);
     }
 
-    static bool _isValidState(CC_Digest_State* state) {
-        if (!state) {
-            return false;
+    vst1q_u32(state, abcd);
+    state[4] = e0;
+}
+
+void sha256CompressArm(uint32_t* state, const uint8_t* blocks, size_t count) {
+    uint32x4_t abcd = vld1q_u32(state);
+    uint32x4_t efgh = vld1q_u32(state + 4);
+
+    for (; count > 0; --count, blocks += CC_SHA256_BLOCK_BYTES) {
+        const uint32x4_t abcdSaved = abcd;
+        const uint32x4_t efghSaved = efgh;
+
+        uint32x4_t w[16];
+        for (int i = 0; i < 16; ++i) {
+            if (i < 4) {
+                w[i] = loadBigEndianArm(blocks + i * 16);
+            } else {
+                w[i] = vsha256su1q_u32(vsha256su0q_u32(w[i - 4], w[i - 3]), w[i - 2], w[i - 1]);
+            }
+
+            const uint32x4_t message = vaddq_u32(w[i], vld1q_u32(c_sha256Constants + i * 4));
+            const uint32x4_t previous = abcd;
+            abcd = vsha256hq_u32(abcd, efgh, message);
+            efgh = vsha256h2q_u32(efgh, previous, message);
         }
 
-        // at this point, state has to be either NULL or valid
-        if (state->_hHash == INVALID_HANDLE_VALUE) {
-            delete state;
-            return false;
+        abcd = vaddq_u32(abcd, abcdSaved);
+        efgh = vaddq_u32(efgh, efghSaved);
+    }
+
+    vst1q_u32(state, abcd);
+    vst1q_u32(state + 4, efgh);
+}
+#endif
+
+#pragma endregion
+
+typedef void (*BlockFunction32)(uint32_t* state, const uint8_t* blocks, size_t count);
+
+BlockFunction32 selectSha1Compress() {
+#if (DIGEST_X86 == 1)
+    if (c_x86Features.sha) {
+        return sha1CompressX86;
+    }
+#elif (DIGEST_ARM == 1)
+    if (c_armHashInstructions) {
+        return sha1CompressArm;
+    }
+#endif
+    return sha1CompressPortable;
+}
+
+BlockFunction32 selectSha256Compress() {
+#if (DIGEST_X86 == 1)
+    if (c_x86Features.sha) {
+        return sha256CompressX86;
+    }
+#elif (DIGEST_ARM == 1)
+    if (c_armHashInstructions) {
+        return sha256CompressArm;
+    }
+#endif
+    return sha256CompressPortable;
+}
+
+const BlockFunction32 c_sha1Compress = selectSha1Compress();
+const BlockFunction32 c_sha256Compress = selectSha256Compress();
+
+#pragma region Streaming
+
+size_t blockSize(CC_LONG algorithm) {
+    switch (algorithm) {
+        case c_digestMD2:
+            return CC_MD2_BLOCK_BYTES;
+        case c_digestSHA384:
+        case c_digestSHA512:
+            return CC_SHA512_BLOCK_BYTES;
+        default:
+            return CC_SHA256_BLOCK_BYTES;
+    }
+}
+
+bool isValid(const CC_Digest_State* ctx) {
+    return ctx && (ctx->algorithm >= c_digestMD2) && (ctx->algorithm <= c_digestSHA512) &&
+           (ctx->bufferLength < blockSize(ctx->algorithm));
+}
+
+// The 32 bit algorithms keep one word in each element of the context's state
+void loadState(const CC_Digest_State* ctx, uint32_t* words, size_t count) {
+    for (size_t i = 0; i < count; ++i) {
+        words[i] = static_cast<uint32_t>(ctx->state[i]);
+    }
+}
+
+void storeState(CC_Digest_State* ctx, const uint32_t* words, size_t count) {
+    for (size_t i = 0; i < count; ++i) {
+        ctx->state[i] = words[i];
+    }
+}
+
+void compress(CC_Digest_State* ctx, const uint8_t* blocks, size_t count) {
+    uint32_t words[8];
+
+    switch (ctx->algorithm) {
+        case c_digestMD2: {
+            uint8_t state[32];
+            memcpy(state, ctx->state, sizeof(state));
+            md2Compress(state, blocks, count);
+            memcpy(ctx->state, state, sizeof(state));
+            break;
         }
 
-        return true;
+        case c_digestMD4:
+            loadState(ctx, words, 4);
+            md4Compress(words, blocks, count);
+            storeState(ctx, words, 4);
+            break;
+
+        case c_digestMD5:
+            loadState(ctx, words, 4);
+            md5Compress(words, blocks, count);
+            storeState(ctx, words, 4);
+            break;
+
+        case c_digestSHA1:
+            loadState(ctx, words, 5);
+            c_sha1Compress(words, blocks, count);
+            storeState(ctx, words, 5);
+            break;
+
+        case c_digestSHA224:
+        case c_digestSHA256:
+            loadState(ctx, words, 8);
+            c_sha256Compress(words, blocks, count);
+            storeState(ctx, words, 8);
+            break;
+
+        default:
+            sha512Compress(ctx->state, blocks, count);
+            break;
+    }
+}
+
+int initDigest(CC_Digest_State* ctx, DigestAlgorithm algorithm) {
+    if (!ctx) {
+        return -1;
     }
 
-    int _hashData(const BYTE* data, CC_LONG length) {
-        NTSTATUS status = BCryptHashData(_hHash, const_cast<BYTE*>(data), length, 0);
-        if (SUCCEEDED_NTSTATUS(status)) {
+    memset(ctx, 0, sizeof(*ctx));
+    ctx->algorithm = algorithm;
+
+    switch (algorithm) {
+        case c_digestMD2:
+            break;
+        case c_digestMD4:
+        case c_digestMD5:
+            storeState(ctx, c_md5Initial, 4);
+            break;
+        case c_digestSHA1:
+            storeState(ctx, c_sha1Initial, 5);
+            break;
+        case c_digestSHA224:
+            storeState(ctx, c_sha224Initial, 8);
+            break;
+        case c_digestSHA256:
+            storeState(ctx, c_sha256Initial, 8);
+            break;
+        case c_digestSHA384:
+            memcpy(ctx->state, c_sha384Initial, sizeof(c_sha384Initial));
+            break;
+        case c_digestSHA512:
+            memcpy(ctx->state, c_sha512Initial, sizeof(c_sha512Initial));
+            break;
+    }
+
+    return 1;
+}
+
+int updateDigest(CC_Digest_State* ctx, const void* data, CC_LONG length) {
+    if (!isValid(ctx) || (!data && length > 0)) {
+        return -1;
+    }
+
+    //  Nothing to hash; data may be NULL, which memcpy must not be given even for zero bytes
+    if (length == 0) {
+        return 1;
+    }
+
+    const uint8_t* bytes = static_cast<const uint8_t*>(data);
+    const size_t block = blockSize(ctx->algorithm);
+
+    ctx->count[0] += length;
+    if (ctx->count[0] < length) {
+        ++ctx->count[1];
+    }
+
+    if (ctx->bufferLength > 0) {
+        const size_t fill = std::min<size_t>(block - ctx->bufferLength, length);
+        memcpy(ctx->buffer + ctx->bufferLength, bytes, fill);
+        ctx->bufferLength += static_cast<CC_LONG>(fill);
+        bytes += fill;
+        length -= static_cast<CC_LONG>(fill);
+
+        if (ctx->bufferLength < block) {
             return 1;
         }
 
-        LOG_NTSTATUS_MSG(status, "BCryptHashData failed\n");
+        compress(ctx, ctx->buffer, 1);
+        ctx->bufferLength = 0;
+    }
+
+    //  Whole blocks are hashed straight from the caller's buffer
+    const size_t blocks = length / block;
+    if (blocks > 0) {
+        compress(ctx, bytes, blocks);
+        bytes += blocks * block;
+        length -= static_cast<CC_LONG>(blocks * block);
+    }
+
+    memcpy(ctx->buffer, bytes, length);
+    ctx->bufferLength = length;
+    return 1;
+}
+
+int finalDigest(unsigned char* digest, CC_Digest_State* ctx) {
+    if (!isValid(ctx) || !digest) {
         return -1;
     }
 
-    void _finishHash(BYTE* digest) {
-        LOG_IF_NTSTATUS_FAILED(BCryptFinishHash(_hHash, digest, _digestLength, 0));
+    const CC_LONG algorithm = ctx->algorithm;
+    const size_t block = blockSize(algorithm);
+
+    if (algorithm == c_digestMD2) {
+        //  Pad with n bytes of value n, then hash the checksum as one more block
+        const uint8_t padding = static_cast<uint8_t>(block - ctx->bufferLength);
+        memset(ctx->buffer + ctx->bufferLength, padding, padding);
+        compress(ctx, ctx->buffer, 1);
+
+        uint8_t state[32];
+        memcpy(state, ctx->state, sizeof(state));
+        compress(ctx, state + 16, 1);
+        memcpy(state, ctx->state, sizeof(state));
+        memcpy(digest, state, CC_MD2_DIGEST_LENGTH);
+    } else {
+        //  A single 1 bit, zeros, then the message length in bits in the last 8 (or 16) bytes of a block
+        const size_t lengthBytes = (block == CC_SHA512_BLOCK_BYTES) ? 16 : 8;
+        ctx->buffer[ctx->bufferLength++] = 0x80;
+        if (ctx->bufferLength > block - lengthBytes) {
+            memset(ctx->buffer + ctx->bufferLength, 0, block - ctx->bufferLength);
+            compress(ctx, ctx->buffer, 1);
+            ctx->bufferLength = 0;
+        }
+
+        memset(ctx->buffer + ctx->bufferLength, 0, block - ctx->bufferLength);
+        const uint64_t bitsLow = ctx->count[0] << 3;
+        const uint64_t bitsHigh = (ctx->count[1] << 3) | (ctx->count[0] >> 61);
+        if (algorithm == c_digestMD4 || algorithm == c_digestMD5) {
+            storeLittleEndian64(ctx->buffer + block - 8, bitsLow);
+        } else {
+            storeBigEndian64(ctx->buffer + block - 8, bitsLow);
+            if (lengthBytes == 16) {
+                storeBigEndian64(ctx->buffer + block - 16, bitsHigh);
+            }
+        }
+
+        compress(ctx, ctx->buffer, 1);
+
+        switch (algorithm) {
+            case c_digestMD4:
+            case c_digestMD5:
+                for (size_t i = 0; i < 4; ++i) {
+                    storeLittleEndian32(digest + i * 4, static_cast<uint32_t>(ctx->state[i]));
+                }
+                break;
+
+            case c_digestSHA1:
+            case c_digestSHA224:
+            case c_digestSHA256: {
+                const size_t digestLength =
+                    (algorithm == c_digestSHA1) ? CC_SHA1_DIGEST_LENGTH : (algorithm == c_digestSHA224) ? CC_SHA224_DIGEST_LENGTH :
+                                                                                                          CC_SHA256_DIGEST_LENGTH;
+                for (size_t i = 0; i < digestLength / 4; ++i) {
+                    storeBigEndian32(digest + i * 4, static_cast<uint32_t>(ctx->state[i]));
+                }
+                break;
+            }
+
+            default: {
+                const size_t digestLength = (algorithm == c_digestSHA384) ? CC_SHA384_DIGEST_LENGTH : CC_SHA512_DIGEST_LENGTH;
+                for (size_t i = 0; i < digestLength / 8; ++i) {
+                    storeBigEndian64(digest + i * 8, ctx->state[i]);
+                }
+                break;
+            }
+        }
+    }
+
+    //  Leave nothing of the message behind in the caller's context
+    memset(ctx, 0, sizeof(*ctx));
+    return 1;
+}
+
+unsigned char* oneShotDigest(DigestAlgorithm algorithm, const void* data, CC_LONG length, unsigned char* digest) {
+    CC_Digest_State ctx;
+    initDigest(&ctx, algorithm);
+    if (updateDigest(&ctx, data, length) < 0 || finalDigest(digest, &ctx) < 0) {
+        return nullptr;
     }
 
-    const unsigned int _digestLength;
-    const LPCWSTR _algorithm;
-    BCRYPT_ALG_HANDLE _hAlg;
-    BCRYPT_HASH_HANDLE _hHash;
-    PBYTE _pHashObject;
+    return digest;
+}
+
+#pragma endregion
+
+#pragma region Multi-buffer
+
+// Feeds up to c_lanes messages through a lane-parallel block function, one 64 byte block per lane per call. Each lane
+// walks its message's whole blocks in place, then one or two padding blocks built from the tail; a lane that finishes
+// stores its digest and picks up the next message, so messages of mixed lengths keep every lane busy.
+template <typename Kernel>
+void hashLanes(const void* const* data, const CC_LONG* lengths, size_t count, unsigned char* digests) {
+    static const size_t c_lanes = Kernel::lanes;
+    static const size_t c_block = 64;
+
+    struct Lane {
+        const uint8_t* next;
+        size_t wholeBlocks;
+        size_t paddingBlocks;
+        size_t paddingIndex;
+        size_t message;
+        bool active;
+        uint8_t padding[2 * c_block];
+    };
+
+    static const uint8_t c_idleBlock[c_block] = {};
+    Lane lanes[c_lanes];
+    alignas(32) uint32_t state[Kernel::words][c_lanes];
+    size_t nextMessage = 0;
+
+    auto start = [&](size_t lane) {
+        Lane& current = lanes[lane];
+        current.active = nextMessage < count;
+        if (!current.active) {
+            return;
+        }
+
+        current.message = nextMessage++;
+        const uint8_t* bytes = static_cast<const uint8_t*>(data[current.message]);
+        const size_t length = lengths[current.message];
+        const size_t tail = length % c_block;
+
+        current.next = bytes;
+        current.wholeBlocks = length / c_block;
+        current.paddingBlocks = (tail + 9 > c_block) ? 2 : 1;
+        current.paddingIndex = 0;
+
+        memset(current.padding, 0, sizeof(current.padding));
+        memcpy(current.padding, bytes + length - tail, tail);
+        current.padding[tail] = 0x80;
+        Kernel::storeLength(current.padding + current.paddingBlocks * c_block - 8, static_cast<uint64_t>(length) << 3);
+
+        for (size_t word = 0; word < Kernel::words; ++word) {
+            state[word][lane] = Kernel::initial[word];
+        }
+    };
+
+    for (size_t lane = 0; lane < c_lanes; ++lane) {
+        start(lane);
+    }
+
+    for (;;) {
+        const uint8_t* blocks[c_lanes];
+        bool anyActive = false;
+
+        for (size_t lane = 0; lane < c_lanes; ++lane) {
+            Lane& current = lanes[lane];
+            if (!current.active) {
+                blocks[lane] = c_idleBlock;
+                continue;
+            }
+
+            anyActive = true;
+            if (current.wholeBlocks > 0) {
+                blocks[lane] = current.next;
+                current.next += c_block;
+                --current.wholeBlocks;
+            } else {
+                blocks[lane] = current.padding + c_block * current.paddingIndex++;
+            }
+        }
+
+        if (!anyActive) {
+            break;
+        }
+
+        Kernel::compress(state, blocks);
+
+        for (size_t lane = 0; lane < c_lanes; ++lane) {
+            Lane& current = lanes[lane];
+            if (current.active && current.wholeBlocks == 0 && current.paddingIndex == current.paddingBlocks) {
+                unsigned char* digest = digests + current.message * Kernel::digestLength;
+                for (size_t word = 0; word < Kernel::digestLength / 4; ++word) {
+                    Kernel::storeWord(digest + word * 4, state[word][lane]);
+                }
+
+                start(lane);
+            }
+        }
+    }
+}
+
+#if (DIGEST_X86 == 1)
+// Transposes eight rows of eight words, so that row i of the result holds word i of every input row
+DIGEST_TARGET("avx2") inline void transpose8x8(__m256i* rows) {
+    const __m256i t0 = _mm256_unpacklo_epi32(rows[0], rows[1]);
+    const __m256i t1 = _mm256_unpackhi_epi32(rows[0], rows[1]);
+    const __m256i t2 = _mm256_unpacklo_epi32(rows[2], rows[3]);
+    const __m256i t3 = _mm256_unpackhi_epi32(rows[2], rows[3]);
+    const __m256i t4 = _mm256_unpacklo_epi32(rows[4], rows[5]);
+    const __m256i t5 = _mm256_unpackhi_epi32(rows[4], rows[5]);
+    const __m256i t6 = _mm256_unpacklo_epi32(rows[6], rows[7]);
+    const __m256i t7 = _mm256_unpackhi_epi32(rows[6], rows[7]);
+
+    const __m256i u0 = _mm256_unpacklo_epi64(t0, t2);
+    const __m256i u1 = _mm256_unpackhi_epi64(t0, t2);
+    const __m256i u2 = _mm256_unpacklo_epi64(t1, t3);
+    const __m256i u3 = _mm256_unpackhi_epi64(t1, t3);
+    const __m256i u4 = _mm256_unpacklo_epi64(t4, t6);
+    const __m256i u5 = _mm256_unpackhi_epi64(t4, t6);
+    const __m256i u6 = _mm256_unpacklo_epi64(t5, t7);
+    const __m256i u7 = _mm256_unpackhi_epi64(t5, t7);
+
+    rows[0] = _mm256_permute2x128_si256(u0, u4, 0x20);
+    rows[1] = _mm256_permute2x128_si256(u1, u5, 0x20);
+    rows[2] = _mm256_permute2x128_si256(u2, u6, 0x20);
+    rows[3] = _mm256_permute2x128_si256(u3, u7, 0x20);
+    rows[4] = _mm256_permute2x128_si256(u0, u4, 0x31);
+    rows[5] = _mm256_permute2x128_si256(u1, u5, 0x31);
+    rows[6] = _mm256_permute2x128_si256(u2, u6, 0x31);
+    rows[7] = _mm256_permute2x128_si256(u3, u7, 0x31);
+}
+
+// Loads the 16 words of each lane's block so that message[i] holds word i of every lane
+DIGEST_TARGET("avx2") inline void loadMessages(const uint8_t* const* blocks, __m256i* message, bool bigEndian) {
+    for (int half = 0; half < 2; ++half) {
+        __m256i* rows = message + half * 8;
+        for (int lane = 0; lane < 8; ++lane) {
+            rows[lane] = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(blocks[lane] + half * 32));
+        }
+
+        transpose8x8(rows);
+    }
+
+    if (bigEndian) {
+        const __m256i byteSwap =
+            _mm256_set_epi8(12, 13, 14, 15, 8, 9, 10, 11, 4, 5, 6, 7, 0, 1, 2, 3, 12, 13, 14, 15, 8, 9, 10, 11, 4, 5, 6, 7, 0, 1, 2, 3);
+        for (int i = 0; i < 16; ++i) {
+            message[i] = _mm256_shuffle_epi8(message[i], byteSwap);
+        }
+    }
+}
+
+DIGEST_TARGET("avx2") inline __m256i rotateLeft8(__m256i value, int bits) {
+    return _mm256_or_si256(_mm256_sll_epi32(value, _mm_cvtsi32_si128(bits)), _mm256_srl_epi32(value, _mm_cvtsi32_si128(32 - bits)));
+}
+
+DIGEST_TARGET("avx2") inline __m256i add8(__m256i a, __m256i b) {
+    return _mm256_add_epi32(a, b);
+}
+
+struct Md5Avx2 {
+    static const size_t lanes = 8;
+    static const size_t words = 4;
+    static const size_t digestLength = CC_MD5_DIGEST_LENGTH;
+    static const uint32_t* const initial;
+
+    static void storeLength(uint8_t* p, uint64_t bits) {
+        storeLittleEndian64(p, bits);
+    }
+
+    static void storeWord(uint8_t* p, uint32_t word) {
+        storeLittleEndian32(p, word);
+    }
+
+    DIGEST_TARGET("avx2") static void compress(uint32_t (*state)[8], const uint8_t* const* blocks) {
+        __m256i x[16];
+        loadMessages(blocks, x, false);
+
+        const __m256i ones = _mm256_set1_epi32(-1);
+        __m256i a = _mm256_load_si256(reinterpret_cast<const __m256i*>(state[0]));
+        __m256i b = _mm256_load_si256(reinterpret_cast<const __m256i*>(state[1]));
+        __m256i c = _mm256_load_si256(reinterpret_cast<const __m256i*>(state[2]));
+        __m256i d = _mm256_load_si256(reinterpret_cast<const __m256i*>(state[3]));
+        const __m256i a0 = a, b0 = b, c0 = c, d0 = d;
+
+        for (int i = 0; i < 64; ++i) {
+            __m256i f;
+            if (i < 16) {
+                f = _mm256_xor_si256(d, _mm256_and_si256(b, _mm256_xor_si256(c, d)));
+            } else if (i < 32) {
+                f = _mm256_xor_si256(c, _mm256_and_si256(d, _mm256_xor_si256(b, c)));
+            } else if (i < 48) {
+                f = _mm256_xor_si256(_mm256_xor_si256(b, c), d);
+            } else {
+                f = _mm256_xor_si256(c, _mm256_or_si256(b, _mm256_xor_si256(d, ones)));
+            }
+
+            const __m256i sum = add8(add8(a, f), add8(x[c_md5MessageIndex[i]], _mm256_set1_epi32(static_cast<int>(c_md5Constants[i]))));
+            const __m256i rotated = add8(b, rotateLeft8(sum, c_md5Shifts[(i / 16) * 4 + i % 4]));
+            a = d;
+            d = c;
+            c = b;
+            b = rotated;
+        }
+
+        _mm256_store_si256(reinterpret_cast<__m256i*>(state[0]), add8(a, a0));
+        _mm256_store_si256(reinterpret_cast<__m256i*>(state[1]), add8(b, b0));
+        _mm256_store_si256(reinterpret_cast<__m256i*>(state[2]), add8(c, c0));
+        _mm256_store_si256(reinterpret_cast<__m256i*>(state[3]), add8(d, d0));
+    }
+};
+
+const uint32_t* const Md5Avx2::initial = c_md5Initial;
+
+struct Sha1Avx2 {
+    static const size_t lanes = 8;
+    static const size_t words = 5;
+    static const size_t digestLength = CC_SHA1_DIGEST_LENGTH;
+    static const uint32_t* const initial;
+
+    static void storeLength(uint8_t* p, uint64_t bits) {
+        storeBigEndian64(p, bits);
+    }
+
+    static void storeWord(uint8_t* p, uint32_t word) {
+        storeBigEndian32(p, word);
+    }
+
+    DIGEST_TARGET("avx2") static void compress(uint32_t (*state)[8], const uint8_t* const* blocks) {
+        __m256i w[16];
+        loadMessages(blocks, w, true);
+
+        __m256i v[5];
+        for (int i = 0; i < 5; ++i) {
+            v[i] = _mm256_load_si256(reinterpret_cast<const __m256i*>(state[i]));
+        }
+
+        __m256i a = v[0], b = v[1], c = v[2], d = v[3], e = v[4];
+        for (int i = 0; i < 80; ++i) {
+            if (i >= 16) {
+                const __m256i mixed = _mm256_xor_si256(_mm256_xor_si256(w[(i + 13) % 16], w[(i + 8) % 16]),
+                                                       _mm256_xor_si256(w[(i + 2) % 16], w[i % 16]));
+                w[i % 16] = rotateLeft8(mixed, 1);
+            }
+
+            __m256i f;
+            if (i < 20) {
+                f = _mm256_xor_si256(d, _mm256_and_si256(b, _mm256_xor_si256(c, d)));
+            } else if (i < 40 || i >= 60) {
+                f = _mm256_xor_si256(_mm256_xor_si256(b, c), d);
+            } else {
+                f = _mm256_or_si256(_mm256_and_si256(b, c), _mm256_and_si256(d, _mm256_or_si256(b, c)));
+            }
+
+            const __m256i constant = _mm256_set1_epi32(static_cast<int>(c_sha1Constants[i / 20]));
+            const __m256i temp = add8(add8(rotateLeft8(a, 5), f), add8(add8(e, constant), w[i % 16]));
+            e = d;
+            d = c;
+            c = rotateLeft8(b, 30);
+            b = a;
+            a = temp;
+        }
+
+        const __m256i result[5] = { add8(a, v[0]), add8(b, v[1]), add8(c, v[2]), add8(d, v[3]), add8(e, v[4]) };
+        for (int i = 0; i < 5; ++i) {
+            _mm256_store_si256(reinterpret_cast<__m256i*>(state[i]), result[i]);
+        }
+    }
+};
+
+const uint32_t* const Sha1Avx2::initial = c_sha1Initial;
+
+DIGEST_TARGET("avx2") inline __m256i rotateRight8(__m256i value, int bits) {
+    return rotateLeft8(value, 32 - bits);
+}
+
+struct Sha256Avx2 {
+    static const size_t lanes = 8;
+    static const size_t words = 8;
+    static const size_t digestLength = CC_SHA256_DIGEST_LENGTH;
+    static const uint32_t* const initial;
+
+    static void storeLength(uint8_t* p, uint64_t bits) {
+        storeBigEndian64(p, bits);
+    }
+
+    static void storeWord(uint8_t* p, uint32_t word) {
+        storeBigEndian32(p, word);
+    }
+
+    DIGEST_TARGET("avx2") static void compress(uint32_t (*state)[8], const uint8_t* const* blocks) {
+        __m256i w[16];
+        loadMessages(blocks, w, true);
+
+        __m256i v[8];
+        for (int i = 0; i < 8; ++i) {
+            v[i] = _mm256_load_si256(reinterpret_cast<const __m256i*>(state[i]));
+        }
+
+        __m256i a = v[0], b = v[1], c = v[2], d = v[3], e = v[4], f = v[5], g = v[6], h = v[7];
+        for (int i = 0; i < 64; ++i) {
+            if (i >= 16) {
+                const __m256i w15 = w[(i + 1) % 16];
+                const __m256i w2 = w[(i + 14) % 16];
+                const __m256i s0 =
+                    _mm256_xor_si256(_mm256_xor_si256(rotateRight8(w15, 7), rotateRight8(w15, 18)), _mm256_srli_epi32(w15, 3));
+                const __m256i s1 =
+                    _mm256_xor_si256(_mm256_xor_si256(rotateRight8(w2, 17), rotateRight8(w2, 19)), _mm256_srli_epi32(w2, 10));
+                w[i % 16] = add8(add8(w[i % 16], s0), add8(w[(i + 9) % 16], s1));
+            }
+
+            const __m256i sigma1 = _mm256_xor_si256(_mm256_xor_si256(rotateRight8(e, 6), rotateRight8(e, 11)), rotateRight8(e, 25));
+            const __m256i choose = _mm256_xor_si256(g, _mm256_and_si256(e, _mm256_xor_si256(f, g)));
+            const __m256i constant = _mm256_set1_epi32(static_cast<int>(c_sha256Constants[i]));
+            const __m256i t1 = add8(add8(add8(h, sigma1), add8(choose, constant)), w[i % 16]);
+
+            const __m256i sigma0 = _mm256_xor_si256(_mm256_xor_si256(rotateRight8(a, 2), rotateRight8(a, 13)), rotateRight8(a, 22));
+            const __m256i majority = _mm256_or_si256(_mm256_and_si256(a, b), _mm256_and_si256(c, _mm256_or_si256(a, b)));
+            const __m256i t2 = add8(sigma0, majority);
+
+            h = g;
+            g = f;
+            f = e;
+            e = add8(d, t1);
+            d = c;
+            c = b;
+            b = a;
+            a = add8(t1, t2);
+        }
+
+        const __m256i result[8] = { add8(a, v[0]), add8(b, v[1]), add8(c, v[2]), add8(d, v[3]),
+                                    add8(e, v[4]), add8(f, v[5]), add8(g, v[6]), add8(h, v[7]) };
+        for (int i = 0; i < 8; ++i) {
+            _mm256_store_si256(reinterpret_cast<__m256i*>(state[i]), result[i]);
+        }
+    }
 };
 
+const uint32_t* const Sha256Avx2::initial = c_sha256Initial;
+#endif
+
+// Below this many messages the lanes mostly hash idle blocks
+const size_t c_multiBufferMinMessages = 4;
+
+template <typename OneShot>
+void hashEach(const void* const* data, const CC_LONG* lengths, size_t count, unsigned char* digests, size_t digestLength, OneShot oneShot) {
+    for (size_t i = 0; i < count; ++i) {
+        oneShot(data[i], lengths[i], digests + i * digestLength);
+    }
+}
+
+#pragma endregion
+
+} // namespace
+
 /**
 @Status Interoperable
 */
 extern "C" int CC_MD2_Init(CC_MD2_CTX* ctx) {
-    return CC_Digest_State::init(ctx, CC_MD2_DIGEST_LENGTH, BCRYPT_MD2_ALGORITHM);
+    return initDigest(ctx, c_digestMD2);
 }
 
 /**
 @Status Interoperable
 */
 extern "C" int CC_MD2_Update(CC_MD2_CTX* ctx, const void* data, CC_LONG len) {
-    return CC_Digest_State::update(ctx, data, len);
+    return updateDigest(ctx, data, len);
 }
 
 /**
 @Status Interoperable
 */
 extern "C" int CC_MD2_Final(unsigned char* digest, CC_MD2_CTX* ctx) {
-    return CC_Digest_State::final(digest, ctx);
+    return finalDigest(digest, ctx);
 }
 
 /**
 @Status Interoperable
 */
 extern "C" unsigned char* CC_MD2(const void* input, CC_LONG length, unsigned char* digest) {
-    return CC_Digest_State::oneShotDigest(CC_MD2_Init, CC_MD2_Update, CC_MD2_Final, input, length, digest);
+    return oneShotDigest(c_digestMD2, input, length, digest);
 }
 
 /**
 @Status Interoperable
 */
 extern "C" int CC_MD4_Init(CC_MD4_CTX* ctx) {
-    return CC_Digest_State::init(ctx, CC_MD4_DIGEST_LENGTH, BCRYPT_MD4_ALGORITHM);
+    return initDigest(ctx, c_digestMD4);
 }
 
 /**
 @Status Interoperable
 */
 extern "C" int CC_MD4_Update(CC_MD4_CTX* ctx, const void* data, CC_LONG len) {
-    return CC_Digest_State::update(ctx, data, len);
+    return updateDigest(ctx, data, len);
 }
 
 /**
 @Status Interoperable
 */
 extern "C" int CC_MD4_Final(unsigned char* digest, CC_MD4_CTX* ctx) {
-    return CC_Digest_State::final(digest, ctx);
+    return finalDigest(digest, ctx);
 }
 
 /**
 @Status Interoperable
 */
 extern "C" unsigned char* CC_MD4(const void* input, CC_LONG length, unsigned char* digest) {
-    return CC_Digest_State::oneShotDigest(CC_MD4_Init, CC_MD4_Update, CC_MD4_Final, input, length, digest);
+    return oneShotDigest(c_digestMD4, input, length, digest);
 }
 
 /**
 @Status Interoperable
 */
 extern "C" int CC_MD5_Init(CC_MD5_CTX* ctx) {
-    return CC_Digest_State::init(ctx, CC_MD5_DIGEST_LENGTH, BCRYPT_MD5_ALGORITHM);
+    return initDigest(ctx, c_digestMD5);
 }
 
 /**
 @Status Interoperable
 */
 extern "C" int CC_MD5_Update(CC_MD5_CTX* ctx, const void* data, CC_LONG len) {
-    return CC_Digest_State::update(ctx, data, len);
+    return updateDigest(ctx, data, len);
 }
 
 /**
 @Status Interoperable
 */
 extern "C" int CC_MD5_Final(unsigned char* digest, CC_MD5_CTX* ctx) {
-    return CC_Digest_State::final(digest, ctx);
+    return finalDigest(digest, ctx);
 }
 
 /**
 @Status Interoperable
 */
 extern "C" unsigned char* CC_MD5(const void* input, CC_LONG length, unsigned char* digest) {
-    return CC_Digest_State::oneShotDigest(CC_MD5_Init, CC_MD5_Update, CC_MD5_Final, input, length, digest);
+    return oneShotDigest(c_digestMD5, input, length, digest);
+}
+
+/**
+@Status Interoperable
+@Notes Not part of the reference platform
+*/
+extern "C" void CC_MD5_Multi(const void* const* data, const CC_LONG* len, size_t count, unsigned char* md) {
+#if (DIGEST_X86 == 1)
+    if (c_x86Features.avx2 && count >= c_multiBufferMinMessages) {
+        hashLanes<Md5Avx2>(data, len, count, md);
+        return;
+    }
+#endif
+    hashEach(data, len, count, md, CC_MD5_DIGEST_LENGTH, CC_MD5);
 }
 
 /**
 @Status Interoperable
 */
 extern "C" int CC_SHA1_Init(CC_SHA1_CTX* ctx) {
-    return CC_Digest_State::init(ctx, CC_SHA1_DIGEST_LENGTH, BCRYPT_SHA1_ALGORITHM);
+    return initDigest(ctx, c_digestSHA1);
 }
 
 /**
 @Status Interoperable
 */
 extern "C" int CC_SHA1_Update(CC_SHA1_CTX* ctx, const void* data, CC_LONG len) {
-    return CC_Digest_State::update(ctx, data, len);
+    return updateDigest(ctx, data, len);
 }
 
 /**
 @Status Interoperable
 */
 extern "C" int CC_SHA1_Final(unsigned char* digest, CC_SHA1_CTX* ctx) {
-    return CC_Digest_State::final(digest, ctx);
+    return finalDigest(digest, ctx);
 }
 
 /**
 @Status Interoperable
 */
 extern "C" unsigned char* CC_SHA1(const void* input, CC_LONG length, unsigned char* digest) {
-    return CC_Digest_State::oneShotDigest(CC_SHA1_Init, CC_SHA1_Update, CC_SHA1_Final, input, length, digest);
+    return oneShotDigest(c_digestSHA1, input, length, digest);
+}
+
+/**
+@Status Interoperable
+@Notes Not part of the reference platform
+*/
+extern "C" void CC_SHA1_Multi(const void* const* data, const CC_LONG* len, size_t count, unsigned char* md) {
+#if (DIGEST_X86 == 1)
+    //  The SHA extensions hash one message faster than eight AVX2 lanes do
+    if (c_x86Features.avx2 && !c_x86Features.sha && count >= c_multiBufferMinMessages) {
+        hashLanes<Sha1Avx2>(data, len, count, md);
+        return;
+    }
+#endif
+    hashEach(data, len, count, md, CC_SHA1_DIGEST_LENGTH, CC_SHA1);
 }
 
 /**
-@Status Stub
+@Status Interoperable
 */
 extern "C" int CC_SHA224_Init(CC_SHA224_CTX* ctx) {
-    UNIMPLEMENTED();
-    return StubReturn();
+    return initDigest(ctx, c_digestSHA224);
 }
 
 /**
-@Status Stub
+@Status Interoperable
 */
 extern "C" int CC_SHA224_Update(CC_SHA224_CTX* ctx, const void* data, CC_LONG len) {
-    UNIMPLEMENTED();
-    return StubReturn();
+    return updateDigest(ctx, data, len);
 }
 
 /**
-@Status Stub
+@Status Interoperable
 */
 extern "C" int CC_SHA224_Final(unsigned char* digest, CC_SHA224_CTX* ctx) {
-    UNIMPLEMENTED();
-    return StubReturn();
+    return finalDigest(digest, ctx);
 }
 
 /**
-@Status Stub
+@Status Interoperable
 */
 extern "C" unsigned char* CC_SHA224(const void* input, CC_LONG length, unsigned char* digest) {
-    UNIMPLEMENTED();
-    return StubReturn();
+    return oneShotDigest(c_digestSHA224, input, length, digest);
 }
 
 /**
 @Status Interoperable
 */
 extern "C" int CC_SHA256_Init(CC_SHA256_CTX* ctx) {
-    return CC_Digest_State::init(ctx, CC_SHA256_DIGEST_LENGTH, BCRYPT_SHA256_ALGORITHM);
+    return initDigest(ctx, c_digestSHA256);
 }
 
 /**
 @Status Interoperable
 */
 extern "C" int CC_SHA256_Update(CC_SHA256_CTX* ctx, const void* data, CC_LONG len) {
-    return CC_Digest_State::update(ctx, data, len);
+    return updateDigest(ctx, data, len);
 }
 
 /**
 @Status Interoperable
 */
 extern "C" int CC_SHA256_Final(unsigned char* digest, CC_SHA256_CTX* ctx) {
-    return CC_Digest_State::final(digest, ctx);
+    return finalDigest(digest, ctx);
 }
 
 /**
 @Status Interoperable
 */
 extern "C" unsigned char* CC_SHA256(const void* input, CC_LONG length, unsigned char* digest) {
-    return CC_Digest_State::oneShotDigest(CC_SHA256_Init, CC_SHA256_Update, CC_SHA256_Final, input, length, digest);
+    return oneShotDigest(c_digestSHA256, input, length, digest);
+}
+
+/**
+@Status Interoperable
+@Notes Not part of the reference platform
+*/
+extern "C" void CC_SHA256_Multi(const void* const* data, const CC_LONG* len, size_t count, unsigned char* md) {
+#if (DIGEST_X86 == 1)
+    //  The SHA extensions hash one message faster than eight AVX2 lanes do
+    if (c_x86Features.avx2 && !c_x86Features.sha && count >= c_multiBufferMinMessages) {
+        hashLanes<Sha256Avx2>(data, len, count, md);
+        return;
+    }
+#endif
+    hashEach(data, len, count, md, CC_SHA256_DIGEST_LENGTH, CC_SHA256);
 }
 
 /**
 @Status Interoperable
 */
 extern "C" int CC_SHA384_Init(CC_SHA384_CTX* ctx) {
-    return CC_Digest_State::init(ctx, CC_SHA384_DIGEST_LENGTH, BCRYPT_SHA384_ALGORITHM);
+    return initDigest(ctx, c_digestSHA384);
 }
 
 /**
 @Status Interoperable
 */
 extern "C" int CC_SHA384_Update(CC_SHA384_CTX* ctx, const void* data, CC_LONG len) {
-    return CC_Digest_State::update(ctx, data, len);
+    return updateDigest(ctx, data, len);
 }
 
 /**
 @Status Interoperable
 */
 extern "C" int CC_SHA384_Final(unsigned char* digest, CC_SHA384_CTX* ctx) {
-    return CC_Digest_State::final(digest, ctx);
+    return finalDigest(digest, ctx);
 }
 
 /**
 @Status Interoperable
 */
 extern "C" unsigned char* CC_SHA384(const void* input, CC_LONG length, unsigned char* digest) {
-    return CC_Digest_State::oneShotDigest(CC_SHA384_Init, CC_SHA384_Update, CC_SHA384_Final, input, length, digest);
+    return oneShotDigest(c_digestSHA384, input, length, digest);
 }
 
 /**
 @Status Interoperable
 */
 extern "C" int CC_SHA512_Init(CC_SHA512_CTX* ctx) {
-    return CC_Digest_State::init(ctx, CC_SHA512_DIGEST_LENGTH, BCRYPT_SHA512_ALGORITHM);
+    return initDigest(ctx, c_digestSHA512);
 }
 
 /**
 @Status Interoperable
 */
 extern "C" int CC_SHA512_Update(CC_SHA512_CTX* ctx, const void* data, CC_LONG len) {
-    return CC_Digest_State::update(ctx, data, len);
+    return updateDigest(ctx, data, len);
 }
 
 /**
 @Status Interoperable
 */
 extern "C" int CC_SHA512_Final(unsigned char* digest, CC_SHA512_CTX* ctx) {
-    return CC_Digest_State::final(digest, ctx);
+    return finalDigest(digest, ctx);
 }
 
 /**
 @Status Interoperable
 */
 extern "C" unsigned char* CC_SHA512(const void* input, CC_LONG length, unsigned char* digest) {
-    return CC_Digest_State::oneShotDigest(CC_SHA512_Init, CC_SHA512_Update, CC_SHA512_Final, input, length, digest);
+    return oneShotDigest(c_digestSHA512, input, length, digest);
 }
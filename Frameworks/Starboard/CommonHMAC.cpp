@@ -14,220 +14,132 @@
 //
 //******************************************************************************
 
-#include <Windows.h>
-#include <CommonCrypto\CommonHMAC.h>
-#include <CommonCrypto\CommonDigest.h>
-#include <COMIncludes.h>
-#include <wrl\wrappers\corewrappers.h>
-#include <wrl\client.h>
-#include <windows.security.cryptography.h>
-#include <windows.storage.streams.h>
-#include <COMIncludes_End.h>
-#include <ErrorHandling.h>
-#include <StubReturn.h>
-#include <RawBuffer.h>
-
-using namespace Microsoft::WRL;
-using namespace ABI::Windows::Storage::Streams;
-using namespace ABI::Windows::Security::Cryptography::Core;
-using namespace Windows::Foundation;
-
-struct CC_Hmac_State {
-    CC_Hmac_State(CCHmacAlgorithm algorithm, const void* key, size_t keyLength) :
-        _algorithm(algorithm),
-        _key(key),
-        _keyLength(keyLength),
-        _isValid(true) {
-        if (FAILED(_init())) {
-            invalidate();
-        }
-    }
-
-    ~CC_Hmac_State() {
-    }
-
-    static void init(CC_Hmac_State** ctx, CCHmacAlgorithm algorithm, const void* key, size_t keyLength) {
-        if (!ctx) {
-            LOG_HR(E_INVALIDARG);
-            return;
-        }
-
-        *ctx = nullptr;
+#include <CommonCrypto/CommonHMAC.h>
+#include <CommonCrypto/CommonDigest.h>
 
-        CC_Hmac_State* state = new CC_Hmac_State(algorithm, key, keyLength);
-        if (!_validState(&state)) {
-            LOG_HR(E_UNEXPECTED);
-            return;
-        }
+#include <string.h>
 
-        *ctx = state;
-        return;
-    }
+namespace {
 
-    static void update(CC_Hmac_State** ctx, const void* data, size_t len) {
-        if (!_validState(ctx)) {
-            LOG_HR(E_INVALIDARG);
-            return;
-        }
+struct HmacDigest {
+    int (*init)(CC_Digest_State* ctx);
+    int (*update)(CC_Digest_State* ctx, const void* data, CC_LONG length);
+    int (*final)(unsigned char* digest, CC_Digest_State* ctx);
+    size_t digestLength;
+    size_t blockLength;
+};
 
-        if (FAILED((*ctx)->_update(data, len))) {
-            delete *ctx;
-            *ctx = nullptr;
-        }
-    }
+// Indexed by CCHmacAlgorithm
+const HmacDigest c_hmacDigests[] = {
+    { CC_SHA1_Init, CC_SHA1_Update, CC_SHA1_Final, CC_SHA1_DIGEST_LENGTH, CC_SHA1_BLOCK_BYTES },
+    { CC_MD5_Init, CC_MD5_Update, CC_MD5_Final, CC_MD5_DIGEST_LENGTH, CC_MD5_BLOCK_BYTES },
+    { CC_SHA256_Init, CC_SHA256_Update, CC_SHA256_Final, CC_SHA256_DIGEST_LENGTH, CC_SHA256_BLOCK_BYTES },
+    { CC_SHA384_Init, CC_SHA384_Update, CC_SHA384_Final, CC_SHA384_DIGEST_LENGTH, CC_SHA384_BLOCK_BYTES },
+    { CC_SHA512_Init, CC_SHA512_Update, CC_SHA512_Final, CC_SHA512_DIGEST_LENGTH, CC_SHA512_BLOCK_BYTES },
+    { CC_SHA224_Init, CC_SHA224_Update, CC_SHA224_Final, CC_SHA224_DIGEST_LENGTH, CC_SHA224_BLOCK_BYTES },
+};
 
-    static void final(void* digest, CC_Hmac_State** ctx) {
-       if (!_validState(ctx)) {
-           LOG_HR(E_INVALIDARG);
-           return;
-       }
-
-        if (FAILED((*ctx)->_finishHash(digest))) {
-            LOG_HR(E_UNEXPECTED);
-        }
-        delete *ctx;
-        *ctx = nullptr;
+const HmacDigest* hmacDigest(const CC_Hmac_State* ctx) {
+    if (!ctx || !ctx->isValid) {
+        return nullptr;
     }
 
-    static void oneShot(CCHmacAlgorithm algorithm, const void* key, size_t keyLength, const void* data, size_t dataLength, void* macOut) {
-        CC_Hmac_State* ctx;
-
-        init(&ctx, algorithm, key, keyLength);
-
-        update(&ctx, data, dataLength);
+    return &c_hmacDigests[ctx->algorithm];
+}
 
-        final(macOut, &ctx);
+// The digest functions take 32 bit lengths; larger inputs are fed in pieces
+void updateInPieces(const HmacDigest* digest, CC_Digest_State* ctx, const void* data, size_t length) {
+    const unsigned char* bytes = static_cast<const unsigned char*>(data);
+    while (length > 0) {
+        const CC_LONG piece = (length > 0x40000000) ? 0x40000000 : static_cast<CC_LONG>(length);
+        digest->update(ctx, bytes, piece);
+        bytes += piece;
+        length -= piece;
     }
+}
 
-private:
-    static bool _validState(CC_Hmac_State** ctx) {
-        if (!ctx) {
-            return false;
-        }
-
-        CC_Hmac_State* state = *ctx;
-        if (!state) {
-            return false;
-        }
-
-        if (!state->_isValid) {
-            delete state;
-            *ctx = nullptr;
-            return false;
-        }
-
-        return true;
-    }
+} // namespace
 
-    void invalidate() {
-        _isValid = false;
+/**
+@Status Interoperable
+*/
+void CCHmacInit(CCHmacContext* ctx, CCHmacAlgorithm algorithm, const void* key, size_t keyLength) {
+    if (!ctx) {
+        return;
     }
 
-    HRESULT _init() {
-        ComPtr<IMacAlgorithmProviderStatics> macAlgorithmProviderStatics;
-        ComPtr<IMacAlgorithmNamesStatics> macAlgorithmNamesStatics;
-
-        RETURN_IF_FAILED_LOG(
-            GetActivationFactory(Wrappers::HStringReference(RuntimeClass_Windows_Security_Cryptography_Core_MacAlgorithmProvider).Get(),
-                 &macAlgorithmProviderStatics));
-
-        RETURN_IF_FAILED_LOG(
-            GetActivationFactory(Wrappers::HStringReference(RuntimeClass_Windows_Security_Cryptography_Core_MacAlgorithmNames).Get(),
-                &macAlgorithmNamesStatics));
-
-        HSTRING name;
-
-        switch (_algorithm) {
-            case kCCHmacAlgSHA1:
-                RETURN_IF_FAILED_LOG(macAlgorithmNamesStatics->get_HmacSha1(&name));
-                _digestLength = CC_SHA1_DIGEST_LENGTH;
-                break;
-            case kCCHmacAlgMD5:
-                RETURN_IF_FAILED_LOG(macAlgorithmNamesStatics->get_HmacMd5(&name));
-                _digestLength = CC_MD5_DIGEST_LENGTH;
-                break;
-            case kCCHmacAlgSHA256:
-                RETURN_IF_FAILED_LOG(macAlgorithmNamesStatics->get_HmacSha256(&name));
-                _digestLength = CC_SHA256_DIGEST_LENGTH;
-                break;
-            case kCCHmacAlgSHA384:
-                RETURN_IF_FAILED_LOG(macAlgorithmNamesStatics->get_HmacSha384(&name));
-                _digestLength = CC_SHA384_DIGEST_LENGTH;
-                break;
-            case kCCHmacAlgSHA512:
-                RETURN_IF_FAILED_LOG(macAlgorithmNamesStatics->get_HmacSha512(&name));
-                _digestLength = CC_SHA512_DIGEST_LENGTH;
-                break;
-            case kCCHmacAlgSHA224:
-            default:
-                UNIMPLEMENTED_WITH_MSG("Requested HMAC algorithm is not supported");
-                return E_NOTIMPL;
-        }
-
-        RETURN_IF_FAILED_LOG(macAlgorithmProviderStatics->OpenAlgorithm(name, &_macAlgorithmProvider));
-
-        ComPtr<IBuffer> keyBuffer;
-        RETURN_IF_FAILED_LOG(BufferFromRawData(&keyBuffer, (unsigned char*)_key, _keyLength));
-        ComPtr<IMacAlgorithmProvider2> macAlgorithmProvider2;
-        RETURN_IF_FAILED_LOG(_macAlgorithmProvider.As(&macAlgorithmProvider2));
-        RETURN_IF_FAILED_LOG(macAlgorithmProvider2->CreateHash(keyBuffer.Get(), &_hash));
-        return S_OK;
+    memset(ctx, 0, sizeof(*ctx));
+    if (algorithm < kCCHmacAlgSHA1 || algorithm > kCCHmacAlgSHA224 || (!key && keyLength > 0)) {
+        return;
     }
 
-    HRESULT _update(const void* data, size_t length) {
-        ComPtr<IBuffer> dataBuffer;
-        RETURN_IF_FAILED_LOG(BufferFromRawData(&dataBuffer, (unsigned char*)data, length));
-        RETURN_IF_FAILED_LOG(_hash->Append(dataBuffer.Get()));
-        return S_OK;
+    ctx->algorithm = algorithm;
+    ctx->isValid = 1;
+    const HmacDigest* digest = hmacDigest(ctx);
+
+    //  Keys longer than a block are replaced by their digest, shorter ones are zero padded
+    unsigned char blockKey[CC_SHA512_BLOCK_BYTES] = {};
+    if (keyLength > digest->blockLength) {
+        digest->init(&ctx->inner);
+        updateInPieces(digest, &ctx->inner, key, keyLength);
+        digest->final(blockKey, &ctx->inner);
+    } else if (keyLength > 0) {
+        memcpy(blockKey, key, keyLength);
     }
 
-    HRESULT _finishHash(void* digest) {
-        memset(digest, 0, _digestLength);
-        RETURN_IF_FAILED_LOG(_hash->GetValueAndReset(&_outBuffer));
-        ComPtr<IBufferByteAccess> bufferAccess;
-        RETURN_IF_FAILED_LOG(_outBuffer.As(&bufferAccess));
-        BYTE* pRawHash;
-        RETURN_IF_FAILED_LOG(bufferAccess->Buffer(&pRawHash));
-        memcpy_s(digest, _digestLength, pRawHash, _digestLength);
-        return S_OK;
+    unsigned char innerKey[CC_SHA512_BLOCK_BYTES];
+    for (size_t i = 0; i < digest->blockLength; ++i) {
+        innerKey[i] = blockKey[i] ^ 0x36;
+        ctx->outerKey[i] = blockKey[i] ^ 0x5c;
     }
 
-    const CCHmacAlgorithm _algorithm;
-    const void* _key;
-    const size_t _keyLength;
-    ComPtr<IMacAlgorithmProvider> _macAlgorithmProvider;
-    ComPtr<IHashComputation> _hash;
-    ComPtr<IBuffer> _outBuffer;
-    size_t _digestLength;
-    bool _isValid;
-};
-
+    digest->init(&ctx->inner);
+    digest->update(&ctx->inner, innerKey, static_cast<CC_LONG>(digest->blockLength));
 
-/**
-@Status Interoperable
-*/
-void CCHmacInit(CCHmacContext* ctx, CCHmacAlgorithm algorithm, const void* key, size_t keyLength) {
-    CC_Hmac_State::init(ctx, algorithm, key, keyLength);
+    memset(blockKey, 0, sizeof(blockKey));
+    memset(innerKey, 0, sizeof(innerKey));
 }
 
 /**
 @Status Interoperable
 */
 void CCHmacUpdate(CCHmacContext* ctx, const void* data, size_t dataLength) {
-    CC_Hmac_State::update(ctx, data, dataLength);
+    const HmacDigest* digest = hmacDigest(ctx);
+    if (!digest || (!data && dataLength > 0)) {
+        return;
+    }
+
+    updateInPieces(digest, &ctx->inner, data, dataLength);
 }
 
 /**
 @Status Interoperable
 */
 void CCHmacFinal(CCHmacContext* ctx, void* macOut) {
-    CC_Hmac_State::final(macOut, ctx);
+    const HmacDigest* digest = hmacDigest(ctx);
+    if (!digest || !macOut) {
+        return;
+    }
+
+    unsigned char innerDigest[CC_SHA512_DIGEST_LENGTH];
+    digest->final(innerDigest, &ctx->inner);
+
+    CC_Digest_State outer;
+    digest->init(&outer);
+    digest->update(&outer, ctx->outerKey, static_cast<CC_LONG>(digest->blockLength));
+    digest->update(&outer, innerDigest, static_cast<CC_LONG>(digest->digestLength));
+    digest->final(static_cast<unsigned char*>(macOut), &outer);
+
+    memset(innerDigest, 0, sizeof(innerDigest));
+    memset(ctx, 0, sizeof(*ctx));
 }
 
 /**
 @Status Interoperable
 */
 void CCHmac(CCHmacAlgorithm algorithm, const void* key, size_t keyLength, const void* data, size_t dataLength, void* macOut) {
-    CC_Hmac_State::oneShot(algorithm, key, keyLength, data, dataLength, macOut);
+    CCHmacContext ctx;
+    CCHmacInit(&ctx, algorithm, key, keyLength);
+    CCHmacUpdate(&ctx, data, dataLength);
+    CCHmacFinal(&ctx, macOut);
 }
-
@@ -34,6 +34,7 @@ THE SOFTWARE.
 #include "pevents.h"
 #include <assert.h>
 #include <errno.h>
+#include <limits.h>
 #include <sys/time.h>
 #include <sys/timespec.h>
 #ifdef WFMO
@@ -45,6 +46,56 @@ static const wchar_t* TAG = L"pevents";
 
 #endif
 
+// How often sockets waiting to become writable are checked for a failed connect
+static const ULONGLONG c_connectCheckMilliseconds = 100;
+
+// WSAPoll before Windows 10 version 2004 never reports a non-blocking connect() that fails, which select() reported in
+// its exception set. A pending connect waits to become writable, so while any socket does, the poll is made in slices
+// and those sockets are checked for a connect error with SO_ERROR after each one.
+int EbrSocketPoll(void* descriptors, int numDescriptors, int timeout) {
+    WSAPOLLFD* polled = static_cast<WSAPOLLFD*>(descriptors);
+
+    bool awaitingWrite = false;
+    for (int i = 0; i < numDescriptors; i++) {
+        awaitingWrite = awaitingWrite || (polled[i].fd != INVALID_SOCKET && (polled[i].events & POLLWRNORM));
+    }
+    if (!awaitingWrite) {
+        return WSAPoll(polled, numDescriptors, timeout);
+    }
+
+    const ULONGLONG deadline = GetTickCount64() + ((timeout < 0) ? 0 : timeout);
+    for (;;) {
+        const ULONGLONG now = GetTickCount64();
+        ULONGLONG slice = (timeout < 0) ? c_connectCheckMilliseconds : ((deadline > now) ? deadline - now : 0);
+        if (slice > c_connectCheckMilliseconds) {
+            slice = c_connectCheckMilliseconds;
+        }
+
+        const int result = WSAPoll(polled, numDescriptors, static_cast<INT>(slice));
+        if (result != 0) {
+            return result;
+        }
+
+        int failed = 0;
+        for (int i = 0; i < numDescriptors; i++) {
+            if (polled[i].fd == INVALID_SOCKET || !(polled[i].events & POLLWRNORM)) {
+                continue;
+            }
+
+            int error = 0;
+            int length = sizeof(error);
+            if (getsockopt(polled[i].fd, SOL_SOCKET, SO_ERROR, reinterpret_cast<char*>(&error), &length) == 0 && error != 0) {
+                polled[i].revents |= POLLERR;
+                failed++;
+            }
+        }
+
+        if (failed != 0 || (timeout >= 0 && GetTickCount64() >= deadline)) {
+            return failed;
+        }
+    }
+}
+
 namespace neosmart {
 #ifdef WFMO
 struct neosmart_wfmo_t_ {
@@ -314,24 +365,23 @@ int WaitForMultipleEvents(neosmart_event_t* events, int count, bool waitAll, uin
             if (milliseconds != (uint64_t)-1) {
                 if (wfmo->WakeupSocket != -1) {
                     pthread_mutex_unlock(&wfmo->Mutex);
-                    struct timeval tv;
-                    tv.tv_sec = long(milliseconds / 1000);
-                    tv.tv_usec = (milliseconds % 1000) * 1000;
-                    int selectResult =
-                        select(sockets->max + 1, (fd_set*)sockets->fdread, (fd_set*)sockets->fdwrite, (fd_set*)sockets->fderror, &tv);
+                    WSAPOLLFD* descriptors = static_cast<WSAPOLLFD*>(sockets->descriptors);
+                    INT pollTimeout = static_cast<INT>(std::min<uint64_t>(milliseconds, INT_MAX));
+                    int pollResult = EbrSocketPoll(descriptors, sockets->numDescriptors, pollTimeout);
                     pthread_mutex_lock(&wfmo->Mutex);
-                    if (selectResult == -1) {
-                        //  Timeout or error
+                    if (pollResult == SOCKET_ERROR) {
+                        //  Error
                         result = -1;
                     } else {
-                        if (FD_ISSET(sockets->WakeupSocketRead, (fd_set*)sockets->fdread)) {
+                        if (descriptors[0].revents & POLLRDNORM) {
                             //  Clear the socket
                             char buf[256];
                             while (recv(sockets->WakeupSocketRead, buf, 256, 0) == 256)
                                 ;
                             result = 0;
                         } else {
-                            sockets->result = selectResult;
+                            //  Timeout, or socket activity
+                            sockets->result = pollResult;
                             result = -1;
                         }
                     }
@@ -33,6 +33,9 @@ NSString* const UINibExternalObjects = @"UINibExternalObjects";
 
 @implementation UINib {
     idretaintype(NSData) _data;
+
+    // Parsed once on first instantiation and shared by every unarchiver after it
+    std::shared_ptr<const UINibArchive> _archive;
 }
 
 /**
@@ -82,8 +85,9 @@ NSString* const UINibExternalObjects = @"UINibExternalObjects";
     }
 
     id prop;
+    bool isNibArchive = [_data length] >= 10 && memcmp(bytes, "NIBArchive", 10) == 0;
 
-    if (memcmp(bytes, "NIBArchive", 10) == 0) {
+    if (isNibArchive) {
         prop = [UINibUnarchiver alloc];
     } else {
         prop = [NSKeyedUnarchiver alloc];
@@ -101,7 +105,14 @@ NSString* const UINibExternalObjects = @"UINibExternalObjects";
     }
 
     [prop _setBundle:(id)_bundle];
-    [prop initForReadingWithData:_data];
+    if (isNibArchive) {
+        if (!_archive) {
+            _archive = [UINibUnarchiver _archiveWithData:_data];
+        }
+        [prop _initWithArchive:_archive];
+    } else {
+        [prop initForReadingWithData:_data];
+    }
     // id allObjects = prop("decodeObjectForKey:", @"UINibObjectsKey");
     NSArray* connections = [prop decodeObjectForKey:@"UINibConnectionsKey"];
     NSArray* topLevelObjects = [prop decodeObjectForKey:@"UINibTopLevelObjectsKey"];
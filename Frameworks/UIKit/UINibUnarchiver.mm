@@ -27,6 +27,10 @@
 #import "NSCoderInternal.h"
 #import "LoggingNative.h"
 
+#include <algorithm>
+#include <string>
+#include <vector>
+
 static const wchar_t* TAG = L"UINibUnarchiver";
 
 #define NIBOBJ_INT8 0x00
@@ -41,258 +45,166 @@ static const wchar_t* TAG = L"UINibUnarchiver";
 #define NIBOBJ_NULL 0x09
 #define NIBOBJ_UID 0x0A
 
-class UINibArchiver;
-
-class Item {
+class UINibArchive {
 public:
-    int type;
-    void* data;
-    int dataLen;
-    char* key;
-    id cachedId;
-
-    Item() {
-        type = 0;
-        data = NULL;
-        dataLen = 0;
-        key = NULL;
-        cachedId = nil;
-    }
-
-    ~Item() {
-        if (data) {
-            IwFree(data);
-        }
-    }
+    static const uint32_t c_notFound = UINT32_MAX;
 
-    void setItemData(void* pData, int len) {
-        data = (void*)IwMalloc(len);
-        memcpy(data, pData, len);
-        dataLen = len;
-    }
-};
-
-class Object {
-public:
-    char* className;
-    id classType;
+    // What constructObject builds for an object, decided once from its class name
+    enum class Kind : uint8_t { Generic, Array, MutableArray, Dictionary, MutableDictionary, String, MutableString, Data, Null };
 
-    Item** items;
-    int itemCount;
-    id cachedId;
-
-    Object() {
-        cachedId = nil;
-        className = NULL;
-        items = NULL;
-        itemCount = 0;
-    }
-};
-
-@implementation UINibUnarchiver
-static void pushObject(UINibUnarchiver* self, Object* pCur) {
-    assert(self->_curObjectLevel < 16);
-    self->_curObjectLevel++;
-    self->_curObject[self->_curObjectLevel] = pCur;
-}
-static void popObject(UINibUnarchiver* self) {
-    self->_curObjectLevel--;
-}
-static Object* curObject(UINibUnarchiver* self) {
-    assert(self->_curObjectLevel >= 0);
-    return self->_curObject[self->_curObjectLevel];
-}
+    struct Item {
+        const uint8_t* data;
+        uint32_t dataLength;
+        uint32_t key;
+        uint8_t type;
+    };
 
-static Item* itemForKey(UINibUnarchiver* self, const char* keyName) {
-    Object* cur = curObject(self);
+    struct Object {
+        const char* className;
+        id classType;
+        uint32_t firstItem;
+        uint32_t itemCount;
 
-    for (int i = 0; i < cur->itemCount; i++) {
-        if (strcmp(cur->items[i]->key, keyName) == 0) {
-            return cur->items[i];
-        }
-    }
+        // Where this object's items, ordered by key, start in _itemsByKey
+        uint32_t firstByKey;
+        Kind kind;
+    };
 
-    return NULL;
-}
+    explicit UINibArchive(NSData* data);
 
-static Object* objectForUid(UINibUnarchiver* self, int uid) {
-    return self->_objects[uid];
-}
+    uint32_t keyId(const char* keyName) const;
 
-static id constructObject(UINibUnarchiver* self, Object* pObj) {
-    if (strcmp(pObj->className, "NSArray") == 0 || strcmp(pObj->className, "NSMutableArray") == 0) {
-        id* arrayItems;
-        int numArrayItems = 0;
+    // The first item of the object with the key, as a linear search in file order would find it
+    uint32_t findItem(uint32_t object, uint32_t key) const;
 
-        arrayItems = (id*)IwMalloc(pObj->itemCount * sizeof(id));
+    const Item& item(uint32_t index) const {
+        return _items[index];
+    }
 
-        pObj->cachedId = (id)(void*)0xBAADF00D;
+    const Object& object(uint32_t index) const {
+        return _objects[index];
+    }
 
-        for (int i = 0; i < pObj->itemCount; i++) {
-            Item* curItem = pObj->items[i];
+    size_t itemCount() const {
+        return _items.size();
+    }
 
-            if (strcmp(curItem->key, "UINibEncoderEmptyKey") == 0) {
-                id item = idForItem(self, curItem);
-                if (item == nil) {
-                    TraceWarning(TAG, L"Unable to create item for UINibEncoderEmptyKey.");
-                } else {
-                    arrayItems[numArrayItems++] = item;
-                }
-            }
-        }
+    size_t objectCount() const {
+        return _objects.size();
+    }
 
-        if (strcmp(pObj->className, "NSArray") == 0) {
-            pObj->cachedId = [NSArray arrayWithObjects:arrayItems count:numArrayItems];
-        } else {
-            pObj->cachedId = [NSMutableArray arrayWithObjects:arrayItems count:numArrayItems];
-        }
-        IwFree(arrayItems);
-    } else if (strcmp(pObj->className, "NSDictionary") == 0 || strcmp(pObj->className, "NSMutableDictionary") == 0) {
-        id* keys;
-        id* values;
-        int numKeys = 0, numValues = 0;
+    uint32_t bytesKey() const {
+        return _bytesKey;
+    }
 
-        keys = (id*)IwMalloc(pObj->itemCount * sizeof(id));
-        values = (id*)IwMalloc(pObj->itemCount * sizeof(id));
+    uint32_t emptyKey() const {
+        return _emptyKey;
+    }
 
-        pObj->cachedId = (id)(void*)0xBAADF00D;
+private:
+    StrongId<NSData> _data;
 
-        for (int i = 1; i < pObj->itemCount; i += 2) {
-            Item* curItem = pObj->items[i];
+    std::vector<std::string> _classNames;
+    std::vector<id> _classTypes;
+    std::vector<std::string> _keyNames;
 
-            id item = idForItem(self, curItem);
-            keys[numKeys++] = item;
+    // Open-addressed hash of key names, holding key id + 1 in each used slot
+    std::vector<uint32_t> _keySlots;
 
-            curItem = pObj->items[i + 1];
+    std::vector<Item> _items;
+    std::vector<Object> _objects;
+    std::vector<uint32_t> _itemsByKey;
 
-            item = idForItem(self, curItem);
-            values[numValues++] = item;
-        }
+    uint32_t _bytesKey;
+    uint32_t _emptyKey;
+};
 
-        if (strcmp(pObj->className, "NSDictionary") == 0) {
-            pObj->cachedId = [NSDictionary dictionaryWithObjects:values forKeys:keys count:numKeys];
-        } else {
-            pObj->cachedId = [NSMutableDictionary dictionaryWithObjects:values forKeys:keys count:numKeys];
-        }
-        IwFree(values);
-        IwFree(keys);
-    } else if (strcmp(pObj->className, "NSString") == 0 || strcmp(pObj->className, "NSMutableString") == 0 ||
-               strcmp(pObj->className, "NSLocalizableString") == 0) {
-        pushObject(self, pObj);
-        Item* strContents = itemForKey(self, "NS.bytes");
-
-        if (strcmp(pObj->className, "NSString") == 0) {
-            pObj->cachedId =
-                [[[NSString alloc] initWithBytes:strContents->data length:strContents->dataLen encoding:NSUTF8StringEncoding] autorelease];
-        } else {
-            pObj->cachedId =
-                [[[NSMutableString alloc] initWithBytes:strContents->data length:strContents->dataLen encoding:NSUTF8StringEncoding]
-                    autorelease];
-        }
-        popObject(self);
-    } else if (strcmp(pObj->className, "NSData") == 0) {
-        pushObject(self, pObj);
-        Item* dataContents = itemForKey(self, "NS.bytes");
-        pObj->cachedId = [NSData dataWithBytes:dataContents->data length:dataContents->dataLen];
-        popObject(self);
-    } else if (strcmp(pObj->className, "") == 0) {
-        pushObject(self, pObj);
-        pObj->cachedId = [NSNull null];
-        popObject(self);
-    } else {
-        id classId = pObj->classType; // objc_getClass(pObj->className);
-        assert(classId != nil);
+namespace {
 
-        pObj->cachedId = [classId alloc];
+uint32_t hashKeyName(const char* keyName) {
+    uint32_t hash = 2166136261u;
+    for (const char* p = keyName; *p; ++p) {
+        hash = (hash ^ static_cast<uint8_t>(*p)) * 16777619u;
+    }
 
-        pushObject(self, pObj);
-        if ([pObj->cachedId respondsToSelector:@selector(initWithCoder:)]) {
-            pObj->cachedId = [pObj->cachedId initWithCoder:(id)self];
-        } else {
-            if (pObj->cachedId) {
-                TraceVerbose(TAG, L"%hs does not respond to initWithCoder", object_getClassName(pObj->cachedId));
-            }
-        }
+    return hash;
+}
 
-        if ([pObj->cachedId respondsToSelector:@selector(awakeAfterUsingCoder:)]) {
-            pObj->cachedId = [pObj->cachedId awakeAfterUsingCoder:(id)self];
+UINibArchive::Kind kindForClassName(const char* className) {
+    static const struct {
+        const char* name;
+        UINibArchive::Kind kind;
+    } c_kinds[] = {
+        { "NSArray", UINibArchive::Kind::Array },
+        { "NSMutableArray", UINibArchive::Kind::MutableArray },
+        { "NSDictionary", UINibArchive::Kind::Dictionary },
+        { "NSMutableDictionary", UINibArchive::Kind::MutableDictionary },
+        { "NSString", UINibArchive::Kind::String },
+        { "NSMutableString", UINibArchive::Kind::MutableString },
+        { "NSLocalizableString", UINibArchive::Kind::MutableString },
+        { "NSData", UINibArchive::Kind::Data },
+        { "", UINibArchive::Kind::Null },
+    };
+
+    for (const auto& entry : c_kinds) {
+        if (strcmp(className, entry.name) == 0) {
+            return entry.kind;
         }
-        [pObj->cachedId autorelease];
-        popObject(self);
     }
-    return pObj->cachedId;
-}
-
-static id idForItem(UINibUnarchiver* self, Item* item) {
-    if (item->cachedId == nil) {
-        switch (item->type) {
-            case NIBOBJ_UID: {
-                Object* pObj = objectForUid(self, *((DWORD*)item->data));
-
-                if (pObj->cachedId == nil) {
-                    pObj->cachedId = constructObject(self, pObj);
-                }
-                item->cachedId = pObj->cachedId;
-            } break;
 
-            case NIBOBJ_FALSE:
-                item->cachedId = [NSNumber numberWithBool:FALSE];
-                break;
-
-            case NIBOBJ_TRUE:
-                item->cachedId = [NSNumber numberWithBool:TRUE];
-                break;
+    return UINibArchive::Kind::Generic;
+}
 
-            case NIBOBJ_FLOAT:
-                item->cachedId = [NSNumber numberWithFloat:*((float*)item->data)];
-                break;
+template <typename T>
+T readItem(const UINibArchive::Item& item) {
+    T value = 0;
+    memcpy(&value, item.data, std::min<size_t>(sizeof(value), item.dataLength));
+    return value;
+}
 
-            case NIBOBJ_DATA:
-                item->cachedId = [NSData dataWithBytes:item->data length:item->dataLen];
-                break;
+// Reads the one or two byte counts used for item starts, item counts and data lengths
+WORD readVarint(const char*& offset) {
+    WORD value = 0;
 
-            case NIBOBJ_NULL:
-                item->cachedId = nil;
-                break;
+    memcpy(&value, offset, 1);
+    offset += 1;
+    if (value < 0x80) {
+        WORD next = 0;
 
-            default:
-                assert(0);
-                break;
+        memcpy(&next, offset, 1);
+        offset += 1;
+        if (next < 0x80) {
+            assert(0);
         }
+        next -= 0x80;
+        value |= (next << 7);
+    } else {
+        value -= 0x80;
     }
 
-    return item->cachedId;
-}
-
-static id getObjectForKey(UINibUnarchiver* self, const char* keyName) {
-    Item* item = itemForKey(self, keyName);
-    if (!item) {
-        return nil;
-    }
-
-    return idForItem(self, item);
+    return value;
 }
 
-- (instancetype)initForReadingWithData:(NSData*)data {
-    _curObjectLevel = -1;
+} // namespace
 
-    _nibData = (char*)[data bytes];
-    _nibLen = [data length];
+UINibArchive::UINibArchive(NSData* data) : _data(data), _bytesKey(c_notFound), _emptyKey(c_notFound) {
+    const char* nibData = static_cast<const char*>([data bytes]);
 
-    memcpy(_fixed, &_nibData[10], sizeof(_fixed));
+    DWORD fixed[10];
+    memcpy(fixed, &nibData[10], sizeof(fixed));
 
-    char* _curOffset;
+    const char* curOffset;
 
-    //  Read classes
-    _classNames = (char**)IwCalloc(_fixed[8], sizeof(char*));
-    _classTypes = (id*)IwCalloc(_fixed[8], sizeof(id));
-    _curOffset = &_nibData[_fixed[9]];
+    //  Read classes, resolving each one once
+    _classNames.reserve(fixed[8]);
+    _classTypes.reserve(fixed[8]);
+    curOffset = &nibData[fixed[9]];
 
-    for (unsigned int i = 0; i < _fixed[8]; i++) {
+    for (unsigned int i = 0; i < fixed[8]; i++) {
         WORD len = 0;
 
-        memcpy(&len, _curOffset, sizeof(WORD));
-        _curOffset += 2;
+        memcpy(&len, curOffset, sizeof(WORD));
+        curOffset += 2;
 
         BYTE top = len >> 8;
         len &= 0xFF;
@@ -301,205 +213,403 @@ static id getObjectForKey(UINibUnarchiver* self, const char* keyName) {
             len -= 0x80;
         }
         if (top == 0x81 || len == 0x1b) {
-            _curOffset += 4; //  ????
+            curOffset += 4; //  ????
         }
 
-        _classNames[i] = (char*)IwMalloc(len + 1);
-        memcpy(_classNames[i], _curOffset, len);
-
-        _classNames[i][len] = '\0';
-        _classTypes[i] = objc_getClass(_classNames[i]);
-        if (_classTypes[i] == nil) {
+        _classNames.emplace_back(curOffset, len);
+        _classTypes.push_back(objc_getClass(_classNames.back().c_str()));
+        if (_classTypes.back() == nil) {
             TraceVerbose(TAG, L"Couldn't find class");
         }
-        _curOffset += len;
+        curOffset += len;
     }
 
-    //  Read keys
-    _keyNames = (char**)IwMalloc(_fixed[4] * sizeof(char*));
-    _curOffset = &_nibData[_fixed[5]];
+    //  Read keys and intern them
+    _keyNames.reserve(fixed[4]);
+    curOffset = &nibData[fixed[5]];
 
-    for (unsigned int i = 0; i < _fixed[4]; i++) {
+    size_t slotCount = 16;
+    while (slotCount < fixed[4] * 2) {
+        slotCount *= 2;
+    }
+    _keySlots.assign(slotCount, 0);
+
+    for (unsigned int i = 0; i < fixed[4]; i++) {
         WORD len = 0;
 
-        memcpy(&len, _curOffset, 1);
-        _curOffset += 1;
+        memcpy(&len, curOffset, 1);
+        curOffset += 1;
 
         len -= 0x80;
 
-        _keyNames[i] = (char*)IwMalloc(len + 1);
-        memcpy(_keyNames[i], _curOffset, len);
-        _keyNames[i][len] = 0;
-        _curOffset += len;
+        _keyNames.emplace_back(curOffset, len);
+        curOffset += len;
+
+        if (keyId(_keyNames.back().c_str()) == c_notFound) {
+            size_t slot = hashKeyName(_keyNames.back().c_str()) & (slotCount - 1);
+            while (_keySlots[slot] != 0) {
+                slot = (slot + 1) & (slotCount - 1);
+            }
+            _keySlots[slot] = i + 1;
+        }
     }
 
-    //  Read items
-    _objectItems = (Item**)IwMalloc(_fixed[6] * sizeof(Item*));
-    _curOffset = &_nibData[_fixed[7]];
+    _bytesKey = keyId("NS.bytes");
+    _emptyKey = keyId("UINibEncoderEmptyKey");
 
-    for (unsigned int i = 0; i < _fixed[6]; i++) {
-        Item* curItem = new Item();
-        _objectItems[i] = curItem;
+    //  Read items, which point into the archive's data
+    _items.resize(fixed[6]);
+    curOffset = &nibData[fixed[7]];
+
+    for (unsigned int i = 0; i < fixed[6]; i++) {
+        Item& curItem = _items[i];
 
         WORD itemKeyName = 0;
 
-        memcpy(&itemKeyName, _curOffset, 1);
-        _curOffset += 1;
+        memcpy(&itemKeyName, curOffset, 1);
+        curOffset += 1;
 
         if (itemKeyName >= 0x80) {
             itemKeyName -= 0x80;
         } else {
             assert(0);
         }
-        // itemKeyName -= 0x80;
-        curItem->key = _keyNames[itemKeyName];
+        //  Keys with the same name share the id of the first of them
+        curItem.key = keyId(_keyNames[itemKeyName].c_str());
 
         WORD itemType = 0;
 
-        memcpy(&itemType, _curOffset, 1);
-        _curOffset += 1;
+        memcpy(&itemType, curOffset, 1);
+        curOffset += 1;
 
-        curItem->type = itemType;
+        curItem.type = static_cast<uint8_t>(itemType);
+        curItem.data = reinterpret_cast<const uint8_t*>(curOffset);
 
         switch (itemType) {
-            case NIBOBJ_UID:
-                curItem->setItemData(_curOffset, 4);
-                _curOffset += 4;
-                break;
-
             case NIBOBJ_TRUE:
-                break;
-
             case NIBOBJ_FALSE:
+            case NIBOBJ_NULL:
+                curItem.dataLength = 0;
                 break;
 
             case NIBOBJ_INT8:
-                curItem->setItemData(_curOffset, 1);
-                _curOffset += 1;
-                break;
-
-            case NIBOBJ_NULL:
+                curItem.dataLength = 1;
                 break;
 
             case NIBOBJ_INT16:
-                curItem->setItemData(_curOffset, 2);
-                _curOffset += 2;
+                curItem.dataLength = 2;
                 break;
 
+            case NIBOBJ_UID:
             case NIBOBJ_INT32:
-                curItem->setItemData(_curOffset, 4);
-                _curOffset += 4;
-                break;
-
-            case NIBOBJ_INT64:
-                curItem->setItemData(_curOffset, 8);
-                _curOffset += 8;
-                break;
-
             case NIBOBJ_FLOAT:
-                curItem->setItemData(_curOffset, 4);
-                _curOffset += 4;
+                curItem.dataLength = 4;
                 break;
 
+            case NIBOBJ_INT64:
             case NIBOBJ_DOUBLE:
-                curItem->setItemData(_curOffset, 8);
-                _curOffset += 8;
+                curItem.dataLength = 8;
                 break;
 
-            case NIBOBJ_DATA: {
-                WORD itemDataLen = 0;
-
-                memcpy(&itemDataLen, _curOffset, 1);
-                _curOffset += 1;
-
-                if (itemDataLen >= 0x80) {
-                    itemDataLen -= 0x80;
-                } else {
-                    WORD _2nd = 0;
-                    memcpy(&_2nd, _curOffset, 1);
-
-                    if (_2nd < 0x80) {
-                        assert(0);
-                    }
-                    _2nd -= 0x80;
-                    _curOffset += 1;
-                    itemDataLen |= (_2nd << 7);
-                }
-
-                curItem->setItemData(_curOffset, itemDataLen);
-                _curOffset += itemDataLen;
-                ;
-            } break;
+            case NIBOBJ_DATA:
+                curItem.dataLength = readVarint(curOffset);
+                curItem.data = reinterpret_cast<const uint8_t*>(curOffset);
+                break;
 
             default:
                 assert(0);
+                curItem.dataLength = 0;
                 break;
         }
+
+        curOffset += curItem.dataLength;
     }
 
-    //  Read objects
-    _objects = (Object**)IwMalloc(_fixed[2] * sizeof(Object*));
-    _curOffset = &_nibData[_fixed[3]];
+    //  Read objects, and index each one's items by key
+    _objects.resize(fixed[2]);
+    curOffset = &nibData[fixed[3]];
 
-    for (unsigned int i = 0; i < _fixed[2]; i++) {
-        Object* curObject = new Object();
-        _objects[i] = curObject;
+    for (unsigned int i = 0; i < fixed[2]; i++) {
+        Object& curObject = _objects[i];
 
         WORD objectClassName = 0;
 
-        memcpy(&objectClassName, _curOffset, 1);
-        _curOffset += 1;
+        memcpy(&objectClassName, curOffset, 1);
+        curOffset += 1;
         if (objectClassName < 0x80) {
             assert(0);
         }
         objectClassName -= 0x80;
-        curObject->className = _classNames[objectClassName];
-        curObject->classType = _classTypes[objectClassName];
-        if (curObject->className == NULL || objectClassName >= _fixed[8]) {
+        if (objectClassName >= fixed[8]) {
             assert(0);
         }
+        curObject.className = _classNames[objectClassName].c_str();
+        curObject.classType = _classTypes[objectClassName];
+        curObject.kind = kindForClassName(curObject.className);
 
-        WORD objectItemStart = 0;
+        curObject.firstItem = readVarint(curOffset);
+        curObject.itemCount = readVarint(curOffset);
+        curObject.firstByKey = static_cast<uint32_t>(_itemsByKey.size());
 
-        memcpy(&objectItemStart, _curOffset, 1);
-        _curOffset += 1;
-        if (objectItemStart < 0x80) {
-            WORD nextItem = 0;
+        for (uint32_t item = 0; item < curObject.itemCount; ++item) {
+            _itemsByKey.push_back(curObject.firstItem + item);
+        }
 
-            memcpy(&nextItem, _curOffset, 1);
-            _curOffset += 1;
-            if (nextItem < 0x80) {
-                assert(0);
-            }
-            nextItem -= 0x80;
-            objectItemStart |= (nextItem << 7);
-        } else {
-            objectItemStart -= 0x80;
+        std::stable_sort(_itemsByKey.begin() + curObject.firstByKey, _itemsByKey.end(), [this](uint32_t left, uint32_t right) {
+            return _items[left].key < _items[right].key;
+        });
+    }
+}
+
+uint32_t UINibArchive::keyId(const char* keyName) const {
+    const size_t mask = _keySlots.size() - 1;
+    for (size_t slot = hashKeyName(keyName) & mask; _keySlots[slot] != 0; slot = (slot + 1) & mask) {
+        const uint32_t key = _keySlots[slot] - 1;
+        if (strcmp(_keyNames[key].c_str(), keyName) == 0) {
+            return key;
         }
+    }
+
+    return c_notFound;
+}
 
-        curObject->items = &_objectItems[objectItemStart];
+uint32_t UINibArchive::findItem(uint32_t object, uint32_t key) const {
+    const Object& cur = _objects[object];
+    const auto begin = _itemsByKey.begin() + cur.firstByKey;
+    const auto end = begin + cur.itemCount;
+    const auto found =
+        std::lower_bound(begin, end, key, [this](uint32_t item, uint32_t searchKey) { return _items[item].key < searchKey; });
 
-        WORD objectItemCount = 0;
+    if (found == end || _items[*found].key != key) {
+        return c_notFound;
+    }
 
-        memcpy(&objectItemCount, _curOffset, 1);
-        _curOffset += 1;
-        if (objectItemCount < 0x80) {
-            WORD nextItem = 0;
+    return *found;
+}
 
-            memcpy(&nextItem, _curOffset, 1);
-            _curOffset += 1;
-            if (nextItem < 0x80) {
-                assert(0);
+@implementation UINibUnarchiver
+static void pushObject(UINibUnarchiver* self, uint32_t object) {
+    assert(self->_curObjectLevel < 15);
+    self->_curObjectLevel++;
+    self->_curObject[self->_curObjectLevel] = object;
+}
+static void popObject(UINibUnarchiver* self) {
+    self->_curObjectLevel--;
+}
+static uint32_t curObject(UINibUnarchiver* self) {
+    assert(self->_curObjectLevel >= 0);
+    return self->_curObject[self->_curObjectLevel];
+}
+
+static uint32_t itemForKeyId(UINibUnarchiver* self, uint32_t key) {
+    if (!self->_archive || self->_curObjectLevel < 0 || key == UINibArchive::c_notFound) {
+        return UINibArchive::c_notFound;
+    }
+
+    return self->_archive->findItem(curObject(self), key);
+}
+
+static uint32_t itemForKey(UINibUnarchiver* self, NSString* key) {
+    if (!self->_archive) {
+        return UINibArchive::c_notFound;
+    }
+
+    return itemForKeyId(self, self->_archive->keyId([key UTF8String]));
+}
+
+static id idForItem(UINibUnarchiver* self, uint32_t itemIndex);
+
+static id constructObject(UINibUnarchiver* self, uint32_t objectIndex) {
+    const UINibArchive& archive = *self->_archive;
+    const UINibArchive::Object& pObj = archive.object(objectIndex);
+    id* instance = &self->_objectInstances[objectIndex];
+
+    switch (pObj.kind) {
+        case UINibArchive::Kind::Array:
+        case UINibArchive::Kind::MutableArray: {
+            std::vector<id> arrayItems;
+            arrayItems.reserve(pObj.itemCount);
+
+            *instance = (id)(void*)0xBAADF00D;
+
+            for (uint32_t i = 0; i < pObj.itemCount; i++) {
+                const uint32_t curItem = pObj.firstItem + i;
+
+                if (archive.item(curItem).key == archive.emptyKey()) {
+                    id item = idForItem(self, curItem);
+                    if (item == nil) {
+                        TraceWarning(TAG, L"Unable to create item for UINibEncoderEmptyKey.");
+                    } else {
+                        arrayItems.push_back(item);
+                    }
+                }
             }
-            nextItem -= 0x80;
-            objectItemCount |= (nextItem << 7);
-        } else {
-            objectItemCount -= 0x80;
+
+            if (pObj.kind == UINibArchive::Kind::Array) {
+                *instance = [NSArray arrayWithObjects:arrayItems.data() count:arrayItems.size()];
+            } else {
+                *instance = [NSMutableArray arrayWithObjects:arrayItems.data() count:arrayItems.size()];
+            }
+        } break;
+
+        case UINibArchive::Kind::Dictionary:
+        case UINibArchive::Kind::MutableDictionary: {
+            std::vector<id> keys;
+            std::vector<id> values;
+
+            *instance = (id)(void*)0xBAADF00D;
+
+            for (uint32_t i = 1; i < pObj.itemCount; i += 2) {
+                keys.push_back(idForItem(self, pObj.firstItem + i));
+                values.push_back(idForItem(self, pObj.firstItem + i + 1));
+            }
+
+            if (pObj.kind == UINibArchive::Kind::Dictionary) {
+                *instance = [NSDictionary dictionaryWithObjects:values.data() forKeys:keys.data() count:keys.size()];
+            } else {
+                *instance = [NSMutableDictionary dictionaryWithObjects:values.data() forKeys:keys.data() count:keys.size()];
+            }
+        } break;
+
+        case UINibArchive::Kind::String:
+        case UINibArchive::Kind::MutableString: {
+            pushObject(self, objectIndex);
+            const uint32_t strContents = itemForKeyId(self, archive.bytesKey());
+            const void* bytes = (strContents != UINibArchive::c_notFound) ? archive.item(strContents).data : nullptr;
+            const NSUInteger length = (strContents != UINibArchive::c_notFound) ? archive.item(strContents).dataLength : 0;
+
+            if (pObj.kind == UINibArchive::Kind::String) {
+                *instance = [[[NSString alloc] initWithBytes:bytes length:length encoding:NSUTF8StringEncoding] autorelease];
+            } else {
+                *instance = [[[NSMutableString alloc] initWithBytes:bytes length:length encoding:NSUTF8StringEncoding] autorelease];
+            }
+            popObject(self);
+        } break;
+
+        case UINibArchive::Kind::Data: {
+            pushObject(self, objectIndex);
+            const uint32_t dataContents = itemForKeyId(self, archive.bytesKey());
+            if (dataContents != UINibArchive::c_notFound) {
+                *instance = [NSData dataWithBytes:archive.item(dataContents).data length:archive.item(dataContents).dataLength];
+            } else {
+                *instance = [NSData data];
+            }
+            popObject(self);
+        } break;
+
+        case UINibArchive::Kind::Null:
+            *instance = [NSNull null];
+            break;
+
+        case UINibArchive::Kind::Generic: {
+            id classId = pObj.classType;
+            assert(classId != nil);
+
+            *instance = [classId alloc];
+
+            pushObject(self, objectIndex);
+            if ([*instance respondsToSelector:@selector(initWithCoder:)]) {
+                *instance = [*instance initWithCoder:(id)self];
+            } else {
+                if (*instance) {
+                    TraceVerbose(TAG, L"%hs does not respond to initWithCoder", object_getClassName(*instance));
+                }
+            }
+
+            if ([*instance respondsToSelector:@selector(awakeAfterUsingCoder:)]) {
+                *instance = [*instance awakeAfterUsingCoder:(id)self];
+            }
+            [*instance autorelease];
+            popObject(self);
+        } break;
+    }
+
+    return *instance;
+}
+
+static id idForItem(UINibUnarchiver* self, uint32_t itemIndex) {
+    const UINibArchive::Item& item = self->_archive->item(itemIndex);
+    id* instance = &self->_itemInstances[itemIndex];
+
+    if (*instance == nil) {
+        switch (item.type) {
+            case NIBOBJ_UID: {
+                const uint32_t objectIndex = readItem<uint32_t>(item);
+                assert(objectIndex < self->_archive->objectCount());
+
+                if (self->_objectInstances[objectIndex] == nil) {
+                    constructObject(self, objectIndex);
+                }
+                *instance = self->_objectInstances[objectIndex];
+            } break;
+
+            case NIBOBJ_FALSE:
+                *instance = [NSNumber numberWithBool:FALSE];
+                break;
+
+            case NIBOBJ_TRUE:
+                *instance = [NSNumber numberWithBool:TRUE];
+                break;
+
+            case NIBOBJ_FLOAT:
+                *instance = [NSNumber numberWithFloat:readItem<float>(item)];
+                break;
+
+            case NIBOBJ_DATA:
+                *instance = [NSData dataWithBytes:item.data length:item.dataLength];
+                break;
+
+            case NIBOBJ_NULL:
+                *instance = nil;
+                break;
+
+            default:
+                assert(0);
+                break;
         }
-        curObject->itemCount = objectItemCount;
     }
 
-    pushObject(self, _objects[0]);
+    return *instance;
+}
+
+static id getObjectForKey(UINibUnarchiver* self, NSString* key) {
+    const uint32_t item = itemForKey(self, key);
+    if (item == UINibArchive::c_notFound) {
+        return nil;
+    }
+
+    return idForItem(self, item);
+}
+
++ (std::shared_ptr<const UINibArchive>)_archiveWithData:(NSData*)data {
+    //  The signature is followed by ten 32 bit header fields
+    if ([data length] < 10 + 10 * sizeof(DWORD) || memcmp([data bytes], "NIBArchive", 10) != 0) {
+        return nullptr;
+    }
+
+    std::shared_ptr<const UINibArchive> archive = std::make_shared<UINibArchive>(data);
+    if (archive->objectCount() == 0) {
+        return nullptr;
+    }
+
+    return archive;
+}
+
+- (instancetype)initForReadingWithData:(NSData*)data {
+    return [self _initWithArchive:[UINibUnarchiver _archiveWithData:data]];
+}
+
+- (instancetype)_initWithArchive:(std::shared_ptr<const UINibArchive>)archive {
+    _curObjectLevel = -1;
+    _archive = std::move(archive);
+
+    //  Without an archive every key is missing
+    if (_archive) {
+        _objectInstances = static_cast<id*>(IwCalloc(_archive->objectCount(), sizeof(id)));
+        _itemInstances = static_cast<id*>(IwCalloc(std::max<size_t>(_archive->itemCount(), 1), sizeof(id)));
+        pushObject(self, 0);
+    }
+
     return self;
 }
 
@@ -509,7 +619,7 @@ static id getObjectForKey(UINibUnarchiver* self, const char* keyName) {
 }
 
 - (NSObject*)decodeObjectForKey:(NSString*)key {
-    id ret = getObjectForKey(self, [key UTF8String]);
+    id ret = getObjectForKey(self, key);
 
     if ([ret isKindOfClass:[NSNull class]]) {
         return nil;
@@ -519,12 +629,7 @@ static id getObjectForKey(UINibUnarchiver* self, const char* keyName) {
 }
 
 - (BOOL)containsValueForKey:(NSString*)key {
-    Item* pItem = itemForKey(self, [key UTF8String]);
-    if (!pItem) {
-        return FALSE;
-    }
-
-    return TRUE;
+    return itemForKey(self, key) != UINibArchive::c_notFound;
 }
 
 - (BOOL)decodeBoolForKey:(NSString*)key {
@@ -540,19 +645,21 @@ static id getObjectForKey(UINibUnarchiver* self, const char* keyName) {
 }
 
 - (NSInteger)decodeInt32ForKey:(NSString*)key {
-    Item* pItem = itemForKey(self, [key UTF8String]);
-    if (!pItem) {
+    const uint32_t itemIndex = itemForKey(self, key);
+    if (itemIndex == UINibArchive::c_notFound) {
         return 0;
     }
 
+    const UINibArchive::Item& item = _archive->item(itemIndex);
+
     DWORD ret = 0;
-    switch (pItem->type) {
+    switch (item.type) {
         case NIBOBJ_INT8:
-            ret = *((BYTE*)pItem->data);
+            ret = readItem<BYTE>(item);
             break;
 
         case NIBOBJ_INT16:
-            ret = *((WORD*)pItem->data);
+            ret = readItem<WORD>(item);
             break;
 
         case NIBOBJ_TRUE:
@@ -564,12 +671,12 @@ static id getObjectForKey(UINibUnarchiver* self, const char* keyName) {
             break;
 
         case NIBOBJ_INT32:
-            ret = *((DWORD*)pItem->data);
+            ret = readItem<DWORD>(item);
             break;
 
         case NIBOBJ_INT64:
             TraceWarning(TAG, L"Warning: 64-bit NIB item truncated to 32 bits");
-            ret = *((DWORD*)pItem->data);
+            ret = readItem<DWORD>(item);
             break;
 
         default:
@@ -580,19 +687,21 @@ static id getObjectForKey(UINibUnarchiver* self, const char* keyName) {
 }
 
 - (float)decodeFloatForKey:(id)key {
-    Item* pItem = itemForKey(self, [key UTF8String]);
-    if (!pItem) {
+    const uint32_t itemIndex = itemForKey(self, key);
+    if (itemIndex == UINibArchive::c_notFound) {
         return 0;
     }
 
+    const UINibArchive::Item& item = _archive->item(itemIndex);
+
     float ret = 0;
-    switch (pItem->type) {
+    switch (item.type) {
         case NIBOBJ_FLOAT:
-            ret = *((float*)pItem->data);
+            ret = readItem<float>(item);
             break;
 
         case NIBOBJ_DOUBLE:
-            ret = (float)(*((double*)pItem->data));
+            ret = (float)readItem<double>(item);
             break;
 
         default:
@@ -603,19 +712,21 @@ static id getObjectForKey(UINibUnarchiver* self, const char* keyName) {
 }
 
 - (double)decodeDoubleForKey:(id)key {
-    Item* pItem = itemForKey(self, [key UTF8String]);
-    if (!pItem) {
+    const uint32_t itemIndex = itemForKey(self, key);
+    if (itemIndex == UINibArchive::c_notFound) {
         return 0;
     }
 
+    const UINibArchive::Item& item = _archive->item(itemIndex);
+
     double ret = 0;
-    switch (pItem->type) {
+    switch (item.type) {
         case NIBOBJ_FLOAT:
-            ret = *((float*)pItem->data);
+            ret = readItem<float>(item);
             break;
 
         case NIBOBJ_DOUBLE:
-            ret = *((double*)pItem->data);
+            ret = readItem<double>(item);
             break;
 
         default:
@@ -659,33 +770,9 @@ static id getObjectForKey(UINibUnarchiver* self, const char* keyName) {
 }
 
 - (void)dealloc {
-    if (_classNames) {
-        for (unsigned int i = 0; i < _fixed[8]; i++) {
-            IwFree(_classNames[i]);
-        }
-        IwFree(_classNames);
-    }
-
-    if (_keyNames) {
-        for (unsigned int i = 0; i < _fixed[4]; i++) {
-            IwFree(_keyNames[i]);
-        }
-        IwFree(_keyNames);
-    }
-
-    if (_objectItems) {
-        for (unsigned int i = 0; i < _fixed[6]; i++) {
-            delete _objectItems[i];
-        }
-        IwFree(_objectItems);
-    }
-
-    if (_objects) {
-        for (unsigned int i = 0; i < _fixed[2]; i++) {
-            delete _objects[i];
-        }
-        IwFree(_objects);
-    }
+    IwFree(_objectInstances);
+    IwFree(_itemInstances);
+    _archive.reset();
 
     _bundle = nil;
 
@@ -693,7 +780,7 @@ static id getObjectForKey(UINibUnarchiver* self, const char* keyName) {
 }
 
 - (void)_swapActiveObject:(id)object {
-    curObject(self)->cachedId = object;
+    _objectInstances[curObject(self)] = object;
 }
 
 @end
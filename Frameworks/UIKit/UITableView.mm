@@ -22,9 +22,11 @@
 #import "Foundation/NSMutableDictionary.h"
 #import "Foundation/NSRunLoop.h"
 #import "LinkedList.h"
+#import "TableViewRowIndex.h"
 #import "UIViewInternal.h"
 #import <algorithm>
 #import <memory>
+#import <vector>
 #import <UIKit/UINib.h>
 #import "UITableViewInternal.h"
 #import "LoggingNative.h"
@@ -274,14 +276,19 @@ class TableViewHeaderFooter;
 class TableViewSection : public TableViewNode {
 public:
     float _yPos;
+    float _rowsYPos;
     float _sectionHeight;
     int _sectionIndex;
 
     TableViewHeaderFooter* _header;
     TableViewHeaderFooter* _footer;
 
+    //  Row heights by position, mirroring the child list
+    TableViewRowIndex<TableViewRow> _rows;
+
     TableViewSection(id parent, int sectionIndex) : TableViewNode(parent) {
         _yPos = 0;
+        _rowsYPos = 0;
         _sectionHeight = 0;
         _sectionIndex = sectionIndex;
         _header = NULL;
@@ -301,20 +308,25 @@ public:
         return childCount;
     }
     void calcRowHeights();
+    void rebuildRowIndex();
 
-    TableViewRow* rowAtIndex(int idx) {
-        return (TableViewRow*)childAtIndex(idx);
-    }
+    TableViewRow* rowAtIndex(int idx);
+    float rowYPos(TableViewRow* row);
+    void setRowHeight(TableViewRow* row, float height);
+    void insertRow(TableViewRow* row, int idx);
+    void removeRow(TableViewRow* row);
 };
 
-class TableViewRow : public TableViewNode {
+class TableViewRow : public TableViewNode, public TableViewRowIndexNode {
 public:
     ReusableCell* _reusable;
     int _rowIndex;
+    bool _heightMeasured;
 
     TableViewRow(id parent, int index) : TableViewNode(parent) {
         _rowIndex = index;
         _reusable = NULL;
+        _heightMeasured = true;
     }
     ~TableViewRow();
 
@@ -495,24 +507,93 @@ TableViewRow::~TableViewRow() {
     }
 }
 
+static float measureRowHeight(UITableView* self, NSIndexPath* index) {
+    float cellHeight = self->tablePriv->_defaultRowHeight;
+
+    if ([self->tablePriv->_delegate respondsToSelector:@selector(tableView:heightForRowAtIndexPath:)]) {
+        cellHeight = [self->tablePriv->_delegate tableView:self heightForRowAtIndexPath:index];
+    }
+
+    return cellHeight;
+}
+
+//  With an estimated row height set, rows start out at the estimate and only ask the delegate for their height once they
+//  scroll into view
+static bool estimatesRowHeights(UITableView* self) {
+    return self->tablePriv->_estimatedRowHeight > 0.0f &&
+           [self->tablePriv->_delegate respondsToSelector:@selector(tableView:heightForRowAtIndexPath:)];
+}
+
+//  Gives a row that is new or being reloaded its initial height
+static void resetRowHeight(UITableView* self, TableViewRow* row, NSIndexPath* index) {
+    if (estimatesRowHeights(self)) {
+        row->_height = self->tablePriv->_estimatedRowHeight;
+        row->_heightMeasured = false;
+    } else {
+        row->_height = measureRowHeight(self, index);
+        row->_heightMeasured = true;
+    }
+}
+
 void TableViewSection::calcRowHeights() {
     int curRowIdx = 0;
 
     LLTREE_FOREACH(curNode, (TableViewNode*)this) {
         TableViewRow* curRow = (TableViewRow*)curNode;
-        id index = [NSIndexPath indexPathForRow:curRowIdx inSection:_sectionIndex];
-        float cellHeight = _parent->tablePriv->_defaultRowHeight;
-
-        if ([_parent->tablePriv->_delegate respondsToSelector:@selector(tableView:heightForRowAtIndexPath:)]) {
-            cellHeight = [_parent->tablePriv->_delegate tableView:_parent heightForRowAtIndexPath:index];
-        }
 
         curRow->_oldHeight = curRow->_height;
-        curRow->_height = cellHeight;
+        resetRowHeight(_parent, curRow, [NSIndexPath indexPathForRow:curRowIdx inSection:_sectionIndex]);
         curRow->_rowIndex = curRowIdx;
 
         curRowIdx++;
     }
+
+    rebuildRowIndex();
+}
+
+void TableViewSection::rebuildRowIndex() {
+    std::vector<TableViewRow*> rows;
+    std::vector<float> heights;
+    rows.reserve(childCount);
+    heights.reserve(childCount);
+
+    LLTREE_FOREACH(curNode, (TableViewNode*)this) {
+        TableViewRow* curRow = (TableViewRow*)curNode;
+        rows.push_back(curRow);
+        heights.push_back(curRow->_height);
+    }
+
+    _rows.assign(rows, heights);
+}
+
+TableViewRow* TableViewSection::rowAtIndex(int idx) {
+    return _rows.at(idx);
+}
+
+float TableViewSection::rowYPos(TableViewRow* row) {
+    return _rowsYPos + static_cast<float>(_rows.offsetOf(row));
+}
+
+void TableViewSection::setRowHeight(TableViewRow* row, float height) {
+    row->_oldHeight = row->_height;
+    row->_height = height;
+    _rows.setHeight(row, height);
+}
+
+//  Inserts row so that it ends up at idx, with the height it already has
+void TableViewSection::insertRow(TableViewRow* row, int idx) {
+    if (idx < rowCount()) {
+        addChildBefore(row, rowAtIndex(idx));
+    } else {
+        addChildAfter(row, NULL);
+    }
+
+    _rows.insert(idx, row, row->_height);
+}
+
+void TableViewSection::removeRow(TableViewRow* row) {
+    _rows.erase(row);
+    removeChild(row);
 }
 int UITableViewPriv::sectionCount() {
     return _rootNode->childCount;
@@ -632,6 +713,7 @@ static void initInternal(UITableView* self) {
     priv->_dataSource = nil;
 
     priv->_defaultRowHeight = 50.0f;
+    priv->_estimatedRowHeight = 0.0f;
     priv->_defaultSectionHeaderHeight = 22.0f;
     priv->_footerYPos = 0.f;
     priv->_reusableCellNibs = [NSMutableDictionary new];
@@ -847,6 +929,45 @@ static void initInternal(UITableView* self) {
     [super layoutIfNeeded];
 }
 
+//  Calls body(section, sectionIndex, row, rowIndex, yPos) for the rows that may overlap [top, bottom], in table order. Each
+//  section's walk starts from the row found at top in its row index, and the row's height is read after body returns so
+//  that body may change it.
+template <typename TBody>
+static void forEachRowInRange(UITableView* self, float top, float bottom, TBody body) {
+    int curSectionIndex = 0;
+
+    LLTREE_FOREACH(curNode, self->tablePriv->_rootNode) {
+        TableViewSection* curSection = (TableViewSection*)curNode;
+        const float rowsTop = curSection->_rowsYPos;
+        const float rowsBottom = rowsTop + static_cast<float>(curSection->_rows.totalHeight());
+
+        if (curSection->rowCount() > 0 && rowsBottom >= top && rowsTop <= bottom) {
+            //  Back up one row so a row ending exactly at top is still offered
+            int curRowIndex = curSection->rowCount() - 1;
+            if (top <= rowsTop) {
+                curRowIndex = 0;
+            } else if (TableViewRow* rowAtTop = curSection->_rows.atOffset(top - rowsTop)) {
+                curRowIndex = std::max(0, static_cast<int>(curSection->_rows.indexOf(rowAtTop)) - 1);
+            }
+
+            TableViewRow* curRow = curSection->rowAtIndex(curRowIndex);
+            float y = curSection->rowYPos(curRow);
+
+            while (curRow != NULL && y <= bottom) {
+                body(curSection, curSectionIndex, curRow, curRowIndex, y);
+
+                y += curRow->_height;
+                curRow = (TableViewRow*)curRow->nextSibling;
+                curRowIndex++;
+            }
+        }
+
+        curSectionIndex++;
+    }
+}
+
+static void calcCellPositions(UITableView* self);
+
 static void showVisibleCells(UITableView* self, BOOL animated = FALSE) {
     auto priv = self->tablePriv;
     priv->_isEnumerating++;
@@ -885,22 +1006,56 @@ static void showVisibleCells(UITableView* self, BOOL animated = FALSE) {
 
     priv->_visibleComponents->MarkReusable(visibleRect, animated);
 
+    //  Rows that already have a cell may be animating out of the visible range from where they used to be
+    if (animated) {
+        LLTREE_FOREACH(curComponent, (&priv->_visibleComponents->_allComponents)) {
+            if (curComponent->_node->getNodeType() == tableViewNodeRow) {
+                curComponent->_node->addIfVisible(visibleRect, animated);
+            }
+        }
+    }
+
     LLTREE_FOREACH(curNode, priv->_rootNode) {
         TableViewSection* curSection = (TableViewSection*)curNode;
 
         if (curSection->isSectionVisible(visibleRect)) {
             curSection->_header->addIfVisible(visibleRect);
-
-            LLTREE_FOREACH(curRowNode, ((TableViewNode*)curSection)) {
-                TableViewRow* curRow = (TableViewRow*)curRowNode;
-
-                curRow->addIfVisible(visibleRect, animated);
-            }
-
             curSection->_footer->addIfVisible(visibleRect);
         }
     }
 
+    bool measuredRows = false;
+
+    forEachRowInRange(self,
+                      visibleRect.origin.y,
+                      visibleRect.origin.y + visibleRect.size.height,
+                      [self, &visibleRect, animated, &measuredRows](
+                          TableViewSection* curSection, int curSectionIndex, TableViewRow* curRow, int curRowIndex, float y) {
+                          if (!curRow->_heightMeasured) {
+                              curRow->_heightMeasured = true;
+                              float cellHeight =
+                                  measureRowHeight(self, [NSIndexPath indexPathForRow:curRowIndex inSection:curSectionIndex]);
+                              if (cellHeight != curRow->_height) {
+                                  curSection->setRowHeight(curRow, cellHeight);
+                                  measuredRows = true;
+                              }
+                          }
+
+                          if (animated && curRow->_visibleComponent != NULL) {
+                              return;
+                          }
+
+                          //  Rows without a cell are only positioned once they come into view
+                          if (curRow->_visibleComponent == NULL) {
+                              curRow->_oldYPos = y;
+                              curRow->_yValid = true;
+                          }
+                          curRow->_yPos = y;
+                          curRow->_rowIndex = curRowIndex;
+
+                          curRow->addIfVisible(visibleRect, animated);
+                      });
+
     if (priv->_footerView != nil) {
         CGRect footerBounds;
         footerBounds = [(UIView*)(priv->_footerView)bounds];
@@ -910,6 +1065,11 @@ static void showVisibleCells(UITableView* self, BOOL animated = FALSE) {
         [(UIView*)(priv->_footerView) setFrame:footerBounds];
     }
     priv->_isEnumerating--;
+
+    //  Rows measured above moved everything after them; lay out again with the real heights
+    if (measuredRows) {
+        calcCellPositions(self);
+    }
 }
 
 static void calcCellPositions(UITableView* self) {
@@ -936,37 +1096,9 @@ static void calcCellPositions(UITableView* self) {
         curSection->_header->_yPos = y;
         y += curSection->_header->_height;
 
-        int curIndex = 0;
-
-        //  Grab rows
-        LLTREE_FOREACH(curRowNode, ((TableViewNode*)curSection)) {
-            TableViewRow* curRow = (TableViewRow*)curRowNode;
-
-            if (curRow->_yValid) {
-                curRow->_oldYPos = curRow->_yPos;
-            } else {
-                curRow->_oldYPos = y;
-            }
-            curRow->_yPos = y;
-            curRow->_yValid = true;
-
-            if (curRow->_view) {
-                if (curRow->_rowIndex != curIndex) {
-                    UITableViewCell* rowView = (UITableViewCell*)(curRow->_view);
-                    id index = [NSIndexPath indexPathForRow:curIndex inSection:curSection->_sectionIndex];
-                    if (rowView->_deferredIndexPath != nil) {
-                        rowView->_deferredIndexPath = index;
-                    } else {
-                        rowView->_indexPath = index;
-                    }
-                }
-            }
-            curRow->_rowIndex = curIndex;
+        curSection->_rowsYPos = y;
+        y += static_cast<float>(curSection->_rows.totalHeight());
 
-            y += curRow->_height;
-
-            curIndex++;
-        }
         curSection->_footer->_yPos = y;
         y += curSection->_footer->_height;
 
@@ -983,6 +1115,39 @@ static void calcCellPositions(UITableView* self) {
         y += footerBounds.size.height;
     }
 
+    //  Only rows holding a cell need their position and index kept current; the rest are placed as they scroll into view
+    LLTREE_FOREACH(curComponent, (&priv->_visibleComponents->_allComponents)) {
+        if (curComponent->_node->getNodeType() != tableViewNodeRow) {
+            continue;
+        }
+
+        TableViewRow* curRow = (TableViewRow*)curComponent->_node;
+        TableViewSection* curSection = (TableViewSection*)curRow->parent;
+        int curIndex = curSection->_rows.indexOf(curRow);
+        float rowY = curSection->rowYPos(curRow);
+
+        if (curRow->_yValid) {
+            curRow->_oldYPos = curRow->_yPos;
+        } else {
+            curRow->_oldYPos = rowY;
+        }
+        curRow->_yPos = rowY;
+        curRow->_yValid = true;
+
+        if (curRow->_view) {
+            if (curRow->_rowIndex != curIndex) {
+                UITableViewCell* rowView = (UITableViewCell*)(curRow->_view);
+                id index = [NSIndexPath indexPathForRow:curIndex inSection:curSection->_sectionIndex];
+                if (rowView->_deferredIndexPath != nil) {
+                    rowView->_deferredIndexPath = index;
+                } else {
+                    rowView->_indexPath = index;
+                }
+            }
+        }
+        curRow->_rowIndex = curIndex;
+    }
+
     contentSize.width = 0;
     contentSize.height = y;
 
@@ -1002,20 +1167,15 @@ static void calcCellPositions(UITableView* self) {
     CGRect bounds;
     bounds = [self bounds];
 
-    LLTREE_FOREACH(curNode, tablePriv->_rootNode) {
-        TableViewSection* curSection = (TableViewSection*)curNode;
-
-        LLTREE_FOREACH(curRowNode, ((TableViewNode*)curSection)) {
-            TableViewRow* curRow = (TableViewRow*)curRowNode;
-
-            if (curRow->_yPos + curRow->_height < scrollPoint.y || curRow->_yPos > scrollPoint.y + bounds.size.height) {
-            } else {
-                if (curRow->_view != nil) {
-                    [ret addObject:curRow->_view];
-                }
-            }
-        }
-    }
+    forEachRowInRange(self,
+                      scrollPoint.y,
+                      scrollPoint.y + bounds.size.height,
+                      [ret, &scrollPoint](
+                          TableViewSection* curSection, int curSectionIndex, TableViewRow* curRow, int curRowIndex, float y) {
+                          if (y + curRow->_height >= scrollPoint.y && curRow->_view != nil) {
+                              [ret addObject:curRow->_view];
+                          }
+                      });
 
     return ret;
 }
@@ -1032,22 +1192,17 @@ static void calcCellPositions(UITableView* self) {
     CGRect bounds;
     bounds = [self bounds];
 
-    LLTREE_FOREACH(curNode, tablePriv->_rootNode) {
-        TableViewSection* curSection = (TableViewSection*)curNode;
-
-        LLTREE_FOREACH(curRowNode, ((TableViewNode*)curSection)) {
-            TableViewRow* curRow = (TableViewRow*)curRowNode;
-
-            if (curRow->_yPos + curRow->_height < scrollPoint.y || curRow->_yPos > scrollPoint.y + bounds.size.height) {
-            } else {
-                if (curRow->_view != nil) {
-                    id indexPath = [static_cast<UITableViewCell*>(curRow->_view) indexPath];
-                    if (indexPath != nil)
-                        [ret addObject:indexPath];
-                }
-            }
-        }
-    }
+    forEachRowInRange(self,
+                      scrollPoint.y,
+                      scrollPoint.y + bounds.size.height,
+                      [ret, &scrollPoint](
+                          TableViewSection* curSection, int curSectionIndex, TableViewRow* curRow, int curRowIndex, float y) {
+                          if (y + curRow->_height >= scrollPoint.y && curRow->_view != nil) {
+                              id indexPath = [static_cast<UITableViewCell*>(curRow->_view) indexPath];
+                              if (indexPath != nil)
+                                  [ret addObject:indexPath];
+                          }
+                      });
 
     return ret;
 }
@@ -1060,17 +1215,11 @@ static void calcCellPositions(UITableView* self) {
     LLTREE_FOREACH(curNode, tablePriv->_rootNode) {
         TableViewSection* curSection = (TableViewSection*)curNode;
 
-        int curRowIndex = 0;
-        LLTREE_FOREACH(curRowNode, ((TableViewNode*)curSection)) {
-            TableViewRow* curRow = (TableViewRow*)curRowNode;
-
-            if (curRow->_yPos + curRow->_height > point.y && curRow->_yPos <= point.y) {
-                id index = [NSIndexPath indexPathForRow:curRowIndex inSection:curSectionIndex];
-
-                return index;
+        if (point.y >= curSection->_rowsYPos) {
+            TableViewRow* curRow = curSection->_rows.atOffset(point.y - curSection->_rowsYPos);
+            if (curRow != NULL) {
+                return [NSIndexPath indexPathForRow:curSection->_rows.indexOf(curRow) inSection:curSectionIndex];
             }
-
-            curRowIndex++;
         }
 
         curSectionIndex++;
@@ -1084,24 +1233,16 @@ static void calcCellPositions(UITableView* self) {
 */
 - (NSIndexPath*)indexPathsForRowsInRect:(CGRect)rect {
     id ret = [NSMutableArray array];
-    int curSectionIndex = 0;
-    LLTREE_FOREACH(curNode, tablePriv->_rootNode) {
-        TableViewSection* curSection = (TableViewSection*)curNode;
 
-        int curRowIndex = 0;
-        LLTREE_FOREACH(curRowNode, ((TableViewNode*)curSection)) {
-            TableViewRow* curRow = (TableViewRow*)curRowNode;
-
-            if (curRow->_yPos + curRow->_height > rect.origin.y && curRow->_yPos <= rect.origin.y + rect.size.height) {
-                id index = [NSIndexPath indexPathForRow:curRowIndex inSection:curSectionIndex];
-                [ret addObject:index];
-            }
-
-            curRowIndex++;
-        }
-
-        curSectionIndex++;
-    }
+    forEachRowInRange(self,
+                      rect.origin.y,
+                      rect.origin.y + rect.size.height,
+                      [ret, &rect](TableViewSection* curSection, int curSectionIndex, TableViewRow* curRow, int curRowIndex, float y) {
+                          if (y + curRow->_height > rect.origin.y) {
+                              id index = [NSIndexPath indexPathForRow:curRowIndex inSection:curSectionIndex];
+                              [ret addObject:index];
+                          }
+                      });
 
     return ret;
 }
@@ -1144,7 +1285,8 @@ static void calcCellPositions(UITableView* self) {
         }
 
         //  Reload the row
-        TableViewRow* curRow = tablePriv->sectionAtIndex(section)->rowAtIndex(row);
+        TableViewSection* curSection = tablePriv->sectionAtIndex(section);
+        TableViewRow* curRow = curSection->rowAtIndex(row);
 
         if (curRow->_view != nil) {
             [curRow->_view setAlpha:0.0f];
@@ -1156,15 +1298,10 @@ static void calcCellPositions(UITableView* self) {
             tablePriv->removeReusableCell(curRow->_reusable);
             curRow->_reusable = NULL;
         }
-        float cellHeight = tablePriv->_defaultRowHeight;
-
-        if ([tablePriv->_delegate respondsToSelector:@selector(tableView:heightForRowAtIndexPath:)]) {
-            cellHeight = [tablePriv->_delegate tableView:self heightForRowAtIndexPath:path];
-        }
 
         curRow->_animation = animationType;
-        curRow->_oldHeight = curRow->_height;
-        curRow->_height = cellHeight;
+        curRow->_heightMeasured = true;
+        curSection->setRowHeight(curRow, measureRowHeight(self, path));
     }
 
     calcCellPositions(self);
@@ -1481,6 +1618,20 @@ static void recalcTableSize(UITableView* self, bool changedWidth) {
     return tablePriv->_defaultRowHeight;
 }
 
+/**
+ @Status Interoperable
+*/
+- (void)setEstimatedRowHeight:(CGFloat)estimatedRowHeight {
+    tablePriv->_estimatedRowHeight = estimatedRowHeight;
+}
+
+/**
+ @Status Interoperable
+*/
+- (CGFloat)estimatedRowHeight {
+    return tablePriv->_estimatedRowHeight;
+}
+
 /**
  @Status Stub
 */
@@ -1792,12 +1943,15 @@ static void recalcTableSize(UITableView* self, bool changedWidth) {
         return ret;
     }
 
+    TableViewSection* curSection = tablePriv->sectionAtIndex(section);
+    TableViewRow* curRow = curSection->rowAtIndex(row);
+
     CGRect bounds;
     bounds = [self bounds];
     ret.origin.x = 0.0f;
-    ret.origin.y = tablePriv->sectionAtIndex(section)->rowAtIndex(row)->_yPos;
+    ret.origin.y = curSection->rowYPos(curRow);
     ret.size.width = bounds.size.width;
-    ret.size.height = tablePriv->sectionAtIndex(section)->rowAtIndex(row)->_height;
+    ret.size.height = curRow->_height;
 
     return ret;
 }
@@ -1824,12 +1978,7 @@ static void recalcTableSize(UITableView* self, bool changedWidth) {
     y += tablePriv->sectionAtIndex(section)->_header->_height;
 
     //  Grab rows
-    TableViewSection* curSection = tablePriv->sectionAtIndex(section);
-    LLTREE_FOREACH(curRowNode, ((TableViewNode*)curSection)) {
-        TableViewRow* curRow = (TableViewRow*)curRowNode;
-
-        y += curRow->_height;
-    }
+    y += static_cast<float>(tablePriv->sectionAtIndex(section)->_rows.totalHeight());
 
     y += tablePriv->sectionAtIndex(section)->_footer->_height;
 
@@ -1864,24 +2013,14 @@ static void recalcTableSize(UITableView* self, bool changedWidth) {
         }
 
         TableViewSection* curSection = tablePriv->sectionAtIndex(section);
-        TableViewNode* insertAfter = NULL;
-        if (row < tablePriv->sectionAtIndex(section)->rowCount()) {
-            insertAfter = curSection->childAtIndex(row);
-        }
-
-        float cellHeight = tablePriv->_defaultRowHeight;
-
-        if ([tablePriv->_delegate respondsToSelector:@selector(tableView:heightForRowAtIndexPath:)]) {
-            cellHeight = [tablePriv->_delegate tableView:self heightForRowAtIndexPath:path];
-        }
 
         //  Insert the row
-        TableViewRow* newRow = new TableViewRow(self, i);
-        curSection->addChildAfter(newRow, insertAfter);
-
-        newRow->_height = cellHeight;
+        TableViewRow* newRow = new TableViewRow(self, row);
+        resetRowHeight(self, newRow, path);
         newRow->_view = nil;
         newRow->_yPos = -1;
+
+        curSection->insertRow(newRow, row);
     }
 
     calcCellPositions(self);
@@ -1949,16 +2088,9 @@ static void recalcTableSize(UITableView* self, bool changedWidth) {
             }
 
             if (curIdx < newRowCount) {
-                float cellHeight = tablePriv->_defaultRowHeight;
-
-                if ([tablePriv->_delegate respondsToSelector:@selector(tableView:heightForRowAtIndexPath:)]) {
-                    id path = [NSIndexPath indexPathForRow:curIdx inSection:section];
-                    cellHeight = [tablePriv->_delegate tableView:self heightForRowAtIndexPath:path];
-                }
-
                 curRow->_animation = animationType;
                 curRow->_oldHeight = curRow->_height;
-                curRow->_height = cellHeight;
+                resetRowHeight(self, curRow, [NSIndexPath indexPathForRow:curIdx inSection:section]);
             } else {
                 curSection->removeChild(curRow);
                 delete curRow;
@@ -1969,21 +2101,17 @@ static void recalcTableSize(UITableView* self, bool changedWidth) {
         //  Add any extra new rows needed
         while (curIdx < newRowCount) {
             TableViewRow* newRow = new TableViewRow(self, curIdx);
-            float cellHeight = tablePriv->_defaultRowHeight;
-
-            if ([tablePriv->_delegate respondsToSelector:@selector(tableView:heightForRowAtIndexPath:)]) {
-                id path = [NSIndexPath indexPathForRow:curIdx inSection:section];
-                cellHeight = [tablePriv->_delegate tableView:self heightForRowAtIndexPath:path];
-            }
 
             newRow->_animation = animationType;
-            newRow->_height = cellHeight;
+            resetRowHeight(self, newRow, [NSIndexPath indexPathForRow:curIdx inSection:section]);
             newRow->_oldHeight = newRow->_height;
 
             curSection->addChildAfter(newRow, NULL);
             curIdx++;
         }
 
+        curSection->rebuildRowIndex();
+
         idx = [sections indexGreaterThanIndex:idx];
     }
 
@@ -2031,7 +2159,7 @@ static void recalcTableSize(UITableView* self, bool changedWidth) {
         }
 
         TableViewSection* section = (TableViewSection*)curRow->parent;
-        section->removeChild(curRow);
+        section->removeRow(curRow);
         delete curRow;
     }
 
@@ -2176,11 +2176,10 @@ static float doRound(float f) {
 }
 
 /**
- @Status Caveat
- @Notes Same impl as setNeedsDisplay. With our compositor this might not even have meaning.
+ @Status Interoperable
 */
 - (void)setNeedsDisplayInRect:(CGRect)rc {
-    [layer setNeedsDisplay];
+    [layer setNeedsDisplayInRect:rc];
 }
 
 /**
@@ -21,6 +21,7 @@
 #import <AccessibilityInternal.h>
 #import <UIKit/UIImage.h>
 #import "UIColorInternal.h"
+#include "LayerBackingStore.h"
 
 @class CAAnimation, CALayerContext;
 
@@ -51,6 +52,7 @@ public:
 
 class DisplayNode;
 class DisplayTexture;
+class LayerTileStore;
 @class CALayer;
 
 class CAPrivateInfo : public CADisplayProperties, public LLTreeNode<CAPrivateInfo, CALayer> {
@@ -88,6 +90,10 @@ public:
 
     DisplayTexture* _textureOverride;
 
+    // What needs redrawing at the next display, and the tiles backing the layer when it is too big for a single texture
+    LayerDirtyRegion _dirtyRegion;
+    LayerTileStore* _tiles;
+
     explicit CAPrivateInfo(CALayer* self);
     ~CAPrivateInfo();
 };
@@ -106,6 +112,9 @@ public:
 - (DisplayNode*)_presentationNode;
 - (void)_releaseContents:(BOOL)immediately;
 
+// The size in pixels of the tiles backing the layer, or CGSizeZero if it is backed by a single texture
+- (CGSize)_backingTileSize;
+
 // Some additional non-standard layer swapping functionality:
 - (void)exchangeSublayer:(CALayer*)layer1 withLayer:(CALayer*)layer2;
 - (void)exchangeSubviewAtIndex:(int)index1 withSubviewAtIndex:(int)index2;
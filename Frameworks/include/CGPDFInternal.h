@@ -0,0 +1,388 @@
+//******************************************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+//
+// This code is licensed under the MIT License (MIT).
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+//******************************************************************************
+#pragma once
+
+#include <CoreGraphics/CGPDFArray.h>
+#include <CoreGraphics/CGPDFContentStream.h>
+#include <CoreGraphics/CGPDFDictionary.h>
+#include <CoreGraphics/CGPDFObject.h>
+#include <CoreGraphics/CGPDFOperatorTable.h>
+#include <CoreGraphics/CGPDFPage.h>
+#include <CoreGraphics/CGPDFScanner.h>
+#include <CoreGraphics/CGPDFStream.h>
+#include <CoreGraphics/CGPDFString.h>
+
+#include <algorithm>
+#include <atomic>
+#include <deque>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <stddef.h>
+#include <stdint.h>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+class PDFFile;
+
+// An indirect reference, as parsed; references are resolved before objects are handed out as CGPDFObjectRefs
+static const CGPDFObjectType c_CGPDFObjectTypeReference = static_cast<CGPDFObjectType>(0);
+
+struct CGPDFValue {
+    CGPDFObjectType type;
+    union {
+        CGPDFBoolean boolean;
+        CGPDFInteger integer;
+        CGPDFReal real;
+        const char* name;
+        CGPDFStringRef string;
+        CGPDFArrayRef array;
+        CGPDFDictionaryRef dictionary;
+        CGPDFStreamRef stream;
+        struct {
+            uint32_t number;
+            uint32_t generation;
+        } reference;
+    };
+};
+
+union __CGPDFObject {
+    CGPDFValue value;
+};
+
+struct __CGPDFString {
+    std::string bytes;
+};
+
+struct __CGPDFArray {
+    PDFFile* file;
+    std::vector<__CGPDFObject> objects;
+
+    // The object at index with any reference resolved, or nullptr past the end
+    CGPDFObjectRef Get(size_t index) const;
+};
+
+struct __CGPDFDictionary {
+    PDFFile* file;
+    std::vector<std::pair<const char*, __CGPDFObject>> entries;
+
+    // The value for key with any reference resolved, or nullptr if there is none
+    CGPDFObjectRef Get(const char* key) const;
+};
+
+// A stream's bytes as they are in the file, still encoded with the filters its dictionary lists
+struct __CGPDFStream {
+    PDFFile* file;
+    CGPDFDictionaryRef dictionary;
+    const uint8_t* data;
+    size_t length;
+};
+
+// Follows an indirect reference, if object is one
+CGPDFObjectRef _CGPDFResolve(PDFFile* file, const __CGPDFObject* object);
+
+// Reads an object's value as one of the types CGPDFObjectGetValue accepts, integers being numbers too
+bool _CGPDFObjectGetValue(const __CGPDFObject* object, CGPDFObjectType type, void* value);
+
+// Decodes a stream's data through its filters, stopping short of image formats, which are reported in format
+bool _CGPDFStreamDecode(CGPDFStreamRef stream, std::string& data, CGPDFDataFormat* format);
+
+// The number of objects parsed from a document's file so far
+COREGRAPHICS_EXPORT size_t _CGPDFDocumentGetParsedObjectCount(CGPDFDocumentRef document);
+
+// Owns the objects parsed from a file or content stream. Everything it hands out lives until it is cleared, or destroyed.
+class PDFObjectArena {
+public:
+    const char* Name(const std::string& name);
+    CGPDFStringRef String(const std::string& bytes);
+    CGPDFArrayRef Array(PDFFile* file);
+    CGPDFDictionaryRef Dictionary(PDFFile* file);
+    CGPDFStreamRef Stream(PDFFile* file, CGPDFDictionaryRef dictionary, const uint8_t* data, size_t length);
+    CGPDFObjectRef Object(const __CGPDFObject& object);
+
+    // Keeps the storage for data, for streams that aren't in a file
+    const uint8_t* Data(std::string&& data);
+
+    // Drops everything but names, which are few and repeat
+    void Clear();
+
+private:
+    std::unordered_set<std::string> _names;
+    std::deque<__CGPDFString> _strings;
+    std::deque<__CGPDFArray> _arrays;
+    std::deque<__CGPDFDictionary> _dictionaries;
+    std::deque<__CGPDFStream> _streams;
+    std::deque<__CGPDFObject> _objects;
+    std::deque<std::string> _data;
+};
+
+// Bytes read through a window, which sources refill as it runs out: a file in memory is one window, while a content
+// stream is decoded a window at a time.
+class PDFByteSource {
+public:
+    virtual ~PDFByteSource() {
+    }
+
+    int Peek() {
+        return (_position < _end || Refill()) ? *_position : -1;
+    }
+
+    int Next() {
+        return (_position < _end || Refill()) ? *_position++ : -1;
+    }
+
+protected:
+    virtual bool Refill() {
+        return false;
+    }
+
+    const uint8_t* _position = nullptr;
+    const uint8_t* _end = nullptr;
+};
+
+class PDFMemorySource : public PDFByteSource {
+public:
+    PDFMemorySource(const uint8_t* data, size_t length) : _begin(data) {
+        _position = data;
+        _end = data + length;
+    }
+
+    size_t Offset() const {
+        return _position - _begin;
+    }
+
+    void Seek(size_t offset) {
+        _position = _begin + std::min(offset, static_cast<size_t>(_end - _begin));
+    }
+
+private:
+    const uint8_t* _begin;
+};
+
+// Reads objects and keywords from PDF syntax. In a file, "number generation R" is read as a reference, and a stream's
+// dictionary is followed by the keyword stream, which the file reads the data after.
+class PDFParser {
+public:
+    enum Result { c_object, c_keyword, c_end, c_error };
+
+    PDFParser(PDFByteSource& source, PDFObjectArena& arena, PDFFile* file) : _source(source), _arena(arena), _file(file) {
+    }
+
+    Result Next(__CGPDFObject& object);
+
+    // Reads an inline image, after the keyword BI, as a stream of the data between ID and EI
+    Result ReadInlineImage(__CGPDFObject& object);
+
+    // The last keyword read
+    const std::string& Keyword() const {
+        return _keyword;
+    }
+
+    PDFByteSource& Source() {
+        return _source;
+    }
+
+private:
+    struct Token {
+        enum Type {
+            c_integer,
+            c_real,
+            c_name,
+            c_string,
+            c_arrayBegin,
+            c_arrayEnd,
+            c_dictionaryBegin,
+            c_dictionaryEnd,
+            c_keyword,
+            c_end,
+            c_error
+        };
+
+        Type type = c_end;
+        CGPDFInteger integer = 0;
+        CGPDFReal real = 0;
+        std::string text;
+    };
+
+    bool nextToken(Token& token);
+    void readToken(Token& token);
+    void readLiteralString(std::string& text);
+    void readHexString(std::string& text);
+    bool readName(std::string& text);
+    Result parse(Token& token, __CGPDFObject& object, int depth);
+
+    PDFByteSource& _source;
+    PDFObjectArena& _arena;
+    PDFFile* _file;
+    std::string _keyword;
+    Token _tokens[3];
+    size_t _pending = 0;
+};
+
+// A PDF file in memory. The cross-reference table, or streams, are read once when it's opened; objects are parsed the
+// first time they're asked for, and kept for the life of the file, since CGPDFObjectRefs into them are expected to stay
+// valid. Object streams are decoded on demand into a small cache, so that opening a large document and reading one page
+// only decodes the objects that page needs.
+class PDFFile {
+public:
+    PDFFile(const uint8_t* data, size_t length, CGPDFDocumentRef document);
+    ~PDFFile();
+
+    bool Open();
+
+    CGPDFObjectRef Resolve(uint32_t number);
+
+    CGPDFDictionaryRef Trailer() const {
+        return _trailer;
+    }
+
+    CGPDFDictionaryRef Catalog();
+    void GetVersion(int* major, int* minor) const;
+    size_t PageCount();
+
+    // 1-based, as CGPDFDocumentGetPage is
+    CGPDFPageRef Page(size_t number);
+
+    // The number of objects parsed so far
+    size_t ParsedObjectCount() const {
+        return _parsedCount;
+    }
+
+private:
+    struct XrefEntry {
+        enum Type : uint8_t { c_free, c_inUse, c_compressed };
+
+        Type type;
+        uint32_t generation;
+
+        // The object's offset in the file, or for compressed objects, the object stream's number and the index in it
+        uint64_t offset;
+    };
+
+    struct ObjectStream {
+        std::string data;
+        std::vector<std::pair<uint32_t, size_t>> objects;
+    };
+
+    bool readXref(size_t offset);
+    bool readXrefTable(PDFMemorySource& source);
+    bool readXrefStream(size_t offset, CGPDFDictionaryRef* trailer);
+    bool repair();
+    void setEntry(uint32_t number, XrefEntry entry);
+    CGPDFObjectRef parseIndirect(size_t offset, uint32_t number);
+    CGPDFObjectRef parseCompressed(uint32_t streamNumber, uint32_t index, uint32_t number);
+    std::shared_ptr<ObjectStream> objectStream(uint32_t number);
+    bool readStream(PDFMemorySource& source, CGPDFDictionaryRef dictionary, __CGPDFObject& object);
+
+    // The index of the first page under each of a page tree node's kids, then the number of pages under the node
+    const std::vector<size_t>& pageTreeOffsets(CGPDFDictionaryRef node, CGPDFArrayRef kids);
+
+    const uint8_t* _data;
+    size_t _length;
+    CGPDFDocumentRef _document;
+    std::recursive_mutex _lock;
+    PDFObjectArena _arena;
+
+    int _majorVersion = 0;
+    int _minorVersion = 0;
+    CGPDFDictionaryRef _trailer = nullptr;
+    std::vector<XrefEntry> _xref;
+
+    // Parsed objects, by number; _resolving marks those being parsed, to stop reference cycles
+    std::vector<CGPDFObjectRef> _objects;
+    std::vector<bool> _resolving;
+    size_t _parsedCount = 0;
+
+    // Least recently used last
+    std::list<std::pair<uint32_t, std::shared_ptr<ObjectStream>>> _objectStreams;
+
+    std::vector<std::unique_ptr<__CGPDFPage>> _pages;
+    std::unordered_map<CGPDFDictionaryRef, std::vector<size_t>> _pageTreeOffsets;
+};
+
+struct __CGPDFPage {
+    CGPDFDocumentRef document;
+    size_t number;
+    CGPDFDictionaryRef dictionary;
+
+    // Inherited from the page tree, where the page doesn't have its own
+    CGPDFDictionaryRef resources;
+    const __CGPDFObject* mediaBox;
+    const __CGPDFObject* cropBox;
+    CGPDFInteger rotation;
+};
+
+struct __CGPDFOperatorTable {
+    std::atomic<int> refCount;
+    std::unordered_map<std::string, CGPDFOperatorCallback> callbacks;
+};
+
+struct __CGPDFContentStream {
+    std::atomic<int> refCount;
+    std::vector<CGPDFStreamRef> streams;
+    CGPDFDictionaryRef resources;
+    CGPDFContentStreamRef parent;
+    CGPDFPageRef page;
+    CFArrayRef streamArray;
+};
+
+struct __CGPDFScanner {
+    std::atomic<int> refCount;
+    CGPDFContentStreamRef contentStream;
+    CGPDFOperatorTableRef table;
+    void* info;
+
+    // The operands of the operator being called back for, which live until it returns
+    std::vector<__CGPDFObject> operands;
+    PDFObjectArena arena;
+};
+
+// Reads a content stream's streams one after the other, decoding them a window at a time where they're compressed
+class PDFContentSource : public PDFByteSource {
+public:
+    explicit PDFContentSource(const std::vector<CGPDFStreamRef>& streams);
+    ~PDFContentSource();
+
+protected:
+    bool Refill() override;
+
+private:
+    bool startStream();
+    void endInflate();
+
+    const std::vector<CGPDFStreamRef>& _streams;
+    size_t _next = 0;
+    bool _separate = false;
+    struct Inflater;
+    std::unique_ptr<Inflater> _inflater;
+    std::string _decoded;
+};
+
+template <typename T>
+T* _CGPDFRetain(T* object) {
+    if (object) {
+        ++object->refCount;
+    }
+    return object;
+}
+
+template <typename T>
+bool _CGPDFRelease(T* object) {
+    return object && --object->refCount == 0;
+}
@@ -20,6 +20,10 @@
 #include "CFBridgeBase.h"
 #include "CoreGraphics/CGContext.h"
 #include "CoreGraphics/CGPath.h"
+#include "PathHitTester.h"
+
+#include <memory>
+#include <mutex>
 
 const int kCGPathMaxPointCount = 3;
 
@@ -56,9 +60,16 @@ struct __CGPath : public CFBridgeBase<__CGPath> {
     NSUInteger _count;
     NSUInteger _max;
 
+    // Built on the first hit test and dropped whenever the path changes
+    std::unique_ptr<PathHitTester> _hitTester;
+    std::mutex _hitTesterLock;
+
     ~__CGPath();
     void _getBoundingBox(CGRect* rectOut);
     void _applyPath(CGContextRef context);
+    void _reserve(NSUInteger count);
+    void _invalidate();
+    const PathHitTester& _getHitTester();
 };
 
 COREGRAPHICS_EXPORT CGRect _CGPathFitRect(CGPathRef pathref, CGRect rect, CGSize maxSize, float padding);
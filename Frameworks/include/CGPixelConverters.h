@@ -0,0 +1,522 @@
+//******************************************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+//
+// This code is licensed under the MIT License (MIT).
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+//******************************************************************************
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(_M_IX86) || defined(_M_X64) || defined(__SSE2__)
+#define CGPIXEL_SSE 1
+#include <emmintrin.h>
+#else
+#define CGPIXEL_SSE 0
+#endif
+
+// AVX2 kernels are selected at runtime. MSVC builds AVX2 intrinsics anywhere; clang and GCC only inside functions that
+// target AVX2, so the kernels carry CGPIXEL_AVX2_TARGET and the files including this header need no -mavx2.
+#if (CGPIXEL_SSE == 1)
+#define CGPIXEL_AVX 1
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+#if defined(__clang__) || defined(__GNUC__)
+#define CGPIXEL_AVX2_TARGET __attribute__((target("avx2")))
+#else
+#define CGPIXEL_AVX2_TARGET
+#endif
+#else
+#define CGPIXEL_AVX 0
+#endif
+
+#if defined(_M_ARM) || defined(__ARM_NEON)
+#define CGPIXEL_NEON 1
+#include <arm_neon.h>
+#else
+#define CGPIXEL_NEON 0
+#endif
+
+// Row converters between the pixel layouts images are stored in and the ones they're read or written as.
+//
+// Every converter takes the same arguments, so that callers can pick one per image and run it over each row: dest, src
+// and a count of pixels, or of components for the 16-bit narrowing. Converters that keep the pixel size may convert in
+// place, with dest == src; otherwise dest and src must not overlap. 32-bit pixels have their alpha, if any, in the last
+// byte, as every 32-bit surface format does in memory.
+typedef void (*CGPixelRowConverter)(uint8_t* dest, const uint8_t* src, size_t count);
+
+#if (CGPIXEL_AVX == 1)
+static inline bool _CGPixelDetectAvx2() {
+#if defined(_MSC_VER)
+    int info[4];
+    __cpuid(info, 0);
+    if (info[0] < 7) {
+        return false;
+    }
+
+    //  AVX2 needs the CPU feature bits and the OS saving the YMM state
+    __cpuid(info, 1);
+    const bool osxsave = (info[2] & (1 << 27)) != 0;
+    const bool avx = (info[2] & (1 << 28)) != 0;
+    if (!osxsave || !avx || (_xgetbv(0) & 0x6) != 0x6) {
+        return false;
+    }
+
+    __cpuidex(info, 7, 0);
+    return (info[1] & (1 << 5)) != 0;
+#else
+    return __builtin_cpu_supports("avx2") != 0;
+#endif
+}
+
+static const bool c_CGPixelUseAvx2 = _CGPixelDetectAvx2();
+#endif
+
+// Rounds c * a / 255, exactly, for 8-bit c and a
+static inline uint8_t _CGPixelMultiplyAlpha(unsigned int c, unsigned int a) {
+    const unsigned int t = c * a + 0x80;
+    return static_cast<uint8_t>((t + (t >> 8)) >> 8);
+}
+
+template <size_t bytesPerPixel>
+static inline void _CGPixelCopy(uint8_t* dest, const uint8_t* src, size_t count) {
+    if (dest != src) {
+        memcpy(dest, src, count * bytesPerPixel);
+    }
+}
+
+#if (CGPIXEL_AVX == 1)
+// AVX2 part of _CGPixelSwapRedBlue32. Returns the number of pixels converted, leaving the rest to the narrower kernels.
+CGPIXEL_AVX2_TARGET static size_t _CGPixelSwapRedBlue32Avx2(uint8_t* dest, const uint8_t* src, size_t count) {
+    const __m256i vShuffle =
+        _mm256_setr_epi8(2, 1, 0, 3, 6, 5, 4, 7, 10, 9, 8, 11, 14, 13, 12, 15, 2, 1, 0, 3, 6, 5, 4, 7, 10, 9, 8, 11, 14, 13, 12, 15);
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        const __m256i vPixels = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + 4 * i));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(dest + 4 * i), _mm256_shuffle_epi8(vPixels, vShuffle));
+    }
+
+    return i;
+}
+
+// AVX2 part of _CGPixelPremultiply32. Returns the number of pixels converted, leaving the rest to the narrower kernels.
+CGPIXEL_AVX2_TARGET static size_t _CGPixelPremultiply32Avx2(uint8_t* dest, const uint8_t* src, size_t count) {
+    //  The alpha lane is multiplied by 255, which rounds back to alpha
+    const __m256i vZero = _mm256_setzero_si256();
+    const __m256i vColorMask = _mm256_set1_epi64x(0x0000FFFFFFFFFFFFll);
+    const __m256i vAlphaLane = _mm256_set1_epi64x(0x00FF000000000000ll);
+    const __m256i vRound = _mm256_set1_epi16(0x80);
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        const __m256i vPixels = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + 4 * i));
+        __m256i vHalves[2] = { _mm256_unpacklo_epi8(vPixels, vZero), _mm256_unpackhi_epi8(vPixels, vZero) };
+        for (__m256i& vHalf : vHalves) {
+            const __m256i vAlpha =
+                _mm256_shufflehi_epi16(_mm256_shufflelo_epi16(vHalf, _MM_SHUFFLE(3, 3, 3, 3)), _MM_SHUFFLE(3, 3, 3, 3));
+            const __m256i vFactor = _mm256_or_si256(_mm256_and_si256(vAlpha, vColorMask), vAlphaLane);
+            const __m256i vProduct = _mm256_add_epi16(_mm256_mullo_epi16(vHalf, vFactor), vRound);
+            vHalf = _mm256_srli_epi16(_mm256_add_epi16(vProduct, _mm256_srli_epi16(vProduct, 8)), 8);
+        }
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(dest + 4 * i), _mm256_packus_epi16(vHalves[0], vHalves[1]));
+    }
+
+    return i;
+}
+#endif
+
+// Swaps the first and third bytes of 32-bit pixels: BGRA to RGBA, and back
+static inline void _CGPixelSwapRedBlue32(uint8_t* dest, const uint8_t* src, size_t count) {
+    size_t i = 0;
+
+#if (CGPIXEL_AVX == 1)
+    if (c_CGPixelUseAvx2) {
+        i = _CGPixelSwapRedBlue32Avx2(dest, src, count);
+    }
+#endif
+
+#if (CGPIXEL_SSE == 1)
+    //  SSE2 has no byte shuffle: the red and blue bytes trade places with 32-bit shifts
+    const __m128i vGreenAlpha = _mm_set1_epi32(static_cast<int>(0xFF00FF00));
+    const __m128i vRedBlue = _mm_set1_epi32(0x00FF00FF);
+    for (; i + 4 <= count; i += 4) {
+        const __m128i vPixels = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + 4 * i));
+        const __m128i vSwapped = _mm_and_si128(vPixels, vRedBlue);
+        const __m128i vResult = _mm_or_si128(_mm_and_si128(vPixels, vGreenAlpha),
+                                             _mm_or_si128(_mm_slli_epi32(vSwapped, 16), _mm_srli_epi32(vSwapped, 16)));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dest + 4 * i), vResult);
+    }
+#elif (CGPIXEL_NEON == 1)
+    for (; i + 16 <= count; i += 16) {
+        uint8x16x4_t vPixels = vld4q_u8(src + 4 * i);
+        const uint8x16_t vFirst = vPixels.val[0];
+        vPixels.val[0] = vPixels.val[2];
+        vPixels.val[2] = vFirst;
+        vst4q_u8(dest + 4 * i, vPixels);
+    }
+#endif
+
+    for (; i < count; ++i) {
+        const uint8_t first = src[4 * i];
+        dest[4 * i] = src[4 * i + 2];
+        dest[4 * i + 1] = src[4 * i + 1];
+        dest[4 * i + 2] = first;
+        dest[4 * i + 3] = src[4 * i + 3];
+    }
+}
+
+// Multiplies the color of 32-bit pixels by their alpha
+static inline void _CGPixelPremultiply32(uint8_t* dest, const uint8_t* src, size_t count) {
+    size_t i = 0;
+
+#if (CGPIXEL_AVX == 1)
+    if (c_CGPixelUseAvx2) {
+        i = _CGPixelPremultiply32Avx2(dest, src, count);
+    }
+#endif
+
+#if (CGPIXEL_SSE == 1)
+    const __m128i vZero = _mm_setzero_si128();
+    const __m128i vColorMask = _mm_set_epi16(0, -1, -1, -1, 0, -1, -1, -1);
+    const __m128i vAlphaLane = _mm_set_epi16(0xFF, 0, 0, 0, 0xFF, 0, 0, 0);
+    const __m128i vRound = _mm_set1_epi16(0x80);
+    for (; i + 4 <= count; i += 4) {
+        const __m128i vPixels = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + 4 * i));
+        __m128i vHalves[2] = { _mm_unpacklo_epi8(vPixels, vZero), _mm_unpackhi_epi8(vPixels, vZero) };
+        for (__m128i& vHalf : vHalves) {
+            const __m128i vAlpha = _mm_shufflehi_epi16(_mm_shufflelo_epi16(vHalf, _MM_SHUFFLE(3, 3, 3, 3)), _MM_SHUFFLE(3, 3, 3, 3));
+            const __m128i vFactor = _mm_or_si128(_mm_and_si128(vAlpha, vColorMask), vAlphaLane);
+            const __m128i vProduct = _mm_add_epi16(_mm_mullo_epi16(vHalf, vFactor), vRound);
+            vHalf = _mm_srli_epi16(_mm_add_epi16(vProduct, _mm_srli_epi16(vProduct, 8)), 8);
+        }
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dest + 4 * i), _mm_packus_epi16(vHalves[0], vHalves[1]));
+    }
+#elif (CGPIXEL_NEON == 1)
+    const uint16x8_t vRound = vdupq_n_u16(0x80);
+    for (; i + 16 <= count; i += 16) {
+        uint8x16x4_t vPixels = vld4q_u8(src + 4 * i);
+        for (int c = 0; c < 3; ++c) {
+            const uint16x8_t vLow = vaddq_u16(vmull_u8(vget_low_u8(vPixels.val[c]), vget_low_u8(vPixels.val[3])), vRound);
+            const uint16x8_t vHigh = vaddq_u16(vmull_u8(vget_high_u8(vPixels.val[c]), vget_high_u8(vPixels.val[3])), vRound);
+            vPixels.val[c] = vcombine_u8(vshrn_n_u16(vsraq_n_u16(vLow, vLow, 8), 8), vshrn_n_u16(vsraq_n_u16(vHigh, vHigh, 8), 8));
+        }
+        vst4q_u8(dest + 4 * i, vPixels);
+    }
+#endif
+
+    for (; i < count; ++i) {
+        const unsigned int alpha = src[4 * i + 3];
+        dest[4 * i] = _CGPixelMultiplyAlpha(src[4 * i], alpha);
+        dest[4 * i + 1] = _CGPixelMultiplyAlpha(src[4 * i + 1], alpha);
+        dest[4 * i + 2] = _CGPixelMultiplyAlpha(src[4 * i + 2], alpha);
+        dest[4 * i + 3] = static_cast<uint8_t>(alpha);
+    }
+}
+
+static inline void _CGPixelUnpremultiplyPixel(uint8_t* dest, const uint8_t* src) {
+    const unsigned int alpha = src[3];
+    if (alpha == 0) {
+        memset(dest, 0, 4);
+        return;
+    }
+
+    for (int c = 0; c < 3; ++c) {
+        const unsigned int color = (src[c] * 255 + alpha / 2) / alpha;
+        dest[c] = static_cast<uint8_t>(color < 255 ? color : 255);
+    }
+    dest[3] = static_cast<uint8_t>(alpha);
+}
+
+// Divides the color of 32-bit pixels by their alpha. Pixels that are opaque, or clear, need no division, and as they're
+// most of nearly every image, runs of them are found a vector at a time.
+static inline void _CGPixelUnpremultiply32(uint8_t* dest, const uint8_t* src, size_t count) {
+    size_t i = 0;
+
+#if (CGPIXEL_SSE == 1)
+    const __m128i vAlphaMask = _mm_set1_epi32(static_cast<int>(0xFF000000));
+    const __m128i vZero = _mm_setzero_si128();
+    for (; i + 4 <= count; i += 4) {
+        const __m128i vPixels = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + 4 * i));
+        const __m128i vAlpha = _mm_and_si128(vPixels, vAlphaMask);
+        if (_mm_movemask_epi8(_mm_cmpeq_epi32(vAlpha, vAlphaMask)) == 0xFFFF) {
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(dest + 4 * i), vPixels);
+        } else if (_mm_movemask_epi8(_mm_cmpeq_epi32(vAlpha, vZero)) == 0xFFFF) {
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(dest + 4 * i), vZero);
+        } else {
+            for (size_t j = i; j < i + 4; ++j) {
+                _CGPixelUnpremultiplyPixel(dest + 4 * j, src + 4 * j);
+            }
+        }
+    }
+#endif
+
+    for (; i < count; ++i) {
+        if (src[4 * i + 3] == 0xFF) {
+            memmove(dest + 4 * i, src + 4 * i, 4);
+        } else {
+            _CGPixelUnpremultiplyPixel(dest + 4 * i, src + 4 * i);
+        }
+    }
+}
+
+// Whether every one of the 32-bit pixels is opaque
+static inline bool _CGPixelIsOpaque32(const uint8_t* src, size_t count) {
+    size_t i = 0;
+
+#if (CGPIXEL_SSE == 1)
+    const __m128i vAlphaMask = _mm_set1_epi32(static_cast<int>(0xFF000000));
+    __m128i vAll = vAlphaMask;
+    for (; i + 4 <= count; i += 4) {
+        vAll = _mm_and_si128(vAll, _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + 4 * i)));
+    }
+    if (_mm_movemask_epi8(_mm_cmpeq_epi32(_mm_and_si128(vAll, vAlphaMask), vAlphaMask)) != 0xFFFF) {
+        return false;
+    }
+#endif
+
+    for (; i < count; ++i) {
+        if (src[4 * i + 3] != 0xFF) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Expands 8-bit gray to opaque 32-bit pixels, gray in each of the first three bytes
+static inline void _CGPixelGrayToRGBA(uint8_t* dest, const uint8_t* src, size_t count) {
+    size_t i = 0;
+
+#if (CGPIXEL_SSE == 1)
+    const __m128i vOpaque = _mm_set1_epi8(static_cast<char>(0xFF));
+    for (; i + 16 <= count; i += 16) {
+        const __m128i vGray = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+        const __m128i vGrayGray[2] = { _mm_unpacklo_epi8(vGray, vGray), _mm_unpackhi_epi8(vGray, vGray) };
+        const __m128i vGrayAlpha[2] = { _mm_unpacklo_epi8(vGray, vOpaque), _mm_unpackhi_epi8(vGray, vOpaque) };
+        __m128i* out = reinterpret_cast<__m128i*>(dest + 4 * i);
+        _mm_storeu_si128(out, _mm_unpacklo_epi16(vGrayGray[0], vGrayAlpha[0]));
+        _mm_storeu_si128(out + 1, _mm_unpackhi_epi16(vGrayGray[0], vGrayAlpha[0]));
+        _mm_storeu_si128(out + 2, _mm_unpacklo_epi16(vGrayGray[1], vGrayAlpha[1]));
+        _mm_storeu_si128(out + 3, _mm_unpackhi_epi16(vGrayGray[1], vGrayAlpha[1]));
+    }
+#elif (CGPIXEL_NEON == 1)
+    const uint8x16_t vOpaque = vdupq_n_u8(0xFF);
+    for (; i + 16 <= count; i += 16) {
+        const uint8x16_t vGray = vld1q_u8(src + i);
+        uint8x16x4_t vPixels;
+        vPixels.val[0] = vGray;
+        vPixels.val[1] = vGray;
+        vPixels.val[2] = vGray;
+        vPixels.val[3] = vOpaque;
+        vst4q_u8(dest + 4 * i, vPixels);
+    }
+#endif
+
+    for (; i < count; ++i) {
+        dest[4 * i] = dest[4 * i + 1] = dest[4 * i + 2] = src[i];
+        dest[4 * i + 3] = 0xFF;
+    }
+}
+
+// Rounds 16-bit components to 8 bits, as v * 255 / 65535. Counts components, which are stored big-endian, or little-endian.
+template <bool bigEndian>
+static inline void _CGPixelNarrow16(uint8_t* dest, const uint8_t* src, size_t count) {
+    size_t i = 0;
+
+#if (CGPIXEL_SSE == 1)
+    //  (v - ((v + 128) >> 8) + 128) >> 8, with the inner sum kept to 16 bits by averaging
+    const __m128i vRoundDown = _mm_set1_epi16(127);
+    const __m128i vRound = _mm_set1_epi16(128);
+    for (; i + 16 <= count; i += 16) {
+        __m128i vValues[2] = { _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + 2 * i)),
+                               _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + 2 * i + 16)) };
+        for (__m128i& vValue : vValues) {
+            if (bigEndian) {
+                vValue = _mm_or_si128(_mm_slli_epi16(vValue, 8), _mm_srli_epi16(vValue, 8));
+            }
+            const __m128i vCarry = _mm_srli_epi16(_mm_avg_epu16(vValue, vRoundDown), 7);
+            vValue = _mm_srli_epi16(_mm_add_epi16(_mm_sub_epi16(vValue, vCarry), vRound), 8);
+        }
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dest + i), _mm_packus_epi16(vValues[0], vValues[1]));
+    }
+#elif (CGPIXEL_NEON == 1)
+    for (; i + 8 <= count; i += 8) {
+        uint8x16_t vBytes = vld1q_u8(src + 2 * i);
+        if (bigEndian) {
+            vBytes = vrev16q_u8(vBytes);
+        }
+        const uint16x8_t vValue = vreinterpretq_u16_u8(vBytes);
+        vst1_u8(dest + i, vrshrn_n_u16(vsubq_u16(vValue, vrshrq_n_u16(vValue, 8)), 8));
+    }
+#endif
+
+    for (; i < count; ++i) {
+        const unsigned int value = bigEndian ? ((src[2 * i] << 8) | src[2 * i + 1]) : ((src[2 * i + 1] << 8) | src[2 * i]);
+        dest[i] = static_cast<uint8_t>((value * 255 + 32895) >> 16);
+    }
+}
+
+// Expands 16-bit 565 pixels to 24-bit, the low bits of each component extended into the bits it gains
+static inline void _CGPixel565ToRGB(uint8_t* dest, const uint8_t* src, size_t count) {
+    for (size_t i = 0; i < count; ++i) {
+        uint16_t pixel;
+        memcpy(&pixel, src + 2 * i, sizeof(pixel));
+
+        const unsigned int r = pixel >> 11;
+        const unsigned int g = (pixel >> 5) & 0x3F;
+        const unsigned int b = pixel & 0x1F;
+        dest[3 * i] = static_cast<uint8_t>((r << 3) | (((r & 0x1) << 3) - (r & 0x1)));
+        dest[3 * i + 1] = static_cast<uint8_t>((g << 2) | (((g & 0x1) << 2) - (g & 0x1)));
+        dest[3 * i + 2] = static_cast<uint8_t>((b << 3) | (((b & 0x1) << 3) - (b & 0x1)));
+    }
+}
+
+// A color table of count 24-bit colors, laid out for expansion: a 4-byte entry for each of the 256 indices, those past
+// the table's end black
+struct CGPixelPalette {
+    uint8_t entries[256][4];
+
+    CGPixelPalette(const uint8_t* colors, size_t count) {
+        memset(entries, 0, sizeof(entries));
+        for (size_t i = 0; i < count && i < 256; ++i) {
+            memcpy(entries[i], colors + 3 * i, 3);
+        }
+    }
+};
+
+// Expands 8-bit indices to 24-bit colors. Each entry is stored as 4 bytes, the next pixel overwriting the extra one.
+static inline void _CGPixelExpandPalette(uint8_t* dest, const uint8_t* src, size_t count, const CGPixelPalette& palette) {
+    if (count == 0) {
+        return;
+    }
+
+    size_t i = 0;
+    for (; i + 1 < count; ++i) {
+        memcpy(dest + 3 * i, palette.entries[src[i]], 4);
+    }
+    memcpy(dest + 3 * i, palette.entries[src[i]], 3);
+}
+
+static inline uint8_t _CGPixelPaethPredictor(int a, int b, int c) {
+    const int pa = abs(b - c);
+    const int pb = abs(a - c);
+    const int pc = abs(a + b - 2 * c);
+    return static_cast<uint8_t>((pa <= pb && pa <= pc) ? a : (pb <= pc ? b : c));
+}
+
+// Filters a PNG row of rowBytes against prior, the row above it, or zeros for the first row, with whichever of the five
+// filters leaves the smallest sum of absolute differences, as libpng does by default. out receives the filter type and the
+// filtered bytes; candidates is scratch for four rows.
+static inline void _CGPixelFilterPNGRow(
+    const uint8_t* row, const uint8_t* prior, size_t rowBytes, size_t bpp, uint8_t* candidates, uint8_t* out) {
+    //  In filter type order: None, Sub, Up, Average, Paeth
+    const uint8_t* filtered[5] = { row, candidates, candidates + rowBytes, candidates + 2 * rowBytes, candidates + 3 * rowBytes };
+    uint8_t* sub = candidates;
+    uint8_t* up = candidates + rowBytes;
+    uint8_t* average = candidates + 2 * rowBytes;
+    uint8_t* paeth = candidates + 3 * rowBytes;
+    size_t sums[5] = {};
+
+    //  The first pixel has nothing to its left
+    size_t i = 0;
+    for (; i < bpp && i < rowBytes; ++i) {
+        sub[i] = row[i];
+        up[i] = static_cast<uint8_t>(row[i] - prior[i]);
+        average[i] = static_cast<uint8_t>(row[i] - (prior[i] >> 1));
+        paeth[i] = static_cast<uint8_t>(row[i] - prior[i]);
+    }
+
+#if (CGPIXEL_SSE == 1)
+    //  Sums of absolute differences are taken of each byte as signed, |v| being the lesser of v and -v unsigned
+    const __m128i vZero = _mm_setzero_si128();
+    const __m128i vOne = _mm_set1_epi8(1);
+    __m128i vSums[5] = { vZero, vZero, vZero, vZero, vZero };
+    auto accumulate = [&vZero](__m128i& vSum, __m128i vValue) {
+        vSum = _mm_add_epi64(vSum, _mm_sad_epu8(_mm_min_epu8(vValue, _mm_sub_epi8(vZero, vValue)), vZero));
+    };
+    auto predictPaeth = [&vZero](__m128i vA, __m128i vB, __m128i vC) {
+        const __m128i vBC = _mm_sub_epi16(vB, vC);
+        const __m128i vAC = _mm_sub_epi16(vA, vC);
+        const __m128i vSum = _mm_add_epi16(vBC, vAC);
+        const __m128i vPa = _mm_max_epi16(vBC, _mm_sub_epi16(vZero, vBC));
+        const __m128i vPb = _mm_max_epi16(vAC, _mm_sub_epi16(vZero, vAC));
+        const __m128i vPc = _mm_max_epi16(vSum, _mm_sub_epi16(vZero, vSum));
+        const __m128i vNotA = _mm_or_si128(_mm_cmpgt_epi16(vPa, vPb), _mm_cmpgt_epi16(vPa, vPc));
+        const __m128i vNotB = _mm_cmpgt_epi16(vPb, vPc);
+        const __m128i vBOrC = _mm_or_si128(_mm_andnot_si128(vNotB, vB), _mm_and_si128(vNotB, vC));
+        return _mm_or_si128(_mm_andnot_si128(vNotA, vA), _mm_and_si128(vNotA, vBOrC));
+    };
+
+    for (; i + 16 <= rowBytes; i += 16) {
+        const __m128i vRow = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row + i));
+        const __m128i vLeft = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row + i - bpp));
+        const __m128i vUp = _mm_loadu_si128(reinterpret_cast<const __m128i*>(prior + i));
+        const __m128i vUpLeft = _mm_loadu_si128(reinterpret_cast<const __m128i*>(prior + i - bpp));
+
+        //  _mm_avg_epu8 rounds up, where the Average filter rounds down
+        const __m128i vAverage = _mm_sub_epi8(_mm_avg_epu8(vLeft, vUp), _mm_and_si128(_mm_xor_si128(vLeft, vUp), vOne));
+        const __m128i vPaeth = _mm_packus_epi16(predictPaeth(_mm_unpacklo_epi8(vLeft, vZero),
+                                                             _mm_unpacklo_epi8(vUp, vZero),
+                                                             _mm_unpacklo_epi8(vUpLeft, vZero)),
+                                                predictPaeth(_mm_unpackhi_epi8(vLeft, vZero),
+                                                             _mm_unpackhi_epi8(vUp, vZero),
+                                                             _mm_unpackhi_epi8(vUpLeft, vZero)));
+
+        const __m128i vFiltered[4] = { _mm_sub_epi8(vRow, vLeft),
+                                       _mm_sub_epi8(vRow, vUp),
+                                       _mm_sub_epi8(vRow, vAverage),
+                                       _mm_sub_epi8(vRow, vPaeth) };
+        accumulate(vSums[0], vRow);
+        for (int filter = 0; filter < 4; ++filter) {
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(candidates + filter * rowBytes + i), vFiltered[filter]);
+            accumulate(vSums[filter + 1], vFiltered[filter]);
+        }
+    }
+
+    for (int filter = 0; filter < 5; ++filter) {
+        sums[filter] = static_cast<size_t>(_mm_cvtsi128_si32(vSums[filter])) +
+                       static_cast<size_t>(_mm_cvtsi128_si32(_mm_unpackhi_epi64(vSums[filter], vSums[filter])));
+    }
+#endif
+
+    const size_t head = (bpp < rowBytes) ? bpp : rowBytes;
+    const size_t tail = i;
+    for (; i < rowBytes; ++i) {
+        sub[i] = static_cast<uint8_t>(row[i] - row[i - bpp]);
+        up[i] = static_cast<uint8_t>(row[i] - prior[i]);
+        average[i] = static_cast<uint8_t>(row[i] - ((row[i - bpp] + prior[i]) >> 1));
+        paeth[i] = static_cast<uint8_t>(row[i] - _CGPixelPaethPredictor(row[i - bpp], prior[i], prior[i - bpp]));
+    }
+
+    //  The bytes the vectors didn't sum: the first pixel's, and those after the last whole vector
+    for (int filter = 0; filter < 5; ++filter) {
+        for (size_t j = 0; j < head; ++j) {
+            sums[filter] += abs(static_cast<int8_t>(filtered[filter][j]));
+        }
+        for (size_t j = tail; j < rowBytes; ++j) {
+            sums[filter] += abs(static_cast<int8_t>(filtered[filter][j]));
+        }
+    }
+
+    int best = 0;
+    for (int filter = 1; filter < 5; ++filter) {
+        if (sums[filter] < sums[best]) {
+            best = filter;
+        }
+    }
+
+    out[0] = static_cast<uint8_t>(best);
+    memcpy(out + 1, filtered[best], rowBytes);
+}
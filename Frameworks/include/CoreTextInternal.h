@@ -21,12 +21,32 @@
 #import "Starboard.h"
 #include <vector>
 
+@class UIFont;
+
+// An attribute run of a typesetter's string, with its font looked up once rather than on every layout
+struct _CTTypesetterRun {
+    NSRange _range;
+    StrongId<NSDictionary> _attributes;
+    StrongId<UIFont> _font;
+
+    // Filled in, along with the run's advances, the first time a line reaches it
+    bool _measured = false;
+    float _fontHeight = 0.0f;
+    float _ascender = 0.0f;
+    float _descender = 0.0f;
+    float _leading = 0.0f;
+};
+
 @interface _CTTypesetter : NSObject {
 @public
     NSAttributedString* _attributedString;
     NSString* _string;
     WORD* _characters;
     CFIndex _charactersLen;
+    std::vector<_CTTypesetterRun> _runs;
+
+    // Each character's advance, in 26.6 fixed point, for the runs that have been measured
+    std::vector<int32_t> _advances;
 }
 @end
 
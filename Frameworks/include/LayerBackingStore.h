@@ -0,0 +1,279 @@
+//******************************************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+//
+// This code is licensed under the MIT License (MIT).
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+//******************************************************************************
+#pragma once
+
+#include <CoreGraphics/CGGeometry.h>
+
+#include <algorithm>
+#include <math.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+
+// A rect in the pixel space of a layer's backing store: (0, 0) is the top left pixel of the layer's bounds.
+struct LayerPixelRect {
+    int x;
+    int y;
+    int width;
+    int height;
+
+    bool IsEmpty() const {
+        return width <= 0 || height <= 0;
+    }
+
+    int64_t Area() const {
+        return IsEmpty() ? 0 : static_cast<int64_t>(width) * height;
+    }
+
+    LayerPixelRect Intersection(const LayerPixelRect& other) const {
+        const int left = std::max(x, other.x);
+        const int top = std::max(y, other.y);
+        const int right = std::min(x + width, other.x + other.width);
+        const int bottom = std::min(y + height, other.y + other.height);
+        if (right <= left || bottom <= top) {
+            return { left, top, 0, 0 };
+        }
+
+        return { left, top, right - left, bottom - top };
+    }
+
+    bool Intersects(const LayerPixelRect& other) const {
+        return !Intersection(other).IsEmpty();
+    }
+
+    // Converts a rect in the coordinate space of a layer with the given bounds and contentsScale, rounding outwards
+    static LayerPixelRect FromLayerRect(const CGRect& rect, const CGRect& bounds, float scale) {
+        const float left = floorf((rect.origin.x - bounds.origin.x) * scale);
+        const float top = floorf((rect.origin.y - bounds.origin.y) * scale);
+        const float right = ceilf((rect.origin.x + rect.size.width - bounds.origin.x) * scale);
+        const float bottom = ceilf((rect.origin.y + rect.size.height - bounds.origin.y) * scale);
+        return { static_cast<int>(left), static_cast<int>(top), static_cast<int>(right - left), static_cast<int>(bottom - top) };
+    }
+
+    CGRect ToLayerRect(const CGRect& bounds, float scale) const {
+        return CGRectMake(bounds.origin.x + x / scale, bounds.origin.y + y / scale, width / scale, height / scale);
+    }
+};
+
+// The parts of a layer invalidated by setNeedsDisplay/setNeedsDisplayInRect: since it last displayed, in layer coordinates.
+// A handful of rects is kept so that a few small, scattered invalidations don't redraw everything in between; once they
+// run out, the new rect is merged into whichever existing one grows the least. Zero-initialized is an empty region.
+class LayerDirtyRegion {
+public:
+    static const size_t c_maxRects = 8;
+
+    void Add(const CGRect& rect) {
+        if (_all || rect.size.width <= 0.0f || rect.size.height <= 0.0f) {
+            return;
+        }
+
+        //  Drop the rects the new one covers, or the new one if it is already covered
+        size_t count = 0;
+        for (size_t i = 0; i < _count; ++i) {
+            if (CGRectContainsRect(_rects[i], rect)) {
+                return;
+            }
+
+            if (!CGRectContainsRect(rect, _rects[i])) {
+                _rects[count++] = _rects[i];
+            }
+        }
+
+        _count = count;
+        if (_count < c_maxRects) {
+            _rects[_count++] = rect;
+            return;
+        }
+
+        size_t best = 0;
+        float bestGrowth = INFINITY;
+        for (size_t i = 0; i < _count; ++i) {
+            const float growth = area(CGRectUnion(_rects[i], rect)) - area(_rects[i]);
+            if (growth < bestGrowth) {
+                bestGrowth = growth;
+                best = i;
+            }
+        }
+
+        _rects[best] = CGRectUnion(_rects[best], rect);
+    }
+
+    void AddAll() {
+        _all = true;
+        _count = 0;
+    }
+
+    void Clear() {
+        _all = false;
+        _count = 0;
+    }
+
+    bool IsEmpty() const {
+        return !_all && _count == 0;
+    }
+
+    bool IsAll() const {
+        return _all;
+    }
+
+    size_t Count() const {
+        return _count;
+    }
+
+    const CGRect* Rects() const {
+        return _rects;
+    }
+
+    // Appends the region in the pixel space of a backing store, clipped to its pixelBounds
+    void GetPixelRects(const CGRect& bounds, float scale, const LayerPixelRect& pixelBounds, std::vector<LayerPixelRect>& out) const {
+        if (_all) {
+            out.emplace_back(pixelBounds);
+            return;
+        }
+
+        for (size_t i = 0; i < _count; ++i) {
+            const LayerPixelRect rect = LayerPixelRect::FromLayerRect(_rects[i], bounds, scale).Intersection(pixelBounds);
+            if (!rect.IsEmpty()) {
+                out.emplace_back(rect);
+            }
+        }
+    }
+
+private:
+    static float area(const CGRect& rect) {
+        return rect.size.width * rect.size.height;
+    }
+
+    CGRect _rects[c_maxRects];
+    size_t _count;
+    bool _all;
+};
+
+// One tile's worth of drawing for a frame: the tile to draw and the pixel rects within it to redraw.
+struct LayerTileUpdate {
+    size_t index;
+    std::vector<LayerPixelRect> rects;
+};
+
+// Splits a backing store too big for a single texture into fixed size tiles and tracks which of them hold valid contents.
+// Only tiles that are visible are ever drawn: visible tiles that have never been drawn are drawn whole, visible tiles with
+// contents only redraw where they are dirty, and invisible tiles that go stale are emptied to be drawn whole when next seen.
+class LayerTileGrid {
+public:
+    LayerTileGrid(int pixelWidth, int pixelHeight, int tileWidth, int tileHeight)
+        : _pixelWidth(pixelWidth),
+          _pixelHeight(pixelHeight),
+          _tileWidth(std::max(tileWidth, 1)),
+          _tileHeight(std::max(tileHeight, 1)),
+          _columns((pixelWidth + _tileWidth - 1) / _tileWidth),
+          _rows((pixelHeight + _tileHeight - 1) / _tileHeight),
+          _valid(static_cast<size_t>(_columns) * _rows, false) {
+    }
+
+    int PixelWidth() const {
+        return _pixelWidth;
+    }
+
+    int PixelHeight() const {
+        return _pixelHeight;
+    }
+
+    size_t Count() const {
+        return _valid.size();
+    }
+
+    LayerPixelRect TileRect(size_t index) const {
+        const int column = static_cast<int>(index % _columns);
+        const int row = static_cast<int>(index / _columns);
+        const int x = column * _tileWidth;
+        const int y = row * _tileHeight;
+        return { x, y, std::min(_tileWidth, _pixelWidth - x), std::min(_tileHeight, _pixelHeight - y) };
+    }
+
+    bool IsValid(size_t index) const {
+        return _valid[index];
+    }
+
+    // Works out the drawing needed to bring the tiles in visibleRect up to date with dirtyRects, marking them valid.
+    // The indices of tiles whose contents were dropped are appended to discarded.
+    void Update(const std::vector<LayerPixelRect>& dirtyRects,
+                const LayerPixelRect& visibleRect,
+                std::vector<LayerTileUpdate>& updates,
+                std::vector<size_t>& discarded) {
+        for (size_t i = 0; i < _valid.size(); ++i) {
+            const LayerPixelRect tile = TileRect(i);
+            const bool visible = tile.Intersects(visibleRect);
+
+            if (!_valid[i]) {
+                if (visible) {
+                    updates.emplace_back(LayerTileUpdate{ i, { tile } });
+                    _valid[i] = true;
+                }
+                continue;
+            }
+
+            std::vector<LayerPixelRect> rects;
+            for (const LayerPixelRect& dirty : dirtyRects) {
+                const LayerPixelRect rect = dirty.Intersection(tile);
+                if (!rect.IsEmpty()) {
+                    rects.emplace_back(rect);
+                }
+            }
+
+            if (rects.empty()) {
+                continue;
+            }
+
+            if (visible) {
+                updates.emplace_back(LayerTileUpdate{ i, std::move(rects) });
+            } else {
+                _valid[i] = false;
+                discarded.emplace_back(i);
+            }
+        }
+    }
+
+    // Returns true if any tile in visibleRect has yet to be drawn
+    bool NeedsUpdate(const LayerPixelRect& visibleRect) const {
+        const LayerPixelRect clipped = visibleRect.Intersection({ 0, 0, _pixelWidth, _pixelHeight });
+        if (clipped.IsEmpty()) {
+            return false;
+        }
+
+        const int firstColumn = clipped.x / _tileWidth;
+        const int lastColumn = (clipped.x + clipped.width - 1) / _tileWidth;
+        const int firstRow = clipped.y / _tileHeight;
+        const int lastRow = (clipped.y + clipped.height - 1) / _tileHeight;
+        for (int row = firstRow; row <= lastRow; ++row) {
+            for (int column = firstColumn; column <= lastColumn; ++column) {
+                if (!_valid[static_cast<size_t>(row) * _columns + column]) {
+                    return true;
+                }
+            }
+        }
+
+        return false;
+    }
+
+private:
+    int _pixelWidth;
+    int _pixelHeight;
+    int _tileWidth;
+    int _tileHeight;
+    int _columns;
+    int _rows;
+    std::vector<bool> _valid;
+};
@@ -0,0 +1,27 @@
+//******************************************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+//
+// This code is licensed under the MIT License (MIT).
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+//******************************************************************************
+
+#pragma once
+
+#import <Foundation/NSCache.h>
+
+@interface NSCache (Internal)
+// Creates a cache split into exactly stripeCount independently locked shards, whatever its limits. Each shard keeps its
+// own LRU order and enforces its share of countLimit and totalCostLimit, so eviction order is only approximately least
+// recently used across the whole cache. -init stripes by core count instead, falling back to one shard while it is
+// empty if given a cost limit or a count limit too small to spread.
+- (instancetype)_initWithStripeCount:(NSUInteger)stripeCount;
+@end
@@ -0,0 +1,33 @@
+//******************************************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+//
+// This code is licensed under the MIT License (MIT).
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+//******************************************************************************
+
+#pragma once
+
+#import <Foundation/NSData.h>
+
+// How a range of bytes is about to be read, in the spirit of madvise()
+typedef NS_ENUM(NSUInteger, _NSDataAccessPattern) {
+    _NSDataAccessPatternNormal,
+    _NSDataAccessPatternSequential,
+    _NSDataAccessPatternRandom,
+    _NSDataAccessPatternWillNeed,
+};
+
+@interface NSData (Internal)
+// Hints how the bytes in range will be read. Sequential and WillNeed page a file-mapped range in ahead of use; Normal and
+// Random leave paging on demand. Data that is not file-mapped is already resident, and ignores the hint.
+- (void)_adviseAccessPattern:(_NSDataAccessPattern)pattern range:(NSRange)range;
+@end
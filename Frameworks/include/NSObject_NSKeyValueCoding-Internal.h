@@ -25,4 +25,8 @@ bool KVCGetViaAccessor(NSObject* self, SEL getter, id* ret);
 bool KVCGetViaIvar(id self, struct objc_ivar* ivar, id* ret);
 SEL KVCSetterForPropertyName(NSObject* self, const char* key);
 bool KVCSetViaAccessor(NSObject* self, SEL setter, id value);
-bool KVCSetViaIvar(NSObject* self, struct objc_ivar* ivar, id value);
\ No newline at end of file
+bool KVCSetViaIvar(NSObject* self, struct objc_ivar* ivar, id value);
+
+// Forgets the accessors and instance variables KVC has resolved for cls and its subclasses; other classes keep theirs. Call
+// after adding or replacing methods that KVC may look up, and only when the method table actually changed.
+void _NSKVCInvalidateAccessorCache(Class cls);
\ No newline at end of file
@@ -32,7 +32,7 @@
 - (void)_addObserver:(NSObject*)observer forMode:(NSString*)mode;
 - (void)_removeObserver:(NSObject*)observer forMode:(NSString*)mode;
 - (StrongId<NSArray*>)_statesForMode:(NSString*)mode;
-- (void)_processMainRunLoop:(int)value;
+- (void)_processMainRunLoop:(int)value sockets:(const SocketWait*)sockets;
 - (void)_shutdown;
 - (void)removeTimer:(NSTimer*)timer forMode:(NSString*)mode;
 
@@ -18,7 +18,6 @@
 #import "NSInputSource.h"
 
 #define MAX_WAITSIGNALS 128
-#define MAX_WAITSOCKETS 128
 
 @interface NSRunLoopState : NSObject {
 @public
@@ -27,17 +26,9 @@
     id _waitSignalObjects[MAX_WAITSIGNALS];
     int _numWaitSignals;
 
-    int _waitSockets[MAX_WAITSOCKETS];
-    id _waitSocketObjects[MAX_WAITSOCKETS];
-    int _numWaitSockets;
-
-    idt(NSMutableArray) _timers;
     idt(NSMutableArray) _observers;
     idt(NSRunLoopSource) _cancelSource;
     int _starveCount;
-
-    bool _builtWakeupSockets;
-    int _wakeupSockets[2];
 }
 + (void)setUIThreadMainRunLoopWaitFunction:(int (*)(EbrEvent* events, int numEvents, double timeout, SocketWait* sockets))callback;
 - (NSObject*)init;
@@ -48,6 +39,7 @@
 - (void)addObserver:(NSTimer*)observer;
 - (void)removeObserver:(NSObject*)observer;
 - (void)removeTimer:(NSTimer*)timer;
+- (void)_rescheduleTimer:(NSTimer*)timer;
 - (void)changingIntoMode:(NSString*)mode;
 - (void)_notifyObservers:(uint32_t)mode;
 - (void)checkHighPriorityEvents;
@@ -59,4 +51,9 @@
 - (void)acceptInputForMode:(NSString*)mode beforeDate:(NSDate*)date;
 - (NSString*)description;
 - (void)_handleSignaledInput:(int)signaled;
+- (void)_handleSignaledInput:(int)signaled sockets:(const SocketWait*)sockets;
 @end
+
+// Copies the sockets a wait polls, for a wait that runs on another thread while the run loop can be re-entered and prepare
+// its own descriptors again. The copy is freed with IwFree.
+SocketWait* _NSRunLoopCopySocketWait(const SocketWait* sockets);
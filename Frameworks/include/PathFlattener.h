@@ -0,0 +1,121 @@
+//******************************************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+//
+// This code is licensed under the MIT License (MIT).
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+//******************************************************************************
+#pragma once
+
+#include <CoreGraphics/CGGeometry.h>
+#include <CoreGraphics/CGPath.h>
+
+#include <algorithm>
+#include <math.h>
+#include <stddef.h>
+
+// Curves are flattened until no point is further than this from the true curve, by default
+static const float c_pathFlatness = 0.1f;
+
+// The number of lines to flatten a curve into, given the largest second difference of its control points and the
+// constant relating it to the curve's deviation from a line: 1/4 for quadratic curves and 3/4 for cubic ones.
+inline int _PathSubdivisions(double secondDifference, double factor, double flatness) {
+    const double count = ceil(sqrt(factor * secondDifference / flatness));
+    return static_cast<int>(std::min(std::max(count, 1.0), 1024.0));
+}
+
+// Walks a path's elements with its curves replaced by lines, calling:
+//
+//     sink.MoveTo(point)             to start each subpath
+//     sink.LineTo(point, interior)   for each line; interior is true for the lines' joins within a curve
+//     sink.Close()                   for each kCGPathElementCloseSubpath
+//
+// Drawing with no current subpath first moves to where the last subpath started, as CGContext does.
+template <typename Element, typename Sink>
+void FlattenPath(const Element* elements, size_t count, Sink& sink, double flatness = c_pathFlatness) {
+    CGPoint start = CGPointZero;
+    CGPoint current = CGPointZero;
+    bool inSubpath = false;
+
+    auto beginDrawing = [&]() {
+        if (!inSubpath) {
+            sink.MoveTo(start);
+            current = start;
+            inSubpath = true;
+        }
+    };
+
+    for (size_t i = 0; i < count; ++i) {
+        const CGPoint* points = elements[i].points;
+        switch (elements[i].type) {
+            case kCGPathElementMoveToPoint:
+                start = current = points[0];
+                sink.MoveTo(start);
+                inSubpath = true;
+                break;
+
+            case kCGPathElementAddLineToPoint:
+                beginDrawing();
+                sink.LineTo(points[0], false);
+                current = points[0];
+                break;
+
+            case kCGPathElementAddQuadCurveToPoint: {
+                beginDrawing();
+                const CGPoint p0 = current;
+                const CGPoint p1 = points[0];
+                const CGPoint p2 = points[1];
+                const int subdivisions = _PathSubdivisions(hypot(p0.x - 2.0 * p1.x + p2.x, p0.y - 2.0 * p1.y + p2.y), 1.0 / 4.0, flatness);
+                for (int j = 1; j < subdivisions; ++j) {
+                    const double t = static_cast<double>(j) / subdivisions;
+                    const double u = 1.0 - t;
+                    sink.LineTo(CGPointMake(u * u * p0.x + 2.0 * u * t * p1.x + t * t * p2.x, u * u * p0.y + 2.0 * u * t * p1.y + t * t * p2.y),
+                                true);
+                }
+                sink.LineTo(p2, false);
+                current = p2;
+                break;
+            }
+
+            case kCGPathElementAddCurveToPoint: {
+                beginDrawing();
+                const CGPoint p0 = current;
+                const CGPoint p1 = points[0];
+                const CGPoint p2 = points[1];
+                const CGPoint p3 = points[2];
+                const double dd0 = hypot(p0.x - 2.0 * p1.x + p2.x, p0.y - 2.0 * p1.y + p2.y);
+                const double dd1 = hypot(p1.x - 2.0 * p2.x + p3.x, p1.y - 2.0 * p2.y + p3.y);
+                const int subdivisions = _PathSubdivisions(std::max(dd0, dd1), 3.0 / 4.0, flatness);
+                for (int j = 1; j < subdivisions; ++j) {
+                    const double t = static_cast<double>(j) / subdivisions;
+                    const double u = 1.0 - t;
+                    const double b0 = u * u * u;
+                    const double b1 = 3.0 * u * u * t;
+                    const double b2 = 3.0 * u * t * t;
+                    const double b3 = t * t * t;
+                    sink.LineTo(CGPointMake(b0 * p0.x + b1 * p1.x + b2 * p2.x + b3 * p3.x, b0 * p0.y + b1 * p1.y + b2 * p2.y + b3 * p3.y),
+                                true);
+                }
+                sink.LineTo(p3, false);
+                current = p3;
+                break;
+            }
+
+            case kCGPathElementCloseSubpath:
+                if (inSubpath) {
+                    sink.Close();
+                }
+                current = start;
+                inSubpath = false;
+                break;
+        }
+    }
+}
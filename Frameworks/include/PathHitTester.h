@@ -0,0 +1,176 @@
+//******************************************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+//
+// This code is licensed under the MIT License (MIT).
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+//******************************************************************************
+#pragma once
+
+#include "PathFlattener.h"
+
+#include <algorithm>
+#include <math.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+
+// Answers whether points lie in the fill of a path, without rasterizing it. The path is flattened once into line segments,
+// each subpath implicitly closed as it is when filled, and the segments are bucketed into horizontal bands so that a query
+// only computes the crossings of a ray from the point with the few segments in its band. Queries don't allocate.
+class PathHitTester {
+public:
+    template <typename Element>
+    PathHitTester(const Element* elements, size_t count) {
+        FlattenPath(elements, count, *this);
+
+        //  Every subpath is closed, the last one included
+        addLine(_current, _start);
+        buildBands();
+    }
+
+    // Flattened path sink, used while building
+    void MoveTo(CGPoint point) {
+        addLine(_current, _start);
+        _start = _current = point;
+    }
+
+    void LineTo(CGPoint point, bool) {
+        addLine(_current, point);
+        _current = point;
+    }
+
+    void Close() {
+        addLine(_current, _start);
+        _current = _start;
+    }
+
+    bool Contains(CGPoint point, bool eoFill) const {
+        const int winding = Winding(point);
+        return eoFill ? (winding & 1) != 0 : winding != 0;
+    }
+
+    // The number of times the path winds around point, counting edges crossed by a ray from it towards +x
+    int Winding(CGPoint point) const {
+        if (_bands.empty() || !(point.y >= _minY && point.y < _maxY) || !(point.x >= _minX && point.x < _maxX)) {
+            return 0;
+        }
+
+        const size_t band = std::min(static_cast<size_t>((point.y - _minY) * _bandScale), _bands.size() - 2);
+        int winding = 0;
+        for (uint32_t i = _bands[band]; i < _bands[band + 1]; ++i) {
+            const Segment& segment = _segments[_bandSegments[i]];
+            if (point.y < segment.y0 || point.y >= segment.y1) {
+                continue;
+            }
+
+            const double x = segment.x0 + (point.y - segment.y0) * segment.slope;
+            if (x > point.x) {
+                winding += segment.direction;
+            }
+        }
+
+        return winding;
+    }
+
+    size_t SegmentCount() const {
+        return _segments.size();
+    }
+
+private:
+    // An edge of the flattened path, with y0 < y1, and the direction it was drawn in: +1 for increasing y
+    struct Segment {
+        double x0;
+        double y0;
+        double y1;
+        double slope;
+        int direction;
+    };
+
+    void addLine(CGPoint from, CGPoint to) {
+        if (from.y == to.y) {
+            //  Horizontal edges never cross a horizontal ray
+            return;
+        }
+
+        const int direction = from.y < to.y ? 1 : -1;
+        if (direction < 0) {
+            std::swap(from, to);
+        }
+
+        _segments.push_back({ from.x, from.y, to.y, (static_cast<double>(to.x) - from.x) / (static_cast<double>(to.y) - from.y), direction });
+        _minX = std::min(_minX, static_cast<double>(std::min(from.x, to.x)));
+        _maxX = std::max(_maxX, static_cast<double>(std::max(from.x, to.x)));
+        _minY = std::min(_minY, static_cast<double>(from.y));
+        _maxY = std::max(_maxY, static_cast<double>(to.y));
+    }
+
+    // Buckets the segments into bands of equal height, each listing the segments overlapping it, laid out as one array
+    // indexed by _bands: band i's segments are _bandSegments[_bands[i]] up to _bandSegments[_bands[i + 1]].
+    void buildBands() {
+        if (_segments.empty()) {
+            return;
+        }
+
+        //  A few segments per band keeps a query to a handful of crossings, even for paths of many thousands of elements,
+        //  but bands much shorter than the segments only repeat them in more bands
+        double totalHeight = 0.0;
+        for (const Segment& segment : _segments) {
+            totalHeight += segment.y1 - segment.y0;
+        }
+
+        const double height = _maxY - _minY;
+        const double bandsPerSegmentHeight = 2.0 * height * _segments.size() / totalHeight;
+        const size_t bandCount = static_cast<size_t>(std::max(std::min({ _segments.size() / 4.0, bandsPerSegmentHeight, 4096.0 }), 1.0));
+        _bandScale = bandCount / height;
+
+        auto bandRange = [this, bandCount](const Segment& segment, size_t& first, size_t& last) {
+            first = std::min(static_cast<size_t>((segment.y0 - _minY) * _bandScale), bandCount - 1);
+            last = std::min(static_cast<size_t>((segment.y1 - _minY) * _bandScale), bandCount - 1);
+        };
+
+        _bands.assign(bandCount + 1, 0);
+        for (const Segment& segment : _segments) {
+            size_t first;
+            size_t last;
+            bandRange(segment, first, last);
+            for (size_t band = first; band <= last; ++band) {
+                ++_bands[band + 1];
+            }
+        }
+
+        for (size_t band = 0; band < bandCount; ++band) {
+            _bands[band + 1] += _bands[band];
+        }
+
+        _bandSegments.resize(_bands[bandCount]);
+        std::vector<uint32_t> next(_bands.begin(), _bands.end() - 1);
+        for (size_t i = 0; i < _segments.size(); ++i) {
+            size_t first;
+            size_t last;
+            bandRange(_segments[i], first, last);
+            for (size_t band = first; band <= last; ++band) {
+                _bandSegments[next[band]++] = static_cast<uint32_t>(i);
+            }
+        }
+    }
+
+    CGPoint _start = CGPointZero;
+    CGPoint _current = CGPointZero;
+    std::vector<Segment> _segments;
+    std::vector<uint32_t> _bands;
+    std::vector<uint32_t> _bandSegments;
+    double _bandScale = 0.0;
+    double _minX = INFINITY;
+    double _minY = INFINITY;
+    double _maxX = -INFINITY;
+    double _maxY = -INFINITY;
+};
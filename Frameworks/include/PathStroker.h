@@ -0,0 +1,418 @@
+//******************************************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+//
+// This code is licensed under the MIT License (MIT).
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+//******************************************************************************
+#pragma once
+
+#include "PathFlattener.h"
+
+#include <algorithm>
+#include <math.h>
+#include <stddef.h>
+#include <vector>
+
+// A path flattened into polylines, one per subpath, with repeated points dropped.
+class FlattenedSubpaths {
+public:
+    struct Vertex {
+        CGPoint point;
+
+        // True for the joins between the lines a curve was flattened into
+        bool interior;
+    };
+
+    struct Subpath {
+        std::vector<Vertex> vertices;
+        bool closed;
+
+        // False for a lone move, which draws nothing even with caps
+        bool drawn;
+    };
+
+    template <typename Element>
+    FlattenedSubpaths(const Element* elements, size_t count) {
+        FlattenPath(elements, count, *this);
+    }
+
+    const std::vector<Subpath>& Subpaths() const {
+        return _subpaths;
+    }
+
+    // Flattened path sink
+    void MoveTo(CGPoint point) {
+        _subpaths.push_back({ { { point, false } }, false, false });
+    }
+
+    void LineTo(CGPoint point, bool interior) {
+        Subpath& subpath = _subpaths.back();
+        subpath.drawn = true;
+
+        Vertex& last = subpath.vertices.back();
+        if (last.point.x == point.x && last.point.y == point.y) {
+            last.interior = last.interior && interior;
+            return;
+        }
+
+        subpath.vertices.push_back({ point, interior });
+    }
+
+    void Close() {
+        Subpath& subpath = _subpaths.back();
+        subpath.closed = true;
+        subpath.drawn = true;
+
+        //  The closing line is implied
+        const CGPoint first = subpath.vertices.front().point;
+        if (subpath.vertices.size() > 1 && subpath.vertices.back().point.x == first.x && subpath.vertices.back().point.y == first.y) {
+            subpath.vertices.pop_back();
+        }
+    }
+
+private:
+    std::vector<Subpath> _subpaths;
+};
+
+// Outlines the area a path covers when stroked, as a path to be filled with the nonzero winding rule. Each subpath is
+// flattened and offset by half the line width to either side, with the chosen joins between its lines and caps on its
+// open ends. Round joins and caps are drawn as cubic curves. The outline is written to a sink with MoveTo(point),
+// LineTo(point), CurveTo(control1, control2, point) and Close().
+//
+// Where a join turns inwards, the two sides are connected through the joint itself, which keeps the region filled with
+// the nonzero rule however short the lines and however small a closed shape is.
+template <typename Sink>
+class PathStroker {
+public:
+    PathStroker(Sink& sink, double lineWidth, CGLineCap cap, CGLineJoin join, double miterLimit)
+        : _sink(sink), _halfWidth(fabs(lineWidth) / 2.0), _cap(cap), _join(join), _miterLimit(std::max(miterLimit, 1.0)) {
+    }
+
+    void Stroke(const FlattenedSubpaths& path) {
+        if (_halfWidth <= 0.0) {
+            return;
+        }
+
+        for (const FlattenedSubpaths::Subpath& subpath : path.Subpaths()) {
+            const std::vector<FlattenedSubpaths::Vertex>& vertices = subpath.vertices;
+            if (!subpath.drawn) {
+                continue;
+            }
+
+            if (vertices.size() == 1) {
+                dot(vertices[0].point);
+            } else if (subpath.closed) {
+                //  A closed subpath is outlined by the offset loops on either side, the right hand one reversed
+                side(vertices, true, false);
+                _sink.Close();
+                side(vertices, true, true);
+                _sink.Close();
+            } else {
+                side(vertices, false, false);
+                cap(vertices.back().point, direction(vertices[vertices.size() - 2].point, vertices.back().point));
+                side(vertices, false, true);
+                cap(vertices.front().point, direction(vertices[1].point, vertices.front().point));
+                _sink.Close();
+            }
+        }
+    }
+
+private:
+    struct Vector {
+        double x;
+        double y;
+    };
+
+    static Vector direction(CGPoint from, CGPoint to) {
+        const double dx = static_cast<double>(to.x) - from.x;
+        const double dy = static_cast<double>(to.y) - from.y;
+        const double length = hypot(dx, dy);
+        return { dx / length, dy / length };
+    }
+
+    // The normal to a direction on its left, for a y-up coordinate system
+    static Vector normal(Vector direction) {
+        return { -direction.y, direction.x };
+    }
+
+    CGPoint offset(CGPoint point, Vector vector, double distance) const {
+        return CGPointMake(point.x + vector.x * distance, point.y + vector.y * distance);
+    }
+
+    // Offsets a polyline to the left, or the left of it reversed, starting from the offset of its first vertex, which is
+    // moved to unless the polyline is open and reversed, when the cap at its end has just reached it.
+    void side(const std::vector<FlattenedSubpaths::Vertex>& vertices, bool closed, bool reversed) {
+        const size_t count = vertices.size();
+        auto vertex = [&](size_t index) -> const FlattenedSubpaths::Vertex& {
+            index %= count;
+            return vertices[reversed ? count - 1 - index : index];
+        };
+
+        Vector incoming = direction(vertex(0).point, vertex(1).point);
+        if (closed || !reversed) {
+            _sink.MoveTo(offset(vertex(0).point, normal(incoming), _halfWidth));
+        }
+
+        const size_t last = closed ? count : count - 1;
+        for (size_t i = 1; i < last; ++i) {
+            const Vector outgoing = direction(vertex(i).point, vertex(i + 1).point);
+            join(vertex(i), incoming, outgoing);
+            incoming = outgoing;
+        }
+
+        if (closed) {
+            join(vertex(0), incoming, direction(vertex(0).point, vertex(1).point));
+        } else {
+            _sink.LineTo(offset(vertex(count - 1).point, normal(incoming), _halfWidth));
+        }
+    }
+
+    void join(const FlattenedSubpaths::Vertex& vertex, Vector incoming, Vector outgoing) {
+        const CGPoint point = vertex.point;
+        const Vector incomingNormal = normal(incoming);
+        const Vector outgoingNormal = normal(outgoing);
+        const double cross = incoming.x * outgoing.y - incoming.y * outgoing.x;
+        const double dot = incoming.x * outgoing.x + incoming.y * outgoing.y;
+        const Vector miter = { (incomingNormal.x + outgoingNormal.x) / (1.0 + dot), (incomingNormal.y + outgoingNormal.y) / (1.0 + dot) };
+
+        if (fabs(cross) < 1e-9 && dot > 0.0) {
+            _sink.LineTo(offset(point, outgoingNormal, _halfWidth));
+            return;
+        }
+
+        if (cross > 0.0) {
+            //  Turning left, so this side is the inside of the turn
+            _sink.LineTo(offset(point, incomingNormal, _halfWidth));
+            _sink.LineTo(point);
+            _sink.LineTo(offset(point, outgoingNormal, _halfWidth));
+            return;
+        }
+
+        _sink.LineTo(offset(point, incomingNormal, _halfWidth));
+
+        //  The miter length relative to the line width, 1 / sin(angle between the lines / 2)
+        const double miterRatio = dot > -1.0 ? 1.0 / sqrt((1.0 + dot) / 2.0) : INFINITY;
+        CGLineJoin join = _join;
+        if (vertex.interior) {
+            //  Within a curve, whatever keeps closest to its true offset
+            join = miterRatio <= 2.0 ? kCGLineJoinMiter : kCGLineJoinRound;
+        } else if (join == kCGLineJoinMiter && miterRatio > _miterLimit) {
+            join = kCGLineJoinBevel;
+        }
+
+        switch (join) {
+            case kCGLineJoinMiter:
+                _sink.LineTo(offset(point, miter, _halfWidth));
+                _sink.LineTo(offset(point, outgoingNormal, _halfWidth));
+                break;
+
+            case kCGLineJoinRound: {
+                //  Always clockwise, since a reversal's cross product can come out as +0
+                const double sweep = -atan2(fabs(cross), dot);
+                arc(point, atan2(incomingNormal.y, incomingNormal.x), sweep);
+                break;
+            }
+
+            default:
+                _sink.LineTo(offset(point, outgoingNormal, _halfWidth));
+                break;
+        }
+    }
+
+    // Caps the end of a line at point, where it runs in direction, from its left side to its right
+    void cap(CGPoint point, Vector direction) {
+        const Vector left = normal(direction);
+        switch (_cap) {
+            case kCGLineCapRound:
+                arc(point, atan2(left.y, left.x), -M_PI);
+                break;
+
+            case kCGLineCapSquare:
+                _sink.LineTo(offset(offset(point, left, _halfWidth), direction, _halfWidth));
+                _sink.LineTo(offset(offset(point, left, -_halfWidth), direction, _halfWidth));
+                _sink.LineTo(offset(point, left, -_halfWidth));
+                break;
+
+            default:
+                _sink.LineTo(offset(point, left, -_halfWidth));
+                break;
+        }
+    }
+
+    // A subpath that doesn't go anywhere only shows its caps
+    void dot(CGPoint point) {
+        switch (_cap) {
+            case kCGLineCapRound:
+                _sink.MoveTo(CGPointMake(point.x + _halfWidth, point.y));
+                arc(point, 0.0, 2.0 * M_PI);
+                _sink.Close();
+                break;
+
+            case kCGLineCapSquare:
+                _sink.MoveTo(CGPointMake(point.x - _halfWidth, point.y - _halfWidth));
+                _sink.LineTo(CGPointMake(point.x + _halfWidth, point.y - _halfWidth));
+                _sink.LineTo(CGPointMake(point.x + _halfWidth, point.y + _halfWidth));
+                _sink.LineTo(CGPointMake(point.x - _halfWidth, point.y + _halfWidth));
+                _sink.Close();
+                break;
+
+            default:
+                break;
+        }
+    }
+
+    // Continues from the point at startAngle on the circle of half the line width around center, along a signed sweep,
+    // in cubic curves of at most a quarter turn each
+    void arc(CGPoint center, double startAngle, double sweep) {
+        const int count = std::max(1, static_cast<int>(ceil(fabs(sweep) / M_PI_2 - 1e-9)));
+        const double step = sweep / count;
+        const double k = 4.0 / 3.0 * tan(step / 4.0) * _halfWidth;
+
+        double angle = startAngle;
+        for (int i = 0; i < count; ++i) {
+            const double next = angle + step;
+            const CGPoint from = CGPointMake(center.x + cos(angle) * _halfWidth, center.y + sin(angle) * _halfWidth);
+            const CGPoint to = CGPointMake(center.x + cos(next) * _halfWidth, center.y + sin(next) * _halfWidth);
+            _sink.CurveTo(CGPointMake(from.x - k * sin(angle), from.y + k * cos(angle)),
+                          CGPointMake(to.x + k * sin(next), to.y - k * cos(next)),
+                          to);
+            angle = next;
+        }
+    }
+
+    Sink& _sink;
+    double _halfWidth;
+    CGLineCap _cap;
+    CGLineJoin _join;
+    double _miterLimit;
+};
+
+// Breaks a path into dashes: runs of the given lengths, alternately drawn and skipped, starting phase into the pattern.
+// An odd number of lengths is repeated twice over, so that each length is drawn and skipped in turn. The pattern starts
+// over with each subpath, and a closed subpath's first and last dashes are joined into one. The dashes are written to a
+// sink with MoveTo(point), LineTo(point) and Close().
+//
+// Returns false, without writing anything, if the pattern doesn't advance.
+template <typename Sink>
+bool DashPath(const FlattenedSubpaths& path, double phase, const CGFloat* lengths, size_t count, Sink& sink) {
+    std::vector<double> pattern(lengths, lengths + count);
+    if (count % 2) {
+        pattern.insert(pattern.end(), lengths, lengths + count);
+    }
+
+    double total = 0.0;
+    for (double length : pattern) {
+        if (length < 0.0 || !isfinite(length)) {
+            return false;
+        }
+        total += length;
+    }
+
+    if (!(total > 0.0)) {
+        return false;
+    }
+
+    phase = fmod(phase, total);
+    if (phase < 0.0) {
+        phase += total;
+    }
+
+    size_t startIndex = 0;
+    while (phase >= pattern[startIndex]) {
+        phase -= pattern[startIndex];
+        startIndex = (startIndex + 1) % pattern.size();
+    }
+    const double startRemaining = pattern[startIndex] - phase;
+
+    std::vector<std::vector<CGPoint>> dashes;
+    for (const FlattenedSubpaths::Subpath& subpath : path.Subpaths()) {
+        if (!subpath.drawn) {
+            continue;
+        }
+
+        std::vector<CGPoint> points;
+        for (const FlattenedSubpaths::Vertex& vertex : subpath.vertices) {
+            points.push_back(vertex.point);
+        }
+        if (subpath.closed) {
+            points.push_back(points.front());
+        }
+
+        size_t index = startIndex;
+        double remaining = startRemaining;
+        bool on = index % 2 == 0;
+        bool toggled = false;
+
+        dashes.clear();
+        if (on) {
+            dashes.push_back({ points.front() });
+        }
+
+        for (size_t i = 1; i < points.size(); ++i) {
+            const CGPoint from = points[i - 1];
+            const CGPoint to = points[i];
+            const double length = hypot(static_cast<double>(to.x) - from.x, static_cast<double>(to.y) - from.y);
+
+            double position = 0.0;
+            while (remaining < length - position) {
+                position += remaining;
+                const double t = position / length;
+                const CGPoint point = CGPointMake(from.x + (to.x - from.x) * t, from.y + (to.y - from.y) * t);
+                if (on) {
+                    dashes.back().push_back(point);
+                } else {
+                    dashes.push_back({ point });
+                }
+
+                index = (index + 1) % pattern.size();
+                remaining = pattern[index];
+                on = !on;
+                toggled = true;
+            }
+
+            remaining -= length - position;
+            if (on) {
+                dashes.back().push_back(to);
+            }
+        }
+
+        if (subpath.closed && on && !toggled) {
+            //  The whole loop is one dash
+            sink.MoveTo(dashes.front().front());
+            for (size_t i = 1; i + 1 < dashes.front().size(); ++i) {
+                sink.LineTo(dashes.front()[i]);
+            }
+            sink.Close();
+            continue;
+        }
+
+        if (subpath.closed && on && startIndex % 2 == 0 && dashes.size() > 1) {
+            //  The last dash runs on into the first
+            dashes.back().insert(dashes.back().end(), dashes.front().begin() + 1, dashes.front().end());
+            dashes.erase(dashes.begin());
+        }
+
+        for (const std::vector<CGPoint>& dash : dashes) {
+            sink.MoveTo(dash.front());
+            for (size_t i = 1; i < dash.size(); ++i) {
+                sink.LineTo(dash[i]);
+            }
+
+            //  A dash of no length still shows its caps
+            if (dash.size() == 1) {
+                sink.LineTo(dash.front());
+            }
+        }
+    }
+
+    return true;
+}
@@ -166,13 +166,21 @@ SB_EXPORT void EbrEventWait(EbrEvent event);
 SB_EXPORT bool EbrEventTryWait(EbrEvent event);
 SB_EXPORT bool EbrEventTimedWait(EbrEvent event, double seconds);
 
+// Sockets for EbrEventTimedMultipleWait to poll while it waits for the events. descriptors points at numDescriptors
+// WSAPOLLFD entries that the caller keeps registered from one wait to the next; the first entry must be WakeupSocketRead,
+// which is written to whenever one of the events is signaled. result receives the number of ready entries.
 typedef struct {
     int WakeupSocketRead, WakeupSocketWrite;
-    void *fdread, *fdwrite, *fderror;
-    int max, result;
+    void* descriptors;
+    int numDescriptors;
+    int result;
 } SocketWait;
 
 SB_EXPORT int EbrEventTimedMultipleWait(EbrEvent* events, int numEvents, double timeout, SocketWait* sockets);
+
+// WSAPoll over numDescriptors WSAPOLLFD entries, which also reports a non-blocking connect that fails as POLLERR, on the
+// Windows versions where WSAPoll alone never does. timeout is in milliseconds, or negative to wait indefinitely.
+SB_EXPORT int EbrSocketPoll(void* descriptors, int numDescriptors, int timeout);
 SB_EXPORT void EbrEventDestroy(EbrEvent event);
 
 #endif
@@ -0,0 +1,355 @@
+//******************************************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+//
+// This code is licensed under the MIT License (MIT).
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+//******************************************************************************
+
+#pragma once
+
+#include <assert.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+
+// Bookkeeping embedded in every element of a TableViewRowIndex.
+class TableViewRowIndexNode {
+public:
+    TableViewRowIndexNode()
+        : _treeLeft(nullptr),
+          _treeRight(nullptr),
+          _treeParent(nullptr),
+          _treePriority(0),
+          _treeCount(1),
+          _treeHeight(0.0f),
+          _treeTotalHeight(0.0) {
+    }
+
+    // The height this node was given in the index
+    float indexedHeight() const {
+        return _treeHeight;
+    }
+
+private:
+    template <class T>
+    friend class TableViewRowIndex;
+
+    TableViewRowIndexNode* _treeLeft;
+    TableViewRowIndexNode* _treeRight;
+    TableViewRowIndexNode* _treeParent;
+    uint32_t _treePriority;
+
+    // Number of nodes and summed height of the subtree rooted here
+    size_t _treeCount;
+    float _treeHeight;
+    double _treeTotalHeight;
+};
+
+// An ordered sequence of heights, such as the rows of a table section, kept in a treap keyed implicitly by position.
+// Each subtree caches its node count and summed height, so positional lookup, offset queries, offset hit-testing, height
+// updates, insertion and removal are all O(log N). Elements derive from TableViewRowIndexNode and are not owned by the index.
+template <class T>
+class TableViewRowIndex {
+public:
+    TableViewRowIndex() : _root(nullptr), _seed(0x9e3779b9) {
+    }
+
+    TableViewRowIndex(const TableViewRowIndex&) = delete;
+    TableViewRowIndex& operator=(const TableViewRowIndex&) = delete;
+
+    size_t count() const {
+        return _root ? _root->_treeCount : 0;
+    }
+
+    double totalHeight() const {
+        return _root ? _root->_treeTotalHeight : 0.0;
+    }
+
+    // The element at index, or nullptr if index is out of range
+    T* at(size_t index) const {
+        TableViewRowIndexNode* node = _root;
+        while (node) {
+            const size_t leftCount = _countOf(node->_treeLeft);
+            if (index < leftCount) {
+                node = node->_treeLeft;
+            } else if (index == leftCount) {
+                return static_cast<T*>(node);
+            } else {
+                index -= leftCount + 1;
+                node = node->_treeRight;
+            }
+        }
+
+        return nullptr;
+    }
+
+    size_t indexOf(const T* element) const {
+        const TableViewRowIndexNode* node = element;
+        size_t index = _countOf(node->_treeLeft);
+        for (; node->_treeParent; node = node->_treeParent) {
+            if (node == node->_treeParent->_treeRight) {
+                index += _countOf(node->_treeParent->_treeLeft) + 1;
+            }
+        }
+
+        return index;
+    }
+
+    // Summed height of the elements before element
+    double offsetOf(const T* element) const {
+        const TableViewRowIndexNode* node = element;
+        double offset = _heightOf(node->_treeLeft);
+        for (; node->_treeParent; node = node->_treeParent) {
+            if (node == node->_treeParent->_treeRight) {
+                offset += _heightOf(node->_treeParent->_treeLeft) + node->_treeParent->_treeHeight;
+            }
+        }
+
+        return offset;
+    }
+
+    // Summed height of the elements before index; totalHeight() when index is count()
+    double offsetAt(size_t index) const {
+        double offset = 0.0;
+        TableViewRowIndexNode* node = _root;
+        while (node) {
+            const size_t leftCount = _countOf(node->_treeLeft);
+            if (index <= leftCount) {
+                if (index == leftCount) {
+                    return offset + _heightOf(node->_treeLeft);
+                }
+
+                node = node->_treeLeft;
+            } else {
+                index -= leftCount + 1;
+                offset += _heightOf(node->_treeLeft) + node->_treeHeight;
+                node = node->_treeRight;
+            }
+        }
+
+        return offset;
+    }
+
+    // The element whose extent [offsetOf, offsetOf + height) contains offset, or nullptr if offset lies outside
+    // [0, totalHeight()). Zero-height elements are never returned.
+    T* atOffset(double offset) const {
+        TableViewRowIndexNode* node = _root;
+        while (node) {
+            const double leftHeight = _heightOf(node->_treeLeft);
+            if (offset < leftHeight) {
+                node = node->_treeLeft;
+            } else if (offset < leftHeight + node->_treeHeight) {
+                return static_cast<T*>(node);
+            } else {
+                offset -= leftHeight + node->_treeHeight;
+                node = node->_treeRight;
+            }
+        }
+
+        return nullptr;
+    }
+
+    void setHeight(T* element, float height) {
+        TableViewRowIndexNode* node = element;
+        node->_treeHeight = height;
+        _updateToRoot(node);
+    }
+
+    // Inserts element so that it ends up at index; index may be count() to append
+    void insert(size_t index, T* element, float height) {
+        TableViewRowIndexNode* node = element;
+        assert(index <= count());
+        _reset(node, height);
+
+        if (!_root) {
+            _root = node;
+            return;
+        }
+
+        //  Descend to the empty slot just before the element currently at index
+        TableViewRowIndexNode* parent = _root;
+        for (;;) {
+            const size_t leftCount = _countOf(parent->_treeLeft);
+            if (index <= leftCount) {
+                if (!parent->_treeLeft) {
+                    parent->_treeLeft = node;
+                    break;
+                }
+
+                parent = parent->_treeLeft;
+            } else {
+                index -= leftCount + 1;
+                if (!parent->_treeRight) {
+                    parent->_treeRight = node;
+                    break;
+                }
+
+                parent = parent->_treeRight;
+            }
+        }
+
+        node->_treeParent = parent;
+        _updateToRoot(parent);
+
+        while (node->_treeParent && node->_treeParent->_treePriority < node->_treePriority) {
+            _rotateUp(node);
+        }
+    }
+
+    void append(T* element, float height) {
+        insert(count(), element, height);
+    }
+
+    void erase(T* element) {
+        TableViewRowIndexNode* node = element;
+
+        //  Rotate the node down until it has at most one child, then splice it out
+        while (node->_treeLeft && node->_treeRight) {
+            _rotateUp((node->_treeLeft->_treePriority > node->_treeRight->_treePriority) ? node->_treeLeft : node->_treeRight);
+        }
+
+        TableViewRowIndexNode* child = node->_treeLeft ? node->_treeLeft : node->_treeRight;
+        TableViewRowIndexNode* parent = node->_treeParent;
+        if (child) {
+            child->_treeParent = parent;
+        }
+
+        _replaceChild(parent, node, child);
+        _updateToRoot(parent);
+
+        node->_treeLeft = node->_treeRight = node->_treeParent = nullptr;
+    }
+
+    // Replaces the contents with elements, in order, in O(N)
+    void assign(const std::vector<T*>& elements, const std::vector<float>& heights) {
+        assert(elements.size() == heights.size());
+        clear();
+
+        //  Build the Cartesian tree of random priorities along the right spine, then fill in the subtree totals
+        std::vector<TableViewRowIndexNode*> spine;
+        for (size_t i = 0; i < elements.size(); ++i) {
+            TableViewRowIndexNode* node = elements[i];
+            _reset(node, heights[i]);
+
+            TableViewRowIndexNode* last = nullptr;
+            while (!spine.empty() && spine.back()->_treePriority < node->_treePriority) {
+                last = spine.back();
+                spine.pop_back();
+            }
+
+            node->_treeLeft = last;
+            if (last) {
+                last->_treeParent = node;
+            }
+
+            if (!spine.empty()) {
+                spine.back()->_treeRight = node;
+                node->_treeParent = spine.back();
+            }
+
+            spine.push_back(node);
+        }
+
+        if (!spine.empty()) {
+            _root = spine.front();
+            _updateSubtree(_root);
+        }
+    }
+
+    // Detaches every element; the elements themselves are left alone
+    void clear() {
+        _root = nullptr;
+    }
+
+private:
+    static size_t _countOf(const TableViewRowIndexNode* node) {
+        return node ? node->_treeCount : 0;
+    }
+
+    static double _heightOf(const TableViewRowIndexNode* node) {
+        return node ? node->_treeTotalHeight : 0.0;
+    }
+
+    static void _update(TableViewRowIndexNode* node) {
+        node->_treeCount = 1 + _countOf(node->_treeLeft) + _countOf(node->_treeRight);
+        node->_treeTotalHeight = node->_treeHeight + _heightOf(node->_treeLeft) + _heightOf(node->_treeRight);
+    }
+
+    static void _updateToRoot(TableViewRowIndexNode* node) {
+        for (; node; node = node->_treeParent) {
+            _update(node);
+        }
+    }
+
+    static void _updateSubtree(TableViewRowIndexNode* node) {
+        if (node) {
+            _updateSubtree(node->_treeLeft);
+            _updateSubtree(node->_treeRight);
+            _update(node);
+        }
+    }
+
+    void _reset(TableViewRowIndexNode* node, float height) {
+        //  xorshift32; the treap only needs priorities that are independent of the insertion order
+        _seed ^= _seed << 13;
+        _seed ^= _seed >> 17;
+        _seed ^= _seed << 5;
+
+        node->_treeLeft = node->_treeRight = node->_treeParent = nullptr;
+        node->_treePriority = _seed;
+        node->_treeHeight = height;
+        node->_treeCount = 1;
+        node->_treeTotalHeight = height;
+    }
+
+    void _replaceChild(TableViewRowIndexNode* parent, TableViewRowIndexNode* child, TableViewRowIndexNode* replacement) {
+        if (!parent) {
+            _root = replacement;
+        } else if (parent->_treeLeft == child) {
+            parent->_treeLeft = replacement;
+        } else {
+            parent->_treeRight = replacement;
+        }
+    }
+
+    // Rotates node above its parent, keeping the in-order sequence
+    void _rotateUp(TableViewRowIndexNode* node) {
+        TableViewRowIndexNode* parent = node->_treeParent;
+        TableViewRowIndexNode* grandparent = parent->_treeParent;
+
+        if (parent->_treeLeft == node) {
+            parent->_treeLeft = node->_treeRight;
+            if (node->_treeRight) {
+                node->_treeRight->_treeParent = parent;
+            }
+
+            node->_treeRight = parent;
+        } else {
+            parent->_treeRight = node->_treeLeft;
+            if (node->_treeLeft) {
+                node->_treeLeft->_treeParent = parent;
+            }
+
+            node->_treeLeft = parent;
+        }
+
+        parent->_treeParent = node;
+        node->_treeParent = grandparent;
+        _replaceChild(grandparent, parent, node);
+
+        _update(parent);
+        _update(node);
+    }
+
+    TableViewRowIndexNode* _root;
+    uint32_t _seed;
+};
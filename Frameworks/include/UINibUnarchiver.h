@@ -15,23 +15,21 @@
 //******************************************************************************
 #pragma once
 
-class Object;
-class Item;
+#include <memory>
+
+// The parsed, immutable contents of a NIBArchive: classes resolved, keys interned and every object's items indexed by key.
+// One archive can back any number of unarchivers, so a UINib parses its data once however many times it is instantiated.
+class UINibArchive;
 
 @interface UINibUnarchiver : NSCoder {
 @public
-    char* _nibData;
-    DWORD _nibLen;
-
-    DWORD _fixed[10];
+    std::shared_ptr<const UINibArchive> _archive;
 
-    char** _classNames;
-    id* _classTypes;
-    char** _keyNames;
-    Object** _objects;
-    Item** _objectItems;
-    Object* _curObject[16];
+    // The objects and item values decoded so far by this unarchiver, indexed like the archive's objects and items
+    id* _objectInstances;
+    id* _itemInstances;
 
+    uint32_t _curObject[16];
     int _curObjectLevel;
 
     id _bundle;
@@ -39,6 +37,7 @@ class Item;
 - (double)decodeDoubleForKey:(id)key;
 - (float)decodeFloatForKey:(id)key;
 - (instancetype)initForReadingWithData:(NSData*)data;
+- (instancetype)_initWithArchive:(std::shared_ptr<const UINibArchive>)archive;
 - (NSObject*)decodeRootObject;
 - (NSObject*)decodeObjectForKey:(NSString*)key;
 - (BOOL)containsValueForKey:(NSString*)key;
@@ -52,4 +51,5 @@ class Item;
 - (void)dealloc;
 + (id)unarchiveObjectWithFile:(NSString*)file;
 + (id)unarchiveObjectWithData:(NSData*)data;
-@end
\ No newline at end of file
++ (std::shared_ptr<const UINibArchive>)_archiveWithData:(NSData*)data;
+@end
@@ -40,6 +40,7 @@ struct UITableViewPriv {
     StrongId<NSMutableDictionary> _reusableCellClasses;
 
     float _defaultRowHeight;
+    float _estimatedRowHeight;
     float _defaultSectionHeaderHeight;
 
     TableViewNode* _rootNode;
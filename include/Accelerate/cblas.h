@@ -33,6 +33,8 @@ enum CBLAS_UPLO {CblasUpper=121, CblasLower=122};
 enum CBLAS_DIAG {CblasNonUnit=131, CblasUnit=132};
 enum CBLAS_SIDE {CblasLeft=141, CblasRight=142};
 
+typedef enum {BLAS_THREADING_MULTI_THREADED=0, BLAS_THREADING_SINGLE_THREADED=1} BLAS_THREADING;
+
 typedef void(*BLASParamErrorProc)( const char *funcName, const char *paramName, const int *paramPos, const int *paramValue);
 
 #ifdef __cplusplus
@@ -613,6 +615,13 @@ ACCELERATE_IMPEXP void cblas_crotg(void* a, void* b, void* c, void* s);
 ACCELERATE_IMPEXP void cblas_zrotg(void* a, void* b, void* c, void* s);
 ACCELERATE_IMPEXP void cblas_zdrot(const int N, void* X, const int incX, void* Y, const int incY, const double c, const double s);
 
+// Threading of the level 3 routines. BLASSetThreadCount(0) restores the default of one thread per core; larger counts are
+// clamped to the number of cores.
+ACCELERATE_IMPEXP int BLASSetThreading(BLAS_THREADING threading);
+ACCELERATE_IMPEXP BLAS_THREADING BLASGetThreading(void);
+ACCELERATE_IMPEXP void BLASSetThreadCount(int count);
+ACCELERATE_IMPEXP int BLASGetThreadCount(void);
+
 ACCELERATE_IMPEXP void SetBLASParamErrorProc(BLASParamErrorProc __ErrorProc);
 
 ACCELERATE_IMPEXP void BLASDefaultErrorProc(const char *funcName, const char *paramName, const int *paramPos, const int *paramValue);
@@ -53,11 +53,16 @@ typedef enum {
     ZROP = 2
 } vDSP_DFT_TransformType;
 
+//Precomputed twiddle factors owned by a DFT setup object
+struct vDSP_DFT_TwiddleStruct;
+struct vDSP_DFT_TwiddleStructD;
+
 //Setup object to be fed while computing the DFT/IDFT for a set of single-precision vectors   
 typedef struct vDSP_DFT_SetupStruct {
     vDSP_Length transformLength;
     vDSP_DFT_Direction transformDirection;
     vDSP_DFT_TransformType transformType;
+    struct vDSP_DFT_TwiddleStruct* twiddles;
 } *vDSP_DFT_Setup;
 
 //Setup object to be fed while computing the DFT/IDFT for a set of double-precision vectors
@@ -65,8 +70,28 @@ typedef struct vDSP_DFT_SetupStructD {
     vDSP_Length transformLength;
     vDSP_DFT_Direction transformDirection;
     vDSP_DFT_TransformType transformType;
+    struct vDSP_DFT_TwiddleStructD* twiddles;
 } *vDSP_DFT_SetupD;
 
+//Setup objects holding the twiddle factors for power-of-two FFTs of up to 2^Log2n elements
+typedef struct OpaqueFFTSetup* FFTSetup;
+typedef struct OpaqueFFTSetupD* FFTSetupD;
+
+//Specifies whether to perform a forward or inverse FFT
+typedef int FFTDirection;
+enum {
+    kFFTDirection_Forward = +1,
+    kFFTDirection_Inverse = -1
+};
+
+//Specifies the radix of the FFTs a setup object is created for
+typedef int FFTRadix;
+enum {
+    kFFTRadix2 = 0,
+    kFFTRadix3 = 1,
+    kFFTRadix5 = 2
+};
+
 ACCELERATE_EXPORT void vDSP_vabs(const float* A, vDSP_Stride IA, float* C, vDSP_Stride IC, vDSP_Length N);
 ACCELERATE_EXPORT void vDSP_vabsD(const double* A, vDSP_Stride IA, double* C, vDSP_Stride IC, vDSP_Length N);
 ACCELERATE_EXPORT void vDSP_vabsi(const int* A, vDSP_Stride IA, int* C, vDSP_Stride IC, vDSP_Length N);
@@ -205,4 +230,25 @@ ACCELERATE_EXPORT void vDSP_DFT_DestroySetupD(vDSP_DFT_SetupD __Setup);
 ACCELERATE_EXPORT void vDSP_DFT_Execute(const struct vDSP_DFT_SetupStruct *__Setup, const float *__Ir, const float *__Ii, float *__Or,
                                         float *__Oi);
 ACCELERATE_EXPORT void vDSP_DFT_ExecuteD(const struct vDSP_DFT_SetupStructD *__Setup, const double *__Ir, const double *__Ii, double *__Or,
-                                         double *__Oi);
\ No newline at end of file
+                                         double *__Oi);
+
+ACCELERATE_EXPORT FFTSetup vDSP_create_fftsetup(vDSP_Length __Log2n, FFTRadix __Radix);
+ACCELERATE_EXPORT FFTSetupD vDSP_create_fftsetupD(vDSP_Length __Log2n, FFTRadix __Radix);
+ACCELERATE_EXPORT void vDSP_destroy_fftsetup(FFTSetup __setup);
+ACCELERATE_EXPORT void vDSP_destroy_fftsetupD(FFTSetupD __setup);
+ACCELERATE_EXPORT void vDSP_fft_zip(FFTSetup __Setup, const DSPSplitComplex* __C, vDSP_Stride __IC, vDSP_Length __Log2N,
+                                    FFTDirection __Direction);
+ACCELERATE_EXPORT void vDSP_fft_zipD(FFTSetupD __Setup, const DSPDoubleSplitComplex* __C, vDSP_Stride __IC, vDSP_Length __Log2N,
+                                     FFTDirection __Direction);
+ACCELERATE_EXPORT void vDSP_fft_zop(FFTSetup __Setup, const DSPSplitComplex* __A, vDSP_Stride __IA, const DSPSplitComplex* __C,
+                                    vDSP_Stride __IC, vDSP_Length __Log2N, FFTDirection __Direction);
+ACCELERATE_EXPORT void vDSP_fft_zopD(FFTSetupD __Setup, const DSPDoubleSplitComplex* __A, vDSP_Stride __IA,
+                                     const DSPDoubleSplitComplex* __C, vDSP_Stride __IC, vDSP_Length __Log2N, FFTDirection __Direction);
+ACCELERATE_EXPORT void vDSP_fft_zrip(FFTSetup __Setup, const DSPSplitComplex* __C, vDSP_Stride __IC, vDSP_Length __Log2N,
+                                     FFTDirection __Direction);
+ACCELERATE_EXPORT void vDSP_fft_zripD(FFTSetupD __Setup, const DSPDoubleSplitComplex* __C, vDSP_Stride __IC, vDSP_Length __Log2N,
+                                      FFTDirection __Direction);
+ACCELERATE_EXPORT void vDSP_fft_zrop(FFTSetup __Setup, const DSPSplitComplex* __A, vDSP_Stride __IA, const DSPSplitComplex* __C,
+                                     vDSP_Stride __IC, vDSP_Length __Log2N, FFTDirection __Direction);
+ACCELERATE_EXPORT void vDSP_fft_zropD(FFTSetupD __Setup, const DSPDoubleSplitComplex* __A, vDSP_Stride __IA,
+                                      const DSPDoubleSplitComplex* __C, vDSP_Stride __IC, vDSP_Length __Log2N, FFTDirection __Direction);
@@ -87,6 +87,17 @@ enum {
     kvImageNoAllocate = 512,
 };
 
+enum {
+    kRotate0DegreesClockwise = 0,
+    kRotate90DegreesClockwise = 3,
+    kRotate180DegreesClockwise = 2,
+    kRotate270DegreesClockwise = 1,
+    kRotate0DegreesCounterClockwise = 0,
+    kRotate90DegreesCounterClockwise = 1,
+    kRotate180DegreesCounterClockwise = 2,
+    kRotate270DegreesCounterClockwise = 3,
+};
+
 typedef unsigned long vImagePixelCount;
 
 typedef SSIZE_T vImage_Error;
@@ -106,6 +117,11 @@ typedef struct _vImage_Buffer {
 
 typedef struct Pixel_8888_s { Pixel_8888 val; } Pixel_8888_s;
 
+typedef struct vImage_AffineTransform {
+    float a, b, c, d;
+    float tx, ty;
+} vImage_AffineTransform;
+
 typedef struct _vImage_CGImageFormat {
     uint32_t bitsPerComponent;
     uint32_t bitsPerPixel;
@@ -130,6 +146,44 @@ ACCELERATE_EXPORT vImage_Error vImageBoxConvolve_ARGB8888(const vImage_Buffer* s
                                                           const Pixel_8888 backgroundColor,
                                                           vImage_Flags flags);
 
+ACCELERATE_EXPORT vImage_Error vImageTentConvolve_ARGB8888(const vImage_Buffer* src,
+                                                           const vImage_Buffer* dest,
+                                                           void* tempBuffer,
+                                                           vImagePixelCount srcOffsetToROI_X,
+                                                           vImagePixelCount srcOffsetToROI_Y,
+                                                           uint32_t kernel_height,
+                                                           uint32_t kernel_width,
+                                                           const Pixel_8888 backgroundColor,
+                                                           vImage_Flags flags);
+
+ACCELERATE_EXPORT vImage_Error vImageConvolve_ARGB8888(const vImage_Buffer* src,
+                                                       const vImage_Buffer* dest,
+                                                       void* tempBuffer,
+                                                       vImagePixelCount srcOffsetToROI_X,
+                                                       vImagePixelCount srcOffsetToROI_Y,
+                                                       const int16_t* kernel,
+                                                       uint32_t kernel_height,
+                                                       uint32_t kernel_width,
+                                                       int32_t divisor,
+                                                       const Pixel_8888 backgroundColor,
+                                                       vImage_Flags flags);
+
+ACCELERATE_EXPORT vImage_Error vImageScale_ARGB8888(const vImage_Buffer* src, const vImage_Buffer* dest, void* tempBuffer, vImage_Flags flags);
+
+ACCELERATE_EXPORT vImage_Error vImageRotate90_ARGB8888(
+    const vImage_Buffer* src, const vImage_Buffer* dest, uint8_t rotationConstant, const Pixel_8888 backColor, vImage_Flags flags);
+
+ACCELERATE_EXPORT vImage_Error vImageHorizontalReflect_ARGB8888(const vImage_Buffer* src, const vImage_Buffer* dest, vImage_Flags flags);
+
+ACCELERATE_EXPORT vImage_Error vImageVerticalReflect_ARGB8888(const vImage_Buffer* src, const vImage_Buffer* dest, vImage_Flags flags);
+
+ACCELERATE_EXPORT vImage_Error vImageAffineWarp_ARGB8888(const vImage_Buffer* src,
+                                                        const vImage_Buffer* dest,
+                                                        void* tempBuffer,
+                                                        const vImage_AffineTransform* transform,
+                                                        const Pixel_8888 backColor,
+                                                        vImage_Flags flags);
+
 ACCELERATE_EXPORT vImage_Error vImageMatrixMultiply_ARGB8888(const vImage_Buffer* src,
                                                              const vImage_Buffer* dest,
                                                              const int16_t matrix[16],
@@ -18,18 +18,30 @@
 
 #include <StarboardExport.h>
 #include <StubIncludes.h>
+#include <stddef.h>
+#include <stdint.h>
 
-struct CC_Digest_State;
-typedef struct CC_Digest_State* CC_MD2_CTX;
-typedef struct CC_Digest_State* CC_MD4_CTX;
-typedef struct CC_Digest_State* CC_MD5_CTX;
-typedef struct CC_Digest_State* CC_SHA1_CTX;
-typedef struct CC_Digest_State* CC_SHA224_CTX;
-typedef struct CC_Digest_State* CC_SHA256_CTX;
-typedef struct CC_Digest_State* CC_SHA384_CTX;
-typedef struct CC_Digest_State* CC_SHA512_CTX;
+typedef uint32_t CC_LONG;
+typedef uint64_t CC_LONG64;
 
-typedef unsigned long CC_LONG;
+// Running state of any of the digests below, held inline so that contexts can live on the stack.
+// The layout is private to CommonDigest.cpp.
+typedef struct CC_Digest_State {
+    CC_LONG64 state[8];
+    CC_LONG64 count[2];
+    unsigned char buffer[128];
+    CC_LONG bufferLength;
+    CC_LONG algorithm;
+} CC_Digest_State;
+
+typedef CC_Digest_State CC_MD2_CTX;
+typedef CC_Digest_State CC_MD4_CTX;
+typedef CC_Digest_State CC_MD5_CTX;
+typedef CC_Digest_State CC_SHA1_CTX;
+typedef CC_Digest_State CC_SHA224_CTX;
+typedef CC_Digest_State CC_SHA256_CTX;
+typedef CC_Digest_State CC_SHA384_CTX;
+typedef CC_Digest_State CC_SHA512_CTX;
 
 #define CC_MD2_DIGEST_LENGTH 16
 #define CC_MD4_DIGEST_LENGTH 16
@@ -40,6 +52,15 @@ typedef unsigned long CC_LONG;
 #define CC_SHA384_DIGEST_LENGTH 48
 #define CC_SHA512_DIGEST_LENGTH 64
 
+#define CC_MD2_BLOCK_BYTES 16
+#define CC_MD4_BLOCK_BYTES 64
+#define CC_MD5_BLOCK_BYTES 64
+#define CC_SHA1_BLOCK_BYTES 64
+#define CC_SHA224_BLOCK_BYTES 64
+#define CC_SHA256_BLOCK_BYTES 64
+#define CC_SHA384_BLOCK_BYTES 128
+#define CC_SHA512_BLOCK_BYTES 128
+
 SB_EXTERNC_BEGIN
 
 int CC_MD2_Init(CC_MD2_CTX* c);
@@ -62,10 +83,10 @@ int CC_SHA1_Update(CC_SHA1_CTX* ctx, const void* data, CC_LONG len);
 int CC_SHA1_Final(unsigned char* digest, CC_SHA1_CTX* ctx);
 unsigned char* CC_SHA1(const void* data, CC_LONG len, unsigned char* md);
 
-int CC_SHA224_Init(CC_SHA224_CTX* ctx) STUB_METHOD;
-int CC_SHA224_Update(CC_SHA224_CTX* ctx, const void* data, CC_LONG len) STUB_METHOD;
-int CC_SHA224_Final(unsigned char* digest, CC_SHA224_CTX* ctx) STUB_METHOD;
-unsigned char* CC_SHA224(const void* data, CC_LONG len, unsigned char* md) STUB_METHOD;
+int CC_SHA224_Init(CC_SHA224_CTX* ctx);
+int CC_SHA224_Update(CC_SHA224_CTX* ctx, const void* data, CC_LONG len);
+int CC_SHA224_Final(unsigned char* digest, CC_SHA224_CTX* ctx);
+unsigned char* CC_SHA224(const void* data, CC_LONG len, unsigned char* md);
 
 int CC_SHA256_Init(CC_SHA256_CTX* ctx);
 int CC_SHA256_Update(CC_SHA256_CTX* ctx, const void* data, CC_LONG len);
@@ -82,4 +103,10 @@ int CC_SHA512_Update(CC_SHA512_CTX* ctx, const void* data, CC_LONG len);
 int CC_SHA512_Final(unsigned char* digest, CC_SHA512_CTX* ctx);
 unsigned char* CC_SHA512(const void* data, CC_LONG len, unsigned char* md);
 
+// Not in the reference platform: digest count independent messages in one call, writing count consecutive digests to md.
+// Batches of short messages are hashed several at a time in SIMD lanes where the processor allows.
+void CC_MD5_Multi(const void* const* data, const CC_LONG* len, size_t count, unsigned char* md);
+void CC_SHA1_Multi(const void* const* data, const CC_LONG* len, size_t count, unsigned char* md);
+void CC_SHA256_Multi(const void* const* data, const CC_LONG* len, size_t count, unsigned char* md);
+
 SB_EXTERNC_END
\ No newline at end of file
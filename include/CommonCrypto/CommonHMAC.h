@@ -16,6 +16,8 @@
 #pragma once
 
 #include <StarboardExport.h>
+#include <CommonCrypto/CommonDigest.h>
+#include <stddef.h>
 #include <stdint.h>
 
 enum {
@@ -27,10 +29,19 @@ enum {
     kCCHmacAlgSHA224
 };
 
-struct CC_Hmac_State;
-typedef struct CC_Hmac_State* CCHmacContext;
 typedef int32_t CCHmacAlgorithm;
 
+// Running state of an HMAC, held inline so that contexts can live on the stack.
+// The layout is private to CommonHMAC.cpp.
+typedef struct CC_Hmac_State {
+    CC_Digest_State inner;
+    unsigned char outerKey[CC_SHA512_BLOCK_BYTES];
+    CCHmacAlgorithm algorithm;
+    int32_t isValid;
+} CC_Hmac_State;
+
+typedef CC_Hmac_State CCHmacContext;
+
 SB_EXTERNC_BEGIN
 
 void CCHmacInit(CCHmacContext* ctx, CCHmacAlgorithm algorithm, const void* key, size_t keyLength);
@@ -38,4 +49,4 @@ void CCHmacUpdate(CCHmacContext* ctx, const void* data, size_t dataLength);
 void CCHmacFinal(CCHmacContext* ctx, void* macOut);
 void CCHmac(CCHmacAlgorithm algorithm, const void* key, size_t keyLength, const void* data, size_t dataLength, void* macOut);
 
-SB_EXTERNC_END
\ No newline at end of file
+SB_EXTERNC_END
@@ -21,14 +21,14 @@
 #import <CoreGraphics/CGPDFString.h>
 #import <CoreGraphics/CGPDFStream.h>
 
-COREGRAPHICS_EXPORT bool CGPDFArrayGetArray(CGPDFArrayRef array, size_t index, CGPDFArrayRef _Nullable* value) STUB_METHOD;
-COREGRAPHICS_EXPORT bool CGPDFArrayGetBoolean(CGPDFArrayRef array, size_t index, CGPDFBoolean* value) STUB_METHOD;
-COREGRAPHICS_EXPORT size_t CGPDFArrayGetCount(CGPDFArrayRef array) STUB_METHOD;
-COREGRAPHICS_EXPORT bool CGPDFArrayGetDictionary(CGPDFArrayRef array, size_t index, CGPDFDictionaryRef _Nullable* value) STUB_METHOD;
-COREGRAPHICS_EXPORT bool CGPDFArrayGetInteger(CGPDFArrayRef array, size_t index, CGPDFInteger* value) STUB_METHOD;
-COREGRAPHICS_EXPORT bool CGPDFArrayGetName(CGPDFArrayRef array, size_t index, const char* _Nullable* value) STUB_METHOD;
-COREGRAPHICS_EXPORT bool CGPDFArrayGetNull(CGPDFArrayRef array, size_t index) STUB_METHOD;
-COREGRAPHICS_EXPORT bool CGPDFArrayGetNumber(CGPDFArrayRef array, size_t index, CGPDFReal* value) STUB_METHOD;
-COREGRAPHICS_EXPORT bool CGPDFArrayGetObject(CGPDFArrayRef array, size_t index, CGPDFObjectRef _Nullable* value) STUB_METHOD;
-COREGRAPHICS_EXPORT bool CGPDFArrayGetString(CGPDFArrayRef array, size_t index, CGPDFStringRef _Nullable* value) STUB_METHOD;
-COREGRAPHICS_EXPORT bool CGPDFArrayGetStream(CGPDFArrayRef array, size_t index, CGPDFStreamRef _Nullable* value) STUB_METHOD;
\ No newline at end of file
+COREGRAPHICS_EXPORT bool CGPDFArrayGetArray(CGPDFArrayRef array, size_t index, CGPDFArrayRef _Nullable* value);
+COREGRAPHICS_EXPORT bool CGPDFArrayGetBoolean(CGPDFArrayRef array, size_t index, CGPDFBoolean* value);
+COREGRAPHICS_EXPORT size_t CGPDFArrayGetCount(CGPDFArrayRef array);
+COREGRAPHICS_EXPORT bool CGPDFArrayGetDictionary(CGPDFArrayRef array, size_t index, CGPDFDictionaryRef _Nullable* value);
+COREGRAPHICS_EXPORT bool CGPDFArrayGetInteger(CGPDFArrayRef array, size_t index, CGPDFInteger* value);
+COREGRAPHICS_EXPORT bool CGPDFArrayGetName(CGPDFArrayRef array, size_t index, const char* _Nullable* value);
+COREGRAPHICS_EXPORT bool CGPDFArrayGetNull(CGPDFArrayRef array, size_t index);
+COREGRAPHICS_EXPORT bool CGPDFArrayGetNumber(CGPDFArrayRef array, size_t index, CGPDFReal* value);
+COREGRAPHICS_EXPORT bool CGPDFArrayGetObject(CGPDFArrayRef array, size_t index, CGPDFObjectRef _Nullable* value);
+COREGRAPHICS_EXPORT bool CGPDFArrayGetString(CGPDFArrayRef array, size_t index, CGPDFStringRef _Nullable* value);
+COREGRAPHICS_EXPORT bool CGPDFArrayGetStream(CGPDFArrayRef array, size_t index, CGPDFStreamRef _Nullable* value);
\ No newline at end of file
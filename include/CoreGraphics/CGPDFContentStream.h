@@ -21,13 +21,13 @@
 #import <CoreGraphics/CGPDFPage.h>
 #import <CoreGraphics/CGPDFDictionary.h>
 
-COREGRAPHICS_EXPORT CGPDFContentStreamRef CGPDFContentStreamCreateWithPage(CGPDFPageRef page) STUB_METHOD;
+COREGRAPHICS_EXPORT CGPDFContentStreamRef CGPDFContentStreamCreateWithPage(CGPDFPageRef page);
 COREGRAPHICS_EXPORT CGPDFContentStreamRef CGPDFContentStreamCreateWithStream(CGPDFStreamRef stream,
                                                                              CGPDFDictionaryRef streamResources,
-                                                                             CGPDFContentStreamRef parent) STUB_METHOD;
-COREGRAPHICS_EXPORT CFArrayRef CGPDFContentStreamGetStreams(CGPDFContentStreamRef cs) STUB_METHOD;
+                                                                             CGPDFContentStreamRef parent);
+COREGRAPHICS_EXPORT CFArrayRef CGPDFContentStreamGetStreams(CGPDFContentStreamRef cs);
 COREGRAPHICS_EXPORT CGPDFObjectRef CGPDFContentStreamGetResource(CGPDFContentStreamRef cs,
                                                                  const char* category,
-                                                                 const char* name) STUB_METHOD;
-COREGRAPHICS_EXPORT CGPDFContentStreamRef CGPDFContentStreamRetain(CGPDFContentStreamRef cs) STUB_METHOD;
-COREGRAPHICS_EXPORT void CGPDFContentStreamRelease(CGPDFContentStreamRef cs) STUB_METHOD;
+                                                                 const char* name);
+COREGRAPHICS_EXPORT CGPDFContentStreamRef CGPDFContentStreamRetain(CGPDFContentStreamRef cs);
+COREGRAPHICS_EXPORT void CGPDFContentStreamRelease(CGPDFContentStreamRef cs);
@@ -25,16 +25,16 @@ typedef void (*CGPDFDictionaryApplierFunction)(const char* key, CGPDFObjectRef v
 
 COREGRAPHICS_EXPORT void CGPDFDictionaryApplyFunction(CGPDFDictionaryRef dict,
                                                       CGPDFDictionaryApplierFunction function,
-                                                      void* info) STUB_METHOD;
-COREGRAPHICS_EXPORT bool CGPDFDictionaryGetArray(CGPDFDictionaryRef dict, const char* key, CGPDFArrayRef _Nullable* value) STUB_METHOD;
-COREGRAPHICS_EXPORT bool CGPDFDictionaryGetBoolean(CGPDFDictionaryRef dict, const char* key, CGPDFBoolean* value) STUB_METHOD;
-COREGRAPHICS_EXPORT size_t CGPDFDictionaryGetCount(CGPDFDictionaryRef dict) STUB_METHOD;
+                                                      void* info);
+COREGRAPHICS_EXPORT bool CGPDFDictionaryGetArray(CGPDFDictionaryRef dict, const char* key, CGPDFArrayRef _Nullable* value);
+COREGRAPHICS_EXPORT bool CGPDFDictionaryGetBoolean(CGPDFDictionaryRef dict, const char* key, CGPDFBoolean* value);
+COREGRAPHICS_EXPORT size_t CGPDFDictionaryGetCount(CGPDFDictionaryRef dict);
 COREGRAPHICS_EXPORT bool CGPDFDictionaryGetDictionary(CGPDFDictionaryRef dict,
                                                       const char* key,
-                                                      CGPDFDictionaryRef _Nullable* value) STUB_METHOD;
-COREGRAPHICS_EXPORT bool CGPDFDictionaryGetInteger(CGPDFDictionaryRef dict, const char* key, CGPDFInteger* value) STUB_METHOD;
-COREGRAPHICS_EXPORT bool CGPDFDictionaryGetName(CGPDFDictionaryRef dict, const char* key, const char* _Nullable* value) STUB_METHOD;
-COREGRAPHICS_EXPORT bool CGPDFDictionaryGetNumber(CGPDFDictionaryRef dict, const char* key, CGPDFReal* value) STUB_METHOD;
-COREGRAPHICS_EXPORT bool CGPDFDictionaryGetObject(CGPDFDictionaryRef dict, const char* key, CGPDFObjectRef _Nullable* value) STUB_METHOD;
-COREGRAPHICS_EXPORT bool CGPDFDictionaryGetStream(CGPDFDictionaryRef dict, const char* key, CGPDFStreamRef _Nullable* value) STUB_METHOD;
-COREGRAPHICS_EXPORT bool CGPDFDictionaryGetString(CGPDFDictionaryRef dict, const char* key, CGPDFStringRef _Nullable* value) STUB_METHOD;
+                                                      CGPDFDictionaryRef _Nullable* value);
+COREGRAPHICS_EXPORT bool CGPDFDictionaryGetInteger(CGPDFDictionaryRef dict, const char* key, CGPDFInteger* value);
+COREGRAPHICS_EXPORT bool CGPDFDictionaryGetName(CGPDFDictionaryRef dict, const char* key, const char* _Nullable* value);
+COREGRAPHICS_EXPORT bool CGPDFDictionaryGetNumber(CGPDFDictionaryRef dict, const char* key, CGPDFReal* value);
+COREGRAPHICS_EXPORT bool CGPDFDictionaryGetObject(CGPDFDictionaryRef dict, const char* key, CGPDFObjectRef _Nullable* value);
+COREGRAPHICS_EXPORT bool CGPDFDictionaryGetStream(CGPDFDictionaryRef dict, const char* key, CGPDFStreamRef _Nullable* value);
+COREGRAPHICS_EXPORT bool CGPDFDictionaryGetString(CGPDFDictionaryRef dict, const char* key, CGPDFStringRef _Nullable* value);
@@ -22,19 +22,19 @@
 #import <CoreFoundation/CFURL.h>
 #import <CoreGraphics/CGPDFPage.h>
 
-COREGRAPHICS_EXPORT CGPDFDocumentRef CGPDFDocumentCreateWithProvider(CGDataProviderRef provider) STUB_METHOD;
-COREGRAPHICS_EXPORT CGPDFDocumentRef CGPDFDocumentCreateWithURL(CFURLRef url) STUB_METHOD;
-COREGRAPHICS_EXPORT void CGPDFDocumentRelease(CGPDFDocumentRef document) STUB_METHOD;
-COREGRAPHICS_EXPORT CGPDFDocumentRef CGPDFDocumentRetain(CGPDFDocumentRef document) STUB_METHOD;
+COREGRAPHICS_EXPORT CGPDFDocumentRef CGPDFDocumentCreateWithProvider(CGDataProviderRef provider);
+COREGRAPHICS_EXPORT CGPDFDocumentRef CGPDFDocumentCreateWithURL(CFURLRef url);
+COREGRAPHICS_EXPORT void CGPDFDocumentRelease(CGPDFDocumentRef document);
+COREGRAPHICS_EXPORT CGPDFDocumentRef CGPDFDocumentRetain(CGPDFDocumentRef document);
 COREGRAPHICS_EXPORT CFTypeID CGPDFDocumentGetTypeID() STUB_METHOD;
-COREGRAPHICS_EXPORT CGPDFDictionaryRef CGPDFDocumentGetCatalog(CGPDFDocumentRef document) STUB_METHOD;
-COREGRAPHICS_EXPORT size_t CGPDFDocumentGetNumberOfPages(CGPDFDocumentRef document) STUB_METHOD;
-COREGRAPHICS_EXPORT CGPDFPageRef CGPDFDocumentGetPage(CGPDFDocumentRef document, size_t pageNumber) STUB_METHOD;
-COREGRAPHICS_EXPORT void CGPDFDocumentGetVersion(CGPDFDocumentRef document, int* majorVersion, int* minorVersion) STUB_METHOD;
-COREGRAPHICS_EXPORT CGPDFDictionaryRef CGPDFDocumentGetInfo(CGPDFDocumentRef document) STUB_METHOD;
-COREGRAPHICS_EXPORT CGPDFArrayRef CGPDFDocumentGetID(CGPDFDocumentRef document) STUB_METHOD;
-COREGRAPHICS_EXPORT bool CGPDFDocumentAllowsCopying(CGPDFDocumentRef document) STUB_METHOD;
-COREGRAPHICS_EXPORT bool CGPDFDocumentAllowsPrinting(CGPDFDocumentRef document) STUB_METHOD;
-COREGRAPHICS_EXPORT bool CGPDFDocumentIsEncrypted(CGPDFDocumentRef document) STUB_METHOD;
-COREGRAPHICS_EXPORT bool CGPDFDocumentIsUnlocked(CGPDFDocumentRef document) STUB_METHOD;
-COREGRAPHICS_EXPORT bool CGPDFDocumentUnlockWithPassword(CGPDFDocumentRef document, const char* password) STUB_METHOD;
\ No newline at end of file
+COREGRAPHICS_EXPORT CGPDFDictionaryRef CGPDFDocumentGetCatalog(CGPDFDocumentRef document);
+COREGRAPHICS_EXPORT size_t CGPDFDocumentGetNumberOfPages(CGPDFDocumentRef document);
+COREGRAPHICS_EXPORT CGPDFPageRef CGPDFDocumentGetPage(CGPDFDocumentRef document, size_t pageNumber);
+COREGRAPHICS_EXPORT void CGPDFDocumentGetVersion(CGPDFDocumentRef document, int* majorVersion, int* minorVersion);
+COREGRAPHICS_EXPORT CGPDFDictionaryRef CGPDFDocumentGetInfo(CGPDFDocumentRef document);
+COREGRAPHICS_EXPORT CGPDFArrayRef CGPDFDocumentGetID(CGPDFDocumentRef document);
+COREGRAPHICS_EXPORT bool CGPDFDocumentAllowsCopying(CGPDFDocumentRef document);
+COREGRAPHICS_EXPORT bool CGPDFDocumentAllowsPrinting(CGPDFDocumentRef document);
+COREGRAPHICS_EXPORT bool CGPDFDocumentIsEncrypted(CGPDFDocumentRef document);
+COREGRAPHICS_EXPORT bool CGPDFDocumentIsUnlocked(CGPDFDocumentRef document);
+COREGRAPHICS_EXPORT bool CGPDFDocumentUnlockWithPassword(CGPDFDocumentRef document, const char* password);
\ No newline at end of file
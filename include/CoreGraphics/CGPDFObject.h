@@ -33,5 +33,5 @@ typedef unsigned char CGPDFBoolean;
 typedef long int CGPDFInteger;
 typedef CGFloat CGPDFReal;
 
-COREGRAPHICS_EXPORT CGPDFObjectType CGPDFObjectGetType(CGPDFObjectRef object) STUB_METHOD;
-COREGRAPHICS_EXPORT bool CGPDFObjectGetValue(CGPDFObjectRef object, CGPDFObjectType type, void* value) STUB_METHOD;
+COREGRAPHICS_EXPORT CGPDFObjectType CGPDFObjectGetType(CGPDFObjectRef object);
+COREGRAPHICS_EXPORT bool CGPDFObjectGetValue(CGPDFObjectRef object, CGPDFObjectType type, void* value);
@@ -20,9 +20,9 @@
 
 typedef void (*CGPDFOperatorCallback)(CGPDFScannerRef scanner, void* info);
 
-COREGRAPHICS_EXPORT CGPDFOperatorTableRef CGPDFOperatorTableCreate() STUB_METHOD;
+COREGRAPHICS_EXPORT CGPDFOperatorTableRef CGPDFOperatorTableCreate();
 COREGRAPHICS_EXPORT void CGPDFOperatorTableSetCallback(CGPDFOperatorTableRef table,
                                                        const char* name,
-                                                       CGPDFOperatorCallback callback) STUB_METHOD;
-COREGRAPHICS_EXPORT CGPDFOperatorTableRef CGPDFOperatorTableRetain(CGPDFOperatorTableRef table) STUB_METHOD;
-COREGRAPHICS_EXPORT void CGPDFOperatorTableRelease(CGPDFOperatorTableRef table) STUB_METHOD;
+                                                       CGPDFOperatorCallback callback);
+COREGRAPHICS_EXPORT CGPDFOperatorTableRef CGPDFOperatorTableRetain(CGPDFOperatorTableRef table);
+COREGRAPHICS_EXPORT void CGPDFOperatorTableRelease(CGPDFOperatorTableRef table);
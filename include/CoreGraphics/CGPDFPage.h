@@ -28,13 +28,13 @@ typedef enum {
     kCGPDFArtBox = 4,
 } CGPDFBox;
 
-COREGRAPHICS_EXPORT CGPDFPageRef CGPDFPageRetain(CGPDFPageRef page) STUB_METHOD;
-COREGRAPHICS_EXPORT void CGPDFPageRelease(CGPDFPageRef page) STUB_METHOD;
+COREGRAPHICS_EXPORT CGPDFPageRef CGPDFPageRetain(CGPDFPageRef page);
+COREGRAPHICS_EXPORT void CGPDFPageRelease(CGPDFPageRef page);
 COREGRAPHICS_EXPORT CFTypeID CGPDFPageGetTypeID() STUB_METHOD;
-COREGRAPHICS_EXPORT CGRect CGPDFPageGetBoxRect(CGPDFPageRef page, CGPDFBox box) STUB_METHOD;
-COREGRAPHICS_EXPORT CGPDFDictionaryRef CGPDFPageGetDictionary(CGPDFPageRef page) STUB_METHOD;
-COREGRAPHICS_EXPORT CGPDFDocumentRef CGPDFPageGetDocument(CGPDFPageRef page) STUB_METHOD;
+COREGRAPHICS_EXPORT CGRect CGPDFPageGetBoxRect(CGPDFPageRef page, CGPDFBox box);
+COREGRAPHICS_EXPORT CGPDFDictionaryRef CGPDFPageGetDictionary(CGPDFPageRef page);
+COREGRAPHICS_EXPORT CGPDFDocumentRef CGPDFPageGetDocument(CGPDFPageRef page);
 COREGRAPHICS_EXPORT CGAffineTransform
-CGPDFPageGetDrawingTransform(CGPDFPageRef page, CGPDFBox box, CGRect rect, int rotate, bool preserveAspectRatio) STUB_METHOD;
-COREGRAPHICS_EXPORT size_t CGPDFPageGetPageNumber(CGPDFPageRef page) STUB_METHOD;
-COREGRAPHICS_EXPORT int CGPDFPageGetRotationAngle(CGPDFPageRef page) STUB_METHOD;
\ No newline at end of file
+CGPDFPageGetDrawingTransform(CGPDFPageRef page, CGPDFBox box, CGRect rect, int rotate, bool preserveAspectRatio);
+COREGRAPHICS_EXPORT size_t CGPDFPageGetPageNumber(CGPDFPageRef page);
+COREGRAPHICS_EXPORT int CGPDFPageGetRotationAngle(CGPDFPageRef page);
\ No newline at end of file
@@ -21,17 +21,17 @@
 #import <CoreGraphics/CGPDFObject.h>
 #import <CoreGraphics/CGPDFOperatorTable.h>
 
-COREGRAPHICS_EXPORT CGPDFScannerRef CGPDFScannerCreate(CGPDFContentStreamRef cs, CGPDFOperatorTableRef table, void* info) STUB_METHOD;
-COREGRAPHICS_EXPORT CGPDFScannerRef CGPDFScannerRetain(CGPDFScannerRef scanner) STUB_METHOD;
-COREGRAPHICS_EXPORT void CGPDFScannerRelease(CGPDFScannerRef scanner) STUB_METHOD;
-COREGRAPHICS_EXPORT bool CGPDFScannerScan(CGPDFScannerRef scanner) STUB_METHOD;
-COREGRAPHICS_EXPORT CGPDFContentStreamRef CGPDFScannerGetContentStream(CGPDFScannerRef scanner) STUB_METHOD;
-COREGRAPHICS_EXPORT bool CGPDFScannerPopObject(CGPDFScannerRef scanner, CGPDFObjectRef _Nullable* value) STUB_METHOD;
-COREGRAPHICS_EXPORT bool CGPDFScannerPopBoolean(CGPDFScannerRef scanner, CGPDFBoolean* value) STUB_METHOD;
-COREGRAPHICS_EXPORT bool CGPDFScannerPopInteger(CGPDFScannerRef scanner, CGPDFInteger* value) STUB_METHOD;
-COREGRAPHICS_EXPORT bool CGPDFScannerPopNumber(CGPDFScannerRef scanner, CGPDFReal* value) STUB_METHOD;
-COREGRAPHICS_EXPORT bool CGPDFScannerPopName(CGPDFScannerRef scanner, const char* _Nullable* value) STUB_METHOD;
-COREGRAPHICS_EXPORT bool CGPDFScannerPopString(CGPDFScannerRef scanner, CGPDFStringRef _Nullable* value) STUB_METHOD;
-COREGRAPHICS_EXPORT bool CGPDFScannerPopArray(CGPDFScannerRef scanner, CGPDFArrayRef _Nullable* value) STUB_METHOD;
-COREGRAPHICS_EXPORT bool CGPDFScannerPopDictionary(CGPDFScannerRef scanner, CGPDFDictionaryRef _Nullable* value) STUB_METHOD;
-COREGRAPHICS_EXPORT bool CGPDFScannerPopStream(CGPDFScannerRef scanner, CGPDFStreamRef _Nullable* value) STUB_METHOD;
+COREGRAPHICS_EXPORT CGPDFScannerRef CGPDFScannerCreate(CGPDFContentStreamRef cs, CGPDFOperatorTableRef table, void* info);
+COREGRAPHICS_EXPORT CGPDFScannerRef CGPDFScannerRetain(CGPDFScannerRef scanner);
+COREGRAPHICS_EXPORT void CGPDFScannerRelease(CGPDFScannerRef scanner);
+COREGRAPHICS_EXPORT bool CGPDFScannerScan(CGPDFScannerRef scanner);
+COREGRAPHICS_EXPORT CGPDFContentStreamRef CGPDFScannerGetContentStream(CGPDFScannerRef scanner);
+COREGRAPHICS_EXPORT bool CGPDFScannerPopObject(CGPDFScannerRef scanner, CGPDFObjectRef _Nullable* value);
+COREGRAPHICS_EXPORT bool CGPDFScannerPopBoolean(CGPDFScannerRef scanner, CGPDFBoolean* value);
+COREGRAPHICS_EXPORT bool CGPDFScannerPopInteger(CGPDFScannerRef scanner, CGPDFInteger* value);
+COREGRAPHICS_EXPORT bool CGPDFScannerPopNumber(CGPDFScannerRef scanner, CGPDFReal* value);
+COREGRAPHICS_EXPORT bool CGPDFScannerPopName(CGPDFScannerRef scanner, const char* _Nullable* value);
+COREGRAPHICS_EXPORT bool CGPDFScannerPopString(CGPDFScannerRef scanner, CGPDFStringRef _Nullable* value);
+COREGRAPHICS_EXPORT bool CGPDFScannerPopArray(CGPDFScannerRef scanner, CGPDFArrayRef _Nullable* value);
+COREGRAPHICS_EXPORT bool CGPDFScannerPopDictionary(CGPDFScannerRef scanner, CGPDFDictionaryRef _Nullable* value);
+COREGRAPHICS_EXPORT bool CGPDFScannerPopStream(CGPDFScannerRef scanner, CGPDFStreamRef _Nullable* value);
@@ -21,5 +21,5 @@
 
 typedef enum { CGPDFDataFormatRaw, CGPDFDataFormatJPEGEncoded, CGPDFDataFormatJPEG2000 } CGPDFDataFormat;
 
-COREGRAPHICS_EXPORT CFDataRef CGPDFStreamCopyData(CGPDFStreamRef stream, CGPDFDataFormat* format) STUB_METHOD;
-COREGRAPHICS_EXPORT CGPDFDictionaryRef CGPDFStreamGetDictionary(CGPDFStreamRef stream) STUB_METHOD;
+COREGRAPHICS_EXPORT CFDataRef CGPDFStreamCopyData(CGPDFStreamRef stream, CGPDFDataFormat* format);
+COREGRAPHICS_EXPORT CGPDFDictionaryRef CGPDFStreamGetDictionary(CGPDFStreamRef stream);
@@ -18,7 +18,7 @@
 #import <CoreGraphics/CoreGraphicsExport.h>
 #import <CoreFoundation/CFDate.h>
 
-COREGRAPHICS_EXPORT CFStringRef CGPDFStringCopyTextString(CGPDFStringRef string) STUB_METHOD;
-COREGRAPHICS_EXPORT CFDateRef CGPDFStringCopyDate(CGPDFStringRef string) STUB_METHOD;
-COREGRAPHICS_EXPORT const unsigned char* CGPDFStringGetBytePtr(CGPDFStringRef string) STUB_METHOD;
-COREGRAPHICS_EXPORT size_t CGPDFStringGetLength(CGPDFStringRef string) STUB_METHOD;
+COREGRAPHICS_EXPORT CFStringRef CGPDFStringCopyTextString(CGPDFStringRef string);
+COREGRAPHICS_EXPORT CFDateRef CGPDFStringCopyDate(CGPDFStringRef string);
+COREGRAPHICS_EXPORT const unsigned char* CGPDFStringGetBytePtr(CGPDFStringRef string);
+COREGRAPHICS_EXPORT size_t CGPDFStringGetLength(CGPDFStringRef string);
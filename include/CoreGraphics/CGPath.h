@@ -59,21 +59,20 @@ COREGRAPHICS_EXPORT CGPathRef CGPathCreateWithRoundedRect(CGRect rect,
 
 COREGRAPHICS_EXPORT CGPathRef CGPathCreateCopy(CGPathRef path);
 
-COREGRAPHICS_EXPORT CGPathRef CGPathCreateCopyByTransformingPath(CGPathRef path, const CGAffineTransform* transform) STUB_METHOD;
+COREGRAPHICS_EXPORT CGPathRef CGPathCreateCopyByTransformingPath(CGPathRef path, const CGAffineTransform* transform);
 
 COREGRAPHICS_EXPORT CGPathRef CGPathCreateCopyByDashingPath(
-    CGPathRef path, const CGAffineTransform* transform, CGFloat phase, const CGFloat* lengths, size_t count) STUB_METHOD;
+    CGPathRef path, const CGAffineTransform* transform, CGFloat phase, const CGFloat* lengths, size_t count);
 COREGRAPHICS_EXPORT CGPathRef CGPathCreateCopyByStrokingPath(CGPathRef path,
                                                              const CGAffineTransform* transform,
                                                              CGFloat lineWidth,
                                                              CGLineCap lineCap,
                                                              CGLineJoin lineJoin,
-                                                             CGFloat miterLimit) STUB_METHOD;
+                                                             CGFloat miterLimit);
 
 COREGRAPHICS_EXPORT CGMutablePathRef CGPathCreateMutableCopy(CGPathRef path);
 
-COREGRAPHICS_EXPORT CGMutablePathRef CGPathCreateMutableCopyByTransformingPath(CGPathRef path,
-                                                                               const CGAffineTransform* transform) STUB_METHOD;
+COREGRAPHICS_EXPORT CGMutablePathRef CGPathCreateMutableCopyByTransformingPath(CGPathRef path, const CGAffineTransform* transform);
 
 COREGRAPHICS_EXPORT void CGPathRelease(CGPathRef path);
 COREGRAPHICS_EXPORT CGPathRef CGPathRetain(CGPathRef path);
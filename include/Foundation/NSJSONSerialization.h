@@ -31,11 +31,11 @@ enum { NSJSONWritingPrettyPrinted = (1UL << 0) };
 FOUNDATION_EXPORT_CLASS
 @interface NSJSONSerialization : NSObject
 + (id)JSONObjectWithData:(NSData*)data options:(NSJSONReadingOptions)opt error:(NSError* _Nullable*)error;
-+ (id)JSONObjectWithStream:(NSInputStream*)stream options:(NSJSONReadingOptions)opt error:(NSError* _Nullable*)error STUB_METHOD;
++ (id)JSONObjectWithStream:(NSInputStream*)stream options:(NSJSONReadingOptions)opt error:(NSError* _Nullable*)error;
 + (NSData*)dataWithJSONObject:(id)obj options:(NSJSONWritingOptions)opt error:(NSError* _Nullable*)error;
 + (NSInteger)writeJSONObject:(id)obj
                     toStream:(NSOutputStream*)stream
                      options:(NSJSONWritingOptions)opt
-                       error:(NSError* _Nullable*)error STUB_METHOD;
+                       error:(NSError* _Nullable*)error;
 + (BOOL)isValidJSONObject:(id)obj;
 @end
@@ -27,6 +27,18 @@
 #endif
 #endif
 
+#include <stddef.h>
+#include <stdint.h>
+
+#ifndef __cplusplus
+#include <stdbool.h>
+#endif
+
+//
+// Trace levels, from most to least severe. These are the WINEVENT_LEVEL values messages are logged to ETW with.
+//
+enum TraceLevel { TraceLevelCritical = 1, TraceLevelError = 2, TraceLevelWarning = 3, TraceLevelInfo = 4, TraceLevelVerbose = 5 };
+
 //
 // Trace a verbose message.
 // Verbose messages log the behavior of "normal" or succesful operations.
@@ -86,3 +98,98 @@ LOGGING_EXPORT void TraceRegister();
 // Ensures the trace logging provider is unregistered.
 //
 LOGGING_EXPORT void TraceUnregister();
+
+//
+// Sets the least severe level that is traced; messages below it are dropped before any formatting.
+// All levels are traced by default.
+//
+// level - one of the TraceLevel values.
+//
+LOGGING_EXPORT void TraceSetLevel(int level);
+
+//
+// Enables or disables tracing for a tag. Messages for a disabled tag are dropped before any formatting.
+//
+// tag - the tag, compared by value.
+// enabled - whether messages with this tag are traced.
+//
+LOGGING_EXPORT void TraceSetTagEnabled(const wchar_t* tag, bool enabled);
+
+//
+// Returns whether a message of the given level and tag would be traced.
+//
+LOGGING_EXPORT bool TraceIsEnabled(int level, const wchar_t* tag);
+
+//
+// Receives the binary trace recording as it is produced.
+//
+// data, length - the next bytes of the recording.
+// context - the context passed to TraceStartRecording.
+//
+typedef void (*TraceRecordingWriter)(const void* data, size_t length, void* context);
+
+//
+// Switches tracing to binary recording. Rather than being formatted, each message is written to a lock-free buffer
+// of the calling thread as the id of its format string and its raw arguments, to be rendered by TraceDecodeRecording.
+// Recording continues until TraceStopRecording is called.
+//
+// bytesPerThread - the size of each thread's buffer. Messages that don't fit are dropped and counted until it is flushed.
+// writer - receives the recording: its header now, then the contents of the thread buffers on each TraceFlushRecording.
+// context - passed to writer.
+//
+LOGGING_EXPORT void TraceStartRecording(size_t bytesPerThread, TraceRecordingWriter writer, void* context);
+
+//
+// Starts binary recording to a file, which is flushed periodically on a background thread and closed by TraceStopRecording.
+//
+// path - the file to write.
+// bytesPerThread - the size of each thread's buffer.
+//
+// Returns false if the file could not be created.
+//
+LOGGING_EXPORT bool TraceStartFileRecording(const char* path, size_t bytesPerThread);
+
+//
+// Writes out everything recorded so far by every thread.
+//
+LOGGING_EXPORT void TraceFlushRecording();
+
+//
+// Stops binary recording, flushing what was recorded, and returns to formatting messages as they are traced.
+//
+LOGGING_EXPORT void TraceStopRecording();
+
+//
+// A message decoded from a binary trace recording.
+//
+struct TraceDecodedRecord {
+    // Nanoseconds on a monotonic clock
+    uint64_t timestamp;
+
+    // Identifies the recording thread; threads are numbered from 1 in the order they first traced
+    uint32_t threadId;
+
+    // A TraceLevel value
+    int level;
+
+    // The tag and formatted message, in UTF-8
+    const char* tag;
+    const char* message;
+};
+
+//
+// Receives the messages decoded from a recording, in timestamp order.
+//
+typedef void (*TraceDecodedRecordCallback)(const struct TraceDecodedRecord* record, void* context);
+
+//
+// Renders a binary trace recording, which may have been made on another machine.
+// Messages dropped because a thread's buffer filled up are reported as a warning with the tag "TraceRecorder".
+//
+// data, length - the recording.
+// callback - called for each message.
+// context - passed to callback.
+//
+// Returns the number of messages decoded, or -1 if the recording is malformed.
+//
+LOGGING_EXPORT int64_t TraceDecodeRecording(const void* data, size_t length, TraceDecodedRecordCallback callback, void* context);
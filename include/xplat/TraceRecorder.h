@@ -0,0 +1,27 @@
+//******************************************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+//
+// This code is licensed under the MIT License (MIT).
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+//******************************************************************************
+#pragma once
+
+#include "LoggingNative.h"
+
+#include <stdarg.h>
+
+// The binary trace recorder behind TraceStartRecording. Portable, so that the same recorder serves the trace functions
+// of the Logging library and of the test shims used off Windows.
+
+// Records a message if binary recording is on, returning false if it isn't and the message should be formatted as usual.
+// The caller checks TraceIsEnabled first.
+bool _traceRecord(int level, const wchar_t* tag, const wchar_t* format, va_list args);
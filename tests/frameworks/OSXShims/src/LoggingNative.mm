@@ -15,10 +15,12 @@
 //******************************************************************************
 
 #import <LoggingNative.h>
+#import <TraceRecorder.h>
 #import <Starboard/SmartTypes.h>
 #import <Foundation/NSString.h>
 
 #import <cstdarg>
+#import <cstdlib>
 
 // NOTE: this function is assumed to only run in Little Endian environments like OSX
 static NSStringEncoding _getWcharEncoding() {
@@ -38,6 +40,18 @@ static NSStringEncoding getWcharEncoding() {
 }
 
 void TraceVerbose(const wchar_t* tag, const wchar_t* format, ...) {
+    if (!TraceIsEnabled(TraceLevelVerbose, tag)) {
+        return;
+    }
+
+    va_list recordArgs;
+    va_start(recordArgs, format);
+    const bool recorded = _traceRecord(TraceLevelVerbose, tag, format, recordArgs);
+    va_end(recordArgs);
+    if (recorded) {
+        return;
+    }
+
     StrongId<NSString> nsTag;
     nsTag.attach([[NSString alloc] initWithBytes:tag length:sizeof(wchar_t) * wcslen(tag) encoding:getWcharEncoding()]);
 
@@ -52,6 +66,18 @@ void TraceVerbose(const wchar_t* tag, const wchar_t* format, ...) {
 }
 
 void TraceInfo(const wchar_t* tag, const wchar_t* format, ...) {
+    if (!TraceIsEnabled(TraceLevelInfo, tag)) {
+        return;
+    }
+
+    va_list recordArgs;
+    va_start(recordArgs, format);
+    const bool recorded = _traceRecord(TraceLevelInfo, tag, format, recordArgs);
+    va_end(recordArgs);
+    if (recorded) {
+        return;
+    }
+
     StrongId<NSString> nsTag;
     nsTag.attach([[NSString alloc] initWithBytes:tag length:sizeof(wchar_t) * wcslen(tag) encoding:getWcharEncoding()]);
 
@@ -66,6 +92,18 @@ void TraceInfo(const wchar_t* tag, const wchar_t* format, ...) {
 }
 
 void TraceWarning(const wchar_t* tag, const wchar_t* format, ...) {
+    if (!TraceIsEnabled(TraceLevelWarning, tag)) {
+        return;
+    }
+
+    va_list recordArgs;
+    va_start(recordArgs, format);
+    const bool recorded = _traceRecord(TraceLevelWarning, tag, format, recordArgs);
+    va_end(recordArgs);
+    if (recorded) {
+        return;
+    }
+
     StrongId<NSString> nsTag;
     nsTag.attach([[NSString alloc] initWithBytes:tag length:sizeof(wchar_t) * wcslen(tag) encoding:getWcharEncoding()]);
 
@@ -80,6 +118,18 @@ void TraceWarning(const wchar_t* tag, const wchar_t* format, ...) {
 }
 
 void TraceError(const wchar_t* tag, const wchar_t* format, ...) {
+    if (!TraceIsEnabled(TraceLevelError, tag)) {
+        return;
+    }
+
+    va_list recordArgs;
+    va_start(recordArgs, format);
+    const bool recorded = _traceRecord(TraceLevelError, tag, format, recordArgs);
+    va_end(recordArgs);
+    if (recorded) {
+        return;
+    }
+
     StrongId<NSString> nsTag;
     nsTag.attach([[NSString alloc] initWithBytes:tag length:sizeof(wchar_t) * wcslen(tag) encoding:getWcharEncoding()]);
 
@@ -94,6 +144,18 @@ void TraceError(const wchar_t* tag, const wchar_t* format, ...) {
 }
 
 void TraceCritical(const wchar_t* tag, const wchar_t* format, ...) {
+    if (!TraceIsEnabled(TraceLevelCritical, tag)) {
+        return;
+    }
+
+    va_list recordArgs;
+    va_start(recordArgs, format);
+    const bool recorded = _traceRecord(TraceLevelCritical, tag, format, recordArgs);
+    va_end(recordArgs);
+    if (recorded) {
+        return;
+    }
+
     StrongId<NSString> nsTag;
     nsTag.attach([[NSString alloc] initWithBytes:tag length:sizeof(wchar_t) * wcslen(tag) encoding:getWcharEncoding()]);
 
@@ -106,3 +168,22 @@ void TraceCritical(const wchar_t* tag, const wchar_t* format, ...) {
     NSLogv(formatString, varArgs);
     va_end(varArgs);
 }
+
+// Test runs set WINOBJC_TRACE_FILE to record their traces in binary, to be decoded with TraceDecodeRecording
+static struct TraceFileRecording {
+    TraceFileRecording() {
+        const char* path = getenv("WINOBJC_TRACE_FILE");
+        if (path && *path) {
+            started = TraceStartFileRecording(path, 0);
+        }
+    }
+
+    //  Only a recording started here is stopped here; tests start and stop their own
+    ~TraceFileRecording() {
+        if (started) {
+            TraceStopRecording();
+        }
+    }
+
+    bool started = false;
+} s_traceFileRecording;
@@ -19,6 +19,11 @@
 #import <Foundation/Foundation.h>
 #import <Accelerate/Accelerate.h>
 
+#include <algorithm>
+#include <chrono>
+#include <thread>
+#include <vector>
+
 /* Note the following abbreviations used at the beginnings of variable and function names:
 d - Double precision real values
 s - Single precision real values
@@ -2234,4 +2239,120 @@ TEST(Accelerate, BLASXerbla) {
     parameterPositionExpected = 12;
     cblas_cgemv(CblasRowMajor, CblasNoTrans, matrixM, matrixN, cScaleFactor, cMatrixA, leadingDimension, cVectorX, arrayStride, cScaleFactor, cVectorY, 0);
     ASSERT_EQ_MSG(errorFlag, 1, "XERBLA TEST FAILED, NO ERROR: NAME: %s POS: %i", functionNameExpected, parameterPositionExpected);
-}
\ No newline at end of file
+}
+
+// Runs gemm single-threaded and on four threads and checks the results agree. The operands are large enough to take the
+// multi-threaded path and leave ragged tiles at the edges.
+template <typename T, typename Gemm>
+static void checkThreadedGemm(int valuesPerElement, Gemm gemm, const char* name) {
+    const int m = 203;
+    const int n = 171;
+    const int k = 157;
+    std::vector<T> a(m * k * valuesPerElement);
+    std::vector<T> b(k * n * valuesPerElement);
+    std::vector<T> single(m * n * valuesPerElement);
+    for (size_t i = 0; i < a.size(); i++) {
+        a[i] = static_cast<T>((i * 7919) % 113) / 113 - static_cast<T>(0.5);
+    }
+
+    for (size_t i = 0; i < b.size(); i++) {
+        b[i] = static_cast<T>((i * 104729) % 97) / 97 - static_cast<T>(0.5);
+    }
+
+    for (size_t i = 0; i < single.size(); i++) {
+        single[i] = static_cast<T>(i % 17);
+    }
+
+    std::vector<T> threaded = single;
+
+    ASSERT_EQ_MSG(0, BLASSetThreading(BLAS_THREADING_SINGLE_THREADED), "TEST FAILED: %s BLASSetThreading", name);
+    ASSERT_EQ_MSG(1, BLASGetThreadCount(), "TEST FAILED: %s single-threaded thread count", name);
+    gemm(a.data(), b.data(), single.data(), m, n, k);
+
+    BLASSetThreading(BLAS_THREADING_MULTI_THREADED);
+    BLASSetThreadCount(4);
+    const int hardwareThreads = std::max(1, static_cast<int>(std::thread::hardware_concurrency()));
+    ASSERT_EQ_MSG(std::min(4, hardwareThreads), BLASGetThreadCount(), "TEST FAILED: %s thread count", name);
+    gemm(a.data(), b.data(), threaded.data(), m, n, k);
+    BLASSetThreadCount(0);
+
+    for (size_t i = 0; i < single.size(); i++) {
+        ASSERT_NEAR_MSG(single[i], threaded[i], 0.001, "TEST FAILED: %s AT INDEX %i\nEXPECTED: %f\nFOUND: %f", name, static_cast<int>(i), single[i], threaded[i]);
+    }
+}
+
+TEST(Accelerate, BLASThreadCountIsClampedToHardware) {
+    const int hardwareThreads = std::max(1, static_cast<int>(std::thread::hardware_concurrency()));
+    BLASSetThreadCount(hardwareThreads * 4);
+    EXPECT_EQ_MSG(hardwareThreads, BLASGetThreadCount(), "TEST FAILED: thread count beyond the hardware");
+    BLASSetThreadCount(0);
+    EXPECT_EQ_MSG(hardwareThreads, BLASGetThreadCount(), "TEST FAILED: default thread count");
+}
+
+TEST(Accelerate, BLASThreadedGemm) {
+    checkThreadedGemm<float>(1, [](const float* a, const float* b, float* c, int m, int n, int k) {
+        cblas_sgemm(CblasRowMajor, CblasNoTrans, CblasTrans, m, n, k, 1.5f, a, k, b, k, 0.5f, c, n);
+    }, "sgemm");
+
+    checkThreadedGemm<double>(1, [](const double* a, const double* b, double* c, int m, int n, int k) {
+        cblas_dgemm(CblasColMajor, CblasTrans, CblasNoTrans, m, n, k, 1.5, a, k, b, k, 0.0, c, m);
+    }, "dgemm");
+
+    checkThreadedGemm<float>(2, [](const float* a, const float* b, float* c, int m, int n, int k) {
+        const float alpha[] = { 1.0f, 0.5f };
+        const float beta[] = { 0.5f, 0.0f };
+        cblas_cgemm(CblasRowMajor, CblasConjTrans, CblasNoTrans, m, n, k, alpha, a, m, b, n, beta, c, n);
+    }, "cgemm");
+
+    checkThreadedGemm<double>(2, [](const double* a, const double* b, double* c, int m, int n, int k) {
+        const double alpha[] = { 1.0, -0.5 };
+        const double beta[] = { 0.0, 0.0 };
+        cblas_zgemm(CblasColMajor, CblasNoTrans, CblasConjTrans, m, n, k, alpha, a, m, b, n, beta, c, m);
+    }, "zgemm");
+}
+
+// Times gemm on square operands single-threaded and with the default thread count. A complex multiply-add is four real
+// multiplies and four real adds, so complex gemm does four times the real flops.
+template <typename T, typename Gemm>
+static void measureGemm(int valuesPerElement, Gemm gemm, const char* name) {
+    const int n = 512;
+    std::vector<T> a(n * n * valuesPerElement);
+    std::vector<T> b(n * n * valuesPerElement);
+    std::vector<T> c(n * n * valuesPerElement);
+    for (size_t i = 0; i < a.size(); i++) {
+        a[i] = static_cast<T>((i * 7919) % 113) / 113;
+        b[i] = static_cast<T>((i * 104729) % 97) / 97;
+    }
+
+    BLASSetThreadCount(0);
+    const double flops = 2.0 * valuesPerElement * valuesPerElement * n * n * n;
+    for (BLAS_THREADING threading : { BLAS_THREADING_SINGLE_THREADED, BLAS_THREADING_MULTI_THREADED }) {
+        BLASSetThreading(threading);
+        auto start = std::chrono::steady_clock::now();
+        gemm(a.data(), b.data(), c.data(), n);
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        LOG_INFO("%s %dx%d, %d thread(s): %.2f GFLOPS", name, n, n, BLASGetThreadCount(), flops / seconds / 1e9);
+    }
+}
+
+TEST(Accelerate, BLASGemmPerformance) {
+    measureGemm<float>(1, [](const float* a, const float* b, float* c, int n) {
+        cblas_sgemm(CblasRowMajor, CblasNoTrans, CblasNoTrans, n, n, n, 1.0f, a, n, b, n, 0.0f, c, n);
+    }, "sgemm");
+
+    measureGemm<double>(1, [](const double* a, const double* b, double* c, int n) {
+        cblas_dgemm(CblasRowMajor, CblasNoTrans, CblasNoTrans, n, n, n, 1.0, a, n, b, n, 0.0, c, n);
+    }, "dgemm");
+
+    measureGemm<float>(2, [](const float* a, const float* b, float* c, int n) {
+        const float alpha[] = { 1.0f, 0.0f };
+        const float beta[] = { 0.0f, 0.0f };
+        cblas_cgemm(CblasRowMajor, CblasNoTrans, CblasNoTrans, n, n, n, alpha, a, n, b, n, beta, c, n);
+    }, "cgemm");
+
+    measureGemm<double>(2, [](const double* a, const double* b, double* c, int n) {
+        const double alpha[] = { 1.0, 0.0 };
+        const double beta[] = { 0.0, 0.0 };
+        cblas_zgemm(CblasRowMajor, CblasNoTrans, CblasNoTrans, n, n, n, alpha, a, n, b, n, beta, c, n);
+    }, "zgemm");
+}
@@ -16,6 +16,9 @@
 //******************************************************************************
 
 #include "gtest-api.h"
+#include <algorithm>
+#include <chrono>
+#include <vector>
 #import "Accelerate/Accelerate.h"
 
 // Constants defining array strides and lengths
@@ -1009,3 +1012,436 @@ TEST(Accelerate, vDSP_DFT_LengthCheck) {
     ASSERT_TRUE_MSG(zrop_Setup_Inverse2 == nullptr, "FAILED: vDSP_DFT_zrop_CreateSetup failed!\n");
     vDSP_DFT_DestroySetup(zrop_Setup_Inverse2);
 }
+
+//Test for validating the single-precision in-place complex FFT against the DFT results
+TEST(Accelerate, vDSP_FFT_ComplexInPlace_Float) {
+    FFTSetup fftSetup = vDSP_create_fftsetup(4, kFFTRadix2);
+    ASSERT_TRUE_MSG(fftSetup != nullptr, "FAILED: vDSP_create_fftsetup failed!\n");
+
+    float Real[8] = {1, 3, 5, 7, 9, 11, 13, 15};
+    float Imag[8] = {2, 4, 6, 8, 10, 12, 14, 16};
+    DSPSplitComplex splitComplex = {Real, Imag};
+
+    vDSP_fft_zip(fftSetup, &splitComplex, 1, 3, kFFTDirection_Forward);
+
+    float FFT_exp_real[] = {64.000000, -27.313709, -16.000000, -11.313708, -8.000000, -4.686292, 0.000000, 11.313708};
+    float FFT_exp_imag[] = {72.000000, 11.313708, 0.000000, -4.686292, -8.000000, -11.313708, -16.000000, -27.313709};
+
+    checkArraySingle(Real, FFT_exp_real, 8, "FFT_zip_Real");
+    checkArraySingle(Imag, FFT_exp_imag, 8, "FFT_zip_Imag");
+
+    vDSP_fft_zip(fftSetup, &splitComplex, 1, 3, kFFTDirection_Inverse);
+
+    float IFFT_exp_real[] = {8, 24, 40, 56, 72, 88, 104, 120};
+    float IFFT_exp_imag[] = {16, 32, 48, 64, 80, 96, 112, 128};
+
+    checkArraySingle(Real, IFFT_exp_real, 8, "IFFT_zip_Real");
+    checkArraySingle(Imag, IFFT_exp_imag, 8, "IFFT_zip_Imag");
+
+    vDSP_destroy_fftsetup(fftSetup);
+}
+
+//Test for validating the single-precision in-place real FFT and its inverse
+TEST(Accelerate, vDSP_FFT_RealInPlace_Float) {
+    FFTSetup fftSetup = vDSP_create_fftsetup(3, kFFTRadix2);
+    ASSERT_TRUE_MSG(fftSetup != nullptr, "FAILED: vDSP_create_fftsetup failed!\n");
+
+    float Real[4] = {5, 10, 15, 20};
+    float Imag[4] = {2, -4, 9, -12};
+    DSPSplitComplex splitComplex = {Real, Imag};
+
+    vDSP_fft_zrip(fftSetup, &splitComplex, 1, 3, kFFTDirection_Forward);
+
+    float FFT_exp_real[] = {90.000000, -41.213204, -20.000000, 1.213204};
+    float FFT_exp_imag[] = {110.000000, 18.585786, -54.000000, -21.414214};
+
+    checkArraySingle(Real, FFT_exp_real, 4, "FFT_zrip_Real");
+    checkArraySingle(Imag, FFT_exp_imag, 4, "FFT_zrip_Imag");
+
+    //The forward real FFT is scaled by 2, so a round trip scales the input by 2 * N
+    vDSP_fft_zrip(fftSetup, &splitComplex, 1, 3, kFFTDirection_Inverse);
+
+    float IFFT_exp_real[] = {80, 160, 240, 320};
+    float IFFT_exp_imag[] = {32, -64, 144, -192};
+
+    checkArraySingle(Real, IFFT_exp_real, 4, "IFFT_zrip_Real");
+    checkArraySingle(Imag, IFFT_exp_imag, 4, "IFFT_zrip_Imag");
+
+    vDSP_destroy_fftsetup(fftSetup);
+}
+
+//Test for validating the double-precision strided out-of-place complex FFT against a directly computed DFT
+TEST(Accelerate, vDSP_FFT_ComplexOutOfPlace_Double) {
+    const vDSP_Length log2N = 10;
+    const vDSP_Length N = 1 << log2N;
+    FFTSetupD fftSetup = vDSP_create_fftsetupD(log2N, kFFTRadix2);
+    ASSERT_TRUE_MSG(fftSetup != nullptr, "FAILED: vDSP_create_fftsetupD failed!\n");
+
+    std::vector<double> inReal(2 * N);
+    std::vector<double> inImag(2 * N);
+    for (vDSP_Length i = 0; i < N; ++i) {
+        inReal[2 * i] = sin(0.37 * i) + (i % 7);
+        inImag[2 * i] = cos(1.13 * i) - (i % 3);
+    }
+
+    std::vector<double> outReal(N);
+    std::vector<double> outImag(N);
+    DSPDoubleSplitComplex input = {inReal.data(), inImag.data()};
+    DSPDoubleSplitComplex output = {outReal.data(), outImag.data()};
+    vDSP_fft_zopD(fftSetup, &input, 2, &output, 1, log2N, kFFTDirection_Forward);
+
+    for (vDSP_Length k = 0; k < N; k += 61) {
+        double real = 0;
+        double imaginary = 0;
+        for (vDSP_Length n = 0; n < N; ++n) {
+            const double angle = -2 * M_PI * ((n * k) % N) / N;
+            real += inReal[2 * n] * cos(angle) - inImag[2 * n] * sin(angle);
+            imaginary += inReal[2 * n] * sin(angle) + inImag[2 * n] * cos(angle);
+        }
+
+        ASSERT_NEAR_MSG(outReal[k], real, 0.001, "TEST FAILED: FFT_zopD_Real AT INDEX %lu", k);
+        ASSERT_NEAR_MSG(outImag[k], imaginary, 0.001, "TEST FAILED: FFT_zopD_Imag AT INDEX %lu", k);
+    }
+
+    vDSP_destroy_fftsetupD(fftSetup);
+}
+
+//Test for validating the single-precision complex DFT for a length that is not a power of two
+TEST(Accelerate, vDSP_DFT_ComplexToComplex_MixedRadix_Float) {
+    const vDSP_Length N = 24;
+    vDSP_DFT_Setup zop_Setup = vDSP_DFT_zop_CreateSetup(NULL, N, vDSP_DFT_FORWARD);
+    ASSERT_TRUE_MSG(zop_Setup != nullptr, "FAILED: vDSP_DFT_zop_CreateSetup failed!\n");
+
+    float RealIn[N];
+    float ImgIn[N];
+    for (vDSP_Length i = 0; i < N; ++i) {
+        RealIn[i] = static_cast<float>(i % 5) - 2;
+        ImgIn[i] = static_cast<float>(i % 3);
+    }
+
+    float RealOut[N];
+    float ImgOut[N];
+    vDSP_DFT_Execute(zop_Setup, RealIn, ImgIn, RealOut, ImgOut);
+
+    for (vDSP_Length k = 0; k < N; ++k) {
+        double real = 0;
+        double imaginary = 0;
+        for (vDSP_Length n = 0; n < N; ++n) {
+            const double angle = -2 * M_PI * ((n * k) % N) / N;
+            real += RealIn[n] * cos(angle) - ImgIn[n] * sin(angle);
+            imaginary += RealIn[n] * sin(angle) + ImgIn[n] * cos(angle);
+        }
+
+        ASSERT_NEAR_MSG(RealOut[k], real, 0.001, "TEST FAILED: DFT_MixedRadix_Real AT INDEX %lu", k);
+        ASSERT_NEAR_MSG(ImgOut[k], imaginary, 0.001, "TEST FAILED: DFT_MixedRadix_Imag AT INDEX %lu", k);
+    }
+
+    vDSP_DFT_DestroySetup(zop_Setup);
+}
+
+//Test for validating that the unit-stride fast paths agree with the strided loops on lengths that are not a multiple of the vector width
+TEST(Accelerate, vDSP_UnitStrideMatchesStrided_Float) {
+    const vDSP_Length N = 19;
+    float A[N];
+    float B[N];
+    float stridedA[2 * N];
+    float stridedB[2 * N];
+    for (vDSP_Length i = 0; i < N; ++i) {
+        stridedA[2 * i] = A[i] = 5 * sinf(1.3f * i);
+        stridedB[2 * i] = B[i] = 3 * cosf(0.7f * i);
+    }
+
+    const float low = -1.0f;
+    const float high = 2.0f;
+    const float scalar = 1.5f;
+    float C[N];
+    float stridedC[2 * N];
+
+    vDSP_vadd(A, 1, B, 1, C, 1, N);
+    vDSP_vadd(stridedA, 2, stridedB, 2, stridedC, 2, N);
+    for (vDSP_Length i = 0; i < N; ++i) {
+        ASSERT_NEAR_MSG(C[i], stridedC[2 * i], 0.001, "TEST FAILED: vadd AT INDEX %lu", i);
+    }
+
+    vDSP_vmul(A, 1, B, 1, C, 1, N);
+    vDSP_vmul(stridedA, 2, stridedB, 2, stridedC, 2, N);
+    for (vDSP_Length i = 0; i < N; ++i) {
+        ASSERT_NEAR_MSG(C[i], stridedC[2 * i], 0.001, "TEST FAILED: vmul AT INDEX %lu", i);
+    }
+
+    vDSP_vsmul(A, 1, &scalar, C, 1, N);
+    vDSP_vsmul(stridedA, 2, &scalar, stridedC, 2, N);
+    for (vDSP_Length i = 0; i < N; ++i) {
+        ASSERT_NEAR_MSG(C[i], stridedC[2 * i], 0.001, "TEST FAILED: vsmul AT INDEX %lu", i);
+    }
+
+    vDSP_vclip(A, 1, &low, &high, C, 1, N);
+    vDSP_vclip(stridedA, 2, &low, &high, stridedC, 2, N);
+    for (vDSP_Length i = 0; i < N; ++i) {
+        ASSERT_NEAR_MSG(C[i], stridedC[2 * i], 0.001, "TEST FAILED: vclip AT INDEX %lu", i);
+    }
+
+    vDSP_vthrsc(A, 1, &low, &scalar, C, 1, N);
+    vDSP_vthrsc(stridedA, 2, &low, &scalar, stridedC, 2, N);
+    for (vDSP_Length i = 0; i < N; ++i) {
+        ASSERT_NEAR_MSG(C[i], stridedC[2 * i], 0.001, "TEST FAILED: vthrsc AT INDEX %lu", i);
+    }
+
+    float maximum;
+    float stridedMaximum;
+    vDSP_maxv(A, 1, &maximum, N);
+    vDSP_maxv(stridedA, 2, &stridedMaximum, N);
+    ASSERT_NEAR_MSG(maximum, stridedMaximum, 0.001, "TEST FAILED: maxv");
+
+    float meanSquare;
+    float stridedMeanSquare;
+    vDSP_measqv(A, 1, &meanSquare, N);
+    vDSP_measqv(stridedA, 2, &stridedMeanSquare, N);
+    ASSERT_NEAR_MSG(meanSquare, stridedMeanSquare, 0.001, "TEST FAILED: measqv");
+}
+
+//Times the out-of-place complex FFT and vDSP_DFT_Execute from 2^8 to 2^20 points against a naive DFT. The naive DFT costs
+//the same N multiply-adds for every output bin, so it is timed on a few bins, checked against the FFT and scaled up to N.
+TEST(Accelerate, vDSP_FFT_Performance) {
+    const vDSP_Length c_maxLog2N = 20;
+    const vDSP_Length c_naiveBins = 16;
+    const vDSP_Length c_pointsPerSize = 1 << 22;
+
+    FFTSetup fftSetup = vDSP_create_fftsetup(c_maxLog2N, kFFTRadix2);
+    ASSERT_TRUE_MSG(fftSetup != nullptr, "FAILED: vDSP_create_fftsetup failed!\n");
+
+    for (vDSP_Length log2N = 8; log2N <= c_maxLog2N; log2N += 2) {
+        const vDSP_Length N = 1 << log2N;
+        const vDSP_Length repeats = std::max<vDSP_Length>(1, c_pointsPerSize / N);
+        std::vector<float> inReal(N);
+        std::vector<float> inImag(N);
+        for (vDSP_Length i = 0; i < N; ++i) {
+            inReal[i] = sinf(0.37f * i) + static_cast<float>(i % 7) / 7;
+            inImag[i] = cosf(1.13f * i) - static_cast<float>(i % 3) / 3;
+        }
+
+        std::vector<float> outReal(N);
+        std::vector<float> outImag(N);
+        DSPSplitComplex input = {inReal.data(), inImag.data()};
+        DSPSplitComplex output = {outReal.data(), outImag.data()};
+
+        auto start = std::chrono::steady_clock::now();
+        for (vDSP_Length r = 0; r < repeats; ++r) {
+            vDSP_fft_zop(fftSetup, &input, 1, &output, 1, log2N, kFFTDirection_Forward);
+        }
+
+        const double fftSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() / repeats;
+
+        vDSP_DFT_Setup dftSetup = vDSP_DFT_zop_CreateSetup(NULL, N, vDSP_DFT_FORWARD);
+        ASSERT_TRUE_MSG(dftSetup != nullptr, "FAILED: vDSP_DFT_zop_CreateSetup failed for %lu points!\n", N);
+        std::vector<float> dftReal(N);
+        std::vector<float> dftImag(N);
+        start = std::chrono::steady_clock::now();
+        for (vDSP_Length r = 0; r < repeats; ++r) {
+            vDSP_DFT_Execute(dftSetup, inReal.data(), inImag.data(), dftReal.data(), dftImag.data());
+        }
+
+        const double dftSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() / repeats;
+        vDSP_DFT_DestroySetup(dftSetup);
+
+        std::vector<double> cosine(N);
+        std::vector<double> sine(N);
+        for (vDSP_Length i = 0; i < N; ++i) {
+            cosine[i] = cos(-2 * M_PI * i / N);
+            sine[i] = sin(-2 * M_PI * i / N);
+        }
+
+        start = std::chrono::steady_clock::now();
+        for (vDSP_Length bin = 0; bin < c_naiveBins; ++bin) {
+            const vDSP_Length k = bin * (N / c_naiveBins) + bin;
+            double real = 0;
+            double imaginary = 0;
+            vDSP_Length index = 0;
+            for (vDSP_Length n = 0; n < N; ++n) {
+                real += inReal[n] * cosine[index] - inImag[n] * sine[index];
+                imaginary += inReal[n] * sine[index] + inImag[n] * cosine[index];
+                index = (index + k) & (N - 1);
+            }
+
+            ASSERT_NEAR_MSG(outReal[k], real, 1e-4 * N, "TEST FAILED: FFT_Performance_Real AT INDEX %lu OF %lu", k, N);
+            ASSERT_NEAR_MSG(outImag[k], imaginary, 1e-4 * N, "TEST FAILED: FFT_Performance_Imag AT INDEX %lu OF %lu", k, N);
+            ASSERT_NEAR_MSG(dftReal[k], real, 1e-4 * N, "TEST FAILED: DFT_Performance_Real AT INDEX %lu OF %lu", k, N);
+            ASSERT_NEAR_MSG(dftImag[k], imaginary, 1e-4 * N, "TEST FAILED: DFT_Performance_Imag AT INDEX %lu OF %lu", k, N);
+        }
+
+        const double naiveSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() * N / c_naiveBins;
+        LOG_INFO("%lu points: FFT %.3f ms (%.0f MFLOPS), DFT_Execute %.3f ms, naive DFT %.1f ms, %.0fx faster",
+                 N,
+                 fftSeconds * 1e3,
+                 5.0 * N * log2N / fftSeconds / 1e6,
+                 dftSeconds * 1e3,
+                 naiveSeconds * 1e3,
+                 naiveSeconds / fftSeconds);
+    }
+
+    vDSP_destroy_fftsetup(fftSetup);
+}
+
+//Runs a kernel and a scalar loop doing the same work over unit-stride buffers, and logs the bytes each moves per second.
+//The scalar loops are kept from being vectorized by the compiler, so they stand for the code the fast paths replaced.
+template <typename Kernel, typename Scalar>
+static void measureThroughput(const char* name, size_t bytesPerElement, vDSP_Length N, Kernel kernel, Scalar scalar) {
+    const double c_bytesPerMeasurement = 512.0 * 1024 * 1024;
+    const int repeats = std::max(1, static_cast<int>(c_bytesPerMeasurement / (bytesPerElement * N)));
+
+    auto start = std::chrono::steady_clock::now();
+    for (int r = 0; r < repeats; ++r) {
+        kernel();
+    }
+
+    const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    start = std::chrono::steady_clock::now();
+    for (int r = 0; r < repeats; ++r) {
+        scalar();
+    }
+
+    const double scalarSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    const double bytes = static_cast<double>(bytesPerElement) * N * repeats;
+    LOG_INFO("%-7s %.2f GB/s, scalar %.2f GB/s, %.1fx", name, bytes / seconds / 1e9, bytes / scalarSeconds / 1e9, scalarSeconds / seconds);
+}
+
+//Throughput of the vectorized single-precision kernels on buffers that fit in the last-level cache
+TEST(Accelerate, vDSP_Throughput_Float) {
+    const vDSP_Length N = 64 * 1024;
+    std::vector<float> A(N);
+    std::vector<float> B(N);
+    std::vector<float> C(N);
+    std::vector<float> D(N);
+    for (vDSP_Length i = 0; i < N; ++i) {
+        A[i] = 5 * sinf(1.3f * i);
+        B[i] = 3 * cosf(0.7f * i);
+    }
+
+    const float low = -1.0f;
+    const float high = 2.0f;
+    const float scalar = 1.5f;
+    float result = 0;
+    DSPSplitComplex splitA = {A.data(), B.data()};
+    DSPSplitComplex splitC = {C.data(), D.data()};
+    float scaleReal = 0.5f;
+    float scaleImag = -0.25f;
+    DSPSplitComplex splitScale = {&scaleReal, &scaleImag};
+
+    measureThroughput("vabs", 2 * sizeof(float), N, [&]() { vDSP_vabs(A.data(), 1, C.data(), 1, N); }, [&]() {
+#pragma clang loop vectorize(disable) interleave(disable)
+        for (vDSP_Length i = 0; i < N; ++i) {
+            C[i] = fabsf(A[i]);
+        }
+    });
+
+    measureThroughput("vneg", 2 * sizeof(float), N, [&]() { vDSP_vneg(A.data(), 1, C.data(), 1, N); }, [&]() {
+#pragma clang loop vectorize(disable) interleave(disable)
+        for (vDSP_Length i = 0; i < N; ++i) {
+            C[i] = -A[i];
+        }
+    });
+
+    measureThroughput("vfill", sizeof(float), N, [&]() { vDSP_vfill(&scalar, C.data(), 1, N); }, [&]() {
+#pragma clang loop vectorize(disable) interleave(disable)
+        for (vDSP_Length i = 0; i < N; ++i) {
+            C[i] = scalar;
+        }
+    });
+
+    measureThroughput("vsq", 2 * sizeof(float), N, [&]() { vDSP_vsq(A.data(), 1, C.data(), 1, N); }, [&]() {
+#pragma clang loop vectorize(disable) interleave(disable)
+        for (vDSP_Length i = 0; i < N; ++i) {
+            C[i] = A[i] * A[i];
+        }
+    });
+
+    measureThroughput("zvmags", 3 * sizeof(float), N, [&]() { vDSP_zvmags(&splitA, 1, C.data(), 1, N); }, [&]() {
+#pragma clang loop vectorize(disable) interleave(disable)
+        for (vDSP_Length i = 0; i < N; ++i) {
+            C[i] = A[i] * A[i] + B[i] * B[i];
+        }
+    });
+
+    measureThroughput("vclip", 2 * sizeof(float), N, [&]() { vDSP_vclip(A.data(), 1, &low, &high, C.data(), 1, N); }, [&]() {
+#pragma clang loop vectorize(disable) interleave(disable)
+        for (vDSP_Length i = 0; i < N; ++i) {
+            C[i] = std::min(std::max(A[i], low), high);
+        }
+    });
+
+    measureThroughput("vthrsc", 2 * sizeof(float), N, [&]() { vDSP_vthrsc(A.data(), 1, &low, &scalar, C.data(), 1, N); }, [&]() {
+#pragma clang loop vectorize(disable) interleave(disable)
+        for (vDSP_Length i = 0; i < N; ++i) {
+            C[i] = (A[i] >= low) ? scalar : -scalar;
+        }
+    });
+
+    measureThroughput("vadd", 3 * sizeof(float), N, [&]() { vDSP_vadd(A.data(), 1, B.data(), 1, C.data(), 1, N); }, [&]() {
+#pragma clang loop vectorize(disable) interleave(disable)
+        for (vDSP_Length i = 0; i < N; ++i) {
+            C[i] = A[i] + B[i];
+        }
+    });
+
+    measureThroughput("vmul", 3 * sizeof(float), N, [&]() { vDSP_vmul(A.data(), 1, B.data(), 1, C.data(), 1, N); }, [&]() {
+#pragma clang loop vectorize(disable) interleave(disable)
+        for (vDSP_Length i = 0; i < N; ++i) {
+            C[i] = A[i] * B[i];
+        }
+    });
+
+    measureThroughput("vsadd", 2 * sizeof(float), N, [&]() { vDSP_vsadd(A.data(), 1, &scalar, C.data(), 1, N); }, [&]() {
+#pragma clang loop vectorize(disable) interleave(disable)
+        for (vDSP_Length i = 0; i < N; ++i) {
+            C[i] = A[i] + scalar;
+        }
+    });
+
+    measureThroughput("vsmul", 2 * sizeof(float), N, [&]() { vDSP_vsmul(A.data(), 1, &scalar, C.data(), 1, N); }, [&]() {
+#pragma clang loop vectorize(disable) interleave(disable)
+        for (vDSP_Length i = 0; i < N; ++i) {
+            C[i] = A[i] * scalar;
+        }
+    });
+
+    measureThroughput("maxv", sizeof(float), N, [&]() { vDSP_maxv(A.data(), 1, &result, N); }, [&]() {
+        float maximum = A[0];
+#pragma clang loop vectorize(disable) interleave(disable)
+        for (vDSP_Length i = 1; i < N; ++i) {
+            maximum = std::max(maximum, A[i]);
+        }
+
+        result = maximum;
+    });
+
+    measureThroughput("measqv", sizeof(float), N, [&]() { vDSP_measqv(A.data(), 1, &result, N); }, [&]() {
+        float sum = 0;
+#pragma clang loop vectorize(disable) interleave(disable)
+        for (vDSP_Length i = 0; i < N; ++i) {
+            sum += A[i] * A[i];
+        }
+
+        result = sum / N;
+    });
+
+    measureThroughput("rmsqv", sizeof(float), N, [&]() { vDSP_rmsqv(A.data(), 1, &result, N); }, [&]() {
+        float sum = 0;
+#pragma clang loop vectorize(disable) interleave(disable)
+        for (vDSP_Length i = 0; i < N; ++i) {
+            sum += A[i] * A[i];
+        }
+
+        result = sqrtf(sum / N);
+    });
+
+    measureThroughput("zvzsml", 4 * sizeof(float), N, [&]() { vDSP_zvzsml(&splitA, 1, &splitScale, &splitC, 1, N); }, [&]() {
+#pragma clang loop vectorize(disable) interleave(disable)
+        for (vDSP_Length i = 0; i < N; ++i) {
+            C[i] = A[i] * scaleReal - B[i] * scaleImag;
+            D[i] = A[i] * scaleImag + B[i] * scaleReal;
+        }
+    });
+
+    ASSERT_FALSE(std::isnan(result));
+}
@@ -25,6 +25,11 @@
 #import "CALayerInternal.h"
 #import "../UIKit/NullCompositor.h"
 
+#include <algorithm>
+#include <chrono>
+#include <memory>
+#include <vector>
+
 vImage_Buffer src, dest;
 vImage_Error Error;
 Pixel_8888 background = {10, 20, 30, 40};
@@ -316,6 +321,247 @@ TEST(Accelerate, BoxConvolve) {
 
 }
 
+TEST(Accelerate, TentConvolve) {
+    vImageInit();
+
+    // A 3x3 tent is the integer kernel {1, 2, 1} x {1, 2, 1} / 16
+    const int16_t tent[9] = { 1, 2, 1, 2, 4, 2, 1, 2, 1 };
+    uint8_t expected[10][10][4];
+    vImage_Buffer expectedBuffer = { expected, 10, 10, 40 };
+
+    Error = vImageConvolve_ARGB8888(&src, &expectedBuffer, NULL, 0, 0, tent, 3, 3, 16, NULL, kvImageEdgeExtend);
+    ASSERT_EQ_MSG(kvImageNoError, Error, "FAILED: vImageConvolve_ARGB8888 returned %d", Error);
+
+    Error = vImageTentConvolve_ARGB8888(&src, &dest, NULL, 0, 0, 3, 3, NULL, kvImageEdgeExtend);
+    ASSERT_EQ_MSG(kvImageNoError, Error, "FAILED: vImageTentConvolve_ARGB8888 returned %d", Error);
+
+    uint8_t* res = reinterpret_cast<uint8_t*>(dest.data);
+    for (int i = 0; i < 10; ++i) {
+        for (int j = 0; j < 10; ++j) {
+            for (int k = 0; k < 4; ++k) {
+                ASSERT_NEAR_MSG(expected[i][j][k], res[i * 40 + j * 4 + k], 1, "Flag :kvImageEdgeExtend\t Tent against integer kernel\0");
+            }
+        }
+    }
+
+    // Interior pixel (4, 4), computed by hand from the input
+    for (int k = 0; k < 4; ++k) {
+        int sum = 0;
+        for (int y = -1; y <= 1; ++y) {
+            for (int x = -1; x <= 1; ++x) {
+                sum += tent[(y + 1) * 3 + (x + 1)] * input[4 + y][4 + x][k];
+            }
+        }
+
+        ASSERT_NEAR_MSG((sum + 8) / 16, res[4 * 40 + 4 * 4 + k], 1, "Tent interior pixel\0");
+    }
+}
+
+TEST(Accelerate, Convolve) {
+    vImageInit();
+
+    // The identity kernel reproduces the source for every edge mode
+    const int16_t identity[9] = { 0, 0, 0, 0, 1, 0, 0, 0, 0 };
+    const vImage_Flags edgeModes[] = { kvImageCopyInPlace, kvImageTruncateKernel, kvImageBackgroundColorFill, kvImageEdgeExtend };
+    for (vImage_Flags edgeMode : edgeModes) {
+        memset(output, 0, sizeof(output));
+        Error = vImageConvolve_ARGB8888(&src, &dest, NULL, 0, 0, identity, 3, 3, 1, background, edgeMode);
+        ASSERT_EQ_MSG(kvImageNoError, Error, "FAILED: vImageConvolve_ARGB8888 returned %d", Error);
+        ASSERT_EQ_MSG(0, memcmp(input, output, sizeof(input)), "FAILED: identity kernel changed the image for flags %u", edgeMode);
+    }
+
+    // A box kernel through vImageConvolve matches vImageBoxConvolve, including when the caller provides the temporary buffer
+    int16_t box[25];
+    for (int i = 0; i < 25; ++i) {
+        box[i] = 1;
+    }
+
+    uint8_t expected[10][10][4];
+    vImage_Buffer expectedBuffer = { expected, 10, 10, 40 };
+    const vImage_Error tempSize =
+        vImageBoxConvolve_ARGB8888(&src, &expectedBuffer, NULL, 0, 0, 5, 5, background, kvImageBackgroundColorFill | kvImageGetTempBufferSize);
+    ASSERT_TRUE_MSG(tempSize > 0, "FAILED: vImageBoxConvolve_ARGB8888 temporary buffer size %d", tempSize);
+
+    std::unique_ptr<uint8_t[]> temp(new uint8_t[tempSize]);
+    Error = vImageBoxConvolve_ARGB8888(&src, &expectedBuffer, temp.get(), 0, 0, 5, 5, background, kvImageBackgroundColorFill);
+    ASSERT_EQ_MSG(kvImageNoError, Error, "FAILED: vImageBoxConvolve_ARGB8888 returned %d", Error);
+
+    Error = vImageConvolve_ARGB8888(&src, &dest, NULL, 0, 0, box, 5, 5, 25, background, kvImageBackgroundColorFill);
+    ASSERT_EQ_MSG(kvImageNoError, Error, "FAILED: vImageConvolve_ARGB8888 returned %d", Error);
+
+    uint8_t* res = reinterpret_cast<uint8_t*>(dest.data);
+    for (int i = 0; i < 10; ++i) {
+        for (int j = 0; j < 10; ++j) {
+            for (int k = 0; k < 4; ++k) {
+                ASSERT_NEAR_MSG(expected[i][j][k], res[i * 40 + j * 4 + k], 1, "Flag :kvImageBackgroundColorFill\t Box against integer kernel\0");
+            }
+        }
+    }
+
+    Error = vImageConvolve_ARGB8888(&src, &dest, NULL, 0, 0, nullptr, 3, 3, 1, NULL, kvImageEdgeExtend);
+    ASSERT_EQ_MSG(kvImageNullPointerArgument, Error, "FAILED: vImageConvolve_ARGB8888 accepted a NULL kernel");
+}
+
+TEST(Accelerate, Reflect) {
+    vImageInit();
+
+    Error = vImageHorizontalReflect_ARGB8888(&src, &dest, kvImageNoFlags);
+    ASSERT_EQ_MSG(kvImageNoError, Error, "FAILED: vImageHorizontalReflect_ARGB8888 returned %d", Error);
+    for (int i = 0; i < 10; ++i) {
+        for (int j = 0; j < 10; ++j) {
+            ASSERT_EQ_MSG(0, memcmp(output[i][j], input[i][9 - j], 4), "FAILED: Horizontal reflect mismatch at (%d, %d)", j, i);
+        }
+    }
+
+    Error = vImageVerticalReflect_ARGB8888(&src, &dest, kvImageNoFlags);
+    ASSERT_EQ_MSG(kvImageNoError, Error, "FAILED: vImageVerticalReflect_ARGB8888 returned %d", Error);
+    for (int i = 0; i < 10; ++i) {
+        ASSERT_EQ_MSG(0, memcmp(output[i], input[9 - i], sizeof(output[i])), "FAILED: Vertical reflect mismatch at row %d", i);
+    }
+
+    // Reflecting twice in place restores the image
+    memcpy(output, input, sizeof(input));
+    vImageHorizontalReflect_ARGB8888(&dest, &dest, kvImageNoFlags);
+    vImageHorizontalReflect_ARGB8888(&dest, &dest, kvImageNoFlags);
+    ASSERT_EQ_MSG(0, memcmp(input, output, sizeof(input)), "FAILED: In-place horizontal reflect is not an involution");
+}
+
+TEST(Accelerate, Rotate90) {
+    vImageInit();
+
+    uint8_t rotated[10][10][4];
+    vImage_Buffer rotatedBuffer = { rotated, 10, 10, 40 };
+
+    Error = vImageRotate90_ARGB8888(&src, &rotatedBuffer, kRotate90DegreesClockwise, background, kvImageNoFlags);
+    ASSERT_EQ_MSG(kvImageNoError, Error, "FAILED: vImageRotate90_ARGB8888 returned %d", Error);
+    for (int i = 0; i < 10; ++i) {
+        for (int j = 0; j < 10; ++j) {
+            ASSERT_EQ_MSG(0, memcmp(rotated[i][j], input[9 - j][i], 4), "FAILED: 90 degree rotation mismatch at (%d, %d)", j, i);
+        }
+    }
+
+    // Four quarter turns restore the image
+    for (int turn = 0; turn < 3; ++turn) {
+        memcpy(output, rotated, sizeof(rotated));
+        vImageRotate90_ARGB8888(&dest, &rotatedBuffer, kRotate90DegreesClockwise, background, kvImageNoFlags);
+    }
+
+    ASSERT_EQ_MSG(0, memcmp(input, rotated, sizeof(input)), "FAILED: Four quarter turns changed the image");
+
+    // A 10x10 image rotated into a 12x10 buffer is centered and padded with the background color
+    uint8_t wide[10][12][4];
+    vImage_Buffer wideBuffer = { wide, 10, 12, 48 };
+    Error = vImageRotate90_ARGB8888(&src, &wideBuffer, kRotate180DegreesClockwise, background, kvImageNoFlags);
+    ASSERT_EQ_MSG(kvImageNoError, Error, "FAILED: vImageRotate90_ARGB8888 returned %d", Error);
+    for (int i = 0; i < 10; ++i) {
+        ASSERT_EQ_MSG(0, memcmp(wide[i][0], background, 4), "FAILED: Left padding not filled in row %d", i);
+        ASSERT_EQ_MSG(0, memcmp(wide[i][11], background, 4), "FAILED: Right padding not filled in row %d", i);
+        for (int j = 0; j < 10; ++j) {
+            ASSERT_EQ_MSG(0, memcmp(wide[i][j + 1], input[9 - i][9 - j], 4), "FAILED: 180 degree rotation mismatch at (%d, %d)", j, i);
+        }
+    }
+
+    Error = vImageRotate90_ARGB8888(&src, &rotatedBuffer, 4, background, kvImageNoFlags);
+    ASSERT_EQ_MSG(kvImageInvalidParameter, Error, "FAILED: vImageRotate90_ARGB8888 accepted an invalid rotation constant");
+}
+
+TEST(Accelerate, Scale) {
+    vImageInit();
+
+    // Scaling to the same size reproduces the source
+    Error = vImageScale_ARGB8888(&src, &dest, NULL, kvImageNoFlags);
+    ASSERT_EQ_MSG(kvImageNoError, Error, "FAILED: vImageScale_ARGB8888 returned %d", Error);
+    ASSERT_EQ_MSG(0, memcmp(input, output, sizeof(input)), "FAILED: Same size scale changed the image");
+
+    // A uniform image stays uniform when shrunk or enlarged
+    uint8_t uniform[10][10][4];
+    for (int i = 0; i < 10; ++i) {
+        for (int j = 0; j < 10; ++j) {
+            memcpy(uniform[i][j], background, 4);
+        }
+    }
+
+    vImage_Buffer uniformBuffer = { uniform, 10, 10, 40 };
+    uint8_t small[3][4][4];
+    uint8_t large[23][17][4];
+    vImage_Buffer smallBuffer = { small, 3, 4, 16 };
+    vImage_Buffer largeBuffer = { large, 23, 17, 68 };
+
+    for (int quality = 0; quality < 2; ++quality) {
+        const vImage_Flags flags = quality ? kvImageHighQualityResampling : kvImageNoFlags;
+        Error = vImageScale_ARGB8888(&uniformBuffer, &smallBuffer, NULL, flags);
+        ASSERT_EQ_MSG(kvImageNoError, Error, "FAILED: vImageScale_ARGB8888 returned %d", Error);
+        for (int i = 0; i < 3 * 4; ++i) {
+            ASSERT_EQ_MSG(0, memcmp(small[i / 4][i % 4], background, 4), "FAILED: Downscaled uniform image changed at pixel %d", i);
+        }
+
+        const vImage_Error tempSize = vImageScale_ARGB8888(&uniformBuffer, &largeBuffer, NULL, flags | kvImageGetTempBufferSize);
+        ASSERT_TRUE_MSG(tempSize > 0, "FAILED: vImageScale_ARGB8888 temporary buffer size %d", tempSize);
+
+        std::unique_ptr<uint8_t[]> temp(new uint8_t[tempSize]);
+        Error = vImageScale_ARGB8888(&uniformBuffer, &largeBuffer, temp.get(), flags);
+        ASSERT_EQ_MSG(kvImageNoError, Error, "FAILED: vImageScale_ARGB8888 returned %d", Error);
+        for (int i = 0; i < 23 * 17; ++i) {
+            ASSERT_EQ_MSG(0, memcmp(large[i / 17][i % 17], background, 4), "FAILED: Upscaled uniform image changed at pixel %d", i);
+        }
+    }
+
+    // Halving a two-column image gives the average of each pair under the symmetric kernel
+    uint8_t stripes[2][2][4] = { { { 0, 0, 0, 0 }, { 200, 200, 200, 200 } }, { { 0, 0, 0, 0 }, { 200, 200, 200, 200 } } };
+    uint8_t halved[1][1][4];
+    vImage_Buffer stripesBuffer = { stripes, 2, 2, 8 };
+    vImage_Buffer halvedBuffer = { halved, 1, 1, 4 };
+    Error = vImageScale_ARGB8888(&stripesBuffer, &halvedBuffer, NULL, kvImageNoFlags);
+    ASSERT_EQ_MSG(kvImageNoError, Error, "FAILED: vImageScale_ARGB8888 returned %d", Error);
+    for (int k = 0; k < 4; ++k) {
+        ASSERT_NEAR_MSG(100, halved[0][0][k], 1, "FAILED: Halved stripes channel %d", k);
+    }
+}
+
+TEST(Accelerate, AffineWarp) {
+    vImageInit();
+
+    const vImage_AffineTransform identity = { 1, 0, 0, 1, 0, 0 };
+    Error = vImageAffineWarp_ARGB8888(&src, &dest, NULL, &identity, background, kvImageBackgroundColorFill);
+    ASSERT_EQ_MSG(kvImageNoError, Error, "FAILED: vImageAffineWarp_ARGB8888 returned %d", Error);
+    ASSERT_EQ_MSG(0, memcmp(input, output, sizeof(input)), "FAILED: Identity warp changed the image");
+
+    // Translating by two pixels shifts the image and exposes the background or the extended edge
+    const vImage_AffineTransform translate = { 1, 0, 0, 1, 2, 0 };
+    Error = vImageAffineWarp_ARGB8888(&src, &dest, NULL, &translate, background, kvImageBackgroundColorFill);
+    ASSERT_EQ_MSG(kvImageNoError, Error, "FAILED: vImageAffineWarp_ARGB8888 returned %d", Error);
+    for (int i = 0; i < 10; ++i) {
+        for (int j = 0; j < 10; ++j) {
+            const uint8_t* expected = (j < 2) ? background : input[i][j - 2];
+            ASSERT_EQ_MSG(0, memcmp(output[i][j], expected, 4), "FAILED: Translated background fill mismatch at (%d, %d)", j, i);
+        }
+    }
+
+    Error = vImageAffineWarp_ARGB8888(&src, &dest, NULL, &translate, NULL, kvImageEdgeExtend);
+    ASSERT_EQ_MSG(kvImageNoError, Error, "FAILED: vImageAffineWarp_ARGB8888 returned %d", Error);
+    for (int i = 0; i < 10; ++i) {
+        for (int j = 0; j < 10; ++j) {
+            ASSERT_EQ_MSG(0, memcmp(output[i][j], input[i][std::max(0, j - 2)], 4), "FAILED: Translated edge extend mismatch at (%d, %d)", j, i);
+        }
+    }
+
+    // A half pixel shift averages horizontal neighbors
+    const vImage_AffineTransform halfShift = { 1, 0, 0, 1, -0.5f, 0 };
+    Error = vImageAffineWarp_ARGB8888(&src, &dest, NULL, &halfShift, NULL, kvImageEdgeExtend);
+    ASSERT_EQ_MSG(kvImageNoError, Error, "FAILED: vImageAffineWarp_ARGB8888 returned %d", Error);
+    for (int i = 0; i < 10; ++i) {
+        for (int j = 0; j < 9; ++j) {
+            for (int k = 0; k < 4; ++k) {
+                ASSERT_NEAR_MSG((input[i][j][k] + input[i][j + 1][k]) / 2.0, output[i][j][k], 1, "FAILED: Half pixel shift at (%d, %d)", j, i);
+            }
+        }
+    }
+
+    const vImage_AffineTransform singular = { 1, 2, 2, 4, 0, 0 };
+    Error = vImageAffineWarp_ARGB8888(&src, &dest, NULL, &singular, background, kvImageBackgroundColorFill);
+    ASSERT_EQ_MSG(kvImageInvalidParameter, Error, "FAILED: vImageAffineWarp_ARGB8888 accepted a singular transform");
+}
+
 TEST(Accelerate, MatrixMultiply) {
     vImageInit();
         
@@ -845,4 +1091,72 @@ TEST(Accelerate, AlphaUnpremultiply) {
 
     vImageTestBufferFree(&unpremultipliedBufferSimd);
     vImageTestBufferFree(&unpremultipliedBufferNormal);
-}
\ No newline at end of file
+}
+
+// Times vImageScale_ARGB8888 against drawing the image into a smaller bitmap context, the way callers downscaled before
+TEST(Accelerate, ScalePerformance) {
+    const size_t c_sourceWidth = 2048;
+    const size_t c_sourceHeight = 1536;
+    const size_t c_sizes[][2] = { { 1024, 768 }, { 640, 480 }, { 512, 384 }, { 160, 120 } };
+    const int c_repeats = 5;
+
+    std::vector<uint8_t> sourcePixels(c_sourceWidth * c_sourceHeight * 4);
+    for (size_t y = 0; y < c_sourceHeight; ++y) {
+        for (size_t x = 0; x < c_sourceWidth; ++x) {
+            uint8_t* pixel = &sourcePixels[(y * c_sourceWidth + x) * 4];
+            pixel[0] = static_cast<uint8_t>(x);
+            pixel[1] = static_cast<uint8_t>(y);
+            pixel[2] = static_cast<uint8_t>(x ^ y);
+            pixel[3] = 0xFF;
+        }
+    }
+
+    woc::unique_cf<CGColorSpaceRef> colorSpace(CGColorSpaceCreateDeviceRGB());
+    const CGBitmapInfo bitmapInfo = kCGImageAlphaPremultipliedFirst | kCGBitmapByteOrder32Big;
+    woc::unique_cf<CGContextRef> sourceContext(CGBitmapContextCreate(
+        sourcePixels.data(), c_sourceWidth, c_sourceHeight, 8, c_sourceWidth * 4, colorSpace.get(), bitmapInfo));
+    woc::unique_cf<CGImageRef> sourceImage(CGBitmapContextCreateImage(sourceContext.get()));
+    ASSERT_TRUE_MSG(sourceImage != nullptr, "FAILED: Could not create the source image");
+
+    vImage_Buffer sourceBuffer = { sourcePixels.data(), c_sourceHeight, c_sourceWidth, c_sourceWidth * 4 };
+    for (const auto& size : c_sizes) {
+        const size_t width = size[0];
+        const size_t height = size[1];
+        std::vector<uint8_t> destinationPixels(width * height * 4);
+        vImage_Buffer destinationBuffer = { destinationPixels.data(), height, width, width * 4 };
+
+        double vImageSeconds[2];
+        for (int quality = 0; quality < 2; ++quality) {
+            const vImage_Flags flags = quality ? kvImageHighQualityResampling : kvImageNoFlags;
+            const vImage_Error tempSize = vImageScale_ARGB8888(&sourceBuffer, &destinationBuffer, NULL, flags | kvImageGetTempBufferSize);
+            ASSERT_TRUE_MSG(tempSize >= 0, "FAILED: vImageScale_ARGB8888 temporary buffer size %d", tempSize);
+            std::unique_ptr<uint8_t[]> temp(new uint8_t[std::max<vImage_Error>(1, tempSize)]);
+
+            auto start = std::chrono::steady_clock::now();
+            for (int r = 0; r < c_repeats; ++r) {
+                Error = vImageScale_ARGB8888(&sourceBuffer, &destinationBuffer, temp.get(), flags);
+                ASSERT_EQ_MSG(kvImageNoError, Error, "FAILED: vImageScale_ARGB8888 returned %d", Error);
+            }
+
+            vImageSeconds[quality] = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() / c_repeats;
+        }
+
+        woc::unique_cf<CGContextRef> destinationContext(
+            CGBitmapContextCreate(destinationPixels.data(), width, height, 8, width * 4, colorSpace.get(), bitmapInfo));
+        CGContextSetInterpolationQuality(destinationContext.get(), kCGInterpolationHigh);
+        auto start = std::chrono::steady_clock::now();
+        for (int r = 0; r < c_repeats; ++r) {
+            CGContextDrawImage(destinationContext.get(), CGRectMake(0, 0, width, height), sourceImage.get());
+        }
+
+        const double drawSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() / c_repeats;
+        LOG_INFO("%zux%zu to %zux%zu: vImageScale %.2f ms, high quality %.2f ms, CGContextDrawImage %.2f ms",
+                 c_sourceWidth,
+                 c_sourceHeight,
+                 width,
+                 height,
+                 vImageSeconds[0] * 1e3,
+                 vImageSeconds[1] * 1e3,
+                 drawSeconds * 1e3);
+    }
+}
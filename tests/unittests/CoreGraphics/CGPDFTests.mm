@@ -0,0 +1,565 @@
+//******************************************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+//
+// This code is licensed under the MIT License (MIT).
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+//******************************************************************************
+
+#import <TestFramework.h>
+#import <Foundation/Foundation.h>
+#import <CoreGraphics/CGDataProvider.h>
+#import <CoreGraphics/CGPDFArray.h>
+#import <CoreGraphics/CGPDFContentStream.h>
+#import <CoreGraphics/CGPDFDictionary.h>
+#import <CoreGraphics/CGPDFDocument.h>
+#import <CoreGraphics/CGPDFObject.h>
+#import <CoreGraphics/CGPDFOperatorTable.h>
+#import <CoreGraphics/CGPDFPage.h>
+#import <CoreGraphics/CGPDFScanner.h>
+#import <CoreGraphics/CGPDFStream.h>
+#import <CoreGraphics/CGPDFString.h>
+#import "CGPDFInternal.h"
+
+#import <chrono>
+#import <map>
+#import <string>
+#import <vector>
+
+// Writes PDF files object by object, keeping track of where each is for the cross-reference section
+class PDFWriter {
+public:
+    PDFWriter() : _data("%PDF-1.7\n%\xe2\xe3\xcf\xd3\n") {
+    }
+
+    void AddObject(uint32_t number, const std::string& body) {
+        _offsets[number] = _data.size();
+        _data += std::to_string(number) + " 0 obj\n" + body + "\nendobj\n";
+    }
+
+    void AddStream(uint32_t number, const std::string& dictionary, const std::string& data) {
+        AddObject(number,
+                  "<< " + dictionary + " /Length " + std::to_string(data.size()) + " >>\nstream\n" + data + "\nendstream");
+    }
+
+    // Ends the file with a cross-reference table
+    std::string Finish(const std::string& trailer) {
+        const size_t xref = _data.size();
+        const uint32_t size = _offsets.empty() ? 1 : _offsets.rbegin()->first + 1;
+        _data += "xref\n0 " + std::to_string(size) + "\n0000000000 65535 f\r\n";
+        for (uint32_t i = 1; i < size; ++i) {
+            char entry[21];
+            auto offset = _offsets.find(i);
+            if (offset != _offsets.end()) {
+                snprintf(entry, sizeof(entry), "%010zu 00000 n\r\n", offset->second);
+            } else {
+                snprintf(entry, sizeof(entry), "%010u 00000 f\r\n", 0u);
+            }
+            _data += entry;
+        }
+
+        _data += "trailer\n<< /Size " + std::to_string(size) + " " + trailer + " >>\nstartxref\n" + std::to_string(xref) + "\n%%EOF\n";
+        return _data;
+    }
+
+    // Ends the file with a cross-reference stream, numbered number, which also lists the objects in object streams
+    std::string FinishWithXrefStream(uint32_t number,
+                                     const std::string& trailer,
+                                     const std::map<uint32_t, std::pair<uint32_t, uint32_t>>& compressed) {
+        const size_t xref = _data.size();
+        _offsets[number] = xref;
+        uint32_t size = std::max(_offsets.rbegin()->first, compressed.empty() ? 0 : compressed.rbegin()->first) + 1;
+
+        //  Entries are a type byte, two bytes of offset or object stream number, and a byte of generation or index
+        std::string entries;
+        for (uint32_t i = 0; i < size; ++i) {
+            auto offset = _offsets.find(i);
+            auto object = compressed.find(i);
+            if (offset != _offsets.end()) {
+                entries += { '\x01', static_cast<char>(offset->second >> 8), static_cast<char>(offset->second), '\0' };
+            } else if (object != compressed.end()) {
+                entries += { '\x02', static_cast<char>(object->second.first >> 8), static_cast<char>(object->second.first),
+                             static_cast<char>(object->second.second) };
+            } else {
+                entries += std::string(4, '\0');
+            }
+        }
+
+        AddStream(number, "/Type /XRef /W [1 2 1] /Size " + std::to_string(size) + " " + trailer, entries);
+        _data += "startxref\n" + std::to_string(xref) + "\n%%EOF\n";
+        return _data;
+    }
+
+private:
+    std::string _data;
+    std::map<uint32_t, size_t> _offsets;
+};
+
+static CGPDFDocumentRef createDocument(const std::string& pdf) {
+    NSData* data = [NSData dataWithBytes:pdf.data() length:pdf.size()];
+    CGDataProviderRef provider = CGDataProviderCreateWithCFData(static_cast<CFDataRef>(data));
+    CGPDFDocumentRef document = CGPDFDocumentCreateWithProvider(provider);
+    CGDataProviderRelease(provider);
+    return document;
+}
+
+static std::string hexEncode(const std::string& data) {
+    static const char c_digits[] = "0123456789ABCDEF";
+    std::string hex;
+    for (unsigned char c : data) {
+        hex += c_digits[c >> 4];
+        hex += c_digits[c & 15];
+    }
+    return hex + ">";
+}
+
+static std::string bytesOfString(CGPDFStringRef string) {
+    return std::string(reinterpret_cast<const char*>(CGPDFStringGetBytePtr(string)), CGPDFStringGetLength(string));
+}
+
+static void countDictionaryEntry(const char* key, CGPDFObjectRef value, void* info) {
+    ++*static_cast<int*>(info);
+}
+
+TEST(CGPDF, DocumentWithXrefTable) {
+    PDFWriter writer;
+    writer.AddObject(1, "<< /Type /Catalog /Pages 2 0 R >>");
+    writer.AddObject(2, "<< /Type /Pages /Kids [3 0 R 4 0 R] /Count 2 /MediaBox [0 0 612 792] /Rotate 90 >>");
+    writer.AddObject(3, "<< /Type /Page /Parent 2 0 R /CropBox [10 10 310 410] >>");
+    writer.AddObject(4, "<< /Type /Page /Parent 2 0 R /MediaBox [200 300 0 0] /Rotate -90 /Extra 5 0 R >>");
+    writer.AddObject(5,
+                     "<< /Integer -42 /Real .5 /Name /A#20B /Escaped (a\\(b\\)\\n\\101\\\nc) /Hex <48656C6C6F7> /True true "
+                     "/Null null /Array [1 2.0 /Three (four) [5] << /Six 6 >> null] >>");
+    writer.AddObject(6,
+                     "<< /Title <FEFF00480069002003C0> /Author (Jane) /CreationDate (D:20161225103000-05'30') >>");
+    CGPDFDocumentRef document = createDocument(writer.Finish("/Root 1 0 R /Info 6 0 R /ID [<0102> <0304>]"));
+    ASSERT_NE(nullptr, document);
+
+    int major = 0;
+    int minor = 0;
+    CGPDFDocumentGetVersion(document, &major, &minor);
+    EXPECT_EQ(1, major);
+    EXPECT_EQ(7, minor);
+    EXPECT_EQ(2, CGPDFDocumentGetNumberOfPages(document));
+    EXPECT_FALSE(CGPDFDocumentIsEncrypted(document));
+    EXPECT_TRUE(CGPDFDocumentIsUnlocked(document));
+    EXPECT_TRUE(CGPDFDocumentAllowsCopying(document));
+    EXPECT_EQ(2, CGPDFArrayGetCount(CGPDFDocumentGetID(document)));
+
+    const char* type = nullptr;
+    EXPECT_TRUE(CGPDFDictionaryGetName(CGPDFDocumentGetCatalog(document), "Type", &type));
+    EXPECT_STREQ("Catalog", type);
+
+    //  Text strings are UTF-16 with a byte order mark, or PDFDocEncoding
+    CGPDFDictionaryRef info = CGPDFDocumentGetInfo(document);
+    CGPDFStringRef string = nullptr;
+    ASSERT_TRUE(CGPDFDictionaryGetString(info, "Title", &string));
+    NSString* title = static_cast<NSString*>(CGPDFStringCopyTextString(string));
+    EXPECT_OBJCEQ(@"Hi π", title);
+    [title release];
+
+    ASSERT_TRUE(CGPDFDictionaryGetString(info, "CreationDate", &string));
+    NSDate* date = static_cast<NSDate*>(CGPDFStringCopyDate(string));
+    EXPECT_EQ(1482661800.0 + 5.5 * 3600.0, [date timeIntervalSince1970]);
+    [date release];
+
+    EXPECT_EQ(nullptr, CGPDFDocumentGetPage(document, 0));
+    EXPECT_EQ(nullptr, CGPDFDocumentGetPage(document, 3));
+
+    //  Pages inherit their media box and rotation from the page tree
+    CGPDFPageRef first = CGPDFDocumentGetPage(document, 1);
+    ASSERT_NE(nullptr, first);
+    EXPECT_EQ(1, CGPDFPageGetPageNumber(first));
+    EXPECT_EQ(document, CGPDFPageGetDocument(first));
+    EXPECT_EQ(90, CGPDFPageGetRotationAngle(first));
+    EXPECT_TRUE(CGRectEqualToRect(CGRectMake(0, 0, 612, 792), CGPDFPageGetBoxRect(first, kCGPDFMediaBox)));
+    EXPECT_TRUE(CGRectEqualToRect(CGRectMake(10, 10, 300, 400), CGPDFPageGetBoxRect(first, kCGPDFCropBox)));
+    EXPECT_TRUE(CGRectEqualToRect(CGRectMake(10, 10, 300, 400), CGPDFPageGetBoxRect(first, kCGPDFTrimBox)));
+
+    CGPDFPageRef second = CGPDFDocumentGetPage(document, 2);
+    ASSERT_NE(nullptr, second);
+    EXPECT_EQ(second, CGPDFDocumentGetPage(document, 2));
+    EXPECT_EQ(270, CGPDFPageGetRotationAngle(second));
+    EXPECT_TRUE(CGRectEqualToRect(CGRectMake(0, 0, 200, 300), CGPDFPageGetBoxRect(second, kCGPDFMediaBox)));
+    EXPECT_TRUE(CGRectEqualToRect(CGRectMake(0, 0, 200, 300), CGPDFPageGetBoxRect(second, kCGPDFArtBox)));
+
+    CGPDFDictionaryRef extra = nullptr;
+    ASSERT_TRUE(CGPDFDictionaryGetDictionary(CGPDFPageGetDictionary(second), "Extra", &extra));
+
+    CGPDFInteger integer = 0;
+    CGPDFReal real = 0;
+    EXPECT_TRUE(CGPDFDictionaryGetInteger(extra, "Integer", &integer));
+    EXPECT_EQ(-42, integer);
+    EXPECT_TRUE(CGPDFDictionaryGetNumber(extra, "Integer", &real));
+    EXPECT_EQ(-42.0f, real);
+    EXPECT_FALSE(CGPDFDictionaryGetInteger(extra, "Real", &integer));
+    EXPECT_TRUE(CGPDFDictionaryGetNumber(extra, "Real", &real));
+    EXPECT_EQ(0.5f, real);
+
+    const char* name = nullptr;
+    EXPECT_TRUE(CGPDFDictionaryGetName(extra, "Name", &name));
+    EXPECT_STREQ("A B", name);
+
+    ASSERT_TRUE(CGPDFDictionaryGetString(extra, "Escaped", &string));
+    EXPECT_EQ(std::string("a(b)\nAc"), bytesOfString(string));
+    ASSERT_TRUE(CGPDFDictionaryGetString(extra, "Hex", &string));
+    EXPECT_EQ(std::string("Hellop"), bytesOfString(string));
+
+    CGPDFBoolean boolean = false;
+    EXPECT_TRUE(CGPDFDictionaryGetBoolean(extra, "True", &boolean));
+    EXPECT_TRUE(boolean);
+
+    //  Null values are the same as missing ones
+    CGPDFObjectRef object = nullptr;
+    EXPECT_FALSE(CGPDFDictionaryGetObject(extra, "Null", &object));
+    int count = 0;
+    CGPDFDictionaryApplyFunction(extra, countDictionaryEntry, &count);
+    EXPECT_EQ(CGPDFDictionaryGetCount(extra), count);
+    EXPECT_EQ(7, count);
+
+    CGPDFArrayRef array = nullptr;
+    ASSERT_TRUE(CGPDFDictionaryGetArray(extra, "Array", &array));
+    ASSERT_EQ(7, CGPDFArrayGetCount(array));
+    EXPECT_TRUE(CGPDFArrayGetInteger(array, 0, &integer));
+    EXPECT_TRUE(CGPDFArrayGetNumber(array, 1, &real));
+    EXPECT_EQ(2.0f, real);
+    EXPECT_TRUE(CGPDFArrayGetName(array, 2, &name));
+    EXPECT_STREQ("Three", name);
+    EXPECT_TRUE(CGPDFArrayGetString(array, 3, &string));
+    CGPDFArrayRef nested = nullptr;
+    EXPECT_TRUE(CGPDFArrayGetArray(array, 4, &nested));
+    EXPECT_EQ(1, CGPDFArrayGetCount(nested));
+    CGPDFDictionaryRef dictionary = nullptr;
+    EXPECT_TRUE(CGPDFArrayGetDictionary(array, 5, &dictionary));
+    EXPECT_TRUE(CGPDFArrayGetNull(array, 6));
+    EXPECT_FALSE(CGPDFArrayGetNull(array, 7));
+    ASSERT_TRUE(CGPDFArrayGetObject(array, 5, &object));
+    EXPECT_EQ(kCGPDFObjectTypeDictionary, CGPDFObjectGetType(object));
+
+    CGPDFDocumentRelease(document);
+}
+
+TEST(CGPDF, DocumentWithObjectStreams) {
+    //  The catalog and page tree are compressed into an object stream, which is itself ASCIIHex encoded
+    const std::string objects[] = {
+        "<< /Type /Catalog /Pages 3 0 R >>",
+        "<< /Type /Pages /Kids [4 0 R] /Count 1 /MediaBox [0 0 100 200] >>",
+        "<< /Type /Page /Parent 3 0 R /Contents 6 0 R >>",
+    };
+
+    std::string header;
+    std::string body;
+    for (size_t i = 0; i < 3; ++i) {
+        header += std::to_string(i + 2) + " " + std::to_string(body.size()) + " ";
+        body += objects[i] + "\n";
+    }
+
+    PDFWriter writer;
+    writer.AddObject(1, "<< /Producer (Test) >>");
+    writer.AddStream(5, "/Type /ObjStm /N 3 /First " + std::to_string(header.size()) + " /Filter /AHx", hexEncode(header + body));
+    writer.AddStream(6, "", "0 0 m 10 10 l S");
+    CGPDFDocumentRef document =
+        createDocument(writer.FinishWithXrefStream(7, "/Root 2 0 R /Info 1 0 R", { { 2, { 5, 0 } }, { 3, { 5, 1 } }, { 4, { 5, 2 } } }));
+    ASSERT_NE(nullptr, document);
+
+    EXPECT_EQ(1, CGPDFDocumentGetNumberOfPages(document));
+    CGPDFPageRef page = CGPDFDocumentGetPage(document, 1);
+    ASSERT_NE(nullptr, page);
+    EXPECT_TRUE(CGRectEqualToRect(CGRectMake(0, 0, 100, 200), CGPDFPageGetBoxRect(page, kCGPDFCropBox)));
+
+    CGPDFStreamRef contents = nullptr;
+    ASSERT_TRUE(CGPDFDictionaryGetStream(CGPDFPageGetDictionary(page), "Contents", &contents));
+    CGPDFDataFormat format;
+    NSData* data = static_cast<NSData*>(CGPDFStreamCopyData(contents, &format));
+    EXPECT_EQ(CGPDFDataFormatRaw, format);
+    EXPECT_OBJCEQ([NSData dataWithBytes:"0 0 m 10 10 l S" length:15], data);
+    [data release];
+
+    CGPDFDocumentRelease(document);
+}
+
+TEST(CGPDF, DocumentWithDamagedXref) {
+    PDFWriter writer;
+    writer.AddObject(1, "<< /Type /Catalog /Pages 2 0 R >>");
+    writer.AddObject(2, "<< /Type /Pages /Kids [3 0 R] /Count 1 >>");
+    writer.AddObject(3, "<< /Type /Page /Parent 2 0 R /MediaBox [0 0 50 50] >>");
+    std::string pdf = writer.Finish("/Root 1 0 R");
+
+    //  Objects are found by scanning the file when the cross-reference table is wrong
+    const size_t startxref = pdf.rfind("startxref\n") + 10;
+    pdf.replace(startxref, pdf.find('\n', startxref) - startxref, "12");
+
+    CGPDFDocumentRef document = createDocument(pdf);
+    ASSERT_NE(nullptr, document);
+    EXPECT_EQ(1, CGPDFDocumentGetNumberOfPages(document));
+    EXPECT_TRUE(CGRectEqualToRect(CGRectMake(0, 0, 50, 50), CGPDFPageGetBoxRect(CGPDFDocumentGetPage(document, 1), kCGPDFMediaBox)));
+    CGPDFDocumentRelease(document);
+
+    EXPECT_EQ(nullptr, createDocument("Not a PDF"));
+}
+
+struct ScannedContent {
+    std::vector<std::string> operators;
+    CGPDFReal transform[6];
+    std::string text;
+    std::string font;
+    CGPDFReal fontSize;
+    size_t dashCount;
+    CGPDFInteger imageWidth;
+    size_t imageLength;
+    std::string xobject;
+};
+
+static void scanTransform(CGPDFScannerRef scanner, void* info) {
+    ScannedContent* content = static_cast<ScannedContent*>(info);
+    content->operators.push_back("cm");
+    for (int i = 5; i >= 0; --i) {
+        CGPDFScannerPopNumber(scanner, &content->transform[i]);
+    }
+}
+
+static void scanFont(CGPDFScannerRef scanner, void* info) {
+    ScannedContent* content = static_cast<ScannedContent*>(info);
+    content->operators.push_back("Tf");
+    const char* name = nullptr;
+    CGPDFScannerPopNumber(scanner, &content->fontSize);
+    if (CGPDFScannerPopName(scanner, &name)) {
+        //  Resources are looked up in the page's resource dictionary
+        CGPDFDictionaryRef font = nullptr;
+        CGPDFObjectRef resource = CGPDFContentStreamGetResource(CGPDFScannerGetContentStream(scanner), "Font", name);
+        if (CGPDFObjectGetValue(resource, kCGPDFObjectTypeDictionary, &font)) {
+            CGPDFDictionaryGetName(font, "BaseFont", &name);
+            content->font = name;
+        }
+    }
+}
+
+static void scanText(CGPDFScannerRef scanner, void* info) {
+    ScannedContent* content = static_cast<ScannedContent*>(info);
+    content->operators.push_back("Tj");
+    CGPDFStringRef string = nullptr;
+    if (CGPDFScannerPopString(scanner, &string)) {
+        content->text = bytesOfString(string);
+    }
+}
+
+static void scanDash(CGPDFScannerRef scanner, void* info) {
+    ScannedContent* content = static_cast<ScannedContent*>(info);
+    content->operators.push_back("d");
+    CGPDFInteger phase;
+    CGPDFArrayRef lengths = nullptr;
+    if (CGPDFScannerPopInteger(scanner, &phase) && CGPDFScannerPopArray(scanner, &lengths)) {
+        content->dashCount = CGPDFArrayGetCount(lengths);
+    }
+}
+
+static void scanInlineImage(CGPDFScannerRef scanner, void* info) {
+    ScannedContent* content = static_cast<ScannedContent*>(info);
+    content->operators.push_back("EI");
+    CGPDFStreamRef image = nullptr;
+    if (CGPDFScannerPopStream(scanner, &image)) {
+        CGPDFDictionaryGetInteger(CGPDFStreamGetDictionary(image), "W", &content->imageWidth);
+        CFDataRef data = CGPDFStreamCopyData(image, nullptr);
+        content->imageLength = [static_cast<NSData*>(data) length];
+        CFRelease(data);
+    }
+}
+
+static void scanXObject(CGPDFScannerRef scanner, void* info) {
+    ScannedContent* content = static_cast<ScannedContent*>(info);
+    content->operators.push_back("Do");
+    const char* name = nullptr;
+    if (CGPDFScannerPopName(scanner, &name)) {
+        content->xobject = name;
+    }
+}
+
+static void scanOperator(CGPDFScannerRef scanner, void* info) {
+    static_cast<ScannedContent*>(info)->operators.push_back("op");
+}
+
+TEST(CGPDF, DocumentWithUnevenPageTree) {
+    //  As many kids as pages, but an empty node first and two pages under the last kid
+    PDFWriter writer;
+    writer.AddObject(1, "<< /Type /Catalog /Pages 2 0 R >>");
+    writer.AddObject(2, "<< /Type /Pages /Kids [3 0 R 4 0 R 5 0 R] /Count 3 >>");
+    writer.AddObject(3, "<< /Type /Pages /Parent 2 0 R /Kids [] /Count 0 >>");
+    writer.AddObject(4, "<< /Type /Page /Parent 2 0 R /MediaBox [0 0 1 1] >>");
+    writer.AddObject(5, "<< /Type /Pages /Parent 2 0 R /Kids [6 0 R 7 0 R] /Count 2 >>");
+    writer.AddObject(6, "<< /Type /Page /Parent 5 0 R /MediaBox [0 0 2 2] >>");
+    writer.AddObject(7, "<< /Type /Page /Parent 5 0 R /MediaBox [0 0 3 3] /Huge 99999999999999999 >>");
+    CGPDFDocumentRef document = createDocument(writer.Finish("/Root 1 0 R"));
+    ASSERT_NE(nullptr, document);
+
+    ASSERT_EQ(3, CGPDFDocumentGetNumberOfPages(document));
+    for (size_t i = 1; i <= 3; ++i) {
+        CGPDFPageRef page = CGPDFDocumentGetPage(document, i);
+        ASSERT_NE(nullptr, page);
+        EXPECT_TRUE(CGRectEqualToRect(CGRectMake(0, 0, i, i), CGPDFPageGetBoxRect(page, kCGPDFMediaBox)));
+    }
+    EXPECT_EQ(nullptr, CGPDFDocumentGetPage(document, 4));
+
+    //  Too large for a CGPDFInteger everywhere, so read as a real
+    CGPDFInteger integer = 0;
+    CGPDFReal real = 0;
+    CGPDFDictionaryRef dictionary = CGPDFPageGetDictionary(CGPDFDocumentGetPage(document, 3));
+    EXPECT_TRUE(sizeof(CGPDFInteger) > 4 || !CGPDFDictionaryGetInteger(dictionary, "Huge", &integer));
+    EXPECT_TRUE(CGPDFDictionaryGetNumber(dictionary, "Huge", &real));
+    CGPDFDocumentRelease(document);
+
+    //  A /Count no file of this size could hold
+    PDFWriter lying;
+    lying.AddObject(1, "<< /Type /Catalog /Pages 2 0 R >>");
+    lying.AddObject(2, "<< /Type /Pages /Kids [3 0 R] /Count 2000000000 >>");
+    lying.AddObject(3, "<< /Type /Page /Parent 2 0 R /MediaBox [0 0 1 1] >>");
+    document = createDocument(lying.Finish("/Root 1 0 R"));
+    ASSERT_NE(nullptr, document);
+    EXPECT_GE(4u, CGPDFDocumentGetNumberOfPages(document));
+    EXPECT_NE(nullptr, CGPDFDocumentGetPage(document, 1));
+    EXPECT_EQ(nullptr, CGPDFDocumentGetPage(document, 2));
+    CGPDFDocumentRelease(document);
+}
+
+TEST(CGPDF, ScannerCallsOperators) {
+    //  "q 1 0 0 1 72 720 cm\n0.5 g\nBT /F1 12 Tf (Hello, \(world\)) Tj ET\n[1 2.5 -3] 0 d\n", Flate compressed
+    static const char c_compressed[] =
+        "\x78\xda\x2b\x54\x30\x54\x30\x00\x42\x43\x05\x73\x23\x20\x32\x50\x48\xce\xe5\x32\xd0\x33\x55\x48\xe7\x72\x0a\x51\xd0\x77\x33"
+        "\x54\x30\x34\x52\x08\x49\x53\xd0\xf0\x48\xcd\xc9\xc9\xd7\x51\x88\xd1\x28\xcf\x2f\xca\x49\x89\xd1\xd4\x54\x08\xc9\x52\x70\x0d"
+        "\xe1\x8a\x36\x54\x30\x02\x2a\xd7\x35\x8e\x05\x1a\x92\xc2\x05\x00\xc5\x13\x12\x4c";
+    static const char c_uncompressed[] = "BI /W 2 /H 1 /CS /G /BPC 8 ID \x00\xff EI\n/Im1 Do Q";
+
+    PDFWriter writer;
+    writer.AddObject(1, "<< /Type /Catalog /Pages 2 0 R >>");
+    writer.AddObject(2, "<< /Type /Pages /Kids [3 0 R] /Count 1 /Resources << /Font << /F1 6 0 R >> >> >>");
+    writer.AddObject(3, "<< /Type /Page /Parent 2 0 R /Contents [4 0 R 5 0 R] >>");
+    writer.AddStream(4, "/Filter /FlateDecode", std::string(c_compressed, sizeof(c_compressed) - 1));
+    writer.AddStream(5, "", std::string(c_uncompressed, sizeof(c_uncompressed) - 1));
+    writer.AddObject(6, "<< /Type /Font /Subtype /Type1 /BaseFont /Helvetica >>");
+    CGPDFDocumentRef document = createDocument(writer.Finish("/Root 1 0 R"));
+    ASSERT_NE(nullptr, document);
+
+    CGPDFOperatorTableRef table = CGPDFOperatorTableCreate();
+    CGPDFOperatorTableSetCallback(table, "cm", scanTransform);
+    CGPDFOperatorTableSetCallback(table, "Tf", scanFont);
+    CGPDFOperatorTableSetCallback(table, "Tj", scanText);
+    CGPDFOperatorTableSetCallback(table, "d", scanDash);
+    CGPDFOperatorTableSetCallback(table, "EI", scanInlineImage);
+    CGPDFOperatorTableSetCallback(table, "Do", scanXObject);
+    CGPDFOperatorTableSetCallback(table, "q", scanOperator);
+    CGPDFOperatorTableSetCallback(table, "Q", scanOperator);
+
+    ScannedContent content = {};
+    CGPDFContentStreamRef contentStream = CGPDFContentStreamCreateWithPage(CGPDFDocumentGetPage(document, 1));
+    EXPECT_EQ(2, CFArrayGetCount(CGPDFContentStreamGetStreams(contentStream)));
+
+    CGPDFScannerRef scanner = CGPDFScannerCreate(contentStream, table, &content);
+    EXPECT_TRUE(CGPDFScannerScan(scanner));
+    CGPDFScannerRelease(scanner);
+    CGPDFContentStreamRelease(contentStream);
+    CGPDFOperatorTableRelease(table);
+    CGPDFDocumentRelease(document);
+
+    const std::vector<std::string> expected = { "op", "cm", "Tf", "Tj", "d", "EI", "Do", "op" };
+    EXPECT_EQ(expected, content.operators);
+    EXPECT_EQ(72.0f, content.transform[4]);
+    EXPECT_EQ(720.0f, content.transform[5]);
+    EXPECT_EQ("Helvetica", content.font);
+    EXPECT_EQ(12.0f, content.fontSize);
+    EXPECT_EQ("Hello, (world)", content.text);
+    EXPECT_EQ(3, content.dashCount);
+    EXPECT_EQ(2, content.imageWidth);
+    EXPECT_EQ(2, content.imageLength);
+    EXPECT_EQ("Im1", content.xobject);
+}
+
+TEST(CGPDF, PageDrawingTransform) {
+    PDFWriter writer;
+    writer.AddObject(1, "<< /Type /Catalog /Pages 2 0 R >>");
+    writer.AddObject(2, "<< /Type /Pages /Kids [3 0 R] /Count 1 >>");
+    writer.AddObject(3, "<< /Type /Page /Parent 2 0 R /MediaBox [0 0 200 100] /Rotate 90 >>");
+    CGPDFDocumentRef document = createDocument(writer.Finish("/Root 1 0 R"));
+    CGPDFPageRef page = CGPDFDocumentGetPage(document, 1);
+    ASSERT_NE(nullptr, page);
+
+    //  Rotated a quarter turn clockwise, the page is 100 wide and 200 tall, and fits a 50x50 rect at a quarter of its size
+    CGAffineTransform transform = CGPDFPageGetDrawingTransform(page, kCGPDFMediaBox, CGRectMake(0, 0, 50, 50), 0, true);
+    CGPoint topLeft = CGPointApplyAffineTransform(CGPointMake(0, 100), transform);
+    CGPoint bottomRight = CGPointApplyAffineTransform(CGPointMake(200, 0), transform);
+    EXPECT_NEAR(37.5f, topLeft.x, 0.001f);
+    EXPECT_NEAR(50.0f, topLeft.y, 0.001f);
+    EXPECT_NEAR(12.5f, bottomRight.x, 0.001f);
+    EXPECT_NEAR(0.0f, bottomRight.y, 0.001f);
+
+    //  Pages are never scaled up
+    transform = CGPDFPageGetDrawingTransform(page, kCGPDFMediaBox, CGRectMake(0, 0, 1000, 1000), -90, true);
+    EXPECT_TRUE(CGAffineTransformEqualToTransform(CGAffineTransformMakeTranslation(400, 450), transform));
+
+    CGPDFDocumentRelease(document);
+}
+
+TEST(CGPDF, LargeDocumentPageAccess) {
+    //  1000 pages under a two level page tree, each with its own content stream
+    const int c_pageCount = 1000;
+    const int c_pagesPerNode = 100;
+    const int c_nodeCount = c_pageCount / c_pagesPerNode;
+
+    PDFWriter writer;
+    writer.AddObject(1, "<< /Type /Catalog /Pages 2 0 R >>");
+    std::string rootKids;
+    for (int node = 0; node < c_nodeCount; ++node) {
+        const uint32_t nodeNumber = 3 + node;
+        rootKids += std::to_string(nodeNumber) + " 0 R ";
+
+        std::string kids;
+        for (int i = 0; i < c_pagesPerNode; ++i) {
+            const int page = node * c_pagesPerNode + i;
+            const uint32_t pageNumber = 3 + c_nodeCount + 2 * page;
+            kids += std::to_string(pageNumber) + " 0 R ";
+            writer.AddObject(pageNumber,
+                             "<< /Type /Page /Parent " + std::to_string(nodeNumber) + " 0 R /MediaBox [0 0 " + std::to_string(page + 1) +
+                                 " 100] /Contents " + std::to_string(pageNumber + 1) + " 0 R >>");
+            writer.AddStream(pageNumber + 1, "", "BT /F1 12 Tf (Page " + std::to_string(page + 1) + ") Tj ET");
+        }
+        writer.AddObject(nodeNumber,
+                         "<< /Type /Pages /Parent 2 0 R /Kids [" + kids + "] /Count " + std::to_string(c_pagesPerNode) + " >>");
+    }
+    writer.AddObject(2, "<< /Type /Pages /Kids [" + rootKids + "] /Count " + std::to_string(c_pageCount) + " >>");
+    const std::string pdf = writer.Finish("/Root 1 0 R");
+
+    auto start = std::chrono::steady_clock::now();
+    CGPDFDocumentRef document = createDocument(pdf);
+    ASSERT_NE(nullptr, document);
+    CGPDFPageRef page = CGPDFDocumentGetPage(document, 900);
+    const double pageMicroseconds = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+
+    ASSERT_NE(nullptr, page);
+    EXPECT_EQ(900, CGPDFPageGetPageNumber(page));
+    EXPECT_TRUE(CGRectEqualToRect(CGRectMake(0, 0, 900, 100), CGPDFPageGetBoxRect(page, kCGPDFMediaBox)));
+
+    //  The catalog, the page tree nodes on the way and the pages under the last node; no other pages, and no content
+    const size_t parsedCount = _CGPDFDocumentGetParsedObjectCount(document);
+    EXPECT_LE(2u + c_nodeCount + c_pagesPerNode, parsedCount);
+    EXPECT_GE(4u + c_nodeCount + c_pagesPerNode, parsedCount);
+    CGPDFDocumentRelease(document);
+
+    start = std::chrono::steady_clock::now();
+    document = createDocument(pdf);
+    for (size_t i = 1; i <= c_pageCount; ++i) {
+        EXPECT_EQ(i, CGPDFPageGetPageNumber(CGPDFDocumentGetPage(document, i)));
+    }
+    const double allMicroseconds = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+
+    //  Every page tree object, and still no content
+    EXPECT_GE(4u + c_nodeCount + c_pageCount, _CGPDFDocumentGetParsedObjectCount(document));
+    CGPDFDocumentRelease(document);
+
+    LOG_INFO("1000 page document: opened and read page 900 in %.0f us, every page in %.0f us", pageMicroseconds, allMicroseconds);
+}
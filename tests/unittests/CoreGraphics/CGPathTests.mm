@@ -22,6 +22,11 @@
 #import <CoreGraphics/CGColor.h>
 #import <CoreGraphics/CGColorSpace.h>
 
+#import <algorithm>
+#import <chrono>
+#import <math.h>
+#import <vector>
+
 static NSString* const kPointsKey = @"PointsKey";
 static NSString* const kTypeKey = @"TypeKey";
 // Helper function to know # of points in an element
@@ -582,3 +587,426 @@ TEST(CGPath, CGPathContainsPointEOFillFalse) {
 
     EXPECT_TRUE(test);
 }
+
+TEST(CGPath, CGPathContainsPointWindingRules) {
+    //  Two nested squares drawn the same way round fill the inner one under the nonzero rule, but not the even-odd rule
+    CGMutablePathRef path = CGPathCreateMutable();
+    CGPathAddRect(path, NULL, CGRectMake(0.0f, 0.0f, 100.0f, 100.0f));
+    CGPathAddRect(path, NULL, CGRectMake(25.0f, 25.0f, 50.0f, 50.0f));
+
+    EXPECT_TRUE(CGPathContainsPoint(path, NULL, CGPointMake(10.0f, 10.0f), NO));
+    EXPECT_TRUE(CGPathContainsPoint(path, NULL, CGPointMake(10.0f, 10.0f), YES));
+    EXPECT_TRUE(CGPathContainsPoint(path, NULL, CGPointMake(50.0f, 50.0f), NO));
+    EXPECT_FALSE(CGPathContainsPoint(path, NULL, CGPointMake(50.0f, 50.0f), YES));
+
+    //  Changing the path drops what was cached for the old one
+    CGPathMoveToPoint(path, NULL, 200.0f, 0.0f);
+    CGPathAddLineToPoint(path, NULL, 300.0f, 0.0f);
+    CGPathAddLineToPoint(path, NULL, 300.0f, 100.0f);
+    EXPECT_FALSE(CGPathContainsPoint(path, NULL, CGPointMake(210.0f, 50.0f), NO));
+
+    //  An open subpath is closed for hit-testing, as when it is filled
+    EXPECT_TRUE(CGPathContainsPoint(path, NULL, CGPointMake(290.0f, 50.0f), NO));
+
+    CGPathRelease(path);
+}
+
+TEST(CGPath, CGPathContainsPointCurves) {
+    CGPathRef circle = CGPathCreateWithEllipseInRect(CGRectMake(0.0f, 0.0f, 200.0f, 200.0f), NULL);
+
+    //  Just inside and just outside the circle, along the diagonal where it's furthest from its control points
+    const float offset = 100.0f / sqrtf(2.0f);
+    EXPECT_TRUE(CGPathContainsPoint(circle, NULL, CGPointMake(100.0f + offset - 0.5f, 100.0f + offset - 0.5f), NO));
+    EXPECT_FALSE(CGPathContainsPoint(circle, NULL, CGPointMake(100.0f + offset + 0.5f, 100.0f + offset + 0.5f), NO));
+    EXPECT_FALSE(CGPathContainsPoint(circle, NULL, CGPointMake(2.0f, 2.0f), NO));
+
+    CGPathRelease(circle);
+
+    CGMutablePathRef quad = CGPathCreateMutable();
+    CGPathMoveToPoint(quad, NULL, 0.0f, 0.0f);
+    CGPathAddQuadCurveToPoint(quad, NULL, 50.0f, 100.0f, 100.0f, 0.0f);
+    CGPathCloseSubpath(quad);
+
+    //  The curve peaks at half its control point's height
+    EXPECT_TRUE(CGPathContainsPoint(quad, NULL, CGPointMake(50.0f, 49.0f), NO));
+    EXPECT_FALSE(CGPathContainsPoint(quad, NULL, CGPointMake(50.0f, 51.0f), NO));
+
+    CGPathRelease(quad);
+}
+
+TEST(CGPath, CGPathLargePathPerformance) {
+    //  A star of 10000 line and curve elements, its points alternating between circles of radius 950 and 1000
+    const int c_points = 10000;
+    CGMutablePathRef path = CGPathCreateMutable();
+
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < c_points; ++i) {
+        const float angle = 2.0f * M_PI * i / c_points;
+        const float radius = (i % 2) ? 1000.0f : 950.0f;
+        const float x = 1000.0f + radius * cosf(angle);
+        const float y = 1000.0f + radius * sinf(angle);
+        if (i == 0) {
+            CGPathMoveToPoint(path, NULL, x, y);
+        } else if (i % 4 == 0) {
+            CGPathAddCurveToPoint(path, NULL, x, y, x, y, x, y);
+        } else {
+            CGPathAddLineToPoint(path, NULL, x, y);
+        }
+    }
+    CGPathCloseSubpath(path);
+    const double buildMicroseconds = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+
+    //  The first test flattens the path
+    start = std::chrono::steady_clock::now();
+    EXPECT_TRUE(CGPathContainsPoint(path, NULL, CGPointMake(1000.0f, 1000.0f), NO));
+    const double firstMicroseconds = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+
+    const int c_tests = 10000;
+    int inside = 0;
+    start = std::chrono::steady_clock::now();
+    for (int i = 0; i < c_tests; ++i) {
+        const float x = 2000.0f * (i % 100) / 100.0f;
+        const float y = 2000.0f * (i / 100) / 100.0f;
+        inside += CGPathContainsPoint(path, NULL, CGPointMake(x, y), i % 2) ? 1 : 0;
+    }
+    const double testMicroseconds = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count() / c_tests;
+
+    //  Between pi * 950^2 / 20^2 and pi * 1000^2 / 20^2 of the grid points, for the star's inner and outer circles
+    EXPECT_GT(inside, 7088 - 50);
+    EXPECT_LT(inside, 7854 + 50);
+
+    LOG_INFO("10000 element path: built in %.0f us, flattened in %.0f us, %.2f us per hit test",
+             buildMicroseconds,
+             firstMicroseconds,
+             testMicroseconds);
+
+    CGPathRelease(path);
+}
+
+// CGPathApplierFunction that adds every point of every element to a std::vector<CGPoint>
+void cgPathPointApplierFunction(void* info, const CGPathElement* element) {
+    std::vector<CGPoint>* points = static_cast<std::vector<CGPoint>*>(info);
+    for (int i = 0; i < cgPathPointCountForElementType(element->type); i++) {
+        points->push_back(element->points[i]);
+    }
+}
+
+// CGPathApplierFunction that counts the subpaths of a path
+void cgPathMoveCountApplierFunction(void* info, const CGPathElement* element) {
+    if (element->type == kCGPathElementMoveToPoint) {
+        ++*static_cast<int*>(info);
+    }
+}
+
+TEST(CGPath, CGPathCreateCopyByTransformingPath) {
+    CGMutablePathRef path = CGPathCreateMutable();
+    CGPathMoveToPoint(path, NULL, 1.0f, 2.0f);
+    CGPathAddLineToPoint(path, NULL, 3.0f, 4.0f);
+    CGPathAddQuadCurveToPoint(path, NULL, 5.0f, 6.0f, 7.0f, 8.0f);
+    CGPathAddCurveToPoint(path, NULL, 9.0f, 10.0f, 11.0f, 12.0f, 13.0f, 14.0f);
+    CGPathCloseSubpath(path);
+
+    const CGAffineTransform transform = CGAffineTransformTranslate(CGAffineTransformMakeScale(2.0f, 3.0f), 10.0f, 20.0f);
+    CGPathRef transformed = CGPathCreateCopyByTransformingPath(path, &transform);
+
+    //  Transforming the elements is the same as adding them with the transform
+    CGMutablePathRef expected = CGPathCreateMutable();
+    CGPathAddPath(expected, &transform, path);
+    EXPECT_TRUE(CGPathEqualToPath(expected, transformed));
+
+    std::vector<CGPoint> points;
+    CGPathApply(transformed, &points, cgPathPointApplierFunction);
+    ASSERT_EQ(7u, points.size());
+    EXPECT_FLOAT_EQ(22.0f, points[0].x);
+    EXPECT_FLOAT_EQ(66.0f, points[0].y);
+    EXPECT_FLOAT_EQ(46.0f, points[6].x);
+    EXPECT_FLOAT_EQ(102.0f, points[6].y);
+
+    CGPathRef copy = CGPathCreateCopyByTransformingPath(path, NULL);
+    EXPECT_TRUE(CGPathEqualToPath(path, copy));
+
+    CGPathRelease(copy);
+    CGPathRelease(expected);
+    CGPathRelease(transformed);
+    CGPathRelease(path);
+}
+
+TEST(CGPath, CGPathCreateCopyByStrokingPathCaps) {
+    CGMutablePathRef line = CGPathCreateMutable();
+    CGPathMoveToPoint(line, NULL, 0.0f, 0.0f);
+    CGPathAddLineToPoint(line, NULL, 100.0f, 0.0f);
+
+    CGPathRef butt = CGPathCreateCopyByStrokingPath(line, NULL, 10.0f, kCGLineCapButt, kCGLineJoinMiter, 10.0f);
+    EXPECT_TRUE(CGPathContainsPoint(butt, NULL, CGPointMake(50.0f, 4.0f), NO));
+    EXPECT_TRUE(CGPathContainsPoint(butt, NULL, CGPointMake(50.0f, -4.0f), NO));
+    EXPECT_FALSE(CGPathContainsPoint(butt, NULL, CGPointMake(50.0f, 6.0f), NO));
+    EXPECT_FALSE(CGPathContainsPoint(butt, NULL, CGPointMake(-1.0f, 0.0f), NO));
+    EXPECT_FALSE(CGPathContainsPoint(butt, NULL, CGPointMake(101.0f, 0.0f), NO));
+
+    CGPathRef square = CGPathCreateCopyByStrokingPath(line, NULL, 10.0f, kCGLineCapSquare, kCGLineJoinMiter, 10.0f);
+    EXPECT_TRUE(CGPathContainsPoint(square, NULL, CGPointMake(-4.0f, 4.0f), NO));
+    EXPECT_TRUE(CGPathContainsPoint(square, NULL, CGPointMake(104.0f, -4.0f), NO));
+    EXPECT_FALSE(CGPathContainsPoint(square, NULL, CGPointMake(-6.0f, 0.0f), NO));
+
+    CGPathRef round = CGPathCreateCopyByStrokingPath(line, NULL, 10.0f, kCGLineCapRound, kCGLineJoinMiter, 10.0f);
+    EXPECT_TRUE(CGPathContainsPoint(round, NULL, CGPointMake(-4.5f, 0.0f), NO));
+    EXPECT_TRUE(CGPathContainsPoint(round, NULL, CGPointMake(103.0f, 3.0f), NO));
+    EXPECT_FALSE(CGPathContainsPoint(round, NULL, CGPointMake(-4.0f, 4.0f), NO));
+    EXPECT_FALSE(CGPathContainsPoint(round, NULL, CGPointMake(104.0f, -4.0f), NO));
+
+    //  A subpath that goes nowhere is drawn as its caps alone
+    CGMutablePathRef dot = CGPathCreateMutable();
+    CGPathMoveToPoint(dot, NULL, 10.0f, 10.0f);
+    CGPathAddLineToPoint(dot, NULL, 10.0f, 10.0f);
+    CGPathRef roundDot = CGPathCreateCopyByStrokingPath(dot, NULL, 10.0f, kCGLineCapRound, kCGLineJoinMiter, 10.0f);
+    EXPECT_TRUE(CGPathContainsPoint(roundDot, NULL, CGPointMake(14.0f, 10.0f), NO));
+    EXPECT_FALSE(CGPathContainsPoint(roundDot, NULL, CGPointMake(14.0f, 14.0f), NO));
+    CGPathRef buttDot = CGPathCreateCopyByStrokingPath(dot, NULL, 10.0f, kCGLineCapButt, kCGLineJoinMiter, 10.0f);
+    EXPECT_TRUE(CGPathIsEmpty(buttDot));
+
+    CGPathRelease(buttDot);
+    CGPathRelease(roundDot);
+    CGPathRelease(dot);
+    CGPathRelease(round);
+    CGPathRelease(square);
+    CGPathRelease(butt);
+    CGPathRelease(line);
+}
+
+TEST(CGPath, CGPathCreateCopyByStrokingPathJoins) {
+    //  A right-angled corner, turning right at (100, 0)
+    CGMutablePathRef corner = CGPathCreateMutable();
+    CGPathMoveToPoint(corner, NULL, 0.0f, 0.0f);
+    CGPathAddLineToPoint(corner, NULL, 100.0f, 0.0f);
+    CGPathAddLineToPoint(corner, NULL, 100.0f, -100.0f);
+
+    CGPathRef miter = CGPathCreateCopyByStrokingPath(corner, NULL, 10.0f, kCGLineCapButt, kCGLineJoinMiter, 10.0f);
+    EXPECT_TRUE(CGPathContainsPoint(miter, NULL, CGPointMake(104.0f, 4.0f), NO));
+    EXPECT_TRUE(CGPathContainsPoint(miter, NULL, CGPointMake(96.0f, -4.0f), NO));
+    EXPECT_FALSE(CGPathContainsPoint(miter, NULL, CGPointMake(90.0f, -10.0f), NO));
+    EXPECT_FALSE(CGPathContainsPoint(miter, NULL, CGPointMake(106.0f, 6.0f), NO));
+
+    //  The miter is sqrt(2) times the line width, so a lower limit bevels it
+    CGPathRef limited = CGPathCreateCopyByStrokingPath(corner, NULL, 10.0f, kCGLineCapButt, kCGLineJoinMiter, 1.4f);
+    EXPECT_FALSE(CGPathContainsPoint(limited, NULL, CGPointMake(104.0f, 4.0f), NO));
+    EXPECT_TRUE(CGPathContainsPoint(limited, NULL, CGPointMake(102.0f, 2.0f), NO));
+
+    CGPathRef bevel = CGPathCreateCopyByStrokingPath(corner, NULL, 10.0f, kCGLineCapButt, kCGLineJoinBevel, 10.0f);
+    EXPECT_FALSE(CGPathContainsPoint(bevel, NULL, CGPointMake(104.0f, 4.0f), NO));
+    EXPECT_TRUE(CGPathContainsPoint(bevel, NULL, CGPointMake(102.0f, 2.0f), NO));
+
+    CGPathRef round = CGPathCreateCopyByStrokingPath(corner, NULL, 10.0f, kCGLineCapButt, kCGLineJoinRound, 10.0f);
+    EXPECT_FALSE(CGPathContainsPoint(round, NULL, CGPointMake(104.0f, 4.0f), NO));
+    EXPECT_TRUE(CGPathContainsPoint(round, NULL, CGPointMake(103.0f, 3.0f), NO));
+
+    //  A closed rectangle's stroke leaves its middle empty, and is mitered at every corner
+    CGPathRef rect = CGPathCreateWithRect(CGRectMake(0.0f, 0.0f, 100.0f, 100.0f), NULL);
+    CGPathRef outline = CGPathCreateCopyByStrokingPath(rect, NULL, 10.0f, kCGLineCapButt, kCGLineJoinMiter, 10.0f);
+    EXPECT_TRUE(CGPathContainsPoint(outline, NULL, CGPointMake(-4.0f, 50.0f), NO));
+    EXPECT_TRUE(CGPathContainsPoint(outline, NULL, CGPointMake(4.0f, 50.0f), NO));
+    EXPECT_TRUE(CGPathContainsPoint(outline, NULL, CGPointMake(-4.0f, -4.0f), NO));
+    EXPECT_TRUE(CGPathContainsPoint(outline, NULL, CGPointMake(104.0f, 104.0f), NO));
+    EXPECT_FALSE(CGPathContainsPoint(outline, NULL, CGPointMake(50.0f, 50.0f), NO));
+    EXPECT_FALSE(CGPathContainsPoint(outline, NULL, CGPointMake(-6.0f, 50.0f), NO));
+
+    CGPathRelease(outline);
+    CGPathRelease(rect);
+    CGPathRelease(round);
+    CGPathRelease(bevel);
+    CGPathRelease(limited);
+    CGPathRelease(miter);
+    CGPathRelease(corner);
+}
+
+TEST(CGPath, CGPathCreateCopyByStrokingPathCurves) {
+    CGPathRef circle = CGPathCreateWithEllipseInRect(CGRectMake(0.0f, 0.0f, 200.0f, 200.0f), NULL);
+    const CGAffineTransform transform = CGAffineTransformMakeTranslation(50.0f, 50.0f);
+    CGPathRef ring = CGPathCreateCopyByStrokingPath(circle, &transform, 4.0f, kCGLineCapButt, kCGLineJoinBevel, 10.0f);
+
+    //  The ring's edges are within the flattening tolerance of radii 98 and 102, all the way round
+    for (int i = 0; i < 16; ++i) {
+        const float angle = 2.0f * M_PI * i / 16;
+        for (float radius : { 98.5f, 100.0f, 101.5f }) {
+            EXPECT_TRUE(CGPathContainsPoint(ring, NULL, CGPointMake(150.0f + radius * cosf(angle), 150.0f + radius * sinf(angle)), NO));
+        }
+        for (float radius : { 97.5f, 102.5f }) {
+            EXPECT_FALSE(CGPathContainsPoint(ring, NULL, CGPointMake(150.0f + radius * cosf(angle), 150.0f + radius * sinf(angle)), NO));
+        }
+    }
+
+    CGPathRelease(ring);
+    CGPathRelease(circle);
+}
+
+static CGMutablePathRef createClosedPolygon(const std::vector<CGPoint>& polygon) {
+    CGMutablePathRef path = CGPathCreateMutable();
+    CGPathMoveToPoint(path, NULL, polygon[0].x, polygon[0].y);
+    for (size_t i = 1; i < polygon.size(); ++i) {
+        CGPathAddLineToPoint(path, NULL, polygon[i].x, polygon[i].y);
+    }
+    CGPathCloseSubpath(path);
+    return path;
+}
+
+// The distance from point to the nearest of the lines around a closed polygon. Without the corners, only points level
+// with the inside of some line are measured, which is all a miter or bevel join is sure to cover.
+static double distanceToPolygon(CGPoint point, const std::vector<CGPoint>& polygon, bool corners) {
+    double nearest = INFINITY;
+    for (size_t i = 0; i < polygon.size(); ++i) {
+        const CGPoint from = polygon[i];
+        const CGPoint to = polygon[(i + 1) % polygon.size()];
+        const double dx = to.x - from.x;
+        const double dy = to.y - from.y;
+        double along = ((point.x - from.x) * dx + (point.y - from.y) * dy) / (dx * dx + dy * dy);
+        if (!corners && (along < 0.001 || along > 0.999)) {
+            continue;
+        }
+        along = std::max(0.0, std::min(1.0, along));
+        nearest = std::min(nearest, hypot(point.x - (from.x + along * dx), point.y - (from.y + along * dy)));
+    }
+    return nearest;
+}
+
+// Every point of a grid that is well within half the line width of the polygon's outline should be stroked, corners
+// included for round joins
+static void expectStrokeCovers(const std::vector<CGPoint>& polygon, CGFloat lineWidth, CGLineJoin join) {
+    CGMutablePathRef path = createClosedPolygon(polygon);
+    CGPathRef stroked = CGPathCreateCopyByStrokingPath(path, NULL, lineWidth, kCGLineCapButt, join, 10.0f);
+
+    const CGRect bounds = CGRectInset(CGPathGetBoundingBox(path), -lineWidth, -lineWidth);
+    for (CGFloat x = CGRectGetMinX(bounds); x <= CGRectGetMaxX(bounds); x += 0.25f) {
+        for (CGFloat y = CGRectGetMinY(bounds); y <= CGRectGetMaxY(bounds); y += 0.25f) {
+            const CGPoint point = CGPointMake(x, y);
+            if (distanceToPolygon(point, polygon, join == kCGLineJoinRound) < 0.45 * lineWidth) {
+                EXPECT_TRUE(CGPathContainsPoint(stroked, NULL, point, NO)) << "(" << x << ", " << y << ") with join " << join;
+            }
+        }
+    }
+
+    CGPathRelease(stroked);
+    CGPathRelease(path);
+}
+
+TEST(CGPath, CGPathCreateCopyByStrokingPathCoversSmallClosedShapes) {
+    //  A triangle whose inner offset lines overshoot each other at every corner
+    const std::vector<CGPoint> triangle = { CGPointMake(4.0f, 7.0f), CGPointMake(5.0f, 1.0f), CGPointMake(0.0f, 4.0f) };
+
+    //  A line there and back, which turns straight round at either end
+    const std::vector<CGPoint> reversal = { CGPointMake(16.0f, 1.0f), CGPointMake(0.0f, 9.0f) };
+
+    for (CGLineJoin join : { kCGLineJoinMiter, kCGLineJoinRound, kCGLineJoinBevel }) {
+        expectStrokeCovers(triangle, 4.0f, join);
+        expectStrokeCovers(reversal, 2.0f, join);
+    }
+
+    CGMutablePathRef trianglePath = createClosedPolygon(triangle);
+    CGPathRef triangleStroke = CGPathCreateCopyByStrokingPath(trianglePath, NULL, 4.0f, kCGLineCapButt, kCGLineJoinMiter, 10.0f);
+    EXPECT_TRUE(CGPathContainsPoint(triangleStroke, NULL, CGPointMake(2.87f, 4.1f), NO));
+
+    //  A round join at a reversal rounds off the end like a round cap
+    CGMutablePathRef reversalPath = createClosedPolygon(reversal);
+    CGPathRef reversalStroke = CGPathCreateCopyByStrokingPath(reversalPath, NULL, 2.0f, kCGLineCapButt, kCGLineJoinRound, 10.0f);
+    EXPECT_TRUE(CGPathContainsPoint(reversalStroke, NULL, CGPointMake(0.59f, 9.36f), NO));
+    EXPECT_FALSE(CGPathContainsPoint(reversalStroke, NULL, CGPointMake(-1.1f, 9.55f), NO));
+
+    CGPathRelease(reversalStroke);
+    CGPathRelease(reversalPath);
+    CGPathRelease(triangleStroke);
+    CGPathRelease(trianglePath);
+}
+
+TEST(CGPath, CGPathCreateCopyByDashingPath) {
+    CGMutablePathRef line = CGPathCreateMutable();
+    CGPathMoveToPoint(line, NULL, 0.0f, 0.0f);
+    CGPathAddLineToPoint(line, NULL, 100.0f, 0.0f);
+
+    //  Dashes at 0, 15, 30, ... 90
+    const CGFloat lengths[] = { 10.0f, 5.0f };
+    CGPathRef dashed = CGPathCreateCopyByDashingPath(line, NULL, 0.0f, lengths, 2);
+    int dashes = 0;
+    CGPathApply(dashed, &dashes, cgPathMoveCountApplierFunction);
+    EXPECT_EQ(7, dashes);
+
+    //  The phase shortens the first dash
+    CGPathRef shifted = CGPathCreateCopyByDashingPath(line, NULL, 5.0f, lengths, 2);
+    std::vector<CGPoint> points;
+    CGPathApply(shifted, &points, cgPathPointApplierFunction);
+    ASSERT_EQ(14u, points.size());
+    EXPECT_FLOAT_EQ(0.0f, points[0].x);
+    EXPECT_FLOAT_EQ(5.0f, points[1].x);
+    EXPECT_FLOAT_EQ(10.0f, points[2].x);
+    EXPECT_FLOAT_EQ(95.0f, points[13].x);
+
+    //  An odd number of lengths is drawn and skipped in turn
+    const CGFloat single[] = { 10.0f };
+    CGPathRef even = CGPathCreateCopyByDashingPath(line, NULL, 0.0f, single, 1);
+    dashes = 0;
+    CGPathApply(even, &dashes, cgPathMoveCountApplierFunction);
+    EXPECT_EQ(5, dashes);
+
+    CGPathRef stroked = CGPathCreateCopyByStrokingPath(even, NULL, 2.0f, kCGLineCapButt, kCGLineJoinMiter, 10.0f);
+    EXPECT_TRUE(CGPathContainsPoint(stroked, NULL, CGPointMake(5.0f, 0.5f), NO));
+    EXPECT_FALSE(CGPathContainsPoint(stroked, NULL, CGPointMake(15.0f, 0.5f), NO));
+
+    //  A closed subpath's dashes run on around its start
+    CGPathRef rect = CGPathCreateWithRect(CGRectMake(0.0f, 0.0f, 100.0f, 100.0f), NULL);
+    const CGFloat rectLengths[] = { 30.0f, 20.0f };
+    CGPathRef dashedRect = CGPathCreateCopyByDashingPath(rect, NULL, 10.0f, rectLengths, 2);
+    dashes = 0;
+    CGPathApply(dashedRect, &dashes, cgPathMoveCountApplierFunction);
+    EXPECT_EQ(8, dashes);
+
+    //  Without a usable pattern, the path is copied
+    const CGFloat zeros[] = { 0.0f, 0.0f };
+    CGPathRef undashed = CGPathCreateCopyByDashingPath(line, NULL, 0.0f, zeros, 2);
+    EXPECT_TRUE(CGPathEqualToPath(line, undashed));
+
+    CGPathRelease(undashed);
+    CGPathRelease(dashedRect);
+    CGPathRelease(rect);
+    CGPathRelease(stroked);
+    CGPathRelease(even);
+    CGPathRelease(shifted);
+    CGPathRelease(dashed);
+    CGPathRelease(line);
+}
+
+TEST(CGPath, CGPathStrokingPerformance) {
+    //  A spiral of 1000 curves, each turning a little further than the last
+    CGMutablePathRef path = CGPathCreateMutable();
+    CGPathMoveToPoint(path, NULL, 1000.0f, 1000.0f);
+    for (int i = 1; i <= 1000; ++i) {
+        const float angle = 0.1f * i;
+        const float radius = 0.9f * i;
+        CGPathAddQuadCurveToPoint(path,
+                                  NULL,
+                                  1000.0f + radius * cosf(angle - 0.05f),
+                                  1000.0f + radius * sinf(angle - 0.05f),
+                                  1000.0f + radius * cosf(angle),
+                                  1000.0f + radius * sinf(angle));
+    }
+
+    const CGFloat lengths[] = { 20.0f, 10.0f };
+    const int c_iterations = 10;
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < c_iterations; ++i) {
+        CGPathRef stroked = CGPathCreateCopyByStrokingPath(path, NULL, 6.0f, kCGLineCapRound, kCGLineJoinRound, 10.0f);
+        EXPECT_FALSE(CGPathIsEmpty(stroked));
+        CGPathRelease(stroked);
+    }
+    const double strokeMicroseconds =
+        std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count() / c_iterations;
+
+    start = std::chrono::steady_clock::now();
+    for (int i = 0; i < c_iterations; ++i) {
+        CGPathRef dashed = CGPathCreateCopyByDashingPath(path, NULL, 0.0f, lengths, 2);
+        EXPECT_FALSE(CGPathIsEmpty(dashed));
+        CGPathRelease(dashed);
+    }
+    const double dashMicroseconds =
+        std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count() / c_iterations;
+
+    LOG_INFO("1000 curve path: stroked in %.0f us, dashed in %.0f us", strokeMicroseconds, dashMicroseconds);
+
+    CGPathRelease(path);
+}
@@ -0,0 +1,244 @@
+//******************************************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+//
+// This code is licensed under the MIT License (MIT).
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+//******************************************************************************
+
+#import <TestFramework.h>
+#import "CGPixelConverters.h"
+
+#import <math.h>
+#import <vector>
+
+// Every vector width leaves a different tail for the scalar loop, so rows are converted at each length up to this one
+static const size_t c_maxRowPixels = 37;
+
+static std::vector<uint8_t> patternBytes(size_t count) {
+    std::vector<uint8_t> bytes(count);
+    uint32_t state = 12345;
+    for (uint8_t& byte : bytes) {
+        state = state * 1103515245 + 12345;
+        byte = static_cast<uint8_t>(state >> 16);
+    }
+    return bytes;
+}
+
+TEST(CGPixelConverters, SwapRedBlue) {
+    for (size_t count = 0; count <= c_maxRowPixels; ++count) {
+        const std::vector<uint8_t> src = patternBytes(4 * count);
+        std::vector<uint8_t> dest(4 * count);
+        _CGPixelSwapRedBlue32(dest.data(), src.data(), count);
+
+        for (size_t i = 0; i < count; ++i) {
+            EXPECT_EQ(src[4 * i + 2], dest[4 * i]);
+            EXPECT_EQ(src[4 * i + 1], dest[4 * i + 1]);
+            EXPECT_EQ(src[4 * i], dest[4 * i + 2]);
+            EXPECT_EQ(src[4 * i + 3], dest[4 * i + 3]);
+        }
+
+        //  In place, twice, is where it started
+        _CGPixelSwapRedBlue32(dest.data(), dest.data(), count);
+        EXPECT_TRUE(src == dest);
+    }
+}
+
+TEST(CGPixelConverters, PremultiplyMatchesExactRounding) {
+    //  Every color against every alpha, in one row
+    std::vector<uint8_t> src(4 * 256 * 256);
+    for (size_t i = 0; i < 256 * 256; ++i) {
+        src[4 * i] = static_cast<uint8_t>(i & 0xFF);
+        src[4 * i + 1] = static_cast<uint8_t>(255 - (i & 0xFF));
+        src[4 * i + 2] = static_cast<uint8_t>(i * 7);
+        src[4 * i + 3] = static_cast<uint8_t>(i >> 8);
+    }
+
+    std::vector<uint8_t> dest(src.size());
+    _CGPixelPremultiply32(dest.data(), src.data(), 256 * 256);
+    for (size_t i = 0; i < src.size(); ++i) {
+        const unsigned int alpha = src[i | 3];
+        const unsigned int expected = ((i & 3) == 3) ? alpha : static_cast<unsigned int>(floor(src[i] * alpha / 255.0 + 0.5));
+        ASSERT_EQ(expected, dest[i]) << "at byte " << i;
+    }
+
+    for (size_t count = 0; count <= c_maxRowPixels; ++count) {
+        std::vector<uint8_t> row(src.begin() + 4 * 1000, src.begin() + 4 * (1000 + count));
+        _CGPixelPremultiply32(row.data(), row.data(), count);
+        EXPECT_TRUE(std::equal(row.begin(), row.end(), dest.begin() + 4 * 1000));
+    }
+}
+
+TEST(CGPixelConverters, UnpremultiplyRoundTrips) {
+    std::vector<uint8_t> straight = patternBytes(4 * 4096);
+    for (size_t i = 0; i < 4096; ++i) {
+        //  Runs of opaque and clear pixels, between translucent ones
+        if ((i / 8) % 3 == 0) {
+            straight[4 * i + 3] = 0xFF;
+        } else if ((i / 8) % 3 == 1) {
+            straight[4 * i + 3] = 0;
+        }
+    }
+
+    std::vector<uint8_t> premultiplied(straight.size());
+    _CGPixelPremultiply32(premultiplied.data(), straight.data(), 4096);
+    std::vector<uint8_t> unpremultiplied(straight.size());
+    _CGPixelUnpremultiply32(unpremultiplied.data(), premultiplied.data(), 4096);
+
+    for (size_t i = 0; i < 4096; ++i) {
+        const unsigned int alpha = straight[4 * i + 3];
+        ASSERT_EQ(alpha, unpremultiplied[4 * i + 3]);
+        for (size_t c = 0; c < 3; ++c) {
+            if (alpha == 0) {
+                EXPECT_EQ(0, unpremultiplied[4 * i + c]);
+            } else {
+                //  Premultiplying loses up to half a step of 1 / alpha
+                EXPECT_LE(abs(static_cast<int>(unpremultiplied[4 * i + c]) - straight[4 * i + c]), static_cast<int>(128 / alpha) + 1);
+            }
+        }
+    }
+
+    //  Premultiplied pixels unpremultiply and premultiply back to themselves
+    std::vector<uint8_t> again(straight.size());
+    _CGPixelPremultiply32(again.data(), unpremultiplied.data(), 4096);
+    EXPECT_TRUE(again == premultiplied);
+}
+
+TEST(CGPixelConverters, IsOpaque) {
+    for (size_t count = 0; count <= c_maxRowPixels; ++count) {
+        std::vector<uint8_t> pixels(4 * count, 0x80);
+        for (size_t i = 0; i < count; ++i) {
+            pixels[4 * i + 3] = 0xFF;
+        }
+        EXPECT_TRUE(_CGPixelIsOpaque32(pixels.data(), count));
+
+        for (size_t i = 0; i < count; ++i) {
+            pixels[4 * i + 3] = 0xFE;
+            EXPECT_FALSE(_CGPixelIsOpaque32(pixels.data(), count));
+            pixels[4 * i + 3] = 0xFF;
+        }
+    }
+}
+
+TEST(CGPixelConverters, GrayToRGBA) {
+    for (size_t count = 0; count <= c_maxRowPixels; ++count) {
+        const std::vector<uint8_t> src = patternBytes(count);
+        std::vector<uint8_t> dest(4 * count);
+        _CGPixelGrayToRGBA(dest.data(), src.data(), count);
+
+        for (size_t i = 0; i < count; ++i) {
+            EXPECT_EQ(src[i], dest[4 * i]);
+            EXPECT_EQ(src[i], dest[4 * i + 1]);
+            EXPECT_EQ(src[i], dest[4 * i + 2]);
+            EXPECT_EQ(0xFF, dest[4 * i + 3]);
+        }
+    }
+}
+
+TEST(CGPixelConverters, Narrow16RoundsToNearest) {
+    std::vector<uint8_t> bigEndian(2 * 65536);
+    std::vector<uint8_t> littleEndian(2 * 65536);
+    for (size_t value = 0; value < 65536; ++value) {
+        bigEndian[2 * value] = littleEndian[2 * value + 1] = static_cast<uint8_t>(value >> 8);
+        bigEndian[2 * value + 1] = littleEndian[2 * value] = static_cast<uint8_t>(value);
+    }
+
+    std::vector<uint8_t> fromBig(65536);
+    std::vector<uint8_t> fromLittle(65536);
+    _CGPixelNarrow16<true>(fromBig.data(), bigEndian.data(), 65536);
+    _CGPixelNarrow16<false>(fromLittle.data(), littleEndian.data(), 65536);
+    for (size_t value = 0; value < 65536; ++value) {
+        const unsigned int expected = static_cast<unsigned int>(floor(value / 257.0 + 0.5));
+        ASSERT_EQ(expected, fromBig[value]) << "for " << value;
+        ASSERT_EQ(expected, fromLittle[value]) << "for " << value;
+    }
+
+    for (size_t count = 0; count <= c_maxRowPixels; ++count) {
+        std::vector<uint8_t> dest(count + 1, 0xCC);
+        _CGPixelNarrow16<true>(dest.data(), &bigEndian[2 * 40000], count);
+        EXPECT_TRUE(std::equal(dest.begin(), dest.begin() + count, fromBig.begin() + 40000));
+        EXPECT_EQ(0xCC, dest[count]);
+    }
+}
+
+TEST(CGPixelConverters, Expand565) {
+    const uint16_t pixels[] = { 0x0000, 0xFFFF, 0xF800, 0x07E0, 0x001F, 0x0821 };
+    const uint8_t expected[][3] = { { 0, 0, 0 }, { 255, 255, 255 }, { 255, 0, 0 }, { 0, 255, 0 }, { 0, 0, 255 }, { 15, 7, 15 } };
+
+    uint8_t dest[sizeof(expected)];
+    _CGPixel565ToRGB(dest, reinterpret_cast<const uint8_t*>(pixels), _countof(pixels));
+    EXPECT_EQ(0, memcmp(dest, expected, sizeof(expected)));
+}
+
+TEST(CGPixelConverters, ExpandPalette) {
+    const uint8_t colors[] = { 10, 20, 30, 40, 50, 60, 70, 80, 90 };
+    CGPixelPalette palette(colors, 3);
+
+    for (size_t count = 0; count <= c_maxRowPixels; ++count) {
+        std::vector<uint8_t> src(count);
+        for (size_t i = 0; i < count; ++i) {
+            src[i] = static_cast<uint8_t>(i * 3 % 5);
+        }
+
+        //  The byte past the last pixel must not be written
+        std::vector<uint8_t> dest(3 * count + 1, 0xCC);
+        _CGPixelExpandPalette(dest.data(), src.data(), count, palette);
+        for (size_t i = 0; i < count; ++i) {
+            for (size_t c = 0; c < 3; ++c) {
+                EXPECT_EQ(src[i] <= 2 ? colors[3 * src[i] + c] : 0, dest[3 * i + c]);
+            }
+        }
+        EXPECT_EQ(0xCC, dest[3 * count]);
+    }
+}
+
+TEST(CGPixelConverters, FilterPNGRowPicksSmallestSum) {
+    for (size_t bpp : { 1, 3, 4 }) {
+        for (size_t rowBytes = bpp; rowBytes <= 4 * c_maxRowPixels; rowBytes += bpp) {
+            //  Smooth rows favor the predicting filters, noisy ones None
+            std::vector<uint8_t> prior = patternBytes(rowBytes + 7);
+            prior.erase(prior.begin(), prior.begin() + 7);
+            std::vector<uint8_t> row(rowBytes);
+            for (size_t i = 0; i < rowBytes; ++i) {
+                row[i] = (rowBytes % 3 == 0) ? prior[i] : static_cast<uint8_t>(prior[i] + i / bpp);
+            }
+            if (rowBytes % 5 == 0) {
+                row = patternBytes(rowBytes);
+            }
+
+            std::vector<uint8_t> candidates(4 * rowBytes);
+            std::vector<uint8_t> out(rowBytes + 1);
+            _CGPixelFilterPNGRow(row.data(), prior.data(), rowBytes, bpp, candidates.data(), out.data());
+
+            std::vector<uint8_t> expected[5];
+            size_t best = 0;
+            size_t bestSum = SIZE_MAX;
+            for (size_t filter = 0; filter < 5; ++filter) {
+                size_t sum = 0;
+                for (size_t i = 0; i < rowBytes; ++i) {
+                    const int a = (i >= bpp) ? row[i - bpp] : 0;
+                    const int b = prior[i];
+                    const int c = (i >= bpp) ? prior[i - bpp] : 0;
+                    const int predictors[5] = { 0, a, b, (a + b) / 2, _CGPixelPaethPredictor(a, b, c) };
+                    expected[filter].push_back(static_cast<uint8_t>(row[i] - predictors[filter]));
+                    sum += abs(static_cast<int8_t>(expected[filter].back()));
+                }
+                if (sum < bestSum) {
+                    best = filter;
+                    bestSum = sum;
+                }
+            }
+
+            ASSERT_EQ(best, out[0]) << "bpp " << bpp << ", " << rowBytes << " bytes";
+            EXPECT_TRUE(std::equal(expected[best].begin(), expected[best].end(), out.begin() + 1));
+        }
+    }
+}
@@ -18,6 +18,9 @@
 #import <UIKit/UIKit.h>
 #include <TestFramework.h>
 #import <CoreFoundation/CoreFoundation.h>
+#import "CGFontInternal.h"
+
+#include <vector>
 
 static NSAttributedString* getMultilineAttributedString() {
     UIFontDescriptor* fontDescriptor = [UIFontDescriptor fontDescriptorWithName:@"Times New Roman" size:40];
@@ -78,4 +81,69 @@ TEST(CTTypeSetter, LinesShouldDefaultToZeroOffset) {
     EXPECT_EQ(ascentWithOffset, ascent);
     EXPECT_EQ(descentWithOffset, descent);
     EXPECT_EQ(leadingWithOffset, leading);
-}
\ No newline at end of file
+}
+
+// Advance of one character measured by the font itself, without going through any typesetter
+static CGFloat _measuredAdvance(UIFont* font, unichar character) {
+    if (character == '\n' || character == '\r') {
+        return 0;
+    }
+
+    //  The typesetter lays tabs out as spaces
+    unsigned short glyphCharacter = (character == '\t') ? ' ' : character;
+    unsigned short glyph = 0;
+    CGFontGetGlyphs(font, &glyphCharacter, 1, &glyph);
+    return CTFontGetAdvancesForGlyphs((__bridge CTFontRef)font, kCTFontHorizontalOrientation, &glyph, nullptr, 1);
+}
+
+TEST(CTTypeSetter, RelayoutMatchesMeasuredAdvances) {
+    UIFont* font = [UIFont fontWithDescriptor:[UIFontDescriptor fontDescriptorWithName:@"Times New Roman" size:40] size:40];
+    UIFont* smallFont = [UIFont fontWithDescriptor:[UIFontDescriptor fontDescriptorWithName:@"Times New Roman" size:20] size:20];
+
+    //  Latin-1 and other characters, across runs of two sizes of one face
+    NSMutableAttributedString* string = [[[NSMutableAttributedString alloc]
+        initWithString:@"the quick\tbrown fox \u03A9\u00E9\u4E2D jumps over the lazy dog\nand keeps going"] autorelease];
+    [string addAttribute:NSFontAttributeName value:font range:NSMakeRange(0, 20)];
+    [string addAttribute:NSFontAttributeName value:smallFont range:NSMakeRange(20, [string length] - 20)];
+    NSString* text = [string string];
+
+    //  Laying the same typesetter out again at other widths reuses the advances measured the first time
+    CTTypesetterRef ts = CTTypesetterCreateWithAttributedString((__bridge CFAttributedStringRef)string);
+    for (double width : { 50.0, 100.0, 250.0, 1000.0, 50.0 }) {
+        CFIndex start = 0;
+        while (start < static_cast<CFIndex>([text length])) {
+            CFIndex end = CTTypesetterSuggestLineBreak(ts, start, width);
+            EXPECT_GT(end, start);
+            if (end <= start) {
+                break;
+            }
+
+            CTLineRef line = CTTypesetterCreateLine(ts, CFRangeMake(start, end - start));
+            CGFloat lineWidth = 0;
+            for (id run in (__bridge NSArray*)CTLineGetGlyphRuns(line)) {
+                CTRunRef ctRun = (__bridge CTRunRef)run;
+                UIFont* runFont = (UIFont*)CFDictionaryGetValue(CTRunGetAttributes(ctRun), kCTFontAttributeName);
+                CFRange range = CTRunGetStringRange(ctRun);
+
+                std::vector<CGSize> advances(range.length);
+                CTRunGetAdvances(ctRun, CFRangeMake(0, 0), advances.data());
+                for (CFIndex i = 0; i < range.length; ++i) {
+                    EXPECT_NEAR_MSG(_measuredAdvance(runFont, [text characterAtIndex:range.location + i]),
+                                    advances[i].width,
+                                    0.01,
+                                    "character %d at width %f",
+                                    static_cast<int>(range.location + i),
+                                    width);
+                    lineWidth += advances[i].width;
+                }
+            }
+
+            EXPECT_NEAR(lineWidth, CTLineGetTypographicBounds(line, nullptr, nullptr, nullptr), 0.1);
+            CFRelease(line);
+
+            start = end;
+        }
+    }
+
+    CFRelease(ts);
+}
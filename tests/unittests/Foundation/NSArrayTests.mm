@@ -17,6 +17,8 @@
 #include <TestFramework.h>
 #include <Foundation/Foundation.h>
 
+#include <chrono>
+
 void assertArrayContents(NSArray* array, NSObject* first, ...) {
     va_list args;
     va_start(args, first);
@@ -411,3 +413,143 @@ TEST(NSArray, SortedArrayWithOptions) {
 
     ASSERT_OBJCEQ(expectedStableSort, actualStableSort);
 }
+
+static NSArray* _sortTestRecords(NSUInteger count) {
+    NSMutableArray* records = [NSMutableArray arrayWithCapacity:count];
+    uint32_t seed = 12345;
+    for (NSUInteger i = 0; i < count; ++i) {
+        seed = seed * 1664525 + 1013904223;
+        [records addObject:@{ @"group" : @((seed >> 8) % 100), @"serial" : @(i) }];
+    }
+
+    return records;
+}
+
+TEST(NSArray, SortUsingDescriptors) {
+    NSArray* records = _sortTestRecords(2000);
+    NSArray* descriptors = @[
+        [NSSortDescriptor sortDescriptorWithKey:@"group" ascending:YES],
+        [NSSortDescriptor sortDescriptorWithKey:@"serial"
+                                      ascending:NO
+                                     comparator:^NSComparisonResult(id obj1, id obj2) {
+                                         return [obj1 compare:obj2];
+                                     }]
+    ];
+
+    NSArray* sorted = [records sortedArrayUsingDescriptors:descriptors];
+    ASSERT_EQ([records count], [sorted count]);
+
+    for (NSUInteger i = 1; i < [sorted count]; ++i) {
+        NSInteger group1 = [sorted[i - 1][@"group"] integerValue];
+        NSInteger group2 = [sorted[i][@"group"] integerValue];
+        ASSERT_LE(group1, group2);
+        if (group1 == group2) {
+            ASSERT_GT([sorted[i - 1][@"serial"] integerValue], [sorted[i][@"serial"] integerValue]);
+        }
+    }
+
+    //  A descriptor without a key compares the objects themselves
+    NSMutableArray* numbers = [NSMutableArray arrayWithObjects:@3, @1, @2, nil];
+    [numbers sortUsingDescriptors:@[ [NSSortDescriptor sortDescriptorWithKey:nil ascending:NO] ]];
+    ASSERT_OBJCEQ((@[ @3, @2, @1 ]), numbers);
+}
+
+TEST(NSArray, SortIsStable) {
+    //  Large enough for a concurrent sort to split the records into several chunks and merge them
+    NSArray* records = _sortTestRecords(20000);
+    NSComparator byGroup = ^NSComparisonResult(id obj1, id obj2) {
+        return [obj1[@"group"] compare:obj2[@"group"]];
+    };
+
+    for (NSArray* sorted in @[
+             [records sortedArrayUsingComparator:byGroup],
+             [records sortedArrayWithOptions:NSSortStable usingComparator:byGroup],
+             [records sortedArrayWithOptions:NSSortConcurrent | NSSortStable usingComparator:byGroup]
+         ]) {
+        ASSERT_EQ([records count], [sorted count]);
+        for (NSUInteger i = 1; i < [sorted count]; ++i) {
+            NSComparisonResult order = byGroup(sorted[i - 1], sorted[i]);
+            ASSERT_NE(NSOrderedDescending, order);
+            if (order == NSOrderedSame) {
+                ASSERT_LT([sorted[i - 1][@"serial"] integerValue], [sorted[i][@"serial"] integerValue]);
+            }
+        }
+    }
+}
+
+TEST(NSArray, SortConcurrent) {
+    const NSUInteger count = 100000;
+    NSMutableArray* numbers = [NSMutableArray arrayWithCapacity:count];
+    for (NSUInteger i = 0; i < count; ++i) {
+        [numbers addObject:@((i * 7919) % count)];
+    }
+
+    [numbers sortWithOptions:NSSortConcurrent
+             usingComparator:^NSComparisonResult(id obj1, id obj2) {
+                 return [obj1 compare:obj2];
+             }];
+
+    ASSERT_EQ(count, [numbers count]);
+    for (NSUInteger i = 0; i < count; ++i) {
+        ASSERT_EQ(i, [numbers[i] unsignedIntegerValue]);
+    }
+}
+
+TEST(NSArray, SortConcurrentComparatorThrows) {
+    const NSUInteger count = 20000;
+    NSMutableArray* numbers = [NSMutableArray arrayWithCapacity:count];
+    for (NSUInteger i = 0; i < count; ++i) {
+        [numbers addObject:@(count - i)];
+    }
+
+    NSArray* original = [[numbers copy] autorelease];
+    EXPECT_ANY_THROW([numbers sortWithOptions:NSSortConcurrent
+                              usingComparator:^NSComparisonResult(id obj1, id obj2) {
+                                  if ([obj1 unsignedIntegerValue] == count / 2 || [obj2 unsignedIntegerValue] == count / 2) {
+                                      [NSException raise:NSInvalidArgumentException format:@"Uncomparable"];
+                                  }
+
+                                  return [obj1 compare:obj2];
+                              }]);
+
+    ASSERT_OBJCEQ(original, numbers);
+}
+
+TEST(NSArray, SortRange) {
+    NSMutableArray* numbers = [NSMutableArray arrayWithObjects:@9, @5, @4, @3, @1, @0, nil];
+    [numbers sortUsingFunction:[](id obj1, id obj2, void* context) -> NSInteger { return [obj1 compare:obj2]; }
+                       context:nullptr
+                         range:NSMakeRange(1, 4)];
+    ASSERT_OBJCEQ((@[ @9, @1, @3, @4, @5, @0 ]), numbers);
+}
+
+// Logs how long sorting 100,000 records takes through descriptors and through a comparator, serially and concurrently.
+TEST(NSArray, SortPerformance) {
+    NSArray* records = _sortTestRecords(100000);
+    NSArray* descriptors =
+        @[ [NSSortDescriptor sortDescriptorWithKey:@"group" ascending:YES], [NSSortDescriptor sortDescriptorWithKey:@"serial" ascending:NO] ];
+    NSComparator comparator = ^NSComparisonResult(id obj1, id obj2) {
+        NSComparisonResult result = [obj1[@"group"] compare:obj2[@"group"]];
+        return (result != NSOrderedSame) ? result : [obj2[@"serial"] compare:obj1[@"serial"]];
+    };
+
+    auto start = std::chrono::steady_clock::now();
+    NSArray* byDescriptors = [records sortedArrayUsingDescriptors:descriptors];
+    auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start);
+    LOG_INFO("sortedArrayUsingDescriptors: %lld ms for %u records.", static_cast<long long>(elapsed.count()), [records count]);
+
+    start = std::chrono::steady_clock::now();
+    NSArray* byComparator = [records sortedArrayUsingComparator:comparator];
+    elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start);
+    LOG_INFO("sortedArrayUsingComparator: %lld ms for %u records.", static_cast<long long>(elapsed.count()), [records count]);
+
+    start = std::chrono::steady_clock::now();
+    NSArray* concurrent = [records sortedArrayWithOptions:NSSortConcurrent usingComparator:comparator];
+    elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start);
+    LOG_INFO("sortedArrayWithOptions:NSSortConcurrent: %lld ms for %u records.",
+             static_cast<long long>(elapsed.count()),
+             [records count]);
+
+    ASSERT_OBJCEQ(byDescriptors, byComparator);
+    ASSERT_OBJCEQ(byComparator, concurrent);
+}
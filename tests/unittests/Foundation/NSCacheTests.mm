@@ -19,6 +19,10 @@
 #import <Starboard/SmartTypes.h>
 #include <windows.h>
 
+#include <atomic>
+#include <thread>
+#include <vector>
+
 #define TEST_PREFIX Foundation_NSCache_Tests
 #define _CONCAT(x, y) x##y
 #define CONCAT(x, y) _CONCAT(x, y)
@@ -117,6 +121,78 @@ TEST(NSCache, CostEviction) {
     EXPECT_OBJCNE(nil, [cache objectForKey:@(1000)]);
 }
 
+TEST(NSCache, CostEvictionSkipsFreeEntries) {
+    NSCache* cache = nil;
+    ASSERT_NO_THROW(cache = [[NSCache new] autorelease]);
+    ASSERT_NO_THROW(cache.totalCostLimit = 100);
+
+    // Free entries are older than every costed one, but can never bring the cache under its cost limit.
+    for (int i = 0; i < 100; ++i) {
+        EXPECT_NO_THROW([cache setObject:@(i) forKey:@(i)]);
+    }
+
+    EXPECT_NO_THROW([cache setObject:@"a" forKey:@"a" cost:60]);
+    EXPECT_NO_THROW([cache setObject:@"b" forKey:@"b" cost:30]);
+
+    // Touch "a" so that "b" becomes the least recently used costed entry.
+    EXPECT_OBJCEQ(@"a", [cache objectForKey:@"a"]);
+    EXPECT_NO_THROW([cache setObject:@"c" forKey:@"c" cost:30]);
+
+    EXPECT_OBJCEQ(nil, [cache objectForKey:@"b"]);
+    EXPECT_OBJCEQ(@"a", [cache objectForKey:@"a"]);
+    EXPECT_OBJCEQ(@"c", [cache objectForKey:@"c"]);
+    for (int i = 0; i < 100; ++i) {
+        EXPECT_OBJCNE_MSG(nil, [cache objectForKey:@(i)], "entry %d", i);
+    }
+}
+
+TEST(NSCache, ZeroTotalCostLimitIsUnlimited) {
+    NSCache* cache = nil;
+    ASSERT_NO_THROW(cache = [[NSCache new] autorelease]);
+    for (int i = 0; i < 100; ++i) {
+        EXPECT_NO_THROW([cache setObject:@(i) forKey:@(i) cost:1000]);
+    }
+
+    for (int i = 0; i < 100; ++i) {
+        EXPECT_OBJCNE_MSG(nil, [cache objectForKey:@(i)], "entry %d", i);
+    }
+}
+
+TEST(NSCache, ConcurrentHitMiss) {
+    NSCache* cache = nil;
+    ASSERT_NO_THROW(cache = [[NSCache new] autorelease]);
+    ASSERT_NO_THROW(cache.countLimit = 128);
+
+    std::atomic<int> hits(0);
+    std::atomic<int> wrongValues(0);
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; ++t) {
+        threads.emplace_back([cache, t, &hits, &wrongValues]() {
+            @autoreleasepool {
+                for (int i = 0; i < 5000; ++i) {
+                    const int key = (i * 5 + t * 61) % 256;
+                    id value = [cache objectForKey:@(key)];
+                    if (value == nil) {
+                        [cache setObject:@(key + 1) forKey:@(key) cost:1];
+                    } else {
+                        ++hits;
+                        if ([value intValue] != key + 1) {
+                            ++wrongValues;
+                        }
+                    }
+                }
+            }
+        });
+    }
+
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    EXPECT_GT(hits.load(), 0);
+    EXPECT_EQ(0, wrongValues.load());
+}
+
 // TODO: This segfaults on OSX after the end of the test
 // Thought it might've have had to do with leaked objects, but an extra release on
 // cache, lastEvictedCache, lastEvictedObject, and delegate, don't seem to fix it
@@ -19,6 +19,15 @@
 #import <Foundation/Foundation.h>
 
 #import "TestUtils.h"
+#import "NSDataInternal.h"
+
+#include <chrono>
+#include <vector>
+
+#ifdef WINOBJC
+#include <windows.h>
+#include <psapi.h>
+#endif
 
 // TODO: BUG 5403859: Enable ARC on this test file once load order issue is fixed
 
@@ -368,3 +377,189 @@ TEST(NSData, Copying_CustomBufferWithoutOwnership) {
     *(backingBuffer.get() + 5) = '!';
     ASSERT_OBJCNE(copiedData, originalNonOwningData);
 }
+
+// Writes length bytes of a repeating pattern to path and returns them
+static NSData* _writePatternFile(NSString* path, size_t length) {
+    std::vector<uint8_t> bytes(length);
+    for (size_t i = 0; i < length; ++i) {
+        bytes[i] = static_cast<uint8_t>((i * 31) ^ (i >> 11));
+    }
+
+    NSData* data = [NSData dataWithBytes:bytes.data() length:length];
+    EXPECT_TRUE([data writeToFile:path atomically:NO]);
+    return data;
+}
+
+TEST(NSData, MappedReading) {
+    StrongId<NSString> filePath = @"./NSDataMappedReading.bin";
+    SCOPE_DELETE_FILE(filePath);
+    NSData* expectedData = _writePatternFile(filePath, 256 * 1024 + 17);
+
+    const NSDataReadingOptions readingOptions[] = { 0, NSDataReadingMappedIfSafe, NSDataReadingMappedAlways };
+    for (NSDataReadingOptions options : readingOptions) {
+        NSError* error = nil;
+        NSData* data = [NSData dataWithContentsOfFile:filePath options:options error:&error];
+        EXPECT_EQ(nil, error);
+        EXPECT_OBJCEQ(expectedData, data);
+    }
+
+    EXPECT_OBJCEQ(expectedData, [NSData dataWithContentsOfMappedFile:filePath]);
+    EXPECT_OBJCEQ(expectedData, [[[NSData dataWithContentsOfMappedFile:filePath] copy] autorelease]);
+    EXPECT_OBJCEQ(expectedData, [[[NSData dataWithContentsOfMappedFile:filePath] mutableCopy] autorelease]);
+    EXPECT_OBJCEQ(expectedData, [NSMutableData dataWithContentsOfFile:filePath options:NSDataReadingMappedAlways error:nullptr]);
+
+    NSError* error = nil;
+    EXPECT_EQ(nil, [NSData dataWithContentsOfFile:@"./NONEXISTENT/NSDataMappedReading.bin" options:NSDataReadingMappedAlways error:&error]);
+    EXPECT_NE(nil, error);
+}
+
+TEST(NSData, MappedReadingSmallFile) {
+    StrongId<NSString> filePath = @"./NSDataMappedReadingSmall.bin";
+    SCOPE_DELETE_FILE(filePath);
+    NSData* expectedData = _writePatternFile(filePath, 11);
+
+    EXPECT_OBJCEQ(expectedData, [NSData dataWithContentsOfFile:filePath options:NSDataReadingMappedIfSafe error:nullptr]);
+    EXPECT_OBJCEQ(expectedData, [NSData dataWithContentsOfFile:filePath options:NSDataReadingMappedAlways error:nullptr]);
+}
+
+TEST(NSData, MappedSubdataOutlivesParent) {
+    StrongId<NSString> filePath = @"./NSDataMappedSubdata.bin";
+    SCOPE_DELETE_FILE(filePath);
+    NSData* expectedData = _writePatternFile(filePath, 512 * 1024);
+
+    const NSRange range = { 100000, 200000 };
+    StrongId<NSData> subdata;
+    @autoreleasepool {
+        NSData* data = [NSData dataWithContentsOfFile:filePath options:NSDataReadingMappedAlways error:nullptr];
+        ASSERT_OBJCNE(nil, data);
+        subdata = [data subdataWithRange:range];
+        EXPECT_EQ(0, [[data subdataWithRange:{ 0, 0 }] length]);
+    }
+
+    EXPECT_OBJCEQ([expectedData subdataWithRange:range], subdata);
+    EXPECT_OBJCEQ([expectedData subdataWithRange:{ range.location + 1000, 10 }], [subdata subdataWithRange:{ 1000, 10 }]);
+}
+
+TEST(NSData, SubdataWithRangeOutOfBounds) {
+    const char bytes[] = "Hello world";
+    NSData* data = [NSData dataWithBytes:bytes length:std::extent<decltype(bytes)>::value];
+
+    EXPECT_OBJCEQ([NSData dataWithBytes:bytes + 6 length:5], [data subdataWithRange:{ 6, 5 }]);
+    EXPECT_ANY_THROW([data subdataWithRange:{ 6, 100 }]);
+    EXPECT_ANY_THROW([data subdataWithRange:{ 6, NSUIntegerMax - 2 }]);
+    EXPECT_ANY_THROW([data subdataWithRange:{ NSUIntegerMax, 2 }]);
+
+    char buffer[4];
+    EXPECT_ANY_THROW([data getBytes:buffer range:{ 2, NSUIntegerMax - 1 }]);
+}
+
+TEST(NSData, BytesNoCopyDeallocator) {
+    __block int deallocatorCalls = 0;
+    __block NSUInteger deallocatedLength = 0;
+    void* bytes = malloc(32);
+    memset(bytes, 'x', 32);
+
+    @autoreleasepool {
+        NSData* data = [[NSData alloc] initWithBytesNoCopy:bytes
+                                                    length:32
+                                               deallocator:^(void* freedBytes, NSUInteger length) {
+                                                   ++deallocatorCalls;
+                                                   deallocatedLength = length;
+                                                   free(freedBytes);
+                                               }];
+        EXPECT_EQ(bytes, [data bytes]);
+        EXPECT_EQ(32, [data length]);
+        EXPECT_EQ(0, deallocatorCalls);
+        [data release];
+    }
+
+    EXPECT_EQ(1, deallocatorCalls);
+    EXPECT_EQ(32, deallocatedLength);
+}
+
+TEST(NSData, AdviseAccessPattern) {
+    StrongId<NSString> filePath = @"./NSDataAdviseAccessPattern.bin";
+    SCOPE_DELETE_FILE(filePath);
+    NSData* expectedData = _writePatternFile(filePath, 256 * 1024);
+
+    //  Hints change nothing about the contents, for mapped and resident data alike
+    NSData* mapped = [NSData dataWithContentsOfFile:filePath options:NSDataReadingMappedAlways error:nullptr];
+    for (NSData* data : { mapped, expectedData }) {
+        const _NSDataAccessPattern patterns[] = {
+            _NSDataAccessPatternNormal, _NSDataAccessPatternSequential, _NSDataAccessPatternRandom, _NSDataAccessPatternWillNeed
+        };
+        for (_NSDataAccessPattern pattern : patterns) {
+            EXPECT_NO_THROW([data _adviseAccessPattern:pattern range:{ 4096, 100000 }]);
+        }
+
+        EXPECT_NO_THROW([data _adviseAccessPattern:_NSDataAccessPatternSequential range:{ [data length], 0 }]);
+        EXPECT_ANY_THROW([data _adviseAccessPattern:_NSDataAccessPatternSequential range:{ 1, [data length] }]);
+        EXPECT_ANY_THROW([data _adviseAccessPattern:_NSDataAccessPatternWillNeed range:{ 1, NSUIntegerMax }]);
+        EXPECT_OBJCEQ(expectedData, data);
+    }
+}
+
+#ifdef WINOBJC
+static PROCESS_MEMORY_COUNTERS_EX _memoryCounters() {
+    PROCESS_MEMORY_COUNTERS_EX counters = {};
+    GetProcessMemoryInfo(GetCurrentProcess(), reinterpret_cast<PROCESS_MEMORY_COUNTERS*>(&counters), sizeof(counters));
+    return counters;
+}
+#endif
+
+// Writes and reads a 128MB file, so it only runs when asked for with --gtest_also_run_disabled_tests
+DISABLED_TEST(NSData, MappedReadingPerformance) {
+    const size_t fileLength = 128 * 1024 * 1024;
+    StrongId<NSString> filePath = @"./NSDataMappedReadingPerformance.bin";
+    SCOPE_DELETE_FILE(filePath);
+    @autoreleasepool {
+        _writePatternFile(filePath, fileLength);
+    }
+
+    //  The copy is read last, so that the peak working set of the mapped reads isn't inflated by it
+    struct {
+        const char* name;
+        NSDataReadingOptions options;
+        bool advise;
+    } const cases[] = { { "Mapped", NSDataReadingMappedAlways, false },
+                        { "Mapped, sequential hint", NSDataReadingMappedAlways, true },
+                        { "Copied", 0, false } };
+    for (const auto& readCase : cases) {
+        @autoreleasepool {
+#ifdef WINOBJC
+            const PROCESS_MEMORY_COUNTERS_EX countersBefore = _memoryCounters();
+#endif
+            auto start = std::chrono::steady_clock::now();
+            NSData* data = [NSData dataWithContentsOfFile:filePath options:readCase.options error:nullptr];
+            auto loadTime = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start);
+            ASSERT_EQ(fileLength, [data length]);
+
+            //  Touch every page, as a parser reading the whole file would
+            start = std::chrono::steady_clock::now();
+            if (readCase.advise) {
+                [data _adviseAccessPattern:_NSDataAccessPatternSequential range:NSMakeRange(0, fileLength)];
+            }
+
+            const uint8_t* bytes = static_cast<const uint8_t*>([data bytes]);
+            unsigned int checksum = 0;
+            for (size_t i = 0; i < fileLength; i += 4096) {
+                checksum += bytes[i];
+            }
+
+            auto touchTime = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start);
+            LOG_INFO("%s: loaded %u MB in %lld ms, touched every page in %lld ms (checksum %u).",
+                     readCase.name,
+                     static_cast<unsigned int>(fileLength / (1024 * 1024)),
+                     static_cast<long long>(loadTime.count()),
+                     static_cast<long long>(touchTime.count()),
+                     checksum);
+#ifdef WINOBJC
+            const PROCESS_MEMORY_COUNTERS_EX countersAfter = _memoryCounters();
+            LOG_INFO("%s: private bytes grew by %lld KB, peak working set %lld KB.",
+                     readCase.name,
+                     (static_cast<long long>(countersAfter.PrivateUsage) - static_cast<long long>(countersBefore.PrivateUsage)) / 1024,
+                     static_cast<long long>(countersAfter.PeakWorkingSetSize) / 1024);
+#endif
+        }
+    }
+}
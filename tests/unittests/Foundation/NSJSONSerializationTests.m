@@ -17,6 +17,8 @@
 #include "gtest-api.h"
 #import <Foundation/Foundation.h>
 
+#include <limits.h>
+
 void VerifyJSONObjectWithDataSucceeds(NSString* dataString, NSJSONWritingOptions opts, id expectedResult) {
     NSData* jsonData = [dataString dataUsingEncoding:NSUTF8StringEncoding];
     NSError* err = nil;
@@ -164,3 +166,233 @@ TEST(NSJSON, ValidJSONObjectTests) {
     ASSERT_EQ(YES, [NSJSONSerialization isValidJSONObject:testObject7]);
     ASSERT_EQ(NO, [NSJSONSerialization isValidJSONObject:testObject8]);
 }
+
+TEST(NSJSON, MutabilityOptions) {
+    NSData* data = [@"{\"list\":[\"a\",{\"b\":\"c\"}]}" dataUsingEncoding:NSUTF8StringEncoding];
+
+    NSDictionary* immutable = [NSJSONSerialization JSONObjectWithData:data options:0 error:nullptr];
+    ASSERT_OBJCNE(nil, immutable);
+    EXPECT_FALSE([immutable isKindOfClass:[NSMutableDictionary class]]);
+    EXPECT_FALSE([immutable[@"list"] isKindOfClass:[NSMutableArray class]]);
+
+    NSMutableDictionary* containers = [NSJSONSerialization JSONObjectWithData:data options:NSJSONReadingMutableContainers error:nullptr];
+    ASSERT_TRUE([containers isKindOfClass:[NSMutableDictionary class]]);
+    ASSERT_TRUE([containers[@"list"] isKindOfClass:[NSMutableArray class]]);
+    ASSERT_TRUE([containers[@"list"][1] isKindOfClass:[NSMutableDictionary class]]);
+    [containers[@"list"] addObject:@"d"];
+    [containers setObject:@1 forKey:@"added"];
+    EXPECT_EQ(3, [containers[@"list"] count]);
+
+    NSArray* leaves = [NSJSONSerialization JSONObjectWithData:[@"[\"a\"]" dataUsingEncoding:NSUTF8StringEncoding]
+                                                      options:NSJSONReadingMutableLeaves
+                                                        error:nullptr];
+    ASSERT_TRUE([leaves[0] isKindOfClass:[NSMutableString class]]);
+    [leaves[0] appendString:@"b"];
+    EXPECT_OBJCEQ(@"ab", leaves[0]);
+}
+
+TEST(NSJSON, ReadStringsAndNumbers) {
+    VerifyJSONObjectWithDataSucceeds(@"[\"\\\"\\\\\\/\\b\\f\\n\\r\\t\"]", 0, @[ @"\"\\/\b\f\n\r\t" ]);
+    VerifyJSONObjectWithDataSucceeds(@"[\"\\u00e9\\u4e2d\\ud83d\\ude00\"]", 0, @[ @"\u00e9\u4e2d\U0001F600" ]);
+    VerifyJSONObjectWithDataSucceeds(@"[\"caf\u00e9 \u4e2d\u6587\"]", 0, @[ @"caf\u00e9 \u4e2d\u6587" ]);
+    VerifyJSONObjectWithDataSucceeds(@"[\"a string long enough to take the vectorized scan, and then some more\"]",
+                                     0,
+                                     @[ @"a string long enough to take the vectorized scan, and then some more" ]);
+
+    VerifyJSONObjectWithDataSucceeds(@"[0,-1,9223372036854775807,-9223372036854775808,18446744073709551615]",
+                                     0,
+                                     @[ @0, @-1, @LLONG_MAX, @LLONG_MIN, @ULLONG_MAX ]);
+    VerifyJSONObjectWithDataSucceeds(@"[0.5,-2.25,1e3,1.5E-3,123456789.125]", 0, @[ @0.5, @-2.25, @1000.0, @0.0015, @123456789.125 ]);
+    VerifyJSONObjectWithDataSucceeds(@"[0.1,2.2250738585072014e-308,1.7976931348623157e308]",
+                                     0,
+                                     @[ @0.1, @2.2250738585072014e-308, @1.7976931348623157e308 ]);
+    VerifyJSONObjectWithDataSucceeds(@" \r\n\t[ true , false , null ] \n", 0, @[ @YES, @NO, [NSNull null] ]);
+    VerifyJSONObjectWithDataSucceeds(@"[[[[[]]]],{}]", 0, @[ @[ @[ @[ @[] ] ] ], @{} ]);
+}
+
+TEST(NSJSON, ReadErrors) {
+    NSArray* invalidDocuments = @[
+        @"",
+        @"   ",
+        @"[1,]",
+        @"[1 2]",
+        @"{\"a\" 1}",
+        @"{1:2}",
+        @"{\"a\":1,}",
+        @"[\"unterminated]",
+        @"[\"\\x\"]",
+        @"[\"\\ud800\"]",
+        @"[\"\\udc00\"]",
+        @"[\"\\u12\"]",
+        @"[01]",
+        @"[1.]",
+        @"[1e]",
+        @"[-]",
+        @"[1e400]",
+        @"[tru]",
+        @"[nul]",
+        @"[1] [2]",
+        @"[[[]]",
+    ];
+
+    for (NSString* document in invalidDocuments) {
+        VerifyJSONObjectWithDataFails(document, NSJSONReadingAllowFragments, 3840);
+    }
+
+    NSError* error = nil;
+    ASSERT_EQ(nil, [NSJSONSerialization JSONObjectWithData:[@"[1,2,x]" dataUsingEncoding:NSUTF8StringEncoding] options:0 error:&error]);
+    EXPECT_TRUE([error.userInfo[NSDebugDescriptionKey] hasSuffix:@"around character 5."]);
+}
+
+TEST(NSJSON, ReadOtherEncodings) {
+    NSArray* expected = @[ @"\u00e9", @1 ];
+    NSString* text = @"[\"\u00e9\",1]";
+    NSStringEncoding encodings[] = { NSUTF16LittleEndianStringEncoding,
+                                     NSUTF16BigEndianStringEncoding,
+                                     NSUTF32LittleEndianStringEncoding,
+                                     NSUTF32BigEndianStringEncoding,
+                                     NSUTF16StringEncoding };
+
+    for (size_t i = 0; i < sizeof(encodings) / sizeof(encodings[0]); ++i) {
+        NSData* data = [text dataUsingEncoding:encodings[i]];
+        NSError* error = nil;
+        EXPECT_OBJCEQ(expected, [NSJSONSerialization JSONObjectWithData:data options:0 error:&error]);
+        EXPECT_EQ(nil, error);
+    }
+
+    const char withByteOrderMark[] = "\xef\xbb\xbf[1]";
+    EXPECT_OBJCEQ(@[ @1 ],
+                  [NSJSONSerialization JSONObjectWithData:[NSData dataWithBytes:withByteOrderMark length:sizeof(withByteOrderMark) - 1]
+                                                  options:0
+                                                    error:nullptr]);
+}
+
+TEST(NSJSON, WriteValues) {
+    VerifyDataWithJSONObjectSucceeds(@[ @"a\"b\\c/d\n\x01", @"\u00e9\U0001F600" ], @"[\"a\\\"b\\\\c\\/d\\n\\u0001\",\"\u00e9\U0001F600\"]");
+    VerifyDataWithJSONObjectSucceeds(@[ @YES, @NO, [NSNull null], @-42, @ULLONG_MAX ], @"[true,false,null,-42,18446744073709551615]");
+    VerifyDataWithJSONObjectSucceeds(@[ @0.1, @1.5, @-1e-7, @1e21 ], @"[0.1,1.5,-1e-07,1e+21]");
+    VerifyDataWithJSONObjectSucceeds(@[ @[], @{} ], @"[[],{}]");
+
+    VerifyDataWithJSONObjectThrows(@[ (NSNumber*)kCFNumberNaN ]);
+    VerifyDataWithJSONObjectThrows(@[ [NSUUID UUID] ]);
+    VerifyDataWithJSONObjectThrows(@{ @1 : @"non-string key" });
+}
+
+TEST(NSJSON, WritePrettyPrinted) {
+    id object = @[ @1, @{ @"key" : @[] } ];
+    NSData* data = [NSJSONSerialization dataWithJSONObject:object options:NSJSONWritingPrettyPrinted error:nullptr];
+    NSString* text = [[[NSString alloc] initWithData:data encoding:NSUTF8StringEncoding] autorelease];
+
+    EXPECT_OBJCEQ(@"[\n  1,\n  {\n    \"key\" : [\n\n    ]\n  }\n]", text);
+    EXPECT_OBJCEQ(object, [NSJSONSerialization JSONObjectWithData:data options:0 error:nullptr]);
+}
+
+TEST(NSJSON, Streams) {
+    id object = @{ @"numbers" : @[ @1, @2.5 ], @"text" : @"\u00e9" };
+
+    NSOutputStream* output = [NSOutputStream outputStreamToMemory];
+    [output open];
+    NSError* error = nil;
+    NSInteger written = [NSJSONSerialization writeJSONObject:object toStream:output options:0 error:&error];
+    [output close];
+
+    NSData* data = [output propertyForKey:NSStreamDataWrittenToMemoryStreamKey];
+    EXPECT_EQ(nil, error);
+    EXPECT_EQ([data length], written);
+    EXPECT_OBJCEQ([NSJSONSerialization dataWithJSONObject:object options:0 error:nullptr], data);
+
+    NSInputStream* input = [NSInputStream inputStreamWithData:data];
+    [input open];
+    EXPECT_OBJCEQ(object, [NSJSONSerialization JSONObjectWithStream:input options:0 error:&error]);
+    EXPECT_EQ(nil, error);
+    [input close];
+}
+
+static NSData* _createTweetLikeDocument(NSUInteger recordCount) {
+    NSMutableString* text = [NSMutableString stringWithString:@"{\"statuses\":["];
+    for (NSUInteger i = 0; i < recordCount; ++i) {
+        [text appendFormat:@"%@{\"id\":%llu,\"id_str\":\"%llu\",\"text\":\"@user%lu \\u3053\\u3093\\u306b\\u3061\\u306f \\\"quoted\\\" "
+                           @"https:\\/\\/t.co\\/abc%lu\",\"truncated\":false,\"retweet_count\":%lu,\"favorited\":false,"
+                           @"\"user\":{\"id\":%lu,\"name\":\"User %lu\",\"screen_name\":\"user%lu\",\"location\":\"\",\"followers_count\":"
+                           @"%lu,\"verified\":false,\"profile_image_url\":\"http:\\/\\/a0.twimg.com\\/profile_images\\/%lu.png\"},"
+                           @"\"entities\":{\"hashtags\":[],\"urls\":[{\"url\":\"https:\\/\\/t.co\\/abc%lu\",\"indices\":[10,33]}]},"
+                           @"\"in_reply_to_status_id\":null}",
+                           (i == 0) ? @"" : @",",
+                           (unsigned long long)(505874924095815681 + i),
+                           (unsigned long long)(505874924095815681 + i),
+                           (unsigned long)i,
+                           (unsigned long)i,
+                           (unsigned long)(i % 97),
+                           (unsigned long)(1186275104 + i),
+                           (unsigned long)i,
+                           (unsigned long)i,
+                           (unsigned long)(i * 31 % 10007),
+                           (unsigned long)i,
+                           (unsigned long)i];
+    }
+
+    [text appendString:@"]}"];
+    return [text dataUsingEncoding:NSUTF8StringEncoding];
+}
+
+static NSData* _createCatalogLikeDocument(NSUInteger recordCount) {
+    NSMutableString* text = [NSMutableString stringWithString:@"{\"performances\":["];
+    for (NSUInteger i = 0; i < recordCount; ++i) {
+        [text appendFormat:@"%@{\"eventId\":%lu,\"id\":%lu,\"logo\":null,\"name\":null,\"prices\":[{\"amount\":%lu,\"audienceSubCategoryId\":"
+                           @"337100890,\"seatCategoryId\":338937295},{\"amount\":%lu,\"audienceSubCategoryId\":337100890,\"seatCategoryId\":"
+                           @"338937296}],\"seatCategories\":[{\"areas\":[{\"areaId\":205705999,\"blockIds\":[]},{\"areaId\":205705998,"
+                           @"\"blockIds\":[]}],\"seatCategoryId\":338937295}],\"start\":%lu,\"venueCode\":\"PLEYEL_PLEYEL\",\"ratio\":%.3f}",
+                           (i == 0) ? @"" : @",",
+                           (unsigned long)(138586341 + i % 50),
+                           (unsigned long)(339887544 + i),
+                           (unsigned long)(90250 + i * 10),
+                           (unsigned long)(66500 + i * 10),
+                           (unsigned long)(1372701600000 + i * 86400000),
+                           i / 7.0];
+    }
+
+    [text appendString:@"]}"];
+    return [text dataUsingEncoding:NSUTF8StringEncoding];
+}
+
+TEST(NSJSON, ReadWritePerformance) {
+    NSArray* names = @[ @"tweet-like", @"catalog-like" ];
+    NSArray* documents = @[ _createTweetLikeDocument(2000), _createCatalogLikeDocument(4000) ];
+
+    for (NSUInteger i = 0; i < [documents count]; ++i) {
+        NSData* document = documents[i];
+        const int iterations = 10;
+
+        id object = nil;
+        CFAbsoluteTime start = CFAbsoluteTimeGetCurrent();
+        for (int iteration = 0; iteration < iterations; ++iteration) {
+            @autoreleasepool {
+                object = [[NSJSONSerialization JSONObjectWithData:document options:0 error:nullptr] retain];
+                if (iteration != iterations - 1) {
+                    [object release];
+                }
+            }
+        }
+
+        const double readSeconds = (CFAbsoluteTimeGetCurrent() - start) / iterations;
+        ASSERT_OBJCNE(nil, object);
+
+        NSData* written = nil;
+        start = CFAbsoluteTimeGetCurrent();
+        for (int iteration = 0; iteration < iterations; ++iteration) {
+            written = [NSJSONSerialization dataWithJSONObject:object options:0 error:nullptr];
+        }
+
+        const double writeSeconds = (CFAbsoluteTimeGetCurrent() - start) / iterations;
+        EXPECT_OBJCEQ(object, [NSJSONSerialization JSONObjectWithData:written options:0 error:nullptr]);
+        [object release];
+
+        const double megabytes = [document length] / (1024.0 * 1024.0);
+        LOG_INFO("%s (%.1f MB): read %.2f ms (%.0f MB/s), write %.2f ms",
+                 [names[i] UTF8String],
+                 megabytes,
+                 readSeconds * 1000.0,
+                 megabytes / readSeconds,
+                 writeSeconds * 1000.0);
+    }
+}
@@ -17,6 +17,8 @@
 #import <TestFramework.h>
 #import <Foundation/Foundation.h>
 
+#include <chrono>
+
 // Many of the tests in this file are disabled pending a fix for GH#800.
 // In short, we have known incompatibilities with aggregate function support vis-a-vis the reference platform.
 // Until we've fixed them, we're disabling the tests that are noncompliant.
@@ -258,4 +260,110 @@ TEST(NSKeyValueCoding, AggregateFunctionNullLeaf) {
 TEST(NSKeyValueCoding, AggregateFunctionInvalid) {
     NSMutableArray* coins = obtainArrayOfCoins(0, 10);
     ASSERT_ANY_THROW([coins valueForKeyPath:@"@foobar.coinValue"]);
-}
\ No newline at end of file
+}
+
+@interface KVCTestIvarHolder : NSObject {
+@public
+    NSInteger _count;
+    BOOL isEnabled;
+    NSString* name;
+}
+@end
+
+@implementation KVCTestIvarHolder
+- (void)dealloc {
+    [name release];
+    [super dealloc];
+}
+@end
+
+@interface KVCTestObserver : NSObject
+@property (assign) NSUInteger notificationCount;
+@end
+
+@implementation KVCTestObserver
+- (void)observeValueForKeyPath:(NSString*)keyPath ofObject:(id)object change:(NSDictionary*)change context:(void*)context {
+    ++_notificationCount;
+}
+@end
+
+TEST(NSKeyValueCoding, CachedAccessorsSeeEachInstance) {
+    NSMutableArray* coins = obtainArrayOfCoins(0, 10);
+
+    //  The first lookup resolves and caches the accessors; every later one must still read its own receiver
+    for (int pass = 0; pass < 2; ++pass) {
+        for (NSUInteger i = 0; i < [coins count]; ++i) {
+            EXPECT_EQ(i, [[coins[i] valueForKey:@"coinValue"] unsignedIntegerValue]);
+        }
+    }
+
+    [coins[3] setValue:@42 forKey:@"coinValue"];
+    [coins[4] setValue:@"leaf" forKey:@"testObj"];
+    EXPECT_EQ(42, [coins[3] coinValue]);
+    EXPECT_OBJCEQ(@"leaf", [coins[4] testObj]);
+    EXPECT_EQ(nil, [coins[3] valueForKey:@"testObj"]);
+
+    EXPECT_ANY_THROW([coins[0] valueForKey:@"noSuchKey"]);
+    EXPECT_ANY_THROW([coins[1] valueForKey:@"noSuchKey"]);
+}
+
+TEST(NSKeyValueCoding, CachedInstanceVariables) {
+    KVCTestIvarHolder* first = [[KVCTestIvarHolder new] autorelease];
+    KVCTestIvarHolder* second = [[KVCTestIvarHolder new] autorelease];
+
+    [first setValue:@7 forKey:@"count"];
+    [second setValue:@9 forKey:@"count"];
+    [first setValue:@YES forKey:@"enabled"];
+    [second setValue:@"second" forKey:@"name"];
+
+    EXPECT_EQ(7, first->_count);
+    EXPECT_EQ(9, second->_count);
+    EXPECT_OBJCEQ(@7, [first valueForKey:@"count"]);
+    EXPECT_OBJCEQ(@9, [second valueForKey:@"count"]);
+    EXPECT_TRUE([[first valueForKey:@"enabled"] boolValue]);
+    EXPECT_FALSE([[second valueForKey:@"enabled"] boolValue]);
+    EXPECT_OBJCEQ(@"second", [second valueForKey:@"name"]);
+    EXPECT_EQ(nil, [first valueForKey:@"name"]);
+}
+
+TEST(NSKeyValueCoding, CachedSetterStillNotifiesObservers) {
+    NSMutableArray* coins = obtainArrayOfCoins(0, 2);
+    KVCTestObserver* observer = [[KVCTestObserver new] autorelease];
+
+    //  Resolve the setter before either coin is observed
+    [coins[0] setValue:@1 forKey:@"coinValue"];
+    [coins[1] setValue:@1 forKey:@"coinValue"];
+
+    [coins[1] addObserver:observer forKeyPath:@"coinValue" options:0 context:nullptr];
+    [coins[0] setValue:@2 forKey:@"coinValue"];
+    EXPECT_EQ(0, [observer notificationCount]);
+
+    [coins[1] setValue:@2 forKey:@"coinValue"];
+    EXPECT_EQ(1, [observer notificationCount]);
+    EXPECT_OBJCEQ(@2, [coins[1] valueForKey:@"coinValue"]);
+
+    [coins[1] removeObserver:observer forKeyPath:@"coinValue"];
+}
+
+TEST(NSKeyValueCoding, ValueForKeyPathPerformance) {
+    const unsigned int coinCount = 100000;
+    NSMutableArray* coins = obtainArrayOfCoins(0, coinCount);
+
+    auto start = std::chrono::steady_clock::now();
+    NSArray* values = [coins valueForKeyPath:@"coinValue"];
+    auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start);
+    LOG_INFO("valueForKeyPath:coinValue: %lld ms for %u objects.", static_cast<long long>(elapsed.count()), coinCount);
+    ASSERT_EQ(coinCount, [values count]);
+
+    start = std::chrono::steady_clock::now();
+    NSNumber* sum = [coins valueForKeyPath:@"@sum.coinValue"];
+    elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start);
+    LOG_INFO("valueForKeyPath:@sum.coinValue: %lld ms for %u objects.", static_cast<long long>(elapsed.count()), coinCount);
+    ASSERT_EQ(static_cast<long long>(coinCount) * (coinCount - 1) / 2, [sum longLongValue]);
+
+    start = std::chrono::steady_clock::now();
+    NSArray* leaves = [coins valueForKeyPath:@"testObj"];
+    elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start);
+    LOG_INFO("valueForKeyPath:testObj: %lld ms for %u objects.", static_cast<long long>(elapsed.count()), coinCount);
+    ASSERT_EQ(coinCount, [leaves count]);
+}
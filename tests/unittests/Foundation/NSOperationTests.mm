@@ -21,6 +21,9 @@
 #import <mutex>
 #import <condition_variable>
 #import <chrono>
+#import <atomic>
+#import <algorithm>
+#import <vector>
 
 static void (^_completionBlockPopulatingConditionAndFlag(void (^completionBlock)(), NSCondition** condition, BOOL* flag))() {
     NSCondition* cond = [[NSCondition new] autorelease];
@@ -586,4 +589,192 @@ TEST(NSOperation, NSBlockOperationInQueue) {
     ASSERT_TRUE(completionBlockCalled);
     ASSERT_TRUE([operation isFinished]);
     ASSERT_FALSE([operation isExecuting]);
-}
\ No newline at end of file
+}
+
+TEST(NSOperation, NSOperationQueueHonorsMaxConcurrentOperationCount) {
+    for (NSInteger maxCount : { 1, 2, 4 }) {
+        NSOperationQueue* queue = [[NSOperationQueue new] autorelease];
+        queue.maxConcurrentOperationCount = maxCount;
+        EXPECT_EQ(maxCount, queue.maxConcurrentOperationCount);
+
+        std::atomic<int> running(0);
+        std::atomic<int> peak(0);
+        std::atomic<int> completed(0);
+        std::atomic<int>* runningPtr = &running;
+        std::atomic<int>* peakPtr = &peak;
+        std::atomic<int>* completedPtr = &completed;
+        for (int i = 0; i < 32; ++i) {
+            [queue addOperation:[NSBlockOperation blockOperationWithBlock:^{
+                       const int now = ++*runningPtr;
+                       int previous = peakPtr->load();
+                       while (now > previous && !peakPtr->compare_exchange_weak(previous, now)) {
+                       }
+
+                       std::this_thread::sleep_for(std::chrono::milliseconds(2));
+                       --*runningPtr;
+                       ++*completedPtr;
+                   }]];
+        }
+
+        [queue waitUntilAllOperationsAreFinished];
+        EXPECT_EQ(32, completed.load());
+        EXPECT_EQ(0u, queue.operationCount);
+        EXPECT_LE(peak.load(), maxCount);
+        EXPECT_GE(peak.load(), 1);
+    }
+}
+
+TEST(NSOperation, NSOperationQueueRunsByPriority) {
+    NSOperationQueue* queue = [[NSOperationQueue new] autorelease];
+    queue.maxConcurrentOperationCount = 1;
+    [queue setSuspended:YES];
+
+    std::mutex orderLock;
+    std::mutex* orderLockPtr = &orderLock;
+    __block std::vector<int> order;
+    const NSOperationQueuePriority priorities[] = { NSOperationQueuePriorityLow,
+                                                    NSOperationQueuePriorityNormal,
+                                                    NSOperationQueuePriorityVeryHigh,
+                                                    NSOperationQueuePriorityLow,
+                                                    NSOperationQueuePriorityHigh,
+                                                    NSOperationQueuePriorityNormal };
+    for (int i = 0; i < 6; ++i) {
+        NSOperation* operation = [NSBlockOperation blockOperationWithBlock:^{
+            std::lock_guard<std::mutex> lock(*orderLockPtr);
+            order.push_back(i);
+        }];
+        operation.queuePriority = priorities[i];
+        [queue addOperation:operation];
+    }
+
+    EXPECT_EQ(6u, queue.operationCount);
+    [queue setSuspended:NO];
+    [queue waitUntilAllOperationsAreFinished];
+
+    // Higher priorities first; operations of equal priority run in the order they were added.
+    const std::vector<int> expected = { 2, 4, 1, 5, 0, 3 };
+    EXPECT_EQ(expected, order);
+}
+
+TEST(NSOperation, NSOperationQueueWaitsForDependenciesWithoutBlockingOthers) {
+    NSOperationQueue* queue = [[NSOperationQueue new] autorelease];
+    queue.maxConcurrentOperationCount = 1;
+
+    __block BOOL independentRan = NO;
+    NSOperation* gate = [[NSOperation new] autorelease];
+    NSOperation* dependent = [NSBlockOperation blockOperationWithBlock:^{
+        EXPECT_TRUE([gate isFinished]);
+    }];
+    [dependent addDependency:gate];
+
+    [queue addOperation:dependent];
+    [queue addOperations:@[ [NSBlockOperation blockOperationWithBlock:^{
+               independentRan = YES;
+           }] ]
+        waitUntilFinished:YES];
+
+    // The dependent operation is parked rather than occupying the queue's only slot.
+    EXPECT_TRUE(independentRan);
+    EXPECT_FALSE([dependent isFinished]);
+    EXPECT_EQ(1u, queue.operationCount);
+
+    [gate start];
+    [queue waitUntilAllOperationsAreFinished];
+    EXPECT_TRUE([dependent isFinished]);
+}
+
+TEST(NSOperation, NSOperationQueueCurrentQueue) {
+    NSOperationQueue* queue = [[NSOperationQueue new] autorelease];
+    __block NSOperationQueue* currentQueue = nil;
+    [queue addOperations:@[ [NSBlockOperation blockOperationWithBlock:^{
+               currentQueue = [NSOperationQueue currentQueue];
+           }] ]
+        waitUntilFinished:YES];
+
+    EXPECT_OBJCEQ(queue, currentQueue);
+}
+
+TEST(NSOperation, NSOperationQueueRequeuesOperationsThatStopBeingReady) {
+    NSOperationQueue* queue = [[NSOperationQueue new] autorelease];
+    [queue setSuspended:YES];
+
+    __block BOOL ran = NO;
+    NSOperation* gate = [[NSOperation new] autorelease];
+    NSOperation* operation = [NSBlockOperation blockOperationWithBlock:^{
+        ran = YES;
+    }];
+    [queue addOperation:operation];
+
+    // The operation was queued as ready; the dependency sends it back to wait when the queue gets to it.
+    [operation addDependency:gate];
+    [queue setSuspended:NO];
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    EXPECT_FALSE(ran);
+    EXPECT_EQ(1u, queue.operationCount);
+
+    [gate start];
+    [queue waitUntilAllOperationsAreFinished];
+    EXPECT_TRUE(ran);
+    EXPECT_TRUE([operation isFinished]);
+}
+
+TEST(NSOperation, NSOperationQueueRunsOperationsWaitedOnFromOtherQueues) {
+    // More waiting operations than the shared pool has workers, all waiting on an operation queued after them
+    const int waiterCount = 2 * static_cast<int>(std::max(4u, std::thread::hardware_concurrency()));
+    NSOperationQueue* waiters = [[NSOperationQueue new] autorelease];
+    NSOperationQueue* others = [[NSOperationQueue new] autorelease];
+    NSOperation* gate = [[NSOperation new] autorelease];
+
+    std::atomic<int> finished(0);
+    std::atomic<int>* finishedPtr = &finished;
+    for (int i = 0; i < waiterCount; ++i) {
+        [waiters addOperation:[NSBlockOperation blockOperationWithBlock:^{
+                     [gate waitUntilFinished];
+                     ++*finishedPtr;
+                 }]];
+    }
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    [others addOperation:gate];
+
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+    while ((finished.load() < waiterCount) && (std::chrono::steady_clock::now() < deadline)) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+
+    EXPECT_TRUE([gate isFinished]);
+    EXPECT_EQ(waiterCount, finished.load());
+}
+
+// Runs the same CPU-bound workload with 1 to N concurrent operations and logs the throughput of each.
+TEST(NSOperation, NSOperationQueueScaling) {
+    const int workerCount = std::max(2u, std::thread::hardware_concurrency());
+    const int operationCount = 64;
+
+    for (int maxCount = 1; maxCount <= workerCount; maxCount *= 2) {
+        NSOperationQueue* queue = [[NSOperationQueue new] autorelease];
+        queue.maxConcurrentOperationCount = maxCount;
+
+        std::atomic<uint64_t> checksum(0);
+        std::atomic<uint64_t>* checksumPtr = &checksum;
+        const auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < operationCount; ++i) {
+            [queue addOperation:[NSBlockOperation blockOperationWithBlock:^{
+                       uint64_t value = i + 1;
+                       for (int step = 0; step < 2000000; ++step) {
+                           value = value * 6364136223846793005ull + 1442695040888963407ull;
+                       }
+
+                       *checksumPtr += value >> 32;
+                   }]];
+        }
+
+        [queue waitUntilAllOperationsAreFinished];
+        const auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start);
+        EXPECT_NE(0ull, checksum.load());
+        LOG_INFO("%d concurrent operation(s): %lld ms for %d operations.",
+                 maxCount,
+                 static_cast<long long>(elapsed.count()),
+                 operationCount);
+    }
+}
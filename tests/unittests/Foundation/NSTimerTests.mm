@@ -17,6 +17,7 @@
 #import <Starboard/SmartTypes.h>
 #import <TestFramework.h>
 #import <Foundation/Foundation.h>
+#import <chrono>
 #import <future>
 #import <windows.h>
 
@@ -266,4 +267,138 @@ TEST(NSTimer, ScheduledTimerWithTimeIntervalWithInvocation) {
     ASSERT_TRUE_MSG(![timer isValid], "FAILED: The timer should not be valid.");
     ASSERT_EQ_MSG(YES, selectorCalledAsync.get(), "FAILED: the scheduled timer did not call the method.");
     ASSERT_OBJCEQ_MSG(testDummyArg, [testObj dummyVal], "FAILED: argument was not retained.");
-}
\ No newline at end of file
+}
+
+@interface NSTimerOrderRecorder : NSObject
+@property (readonly) NSMutableArray* fired;
+@end
+
+@implementation NSTimerOrderRecorder
+- (instancetype)init {
+    if (self = [super init]) {
+        _fired = [NSMutableArray new];
+    }
+
+    return self;
+}
+
+- (void)recordFire:(NSTimer*)timer {
+    [_fired addObject:[timer userInfo]];
+}
+
+- (void)dealloc {
+    [_fired release];
+    [super dealloc];
+}
+@end
+
+static void _runCurrentRunLoopBriefly() {
+    for (int i = 0; i < 10; ++i) {
+        [[NSRunLoop currentRunLoop] runMode:NSDefaultRunLoopMode beforeDate:[NSDate dateWithTimeIntervalSinceNow:0.01]];
+    }
+}
+
+TEST(NSTimer, DueTimersFireInFireDateOrder) {
+    NSTimerOrderRecorder* recorder = [[NSTimerOrderRecorder new] autorelease];
+    const int offsets[] = { 3, 7, 1, 9, 5, 2, 8, 4, 6, 0 };
+
+    for (int offset : offsets) {
+        NSDate* fireDate = [NSDate dateWithTimeIntervalSinceNow:-10.0 + offset * 0.1];
+        NSTimer* timer = [[[NSTimer alloc] initWithFireDate:fireDate
+                                                   interval:0
+                                                     target:recorder
+                                                   selector:@selector(recordFire:)
+                                                   userInfo:@(offset)
+                                                    repeats:NO] autorelease];
+        [[NSRunLoop currentRunLoop] addTimer:timer forMode:NSDefaultRunLoopMode];
+    }
+
+    _runCurrentRunLoopBriefly();
+
+    EXPECT_OBJCEQ((@[ @0, @1, @2, @3, @4, @5, @6, @7, @8, @9 ]), recorder.fired);
+}
+
+TEST(NSTimer, SetFireDateReschedules) {
+    NSTimerOrderRecorder* recorder = [[NSTimerOrderRecorder new] autorelease];
+    NSTimer* timer = [[[NSTimer alloc] initWithFireDate:[NSDate distantFuture]
+                                               interval:0
+                                                 target:recorder
+                                               selector:@selector(recordFire:)
+                                               userInfo:@"moved"
+                                                repeats:NO] autorelease];
+    [[NSRunLoop currentRunLoop] addTimer:timer forMode:NSDefaultRunLoopMode];
+
+    _runCurrentRunLoopBriefly();
+    EXPECT_EQ(0, [recorder.fired count]);
+
+    [timer setFireDate:[NSDate dateWithTimeIntervalSinceNow:-1.0]];
+    _runCurrentRunLoopBriefly();
+    EXPECT_OBJCEQ(@[ @"moved" ], recorder.fired);
+    EXPECT_FALSE([timer isValid]);
+}
+
+TEST(NSTimer, InvalidatedTimerLeavesRunLoop) {
+    NSTimerOrderRecorder* recorder = [[NSTimerOrderRecorder new] autorelease];
+    NSTimer* timer = [[NSTimer alloc] initWithFireDate:[NSDate dateWithTimeIntervalSinceNow:-1.0]
+                                              interval:0
+                                                target:recorder
+                                              selector:@selector(recordFire:)
+                                              userInfo:@"invalidated"
+                                               repeats:NO];
+    [[NSRunLoop currentRunLoop] addTimer:timer forMode:NSDefaultRunLoopMode];
+    EXPECT_LT(1, [timer retainCount]);
+
+    [timer invalidate];
+    EXPECT_EQ(1, [timer retainCount]);
+    [timer release];
+
+    _runCurrentRunLoopBriefly();
+    EXPECT_EQ(0, [recorder.fired count]);
+}
+
+TEST(NSTimer, ManyTimersPerformance) {
+    const int timerCount = 10000;
+    NSTimerOrderRecorder* recorder = [[NSTimerOrderRecorder new] autorelease];
+    NSRunLoop* runLoop = [NSRunLoop currentRunLoop];
+    NSMutableArray* timers = [NSMutableArray arrayWithCapacity:timerCount];
+
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < timerCount; ++i) {
+        //  Spread over the next few hours so that none of them comes due during the test
+        NSDate* fireDate = [NSDate dateWithTimeIntervalSinceNow:3600.0 + (i * 7919 % timerCount)];
+        NSTimer* timer = [[NSTimer alloc] initWithFireDate:fireDate
+                                                  interval:1.0
+                                                    target:recorder
+                                                  selector:@selector(recordFire:)
+                                                  userInfo:nil
+                                                   repeats:YES];
+        [runLoop addTimer:timer forMode:NSDefaultRunLoopMode];
+        [timers addObject:timer];
+        [timer release];
+    }
+
+    auto scheduled = std::chrono::steady_clock::now();
+
+    const int iterations = 1000;
+    for (int i = 0; i < iterations; ++i) {
+        @autoreleasepool {
+            [runLoop runMode:NSDefaultRunLoopMode beforeDate:[NSDate date]];
+        }
+    }
+
+    auto polled = std::chrono::steady_clock::now();
+
+    for (NSTimer* timer in timers) {
+        [timer invalidate];
+    }
+
+    auto invalidated = std::chrono::steady_clock::now();
+
+    EXPECT_EQ(0, [recorder.fired count]);
+    LOG_INFO("%d timers: schedule %lld us, %d run loop iterations %lld us, invalidate %lld us",
+             timerCount,
+             std::chrono::duration_cast<std::chrono::microseconds>(scheduled - start).count(),
+             iterations,
+             std::chrono::duration_cast<std::chrono::microseconds>(polled - scheduled).count(),
+             std::chrono::duration_cast<std::chrono::microseconds>(invalidated - polled).count());
+}
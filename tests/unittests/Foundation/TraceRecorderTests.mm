@@ -0,0 +1,277 @@
+//******************************************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+//
+// This code is licensed under the MIT License (MIT).
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+//******************************************************************************
+
+#import <TestFramework.h>
+#import <Foundation/Foundation.h>
+#import "TestUtils.h"
+
+#include "LoggingNative.h"
+
+#include <chrono>
+#include <functional>
+#include <stdio.h>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+struct Message {
+    uint32_t threadId;
+    int level;
+    std::string tag;
+    std::string message;
+};
+
+class Recording {
+public:
+    explicit Recording(size_t bytesPerThread = 0) {
+        TraceStartRecording(bytesPerThread, &Recording::write, this);
+    }
+
+    ~Recording() {
+        TraceStopRecording();
+    }
+
+    // Stops recording and decodes everything recorded
+    std::vector<Message> Stop() {
+        TraceStopRecording();
+        return Decode(_data);
+    }
+
+    static std::vector<Message> Decode(const std::vector<uint8_t>& data) {
+        std::vector<Message> messages;
+        EXPECT_NE(-1, TraceDecodeRecording(data.data(), data.size(), &Recording::decoded, &messages));
+        return messages;
+    }
+
+private:
+    static void write(const void* data, size_t length, void* context) {
+        std::vector<uint8_t>& recording = static_cast<Recording*>(context)->_data;
+        recording.insert(recording.end(), static_cast<const uint8_t*>(data), static_cast<const uint8_t*>(data) + length);
+    }
+
+    static void decoded(const TraceDecodedRecord* record, void* context) {
+        static_cast<std::vector<Message>*>(context)->push_back({ record->threadId, record->level, record->tag, record->message });
+    }
+
+    std::vector<uint8_t> _data;
+};
+
+} // namespace
+
+TEST(TraceRecorder, DecodesArguments) {
+    Recording recording;
+
+    TraceVerbose(L"TraceRecorderTests", L"Int: %d Negative: %hd Unsigned: %u Long: %lld Hex: %#x Size: %Iu", 12345, -7, 3000000000u, -123456789012ll, 255, (size_t)42);
+    TraceInfo(L"TraceRecorderTests", L"Float: %.2f Padded: %08.3f Exponent: %e", 123.456, 3.14159, 1.5e10);
+    TraceWarning(L"TraceRecorderTests", L"Wide: %ws Narrow: %hs Wide2: %s Narrow2: %S Null: %hs", L"文字化け", "abcdefg", L"wide", "narrow", (const char*)nullptr);
+    TraceError(L"TraceRecorderTests", L"Width: [%*d] Precision: [%.*hs] Left: [%-5hs] Char: %hc%c 100%%", 6, 42, 3, "truncated", "ab", 'x', L'ü');
+    TraceCritical(L"TraceRecorderTests", L"No arguments");
+
+    std::vector<Message> messages = recording.Stop();
+    ASSERT_EQ(5u, messages.size());
+
+    EXPECT_EQ(TraceLevelVerbose, messages[0].level);
+    EXPECT_STREQ("TraceRecorderTests", messages[0].tag.c_str());
+    EXPECT_STREQ("Int: 12345 Negative: -7 Unsigned: 3000000000 Long: -123456789012 Hex: 0xff Size: 42", messages[0].message.c_str());
+
+    EXPECT_EQ(TraceLevelInfo, messages[1].level);
+    EXPECT_STREQ("Float: 123.46 Padded: 0003.142 Exponent: 1.500000e+10", messages[1].message.c_str());
+
+    EXPECT_EQ(TraceLevelWarning, messages[2].level);
+    EXPECT_STREQ("Wide: 文字化け Narrow: abcdefg Wide2: wide Narrow2: narrow Null: (null)", messages[2].message.c_str());
+
+    EXPECT_EQ(TraceLevelError, messages[3].level);
+    EXPECT_STREQ("Width: [    42] Precision: [tru] Left: [ab   ] Char: xü 100%", messages[3].message.c_str());
+
+    EXPECT_EQ(TraceLevelCritical, messages[4].level);
+    EXPECT_STREQ("No arguments", messages[4].message.c_str());
+}
+
+TEST(TraceRecorder, FormatsInReusedBuffers) {
+    Recording recording;
+
+    //  Callers like the WIL logging hook trace whatever is in a buffer as the format
+    wchar_t buffer[32];
+    swprintf(buffer, 32, L"First");
+    TraceError(L"TraceRecorderTests", buffer);
+    swprintf(buffer, 32, L"Second");
+    TraceError(L"TraceRecorderTests", buffer);
+
+    std::vector<Message> messages = recording.Stop();
+    ASSERT_EQ(2u, messages.size());
+    EXPECT_STREQ("First", messages[0].message.c_str());
+    EXPECT_STREQ("Second", messages[1].message.c_str());
+}
+
+TEST(TraceRecorder, TruncatesLongMessages) {
+    Recording recording;
+
+    //  Too long to record as arguments, so the message is formatted at once and cut to fit
+    const std::string text(4000, 'x');
+    TraceError(L"TraceRecorderTests", L"%hs", text.c_str());
+
+    std::vector<Message> messages = recording.Stop();
+    ASSERT_EQ(1u, messages.size());
+    EXPECT_LT(0u, messages[0].message.size());
+    EXPECT_GT(1024u, messages[0].message.size());
+    EXPECT_EQ(std::string::npos, messages[0].message.find_first_not_of('x'));
+}
+
+TEST(TraceRecorder, RejectsDamagedRecordings) {
+    //  A header, then a tag definition whose id no recorder would hand out
+    std::vector<uint8_t> data;
+    const uint8_t header[] = { 'W', 'O', 'C', 'T', 'R', 'A', 'C', 'E', 1, 0, 0, 0, sizeof(wchar_t), sizeof(void*), 0, 0 };
+    const uint8_t tag[] = { 2, 0xF0, 0xFF, 0xFF, 0xFF, 0, 0, 0, 0 };
+    data.insert(data.end(), header, header + sizeof(header));
+    data.insert(data.end(), tag, tag + sizeof(tag));
+    EXPECT_EQ(-1, TraceDecodeRecording(data.data(), data.size(), [](const TraceDecodedRecord*, void*) {}, nullptr));
+
+    //  A format definition longer than the recording
+    const uint8_t format[] = { 1, 0, 0, 0, 0, 0xFF, 0xFF, 0xFF, 0x7F };
+    data.resize(sizeof(header));
+    data.insert(data.end(), format, format + sizeof(format));
+    EXPECT_EQ(-1, TraceDecodeRecording(data.data(), data.size(), [](const TraceDecodedRecord*, void*) {}, nullptr));
+}
+
+TEST(TraceRecorder, FiltersByLevelAndTag) {
+    Recording recording;
+
+    TraceSetLevel(TraceLevelWarning);
+    EXPECT_FALSE(TraceIsEnabled(TraceLevelInfo, L"TraceRecorderTests"));
+    EXPECT_TRUE(TraceIsEnabled(TraceLevelWarning, L"TraceRecorderTests"));
+    TraceVerbose(L"TraceRecorderTests", L"Dropped %d", 1);
+    TraceInfo(L"TraceRecorderTests", L"Dropped %d", 2);
+    TraceWarning(L"TraceRecorderTests", L"Kept %d", 3);
+    TraceSetLevel(TraceLevelVerbose);
+
+    //  Tags are matched by value, not by address
+    const std::wstring tag = L"TraceRecorderTests.Noisy";
+    TraceSetTagEnabled(L"TraceRecorderTests.Noisy", false);
+    EXPECT_FALSE(TraceIsEnabled(TraceLevelCritical, tag.c_str()));
+    TraceVerbose(tag.c_str(), L"Dropped %d", 4);
+    TraceVerbose(L"TraceRecorderTests", L"Kept %d", 5);
+    TraceSetTagEnabled(L"TraceRecorderTests.Noisy", true);
+    TraceVerbose(tag.c_str(), L"Kept %d", 6);
+
+    std::vector<Message> messages = recording.Stop();
+    ASSERT_EQ(3u, messages.size());
+    EXPECT_STREQ("Kept 3", messages[0].message.c_str());
+    EXPECT_STREQ("Kept 5", messages[1].message.c_str());
+    EXPECT_STREQ("Kept 6", messages[2].message.c_str());
+    EXPECT_STREQ("TraceRecorderTests.Noisy", messages[2].tag.c_str());
+}
+
+TEST(TraceRecorder, RecordsEachThread) {
+    const int c_threadCount = 4;
+    const int c_messagesPerThread = 1000;
+    Recording recording(1024 * 1024);
+
+    std::vector<std::thread> threads;
+    for (int i = 0; i < c_threadCount; ++i) {
+        threads.emplace_back([i]() {
+            for (int j = 0; j < c_messagesPerThread; ++j) {
+                TraceVerbose(L"TraceRecorderTests", L"%d %d", i, j);
+            }
+        });
+    }
+
+    //  Flushing while the threads trace must not lose or tear anything
+    for (int i = 0; i < 10; ++i) {
+        TraceFlushRecording();
+    }
+
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+
+    std::vector<Message> messages = recording.Stop();
+    ASSERT_EQ(static_cast<size_t>(c_threadCount * c_messagesPerThread), messages.size());
+
+    std::vector<int> next(c_threadCount, 0);
+    for (const Message& message : messages) {
+        int thread = -1;
+        int index = -1;
+        ASSERT_EQ(2, sscanf(message.message.c_str(), "%d %d", &thread, &index));
+        ASSERT_TRUE(thread >= 0 && thread < c_threadCount);
+        EXPECT_EQ(next[thread]++, index);
+    }
+}
+
+TEST(TraceRecorder, CountsDroppedMessages) {
+    Recording recording(4096);
+
+    const int c_messageCount = 1000;
+    for (int i = 0; i < c_messageCount; ++i) {
+        TraceVerbose(L"TraceRecorderTests", L"Message %d", i);
+    }
+
+    std::vector<Message> messages = recording.Stop();
+    ASSERT_FALSE(messages.empty());
+    ASSERT_LT(messages.size(), static_cast<size_t>(c_messageCount));
+
+    const Message& dropped = messages.back();
+    EXPECT_EQ(TraceLevelWarning, dropped.level);
+    EXPECT_STREQ("TraceRecorder", dropped.tag.c_str());
+    EXPECT_EQ(static_cast<int>(c_messageCount - (messages.size() - 1)), atoi(dropped.message.c_str()));
+}
+
+TEST(TraceRecorder, RecordsToFile) {
+    NSString* fileName = @"TraceRecorderTests.trace";
+    SCOPE_DELETE_FILE(fileName);
+    const std::string path = [getPathToFile(fileName) UTF8String];
+    ASSERT_TRUE(TraceStartFileRecording(path.c_str(), 0));
+    TraceInfo(L"TraceRecorderTests", L"To a file: %d", 42);
+    TraceStopRecording();
+
+    FILE* file = fopen(path.c_str(), "rb");
+    ASSERT_NE(nullptr, file);
+    std::vector<uint8_t> data;
+    uint8_t buffer[4096];
+    for (size_t read; (read = fread(buffer, 1, sizeof(buffer), file)) > 0;) {
+        data.insert(data.end(), buffer, buffer + read);
+    }
+    fclose(file);
+
+    std::vector<Message> messages = Recording::Decode(data);
+    ASSERT_EQ(1u, messages.size());
+    EXPECT_STREQ("To a file: 42", messages[0].message.c_str());
+}
+
+TEST(TraceRecorder, Performance) {
+    const int c_iterations = 100000;
+    auto nanosecondsPerCall = [](const std::function<void()>& trace) {
+        const auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < c_iterations; ++i) {
+            trace();
+        }
+        return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / c_iterations;
+    };
+
+    TraceSetLevel(TraceLevelWarning);
+    const double disabled = nanosecondsPerCall([]() { TraceVerbose(L"TraceRecorderTests", L"Disabled %d %ws", 42, L"argument"); });
+    TraceSetLevel(TraceLevelVerbose);
+
+    double enabled;
+    {
+        Recording recording(64 * 1024 * 1024);
+        enabled = nanosecondsPerCall([]() { TraceVerbose(L"TraceRecorderTests", L"Enabled %d %ws", 42, L"argument"); });
+    }
+
+    LOG_INFO("TraceVerbose: %.1f ns per filtered call, %.1f ns per recorded call", disabled, enabled);
+    EXPECT_LT(disabled, enabled);
+}
@@ -17,9 +17,16 @@
 #import <TestFramework.h>
 #import <Foundation/Foundation.h>
 #import <Starboard.h>
+#import "NSCacheInternal.h"
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
 
 // Windows-only:
 //      WinObjC_SetZombiesEnabled
+//      -[NSCache _initWithStripeCount:]
 
 TEST(NSCache, AutoreleasedKeys) {
     WinObjC_SetZombiesEnabled(YES);
@@ -47,4 +54,161 @@ TEST(NSCache, AutoreleasedKeys) {
 
     ASSERT_NO_THROW([cache setObject:@"stomp" forKey:@"key-1"]);
     ASSERT_NO_THROW([cache removeObjectForKey:@"key-1"]);
-}
\ No newline at end of file
+}
+
+TEST(NSCache, StripedSanity) {
+    NSCache* cache = nil;
+    ASSERT_NO_THROW(cache = [[[NSCache alloc] _initWithStripeCount:8] autorelease]);
+    for (int i = 0; i < 100; ++i) {
+        EXPECT_NO_THROW([cache setObject:@(i * 2) forKey:@(i)]);
+    }
+
+    for (int i = 0; i < 100; ++i) {
+        EXPECT_OBJCEQ_MSG(@(i * 2), [cache objectForKey:@(i)], "entry %d", i);
+    }
+
+    EXPECT_NO_THROW([cache removeObjectForKey:@(50)]);
+    EXPECT_OBJCEQ(nil, [cache objectForKey:@(50)]);
+
+    EXPECT_NO_THROW([cache removeAllObjects]);
+    for (int i = 0; i < 100; ++i) {
+        EXPECT_OBJCEQ_MSG(nil, [cache objectForKey:@(i)], "entry %d", i);
+    }
+}
+
+TEST(NSCache, StripedLimits) {
+    NSCache* cache = nil;
+    ASSERT_NO_THROW(cache = [[[NSCache alloc] _initWithStripeCount:4] autorelease]);
+    ASSERT_NO_THROW(cache.countLimit = 100);
+    ASSERT_NO_THROW(cache.totalCostLimit = 4000);
+    for (int i = 0; i < 1000; ++i) {
+        EXPECT_NO_THROW([cache setObject:@(i) forKey:@(i) cost:(i % 10)]);
+    }
+
+    // Each shard holds at most its share of the limits, so the whole cache is bounded by them.
+    int count = 0;
+    for (int i = 0; i < 1000; ++i) {
+        if ([cache objectForKey:@(i)] != nil) {
+            ++count;
+        }
+    }
+
+    EXPECT_LE(count, 100);
+    EXPECT_GT(count, 0);
+    EXPECT_OBJCEQ(nil, [cache objectForKey:@(0)]);
+}
+
+TEST(NSCache, StripedHugeLimits) {
+    NSCache* cache = nil;
+    ASSERT_NO_THROW(cache = [[[NSCache alloc] _initWithStripeCount:4] autorelease]);
+    ASSERT_NO_THROW(cache.countLimit = NSUIntegerMax);
+    ASSERT_NO_THROW(cache.totalCostLimit = NSUIntegerMax);
+    for (int i = 0; i < 100; ++i) {
+        EXPECT_NO_THROW([cache setObject:@(i) forKey:@(i) cost:1]);
+    }
+
+    // A shard's share of a limit near NSUIntegerMax must not wrap around to a tiny one.
+    for (int i = 0; i < 100; ++i) {
+        EXPECT_OBJCEQ_MSG(@(i), [cache objectForKey:@(i)], "entry %d", i);
+    }
+}
+
+TEST(NSCache, StripedConcurrentHitMiss) {
+    NSCache* cache = nil;
+    ASSERT_NO_THROW(cache = [[[NSCache alloc] _initWithStripeCount:8] autorelease]);
+    ASSERT_NO_THROW(cache.countLimit = 256);
+
+    std::atomic<int> hits(0);
+    std::atomic<int> wrongValues(0);
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 8; ++t) {
+        threads.emplace_back([cache, t, &hits, &wrongValues]() {
+            @autoreleasepool {
+                for (int i = 0; i < 5000; ++i) {
+                    const int key = (i * 7 + t * 131) % 512;
+                    id value = [cache objectForKey:@(key)];
+                    if (value == nil) {
+                        [cache setObject:@(key + 1) forKey:@(key)];
+                    } else {
+                        ++hits;
+                        if ([value intValue] != key + 1) {
+                            ++wrongValues;
+                        }
+                    }
+
+                    if ((i % 1000) == 999) {
+                        [cache removeObjectForKey:@(key)];
+                    }
+                }
+            }
+        });
+    }
+
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    EXPECT_GT(hits.load(), 0);
+    EXPECT_EQ(0, wrongValues.load());
+}
+
+// Hit/miss throughput from one to eight threads, for a single-shard cache and for the default one striped by core count
+TEST(NSCache, ConcurrentHitMissPerformance) {
+    const int c_keyCount = 16384;
+    const int c_operationsPerThread = 200000;
+
+    std::vector<id> keys;
+    for (int i = 0; i < c_keyCount; ++i) {
+        keys.emplace_back([@(i) retain]);
+    }
+
+    for (int striped = 0; striped < 2; ++striped) {
+        for (int threadCount = 1; threadCount <= 8; threadCount *= 2) {
+            NSCache* cache = striped ? [NSCache new] : [[NSCache alloc] _initWithStripeCount:1];
+            std::atomic<int> hits(0);
+            std::vector<std::thread> threads;
+            const auto start = std::chrono::steady_clock::now();
+            for (int t = 0; t < threadCount; ++t) {
+                threads.emplace_back([cache, t, &keys, &hits]() {
+                    @autoreleasepool {
+                        int threadHits = 0;
+                        uint32_t seed = 2654435761u * (t + 1);
+                        for (int i = 0; i < c_operationsPerThread; ++i) {
+                            seed = seed * 1664525 + 1013904223;
+                            id key = keys[(seed >> 8) % c_keyCount];
+
+                            //  Every eighth operation removes its key, so lookups keep missing as well as hitting
+                            if ((i % 8) == 7) {
+                                [cache removeObjectForKey:key];
+                            } else if ([cache objectForKey:key] != nil) {
+                                ++threadHits;
+                            } else {
+                                [cache setObject:key forKey:key];
+                            }
+                        }
+
+                        hits += threadHits;
+                    }
+                });
+            }
+
+            for (auto& thread : threads) {
+                thread.join();
+            }
+
+            const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+            const double operations = static_cast<double>(threadCount) * c_operationsPerThread;
+            LOG_INFO("%s cache, %d thread(s): %.2f million operations/s, %.0f%% hits",
+                     striped ? "Striped" : "Single-shard",
+                     threadCount,
+                     operations / seconds / 1e6,
+                     100.0 * hits / (operations * 7 / 8));
+            EXPECT_GT(hits.load(), 0);
+            [cache release];
+        }
+    }
+
+    for (id key : keys) {
+        [key release];
+    }
+}
@@ -0,0 +1,259 @@
+//******************************************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+//
+// This code is licensed under the MIT License (MIT).
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+//******************************************************************************
+
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#undef WIN32
+
+#import <TestFramework.h>
+#import <Foundation/Foundation.h>
+#import <Starboard.h>
+#import "NSSelectInputSource.h"
+#import "NSRunLoop+Internal.h"
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+// Windows-only:
+//      NSSelectInputSource
+//      -[NSRunLoop _addInputSource:forMode:]
+
+@interface NSRunLoopSocketTestReader : NSObject {
+@public
+    std::atomic<size_t> _bytesRead;
+    std::atomic<size_t> _wakeups;
+}
+@end
+
+@implementation NSRunLoopSocketTestReader
+- (void)selectInputSource:(NSSelectInputSource*)source selectEvent:(DWORD)selectEvent {
+    char buffer[4096];
+    int count = recv(static_cast<SOCKET>([source descriptor]), buffer, sizeof(buffer), 0);
+    if (count > 0) {
+        _bytesRead += count;
+    }
+
+    ++_wakeups;
+}
+@end
+
+namespace {
+
+struct SocketPair {
+    SOCKET reader;
+    SOCKET writer;
+};
+
+class LoopbackSockets {
+public:
+    explicit LoopbackSockets(size_t count) {
+        WSADATA data;
+        WSAStartup(MAKEWORD(2, 2), &data);
+
+        SOCKET listener = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+        sockaddr_in address = {};
+        address.sin_family = AF_INET;
+        address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        int addressLength = sizeof(address);
+        bind(listener, reinterpret_cast<sockaddr*>(&address), addressLength);
+        getsockname(listener, reinterpret_cast<sockaddr*>(&address), &addressLength);
+        listen(listener, SOMAXCONN);
+
+        for (size_t i = 0; i < count; ++i) {
+            SocketPair pair;
+            pair.writer = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+            connect(pair.writer, reinterpret_cast<sockaddr*>(&address), addressLength);
+            pair.reader = accept(listener, nullptr, nullptr);
+
+            BOOL noDelay = TRUE;
+            setsockopt(pair.writer, IPPROTO_TCP, TCP_NODELAY, reinterpret_cast<const char*>(&noDelay), sizeof(noDelay));
+            pairs.push_back(pair);
+        }
+
+        closesocket(listener);
+    }
+
+    ~LoopbackSockets() {
+        for (const SocketPair& pair : pairs) {
+            closesocket(pair.reader);
+            closesocket(pair.writer);
+        }
+
+        WSACleanup();
+    }
+
+    std::vector<SocketPair> pairs;
+};
+
+// Services read sources for every pair on a run loop of its own thread; sockets are only dispatched off the main thread
+class SocketRunLoopThread {
+public:
+    SocketRunLoopThread(const LoopbackSockets& sockets, NSRunLoopSocketTestReader* reader) : _stop(false), _ready(false) {
+        _thread = std::thread([this, &sockets, reader]() {
+            NSAutoreleasePool* pool = [NSAutoreleasePool new];
+            NSRunLoop* runLoop = [NSRunLoop currentRunLoop];
+
+            std::vector<NSSelectInputSource*> sources;
+            for (const SocketPair& pair : sockets.pairs) {
+                NSSelectInputSource* source = [[NSSelectInputSource alloc] initWithDescriptor:static_cast<int>(pair.reader)];
+                [source setDelegate:reader];
+                [source setSelectEventMask:NSSelectReadEvent];
+                [runLoop _addInputSource:source forMode:NSDefaultRunLoopMode];
+                sources.push_back(source);
+            }
+
+            _ready = true;
+            while (!_stop) {
+                [runLoop runMode:NSDefaultRunLoopMode beforeDate:[NSDate dateWithTimeIntervalSinceNow:0.05]];
+            }
+
+            for (NSSelectInputSource* source : sources) {
+                [runLoop _removeInputSource:source forMode:NSDefaultRunLoopMode];
+                [source release];
+            }
+
+            [pool release];
+        });
+
+        while (!_ready) {
+            std::this_thread::yield();
+        }
+    }
+
+    ~SocketRunLoopThread() {
+        _stop = true;
+        _thread.join();
+    }
+
+private:
+    std::atomic<bool> _stop;
+    std::atomic<bool> _ready;
+    std::thread _thread;
+};
+
+bool waitForBytes(NSRunLoopSocketTestReader* reader, size_t expected) {
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+    while (reader->_bytesRead < expected) {
+        if (std::chrono::steady_clock::now() > deadline) {
+            return false;
+        }
+
+        std::this_thread::yield();
+    }
+
+    return true;
+}
+
+} // namespace
+
+TEST(NSRunLoop, SocketSourcesDeliverReads) {
+    LoopbackSockets sockets(16);
+    NSRunLoopSocketTestReader* reader = [[NSRunLoopSocketTestReader new] autorelease];
+    SocketRunLoopThread thread(sockets, reader);
+
+    const char message[] = "hello";
+    for (const SocketPair& pair : sockets.pairs) {
+        ASSERT_EQ(static_cast<int>(sizeof(message)), send(pair.writer, message, sizeof(message), 0));
+    }
+
+    ASSERT_TRUE_MSG(waitForBytes(reader, sizeof(message) * sockets.pairs.size()), "FAILED: not every socket was serviced");
+    EXPECT_EQ(sizeof(message) * sockets.pairs.size(), reader->_bytesRead.load());
+}
+
+TEST(NSRunLoop, ManySocketSourcesPerformance) {
+    const size_t c_pairCount = 1000;
+    const size_t c_pingCount = 200;
+
+    LoopbackSockets sockets(c_pairCount);
+    ASSERT_EQ(c_pairCount, sockets.pairs.size());
+
+    NSRunLoopSocketTestReader* reader = [[NSRunLoopSocketTestReader new] autorelease];
+    SocketRunLoopThread thread(sockets, reader);
+
+    //  Wakeup latency: one byte at a time on a single socket among many idle ones
+    const SocketPair& pinged = sockets.pairs[c_pairCount / 2];
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < c_pingCount; ++i) {
+        ASSERT_EQ(1, send(pinged.writer, "x", 1, 0));
+        ASSERT_TRUE(waitForBytes(reader, i + 1));
+    }
+
+    auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start);
+    LOG_INFO("%zu sockets: %.1f us per single-socket wakeup", c_pairCount, static_cast<double>(elapsed.count()) / c_pingCount);
+
+    //  Throughput: every socket readable at once
+    const char payload[64] = {};
+    start = std::chrono::steady_clock::now();
+    for (const SocketPair& pair : sockets.pairs) {
+        ASSERT_EQ(static_cast<int>(sizeof(payload)), send(pair.writer, payload, sizeof(payload), 0));
+    }
+
+    ASSERT_TRUE(waitForBytes(reader, c_pingCount + sizeof(payload) * c_pairCount));
+    elapsed = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start);
+    LOG_INFO("%zu sockets: %lld us to service all of them (%zu dispatches)",
+             c_pairCount,
+             static_cast<long long>(elapsed.count()),
+             reader->_wakeups.load());
+}
+
+TEST(NSRunLoop, SocketSourceReportsFailedConnect) {
+    WSADATA data;
+    WSAStartup(MAKEWORD(2, 2), &data);
+
+    //  A loopback port that nothing listens on
+    SOCKET unused = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+    sockaddr_in address = {};
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    int addressLength = sizeof(address);
+    bind(unused, reinterpret_cast<sockaddr*>(&address), addressLength);
+    getsockname(unused, reinterpret_cast<sockaddr*>(&address), &addressLength);
+    closesocket(unused);
+
+    SOCKET connecting = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+    u_long nonBlocking = 1;
+    ioctlsocket(connecting, FIONBIO, &nonBlocking);
+    ASSERT_EQ(SOCKET_ERROR, connect(connecting, reinterpret_cast<sockaddr*>(&address), addressLength));
+    ASSERT_EQ(WSAEWOULDBLOCK, WSAGetLastError());
+
+    //  One long wait, which the failed connect has to end; WSAPoll alone doesn't report it on older versions of Windows
+    NSRunLoopSocketTestReader* reader = [[NSRunLoopSocketTestReader new] autorelease];
+    const auto start = std::chrono::steady_clock::now();
+    std::thread thread([connecting, reader]() {
+        NSAutoreleasePool* pool = [NSAutoreleasePool new];
+        NSRunLoop* runLoop = [NSRunLoop currentRunLoop];
+
+        NSSelectInputSource* source = [[NSSelectInputSource alloc] initWithDescriptor:static_cast<int>(connecting)];
+        [source setDelegate:reader];
+        [source setSelectEventMask:NSSelectWriteEvent | NSSelectExceptEvent];
+        [runLoop _addInputSource:source forMode:NSDefaultRunLoopMode];
+
+        [runLoop runMode:NSDefaultRunLoopMode beforeDate:[NSDate dateWithTimeIntervalSinceNow:30.0]];
+
+        [runLoop _removeInputSource:source forMode:NSDefaultRunLoopMode];
+        [source release];
+        [pool release];
+    });
+    thread.join();
+
+    EXPECT_LT(0u, reader->_wakeups.load());
+    EXPECT_GT(std::chrono::seconds(20), std::chrono::steady_clock::now() - start);
+
+    closesocket(connecting);
+    WSACleanup();
+}
@@ -0,0 +1,202 @@
+//******************************************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+//
+// This code is licensed under the MIT License (MIT).
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+//******************************************************************************
+
+#include <TestFramework.h>
+
+#include "LayerBackingStore.h"
+
+#include <vector>
+
+namespace {
+
+// Stands in for a layer's backing store on the CPU: each frame takes the layer's dirty region and visible rect the way
+// -display does, and counts the pixels it rasterizes, each pixel once however many dirty rects cover it.
+class RasterizedPixelCounter {
+public:
+    RasterizedPixelCounter(CGSize size, float scale, int tileSize)
+        : _bounds(CGRectMake(0.0f, 0.0f, size.width, size.height)),
+          _scale(scale),
+          _width(static_cast<int>(size.width * scale)),
+          _height(static_cast<int>(size.height * scale)),
+          _grid(_width, _height, tileSize, tileSize),
+          _drawn(static_cast<size_t>(_width) * _height, 0) {
+    }
+
+    // Draws a frame showing visibleRect, in points, and returns the number of pixels rasterized
+    int64_t Frame(const LayerDirtyRegion& dirty, const CGRect& visibleRect) {
+        const LayerPixelRect whole = { 0, 0, _width, _height };
+        std::vector<LayerPixelRect> dirtyRects;
+        dirty.GetPixelRects(_bounds, _scale, whole, dirtyRects);
+
+        std::vector<LayerTileUpdate> updates;
+        std::vector<size_t> discarded;
+        _grid.Update(dirtyRects, LayerPixelRect::FromLayerRect(visibleRect, _bounds, _scale).Intersection(whole), updates, discarded);
+
+        ++_frame;
+        int64_t pixels = 0;
+        for (const LayerTileUpdate& update : updates) {
+            for (const LayerPixelRect& rect : update.rects) {
+                pixels += fill(rect);
+            }
+        }
+
+        return pixels;
+    }
+
+    const LayerTileGrid& Grid() const {
+        return _grid;
+    }
+
+private:
+    int64_t fill(const LayerPixelRect& rect) {
+        int64_t pixels = 0;
+        for (int y = rect.y; y < rect.y + rect.height; ++y) {
+            for (int x = rect.x; x < rect.x + rect.width; ++x) {
+                uint32_t& pixel = _drawn[static_cast<size_t>(y) * _width + x];
+                if (pixel != _frame) {
+                    pixel = _frame;
+                    ++pixels;
+                }
+            }
+        }
+
+        return pixels;
+    }
+
+    CGRect _bounds;
+    float _scale;
+    int _width;
+    int _height;
+    LayerTileGrid _grid;
+    std::vector<uint32_t> _drawn;
+    uint32_t _frame = 0;
+};
+
+LayerDirtyRegion EmptyRegion() {
+    LayerDirtyRegion region = {};
+    return region;
+}
+
+LayerDirtyRegion RegionWithRect(const CGRect& rect) {
+    LayerDirtyRegion region = EmptyRegion();
+    region.Add(rect);
+    return region;
+}
+
+} // namespace
+
+TEST(LayerBackingStore, DirtyRegionMergesRects) {
+    LayerDirtyRegion region = EmptyRegion();
+    EXPECT_TRUE(region.IsEmpty());
+
+    region.Add(CGRectMake(0.0f, 0.0f, 10.0f, 10.0f));
+    region.Add(CGRectMake(2.0f, 2.0f, 4.0f, 4.0f));
+    EXPECT_EQ(1u, region.Count());
+
+    region.Add(CGRectMake(-5.0f, -5.0f, 20.0f, 20.0f));
+    ASSERT_EQ(1u, region.Count());
+    EXPECT_FLOAT_EQ(20.0f, region.Rects()[0].size.width);
+
+    //  Once out of rects, new ones are merged into the nearest
+    const size_t c_maxRects = LayerDirtyRegion::c_maxRects;
+    for (size_t i = 1; i < c_maxRects; ++i) {
+        region.Add(CGRectMake(100.0f * i, 0.0f, 10.0f, 10.0f));
+    }
+    EXPECT_EQ(c_maxRects, region.Count());
+
+    region.Add(CGRectMake(705.0f, 0.0f, 10.0f, 10.0f));
+    ASSERT_EQ(c_maxRects, region.Count());
+    EXPECT_FLOAT_EQ(15.0f, region.Rects()[c_maxRects - 1].size.width);
+
+    region.AddAll();
+    EXPECT_TRUE(region.IsAll());
+    EXPECT_EQ(0u, region.Count());
+
+    region.Clear();
+    EXPECT_TRUE(region.IsEmpty());
+}
+
+TEST(LayerBackingStore, PixelRectsRoundOutwards) {
+    const CGRect bounds = CGRectMake(10.0f, 20.0f, 100.0f, 100.0f);
+    const LayerPixelRect rect = LayerPixelRect::FromLayerRect(CGRectMake(10.5f, 20.25f, 1.0f, 1.0f), bounds, 2.0f);
+    EXPECT_EQ(1, rect.x);
+    EXPECT_EQ(0, rect.y);
+    EXPECT_EQ(2, rect.width);
+    EXPECT_EQ(3, rect.height);
+}
+
+TEST(LayerBackingStore, SmallLayerRasterizesOnlyDirtyPixels) {
+    //  A 320x480 @2x layer fits a single tile, as an untiled layer's one backing store
+    RasterizedPixelCounter layer(CGSizeMake(320.0f, 480.0f), 2.0f, 2048);
+    const CGRect screen = CGRectMake(0.0f, 0.0f, 320.0f, 480.0f);
+    ASSERT_EQ(1u, layer.Grid().Count());
+
+    EXPECT_EQ(640 * 960, layer.Frame(EmptyRegion(), screen));
+
+    //  Nothing invalidated, nothing drawn
+    EXPECT_EQ(0, layer.Frame(EmptyRegion(), screen));
+
+    //  A blinking caret
+    EXPECT_EQ(4 * 40, layer.Frame(RegionWithRect(CGRectMake(100.0f, 200.0f, 2.0f, 20.0f)), screen));
+
+    //  Two overlapping rects draw their union once
+    LayerDirtyRegion overlapping = EmptyRegion();
+    overlapping.Add(CGRectMake(0.0f, 0.0f, 20.0f, 20.0f));
+    overlapping.Add(CGRectMake(10.0f, 10.0f, 20.0f, 20.0f));
+    EXPECT_EQ(40 * 40 * 2 - 20 * 20, layer.Frame(overlapping, screen));
+
+    LayerDirtyRegion all = EmptyRegion();
+    all.AddAll();
+    EXPECT_EQ(640 * 960, layer.Frame(all, screen));
+}
+
+TEST(LayerBackingStore, TiledLayerRasterizesOnlyVisibleDirtyTiles) {
+    //  A 320x5000 @2x layer, past the old 2048 pixel cap, scrolled through a 320x480 window
+    const int c_tileSize = 512;
+    RasterizedPixelCounter layer(CGSizeMake(320.0f, 5000.0f), 2.0f, c_tileSize);
+    ASSERT_EQ(2u * 20u, layer.Grid().Count());
+
+    //  The first frame draws the two tile rows the window covers, not the 10000 pixel tall whole
+    EXPECT_EQ(640 * 1024, layer.Frame(EmptyRegion(), CGRectMake(0.0f, 0.0f, 320.0f, 480.0f)));
+    EXPECT_TRUE(layer.Grid().IsValid(0));
+    EXPECT_FALSE(layer.Grid().IsValid(4));
+
+    //  Scrolling down a screen brings in three new rows of tiles
+    const CGRect scrolled = CGRectMake(0.0f, 600.0f, 320.0f, 480.0f);
+    EXPECT_EQ(640 * 1536, layer.Frame(EmptyRegion(), scrolled));
+    EXPECT_EQ(0, layer.Frame(EmptyRegion(), scrolled));
+
+    //  Invalidating a rect straddling two visible tiles redraws just that rect
+    EXPECT_EQ(40 * 40, layer.Frame(RegionWithRect(CGRectMake(246.0f, 700.0f, 20.0f, 20.0f)), scrolled));
+
+    //  Invalidating something off screen draws nothing, but empties its tile to be drawn whole when scrolled back
+    EXPECT_EQ(0, layer.Frame(RegionWithRect(CGRectMake(0.0f, 0.0f, 10.0f, 10.0f)), scrolled));
+    EXPECT_FALSE(layer.Grid().IsValid(0));
+    EXPECT_TRUE(layer.Grid().IsValid(1));
+    EXPECT_EQ(512 * 512, layer.Frame(EmptyRegion(), CGRectMake(0.0f, 0.0f, 320.0f, 480.0f)));
+
+    //  setNeedsDisplay redraws what's visible and drops the rest
+    LayerDirtyRegion all = EmptyRegion();
+    all.AddAll();
+    EXPECT_EQ(640 * 1024, layer.Frame(all, CGRectMake(0.0f, 0.0f, 320.0f, 480.0f)));
+    EXPECT_FALSE(layer.Grid().IsValid(4));
+    EXPECT_TRUE(layer.Grid().NeedsUpdate({ 0, 600, 640, 960 }));
+    EXPECT_FALSE(layer.Grid().NeedsUpdate({ 0, 0, 640, 960 }));
+
+    //  The tiles along the bottom edge are cut down to the layer
+    EXPECT_EQ(10000 - 19 * c_tileSize, layer.Grid().TileRect(39).height);
+    EXPECT_EQ(640 - c_tileSize, layer.Grid().TileRect(39).width);
+}
@@ -17,6 +17,8 @@
 #include <TestFramework.h>
 #include <windows.h>
 #include <CommonCrypto/CommonCrypto.h>
+#include <chrono>
+#include <functional>
 #include <string>
 #include <vector>
 #include "ByteUtils.h"
@@ -33,11 +35,11 @@ static const char longKey[] =
 
 /* CommonDigest Tests */
 
-void _sanity(int (*init)(CC_Digest_State**),
-             int (*update)(CC_Digest_State** ctx, const void* data, CC_LONG len),
-             int (*final)(unsigned char* digest, CC_Digest_State** ctx),
+void _sanity(int (*init)(CC_Digest_State*),
+             int (*update)(CC_Digest_State* ctx, const void* data, CC_LONG len),
+             int (*final)(unsigned char* digest, CC_Digest_State* ctx),
              unsigned digestLength) {
-    CC_Digest_State* ctx;
+    CC_Digest_State ctx;
     std::vector<unsigned char> digest(digestLength);
 
     ASSERT_EQ_MSG(init(&ctx), 1, "FAILED: init returned incorrect value");
@@ -46,11 +48,11 @@ void _sanity(int (*init)(CC_Digest_State**),
     logBytes(singleLine, digest.data(), digestLength);
 }
 
-void _sameDataYieldsSameDigest(int (*init)(CC_Digest_State**),
-                               int (*update)(CC_Digest_State** ctx, const void* data, CC_LONG len),
-                               int (*final)(unsigned char* digest, CC_Digest_State** ctx),
+void _sameDataYieldsSameDigest(int (*init)(CC_Digest_State*),
+                               int (*update)(CC_Digest_State* ctx, const void* data, CC_LONG len),
+                               int (*final)(unsigned char* digest, CC_Digest_State* ctx),
                                unsigned digestLength) {
-    CC_Digest_State* ctx;
+    CC_Digest_State ctx;
     std::vector<unsigned char> digest1(digestLength);
     std::vector<unsigned char> digest2(digestLength);
 
@@ -67,11 +69,11 @@ void _sameDataYieldsSameDigest(int (*init)(CC_Digest_State**),
     ASSERT_TRUE_MSG(equalsBytes(digest1.data(), digest2.data(), digestLength), "FAILED: same data should yield same result");
 }
 
-void _multipleUpdatesYieldsSameDigest(int (*init)(CC_Digest_State**),
-                                      int (*update)(CC_Digest_State** ctx, const void* data, CC_LONG len),
-                                      int (*final)(unsigned char* digest, CC_Digest_State** ctx),
+void _multipleUpdatesYieldsSameDigest(int (*init)(CC_Digest_State*),
+                                      int (*update)(CC_Digest_State* ctx, const void* data, CC_LONG len),
+                                      int (*final)(unsigned char* digest, CC_Digest_State* ctx),
                                       unsigned digestLength) {
-    CC_Digest_State* ctx;
+    CC_Digest_State ctx;
     std::vector<unsigned char> digest1(digestLength);
     std::vector<unsigned char> digest2(digestLength);
 
@@ -91,9 +93,9 @@ void _multipleUpdatesYieldsSameDigest(int (*init)(CC_Digest_State**),
                     "FAILED: multiple updates using same data should yield same result");
 }
 
-class DigestTest : public ::testing::TestWithParam<::testing::tuple<int (*)(CC_Digest_State**),
-                                                                    int (*)(CC_Digest_State** ctx, const void* data, CC_LONG len),
-                                                                    int (*)(unsigned char* digest, CC_Digest_State** ctx),
+class DigestTest : public ::testing::TestWithParam<::testing::tuple<int (*)(CC_Digest_State*),
+                                                                    int (*)(CC_Digest_State* ctx, const void* data, CC_LONG len),
+                                                                    int (*)(unsigned char* digest, CC_Digest_State* ctx),
                                                                     unsigned>> {};
 
 TEST_P(DigestTest, Sanity) {
@@ -121,16 +123,17 @@ INSTANTIATE_TEST_CASE_P(
                       ::testing::make_tuple(CC_MD4_Init, CC_MD4_Update, CC_MD4_Final, CC_MD4_DIGEST_LENGTH),
                       ::testing::make_tuple(CC_MD5_Init, CC_MD5_Update, CC_MD5_Final, CC_MD5_DIGEST_LENGTH),
                       ::testing::make_tuple(CC_SHA1_Init, CC_SHA1_Update, CC_SHA1_Final, CC_SHA1_DIGEST_LENGTH),
+                      ::testing::make_tuple(CC_SHA224_Init, CC_SHA224_Update, CC_SHA224_Final, CC_SHA224_DIGEST_LENGTH),
                       ::testing::make_tuple(CC_SHA256_Init, CC_SHA256_Update, CC_SHA256_Final, CC_SHA256_DIGEST_LENGTH),
                       ::testing::make_tuple(CC_SHA384_Init, CC_SHA384_Update, CC_SHA384_Final, CC_SHA384_DIGEST_LENGTH),
                       ::testing::make_tuple(CC_SHA512_Init, CC_SHA512_Update, CC_SHA512_Final, CC_SHA512_DIGEST_LENGTH)));
 
-void _oneShotYieldsSameDigestAsUpdate(int (*init)(CC_Digest_State**),
-                                      int (*update)(CC_Digest_State** ctx, const void* data, CC_LONG len),
-                                      int (*final)(unsigned char* digest, CC_Digest_State** ctx),
+void _oneShotYieldsSameDigestAsUpdate(int (*init)(CC_Digest_State*),
+                                      int (*update)(CC_Digest_State* ctx, const void* data, CC_LONG len),
+                                      int (*final)(unsigned char* digest, CC_Digest_State* ctx),
                                       unsigned char* (*oneShot)(const void* data, CC_LONG len, unsigned char* md),
                                       unsigned digestLength) {
-    CC_Digest_State* ctx;
+    CC_Digest_State ctx;
     std::vector<unsigned char> digest1(digestLength);
     std::vector<unsigned char> digest2(digestLength);
 
@@ -145,9 +148,9 @@ void _oneShotYieldsSameDigestAsUpdate(int (*init)(CC_Digest_State**),
     ASSERT_TRUE_MSG(equalsBytes(digest1.data(), digest2.data(), digestLength), "FAILED: one shot should yield same result");
 }
 
-class DigestTest2 : public ::testing::TestWithParam<::testing::tuple<int (*)(CC_Digest_State**),
-                                                                     int (*)(CC_Digest_State** ctx, const void* data, CC_LONG len),
-                                                                     int (*)(unsigned char* digest, CC_Digest_State** ctx),
+class DigestTest2 : public ::testing::TestWithParam<::testing::tuple<int (*)(CC_Digest_State*),
+                                                                     int (*)(CC_Digest_State* ctx, const void* data, CC_LONG len),
+                                                                     int (*)(unsigned char* digest, CC_Digest_State* ctx),
                                                                      unsigned char* (*)(const void*, CC_LONG, unsigned char*),
                                                                      unsigned>> {};
 
@@ -166,16 +169,174 @@ INSTANTIATE_TEST_CASE_P(
                       ::testing::make_tuple(CC_MD4_Init, CC_MD4_Update, CC_MD4_Final, CC_MD4, CC_MD4_DIGEST_LENGTH),
                       ::testing::make_tuple(CC_MD5_Init, CC_MD5_Update, CC_MD5_Final, CC_MD5, CC_MD5_DIGEST_LENGTH),
                       ::testing::make_tuple(CC_SHA1_Init, CC_SHA1_Update, CC_SHA1_Final, CC_SHA1, CC_SHA1_DIGEST_LENGTH),
+                      ::testing::make_tuple(CC_SHA224_Init, CC_SHA224_Update, CC_SHA224_Final, CC_SHA224, CC_SHA224_DIGEST_LENGTH),
                       ::testing::make_tuple(CC_SHA256_Init, CC_SHA256_Update, CC_SHA256_Final, CC_SHA256, CC_SHA256_DIGEST_LENGTH),
                       ::testing::make_tuple(CC_SHA384_Init, CC_SHA384_Update, CC_SHA384_Final, CC_SHA384, CC_SHA384_DIGEST_LENGTH),
                       ::testing::make_tuple(CC_SHA512_Init, CC_SHA512_Update, CC_SHA512_Final, CC_SHA512, CC_SHA512_DIGEST_LENGTH)));
 
+static std::string _hexDigest(const unsigned char* digest, size_t length) {
+    static const char c_hex[] = "0123456789abcdef";
+    std::string hex;
+    for (size_t i = 0; i < length; ++i) {
+        hex.push_back(c_hex[digest[i] >> 4]);
+        hex.push_back(c_hex[digest[i] & 0xf]);
+    }
+
+    return hex;
+}
+
+static std::string _oneShotHex(unsigned char* (*oneShot)(const void*, CC_LONG, unsigned char*),
+                               unsigned digestLength,
+                               const char* message) {
+    std::vector<unsigned char> digest(digestLength);
+    oneShot(message, static_cast<CC_LONG>(strlen(message)), digest.data());
+    return _hexDigest(digest.data(), digestLength);
+}
+
+TEST(CommonDigest, KnownAnswers) {
+    static const char c_longMessage[] = "abcdbcdecdefdefgefghfghighijhijkijkljklmklmnlmnomnopnopq";
+
+    EXPECT_STREQ("8350e5a3e24c153df2275c9f80692773", _oneShotHex(CC_MD2, CC_MD2_DIGEST_LENGTH, "").c_str());
+    EXPECT_STREQ("da853b0d3f88d99b30283a69e6ded6bb", _oneShotHex(CC_MD2, CC_MD2_DIGEST_LENGTH, "abc").c_str());
+    EXPECT_STREQ("ab4f496bfb2a530b219ff33031fe06b0", _oneShotHex(CC_MD2, CC_MD2_DIGEST_LENGTH, "message digest").c_str());
+    EXPECT_STREQ("31d6cfe0d16ae931b73c59d7e0c089c0", _oneShotHex(CC_MD4, CC_MD4_DIGEST_LENGTH, "").c_str());
+    EXPECT_STREQ("a448017aaf21d8525fc10ae87aa6729d", _oneShotHex(CC_MD4, CC_MD4_DIGEST_LENGTH, "abc").c_str());
+    EXPECT_STREQ("900150983cd24fb0d6963f7d28e17f72", _oneShotHex(CC_MD5, CC_MD5_DIGEST_LENGTH, "abc").c_str());
+    EXPECT_STREQ("8215ef0796a20bcaaae116d3876c664a", _oneShotHex(CC_MD5, CC_MD5_DIGEST_LENGTH, c_longMessage).c_str());
+    EXPECT_STREQ("a9993e364706816aba3e25717850c26c9cd0d89d", _oneShotHex(CC_SHA1, CC_SHA1_DIGEST_LENGTH, "abc").c_str());
+    EXPECT_STREQ("84983e441c3bd26ebaae4aa1f95129e5e54670f1", _oneShotHex(CC_SHA1, CC_SHA1_DIGEST_LENGTH, c_longMessage).c_str());
+    EXPECT_STREQ("23097d223405d8228642a477bda255b32aadbce4bda0b3f7e36c9da7",
+                 _oneShotHex(CC_SHA224, CC_SHA224_DIGEST_LENGTH, "abc").c_str());
+    EXPECT_STREQ("248d6a61d20638b8e5c026930c3e6039a33ce45964ff2167f6ecedd419db06c1",
+                 _oneShotHex(CC_SHA256, CC_SHA256_DIGEST_LENGTH, c_longMessage).c_str());
+    EXPECT_STREQ("cb00753f45a35e8bb5a03d699ac65007272c32ab0eded1631a8b605a43ff5bed8086072ba1e7cc2358baeca134c825a7",
+                 _oneShotHex(CC_SHA384, CC_SHA384_DIGEST_LENGTH, "abc").c_str());
+    EXPECT_STREQ("204a8fc6dda82f0a0ced7beb8e08a41657c16ef468b228a8279be331a703c335"
+                 "96fd15c13b1b07f9aa1d3bea57789ca031ad85c7a71dd70354ec631238ca3445",
+                 _oneShotHex(CC_SHA512, CC_SHA512_DIGEST_LENGTH, c_longMessage).c_str());
+}
+
+TEST(CommonDigest, MillionBytesInOddUpdates) {
+    std::vector<char> message(1000000, 'a');
+    CC_SHA256_CTX ctx;
+    ASSERT_EQ(1, CC_SHA256_Init(&ctx));
+
+    size_t offset = 0;
+    for (CC_LONG step = 1; offset < message.size(); step = (step * 7 + 3) % 997) {
+        const CC_LONG length = static_cast<CC_LONG>(std::min<size_t>(step, message.size() - offset));
+        ASSERT_EQ(1, CC_SHA256_Update(&ctx, message.data() + offset, length));
+        offset += length;
+    }
+
+    unsigned char digest[CC_SHA256_DIGEST_LENGTH];
+    ASSERT_EQ(1, CC_SHA256_Final(digest, &ctx));
+    EXPECT_STREQ("cdc76e5c9914fb9281a1c7e284d73e67f1809a48a497200e046d39ccc7112cd0", _hexDigest(digest, sizeof(digest)).c_str());
+}
+
+TEST(CommonDigest, EmptyUpdatesAcceptNull) {
+    CC_SHA256_CTX ctx;
+    ASSERT_EQ(1, CC_SHA256_Init(&ctx));
+    ASSERT_EQ(1, CC_SHA256_Update(&ctx, nullptr, 0));
+    ASSERT_EQ(1, CC_SHA256_Update(&ctx, "ab", 2));
+    ASSERT_EQ(1, CC_SHA256_Update(&ctx, nullptr, 0));
+    ASSERT_EQ(1, CC_SHA256_Update(&ctx, "c", 1));
+
+    unsigned char digest[CC_SHA256_DIGEST_LENGTH];
+    ASSERT_EQ(1, CC_SHA256_Final(digest, &ctx));
+    EXPECT_STREQ("ba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad", _hexDigest(digest, sizeof(digest)).c_str());
+}
+
+typedef void (*MultiDigestFunction)(const void* const* data, const CC_LONG* len, size_t count, unsigned char* md);
+
+typedef unsigned char* (*OneShotDigestFunction)(const void* data, CC_LONG len, unsigned char* md);
+
+class DigestMultiTest : public ::testing::TestWithParam<::testing::tuple<MultiDigestFunction, OneShotDigestFunction, unsigned>> {};
+
+TEST_P(DigestMultiTest, MultiBufferMatchesOneShot) {
+    auto multi = ::testing::get<0>(GetParam());
+    auto oneShot = ::testing::get<1>(GetParam());
+    const unsigned digestLength = ::testing::get<2>(GetParam());
+
+    //  Mixed lengths around the padding boundaries, so that lanes finish at different times
+    std::vector<std::vector<unsigned char>> messages;
+    for (size_t length = 0; length < 300; length += (length < 130) ? 1 : 17) {
+        std::vector<unsigned char> message(length);
+        for (size_t i = 0; i < length; ++i) {
+            message[i] = static_cast<unsigned char>(i * 31 + length);
+        }
+
+        messages.push_back(message);
+    }
+
+    std::vector<const void*> data;
+    std::vector<CC_LONG> lengths;
+    for (const auto& message : messages) {
+        data.push_back(message.data());
+        lengths.push_back(static_cast<CC_LONG>(message.size()));
+    }
+
+    std::vector<unsigned char> digests(messages.size() * digestLength);
+    multi(data.data(), lengths.data(), messages.size(), digests.data());
+
+    std::vector<unsigned char> expected(digestLength);
+    for (size_t i = 0; i < messages.size(); ++i) {
+        oneShot(data[i], lengths[i], expected.data());
+        ASSERT_TRUE_MSG(equalsBytes(expected.data(), digests.data() + i * digestLength, digestLength),
+                        "FAILED: multi-buffer digest %zu differs from the one-shot digest",
+                        i);
+    }
+}
+
+TEST_P(DigestMultiTest, Throughput) {
+    auto multi = ::testing::get<0>(GetParam());
+    auto oneShot = ::testing::get<1>(GetParam());
+    const unsigned digestLength = ::testing::get<2>(GetParam());
+
+    const size_t c_totalBytes = 64 * 1024 * 1024;
+    std::vector<unsigned char> buffer(c_totalBytes, 0x5a);
+    std::vector<unsigned char> digests((c_totalBytes / 64) * digestLength);
+
+    for (size_t messageLength = 64; messageLength <= c_totalBytes; messageLength *= 16) {
+        const size_t count = c_totalBytes / messageLength;
+
+        auto start = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < count; ++i) {
+            oneShot(buffer.data() + i * messageLength, static_cast<CC_LONG>(messageLength), digests.data() + i * digestLength);
+        }
+
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        LOG_INFO("%u byte digest, %zu byte messages: %.1f MB/s", digestLength, messageLength, c_totalBytes / seconds / 1e6);
+
+        if (messageLength <= 4096) {
+            std::vector<const void*> data(count);
+            std::vector<CC_LONG> lengths(count, static_cast<CC_LONG>(messageLength));
+            for (size_t i = 0; i < count; ++i) {
+                data[i] = buffer.data() + i * messageLength;
+            }
+
+            start = std::chrono::steady_clock::now();
+            multi(data.data(), lengths.data(), count, digests.data());
+            seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+            LOG_INFO("%u byte digest, %zu byte messages, multi-buffer: %.1f MB/s",
+                     digestLength,
+                     messageLength,
+                     c_totalBytes / seconds / 1e6);
+        }
+    }
+}
+
+INSTANTIATE_TEST_CASE_P(CommonDigest,
+                        DigestMultiTest,
+                        ::testing::Values(::testing::make_tuple(CC_MD5_Multi, CC_MD5, CC_MD5_DIGEST_LENGTH),
+                                          ::testing::make_tuple(CC_SHA1_Multi, CC_SHA1, CC_SHA1_DIGEST_LENGTH),
+                                          ::testing::make_tuple(CC_SHA256_Multi, CC_SHA256, CC_SHA256_DIGEST_LENGTH)));
+
 /* CommonHMAC tests */
 
 class HmacTest : public ::testing::TestWithParam<::testing::tuple<CCHmacAlgorithm, unsigned>> {};
 
 void _sameDataYieldsSameHash(CCHmacAlgorithm algorithm, unsigned outputLength) {
-    CC_Hmac_State* ctx;
+    CC_Hmac_State ctx;
 
     std::vector<unsigned char> hash1(outputLength);
     std::vector<unsigned char> hash2(outputLength);
@@ -194,7 +355,7 @@ void _sameDataYieldsSameHash(CCHmacAlgorithm algorithm, unsigned outputLength) {
 }
 
 void _multipleUpdatesYieldsSameHash(CCHmacAlgorithm algorithm, unsigned outputLength) {
-    CC_Hmac_State* ctx;
+    CC_Hmac_State ctx;
 
     std::vector<unsigned char> hash1(outputLength);
     std::vector<unsigned char> hash2(outputLength);
@@ -229,17 +390,48 @@ INSTANTIATE_TEST_CASE_P(CommonHmac,
                                           ::testing::make_tuple(kCCHmacAlgMD5, CC_MD5_DIGEST_LENGTH),
                                           ::testing::make_tuple(kCCHmacAlgSHA256, CC_SHA256_DIGEST_LENGTH),
                                           ::testing::make_tuple(kCCHmacAlgSHA384, CC_SHA384_DIGEST_LENGTH),
-                                          ::testing::make_tuple(kCCHmacAlgSHA512, CC_SHA512_DIGEST_LENGTH)));
+                                          ::testing::make_tuple(kCCHmacAlgSHA512, CC_SHA512_DIGEST_LENGTH),
+                                          ::testing::make_tuple(kCCHmacAlgSHA224, CC_SHA224_DIGEST_LENGTH)));
 
 TEST(CommonHmac, OneShotSanity) {
     unsigned hashLength = CC_SHA256_DIGEST_LENGTH;
-    CC_Hmac_State* ctx;
+    CC_Hmac_State ctx;
     std::vector<unsigned char> hash1(hashLength);
 
     CCHmac(kCCHmacAlgSHA256, secret, _countof(secret) - 1, singleLine, _countof(singleLine) - 1, hash1.data());
     logBytes(singleLine, hash1.data(), hashLength);
 }
 
+TEST(CommonHmac, KnownAnswers) {
+    static const char c_key[] = "Jefe";
+    static const char c_data[] = "what do ya want for nothing?";
+
+    //  RFC 2202 and RFC 4231 test case 2
+    const struct {
+        CCHmacAlgorithm algorithm;
+        unsigned length;
+        const char* expected;
+    } c_cases[] = {
+        { kCCHmacAlgMD5, CC_MD5_DIGEST_LENGTH, "750c783e6ab0b503eaa86e310a5db738" },
+        { kCCHmacAlgSHA1, CC_SHA1_DIGEST_LENGTH, "effcdf6ae5eb2fa2d27416d5f184df9c259a7c79" },
+        { kCCHmacAlgSHA224, CC_SHA224_DIGEST_LENGTH, "a30e01098bc6dbbf45690f3a7e9e6d0f8bbea2a39e6148008fd05e44" },
+        { kCCHmacAlgSHA256, CC_SHA256_DIGEST_LENGTH, "5bdcc146bf60754e6a042426089575c75a003f089d2739839dec58b964ec3843" },
+        { kCCHmacAlgSHA384,
+          CC_SHA384_DIGEST_LENGTH,
+          "af45d2e376484031617f78d2b58a6b1b9c7ef464f5a01b47e42ec3736322445e8e2240ca5e69e2c78b3239ecfab21649" },
+        { kCCHmacAlgSHA512,
+          CC_SHA512_DIGEST_LENGTH,
+          "164b7a7bfcf819e2e395fbe73b56e0a387bd64222e831fd610270cd7ea250554"
+          "9758bf75c05a994a6d034f65f8f0e6fdcaeab1a34d4a6b4b636e070a38bce737" },
+    };
+
+    for (const auto& testCase : c_cases) {
+        std::vector<unsigned char> mac(testCase.length);
+        CCHmac(testCase.algorithm, c_key, _countof(c_key) - 1, c_data, _countof(c_data) - 1, mac.data());
+        EXPECT_STREQ(testCase.expected, _hexDigest(mac.data(), testCase.length).c_str());
+    }
+}
+
 /* CommonCryptor tests */
 void _oneShotYieldsSameCrypto(CCAlgorithm algorithm,
                               CCOperation operation,
@@ -399,7 +591,7 @@ void _encryptDecryptSameAsOriginal(
                      outputSize,
                      &oneShotBytesDecrypted);
     ASSERT_EQ(kCCSuccess, status);
-    ASSERT_EQ(outputLength, oneShotBytesDecrypted);
+    ASSERT_EQ(update1Size + update2Size, oneShotBytesDecrypted);
     logBytes(singleLine, output2.data(), update1Size + update2Size);
 
     ASSERT_TRUE_MSG(equalsBytes((BYTE*)singleLine, output2.data(), update1Size + update2Size),
@@ -482,4 +674,363 @@ TEST(CommonCryptor, Sanity) {
     logBytes(multiLine2, output.data(), aesBlockLength);
     ASSERT_EQ(16, datamoved);
     CCCryptorRelease(ctx);
-}
\ No newline at end of file
+}
+
+static std::vector<unsigned char> _fromHex(const char* hex) {
+    std::vector<unsigned char> bytes;
+    for (size_t i = 0; hex[i] && hex[i + 1]; i += 2) {
+        bytes.push_back(static_cast<unsigned char>(std::stoi(std::string(hex + i, 2), nullptr, 16)));
+    }
+
+    return bytes;
+}
+
+TEST(CommonCryptor, AesKnownAnswers) {
+    // FIPS-197 appendix C
+    const std::vector<unsigned char> key = _fromHex("000102030405060708090a0b0c0d0e0f101112131415161718191a1b1c1d1e1f");
+    const std::vector<unsigned char> plaintext = _fromHex("00112233445566778899aabbccddeeff");
+    const char* expected[] = { "69c4e0d86a7b0430d8cdb78070b4c55a", "dda97ca4864cdfe06eaf70a0ec0d7191", "8ea2b7ca516745bfeafc49904b496089" };
+    const size_t keyLengths[] = { kCCKeySizeAES128, kCCKeySizeAES192, kCCKeySizeAES256 };
+
+    for (size_t i = 0; i < 3; ++i) {
+        unsigned char ciphertext[kCCBlockSizeAES128];
+        size_t moved;
+        ASSERT_EQ(kCCSuccess,
+                  CCCrypt(kCCEncrypt,
+                          kCCAlgorithmAES,
+                          kCCOptionECBMode,
+                          key.data(),
+                          keyLengths[i],
+                          nullptr,
+                          plaintext.data(),
+                          plaintext.size(),
+                          ciphertext,
+                          sizeof(ciphertext),
+                          &moved));
+        ASSERT_EQ(kCCBlockSizeAES128, moved);
+        EXPECT_STREQ(expected[i], _hexDigest(ciphertext, moved).c_str());
+
+        unsigned char decrypted[kCCBlockSizeAES128];
+        ASSERT_EQ(kCCSuccess,
+                  CCCrypt(kCCDecrypt,
+                          kCCAlgorithmAES,
+                          kCCOptionECBMode,
+                          key.data(),
+                          keyLengths[i],
+                          nullptr,
+                          ciphertext,
+                          sizeof(ciphertext),
+                          decrypted,
+                          sizeof(decrypted),
+                          &moved));
+        EXPECT_TRUE(equalsBytes(decrypted, const_cast<unsigned char*>(plaintext.data()), sizeof(decrypted)));
+    }
+}
+
+TEST(CommonCryptor, PaddedDecryptStripsPadding) {
+    std::vector<unsigned char> key(kCCKeySizeAES256, 0x42);
+    for (size_t length = 0; length <= 3 * kCCBlockSizeAES128; ++length) {
+        std::vector<unsigned char> ciphertext(length + kCCBlockSizeAES128);
+        size_t encrypted;
+        ASSERT_EQ(kCCSuccess,
+                  CCCrypt(kCCEncrypt,
+                          kCCAlgorithmAES,
+                          kCCOptionPKCS7Padding,
+                          key.data(),
+                          key.size(),
+                          secret2,
+                          singleLine,
+                          length,
+                          ciphertext.data(),
+                          ciphertext.size(),
+                          &encrypted));
+        ASSERT_EQ((length / kCCBlockSizeAES128 + 1) * kCCBlockSizeAES128, encrypted);
+
+        std::vector<unsigned char> decrypted(encrypted);
+        size_t moved;
+        ASSERT_EQ(kCCSuccess,
+                  CCCrypt(kCCDecrypt,
+                          kCCAlgorithmAES,
+                          kCCOptionPKCS7Padding,
+                          key.data(),
+                          key.size(),
+                          secret2,
+                          ciphertext.data(),
+                          encrypted,
+                          decrypted.data(),
+                          decrypted.size(),
+                          &moved));
+        ASSERT_EQ(length, moved);
+        ASSERT_TRUE(equalsBytes((BYTE*)singleLine, decrypted.data(), length));
+    }
+}
+
+TEST(CommonCryptor, CounterMode) {
+    // SP 800-38A F.5.1, fed in uneven pieces
+    const std::vector<unsigned char> key = _fromHex("2b7e151628aed2a6abf7158809cf4f3c");
+    const std::vector<unsigned char> counter = _fromHex("f0f1f2f3f4f5f6f7f8f9fafbfcfdfeff");
+    const std::vector<unsigned char> plaintext = _fromHex(
+        "6bc1bee22e409f96e93d7e117393172aae2d8a571e03ac9c9eb76fac45af8e5130c81c46a35ce411e5fbc1191a0a52eff69f2445df4f9b17ad2b417be66c3710");
+
+    CCCryptorRef ctx;
+    ASSERT_EQ(kCCSuccess,
+              CCCryptorCreateWithMode(kCCEncrypt,
+                                      kCCModeCTR,
+                                      kCCAlgorithmAES,
+                                      ccNoPadding,
+                                      counter.data(),
+                                      key.data(),
+                                      key.size(),
+                                      nullptr,
+                                      0,
+                                      0,
+                                      kCCModeOptionCTR_BE,
+                                      &ctx));
+    EXPECT_EQ(plaintext.size(), CCCryptorGetOutputLength(ctx, plaintext.size(), true));
+
+    std::vector<unsigned char> ciphertext(plaintext.size());
+    const size_t pieces[] = { 5, 27, 16, 0, 16 };
+    size_t offset = 0;
+    for (size_t piece : pieces) {
+        size_t moved;
+        ASSERT_EQ(kCCSuccess, CCCryptorUpdate(ctx, plaintext.data() + offset, piece, ciphertext.data() + offset, piece, &moved));
+        ASSERT_EQ(piece, moved);
+        offset += piece;
+    }
+
+    EXPECT_STREQ("874d6191b620e3261bef6864990db6ce9806f66b7970fdff8617187bb9fffdff"
+                 "5ae4df3edbd5d35e5b4f09020db03eab1e031dda2fbe03d1792170a0f3009cee",
+                 _hexDigest(ciphertext.data(), ciphertext.size()).c_str());
+    ASSERT_EQ(kCCSuccess, CCCryptorRelease(ctx));
+}
+
+TEST(CommonCryptor, CreateWithModeRejectsTweaksAndRounds) {
+    const std::vector<unsigned char> key(kCCKeySizeAES128, 0x24);
+    const std::vector<unsigned char> tweak(kCCKeySizeAES128, 0x42);
+
+    CCCryptorRef ctx = nullptr;
+    EXPECT_EQ(kCCUnimplemented,
+              CCCryptorCreateWithMode(kCCEncrypt,
+                                      kCCModeCBC,
+                                      kCCAlgorithmAES,
+                                      ccNoPadding,
+                                      nullptr,
+                                      key.data(),
+                                      key.size(),
+                                      tweak.data(),
+                                      tweak.size(),
+                                      0,
+                                      0,
+                                      &ctx));
+    EXPECT_EQ(nullptr, ctx);
+    EXPECT_EQ(kCCUnimplemented,
+              CCCryptorCreateWithMode(
+                  kCCEncrypt, kCCModeCBC, kCCAlgorithmAES, ccNoPadding, nullptr, key.data(), key.size(), nullptr, 0, 12, 0, &ctx));
+    EXPECT_EQ(nullptr, ctx);
+
+    //  An empty update of a block mode may pass no buffers at all
+    ASSERT_EQ(kCCSuccess,
+              CCCryptorCreateWithMode(
+                  kCCEncrypt, kCCModeCBC, kCCAlgorithmAES, ccNoPadding, nullptr, key.data(), key.size(), nullptr, 0, 0, 0, &ctx));
+    size_t moved = 1;
+    EXPECT_EQ(kCCSuccess, CCCryptorUpdate(ctx, nullptr, 0, nullptr, 0, &moved));
+    EXPECT_EQ(0, moved);
+    ASSERT_EQ(kCCSuccess, CCCryptorRelease(ctx));
+}
+
+TEST(CommonCryptor, GcmKnownAnswers) {
+    // Test case 4 from the GCM specification
+    const std::vector<unsigned char> key = _fromHex("feffe9928665731c6d6a8f9467308308");
+    const std::vector<unsigned char> iv = _fromHex("cafebabefacedbaddecaf888");
+    const std::vector<unsigned char> aad = _fromHex("feedfacedeadbeeffeedfacedeadbeefabaddad2");
+    const std::vector<unsigned char> plaintext = _fromHex(
+        "d9313225f88406e5a55909c5aff5269a86a7a9531534f7da2e4c303d8a318a721c3c0c95956809532fcf0e2449a6b525b16aedf5aa0de657ba637b39");
+
+    std::vector<unsigned char> ciphertext(plaintext.size());
+    unsigned char tag[16];
+    ASSERT_EQ(kCCSuccess,
+              CCCryptorGCMOneshotEncrypt(kCCAlgorithmAES,
+                                         key.data(),
+                                         key.size(),
+                                         iv.data(),
+                                         iv.size(),
+                                         aad.data(),
+                                         aad.size(),
+                                         plaintext.data(),
+                                         plaintext.size(),
+                                         ciphertext.data(),
+                                         tag,
+                                         sizeof(tag)));
+    EXPECT_STREQ("42831ec2217774244b7221b784d0d49ce3aa212f2c02a4e035c17e2329aca12e"
+                 "21d514b25466931c7d8f6a5aac84aa051ba30b396a0aac973d58e091",
+                 _hexDigest(ciphertext.data(), ciphertext.size()).c_str());
+    EXPECT_STREQ("5bc94fbc3221a5db94fae95ae7121a47", _hexDigest(tag, sizeof(tag)).c_str());
+
+    std::vector<unsigned char> decrypted(plaintext.size());
+    ASSERT_EQ(kCCSuccess,
+              CCCryptorGCMOneshotDecrypt(kCCAlgorithmAES,
+                                         key.data(),
+                                         key.size(),
+                                         iv.data(),
+                                         iv.size(),
+                                         aad.data(),
+                                         aad.size(),
+                                         ciphertext.data(),
+                                         ciphertext.size(),
+                                         decrypted.data(),
+                                         tag,
+                                         sizeof(tag)));
+    EXPECT_TRUE(decrypted == plaintext);
+
+    //  Any change to the ciphertext, the associated data or the tag must be rejected
+    ciphertext[7] ^= 0x01;
+    EXPECT_EQ(kCCDecodeError,
+              CCCryptorGCMOneshotDecrypt(kCCAlgorithmAES,
+                                         key.data(),
+                                         key.size(),
+                                         iv.data(),
+                                         iv.size(),
+                                         aad.data(),
+                                         aad.size(),
+                                         ciphertext.data(),
+                                         ciphertext.size(),
+                                         decrypted.data(),
+                                         tag,
+                                         sizeof(tag)));
+    EXPECT_TRUE(decrypted == std::vector<unsigned char>(plaintext.size(), 0));
+    ciphertext[7] ^= 0x01;
+
+    EXPECT_EQ(kCCDecodeError,
+              CCCryptorGCMOneshotDecrypt(kCCAlgorithmAES,
+                                         key.data(),
+                                         key.size(),
+                                         iv.data(),
+                                         iv.size(),
+                                         aad.data(),
+                                         aad.size() - 1,
+                                         ciphertext.data(),
+                                         ciphertext.size(),
+                                         decrypted.data(),
+                                         tag,
+                                         sizeof(tag)));
+
+    tag[15] ^= 0x80;
+    EXPECT_EQ(kCCDecodeError,
+              CCCryptorGCMOneshotDecrypt(kCCAlgorithmAES,
+                                         key.data(),
+                                         key.size(),
+                                         iv.data(),
+                                         iv.size(),
+                                         aad.data(),
+                                         aad.size(),
+                                         ciphertext.data(),
+                                         ciphertext.size(),
+                                         decrypted.data(),
+                                         tag,
+                                         sizeof(tag)));
+}
+
+TEST(CommonCryptor, CreateFromDataUsesCallerMemory) {
+    std::vector<unsigned char> key(kCCKeySizeAES128, 0x11);
+    CCCryptorRef ctx;
+    size_t required;
+    ASSERT_EQ(kCCBufferTooSmall,
+              CCCryptorCreateFromData(kCCEncrypt, kCCAlgorithmAES, 0, key.data(), key.size(), nullptr, nullptr, 0, &ctx, &required));
+
+    std::vector<unsigned char> memory(required + 1);
+    size_t used;
+    ASSERT_EQ(kCCSuccess,
+              CCCryptorCreateFromData(
+                  kCCEncrypt, kCCAlgorithmAES, 0, key.data(), key.size(), nullptr, memory.data() + 1, required, &ctx, &used));
+    EXPECT_EQ(required, used);
+
+    unsigned char output[kCCBlockSizeAES128];
+    size_t moved;
+    ASSERT_EQ(kCCSuccess, CCCryptorUpdate(ctx, multiLine2, sizeof(output), output, sizeof(output), &moved));
+    EXPECT_EQ(sizeof(output), moved);
+    EXPECT_EQ(kCCSuccess, CCCryptorRelease(ctx));
+}
+
+TEST(CommonCryptor, Throughput) {
+    const size_t c_totalBytes = 64 * 1024 * 1024;
+    std::vector<unsigned char> input(c_totalBytes, 0x5a);
+    std::vector<unsigned char> output(c_totalBytes + kCCBlockSizeAES128);
+    std::vector<unsigned char> key(kCCKeySizeAES128, 0x24);
+    std::vector<unsigned char> iv(kCCBlockSizeAES128, 0x01);
+    unsigned char tag[16];
+
+    auto measure = [&](const char* name, const std::function<CCCryptorStatus()>& crypt) {
+        auto start = std::chrono::steady_clock::now();
+        ASSERT_EQ(kCCSuccess, crypt());
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        LOG_INFO("AES-128 %s: %.1f MB/s", name, c_totalBytes / seconds / 1e6);
+    };
+
+    measure("CBC encrypt", [&]() {
+        size_t moved;
+        return CCCrypt(kCCEncrypt,
+                       kCCAlgorithmAES,
+                       0,
+                       key.data(),
+                       key.size(),
+                       iv.data(),
+                       input.data(),
+                       c_totalBytes,
+                       output.data(),
+                       output.size(),
+                       &moved);
+    });
+
+    measure("CBC decrypt", [&]() {
+        size_t moved;
+        return CCCrypt(kCCDecrypt,
+                       kCCAlgorithmAES,
+                       0,
+                       key.data(),
+                       key.size(),
+                       iv.data(),
+                       input.data(),
+                       c_totalBytes,
+                       output.data(),
+                       output.size(),
+                       &moved);
+    });
+
+    measure("CTR", [&]() {
+        CCCryptorRef ctx;
+        CCCryptorStatus status = CCCryptorCreateWithMode(kCCEncrypt,
+                                                         kCCModeCTR,
+                                                         kCCAlgorithmAES,
+                                                         ccNoPadding,
+                                                         iv.data(),
+                                                         key.data(),
+                                                         key.size(),
+                                                         nullptr,
+                                                         0,
+                                                         0,
+                                                         kCCModeOptionCTR_BE,
+                                                         &ctx);
+        if (status == kCCSuccess) {
+            size_t moved;
+            status = CCCryptorUpdate(ctx, input.data(), c_totalBytes, output.data(), output.size(), &moved);
+            CCCryptorRelease(ctx);
+        }
+
+        return status;
+    });
+
+    measure("GCM", [&]() {
+        return CCCryptorGCMOneshotEncrypt(kCCAlgorithmAES,
+                                          key.data(),
+                                          key.size(),
+                                          iv.data(),
+                                          12,
+                                          nullptr,
+                                          0,
+                                          input.data(),
+                                          c_totalBytes,
+                                          output.data(),
+                                          tag,
+                                          sizeof(tag));
+    });
+}
@@ -23,6 +23,9 @@
 
 #include <windows.h>
 
+#include <chrono>
+#include <vector>
+
 static void initAutoLayout() {
     static bool initialized;
 
@@ -235,3 +238,120 @@ TEST(NSLayoutConstraint, AddConstraints) {
     EXPECT_EQ(numConstraints, [topLevelView.constraints count]) << "Unrelated constraints added to view:\n"
                                                                 << ::testing::PrintToString(layoutConstraints);
 }
+
+TEST(NSLayoutConstraint, MergesIslands) {
+    initAutoLayout();
+
+    UIView* container = [[[UIView alloc] initWithFrame:CGRectMake(0, 0, 300, 100)] autorelease];
+    UIView* first = [[UIView new] autorelease];
+    UIView* second = [[UIView new] autorelease];
+    UIView* third = [[UIView new] autorelease];
+    UIView* fourth = [[UIView new] autorelease];
+    for (UIView* view in @[ first, second, third, fourth ]) {
+        view.translatesAutoresizingMaskIntoConstraints = NO;
+        [container addSubview:view];
+        [container addConstraints:[NSLayoutConstraint constraintsWithVisualFormat:@"V:|-10-[view(20)]"
+                                                                          options:0
+                                                                          metrics:nil
+                                                                            views:NSDictionaryOfVariableBindings(view)]];
+    }
+
+    //  Two islands of several items each, then a constraint spanning them; items of the absorbed island still point at its
+    //  old tableau, which has to forward to the survivor
+    NSDictionary* views = NSDictionaryOfVariableBindings(first, second, third, fourth);
+    [container addConstraints:[NSLayoutConstraint constraintsWithVisualFormat:@"H:|-10-[first(50)]-10-[second(50)]"
+                                                                      options:0
+                                                                      metrics:nil
+                                                                        views:views]];
+    [container addConstraints:[NSLayoutConstraint constraintsWithVisualFormat:@"H:[third(30)]-10-[fourth(30)]"
+                                                                      options:0
+                                                                      metrics:nil
+                                                                        views:views]];
+    [container layoutIfNeeded];
+
+    NSArray* bridge = [NSLayoutConstraint constraintsWithVisualFormat:@"H:[second]-10-[third]" options:0 metrics:nil views:views];
+    [container addConstraints:bridge];
+    [container layoutIfNeeded];
+
+    EXPECT_FLOAT_EQ(10, first.frame.origin.x);
+    EXPECT_FLOAT_EQ(70, second.frame.origin.x);
+    EXPECT_FLOAT_EQ(130, third.frame.origin.x);
+    EXPECT_FLOAT_EQ(170, fourth.frame.origin.x);
+    EXPECT_FLOAT_EQ(30, fourth.frame.size.width);
+    EXPECT_FLOAT_EQ(10, fourth.frame.origin.y);
+
+    //  Removing the bridge leaves one island, which still solves for every item
+    [container removeConstraints:bridge];
+    [container addConstraints:[NSLayoutConstraint constraintsWithVisualFormat:@"H:[second]-20-[third]" options:0 metrics:nil views:views]];
+    [container layoutIfNeeded];
+
+    EXPECT_FLOAT_EQ(140, third.frame.origin.x);
+    EXPECT_FLOAT_EQ(180, fourth.frame.origin.x);
+}
+
+TEST(NSLayoutConstraint, IndependentCellsPerformance) {
+    initAutoLayout();
+
+    const size_t c_cellCount = 1000;
+    const CGFloat c_cellHeight = 44;
+
+    UIView* tableView = [[[UIView alloc] initWithFrame:CGRectMake(0, 0, 320, c_cellCount * c_cellHeight)] autorelease];
+    std::vector<UIView*> cells;
+    std::vector<UIView*> leadingViews;
+    std::vector<UIView*> trailingViews;
+
+    //  Each cell lays out two labels side by side; no constraint crosses from one cell to another
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < c_cellCount; ++i) {
+        UIView* cell = [[[UIView alloc] initWithFrame:CGRectMake(0, i * c_cellHeight, 320, c_cellHeight)] autorelease];
+        UIView* leading = [[UIView new] autorelease];
+        UIView* trailing = [[UIView new] autorelease];
+        leading.translatesAutoresizingMaskIntoConstraints = NO;
+        trailing.translatesAutoresizingMaskIntoConstraints = NO;
+
+        [tableView addSubview:cell];
+        [cell addSubview:leading];
+        [cell addSubview:trailing];
+
+        NSDictionary* views = NSDictionaryOfVariableBindings(leading, trailing);
+        [cell addConstraints:[NSLayoutConstraint constraintsWithVisualFormat:@"H:|-8-[leading]-8-[trailing(==leading)]-8-|"
+                                                                     options:0
+                                                                     metrics:nil
+                                                                       views:views]];
+        [cell addConstraints:[NSLayoutConstraint constraintsWithVisualFormat:@"V:|-4-[leading]-4-|" options:0 metrics:nil views:views]];
+        [cell addConstraints:[NSLayoutConstraint constraintsWithVisualFormat:@"V:|-4-[trailing]-4-|" options:0 metrics:nil views:views]];
+
+        cells.push_back(cell);
+        leadingViews.push_back(leading);
+        trailingViews.push_back(trailing);
+    }
+
+    for (UIView* cell : cells) {
+        [cell layoutIfNeeded];
+    }
+
+    auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start);
+    LOG_INFO("%zu cells: %lld us to add constraints and lay out", c_cellCount, static_cast<long long>(elapsed.count()));
+
+    EXPECT_FLOAT_EQ(8, leadingViews[0].frame.origin.x);
+    EXPECT_FLOAT_EQ(4, leadingViews[0].frame.origin.y);
+    EXPECT_FLOAT_EQ(148, leadingViews[0].frame.size.width);
+    EXPECT_FLOAT_EQ(36, leadingViews[0].frame.size.height);
+    EXPECT_FLOAT_EQ(164, trailingViews[c_cellCount - 1].frame.origin.x);
+
+    //  Resizing a cell suggests its new frame to its own solver only
+    start = std::chrono::steady_clock::now();
+    for (UIView* cell : cells) {
+        CGRect frame = cell.frame;
+        frame.size.width = 400;
+        cell.frame = frame;
+        [cell setNeedsLayout];
+        [cell layoutIfNeeded];
+    }
+
+    elapsed = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start);
+    LOG_INFO("%zu cells: %.2f us per cell resize and relayout", c_cellCount, static_cast<double>(elapsed.count()) / c_cellCount);
+
+    EXPECT_FLOAT_EQ(188, leadingViews[c_cellCount / 2].frame.size.width);
+    EXPECT_FLOAT_EQ(204, trailingViews[c_cellCount / 2].frame.origin.x);
+}
@@ -0,0 +1,143 @@
+//******************************************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+//
+// This code is licensed under the MIT License (MIT).
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+//******************************************************************************
+
+#include <TestFramework.h>
+#include "TableViewRowIndex.h"
+
+#include <memory>
+#include <random>
+#include <vector>
+
+namespace {
+
+class TestRow : public TableViewRowIndexNode {
+public:
+    float height = 0.0f;
+};
+
+// Checks every query of the index against a plain array of the same rows
+void verifyIndex(const TableViewRowIndex<TestRow>& index, const std::vector<TestRow*>& rows) {
+    ASSERT_EQ(rows.size(), index.count());
+
+    double offset = 0.0;
+    for (size_t i = 0; i < rows.size(); ++i) {
+        ASSERT_EQ(rows[i], index.at(i));
+        ASSERT_EQ(i, index.indexOf(rows[i]));
+        ASSERT_DOUBLE_EQ(offset, index.offsetOf(rows[i]));
+        ASSERT_DOUBLE_EQ(offset, index.offsetAt(i));
+
+        if (rows[i]->height > 0.0f) {
+            ASSERT_EQ(rows[i], index.atOffset(offset));
+            ASSERT_EQ(rows[i], index.atOffset(offset + rows[i]->height / 2.0));
+        }
+
+        offset += rows[i]->height;
+    }
+
+    ASSERT_DOUBLE_EQ(offset, index.totalHeight());
+    ASSERT_DOUBLE_EQ(offset, index.offsetAt(rows.size()));
+    ASSERT_EQ(nullptr, index.at(rows.size()));
+    ASSERT_EQ(nullptr, index.atOffset(offset));
+    ASSERT_EQ(nullptr, index.atOffset(-1.0));
+}
+
+} // namespace
+
+TEST(TableViewRowIndex, Empty) {
+    TableViewRowIndex<TestRow> index;
+
+    EXPECT_EQ(0, index.count());
+    EXPECT_DOUBLE_EQ(0.0, index.totalHeight());
+    EXPECT_EQ(nullptr, index.at(0));
+    EXPECT_EQ(nullptr, index.atOffset(0.0));
+    EXPECT_DOUBLE_EQ(0.0, index.offsetAt(0));
+}
+
+TEST(TableViewRowIndex, AssignAndQuery) {
+    const size_t rowCount = 1000;
+    std::unique_ptr<TestRow[]> storage(new TestRow[rowCount]);
+    std::vector<TestRow*> rows;
+    std::vector<float> heights;
+
+    for (size_t i = 0; i < rowCount; ++i) {
+        storage[i].height = static_cast<float>(i % 7) * 11.0f;
+        rows.push_back(&storage[i]);
+        heights.push_back(storage[i].height);
+    }
+
+    TableViewRowIndex<TestRow> index;
+    index.assign(rows, heights);
+    verifyIndex(index, rows);
+
+    //  Zero-height rows are never hit; the offset belongs to the next row with height
+    EXPECT_EQ(rows[1], index.atOffset(0.0));
+    EXPECT_EQ(rows[8], index.atOffset(index.offsetOf(rows[7])));
+}
+
+TEST(TableViewRowIndex, InsertEraseAndResize) {
+    const size_t rowCount = 2000;
+    std::unique_ptr<TestRow[]> storage(new TestRow[rowCount]);
+    std::vector<TestRow*> rows;
+    std::mt19937 random(1234);
+
+    TableViewRowIndex<TestRow> index;
+    size_t nextRow = 0;
+
+    for (int step = 0; step < 6000; ++step) {
+        const unsigned op = random() % 4;
+
+        if ((op == 0 || rows.empty()) && nextRow < rowCount) {
+            TestRow* row = &storage[nextRow++];
+            row->height = static_cast<float>(random() % 5) * 10.0f;
+
+            const size_t at = random() % (rows.size() + 1);
+            index.insert(at, row, row->height);
+            rows.insert(rows.begin() + at, row);
+        } else if (op == 1 && !rows.empty()) {
+            const size_t at = random() % rows.size();
+            index.erase(rows[at]);
+            rows.erase(rows.begin() + at);
+        } else if (!rows.empty()) {
+            TestRow* row = rows[random() % rows.size()];
+            row->height = static_cast<float>(random() % 100);
+            index.setHeight(row, row->height);
+        }
+
+        if (step % 500 == 0) {
+            verifyIndex(index, rows);
+        }
+    }
+
+    verifyIndex(index, rows);
+
+    index.clear();
+    EXPECT_EQ(0, index.count());
+}
+
+TEST(TableViewRowIndex, AppendKeepsOrder) {
+    const size_t rowCount = 100000;
+    std::unique_ptr<TestRow[]> storage(new TestRow[rowCount]);
+    TableViewRowIndex<TestRow> index;
+
+    for (size_t i = 0; i < rowCount; ++i) {
+        index.append(&storage[i], 44.0f);
+    }
+
+    EXPECT_EQ(rowCount, index.count());
+    EXPECT_DOUBLE_EQ(44.0 * rowCount, index.totalHeight());
+    EXPECT_EQ(&storage[rowCount / 2], index.atOffset(44.0 * (rowCount / 2) + 1.0));
+    EXPECT_EQ(rowCount - 1, index.indexOf(&storage[rowCount - 1]));
+}
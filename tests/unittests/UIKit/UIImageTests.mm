@@ -0,0 +1,103 @@
+//******************************************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+//
+// This code is licensed under the MIT License (MIT).
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+//******************************************************************************
+
+#include <TestFramework.h>
+
+#import <UIKit/UIKit.h>
+
+#include <cstdlib>
+#include <vector>
+
+// Large enough, at more than 512KB of rows, for UIImagePNGRepresentation to deflate the image in several bands
+static const size_t c_pngTestWidth = 601;
+static const size_t c_pngTestHeight = 499;
+
+// Premultiplied 32-bit pixels with alpha in the last byte: gradients, a patch of noise and every level of alpha
+static std::vector<uint8_t> _pngTestPixels() {
+    std::vector<uint8_t> pixels(c_pngTestWidth * c_pngTestHeight * 4);
+    uint32_t seed = 12345;
+    for (size_t y = 0; y < c_pngTestHeight; ++y) {
+        for (size_t x = 0; x < c_pngTestWidth; ++x) {
+            seed = seed * 1664525 + 1013904223;
+            const bool noise = (x > 200 && x < 300 && y > 100 && y < 200);
+            const unsigned int alpha = (y < c_pngTestHeight / 2) ? 255 : static_cast<unsigned int>((x + y) & 0xFF);
+            const unsigned int color[3] = { noise ? (seed >> 24) : static_cast<unsigned int>(x & 0xFF),
+                                            noise ? ((seed >> 16) & 0xFF) : static_cast<unsigned int>(y & 0xFF),
+                                            static_cast<unsigned int>((x * y) & 0xFF) };
+
+            uint8_t* pixel = &pixels[(y * c_pngTestWidth + x) * 4];
+            for (int c = 0; c < 3; ++c) {
+                pixel[c] = static_cast<uint8_t>((color[c] * alpha + 127) / 255);
+            }
+            pixel[3] = static_cast<uint8_t>(alpha);
+        }
+    }
+
+    return pixels;
+}
+
+// Draws image into premultiplied pixels of the given layout
+static std::vector<uint8_t> _pngTestDraw(CGImageRef image, CGBitmapInfo bitmapInfo) {
+    std::vector<uint8_t> pixels(c_pngTestWidth * c_pngTestHeight * 4);
+    CGColorSpaceRef colorSpace = CGColorSpaceCreateDeviceRGB();
+    CGContextRef context =
+        CGBitmapContextCreate(pixels.data(), c_pngTestWidth, c_pngTestHeight, 8, c_pngTestWidth * 4, colorSpace, bitmapInfo);
+    CGColorSpaceRelease(colorSpace);
+
+    CGContextSetBlendMode(context, kCGBlendModeCopy);
+    CGContextDrawImage(context, CGRectMake(0, 0, c_pngTestWidth, c_pngTestHeight), image);
+    CGContextRelease(context);
+    return pixels;
+}
+
+TEST(UIImage, PNGRepresentationRoundTripsInBands) {
+    //  The premultiplied ARGB and ABGR surface formats; both keep alpha in the last byte
+    const CGBitmapInfo bitmapInfos[] = { kCGImageAlphaPremultipliedFirst | kCGBitmapByteOrder32Big, kCGImageAlphaPremultipliedLast };
+    for (CGBitmapInfo bitmapInfo : bitmapInfos) {
+        std::vector<uint8_t> pixels = _pngTestPixels();
+
+        CGColorSpaceRef colorSpace = CGColorSpaceCreateDeviceRGB();
+        CGContextRef context =
+            CGBitmapContextCreate(pixels.data(), c_pngTestWidth, c_pngTestHeight, 8, c_pngTestWidth * 4, colorSpace, bitmapInfo);
+        CGColorSpaceRelease(colorSpace);
+        CGImageRef sourceImage = CGBitmapContextCreateImage(context);
+        CGContextRelease(context);
+
+        NSData* png = UIImagePNGRepresentation([UIImage imageWithCGImage:sourceImage]);
+        CGImageRelease(sourceImage);
+        ASSERT_OBJCNE(nil, png);
+
+        UIImage* decoded = [UIImage imageWithData:png];
+        ASSERT_OBJCNE(nil, decoded);
+        ASSERT_EQ(c_pngTestWidth, CGImageGetWidth(decoded.CGImage));
+        ASSERT_EQ(c_pngTestHeight, CGImageGetHeight(decoded.CGImage));
+
+        //  PNG stores unpremultiplied color, so translucent pixels may come back a step or two off; alpha comes back exactly
+        std::vector<uint8_t> roundTripped = _pngTestDraw(decoded.CGImage, bitmapInfo);
+        size_t mismatches = 0;
+        for (size_t i = 0; i < pixels.size(); ++i) {
+            const int tolerance = ((i % 4) == 3) ? 0 : 2;
+            if (std::abs(static_cast<int>(pixels[i]) - static_cast<int>(roundTripped[i])) > tolerance) {
+                if (mismatches++ == 0) {
+                    ADD_FAILURE() << "First mismatch at pixel " << i / 4 << ", byte " << i % 4 << ": expected "
+                                  << static_cast<int>(pixels[i]) << ", found " << static_cast<int>(roundTripped[i]);
+                }
+            }
+        }
+
+        EXPECT_EQ(0, mismatches);
+    }
+}
@@ -0,0 +1,254 @@
+//******************************************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+//
+// This code is licensed under the MIT License (MIT).
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+//******************************************************************************
+
+#include <TestFramework.h>
+
+#import <UIKit/UIKit.h>
+#import "Starboard/SmartTypes.h"
+
+#include <chrono>
+#include <cstring>
+#include <string>
+#include <vector>
+
+@interface UINibTestItem : NSObject <NSCoding> {
+@public
+    int _tag;
+    float _scale;
+    BOOL _enabled;
+    StrongId<NSString> _title;
+    BOOL _awake;
+}
+@end
+
+@implementation UINibTestItem
+- (instancetype)initWithCoder:(NSCoder*)coder {
+    if (self = [super init]) {
+        _tag = [coder decodeInt32ForKey:@"tag"];
+        _scale = [coder decodeFloatForKey:@"scale"];
+        _enabled = [coder decodeBoolForKey:@"enabled"];
+        _title = [coder decodeObjectForKey:@"title"];
+    }
+
+    return self;
+}
+
+- (void)encodeWithCoder:(NSCoder*)coder {
+}
+
+- (void)awakeFromNib {
+    _awake = YES;
+}
+@end
+
+namespace {
+
+const uint8_t c_typeInt32 = 0x02;
+const uint8_t c_typeTrue = 0x05;
+const uint8_t c_typeFloat = 0x06;
+const uint8_t c_typeData = 0x08;
+const uint8_t c_typeUid = 0x0A;
+
+// Writes a NIBArchive of a root object whose top level objects are itemCount UINibTestItems, each with its own title string
+class NibArchiveWriter {
+public:
+    explicit NibArchiveWriter(uint32_t itemCount) {
+        const uint32_t c_root = 0;
+        const uint32_t c_array = 1;
+        const uint32_t c_firstItem = 2;
+
+        _objects.resize(c_firstItem + itemCount * 2);
+
+        beginObject(c_root, "NSObject");
+        addUid("UINibTopLevelObjectsKey", c_array);
+        addUid("UINibObjectsKey", c_array);
+
+        beginObject(c_array, "NSArray");
+        for (uint32_t i = 0; i < itemCount; ++i) {
+            addUid("UINibEncoderEmptyKey", c_firstItem + i);
+        }
+
+        for (uint32_t i = 0; i < itemCount; ++i) {
+            const uint32_t title = c_firstItem + itemCount + i;
+
+            beginObject(c_firstItem + i, "UINibTestItem");
+            addValue("tag", c_typeInt32, i);
+            addValue("scale", c_typeFloat, i * 0.5f);
+            addItem("enabled", c_typeTrue, nullptr, 0);
+            addUid("title", title);
+
+            const std::string text = "Item " + std::to_string(i);
+            beginObject(title, "NSString");
+            addItem("NS.bytes", c_typeData, text.data(), text.size());
+        }
+    }
+
+    NSData* data() const {
+        std::vector<uint8_t> out(c_headerSize);
+        uint32_t header[10] = { 1, 9 };
+
+        header[2] = static_cast<uint32_t>(_objects.size());
+        header[3] = static_cast<uint32_t>(out.size());
+        for (const ObjectEntry& object : _objects) {
+            out.push_back(static_cast<uint8_t>(0x80 + object.classIndex));
+            writeVarint(out, object.firstItem);
+            writeVarint(out, object.itemCount);
+        }
+
+        header[4] = static_cast<uint32_t>(_keys.size());
+        header[5] = static_cast<uint32_t>(out.size());
+        for (const std::string& key : _keys) {
+            out.push_back(static_cast<uint8_t>(0x80 + key.size()));
+            out.insert(out.end(), key.begin(), key.end());
+        }
+
+        header[6] = static_cast<uint32_t>(_itemCount);
+        header[7] = static_cast<uint32_t>(out.size());
+        out.insert(out.end(), _items.begin(), _items.end());
+
+        header[8] = static_cast<uint32_t>(_classes.size());
+        header[9] = static_cast<uint32_t>(out.size());
+        for (const std::string& className : _classes) {
+            out.push_back(static_cast<uint8_t>(0x80 + className.size()));
+            out.push_back(0x80);
+            out.insert(out.end(), className.begin(), className.end());
+        }
+
+        memcpy(out.data(), "NIBArchive", 10);
+        memcpy(out.data() + 10, header, sizeof(header));
+        return [NSData dataWithBytes:out.data() length:out.size()];
+    }
+
+private:
+    static const size_t c_headerSize = 10 + 10 * sizeof(uint32_t);
+
+    struct ObjectEntry {
+        uint32_t classIndex;
+        uint32_t firstItem;
+        uint32_t itemCount;
+    };
+
+    static void writeVarint(std::vector<uint8_t>& out, uint32_t value) {
+        if (value < 0x80) {
+            out.push_back(static_cast<uint8_t>(0x80 + value));
+        } else {
+            out.push_back(static_cast<uint8_t>(value & 0x7F));
+            out.push_back(static_cast<uint8_t>(0x80 + (value >> 7)));
+        }
+    }
+
+    static uint32_t indexOf(std::vector<std::string>& names, const char* name) {
+        for (size_t i = 0; i < names.size(); ++i) {
+            if (names[i] == name) {
+                return static_cast<uint32_t>(i);
+            }
+        }
+
+        names.emplace_back(name);
+        return static_cast<uint32_t>(names.size() - 1);
+    }
+
+    void beginObject(uint32_t index, const char* className) {
+        _current = index;
+        _objects[index] = { indexOf(_classes, className), static_cast<uint32_t>(_itemCount), 0 };
+    }
+
+    void addItem(const char* key, uint8_t type, const void* data, size_t length) {
+        _items.push_back(static_cast<uint8_t>(0x80 + indexOf(_keys, key)));
+        _items.push_back(type);
+        if (type == c_typeData) {
+            writeVarint(_items, static_cast<uint32_t>(length));
+        }
+
+        _items.insert(_items.end(), static_cast<const uint8_t*>(data), static_cast<const uint8_t*>(data) + length);
+        _objects[_current].itemCount++;
+        _itemCount++;
+    }
+
+    template <typename T>
+    void addValue(const char* key, uint8_t type, T value) {
+        addItem(key, type, &value, sizeof(value));
+    }
+
+    void addUid(const char* key, uint32_t object) {
+        addValue(key, c_typeUid, object);
+    }
+
+    std::vector<ObjectEntry> _objects;
+    std::vector<std::string> _classes;
+    std::vector<std::string> _keys;
+    std::vector<uint8_t> _items;
+    size_t _itemCount = 0;
+    uint32_t _current = 0;
+};
+
+} // namespace
+
+TEST(UINib, InstantiatesFreshObjectsFromCachedArchive) {
+    const uint32_t c_itemCount = 20;
+    UINib* nib = [UINib nibWithData:NibArchiveWriter(c_itemCount).data() bundle:nil];
+    ASSERT_NE(nil, nib);
+
+    NSArray* first = [nib instantiateWithOwner:nil options:nil];
+    NSArray* second = [nib instantiateWithOwner:nil options:nil];
+    ASSERT_EQ(c_itemCount, [first count]);
+    ASSERT_EQ(c_itemCount, [second count]);
+
+    for (uint32_t i = 0; i < c_itemCount; ++i) {
+        UINibTestItem* item = first[i];
+        ASSERT_TRUE([item isKindOfClass:[UINibTestItem class]]);
+        EXPECT_EQ(static_cast<int>(i), item->_tag);
+        EXPECT_FLOAT_EQ(i * 0.5f, item->_scale);
+        EXPECT_TRUE(item->_enabled);
+        EXPECT_TRUE(item->_awake);
+        EXPECT_OBJCEQ([NSString stringWithFormat:@"Item %u", i], item->_title.get());
+
+        //  Every instantiation allocates its own objects
+        UINibTestItem* other = second[i];
+        EXPECT_NE(item, other);
+        EXPECT_NE(item->_title.get(), other->_title.get());
+        EXPECT_EQ(item->_tag, other->_tag);
+    }
+}
+
+TEST(UINib, RepeatedInstantiationPerformance) {
+    const uint32_t c_itemCount = 99;
+    const size_t c_iterations = 10000;
+
+    //  The root, the top level array, and an item and a title string each: 200 objects
+    NSData* data = NibArchiveWriter(c_itemCount).data();
+    UINib* nib = [UINib nibWithData:data bundle:nil];
+
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < c_iterations; ++i) {
+        NSAutoreleasePool* pool = [NSAutoreleasePool new];
+        ASSERT_EQ(c_itemCount, [[nib instantiateWithOwner:nil options:nil] count]);
+        [pool release];
+    }
+
+    auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start);
+    LOG_INFO("200-object nib, one UINib: %.2f us per instantiation", static_cast<double>(elapsed.count()) / c_iterations);
+
+    start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < c_iterations; ++i) {
+        NSAutoreleasePool* pool = [NSAutoreleasePool new];
+        ASSERT_EQ(c_itemCount, [[[UINib nibWithData:data bundle:nil] instantiateWithOwner:nil options:nil] count]);
+        [pool release];
+    }
+
+    elapsed = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start);
+    LOG_INFO("200-object nib, new UINib each time: %.2f us per instantiation", static_cast<double>(elapsed.count()) / c_iterations);
+}